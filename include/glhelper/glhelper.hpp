@@ -33,6 +33,15 @@
 /* include glhelper_shader.hpp */
 #include <glhelper/glhelper_shader.hpp>
 
+/* include glhelper_block_layout.hpp */
+#include <glhelper/glhelper_block_layout.hpp>
+
+/* include glhelper_permutation.hpp */
+#include <glhelper/glhelper_permutation.hpp>
+
+/* include glhelper_reload.hpp */
+#include <glhelper/glhelper_reload.hpp>
+
 /* include glhelper_matrix.hpp */
 #include <glhelper/glhelper_matrix.hpp>
 
@@ -51,6 +60,9 @@
 /* include glhelper_render.hpp */
 #include <glhelper/glhelper_render.hpp>
 
+/* include glhelper_render_queue.hpp */
+#include <glhelper/glhelper_render_queue.hpp>
+
 /* include glhelper_model.hpp */
 #include <glhelper/glhelper_model.hpp>
 
@@ -70,4 +82,19 @@
 #include <glhelper/glhelper_function.hpp>
 
 /* include glhelper_composite_function.hpp */
-#include <glhelper/glhelper_composite_function.hpp>
\ No newline at end of file
+#include <glhelper/glhelper_composite_function.hpp>
+
+/* include glhelper_culling.hpp */
+#include <glhelper/glhelper_culling.hpp>
+
+/* include glhelper_thread.hpp */
+#include <glhelper/glhelper_thread.hpp>
+
+/* include glhelper_lod.hpp */
+#include <glhelper/glhelper_lod.hpp>
+
+/* include glhelper_meshlet.hpp */
+#include <glhelper/glhelper_meshlet.hpp>
+
+/* include glhelper_alpha_test.hpp */
+#include <glhelper/glhelper_alpha_test.hpp>
\ No newline at end of file
@@ -0,0 +1,352 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * include/glhelper/glhelper_alpha_test.hpp
+ *
+ * constructs for classifying the faces of a mesh as opaque and/or transparent from their vertex color alpha and the alpha of a diffuse texture stack
+ * faces are described by flat face data, so that the same faces can be tested on the cpu and by the compute program in shaders/compute.alpha_test.glsl
+ * notable constructs include:
+ *
+ *
+ *
+ * FACE DATA
+ *
+ * each face is three vertices, and each vertex is the texcoords of every uv channel followed by the vertex color alpha
+ * so a face is ( num_uv_channels * 2 + 1 ) * 3 floats, and the faces of a mesh follow one another
+ * the number of uv channels must be the MAX_TEXTURE_STACK_SIZE which the compute program was built with
+ *
+ *
+ *
+ * TEST RESULTS
+ *
+ * each face gives 4 bits, set if any sample of the face had:
+ * 0x1: a vertex color alpha of at least 0.98
+ * 0x2: a vertex color alpha between 0.02 and 0.98
+ * 0x4: a diffuse alpha of at least 0.98
+ * 0x8: a diffuse alpha between 0.02 and 0.98
+ * a face is sampled at its centroid, its vertices and the center of every texel of the diffuse stack it covers
+ *
+ *
+ *
+ * STRUCTS GLH::ALPHA_TEST::STACK AND GLH::ALPHA_TEST::STACK_LEVEL
+ *
+ * the parts of a diffuse texture stack which the cpu needs to evaluate its alpha, in the same way as evaluate_stack_w in shaders/materials.glsl
+ * each level refers to the image it was uploaded from, which is sampled without interpolation and wrapped as OpenGL would
+ *
+ *
+ *
+ * FUNCTIONS GLH::ALPHA_TEST::TEST_FACE AND GLH::ALPHA_TEST::TEST_FACES
+ *
+ * alpha test faces on the cpu, with the same sample points and arithmetic as the compute program
+ * test_faces spreads ranges of faces, each with their own stack, across the shared thread pool
+ *
+ *
+ *
+ * CLASS GLH::ALPHA_TEST::COMPUTE_TESTER
+ *
+ * alpha tests faces with the compute program
+ * the face data is uploaded once, then each range of faces sharing a stack is dispatched without waiting, and the results are read after a single fence
+ * the caller must set the diffuse stack of the material uniform of the program before each dispatch, except for the texture unit, which is set by dispatch
+ *
+ *
+ *
+ * CLASS GLH::EXCEPTION::ALPHA_TEST_EXCEPTION
+ *
+ * thrown when an error occurs in one of the alpha test functions (e.g. face data which is not a whole number of faces)
+ *
+ */
+
+
+
+/* HEADER GUARD */
+#ifndef GLHELPER_ALPHA_TEST_HPP_INCLUDED
+#define GLHELPER_ALPHA_TEST_HPP_INCLUDED
+
+
+
+/* INCLUDES */
+
+/* include core headers */
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+/* include glhelper_core.hpp */
+#include <glhelper/glhelper_core.hpp>
+
+/* include glhelper_exception.hpp */
+#include <glhelper/glhelper_exception.hpp>
+
+/* include glhelper_vector.hpp */
+#include <glhelper/glhelper_vector.hpp>
+
+/* include glhelper_buffer.hpp */
+#include <glhelper/glhelper_buffer.hpp>
+
+/* include glhelper_shader.hpp */
+#include <glhelper/glhelper_shader.hpp>
+
+/* include glhelper_texture.hpp */
+#include <glhelper/glhelper_texture.hpp>
+
+/* include glhelper_sync.hpp */
+#include <glhelper/glhelper_sync.hpp>
+
+/* include glhelper_thread.hpp */
+#include <glhelper/glhelper_thread.hpp>
+
+
+
+/* NAMESPACE DECLARATIONS */
+
+namespace glh
+{
+    namespace alpha_test
+    {
+        /* struct stack_level
+         *
+         * a level of a diffuse texture stack
+         */
+        struct stack_level;
+
+        /* struct stack
+         *
+         * a diffuse texture stack
+         */
+        struct stack;
+
+        /* class compute_tester
+         *
+         * alpha tests faces with the compute program
+         */
+        class compute_tester;
+
+
+
+        /* get_face_stride
+         *
+         * get the number of floats per face of face data
+         *
+         * num_uv_channels: the number of uv channels of each vertex
+         */
+        inline unsigned get_face_stride ( const unsigned num_uv_channels ) { return ( num_uv_channels * 2 + 1 ) * 3; }
+
+        /* test_face
+         *
+         * alpha test a face on the cpu
+         *
+         * _stack: the diffuse stack of the face
+         * face: a pointer to the face data of the face
+         * num_uv_channels: the number of uv channels of each vertex
+         *
+         * return: the 4 bits of the results of alpha testing the face
+         */
+        unsigned test_face ( const stack& _stack, const float * face, const unsigned num_uv_channels );
+
+        /* test_faces
+         *
+         * alpha test ranges of faces on the cpu across the shared thread pool
+         *
+         * face_data: the face data of every face
+         * num_uv_channels: the number of uv channels of each vertex
+         * first_faces: the index of the first face of each range, followed by the total number of faces
+         * stacks: the diffuse stack of each range
+         *
+         * return: the 4 bits of the results of alpha testing each face
+         */
+        std::vector<unsigned> test_faces ( const std::vector<float>& face_data, const unsigned num_uv_channels, const std::vector<unsigned>& first_faces, const std::vector<const stack *>& stacks );
+
+        /* sample_face
+         *
+         * sample a face at barycentric coordinates on the cpu, as sample_face does in the compute program
+         *
+         * _stack: the diffuse stack of the face
+         * face: a pointer to the face data of the face
+         * num_uv_channels: the number of uv channels of each vertex
+         * barycentric: the barycentric coordinates to sample at
+         *
+         * return: the 4 bits of the results of the sample
+         */
+        unsigned sample_face ( const stack& _stack, const float * face, const unsigned num_uv_channels, const math::fvec3& barycentric );
+
+        /* sample_stack_alpha
+         *
+         * sample the alpha of a level of a stack from its image on the cpu, without interpolation
+         * the texel is wrapped in the same way as the sampler used by the compute program
+         *
+         * _stack: the stack to sample
+         * level: the level of the stack to sample
+         * texcoords: the texture coords to sample at
+         */
+        float sample_stack_alpha ( const stack& _stack, const unsigned level, const math::fvec2& texcoords );
+    }
+
+    namespace exception
+    {
+        /* class alpha_test_exception : exception
+         *
+         * exception relating to alpha testing
+         */
+        class alpha_test_exception;
+    }
+}
+
+
+
+/* STACK_LEVEL DEFINITION */
+
+/* struct stack_level
+ *
+ * a level of a diffuse texture stack
+ */
+struct glh::alpha_test::stack_level
+{
+    /* the image the level was uploaded from */
+    const core::image * level_image;
+
+    /* the uv channel of the level */
+    unsigned uvwsrc;
+
+    /* the blend operation and strength of the level */
+    int blend_operation;
+    float blend_strength;
+};
+
+
+
+/* STACK DEFINITION */
+
+/* struct stack
+ *
+ * a diffuse texture stack
+ */
+struct glh::alpha_test::stack
+{
+    /* the alpha of the base color */
+    float base_alpha;
+
+    /* the width and height of the stack */
+    unsigned width;
+    unsigned height;
+
+    /* the OpenGL wrapping modes in each direction (GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP_TO_EDGE or GL_CLAMP_TO_BORDER) */
+    GLenum wrapping_u;
+    GLenum wrapping_v;
+
+    /* the levels of the stack */
+    std::vector<stack_level> levels;
+};
+
+
+
+/* COMPUTE_TESTER DEFINITION */
+
+/* class compute_tester
+ *
+ * alpha tests faces with the compute program
+ */
+class glh::alpha_test::compute_tester
+{
+public:
+
+    /* full constructor
+     *
+     * upload the face data, and create the output buffer cleared to zero
+     *
+     * _alpha_test_program: the compute program built from shaders/compute.alpha_test.glsl
+     * face_data: the face data of every face to test
+     * num_uv_channels: the number of uv channels of each vertex, which must be the MAX_TEXTURE_STACK_SIZE of the program
+     */
+    compute_tester ( core::compute_program& _alpha_test_program, const std::vector<float>& face_data, const unsigned num_uv_channels );
+
+    /* deleted copy constructor */
+    compute_tester ( const compute_tester& other ) = delete;
+
+    /* deleted copy assignment operator */
+    compute_tester& operator= ( const compute_tester& other ) = delete;
+
+    /* default destructor */
+    ~compute_tester () = default;
+
+
+
+    /* dispatch
+     *
+     * dispatch the program for a range of faces which share a diffuse stack, without waiting for it to complete
+     * the textures are sampled without interpolation through a cached sampler with the wrapping of the stack
+     *
+     * textures: the texture array of the diffuse stack
+     * _stack: the diffuse stack, whose base color and levels must already be set in the material uniform of the program
+     * first_face: the index of the first face of the range
+     * num_faces: the number of faces in the range
+     */
+    void dispatch ( const core::texture2d_array& textures, const stack& _stack, const unsigned first_face, const unsigned num_faces );
+
+    /* get_results
+     *
+     * wait for every dispatch, then read the results
+     *
+     * return: the 4 bits of the results of alpha testing each face
+     */
+    std::vector<unsigned> get_results ();
+
+
+
+private:
+
+    /* the alpha test program */
+    core::compute_program& alpha_test_program;
+
+    /* the number of faces */
+    unsigned num_faces;
+
+    /* the face data, and the output with 4 bits for each face */
+    core::ssbo face_ssbo;
+    core::ssbo output_ssbo;
+
+    /* cached uniforms */
+    core::uniform& first_face_uni;
+    core::uniform& num_faces_uni;
+    core::uniform& textures_uni;
+
+};
+
+
+
+/* ALPHA_TEST_EXCEPTION DEFINITION */
+
+/* class alpha_test_exception : exception
+ *
+ * exception relating to alpha testing
+ */
+class glh::exception::alpha_test_exception : public exception
+{
+public:
+
+    /* full constructor
+     *
+     * __what: description of the exception
+     */
+    explicit alpha_test_exception ( const std::string& __what )
+        : exception { __what }
+    {}
+
+    /* default zero-parameter constructor
+     *
+     * construct alpha_test_exception with no descrption
+     */
+    alpha_test_exception () = default;
+
+    /* default everything else and inherits what () function */
+
+};
+
+
+
+/* #ifndef GLHELPER_ALPHA_TEST_HPP_INCLUDED */
+#endif
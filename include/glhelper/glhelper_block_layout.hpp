@@ -0,0 +1,540 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * include/glhelper/glhelper_block_layout.hpp
+ *
+ * constructs for describing C++ structs and laying them out in uniform and shader storage blocks
+ * notable constructs include:
+ *
+ *
+ *
+ * STRUCT GLH::CORE::STD140_LAYOUT AND GLH::CORE::STD430_LAYOUT
+ *
+ * tag types for the two standard block layouts, given as the first template parameter of the functions below
+ * the only difference between them is that std140 rounds the alignment of arrays, matrix columns and structs up to that of a vec4
+ *
+ *
+ *
+ * STRUCT GLH::CORE::BLOCK_MEMBER
+ *
+ * the name and member pointer of a member of a C++ struct
+ * a struct is described by giving it a static block_members function, returning a tuple of block members in the same order as the GLSL struct, e.g.
+ *
+ * struct camera_block
+ * {
+ *     math::fmat4 view;
+ *     math::fvec3 viewpos;
+ *
+ *     static auto block_members () { return std::make_tuple ( GLH_BLOCK_MEMBER ( camera_block, view ), GLH_BLOCK_MEMBER ( camera_block, viewpos ) ); }
+ * };
+ *
+ * members may be 4-byte scalars, bools, float, int or unsigned vectors and matrices, std::arrays of any of these, or other described structs
+ * the C++ struct need not have the same padding as the GLSL struct, as members are copied one at a time into their offsets in the block
+ *
+ *
+ *
+ * STRUCT GLH::CORE::BLOCK_TYPE
+ *
+ * computes the alignment and size of a type under a layout at compile time, packs values of it into memory, and validates it against a program
+ *
+ *
+ *
+ * FUNCTIONS PACK_BLOCK(_ARRAY), UPLOAD_BLOCK(_ARRAY) AND VALIDATE_BLOCK
+ *
+ * pack_block(_array) lays out a value (or an array of values, each at the array stride of the type) into memory
+ * upload_block(_array) does the same into a buffer, in one upload (if the buffer is a ubo, the data is staged, so only the bytes which changed are uploaded)
+ * validate_block checks the offsets (and array and matrix strides) of each member against the program, with glGetProgramResourceiv
+ * this should be called once after linking, and throws if the C++ description does not match the GLSL struct
+ * members which are not active in the program are skipped
+ *
+ *
+ *
+ * CLASS GLH::EXCEPTION::BLOCK_LAYOUT_EXCEPTION
+ *
+ * thrown when a block layout does not match a program, or a value does not fit in the buffer it is uploaded to
+ *
+ */
+
+
+
+/* HEADER GUARD */
+#ifndef GLHELPER_BLOCK_LAYOUT_HPP_INCLUDED
+#define GLHELPER_BLOCK_LAYOUT_HPP_INCLUDED
+
+
+
+/* INCLUDES */
+
+/* include core headers */
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/* include glhelper_core.hpp */
+#include <glhelper/glhelper_core.hpp>
+
+/* include glhelper_exception.hpp */
+#include <glhelper/glhelper_exception.hpp>
+
+/* include glhelper_matrix.hpp */
+#include <glhelper/glhelper_matrix.hpp>
+
+/* include glhelper_vector.hpp */
+#include <glhelper/glhelper_vector.hpp>
+
+/* include glhelper_buffer.hpp */
+#include <glhelper/glhelper_buffer.hpp>
+
+/* include glhelper_shader.hpp */
+#include <glhelper/glhelper_shader.hpp>
+
+
+
+/* MACROS */
+
+/* GLH_BLOCK_MEMBER
+ *
+ * create a block member from a struct type and the name of one of its members
+ */
+#define GLH_BLOCK_MEMBER( type, member ) glh::core::make_block_member ( #member, &type::member )
+
+
+
+/* NAMESPACE DECLARATIONS */
+
+namespace glh
+{
+    namespace core
+    {
+        /* struct std140_layout
+         * struct std430_layout
+         *
+         * tag types for the standard block layouts
+         */
+        struct std140_layout;
+        struct std430_layout;
+
+        /* struct block_member
+         *
+         * the name and member pointer of a member of a described struct
+         */
+        template<class C, class M> struct block_member;
+
+        /* make_block_member
+         *
+         * create a block member from its name and member pointer
+         */
+        template<class C, class M> block_member<C, M> make_block_member ( const char * name, M C::* pointer );
+
+        /* struct block_type
+         *
+         * the layout of a type in a block
+         */
+        template<class Layout, class T, class = void> struct block_type;
+
+        /* pack_block
+         * pack_block_array
+         *
+         * lay out a value, or an array of values, into memory
+         */
+        template<class Layout, class T> std::vector<unsigned char> pack_block ( const T& value );
+        template<class Layout, class It> std::vector<unsigned char> pack_block_array ( It first, It last );
+
+        /* upload_block
+         * upload_block_array
+         *
+         * lay out a value, or an array of values, into a buffer in one upload
+         */
+        template<class Layout, class T> void upload_block ( buffer& buff, const T& value, const unsigned offset = 0 );
+        template<class Layout, class It> void upload_block_array ( buffer& buff, It first, It last, const unsigned offset = 0 );
+
+        /* validate_block
+         *
+         * check that the layout of a described struct matches a struct in a program
+         */
+        template<class Layout, class T> void validate_block ( const program& prog, const std::string& name, const GLenum interface = GL_UNIFORM );
+
+        /* write_block_data
+         *
+         * upload laid out data to a buffer
+         */
+        void write_block_data ( buffer& buff, const std::vector<unsigned char>& data, const unsigned offset );
+
+        /* validate_block_member
+         *
+         * check the offset and strides of a single member of a block against a program
+         */
+        void validate_block_member ( const program& prog, const GLenum interface, const std::string& name, const unsigned offset, const int array_stride = -1, const int matrix_stride = -1 );
+    }
+
+    namespace meta
+    {
+        /* struct is_block_struct
+         *
+         * is_block_struct::value is true if the type is a struct described by a block_members function
+         */
+        template<class T, class = void> struct is_block_struct;
+    }
+
+    namespace exception
+    {
+        /* class block_layout_exception : exception
+         *
+         * for exceptions related to block layouts
+         */
+        class block_layout_exception;
+    }
+}
+
+
+
+/* STD140_LAYOUT AND STD430_LAYOUT DEFINITIONS */
+
+/* struct std140_layout
+ *
+ * arrays, matrix columns and structs are aligned to at least a vec4
+ */
+struct glh::core::std140_layout
+{
+    static constexpr unsigned round_alignment ( const unsigned alignment ) { return ( alignment < 16 ? 16 : alignment ); }
+};
+
+/* struct std430_layout
+ *
+ * arrays, matrix columns and structs are aligned as their elements
+ */
+struct glh::core::std430_layout
+{
+    static constexpr unsigned round_alignment ( const unsigned alignment ) { return alignment; }
+};
+
+
+
+/* BLOCK_MEMBER DEFINITION */
+
+/* struct block_member
+ *
+ * the name and member pointer of a member of a described struct
+ */
+template<class C, class M> struct glh::core::block_member
+{
+    /* the type of the member */
+    typedef M member_type;
+
+    /* the GLSL name of the member and the pointer to it */
+    const char * name;
+    M C::* pointer;
+};
+
+/* make_block_member
+ *
+ * create a block member from its name and member pointer
+ */
+template<class C, class M> inline glh::core::block_member<C, M> glh::core::make_block_member ( const char * name, M C::* pointer )
+{
+    return block_member<C, M> { name, pointer };
+}
+
+
+
+/* IS_BLOCK_STRUCT DEFINITION */
+
+/* struct is_block_struct
+ *
+ * is_block_struct::value is true if the type is a struct described by a block_members function
+ */
+template<class T, class> struct glh::meta::is_block_struct : std::false_type {};
+template<class T> struct glh::meta::is_block_struct<T, std::void_t<decltype ( T::block_members () )>> : std::true_type {};
+
+
+
+/* BLOCK_TYPE DEFINITIONS */
+
+/* struct block_type for scalars
+ *
+ * 4-byte scalars are aligned to and take 4 bytes
+ */
+template<class Layout, class T> struct glh::core::block_type<Layout, T, std::enable_if_t<std::is_arithmetic<T>::value>>
+{
+    /* static assert that the scalar is 4 bytes */
+    static_assert ( sizeof ( T ) == 4, "only 4-byte scalars and bools can be laid out in a block" );
+
+    /* alignment and size */
+    static constexpr unsigned alignment = 4;
+    static constexpr unsigned size = 4;
+    static constexpr bool is_basic = true;
+
+    /* pack a value into memory */
+    static void pack ( const T& value, unsigned char * dest ) { std::memcpy ( dest, &value, 4 ); }
+
+    /* validate against a program */
+    static void validate ( const program& prog, const GLenum interface, const std::string& name, const unsigned offset ) { validate_block_member ( prog, interface, name, offset ); }
+};
+
+/* struct block_type for bools
+ *
+ * bools are laid out as 4-byte unsigned integers
+ */
+template<class Layout> struct glh::core::block_type<Layout, bool, void>
+{
+    /* alignment and size */
+    static constexpr unsigned alignment = 4;
+    static constexpr unsigned size = 4;
+    static constexpr bool is_basic = true;
+
+    /* pack a value into memory */
+    static void pack ( const bool& value, unsigned char * dest ) { const GLuint v = value; std::memcpy ( dest, &v, 4 ); }
+
+    /* validate against a program */
+    static void validate ( const program& prog, const GLenum interface, const std::string& name, const unsigned offset ) { validate_block_member ( prog, interface, name, offset ); }
+};
+
+/* struct block_type for vectors
+ *
+ * vec2s are aligned to 8 bytes, and vec3s and vec4s to 16 bytes
+ */
+template<class Layout, unsigned M, class T> struct glh::core::block_type<Layout, glh::math::vector<M, T>, void>
+{
+    /* alignment and size */
+    static constexpr unsigned alignment = ( M == 2 ? 8 : 16 );
+    static constexpr unsigned size = M * block_type<Layout, T>::size;
+    static constexpr bool is_basic = true;
+
+    /* pack a value into memory */
+    static void pack ( const math::vector<M, T>& value, unsigned char * dest )
+        { for ( unsigned i = 0; i < M; ++i ) block_type<Layout, T>::pack ( value.at ( i ), dest + i * block_type<Layout, T>::size ); }
+
+    /* validate against a program */
+    static void validate ( const program& prog, const GLenum interface, const std::string& name, const unsigned offset ) { validate_block_member ( prog, interface, name, offset ); }
+};
+
+/* struct block_type for matrices
+ *
+ * matrices are laid out as arrays of column vectors
+ */
+template<class Layout, unsigned M, unsigned N, class T> struct glh::core::block_type<Layout, glh::math::matrix<M, N, T>, void>
+{
+    /* the stride of the columns */
+    static constexpr unsigned column_stride = Layout::round_alignment ( block_type<Layout, math::vector<M, T>>::alignment );
+
+    /* alignment and size */
+    static constexpr unsigned alignment = column_stride;
+    static constexpr unsigned size = N * column_stride;
+    static constexpr bool is_basic = true;
+
+    /* pack a value into memory */
+    static void pack ( const math::matrix<M, N, T>& value, unsigned char * dest )
+        { for ( unsigned j = 0; j < N; ++j ) for ( unsigned i = 0; i < M; ++i ) block_type<Layout, T>::pack ( value.at ( i, j ), dest + j * column_stride + i * block_type<Layout, T>::size ); }
+
+    /* validate against a program */
+    static void validate ( const program& prog, const GLenum interface, const std::string& name, const unsigned offset ) { validate_block_member ( prog, interface, name, offset, -1, column_stride ); }
+};
+
+/* struct block_type for arrays
+ *
+ * elements are placed at a stride of their size, rounded up to their alignment
+ */
+template<class Layout, class T, std::size_t N> struct glh::core::block_type<Layout, std::array<T, N>, void>
+{
+    /* the alignment and stride of the elements */
+    static constexpr unsigned element_alignment = Layout::round_alignment ( block_type<Layout, T>::alignment );
+    static constexpr unsigned stride = ( block_type<Layout, T>::size + element_alignment - 1 ) / element_alignment * element_alignment;
+
+    /* alignment and size */
+    static constexpr unsigned alignment = element_alignment;
+    static constexpr unsigned size = N * stride;
+    static constexpr bool is_basic = false;
+
+    /* pack a value into memory */
+    static void pack ( const std::array<T, N>& value, unsigned char * dest )
+        { for ( unsigned i = 0; i < N; ++i ) block_type<Layout, T>::pack ( value.at ( i ), dest + i * stride ); }
+
+    /* validate against a program
+     * arrays of basic types are a single resource, so the first element is validated along with the stride, otherwise each element is validated
+     */
+    static void validate ( const program& prog, const GLenum interface, const std::string& name, const unsigned offset )
+    {
+        if ( block_type<Layout, T>::is_basic ) validate_block_member ( prog, interface, name + "[0]", offset, stride );
+        else for ( unsigned i = 0; i < N; ++i ) block_type<Layout, T>::validate ( prog, interface, name + "[" + std::to_string ( i ) + "]", offset + i * stride );
+    }
+};
+
+/* struct block_type for described structs
+ *
+ * members are placed in order, each at the next offset aligned to its alignment
+ */
+template<class Layout, class T> struct glh::core::block_type<Layout, T, std::enable_if_t<glh::meta::is_block_struct<T>::value>>
+{
+    /* the tuple of block members, and the number of them */
+    typedef decltype ( T::block_members () ) members_type;
+    static constexpr std::size_t num_members = std::tuple_size<members_type>::value;
+
+    /* the type of the ith member */
+    template<std::size_t I> using member_type = typename std::tuple_element_t<I, members_type>::member_type;
+
+    /* compute_alignment
+     *
+     * the largest alignment of any member, rounded by the layout
+     */
+    template<std::size_t ...Is> static constexpr unsigned compute_alignment ( std::index_sequence<Is...> )
+        { return Layout::round_alignment ( std::max ( { 4u, block_type<Layout, member_type<Is>>::alignment... } ) ); }
+
+    /* compute_offsets
+     *
+     * the offset of each member, followed by the end of the last member
+     */
+    template<std::size_t ...Is> static constexpr std::array<unsigned, sizeof... ( Is ) + 1> compute_offsets ( std::index_sequence<Is...> )
+    {
+        std::array<unsigned, sizeof... ( Is ) + 1> offsets {};
+        unsigned cursor = 0, i = 0;
+        ( ( cursor = ( cursor + block_type<Layout, member_type<Is>>::alignment - 1 ) / block_type<Layout, member_type<Is>>::alignment * block_type<Layout, member_type<Is>>::alignment,
+            offsets [ i++ ] = cursor, cursor += block_type<Layout, member_type<Is>>::size ), ... );
+        offsets [ i ] = cursor;
+        return offsets;
+    }
+
+    /* the offsets of the members */
+    static constexpr std::array<unsigned, num_members + 1> offsets = compute_offsets ( std::make_index_sequence<num_members> {} );
+
+    /* alignment and size */
+    static constexpr unsigned alignment = compute_alignment ( std::make_index_sequence<num_members> {} );
+    static constexpr unsigned size = ( offsets.back () + alignment - 1 ) / alignment * alignment;
+    static constexpr bool is_basic = false;
+
+    /* pack a value into memory */
+    static void pack ( const T& value, unsigned char * dest ) { pack_members ( value, dest, T::block_members (), std::make_index_sequence<num_members> {} ); }
+
+    /* validate against a program */
+    static void validate ( const program& prog, const GLenum interface, const std::string& name, const unsigned offset )
+        { validate_members ( prog, interface, name, offset, T::block_members (), std::make_index_sequence<num_members> {} ); }
+
+    /* pack_members
+     * validate_members
+     *
+     * pack or validate each member in turn
+     */
+    template<std::size_t ...Is> static void pack_members ( const T& value, unsigned char * dest, const members_type& members, std::index_sequence<Is...> )
+        { ( block_type<Layout, member_type<Is>>::pack ( value.*( std::get<Is> ( members ).pointer ), dest + offsets [ Is ] ), ... ); }
+    template<std::size_t ...Is> static void validate_members ( const program& prog, const GLenum interface, const std::string& name, const unsigned offset, const members_type& members, std::index_sequence<Is...> )
+        { ( block_type<Layout, member_type<Is>>::validate ( prog, interface, name + "." + std::get<Is> ( members ).name, offset + offsets [ Is ] ), ... ); }
+};
+
+
+
+/* BLOCK FUNCTIONS IMPLEMENTATION */
+
+/* pack_block
+ *
+ * lay out a value into memory, with any padding zeroed
+ */
+template<class Layout, class T> inline std::vector<unsigned char> glh::core::pack_block ( const T& value )
+{
+    /* pack into zeroed memory */
+    std::vector<unsigned char> data ( block_type<Layout, T>::size, 0 );
+    block_type<Layout, T>::pack ( value, data.data () );
+    return data;
+}
+
+/* pack_block_array
+ *
+ * lay out an array of values into memory, each at the array stride of the type
+ */
+template<class Layout, class It> inline std::vector<unsigned char> glh::core::pack_block_array ( It first, It last )
+{
+    /* get the type of the values and their stride */
+    typedef std::remove_cv_t<std::remove_reference_t<decltype ( * first )>> value_type;
+    constexpr unsigned stride = block_type<Layout, std::array<value_type, 1>>::stride;
+
+    /* pack each value into zeroed memory */
+    std::vector<unsigned char> data ( std::distance ( first, last ) * stride, 0 );
+    for ( unsigned i = 0; first != last; ++first, ++i ) block_type<Layout, value_type>::pack ( * first, data.data () + i * stride );
+    return data;
+}
+
+/* upload_block
+ *
+ * lay out a value into a buffer in one upload
+ *
+ * buff: the buffer to upload to
+ * value: the value to upload
+ * offset: the offset into the buffer to upload to (defaults to 0)
+ */
+template<class Layout, class T> inline void glh::core::upload_block ( buffer& buff, const T& value, const unsigned offset )
+{
+    /* pack then write */
+    write_block_data ( buff, pack_block<Layout> ( value ), offset );
+}
+
+/* upload_block_array
+ *
+ * lay out an array of values into a buffer in one upload
+ *
+ * buff: the buffer to upload to
+ * first/last: iterators for the values
+ * offset: the offset into the buffer to upload to (defaults to 0)
+ */
+template<class Layout, class It> inline void glh::core::upload_block_array ( buffer& buff, It first, It last, const unsigned offset )
+{
+    /* pack then write */
+    write_block_data ( buff, pack_block_array<Layout> ( first, last ), offset );
+}
+
+/* validate_block
+ *
+ * check that the layout of a described struct matches a struct in a program
+ * throws if any active member has a different offset or stride
+ *
+ * prog: the program to validate against (which must be linked)
+ * name: the name of the struct in the program
+ * interface: the program interface of the members (GL_UNIFORM for uniform blocks, GL_BUFFER_VARIABLE for shader storage blocks)
+ */
+template<class Layout, class T> inline void glh::core::validate_block ( const program& prog, const std::string& name, const GLenum interface )
+{
+    /* validate from the start of the block */
+    block_type<Layout, T>::validate ( prog, interface, name, 0 );
+}
+
+
+
+/* BLOCK_LAYOUT_EXCEPTION DEFINITION */
+
+/* class block_layout_exception : exception
+ *
+ * for exceptions related to block layouts
+ */
+class glh::exception::block_layout_exception : public exception
+{
+public:
+
+    /* full constructor
+     *
+     * __what: description of the exception
+     */
+    explicit block_layout_exception ( const std::string& __what )
+        : exception { __what }
+    {}
+
+    /* default zero-parameter constructor
+     *
+     * construct block_layout_exception with no descrption
+     */
+    block_layout_exception () = default;
+
+    /* default everything else and inherits what () function */
+
+};
+
+
+
+/* #ifndef GLHELPER_BLOCK_LAYOUT_HPP_INCLUDED */
+#endif
@@ -34,6 +34,29 @@
  *
  * 
  * 
+ * UBO STAGING
+ * 
+ * uniforms in named blocks do not write straight into the ubo bound to their block, but into a CPU-side image of the ubo
+ * the image is read back from the ubo once, when first written to, and the ranges written to since the last flush are recorded,
+ * merging ranges which overlap or are separated by at most GLH_UBO_STAGING_MERGE_GAP bytes
+ * the renderer flushes every ubo with staged data before each draw, so setting a whole struct in a block costs one upload, rather than one per member
+ * bytes of a write which already match the image are trimmed off, and a write which matches entirely is dropped, so unchanged values are never uploaded
+ * data written to a ubo by other means (e.g. buffer_sub_data or a mapping) is overwritten by a pending flush of the same range,
+ * and invalidate_staging should be called afterwards so that the image is read back again
+ *
+ * 
+ * 
+ * CLASS GLH::CORE::RING_BUFFER
+ * 
+ * a buffer for streaming data which changes every frame (e.g. instance matrices, light data or debug geometry)
+ * the buffer is immutable and persistently mapped, and split into a number of frame regions
+ * data is written straight into the current region, with no driver copies, and bound to indexed targets with bind_range
+ * at the end of each frame, next_frame places a fence on the current region and moves to the next one,
+ * waiting on the fence of the next region only if the GPU has not yet finished reading from it
+ * the number and duration of these waits are recorded, so that the number of regions can be tuned
+ *
+ * 
+ * 
  * CLASS GLH::CORE::VAO
  * 
  * a vertex array object (does not inherit from buffer base class as a vao is not a buffer per se)
@@ -54,10 +77,13 @@
 
 /* include core headers */
 #include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <iterator>
+#include <memory>
 #include <string>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 /* include glhelper_core.hpp */
@@ -66,6 +92,19 @@
 /* include glhelper_math.hpp */
 #include <glhelper/glhelper_math.hpp>
 
+/* include glhelper_sync.hpp */
+#include <glhelper/glhelper_sync.hpp>
+
+
+
+/* MACROS */
+
+/* GLH_UBO_STAGING_MERGE_GAP
+ *
+ * the largest gap in bytes between two staged ranges of a ubo for them to be merged into one upload
+ */
+#define GLH_UBO_STAGING_MERGE_GAP 64
+
 
 
 /* NAMESPACE DECLARATIONS */
@@ -104,6 +143,12 @@ namespace glh
          */
         class ssbo;
 
+        /* class ring_buffer : buffer
+         *
+         * persistently mapped buffer split into frame regions
+         */
+        class ring_buffer;
+
         /* class vao : object
          *
          * vertex array object
@@ -552,6 +597,63 @@ public:
 
 
 
+    /* stage_sub_data
+     *
+     * write data into the CPU-side image of the ubo, to be uploaded on the next flush
+     * 
+     * offset: offset in bytes of where to start writing
+     * size: size of the data in bytes
+     * data: pointer to data
+     */
+    void stage_sub_data ( const unsigned offset, const unsigned size, const void * data );
+
+    /* flush_staging
+     *
+     * upload the ranges of the ubo written to since the last flush
+     * 
+     * return: true if any data was uploaded
+     */
+    bool flush_staging ();
+
+    /* invalidate_staging
+     *
+     * flush any staged data, then discard the CPU-side image, so that it is read back from the ubo when next written to
+     * this should be called after writing to the ubo by means other than uniforms
+     */
+    void invalidate_staging ();
+
+    /* has_staged_data
+     *
+     * returns true if there is staged data waiting to be flushed
+     */
+    bool has_staged_data () const { return !staged_ranges.empty (); }
+
+    /* flush_all_staging
+     *
+     * flush every ubo with staged data
+     * this is called by the renderer before each draw
+     */
+    static void flush_all_staging ();
+
+    /* get_num_staged_writes
+     * get_num_unchanged_staged_writes
+     * get_num_staged_uploads
+     *
+     * get the number of writes staged across all ubos, the number which were dropped as they matched the image, and the number of uploads they were flushed with
+     * the difference between the writes and the uploads is the number of uploads avoided by staging
+     */
+    static unsigned get_num_staged_writes () { return num_staged_writes; }
+    static unsigned get_num_unchanged_staged_writes () { return num_unchanged_staged_writes; }
+    static unsigned get_num_staged_uploads () { return num_staged_uploads; }
+
+    /* reset_staging_statistics
+     *
+     * reset the staged write, unchanged write and upload counts
+     */
+    static void reset_staging_statistics () { num_staged_writes = 0; num_unchanged_staged_writes = 0; num_staged_uploads = 0; }
+
+
+
 private:
 
     /* bound_ubo
@@ -562,12 +664,40 @@ private:
     static object_pointer<ubo> bound_ubo;
     static std::vector<object_pointer<ubo>> bound_ubo_indices;
 
+    /* friend of ring_buffer, which must forget about indices it binds over */
+    friend class ring_buffer;
+
     /* uniform_buffer_offset_alignment
      *
      * constant defined by the implementation for uniform alignment in ubos
      */
     int uniform_buffer_offset_alignment;
 
+    /* staging
+     * staged_ranges
+     *
+     * the CPU-side image of the ubo (empty until first written to),
+     * and the sorted, disjoint ranges of it written to since the last flush, as pairs of begin and end offsets
+     */
+    std::vector<unsigned char> staging;
+    std::vector<std::pair<unsigned, unsigned>> staged_ranges;
+
+    /* staged_ubos
+     *
+     * the ubos with staged data waiting to be flushed
+     */
+    static std::vector<object_pointer<ubo>> staged_ubos;
+
+    /* num_staged_writes
+     * num_unchanged_staged_writes
+     * num_staged_uploads
+     *
+     * staging statistics across all ubos
+     */
+    static unsigned num_staged_writes;
+    static unsigned num_unchanged_staged_writes;
+    static unsigned num_staged_uploads;
+
 };
 
 
@@ -650,6 +780,173 @@ private:
     static object_pointer<ssbo> bound_ssbo;
     static std::vector<object_pointer<ssbo>> bound_ssbo_indices;
 
+    /* friend of ring_buffer, which must forget about indices it binds over */
+    friend class ring_buffer;
+
+};
+
+
+
+/* RING_BUFFER DEFINITION */
+
+/* class ring_buffer : buffer
+ *
+ * persistently mapped buffer split into frame regions
+ */
+class glh::core::ring_buffer : public buffer
+{
+public:
+
+    /* full constructor
+     *
+     * create the buffer and persistently map it
+     * 
+     * _region_size: the size of each frame region in bytes (rounded up to the offset alignment of indexed targets)
+     * _num_regions: the number of frame regions, and so the number of frames the CPU may get ahead of the GPU (defaults to 3)
+     */
+    explicit ring_buffer ( const unsigned _region_size, const unsigned _num_regions = 3 );
+
+    /* deleted zero-parameter constructor */
+    ring_buffer () = delete;
+
+    /* deleted copy constructor */
+    ring_buffer ( const ring_buffer& other ) = delete;
+
+    /* default move constructor */
+    ring_buffer ( ring_buffer&& other ) = default;
+
+    /* deleted copy assignment operator */
+    ring_buffer& operator= ( const ring_buffer& other ) = delete;
+
+    /* default destructor */
+    ~ring_buffer () = default;
+
+
+
+    /* allocate
+     *
+     * allocate space in the current frame region
+     * 
+     * size: the number of bytes to allocate
+     * alignment: the alignment of the allocation in bytes (defaults to 0, meaning the offset alignment of indexed targets)
+     * 
+     * return: the offset of the allocation from the start of the buffer
+     */
+    unsigned allocate ( const unsigned size, const unsigned alignment = 0 );
+
+    /* get_pointer
+     *
+     * get a pointer to the persistent mapping at an offset from the start of the buffer
+     */
+    void * get_pointer ( const unsigned offset ) const { return map_base + offset; }
+
+    /* write with pointer
+     *
+     * allocate space in the current frame region and copy data into it
+     * 
+     * data: pointer to the data
+     * size: the size of the data in bytes
+     * alignment: the alignment of the allocation in bytes (defaults to the offset alignment of indexed targets)
+     * 
+     * return: the offset of the data from the start of the buffer
+     */
+    unsigned write ( const void * data, const unsigned size, const unsigned alignment = 0 );
+
+    /* write with iterators
+     *
+     * first/last: iterators for the data (ie. from begin and end)
+     * alignment: the alignment of the allocation in bytes (defaults to the offset alignment of indexed targets)
+     * 
+     * return: the offset of the data from the start of the buffer
+     */
+    template<class It> unsigned write ( It first, It last, const unsigned alignment = 0 );
+
+    /* bind_range
+     *
+     * bind a range of the buffer to an indexed target
+     * 
+     * target: the indexed target (e.g. GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER)
+     * index: the index of the binding point
+     * offset: the offset of the range from the start of the buffer, as returned by allocate or write
+     * size: the size of the range in bytes
+     */
+    void bind_range ( const GLenum target, const unsigned index, const unsigned offset, const unsigned size ) const;
+
+    /* next_frame
+     *
+     * fence the current frame region, and move to the next one, waiting for the GPU to finish with it if necessary
+     * this should be called once per frame, after the last command which reads from the current region
+     */
+    void next_frame ();
+
+
+
+    /* unbind_all
+     *
+     * the ring buffer is only ever bound by range or to the copy targets, so only unbind from the copy targets
+     */
+    bool unbind_all () const { return ( unbind_copy_read () | unbind_copy_write () ); }
+
+
+
+    /* get_region_size
+     * get_num_regions
+     * get_current_region
+     *
+     * get the size of the frame regions, the number of them, and which is currently being written to
+     */
+    unsigned get_region_size () const { return region_size; }
+    unsigned get_num_regions () const { return num_regions; }
+    unsigned get_current_region () const { return current_region; }
+
+    /* get_region_used
+     *
+     * get the number of bytes allocated in the current frame region
+     */
+    unsigned get_region_used () const { return region_offset; }
+
+    /* get_num_frames
+     * get_num_stalls
+     * get_stall_time
+     *
+     * get the number of frames advanced through, the number of those where the CPU had to wait for the GPU, and the total time waited in seconds
+     */
+    unsigned get_num_frames () const { return num_frames; }
+    unsigned get_num_stalls () const { return num_stalls; }
+    double get_stall_time () const { return stall_time; }
+
+    /* reset_statistics
+     *
+     * reset the frame and stall counts
+     */
+    void reset_statistics () { num_frames = 0; num_stalls = 0; stall_time = 0.0; }
+
+
+
+private:
+
+    /* the size and number of frame regions */
+    unsigned region_size;
+    unsigned num_regions;
+
+    /* the offset alignment of indexed targets */
+    unsigned bind_alignment;
+
+    /* the current region and the offset of the next allocation within it */
+    unsigned current_region;
+    unsigned region_offset;
+
+    /* the persistent mapping of the whole buffer */
+    char * map_base;
+
+    /* the fence placed on each region when it was last finished with, or NULL if none is pending */
+    std::vector<std::unique_ptr<fence_sync>> region_fences;
+
+    /* frame and stall statistics */
+    unsigned num_frames;
+    unsigned num_stalls;
+    double stall_time;
+
 };
 
 
@@ -700,7 +997,8 @@ public:
      * also implicitly enables the vertex attribute
      * 
      * attrib: the attribute to configure (>=0)
-     * buff: the vertex buffer object to bind to the attribute
+     * buff: the vertex buffer object or ring buffer to bind to the attribute
+     *       data written to a ring buffer is reached by the base vertex or base instance of a draw, as the offset is fixed
      * size: components per vertex (1, 2, 3 or 4)
      * type: the type of each component of each vertex
      * norm: boolean as to whether to normalize the vertex data
@@ -708,6 +1006,7 @@ public:
      * offset: the offset from the start of the vertex data in bytes
      */
     void set_vertex_attrib ( const unsigned attrib, const vbo& buff, const int size, const GLenum type, const bool norm, const unsigned stride, const unsigned offset );
+    void set_vertex_attrib ( const unsigned attrib, const ring_buffer& buff, const int size, const GLenum type, const bool norm, const unsigned stride, const unsigned offset );
 
     /* enable_vertex_attrib
      *
@@ -725,6 +1024,15 @@ public:
      */
     void disable_vertex_attrib ( const unsigned attrib );
 
+    /* set_vertex_attrib_divisor
+     *
+     * set the rate at which a vertex attribute advances during instanced rendering
+     * 
+     * attrib: the attribute to configure (>=0)
+     * divisor: the number of instances to draw before advancing (0 advances per vertex rather than per instance)
+     */
+    void set_vertex_attrib_divisor ( const unsigned attrib, const unsigned divisor );
+
     /* bind_ebo
      *
      * binds an element buffer object to the vao
@@ -855,6 +1163,25 @@ template<class T> inline const T& glh::core::buffer::at ( const unsigned i ) con
 
 
 
+/* RING_BUFFER IMPLEMENTATION */
+
+/* write with iterators
+ *
+ * first/last: iterators for the data (ie. from begin and end)
+ * alignment: the alignment of the allocation in bytes (defaults to the offset alignment of indexed targets)
+ * 
+ * return: the offset of the data from the start of the buffer
+ */
+template<class It> inline unsigned glh::core::ring_buffer::write ( It first, It last, const unsigned alignment )
+{
+    /* allocate the space, then copy using iterators */
+    const unsigned offset = allocate ( std::distance ( first, last ) * sizeof ( typename std::iterator_traits<It>::value_type ), alignment );
+    std::copy ( first, last, reinterpret_cast<typename std::iterator_traits<It>::value_type *> ( get_pointer ( offset ) ) );
+    return offset;
+}
+
+
+
 /* UBO IMPLEMENTATION */
 
 /* construct and immediately buffer data with iterators
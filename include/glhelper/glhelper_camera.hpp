@@ -16,6 +16,7 @@
  * abstract base class for all further camera classes
  * functionality such as uniform and matrix caching and applying uniforms is common to all cameras
  * the pure virtual methods are the update_view/proj as the creation of these matrices will differ for each camera
+ * the view and projection matrices are versioned, and apply only sets the matrices which have been recreated since they were last applied to the cached uniforms
  * this class is applied to the following uniform structure
  * 
  * 
@@ -37,6 +38,15 @@
  * view_proj: equal to proj * view
  * viewpos: the viewer position
  * 
+ * shaders/camera.glsl declares this struct in a std140 uniform block, camera_block, so that it can be shared by every program
+ * the camera can then be applied to a ubo bound to that block's binding in one upload, rather than to each program's struct uniform
+ * 
+ * 
+ * 
+ * STRUCT GLH::CAMERA::CAMERA_BLOCK
+ * 
+ * the C++ mirror of camera_struct, described for glh::core::block_type so that it can be laid out as std140 and validated against a program
+ * 
  * 
  * 
  * CLASS GLH::CAMERA::CAMERA_MOVEMENT
@@ -111,6 +121,9 @@
 /* include glhelper_shader.hpp */
 #include <glhelper/glhelper_shader.hpp>
 
+/* include glhelper_block_layout.hpp */
+#include <glhelper/glhelper_block_layout.hpp>
+
 
 
 /* NAMESPACE DECLARATIONS */
@@ -119,6 +132,12 @@ namespace glh
 {
     namespace camera
     {
+        /* struct camera_block
+         *
+         * the parameters of a camera, laid out for camera_struct
+         */
+        struct camera_block;
+
         /* class camera_base
          *
          * base class for all cameras
@@ -184,6 +203,31 @@ namespace glh
 
 
 
+/* CAMERA_BLOCK DEFINITION */
+
+/* struct camera_block
+ *
+ * the parameters of a camera, laid out for camera_struct
+ */
+struct glh::camera::camera_block
+{
+    /* the view, projection and combined matrices */
+    math::fmat4 view;
+    math::fmat4 proj;
+    math::fmat4 view_proj;
+
+    /* the viewer position */
+    math::fvec3 viewpos;
+
+    /* the members of camera_struct */
+    static auto block_members ()
+    {
+        return std::make_tuple ( GLH_BLOCK_MEMBER ( camera_block, view ), GLH_BLOCK_MEMBER ( camera_block, proj ), GLH_BLOCK_MEMBER ( camera_block, view_proj ), GLH_BLOCK_MEMBER ( camera_block, viewpos ) );
+    }
+};
+
+
+
 /* CAMERA_BASE DEFINITION */
 
 /* class camera_base
@@ -198,6 +242,8 @@ public:
     camera_base ()
         : view_change { true }
         , proj_change { true }
+        , view_version { 0 }
+        , proj_version { 0 }
     {}
 
     /* copy constructor
@@ -207,6 +253,8 @@ public:
     camera_base ( const camera_base& other )
         : view_change { true }
         , proj_change { true }
+        , view_version { 0 }
+        , proj_version { 0 }
     {}
 
     /* default move constructor */
@@ -236,12 +284,35 @@ public:
     void apply ( core::struct_uniform& camera_uni );
     void apply () const;
 
+    /* apply to a ubo
+     *
+     * upload the camera to a ubo in one write, laid out as a std140 camera_struct
+     * the ubo should be bound to the binding of a camera_block uniform block
+     * 
+     * camera_ubo: the ubo to upload to
+     */
+    void apply ( core::ubo& camera_ubo ) const;
+
     /* cache_uniforms
      *
      * camera_uni: the uniform to cache
      */
     void cache_uniforms ( core::struct_uniform& camera_uni );
 
+    /* get_block
+     *
+     * get the parameters of the camera, ready to be laid out in a block
+     */
+    camera_block get_block () const;
+
+    /* get_view/proj_version
+     *
+     * get the versions of the view and projection matrices, which are incremented whenever the matrix is recreated
+     * apply only sets the uniforms of matrices whose version has changed since they were last applied to
+     */
+    unsigned get_view_version () const { update_parameters (); return view_version; }
+    unsigned get_proj_version () const { update_parameters (); return proj_version; }
+
 
 
     /* get_view
@@ -284,6 +355,10 @@ private:
     /* viewing position */
     mutable math::vec3 viewpos;
 
+    /* the versions of the view and projection matrices */
+    mutable unsigned view_version;
+    mutable unsigned proj_version;
+
 
 
     /* struct for cached uniforms */
@@ -294,6 +369,10 @@ private:
         core::uniform& proj_uni;
         core::uniform& view_proj_uni;
         core::uniform& viewpos_uni;
+
+        /* the versions of the matrices last applied to the uniforms */
+        unsigned applied_view_version;
+        unsigned applied_proj_version;
     };
 
     /* cached uniforms */
@@ -36,6 +36,11 @@
  * acts as a pointer to an object that may at some point be destroyed
  * one can get an actual pointer to the object through a static method of the object class or through the operators in this class
  * 
+ * every object occupies a slot in a global table of object pointers, which is reused once the object is destroyed
+ * an object pointer records the slot and the unique id of its object, and is valid only while the slot still holds that unique id
+ * since unique ids are never reused, this is a generational handle: validation is a single comparison, with no lookup or RTTI
+ * the object pointer assumes that the object is still of type T, so objects must only be moved into objects of the same type
+ * 
  */
 
 
@@ -50,15 +55,14 @@
 
 /* include core headers */
 #include <iostream>
-#include <map>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
-/* include GLAD followed by GLLFW
- * this order is necesarry, as GLAD defines macros, which GLFW requires even to be included
+/* include GLAD
+ * GLFW is only included by glhelper_glfw.hpp, so headless programs do not need its headers
  */
 #include <glad/glad.h>
-#include <GLFW/glfw3.h>
 
 /* include glhelper_exception.hpp */
 #include <glhelper/glhelper_exception.hpp>
@@ -274,6 +278,16 @@ public:
 
 
 
+    /* get_num_objects
+     * get_num_object_slots
+     *
+     * get the number of objects in existence, and the number of slots in the object table (the greatest number of objects which have existed at once)
+     */
+    static unsigned get_num_objects () { return object_slots.size () - free_object_slots.size (); }
+    static unsigned get_num_object_slots () { return object_slots.size (); }
+
+
+
 protected:
 
     /* NON-STATIC MEMBERS */
@@ -292,6 +306,13 @@ protected:
      */
     const unsigned unique_id;
 
+    /* slot
+     *
+     * the index of the slot of the object in object_slots
+     * will not be changed for move-constructed objects
+     */
+    const unsigned slot;
+
 
 
     /* STATIC MEMBERS */
@@ -303,11 +324,34 @@ protected:
      */
     static unsigned next_unique_id;
 
-    /* object_pointers
+    /* struct object_slot
+     *
+     * a slot of the object table, holding the unique id of the object occupying it and a pointer to the object
+     * the unique id is 0 if the slot is free
+     */
+    struct object_slot
+    {
+        unsigned unique_id;
+        object * ptr;
+    };
+
+    /* object_slots
+     * free_object_slots
      *
-     * map between unique ids and pointers to their objects
+     * the object table, and the indices of the slots of the table which are free to be reused
      */
-    static std::map<unsigned, object *> object_pointers;
+    static std::vector<object_slot> object_slots;
+    static std::vector<unsigned> free_object_slots;
+
+
+
+private:
+
+    /* acquire_slot
+     *
+     * get the index of a free slot in the object table, reusing a freed slot if possible
+     */
+    static unsigned acquire_slot ();
 
 
 };
@@ -333,18 +377,21 @@ public:
     object_pointer ( T& obj )
         : id { obj.internal_id () }
         , unique_id { obj.internal_unique_id () }
+        , slot { obj.slot }
     {}
 
     /* pointer constructor */
     object_pointer ( T * obj )
         : id ( obj ? obj->internal_id () : 0 )
         , unique_id { obj ? obj->internal_unique_id () : 0 }
+        , slot { obj ? obj->slot : 0 }
     {}
 
     /* zero-parameter constructor */
     object_pointer ()
         : id { 0 }
         , unique_id { 0 }
+        , slot { 0 }
     {}
 
     /* default copy constructor */
@@ -428,6 +475,9 @@ private:
     unsigned id;
     unsigned unique_id;
 
+    /* the slot of the object in the object table */
+    unsigned slot;
+
 };
 
 
@@ -439,9 +489,10 @@ private:
 template<class T>
 glh::core::object_pointer<T>& glh::core::object_pointer<T>::operator= ( T& obj )
 {
-    /* set id and unique id */
+    /* set id, unique id and slot */
     id = obj.internal_id ();
     unique_id = obj.internal_unique_id ();
+    slot = obj.slot;
 
     /* return * this */
     return * this;
@@ -449,15 +500,17 @@ glh::core::object_pointer<T>& glh::core::object_pointer<T>::operator= ( T& obj )
 template<class T>
 glh::core::object_pointer<T>& glh::core::object_pointer<T>::operator= ( T * obj )
 {
-    /* set id and unique id */
+    /* set id, unique id and slot */
     if ( obj )
     {
         id = obj->internal_id ();
         unique_id = obj->internal_unique_id ();
+        slot = obj->slot;
     } else
     {
         id = 0;
         unique_id = 0;
+        slot = 0;
     }
     
     /* return * this */
@@ -474,11 +527,9 @@ template<class T> inline T * glh::core::object_pointer<T>::get () const
     /* if unique_id == 0 return NULL */
     if ( unique_id == 0 ) return NULL;
 
-    /* find the pointer */
-    auto ptr = object::object_pointers.find ( unique_id );
-
-    /* if not found, return NULL, else cast the pointer and return it */
-    return dynamic_cast<T *> ( ptr == object::object_pointers.end () ? NULL : ptr->second );
+    /* if the slot still holds the object, cast the pointer and return it, else return NULL */
+    const object::object_slot& _slot = object::object_slots [ slot ];
+    return ( _slot.unique_id == unique_id ? static_cast<T *> ( _slot.ptr ) : NULL );
 }
 
 
@@ -0,0 +1,479 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * include/glhelper/glhelper_culling.hpp
+ *
+ * constructs for culling geometry which will not contribute to the final image
+ * notable constructs include:
+ *
+ *
+ *
+ * CLASS GLH::CULLING::FRUSTUM
+ *
+ * the six planes of a view frustum, extracted from a view-projection matrix
+ * spherical regions can be tested against the planes to determine whether they lie outside of the view
+ * statistics on the number of tests and culled regions are kept until reset
+ * testing makes no OpenGL calls and the statistics are atomic, so regions can be tested from several threads at once
+ *
+ *
+ *
+ * CLASS GLH::CULLING::DEPTH_PYRAMID
+ *
+ * a hierarchical-z (hi-z) depth pyramid built from a depth texture
+ * each level of the pyramid is half the size of the previous, with each texel storing the maximum (furthest) depth of the texels it covers
+ * the pyramid is built on the GPU using a fragment shader downsample chain (shaders/vertex.simple.glsl and shaders/fragment.depth_pyramid.glsl)
+ * once built, a small level of the pyramid is read back to the CPU, which allows spherical regions to be tested for occlusion
+ * the depth and view-projection matrix used for testing are those supplied to the last call to build,
+ * so the intended usage is to build the pyramid after the opaque geometry of one frame, and cull against it in the next
+ * the readback is not done by build, which gives the GPU time to finish the downsample chain:
+ * readback must instead be called on the thread with the context after the build and before the first occlusion test
+ * testing then makes no OpenGL calls and the statistics are atomic, so regions can be tested from several threads at once (e.g. while recording render queues)
+ * statistics on the number of tests and occluded regions are kept until reset
+ *
+ *
+ *
+ * CLASS GLH::EXCEPTION::CULLING_EXCEPTION
+ *
+ * thrown when an error occurs in one of the culling methods (e.g. the depth texture being too small)
+ *
+ */
+
+
+
+/* HEADER GUARD */
+#ifndef GLHELPER_CULLING_HPP_INCLUDED
+#define GLHELPER_CULLING_HPP_INCLUDED
+
+
+
+/* MACROS */
+
+/* GLH_DEPTH_PYRAMID_READBACK_SIZE
+ *
+ * the maximum width and height of the pyramid level read back to the CPU for occlusion testing
+ * defaults to 128
+ */
+#ifndef GLH_DEPTH_PYRAMID_READBACK_SIZE
+    #define GLH_DEPTH_PYRAMID_READBACK_SIZE 128
+#endif
+
+
+
+/* INCLUDES */
+
+/* include core headers */
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+/* include glhelper_core.hpp */
+#include <glhelper/glhelper_core.hpp>
+
+/* include glhelper_buffer.hpp */
+#include <glhelper/glhelper_buffer.hpp>
+
+/* include glhelper_texture.hpp */
+#include <glhelper/glhelper_texture.hpp>
+
+/* include glhelper_shader.hpp */
+#include <glhelper/glhelper_shader.hpp>
+
+/* include glhelper_render.hpp */
+#include <glhelper/glhelper_render.hpp>
+
+/* include glhelper_framebuffer.hpp */
+#include <glhelper/glhelper_framebuffer.hpp>
+
+/* include glhelper_vector.hpp */
+#include <glhelper/glhelper_vector.hpp>
+
+/* include glhelper_matrix.hpp */
+#include <glhelper/glhelper_matrix.hpp>
+
+/* include glhelper_region.hpp */
+#include <glhelper/glhelper_region.hpp>
+
+/* include glhelper_vertices.hpp */
+#include <glhelper/glhelper_vertices.hpp>
+
+
+
+/* NAMESPACE DECLARATIONS */
+
+namespace glh
+{
+    namespace culling
+    {
+        /* class frustum
+         *
+         * view frustum for frustum culling
+         */
+        class frustum;
+
+        /* class depth_pyramid
+         *
+         * hierarchical-z depth pyramid for occlusion culling
+         */
+        class depth_pyramid;
+    }
+
+    namespace exception
+    {
+        /* class culling_exception : exception
+         *
+         * exception relating to culling
+         */
+        class culling_exception;
+    }
+}
+
+
+
+/* FRUSTUM DEFINITION */
+
+/* class frustum
+ *
+ * view frustum for frustum culling
+ */
+class glh::culling::frustum
+{
+public:
+
+    /* full constructor
+     *
+     * extract the planes of the frustum from a view-projection matrix
+     *
+     * view_proj: the view-projection matrix to extract the planes from
+     */
+    explicit frustum ( const math::mat4& view_proj ) : num_tests { 0 }, num_culled { 0 } { set_view_proj ( view_proj ); }
+
+    /* default zero-parameter constructor
+     *
+     * the frustum will cull nothing until set_view_proj is called
+     */
+    frustum () : num_tests { 0 }, num_culled { 0 } {}
+
+    /* copy constructor
+     *
+     * the statistics are copied too
+     */
+    frustum ( const frustum& other ) : planes { other.planes }, num_tests { other.num_tests.load () }, num_culled { other.num_culled.load () } {}
+
+    /* copy assignment operator
+     *
+     * the statistics are copied too
+     */
+    frustum& operator= ( const frustum& other ) { planes = other.planes; num_tests = other.num_tests.load (); num_culled = other.num_culled.load (); return * this; }
+
+    /* default destructor */
+    ~frustum () = default;
+
+
+
+    /* set_view_proj
+     *
+     * re-extract the planes of the frustum from a new view-projection matrix
+     * the statistics are not reset
+     *
+     * view_proj: the view-projection matrix to extract the planes from
+     */
+    void set_view_proj ( const math::mat4& view_proj );
+
+
+
+    /* is_culled
+     *
+     * test whether a region lies entirely outside of the frustum
+     *
+     * _region: the region to test (in world space)
+     *
+     * return: true if the region is outside of the frustum
+     */
+    bool is_culled ( const region::spherical_region<>& _region ) const;
+
+    /* is_visible
+     *
+     * the opposite of is_culled, for any number of regions
+     *
+     * _region(s): the region(s) to test (in world space)
+     *
+     * return: true (or a vector of booleans) if the region(s) are at least partially inside the frustum
+     */
+    bool is_visible ( const region::spherical_region<>& _region ) const { return !is_culled ( _region ); }
+    std::vector<bool> is_visible ( const std::vector<region::spherical_region<>>& regions ) const;
+
+
+
+    /* get_num_tests
+     *
+     * get the number of frustum tests performed since the last reset
+     */
+    unsigned get_num_tests () const { return num_tests; }
+
+    /* get_num_culled
+     *
+     * get the number of frustum tests which concluded the region was outside of the frustum since the last reset
+     */
+    unsigned get_num_culled () const { return num_culled; }
+
+    /* reset_statistics
+     *
+     * reset the number of tests and number of culled regions to zero
+     */
+    void reset_statistics () const { num_tests = 0; num_culled = 0; }
+
+
+
+private:
+
+    /* the planes of the frustum
+     * each plane is stored as a normal followed by a distance, with the normal pointing into the frustum
+     * the planes are in the order left, right, bottom, top, near, far
+     */
+    std::array<math::vec4, 6> planes;
+
+    /* statistics */
+    mutable std::atomic<unsigned> num_tests;
+    mutable std::atomic<unsigned> num_culled;
+
+};
+
+
+
+/* DEPTH_PYRAMID DEFINITION */
+
+/* class depth_pyramid
+ *
+ * hierarchical-z depth pyramid for occlusion culling
+ */
+class glh::culling::depth_pyramid
+{
+public:
+
+    /* full constructor
+     *
+     * create the pyramid for a depth texture of given dimensions
+     * the base level of the pyramid is half the size of the depth texture
+     *
+     * _depth_width/_depth_height: the width and height of the depth texture the pyramid will be built from
+     */
+    depth_pyramid ( const unsigned _depth_width, const unsigned _depth_height );
+
+    /* deleted zero-parameter constructor */
+    depth_pyramid () = delete;
+
+    /* deleted copy constructor */
+    depth_pyramid ( const depth_pyramid& other ) = delete;
+
+    /* deleted move constructor */
+    depth_pyramid ( depth_pyramid&& other ) = delete;
+
+    /* deleted copy assignment operator */
+    depth_pyramid& operator= ( const depth_pyramid& other ) = delete;
+
+    /* default destructor */
+    ~depth_pyramid () = default;
+
+
+
+    /* build
+     *
+     * build the pyramid from a depth texture
+     * this will change the bound framebuffer, program, vao and viewport
+     * the render state is restored afterwards
+     * readback must be called before the pyramid is next tested against
+     *
+     * depth_texture: the depth texture to build from (must be the same size as specified in the constructor)
+     * view_proj: the view-projection matrix used to render the depth texture
+     */
+    void build ( const core::texture2d& depth_texture, const math::mat4& view_proj );
+
+    /* readback
+     *
+     * read back the readback level of the last build to the CPU, if not already read
+     * this must be called on the thread with the context, and before any region is tested after a build
+     */
+    void readback () const;
+
+    /* is_readback_pending
+     *
+     * returns true if the pyramid has been built since it was last read back
+     */
+    bool is_readback_pending () const { return readback_pending; }
+
+
+
+    /* is_occluded
+     *
+     * test whether a region is definitely hidden behind the depth of the last build
+     * regions which intersect the near plane or lie outside of the view at the time of the build are never considered occluded
+     * if the pyramid has not yet been built, no region is occluded
+     * throws if the pyramid has been built but not read back
+     *
+     * _region: the region to test (in world space)
+     *
+     * return: true if the region is occluded
+     */
+    bool is_occluded ( const region::spherical_region<>& _region ) const;
+
+    /* is_visible
+     *
+     * the opposite of is_occluded, for any number of regions
+     *
+     * _region(s): the region(s) to test (in world space)
+     *
+     * return: true (or a vector of booleans) if the region(s) are not occluded
+     */
+    bool is_visible ( const region::spherical_region<>& _region ) const { return !is_occluded ( _region ); }
+    std::vector<bool> is_visible ( const std::vector<region::spherical_region<>>& regions ) const;
+
+
+
+    /* get_num_tests
+     *
+     * get the number of occlusion tests performed since the last reset
+     */
+    unsigned get_num_tests () const { return num_tests; }
+
+    /* get_num_occluded
+     *
+     * get the number of occlusion tests which concluded the region was occluded since the last reset
+     */
+    unsigned get_num_occluded () const { return num_occluded; }
+
+    /* reset_statistics
+     *
+     * reset the number of tests and number of occluded regions to zero
+     */
+    void reset_statistics () const { num_tests = 0; num_occluded = 0; }
+
+
+
+    /* is_built
+     *
+     * returns true if the pyramid has been built at least once
+     */
+    bool is_built () const { return built; }
+
+    /* get_pyramid_texture
+     *
+     * get the texture containing the pyramid
+     */
+    const core::texture2d& get_pyramid_texture () const { return pyramid_texture; }
+
+    /* get_num_levels
+     *
+     * get the number of mipmap levels in the pyramid
+     */
+    const unsigned& get_num_levels () const { return num_levels; }
+
+    /* get_readback_level
+     *
+     * get the level of the pyramid which is read back for occlusion tests
+     */
+    const unsigned& get_readback_level () const { return readback_level; }
+
+
+
+private:
+
+    /* the width and height of the depth texture */
+    const unsigned depth_width;
+    const unsigned depth_height;
+
+    /* the number of levels in the pyramid */
+    const unsigned num_levels;
+
+    /* the level read back to the CPU and its dimensions */
+    unsigned readback_level;
+    unsigned readback_width;
+    unsigned readback_height;
+
+
+
+    /* the texture containing the pyramid */
+    core::texture2d pyramid_texture;
+
+    /* an fbo for each level of the pyramid */
+    std::vector<core::fbo> pyramid_fbos;
+
+    /* shaders and program for downsampling */
+    core::vshader downsample_vshader;
+    core::fshader downsample_fshader;
+    core::program downsample_program;
+
+    /* quad to render each level with */
+    core::vbo quad_vbo;
+    core::vao quad_vao;
+
+
+
+    /* true if the pyramid has been built */
+    bool built;
+
+    /* true if the readback level has changed since it was last read */
+    mutable bool readback_pending;
+
+    /* the depths of the readback level */
+    mutable std::vector<GLfloat> readback_depths;
+
+    /* the view-projection matrix of the last build */
+    math::mat4 build_view_proj;
+
+    /* statistics */
+    mutable std::atomic<unsigned> num_tests;
+    mutable std::atomic<unsigned> num_occluded;
+
+
+
+    /* level_width/height
+     *
+     * get the width/height of a level of the pyramid
+     *
+     * level: the level to get the dimension of
+     */
+    unsigned level_width ( const unsigned level ) const { return std::max ( ( depth_width / 2 ) >> level, 1u ); }
+    unsigned level_height ( const unsigned level ) const { return std::max ( ( depth_height / 2 ) >> level, 1u ); }
+
+};
+
+
+
+/* CULLING_EXCEPTION DEFINITION */
+
+/* class culling_exception : exception
+ *
+ * exception relating to culling
+ */
+class glh::exception::culling_exception : public exception
+{
+public:
+
+    /* full constructor
+     *
+     * __what: description of the exception
+     */
+    explicit culling_exception ( const std::string& __what )
+        : exception { __what }
+    {}
+
+    /* default zero-parameter constructor
+     *
+     * construct culling_exception with no descrption
+     */
+    culling_exception () = default;
+
+    /* default everything else and inherits what () function */
+
+};
+
+
+
+/* #ifndef GLHELPER_CULLING_HPP_INCLUDED */
+#endif
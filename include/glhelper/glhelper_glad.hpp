@@ -15,6 +15,9 @@
  * 
  * class containing static methods to initialise OpenGL (using GLAD) 
  * will also keep track of the currently loaded context, so that the same context cannot be loaded more than once
+ * contexts are usually GLFW windows, but any context can be loaded by giving its handle and a function to get procedure addresses (e.g. eglGetProcAddress for glh::headless::context)
+ * glad was generated without any extensions, so the few extensions GLHelper makes use of are detected and loaded by hand on loading a context
+ * currently this is just GL_KHR_parallel_shader_compile (or its ARB equivalent), which lets shader and program completion be polled without blocking
  * 
  * 
  * 
@@ -38,10 +41,24 @@
 #include <iostream>
 #include <string>
 
+/* include glhelper_core.hpp */
 #include <glhelper/glhelper_core.hpp>
 
-/* include glhelper_glfw.hpp */
-#include <glhelper/glhelper_glfw.hpp>
+
+
+/* MACROS */
+
+/* GL_MAX_SHADER_COMPILER_THREADS_KHR
+ * GL_COMPLETION_STATUS_KHR
+ *
+ * tokens of GL_KHR_parallel_shader_compile, which are shared with GL_ARB_parallel_shader_compile
+ */
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+    #define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+    #define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
 
 
 
@@ -102,15 +119,33 @@ public:
 
     /* load
      *
-     * loads glad to the current context
+     * loads glad to the current context, which was made current by GLFW
+     * this overload is defined in glhelper_glfw.cpp, so only programs using glfw need to link against it
      */
     static void load ();
 
+    /* load
+     *
+     * loads glad to the current context, which was not made current by GLFW
+     *
+     * context: a handle to the current context, which is used to avoid reloading the same context
+     * get_proc_address: the function to get the address of each OpenGL function with
+     */
+    static void load ( const void * context, GLADloadproc get_proc_address );
+
+    /* unload
+     *
+     * forget the loaded context, if it is the context given, so that the next context loaded is always loaded, even if it reuses its handle
+     *
+     * context: a handle to the context being destroyed
+     */
+    static void unload ( const void * context ) { if ( context == active_context ) active_context = NULL; }
+
     /* is_loaded
      *
      * returns true if glad has been loaded
      */
-    static bool is_loaded () { return active_window; }
+    static bool is_loaded () { return active_context; }
 
     /* is_window_loaded
      *
@@ -124,13 +159,47 @@ public:
 
 
 
+    /* has_extension
+     *
+     * checks whether the current context supports an extension
+     *
+     * name: the name of the extension (e.g. GL_KHR_parallel_shader_compile)
+     *
+     * return: boolean representing if the extension is supported
+     */
+    static bool has_extension ( const std::string& name );
+
+    /* has_parallel_shader_compile
+     *
+     * returns true if the current context supports GL_KHR_parallel_shader_compile or GL_ARB_parallel_shader_compile
+     * if so, GL_COMPLETION_STATUS_KHR can be queried on shaders and programs to check whether they have finished compiling or linking without blocking
+     */
+    static bool has_parallel_shader_compile () { return max_shader_compiler_threads_proc; }
+
+    /* set_max_shader_compiler_threads
+     *
+     * hint to the driver how many threads to compile shaders and link programs with
+     * does nothing if parallel shader compile is not supported
+     *
+     * count: the number of threads, where 0 disables parallel compilation and 0xffffffff (the initial value) leaves it to the driver
+     */
+    static void set_max_shader_compiler_threads ( const unsigned count );
+
+
+
 private:
 
-    /* GLFWwindow * active_window
+    /* const void * active_context
+     *
+     * a handle to the currently active context (e.g. a GLFWwindow pointer)
+     */
+    static const void * active_context;
+
+    /* max_shader_compiler_threads_proc
      *
-     * a pointer to the currently active window
+     * glMaxShaderCompilerThreadsKHR/ARB, loaded by hand as it is not part of glad, or NULL if not supported
      */
-    static const GLFWwindow * active_window;
+    static void ( APIENTRYP max_shader_compiler_threads_proc ) ( GLuint count );
 
 };
 
@@ -48,6 +48,11 @@
 /* include glhelper_core.hpp */
 #include <glhelper/glhelper_core.hpp>
 
+/* include GLFW after glhelper_core.hpp
+ * this order is necesarry, as GLAD defines macros, which GLFW requires even to be included
+ */
+#include <GLFW/glfw3.h>
+
 /* include glhelper_glad.hpp */
 #include <glhelper/glhelper_glad.hpp>
 
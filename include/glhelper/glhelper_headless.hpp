@@ -0,0 +1,363 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * include/glhelper/glhelper_headless.hpp
+ *
+ * constructs for rendering without a display, and checking the results against golden images
+ * this header is not included by glhelper.hpp, as it includes the EGL headers, so it must be included directly
+ * likewise glhelper_headless.o is not part of libglhelper, so programs which use it must link it and -lEGL themselves
+ * notable constructs include:
+ *
+ *
+ *
+ * CLASS GLH::HEADLESS::CONTEXT
+ *
+ * an OpenGL context with no window or default framebuffer, created through EGL
+ * the surfaceless Mesa platform is used if available (so software drivers such as llvmpipe work with no display server at all), otherwise the default EGL display
+ * either way, EGL_KHR_surfaceless_context is required, so that the context can be made current with no surface
+ * on construction, the context is made current and glad is loaded to it with eglGetProcAddress through glh::core::glad_loader,
+ * so everything else in the library (e.g. the renderer, models, lighting and framebuffers) works as it does with a glh::glfw::window
+ * the state cache of the renderer is also reset on construction, as a new context starts in the default state
+ * EGL shares one initialisation between every user of a display, so the displays are reference counted, and only terminated once no context uses them
+ * since there is no default framebuffer, everything must be rendered into fbos
+ * as with windows, the library keeps global state per process (e.g. bindings and registered objects), so only one context should be used at a time
+ *
+ *
+ *
+ * CLASS GLH::HEADLESS::IMAGE_REGRESSION
+ *
+ * compares rendered images against golden images, for checking that rendering is unchanged (e.g. in continuous integration)
+ * each comparison reads back a texture (or the default framebuffer of a window) as 8-bit RGBA, and writes it to the output directory with stb_image_write
+ * it is then compared against the image of the same name in the golden directory, and passes if few enough pixels differ by more than a tolerance in any channel
+ * if a comparison fails, an image marking the differing pixels in red is also written to the output directory
+ * if there is no golden image, by default the result is recorded as the golden image and the comparison passes, so golden images are created by the first run
+ * when checking against committed golden images (e.g. in continuous integration), missing golden images can instead be made to fail the comparison
+ * the number of comparisons which passed, failed and were recorded are kept, along with the fraction of pixels which differed in the last comparison
+ *
+ *
+ *
+ * CLASS GLH::EXCEPTION::HEADLESS_EXCEPTION
+ *
+ * thrown when an error occurs in one of the headless methods (e.g. no EGL display is available)
+ *
+ */
+
+
+
+/* HEADER GUARD */
+#ifndef GLHELPER_HEADLESS_HPP_INCLUDED
+#define GLHELPER_HEADLESS_HPP_INCLUDED
+
+
+
+/* INCLUDES */
+
+/* include core headers */
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+/* include glhelper_core.hpp */
+#include <glhelper/glhelper_core.hpp>
+
+/* include glhelper_exception.hpp */
+#include <glhelper/glhelper_exception.hpp>
+
+/* include glhelper_glad.hpp */
+#include <glhelper/glhelper_glad.hpp>
+
+/* include glhelper_texture.hpp */
+#include <glhelper/glhelper_texture.hpp>
+
+/* include glhelper_framebuffer.hpp */
+#include <glhelper/glhelper_framebuffer.hpp>
+
+/* include glhelper_render.hpp */
+#include <glhelper/glhelper_render.hpp>
+
+/* include egl, without any X11 headers */
+#ifndef EGL_NO_X11
+    #define EGL_NO_X11
+#endif
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+
+
+/* NAMESPACE DECLARATIONS */
+
+namespace glh
+{
+    namespace headless
+    {
+        /* class context
+         *
+         * an OpenGL context with no window
+         */
+        class context;
+
+        /* class image_regression
+         *
+         * compares rendered images against golden images
+         */
+        class image_regression;
+    }
+
+    namespace exception
+    {
+        /* class headless_exception : exception
+         *
+         * exception relating to headless rendering
+         */
+        class headless_exception;
+    }
+}
+
+
+
+/* CONTEXT DEFINITION */
+
+/* class context
+ *
+ * an OpenGL context with no window
+ */
+class glh::headless::context
+{
+public:
+
+    /* full constructor
+     *
+     * create a core profile context, make it current, load glad to it and reset the state cache of the renderer
+     *
+     * major_version/minor_version: the version of OpenGL to request (defaults to 4.6)
+     */
+    explicit context ( const unsigned major_version = 4, const unsigned minor_version = 6 );
+
+    /* deleted copy constructor */
+    context ( const context& other ) = delete;
+
+    /* deleted copy assignment operator */
+    context& operator= ( const context& other ) = delete;
+
+    /* destructor
+     *
+     * release and destroy the context, terminating the display if no other context uses it
+     */
+    ~context ();
+
+
+
+    /* make_current
+     *
+     * makes the context current, loading glad to it if it is not already loaded
+     */
+    void make_current () const;
+
+    /* is_current
+     *
+     * checks if the context is current
+     */
+    bool is_current () const { return eglGetCurrentContext () == egl_context; }
+
+    /* get_renderer
+     *
+     * get the name of the renderer of the context (e.g. llvmpipe)
+     */
+    std::string get_renderer () const;
+
+    /* is_surfaceless_platform
+     *
+     * returns true if the surfaceless Mesa platform is being used, rather than the default EGL display
+     */
+    bool is_surfaceless_platform () const { return surfaceless_platform; }
+
+
+
+private:
+
+    /* the EGL display and context */
+    EGLDisplay display;
+    EGLContext egl_context;
+
+    /* whether the surfaceless Mesa platform is being used */
+    bool surfaceless_platform;
+
+    /* the number of contexts using each initialised display */
+    static std::map<EGLDisplay, unsigned> display_references;
+
+
+
+    /* release_display
+     *
+     * remove a reference to a display, terminating it if it has no references left
+     *
+     * _display: the display to release
+     */
+    static void release_display ( const EGLDisplay _display );
+
+};
+
+
+
+/* IMAGE_REGRESSION DEFINITION */
+
+/* class image_regression
+ *
+ * compares rendered images against golden images
+ */
+class glh::headless::image_regression
+{
+public:
+
+    /* full constructor
+     *
+     * _golden_directory: the directory containing the golden images, where missing golden images are recorded
+     * _output_directory: the directory to write the rendered images and difference images to
+     * _channel_tolerance: the largest difference in any channel for pixels to be considered the same (defaults to 2)
+     * _max_differing_fraction: the largest fraction of pixels which can differ for a comparison to pass (defaults to 0.001)
+     * _fail_on_missing: true if a missing golden image should fail the comparison, rather than be recorded (defaults to false)
+     */
+    image_regression ( const std::string& _golden_directory, const std::string& _output_directory, const unsigned _channel_tolerance = 2, const double _max_differing_fraction = 0.001, const bool _fail_on_missing = false );
+
+    /* deleted copy constructor */
+    image_regression ( const image_regression& other ) = delete;
+
+    /* default move constructor */
+    image_regression ( image_regression&& other ) = default;
+
+    /* deleted copy assignment operator */
+    image_regression& operator= ( const image_regression& other ) = delete;
+
+    /* default destructor */
+    ~image_regression () = default;
+
+
+
+    /* compare
+     *
+     * read back the base level of a texture and compare it against its golden image
+     *
+     * name: the name of the image, which is the name of its png files without the extension
+     * texture: the texture to compare
+     *
+     * return: true if the comparison passed, or the golden image was recorded
+     */
+    bool compare ( const std::string& name, const core::texture2d& texture );
+
+    /* compare_default_framebuffer
+     *
+     * copy the color buffer of the default framebuffer into a texture and compare it against its golden image
+     * this needs a window, as a headless context has no default framebuffer
+     *
+     * name: the name of the image, which is the name of its png files without the extension
+     * width/height: the dimensions of the default framebuffer
+     *
+     * return: true if the comparison passed, or the golden image was recorded
+     */
+    bool compare_default_framebuffer ( const std::string& name, const unsigned width, const unsigned height );
+
+
+
+    /* get_num_passed/failed/recorded
+     *
+     * get the number of comparisons which passed, failed, and recorded a golden image
+     */
+    unsigned get_num_passed () const { return num_passed; }
+    unsigned get_num_failed () const { return num_failed; }
+    unsigned get_num_recorded () const { return num_recorded; }
+
+    /* get_last_differing_fraction
+     *
+     * get the fraction of pixels which differed in the last comparison, which is 1.0 if the dimensions differed or the golden image was missing
+     */
+    double get_last_differing_fraction () const { return last_differing_fraction; }
+
+
+
+private:
+
+    /* the golden and output directories */
+    std::filesystem::path golden_directory;
+    std::filesystem::path output_directory;
+
+    /* the tolerances of comparisons */
+    unsigned channel_tolerance;
+    double max_differing_fraction;
+
+    /* whether missing golden images fail comparisons */
+    bool fail_on_missing;
+
+    /* statistics */
+    unsigned num_passed;
+    unsigned num_failed;
+    unsigned num_recorded;
+    double last_differing_fraction;
+
+
+
+    /* compare_pixels
+     *
+     * write rendered pixels and compare them against their golden image
+     *
+     * name: the name of the image
+     * width/height: the dimensions of the image
+     * pixels: the 8-bit RGBA pixels read back from OpenGL, with the bottom row first, which are flipped in place
+     *
+     * return: true if the comparison passed, or the golden image was recorded
+     */
+    bool compare_pixels ( const std::string& name, const unsigned width, const unsigned height, std::vector<unsigned char>& pixels );
+
+    /* write_png
+     *
+     * write 8-bit RGBA pixels to a png, with the top row first, creating its directory if necessary
+     *
+     * path: the path to write to
+     * width/height: the dimensions of the image
+     * pixels: the pixels to write
+     */
+    static void write_png ( const std::filesystem::path& path, const unsigned width, const unsigned height, const std::vector<unsigned char>& pixels );
+
+};
+
+
+
+/* HEADLESS_EXCEPTION DEFINITION */
+
+/* class headless_exception : exception
+ *
+ * exception relating to headless rendering
+ */
+class glh::exception::headless_exception : public exception
+{
+public:
+
+    /* full constructor
+     *
+     * __what: description of the exception
+     */
+    explicit headless_exception ( const std::string& __what )
+        : exception { __what }
+    {}
+
+    /* default zero-parameter constructor
+     *
+     * construct headless_exception with no descrption
+     */
+    headless_exception () = default;
+
+    /* default everything else and inherits what () function */
+
+};
+
+
+
+/* #ifndef GLHELPER_HEADLESS_HPP_INCLUDED */
+#endif
@@ -20,6 +20,8 @@
  * CLASS GLH::LIGHTING::SPOTLIGHT
  * 
  * classes storing the attributes of a different types of light
+ * each light has a version, which every setter increments, and apply only sets the uniforms if the version has changed since they were last applied to
+ * the individual uniforms then only make calls for values which differ from those last written to the program
  * these attributes can be applied to a the respective uniforms struct uniform:
  * 
  * 
@@ -40,8 +42,9 @@
  *     mat4 shadow_trans;
  * 
  *     float shadow_bias;
+ *     float shadow_depth_range_mult;
  * 
- *     float pcf_samples;
+ *     int pcf_samples;
  *     float pcf_radius;
  *     mat2 pcf_rotation;
  * };
@@ -69,7 +72,7 @@
  *     mat2 pcf_rotation;
  * };
  * 
- * struct light_struct
+ * struct spotlight_struct
  * {
  *     vec3 position;
  *     vec3 direction;
@@ -111,7 +114,7 @@
  * shadow_mapping_enabled: whether the light should be shadow mapped (all types)
  * shadow_trans: the transformation matrix used for shadow mapping (only directional and spot lights)
  * shadow_bias: the bias to apply when sampling from the shadow map
- * shadow_depth_range_mult: reciprocal the side length of the perspective frustum (only point and spot lights)
+ * shadow_depth_range_mult: reciprocal the side length of the perspective frustum (only point and spot lights, and zero for directional lights)
  * pcf_samples: the number of pcf samples to take (all types)
  * pcf_radius: the radius of pcf samples (all types)
  * pcf_rotation: an anticlockwise rotation by 360/pcf_samples degrees (all types)
@@ -130,24 +133,38 @@
  * struct light_system_struct
  * {
  *     int dirlights_size;
- *     light_struct dirlights [ MAX_NUM_LIGHTS ];
+ *     dirlight_struct dirlights [ MAX_NUM_DIRLIGHTS ];
  *
  *     int pointlights_size;
- *     light_struct pointlights [ MAX_NUM_LIGHTS ];
+ *     pointlight_struct pointlights [ MAX_NUM_POINTLIGHTS ];
  *
  *     int spotlights_size;
- *     light_struct spotlights_size [ MAX_NUM_LIGHTS ];
- * 
- *     sampler2DArrayShadow shadow_maps;
+ *     spotlight_struct spotlights [ MAX_NUM_SPOTLIGHTS ];
  * };
  * 
+ * uniform sampler2DArrayShadow light_system_shadow_maps;
+ * 
  * this structure holds multiple arrays of lights
  * this is the structure the glh::lighting::light_system class expects to be supplied with to write to
  * 
  * dirlights(_size): array of directional lights and its size
  * pointlights(_size): array of collection of point lights and its size
  * spotlights(_size): collection of spotlights and its size
- * shadow_maps: sampler for shadow maps
+ * 
+ * the shadow maps are not part of the struct, as opaque types cannot be stored in blocks
+ * instead they are a separate uniform, with the name of the struct uniform followed by _shadow_maps
+ * shaders/lighting.glsl declares the struct in a std140 uniform block, light_system_block, so that it can be shared by every program
+ * the light system can then be applied to a ubo bound to that block's binding in one upload, rather than to each program's struct uniform
+ * 
+ * 
+ * 
+ * STRUCT GLH::LIGHTING::DIRLIGHT_BLOCK, POINTLIGHT_BLOCK, SPOTLIGHT_BLOCK AND LIGHT_SYSTEM_BLOCK
+ * 
+ * the C++ mirrors of the GLSL structs above, described for glh::core::block_type so that they can be laid out as std140 and validated against a program
+ * the sizes of the light arrays are GLH_LIGHTING_MAX_DIRLIGHTS/POINTLIGHTS/SPOTLIGHTS
+ * light_system::get_shader_defines gives the #define directives to add to shaders including shaders/lighting.glsl, so that the maxima always match
+ * light_system::get_permutation_features and get_permutation_values describe the light system as glh::core::program_permutations features,
+ * so that a variant of a lighting program can be built with its loops unrolled for the current number of lights, and with shadow mapping removed when no light uses it
  * 
  */
 
@@ -199,6 +216,31 @@
 /* include glhelper_render.hpp */
 #include <glhelper/glhelper_render.hpp>
 
+/* include glhelper_block_layout.hpp */
+#include <glhelper/glhelper_block_layout.hpp>
+
+/* include glhelper_permutation.hpp */
+#include <glhelper/glhelper_permutation.hpp>
+
+
+
+/* MACROS */
+
+/* GLH_LIGHTING_MAX_DIRLIGHTS/POINTLIGHTS/SPOTLIGHTS
+ *
+ * the sizes of the light arrays of a light_system_block, which are injected into shaders as MAX_NUM_DIRLIGHTS/POINTLIGHTS/SPOTLIGHTS
+ * default to 1
+ */
+#ifndef GLH_LIGHTING_MAX_DIRLIGHTS
+    #define GLH_LIGHTING_MAX_DIRLIGHTS 1
+#endif
+#ifndef GLH_LIGHTING_MAX_POINTLIGHTS
+    #define GLH_LIGHTING_MAX_POINTLIGHTS 1
+#endif
+#ifndef GLH_LIGHTING_MAX_SPOTLIGHTS
+    #define GLH_LIGHTING_MAX_SPOTLIGHTS 1
+#endif
+
 
 
 /* NAMESPACE DECLARATIONS */
@@ -207,6 +249,20 @@ namespace glh
 {
     namespace lighting
     {
+        /* struct dirlight_block
+         * struct pointlight_block
+         * struct spotlight_block
+         * struct light_system_block
+         *
+         * the attributes of lights and light systems, laid out for the GLSL light structs
+         */
+        struct dirlight_block;
+        struct pointlight_block;
+        struct spotlight_block;
+        struct light_system_block;
+
+
+
         /* class dirlight : light
          *
          * directional light class
@@ -259,6 +315,143 @@ template<> struct glh::meta::is_light<glh::lighting::spotlight> : std::true_type
 
 
 
+/* LIGHT BLOCK DEFINITIONS */
+
+/* struct dirlight_block
+ *
+ * the attributes of a directional light, laid out for dirlight_struct
+ */
+struct glh::lighting::dirlight_block
+{
+    math::fvec3 direction;
+    math::fvec3 ambient_color;
+    math::fvec3 diffuse_color;
+    math::fvec3 specular_color;
+    bool enabled;
+    bool shadow_mapping_enabled;
+    math::fmat4 shadow_trans;
+    float shadow_bias;
+    float shadow_depth_range_mult;
+    int pcf_samples;
+    float pcf_radius;
+    math::fmat2 pcf_rotation;
+
+    /* the members of dirlight_struct */
+    static auto block_members ()
+    {
+        return std::make_tuple
+        (
+            GLH_BLOCK_MEMBER ( dirlight_block, direction ), GLH_BLOCK_MEMBER ( dirlight_block, ambient_color ), GLH_BLOCK_MEMBER ( dirlight_block, diffuse_color ),
+            GLH_BLOCK_MEMBER ( dirlight_block, specular_color ), GLH_BLOCK_MEMBER ( dirlight_block, enabled ), GLH_BLOCK_MEMBER ( dirlight_block, shadow_mapping_enabled ),
+            GLH_BLOCK_MEMBER ( dirlight_block, shadow_trans ), GLH_BLOCK_MEMBER ( dirlight_block, shadow_bias ), GLH_BLOCK_MEMBER ( dirlight_block, shadow_depth_range_mult ),
+            GLH_BLOCK_MEMBER ( dirlight_block, pcf_samples ), GLH_BLOCK_MEMBER ( dirlight_block, pcf_radius ), GLH_BLOCK_MEMBER ( dirlight_block, pcf_rotation )
+        );
+    }
+};
+
+/* struct pointlight_block
+ *
+ * the attributes of a point light, laid out for pointlight_struct
+ */
+struct glh::lighting::pointlight_block
+{
+    math::fvec3 position;
+    float att_const;
+    float att_linear;
+    float att_quad;
+    math::fvec3 ambient_color;
+    math::fvec3 diffuse_color;
+    math::fvec3 specular_color;
+    bool enabled;
+    bool shadow_mapping_enabled;
+    float shadow_bias;
+    float shadow_depth_range_mult;
+    int pcf_samples;
+    float pcf_radius;
+    math::fmat2 pcf_rotation;
+
+    /* the members of pointlight_struct */
+    static auto block_members ()
+    {
+        return std::make_tuple
+        (
+            GLH_BLOCK_MEMBER ( pointlight_block, position ), GLH_BLOCK_MEMBER ( pointlight_block, att_const ), GLH_BLOCK_MEMBER ( pointlight_block, att_linear ),
+            GLH_BLOCK_MEMBER ( pointlight_block, att_quad ), GLH_BLOCK_MEMBER ( pointlight_block, ambient_color ), GLH_BLOCK_MEMBER ( pointlight_block, diffuse_color ),
+            GLH_BLOCK_MEMBER ( pointlight_block, specular_color ), GLH_BLOCK_MEMBER ( pointlight_block, enabled ), GLH_BLOCK_MEMBER ( pointlight_block, shadow_mapping_enabled ),
+            GLH_BLOCK_MEMBER ( pointlight_block, shadow_bias ), GLH_BLOCK_MEMBER ( pointlight_block, shadow_depth_range_mult ), GLH_BLOCK_MEMBER ( pointlight_block, pcf_samples ),
+            GLH_BLOCK_MEMBER ( pointlight_block, pcf_radius ), GLH_BLOCK_MEMBER ( pointlight_block, pcf_rotation )
+        );
+    }
+};
+
+/* struct spotlight_block
+ *
+ * the attributes of a spotlight, laid out for spotlight_struct
+ */
+struct glh::lighting::spotlight_block
+{
+    math::fvec3 position;
+    math::fvec3 direction;
+    float inner_cone;
+    float outer_cone;
+    float att_const;
+    float att_linear;
+    float att_quad;
+    math::fvec3 ambient_color;
+    math::fvec3 diffuse_color;
+    math::fvec3 specular_color;
+    bool enabled;
+    bool shadow_mapping_enabled;
+    math::fmat4 shadow_trans;
+    float shadow_bias;
+    float shadow_depth_range_mult;
+    int pcf_samples;
+    float pcf_radius;
+    math::fmat2 pcf_rotation;
+
+    /* the members of spotlight_struct */
+    static auto block_members ()
+    {
+        return std::make_tuple
+        (
+            GLH_BLOCK_MEMBER ( spotlight_block, position ), GLH_BLOCK_MEMBER ( spotlight_block, direction ), GLH_BLOCK_MEMBER ( spotlight_block, inner_cone ),
+            GLH_BLOCK_MEMBER ( spotlight_block, outer_cone ), GLH_BLOCK_MEMBER ( spotlight_block, att_const ), GLH_BLOCK_MEMBER ( spotlight_block, att_linear ),
+            GLH_BLOCK_MEMBER ( spotlight_block, att_quad ), GLH_BLOCK_MEMBER ( spotlight_block, ambient_color ), GLH_BLOCK_MEMBER ( spotlight_block, diffuse_color ),
+            GLH_BLOCK_MEMBER ( spotlight_block, specular_color ), GLH_BLOCK_MEMBER ( spotlight_block, enabled ), GLH_BLOCK_MEMBER ( spotlight_block, shadow_mapping_enabled ),
+            GLH_BLOCK_MEMBER ( spotlight_block, shadow_trans ), GLH_BLOCK_MEMBER ( spotlight_block, shadow_bias ), GLH_BLOCK_MEMBER ( spotlight_block, shadow_depth_range_mult ),
+            GLH_BLOCK_MEMBER ( spotlight_block, pcf_samples ), GLH_BLOCK_MEMBER ( spotlight_block, pcf_radius ), GLH_BLOCK_MEMBER ( spotlight_block, pcf_rotation )
+        );
+    }
+};
+
+/* struct light_system_block
+ *
+ * the arrays of lights of a light system, laid out for light_system_struct
+ * only the first ..._size elements of each array are used
+ */
+struct glh::lighting::light_system_block
+{
+    int dirlights_size;
+    std::array<dirlight_block, GLH_LIGHTING_MAX_DIRLIGHTS> dirlights;
+    int pointlights_size;
+    std::array<pointlight_block, GLH_LIGHTING_MAX_POINTLIGHTS> pointlights;
+    int spotlights_size;
+    std::array<spotlight_block, GLH_LIGHTING_MAX_SPOTLIGHTS> spotlights;
+
+    /* the members of light_system_struct */
+    static auto block_members ()
+    {
+        return std::make_tuple
+        (
+            GLH_BLOCK_MEMBER ( light_system_block, dirlights_size ), GLH_BLOCK_MEMBER ( light_system_block, dirlights ),
+            GLH_BLOCK_MEMBER ( light_system_block, pointlights_size ), GLH_BLOCK_MEMBER ( light_system_block, pointlights ),
+            GLH_BLOCK_MEMBER ( light_system_block, spotlights_size ), GLH_BLOCK_MEMBER ( light_system_block, spotlights )
+        );
+    }
+};
+
+
+
 /* DIRLIGHT DEFINITION */
 
 /* class dirlight : light
@@ -286,6 +479,7 @@ public:
         , pcf_rotation { math::rotate ( math::identity<2> (), glh::math::pi ( 2.0 ) / _pcf_samples, 0, 1 ) }
         , shadow_camera { math::vec3 { 0.0 }, _direction, math::any_perpandicular ( _direction ), math::vec3 { 0.0 }, math::vec3 { 0.0 } }
         , shadow_camera_change { true }
+        , version { 0 }
     {}
 
     /* default zero-parameter constructor */
@@ -299,6 +493,7 @@ public:
         , enabled { other.enabled }, shadow_mapping_enabled { other.shadow_mapping_enabled }, shadow_bias { other.shadow_bias }
         , pcf_samples { other.pcf_samples }, pcf_radius { other.pcf_radius }, pcf_rotation { other.pcf_rotation }
         , shadow_camera { other.shadow_camera }, shadow_camera_change { other.shadow_camera_change }
+        , version { 0 }
     {}
 
     /* default move constructor */
@@ -312,6 +507,7 @@ public:
         ; enabled = other.enabled; shadow_mapping_enabled = other.shadow_mapping_enabled; shadow_bias = other.shadow_bias
         ; pcf_samples = other.pcf_samples; pcf_radius = other.pcf_radius; pcf_rotation = other.pcf_rotation
         ; shadow_camera = other.shadow_camera; shadow_camera_change = other.shadow_camera_change
+        ; ++version
     ; return * this; }
 
     /* default move assignment operator */
@@ -339,6 +535,19 @@ public:
      * light_uni: the uniform to cache
      */
     void cache_uniforms ( core::struct_uniform& light_uni );
+
+    /* get_block
+     *
+     * get the attributes of the light, ready to be laid out in a block
+     */
+    dirlight_block get_block () const;
+
+    /* get_version
+     *
+     * get the version of the light, which is incremented whenever an attribute changes
+     * apply only sets the uniforms if the version has changed since they were last applied to
+     */
+    unsigned get_version () const { return version; }
     
 
 
@@ -347,34 +556,34 @@ public:
      * get/set the direction of the light
      */
     const math::vec3& get_direction () const { return direction; }
-    void set_direction ( const math::vec3& _direction ) { direction = _direction; shadow_camera_change = true; }
+    void set_direction ( const math::vec3& _direction ) { ++version; direction = _direction; shadow_camera_change = true; }
 
     /* set/get_ambient/diffuse/specular_color
      *
      * get/set the colors of the light
      */
     const math::vec3& get_ambient_color () const { return ambient_color; }
-    void set_ambient_color ( const math::vec3& _ambient_color ) { ambient_color = _ambient_color; }
+    void set_ambient_color ( const math::vec3& _ambient_color ) { ++version; ambient_color = _ambient_color; }
     const math::vec3& get_diffuse_color () const { return diffuse_color; }
-    void set_diffuse_color ( const math::vec3& _diffuse_color ) { diffuse_color = _diffuse_color; }
+    void set_diffuse_color ( const math::vec3& _diffuse_color ) { ++version; diffuse_color = _diffuse_color; }
     const math::vec3& get_specular_color () const { return ambient_color; }
-    void set_specular_color ( const math::vec3& _specular_color ) { specular_color = _specular_color; }
+    void set_specular_color ( const math::vec3& _specular_color ) { ++version; specular_color = _specular_color; }
     void set_color ( const math::vec3& _ambient_color, const math::vec3& _diffuse_color, const math::vec3& _specular_color )
-    { ambient_color = _ambient_color; diffuse_color = _diffuse_color; specular_color = _specular_color; }
+    { ++version; ambient_color = _ambient_color; diffuse_color = _diffuse_color; specular_color = _specular_color; }
 
     /* get/set_shadow_region
      *
      * get/set the region the light should cast shadows over
      */
     const region::spherical_region<>& get_shadow_region () const { return shadow_region; }
-    void set_shadow_region ( const region::spherical_region<>& _shadow_region ) { shadow_region = _shadow_region; shadow_camera_change = true; }
+    void set_shadow_region ( const region::spherical_region<>& _shadow_region ) { ++version; shadow_region = _shadow_region; shadow_camera_change = true; }
 
     /* enable/disable/is_enabled
      *
      * enable/disable the light or get whether is enabled
      */
-    void enable () { enabled = true; }
-    void disable () { enabled = false; }
+    void enable () { ++version; enabled = true; }
+    void disable () { ++version; enabled = false; }
     bool is_enabled () const { return enabled; }
 
     /* enable/disable_shadow_mapping
@@ -382,8 +591,8 @@ public:
      * 
      * enable/disable shadow mapping or get whether shadow mapping is enabled
      */
-    void enable_shadow_mapping () { shadow_mapping_enabled = true; }
-    void disable_shadow_mapping () { shadow_mapping_enabled = false; }
+    void enable_shadow_mapping () { ++version; shadow_mapping_enabled = true; }
+    void disable_shadow_mapping () { ++version; shadow_mapping_enabled = false; }
     bool is_shadow_mapping_enabled () const { return shadow_mapping_enabled; }
 
     /* get/set_shadow_bias
@@ -391,7 +600,7 @@ public:
      * get/set the shadow bias
      */
     const double& get_shadow_bias () const { return shadow_bias; }
-    void set_shadow_bias ( const double _shadow_bias ) { shadow_bias = _shadow_bias; }
+    void set_shadow_bias ( const double _shadow_bias ) { ++version; shadow_bias = _shadow_bias; }
 
     /* get/set_pcf_samples/radius
      *
@@ -399,9 +608,9 @@ public:
      */
     const unsigned& get_pcf_samples () const { return pcf_samples; }
     void set_pcf_samples ( const unsigned _pcf_samples ) 
-        { pcf_samples = _pcf_samples; pcf_rotation = math::rotate ( math::identity<2> (), glh::math::pi ( 2.0 ) / _pcf_samples, 0, 1 ); }
+        { ++version; pcf_samples = _pcf_samples; pcf_rotation = math::rotate ( math::identity<2> (), glh::math::pi ( 2.0 ) / _pcf_samples, 0, 1 ); }
     const double& get_pcf_radius () const { return pcf_radius; }
-    void set_pcf_radius ( const double _pcf_radius ) { pcf_radius = _pcf_radius; }
+    void set_pcf_radius ( const double _pcf_radius ) { ++version; pcf_radius = _pcf_radius; }
 
 
 
@@ -447,6 +656,9 @@ private:
         core::uniform& pcf_samples_uni;
         core::uniform& pcf_radius_uni;
         core::uniform& pcf_rotation_uni;
+
+        /* the version of the light last applied to the uniforms */
+        unsigned applied_version;
     };
 
     /* cached uniforms */
@@ -461,6 +673,17 @@ private:
     /* true if the shadow camera must be updated */
     mutable bool shadow_camera_change;
 
+    /* the version of the light, incremented whenever an attribute changes */
+    unsigned version;
+
+
+
+    /* update_shadow_camera
+     *
+     * update the shadow camera, if shadow mapping is enabled and it has changed
+     */
+    void update_shadow_camera () const;
+
 };
 
 
@@ -491,6 +714,7 @@ public:
         , pcf_samples { _pcf_samples }, pcf_radius { _pcf_radius }
         , pcf_rotation { math::rotate ( math::identity<2> (), glh::math::pi ( 2.0 ) / _pcf_samples, 0, 1 ) }
         , shadow_region { _shadow_region }
+        , version { 0 }
     {}
 
     /* default zero-parameter constructor */
@@ -504,6 +728,7 @@ public:
         , shadow_region { other.shadow_region }
         , enabled { other.enabled }, shadow_mapping_enabled { other.shadow_mapping_enabled }, shadow_bias { other.shadow_bias }
         , pcf_samples { other.pcf_samples }, pcf_radius { other.pcf_radius }, pcf_rotation { other.pcf_rotation }
+        , version { 0 }
     {}
 
     /* default move constructor */
@@ -516,6 +741,7 @@ public:
         ; ambient_color = other.ambient_color; diffuse_color = other.diffuse_color; specular_color = other.specular_color
         ; shadow_region = other.shadow_region
         ; enabled = other.enabled; shadow_mapping_enabled = other.shadow_mapping_enabled; shadow_bias = other.shadow_bias
+        ; ++version
     ; return * this; }
 
     /* default move assignment operator */
@@ -543,6 +769,19 @@ public:
      * light_uni: the uniform to cache
      */
     void cache_uniforms ( core::struct_uniform& light_uni );
+
+    /* get_block
+     *
+     * get the attributes of the light, ready to be laid out in a block
+     */
+    pointlight_block get_block () const;
+
+    /* get_version
+     *
+     * get the version of the light, which is incremented whenever an attribute changes
+     * apply only sets the uniforms if the version has changed since they were last applied to
+     */
+    unsigned get_version () const { return version; }
     
 
 
@@ -551,46 +790,46 @@ public:
      * get/set the position of the light
      */
     const math::vec3& get_position () const { return position; }
-    void set_position ( const math::vec3& _position ) { position = _position; }
+    void set_position ( const math::vec3& _position ) { ++version; position = _position; }
 
     /* get/set_att_const/linear/quad
      *
      * get/set the attenuation coefficients
      */
     const double& get_att_const () const { return att_const; }
-    void set_att_const ( const double _att_const ) { att_const = _att_const; }
+    void set_att_const ( const double _att_const ) { ++version; att_const = _att_const; }
     const double& get_att_linear () const { return att_linear; }
-    void set_att_linear ( const double _att_linear ) { att_linear = _att_linear; } 
+    void set_att_linear ( const double _att_linear ) { ++version; att_linear = _att_linear; } 
     const double& get_att_quad () const { return att_quad; }
-    void set_att_quad ( const double _att_quad ) { att_quad = _att_quad; }
-    void set_att ( const double _att_const, const double _att_linear, const double _att_quad ) { att_const = _att_const; att_linear = _att_linear; att_quad = _att_quad; }
+    void set_att_quad ( const double _att_quad ) { ++version; att_quad = _att_quad; }
+    void set_att ( const double _att_const, const double _att_linear, const double _att_quad ) { ++version; att_const = _att_const; att_linear = _att_linear; att_quad = _att_quad; }
 
     /* set/get_ambient/diffuse/specular_color
      *
      * get/set the colors of the light
      */
     const math::vec3& get_ambient_color () const { return ambient_color; }
-    void set_ambient_color ( const math::vec3& _ambient_color ) { ambient_color = _ambient_color; }
+    void set_ambient_color ( const math::vec3& _ambient_color ) { ++version; ambient_color = _ambient_color; }
     const math::vec3& get_diffuse_color () const { return diffuse_color; }
-    void set_diffuse_color ( const math::vec3& _diffuse_color ) { diffuse_color = _diffuse_color; }
+    void set_diffuse_color ( const math::vec3& _diffuse_color ) { ++version; diffuse_color = _diffuse_color; }
     const math::vec3& get_specular_color () const { return ambient_color; }
-    void set_specular_color ( const math::vec3& _specular_color ) { specular_color = _specular_color; }
+    void set_specular_color ( const math::vec3& _specular_color ) { ++version; specular_color = _specular_color; }
     void set_color ( const math::vec3& _ambient_color, const math::vec3& _diffuse_color, const math::vec3& _specular_color )
-    { ambient_color = _ambient_color; diffuse_color = _diffuse_color; specular_color = _specular_color; }
+    { ++version; ambient_color = _ambient_color; diffuse_color = _diffuse_color; specular_color = _specular_color; }
 
     /* get/set_shadow_region
      *
      * get/set the region the light should cast shadows over
      */
     const region::spherical_region<>& get_shadow_region () const { return shadow_region; }
-    void set_shadow_region ( const region::spherical_region<>& _shadow_region ) { shadow_region = _shadow_region; }
+    void set_shadow_region ( const region::spherical_region<>& _shadow_region ) { ++version; shadow_region = _shadow_region; }
 
     /* enable/disable/is_enabled
      *
      * enable/disable the light or get whether is enabled
      */
-    void enable () { enabled = true; }
-    void disable () { enabled = false; }
+    void enable () { ++version; enabled = true; }
+    void disable () { ++version; enabled = false; }
     bool is_enabled () const { return enabled; }
 
     /* enable/disable_shadow_mapping
@@ -598,8 +837,8 @@ public:
      * 
      * enable/disable shadow mapping or get whether shadow mapping is enabled
      */
-    void enable_shadow_mapping () { shadow_mapping_enabled = true; }
-    void disable_shadow_mapping () { shadow_mapping_enabled = false; }
+    void enable_shadow_mapping () { ++version; shadow_mapping_enabled = true; }
+    void disable_shadow_mapping () { ++version; shadow_mapping_enabled = false; }
     bool is_shadow_mapping_enabled () const { return shadow_mapping_enabled; }
 
     /* get/set_shadow_bias
@@ -607,7 +846,7 @@ public:
      * get/set the shadow bias
      */
     const double& get_shadow_bias () const { return shadow_bias; }
-    void set_shadow_bias ( const double _shadow_bias ) { shadow_bias = _shadow_bias; }
+    void set_shadow_bias ( const double _shadow_bias ) { ++version; shadow_bias = _shadow_bias; }
 
     /* get/set_pcf_samples/radius
      *
@@ -615,9 +854,9 @@ public:
      */
     const unsigned& get_pcf_samples () const { return pcf_samples; }
     void set_pcf_samples ( const unsigned _pcf_samples ) 
-        { pcf_samples = _pcf_samples; pcf_rotation = math::rotate ( math::identity<2> (), glh::math::pi ( 2.0 ) / _pcf_samples, 0, 1 ); }
+        { ++version; pcf_samples = _pcf_samples; pcf_rotation = math::rotate ( math::identity<2> (), glh::math::pi ( 2.0 ) / _pcf_samples, 0, 1 ); }
     const double& get_pcf_radius () const { return pcf_radius; }
-    void set_pcf_radius ( const double _pcf_radius ) { pcf_radius = _pcf_radius; }
+    void set_pcf_radius ( const double _pcf_radius ) { ++version; pcf_radius = _pcf_radius; }
 
 
 
@@ -670,6 +909,9 @@ private:
         core::uniform& pcf_samples_uni;
         core::uniform& pcf_radius_uni;
         core::uniform& pcf_rotation_uni;
+
+        /* the version of the light last applied to the uniforms */
+        unsigned applied_version;
     };
 
     /* cached uniforms */
@@ -678,6 +920,9 @@ private:
     /* the last shadow region used */
     region::spherical_region<> shadow_region;
 
+    /* the version of the light, incremented whenever an attribute changes */
+    unsigned version;
+
 };
 
 
@@ -711,6 +956,7 @@ public:
         , shadow_camera { _position, _direction, math::any_perpandicular ( _direction ), _outer_cone, 1.0, 0.1, 0.1 }
         , shadow_region { _shadow_region }
         , shadow_camera_change { true }
+        , version { 0 }
     {}
 
     /* default zero-parameter constructor */
@@ -725,6 +971,7 @@ public:
         , enabled { other.enabled }, shadow_mapping_enabled { other.shadow_mapping_enabled }, shadow_bias { other.shadow_bias }
         , pcf_samples { other.pcf_samples }, pcf_radius { other.pcf_radius }, pcf_rotation { other.pcf_rotation }
         , shadow_camera { other.shadow_camera }, shadow_camera_change { other.shadow_camera_change }
+        , version { 0 }
     {}
 
     /* default move constructor */
@@ -739,6 +986,7 @@ public:
         ; enabled = other.enabled; shadow_mapping_enabled = other.shadow_mapping_enabled; shadow_bias = other.shadow_bias
         ; pcf_samples = other.pcf_samples; pcf_radius = other.pcf_radius; pcf_rotation = other.pcf_rotation
         ; shadow_camera = other.shadow_camera; shadow_camera_change = other.shadow_camera_change
+        ; ++version
     ; return * this; }
 
     /* default move assignment operator */
@@ -766,6 +1014,19 @@ public:
      * light_uni: the uniform to cache
      */
     void cache_uniforms ( core::struct_uniform& light_uni );
+
+    /* get_block
+     *
+     * get the attributes of the light, ready to be laid out in a block
+     */
+    spotlight_block get_block () const;
+
+    /* get_version
+     *
+     * get the version of the light, which is incremented whenever an attribute changes
+     * apply only sets the uniforms if the version has changed since they were last applied to
+     */
+    unsigned get_version () const { return version; }
     
 
 
@@ -775,58 +1036,58 @@ public:
      * get/set the position and direction of the light
      */
     const math::vec3& get_position () const { return position; }
-    void set_position ( const math::vec3& _position ) { position = _position; shadow_camera_change = true; }
+    void set_position ( const math::vec3& _position ) { ++version; position = _position; shadow_camera_change = true; }
     const math::vec3& get_direction () const { return direction; }
-    void set_direction ( const math::vec3& _direction ) { direction = _direction; shadow_camera_change = true; }
+    void set_direction ( const math::vec3& _direction ) { ++version; direction = _direction; shadow_camera_change = true; }
 
     /* get/set_inner/outer_cone
      *
      * get/set the inner and outer cone of the spotlight
      */
     const double& get_inner_cone () const { return inner_cone; }
-    void set_inner_cone ( const double _inner_cone ) { inner_cone = _inner_cone; shadow_camera_change = true; }
+    void set_inner_cone ( const double _inner_cone ) { ++version; inner_cone = _inner_cone; shadow_camera_change = true; }
     const double& get_outer_cone () const { return outer_cone; }
-    void set_outer_cone ( const double _outer_cone ) { outer_cone = _outer_cone; shadow_camera_change = true; }
-    void set_cone ( const double _inner_cone, const double _outer_cone ) { inner_cone = _inner_cone; outer_cone = _outer_cone; shadow_camera_change = true; }
+    void set_outer_cone ( const double _outer_cone ) { ++version; outer_cone = _outer_cone; shadow_camera_change = true; }
+    void set_cone ( const double _inner_cone, const double _outer_cone ) { ++version; inner_cone = _inner_cone; outer_cone = _outer_cone; shadow_camera_change = true; }
 
     /* get/set_att_const/linear/quad
      *
      * get/set the attenuation coefficients
      */
     const double& get_att_const () const { return att_const; }
-    void set_att_const ( const double _att_const ) { att_const = _att_const; }
+    void set_att_const ( const double _att_const ) { ++version; att_const = _att_const; }
     const double& get_att_linear () const { return att_linear; }
-    void set_att_linear ( const double _att_linear ) { att_linear = _att_linear; } 
+    void set_att_linear ( const double _att_linear ) { ++version; att_linear = _att_linear; } 
     const double& get_att_quad () const { return att_quad; }
-    void set_att_quad ( const double _att_quad ) { att_quad = _att_quad; }
-    void set_att ( const double _att_const, const double _att_linear, const double _att_quad ) { att_const = _att_const; att_linear = _att_linear; att_quad = _att_quad; }
+    void set_att_quad ( const double _att_quad ) { ++version; att_quad = _att_quad; }
+    void set_att ( const double _att_const, const double _att_linear, const double _att_quad ) { ++version; att_const = _att_const; att_linear = _att_linear; att_quad = _att_quad; }
 
     /* set/get_ambient/diffuse/specular_color
      *
      * get/set the colors of the light
      */
     const math::vec3& get_ambient_color () const { return ambient_color; }
-    void set_ambient_color ( const math::vec3& _ambient_color ) { ambient_color = _ambient_color; }
+    void set_ambient_color ( const math::vec3& _ambient_color ) { ++version; ambient_color = _ambient_color; }
     const math::vec3& get_diffuse_color () const { return diffuse_color; }
-    void set_diffuse_color ( const math::vec3& _diffuse_color ) { diffuse_color = _diffuse_color; }
+    void set_diffuse_color ( const math::vec3& _diffuse_color ) { ++version; diffuse_color = _diffuse_color; }
     const math::vec3& get_specular_color () const { return ambient_color; }
-    void set_specular_color ( const math::vec3& _specular_color ) { specular_color = _specular_color; }
+    void set_specular_color ( const math::vec3& _specular_color ) { ++version; specular_color = _specular_color; }
     void set_color ( const math::vec3& _ambient_color, const math::vec3& _diffuse_color, const math::vec3& _specular_color )
-    { ambient_color = _ambient_color; diffuse_color = _diffuse_color; specular_color = _specular_color; }
+    { ++version; ambient_color = _ambient_color; diffuse_color = _diffuse_color; specular_color = _specular_color; }
 
     /* get/set_shadow_region
      *
      * get/set the region the light should cast shadows over
      */
     const region::spherical_region<>& get_shadow_region () const { return shadow_region; }
-    void set_shadow_region ( const region::spherical_region<>& _shadow_region ) { shadow_region = _shadow_region; shadow_camera_change = true; }
+    void set_shadow_region ( const region::spherical_region<>& _shadow_region ) { ++version; shadow_region = _shadow_region; shadow_camera_change = true; }
 
     /* enable/disable/is_enabled
      *
      * enable/disable the light or get whether is enabled
      */
-    void enable () { enabled = true; }
-    void disable () { enabled = false; }
+    void enable () { ++version; enabled = true; }
+    void disable () { ++version; enabled = false; }
     bool is_enabled () const { return enabled; }
 
     /* enable/disable_shadow_mapping
@@ -834,8 +1095,8 @@ public:
      * 
      * enable/disable shadow mapping or get whether shadow mapping is enabled
      */
-    void enable_shadow_mapping () { shadow_mapping_enabled = true; }
-    void disable_shadow_mapping () { shadow_mapping_enabled = false; }
+    void enable_shadow_mapping () { ++version; shadow_mapping_enabled = true; }
+    void disable_shadow_mapping () { ++version; shadow_mapping_enabled = false; }
     bool is_shadow_mapping_enabled () const { return shadow_mapping_enabled; }
 
     /* get/set_shadow_bias
@@ -843,7 +1104,7 @@ public:
      * get/set the shadow bias
      */
     const double& get_shadow_bias () const { return shadow_bias; }
-    void set_shadow_bias ( const double _shadow_bias ) { shadow_bias = _shadow_bias; }
+    void set_shadow_bias ( const double _shadow_bias ) { ++version; shadow_bias = _shadow_bias; }
 
     /* get/set_pcf_samples/radius
      *
@@ -851,9 +1112,9 @@ public:
      */
     const unsigned& get_pcf_samples () const { return pcf_samples; }
     void set_pcf_samples ( const unsigned _pcf_samples ) 
-        { pcf_samples = _pcf_samples; pcf_rotation = math::rotate ( math::identity<2> (), glh::math::pi ( 2.0 ) / _pcf_samples, 0, 1 ); }
+        { ++version; pcf_samples = _pcf_samples; pcf_rotation = math::rotate ( math::identity<2> (), glh::math::pi ( 2.0 ) / _pcf_samples, 0, 1 ); }
     const double& get_pcf_radius () const { return pcf_radius; }
-    void set_pcf_radius ( const double _pcf_radius ) { pcf_radius = _pcf_radius; }
+    void set_pcf_radius ( const double _pcf_radius ) { ++version; pcf_radius = _pcf_radius; }
 
 
 
@@ -917,6 +1178,9 @@ private:
         core::uniform& pcf_samples_uni;
         core::uniform& pcf_radius_uni;
         core::uniform& pcf_rotation_uni;
+
+        /* the version of the light last applied to the uniforms */
+        unsigned applied_version;
     };
 
     /* cached uniforms */
@@ -931,6 +1195,17 @@ private:
     /* true if the shadow camera must be updated */
     mutable bool shadow_camera_change; 
 
+    /* the version of the light, incremented whenever an attribute changes */
+    unsigned version;
+
+
+
+    /* update_shadow_camera
+     *
+     * update the shadow camera, if it has changed
+     */
+    void update_shadow_camera () const;
+
 };
 
 
@@ -965,6 +1240,26 @@ public:
 
 
 
+    /* get_shader_defines
+     *
+     * get the #define directives for the maximum number of each type of light, to add to shaders which include shaders/lighting.glsl
+     */
+    static std::string get_shader_defines ();
+
+    /* get_permutation_features
+     *
+     * get the program permutation features of a light system: NUM_DIRLIGHTS/POINTLIGHTS/SPOTLIGHTS and the NO_SHADOWS flag
+     */
+    static std::vector<core::permutation_feature> get_permutation_features ();
+
+    /* get_permutation_values
+     *
+     * get the values of the features from get_permutation_features for this light system
+     */
+    std::vector<unsigned> get_permutation_values () const;
+
+
+
     /* add_...light
      *
      * add a light to the system
@@ -1034,14 +1329,40 @@ public:
     void apply ( core::struct_uniform& light_system_uni );
     void apply () const;
 
+    /* apply to a ubo
+     *
+     * upload all of the lights to a ubo in one write, laid out as a std140 light_system_struct
+     * the ubo should be bound to the binding of a light_system_block uniform block, so one upload serves every program
+     * 
+     * light_system_ubo: the ubo to upload to
+     */
+    void apply ( core::ubo& light_system_ubo ) const;
+
+    /* apply_shadow_maps
+     *
+     * bind the shadow maps and set a sampler uniform to them
+     * this is needed by each program which samples the shadow maps, as they are not part of the block
+     * 
+     * shadow_maps_uni: the sampler uniform for the shadow maps (e.g. light_system_shadow_maps)
+     */
+    void apply_shadow_maps ( core::uniform& shadow_maps_uni ) const;
+
     /* cache_uniforms
      *
      * cache uniforms for later use
+     * the shadow maps uniform is found by appending _shadow_maps to the name of the light system uniform
      * 
      * light_system_uni: the uniform to cache
      */
     void cache_uniforms ( core::struct_uniform& light_system_uni );
 
+    /* get_block
+     *
+     * get the attributes of every light, ready to be laid out in a block
+     * throws if there are more lights of a type than the block can hold
+     */
+    light_system_block get_block () const;
+
     /* recache_uniforms
      *
      * recache the light collections based on the currently cached uniforms
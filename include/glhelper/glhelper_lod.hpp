@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * include/glhelper/glhelper_lod.hpp
+ *
+ * constructs for generating and selecting levels of detail of triangle meshes
+ * all of the functions here are CPU only, and so can be used without an OpenGL context
+ * notable constructs include:
+ *
+ *
+ *
+ * STRUCT GLH::LOD::QUADRIC
+ *
+ * a symmetric 4x4 matrix representing the sum of squared distances to a set of planes
+ * used by simplify to measure how far a vertex has moved from the surface it originally lay on
+ *
+ *
+ *
+ * STRUCT GLH::LOD::SIMPLIFICATION_REPORT
+ *
+ * the result of a simplification, giving the reduction in triangles and the quality of the result
+ * the error is the greatest distance (in the units of the positions) of any collapsed vertex from the planes of the original triangles it represents
+ *
+ *
+ *
+ * FUNCTION GLH::LOD::SIMPLIFY
+ *
+ * quadric-error mesh simplification by half-edge collapse
+ * vertices are only ever moved onto other existing vertices, so the result is a new set of triangles indexing the same vertices
+ * this allows levels of detail to share a vertex buffer, only differing in their index data
+ * vertices on a border of the mesh (including texture and normal seams, where vertices are duplicated) are never moved
+ * collapses which would flip the orientation of a triangle are rejected
+ *
+ *
+ *
+ * FUNCTION GLH::LOD::GENERATE_LODS
+ *
+ * simplifies a mesh into successive levels, each targeting a fraction of the triangles of the level before
+ * every level is simplified from the full detail, so the error of each level is never less than the error of the level before
+ *
+ *
+ *
+ * FUNCTIONS GLH::LOD::PROJECTED_SIZE AND GLH::LOD::SELECT_LOD
+ *
+ * projected_size gives the radius of a region as a fraction of half the height of the screen, as seen by a perspective camera
+ * select_lod then picks a level of detail for that size:
+ * sizes at least as large as the threshold use the full detail, and each level of detail after covers half of the size of the previous
+ *
+ */
+
+
+
+/* HEADER GUARD */
+#ifndef GLHELPER_LOD_HPP_INCLUDED
+#define GLHELPER_LOD_HPP_INCLUDED
+
+
+
+/* INCLUDES */
+
+/* include core headers */
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+/* include glhelper_core.hpp */
+#include <glhelper/glhelper_core.hpp>
+
+/* include glhelper_vector.hpp */
+#include <glhelper/glhelper_vector.hpp>
+
+/* include glhelper_transform.hpp */
+#include <glhelper/glhelper_transform.hpp>
+
+/* include glhelper_region.hpp */
+#include <glhelper/glhelper_region.hpp>
+
+
+
+/* NAMESPACE DECLARATIONS */
+
+namespace glh
+{
+    namespace lod
+    {
+        /* struct quadric
+         *
+         * a symmetric 4x4 error quadric
+         */
+        struct quadric;
+
+        /* struct simplification_report
+         *
+         * the reduction and quality of a simplification
+         */
+        struct simplification_report;
+
+        /* typedef triangle
+         *
+         * three indices into a set of vertex positions
+         */
+        using triangle = std::array<unsigned, 3>;
+
+
+
+        /* simplify
+         *
+         * simplify a triangle mesh by collapsing edges until a target number of triangles or an error limit is reached
+         *
+         * positions: the positions of the vertices
+         * triangles: the triangles to simplify
+         * target_triangles: the number of triangles to stop at
+         * max_error: the greatest error a collapse may introduce (in the units of the positions)
+         * report: if not NULL, filled in with the reduction and quality of the simplification
+         *
+         * return: the simplified triangles, which index the same positions
+         */
+        std::vector<triangle> simplify ( const std::vector<math::fvec3>& positions, const std::vector<triangle>& triangles, const unsigned target_triangles, const double max_error, simplification_report * report = NULL );
+
+        /* generate_lods
+         *
+         * generate successive levels of detail of a triangle mesh
+         * each level is simplified from the full detail, so that errors do not accumulate, and targets triangle_ratio of the triangles of the level before
+         * generation stops once a level fails to remove at least a quarter of the triangles of the level before, as further levels would not be worthwhile
+         *
+         * positions: the positions of the vertices
+         * triangles: the triangles of the full detail
+         * max_levels: the greatest number of levels to generate
+         * triangle_ratio: the fraction of the triangles of the previous level each level targets
+         * max_error: the greatest error a collapse may introduce (in the units of the positions)
+         * reports: if not NULL, filled in with the report of each level generated
+         *
+         * return: the triangles of each level generated, from the finest to the coarsest
+         */
+        std::vector<std::vector<triangle>> generate_lods ( const std::vector<math::fvec3>& positions, const std::vector<triangle>& triangles, const unsigned max_levels, const double triangle_ratio, const double max_error, std::vector<simplification_report> * reports = NULL );
+
+        /* projected_size
+         *
+         * get the radius of a region as a fraction of half the height of the screen
+         * if the viewer is inside of the region, infinity is returned
+         *
+         * _region: the region to project
+         * viewpos: the position of the viewer
+         * fov: the vertical field of view of the viewer
+         */
+        double projected_size ( const region::spherical_region<>& _region, const math::vec3& viewpos, const double fov );
+
+        /* select_lod
+         *
+         * select a level of detail from a projected size
+         * 0 is the full detail, and each level up to num_lods is used for half the size of the level before
+         *
+         * size: the projected size of the region being rendered
+         * threshold: the smallest projected size which is rendered at full detail
+         * num_lods: the number of levels of detail available, not including the full detail
+         */
+        unsigned select_lod ( const double size, const double threshold, const unsigned num_lods );
+    }
+}
+
+
+
+/* QUADRIC DEFINITION */
+
+/* struct quadric
+ *
+ * a symmetric 4x4 error quadric
+ */
+struct glh::lod::quadric
+{
+    /* the upper triangle of the matrix, in row order */
+    std::array<double, 10> q;
+
+    /* default constructor
+     *
+     * a quadric with no error anywhere
+     */
+    quadric () { q.fill ( 0.0 ); }
+
+    /* plane constructor
+     *
+     * the quadric of the squared distance to a plane ax + by + cz + d = 0, where (a, b, c) is normalised
+     */
+    quadric ( const double a, const double b, const double c, const double d )
+        : q { a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d }
+    {}
+
+    /* operator+=
+     *
+     * add another quadric to this one
+     */
+    quadric& operator+= ( const quadric& other ) { for ( unsigned i = 0; i < 10; ++i ) q.at ( i ) += other.q.at ( i ); return * this; }
+
+    /* evaluate
+     *
+     * get the error of a position
+     */
+    double evaluate ( const math::fvec3& p ) const
+    {
+        const double x = p.at ( 0 ), y = p.at ( 1 ), z = p.at ( 2 );
+        return q.at ( 0 ) * x * x + 2.0 * q.at ( 1 ) * x * y + 2.0 * q.at ( 2 ) * x * z + 2.0 * q.at ( 3 ) * x
+             + q.at ( 4 ) * y * y + 2.0 * q.at ( 5 ) * y * z + 2.0 * q.at ( 6 ) * y
+             + q.at ( 7 ) * z * z + 2.0 * q.at ( 8 ) * z
+             + q.at ( 9 );
+    }
+};
+
+
+
+/* SIMPLIFICATION_REPORT DEFINITION */
+
+/* struct simplification_report
+ *
+ * the reduction and quality of a simplification
+ */
+struct glh::lod::simplification_report
+{
+    /* the number of triangles before and after simplification */
+    unsigned source_triangles = 0;
+    unsigned result_triangles = 0;
+
+    /* the number of edge collapses performed */
+    unsigned num_collapses = 0;
+
+    /* the greatest error introduced by a collapse, which is the greatest distance of a remaining vertex from the original planes it represents (in the units of the positions) */
+    double max_error = 0.0;
+
+    /* triangle_reduction
+     *
+     * get the fraction of triangles removed by the simplification
+     */
+    double triangle_reduction () const { return ( source_triangles == 0 ? 0.0 : 1.0 - static_cast<double> ( result_triangles ) / source_triangles ); }
+};
+
+
+
+/* #ifndef GLHELPER_LOD_HPP_INCLUDED */
+#endif
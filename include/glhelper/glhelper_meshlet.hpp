@@ -0,0 +1,300 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * include/glhelper/glhelper_meshlet.hpp
+ *
+ * constructs for decomposing triangle meshes into small clusters of triangles (meshlets) and culling them
+ * building and culling meshlets is CPU only, and so can be used without an OpenGL context
+ * notable constructs include:
+ *
+ *
+ *
+ * STRUCT GLH::MESHLET::MESHLET
+ *
+ * a cluster of up to GLH_MESHLET_MAX_VERTICES vertices and GLH_MESHLET_MAX_TRIANGLES triangles
+ * each meshlet refers to a range of a meshlet vertex array, containing indices into the original vertices,
+ * and a range of a meshlet triangle array, where each triangle is three 8-bit indices into the meshlet's range of vertices, packed into an unsigned int
+ * each meshlet also stores a bounding sphere and a normal cone, which contains the normals of all of its triangles
+ * the layout of the struct matches meshlet_struct in shaders/meshlets.glsl, under std430 packing, so meshlets can be directly copied into an ssbo
+ *
+ *
+ *
+ * STRUCT GLH::MESHLET::MESHLET_FLAGS
+ *
+ * struct of static integers for meshlet flags, marking whether a meshlet should be rendered in opaque or transparent rendering modes
+ *
+ *
+ *
+ * STRUCT GLH::MESHLET::CULLING_STATISTICS
+ *
+ * the number of meshlets tested and culled by each type of test
+ *
+ *
+ *
+ * FUNCTION GLH::MESHLET::BUILD
+ *
+ * greedily group triangles into meshlets
+ * each meshlet grows by adding the triangle adjacent to it which adds the fewest new vertices, keeping meshlets spatially compact
+ *
+ *
+ *
+ * FUNCTIONS GLH::MESHLET::MESHLET_REGION AND GLH::MESHLET::IS_BACKFACING
+ *
+ * meshlet_region gives the bounding sphere of a meshlet as a region, for frustum and occlusion culling
+ * is_backfacing tests the normal cone of a meshlet against a viewing position, returning true if every triangle of the meshlet is definitely facing away
+ * the viewing position must be in the same space as the meshlet
+ *
+ *
+ *
+ * CLASS GLH::EXCEPTION::MESHLET_EXCEPTION
+ *
+ * thrown when an error occurs in one of the meshlet functions (e.g. requesting meshlets too large for 8-bit local indices)
+ *
+ */
+
+
+
+/* HEADER GUARD */
+#ifndef GLHELPER_MESHLET_HPP_INCLUDED
+#define GLHELPER_MESHLET_HPP_INCLUDED
+
+
+
+/* MACROS */
+
+/* GLH_MESHLET_MAX_VERTICES
+ *
+ * the default maximum number of vertices in a meshlet (no more than 256)
+ * defaults to 64
+ */
+#ifndef GLH_MESHLET_MAX_VERTICES
+    #define GLH_MESHLET_MAX_VERTICES 64
+#endif
+
+/* GLH_MESHLET_MAX_TRIANGLES
+ *
+ * the default maximum number of triangles in a meshlet
+ * defaults to 124
+ */
+#ifndef GLH_MESHLET_MAX_TRIANGLES
+    #define GLH_MESHLET_MAX_TRIANGLES 124
+#endif
+
+
+
+/* INCLUDES */
+
+/* include core headers */
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+/* include glhelper_core.hpp */
+#include <glhelper/glhelper_core.hpp>
+
+/* include glhelper_vector.hpp */
+#include <glhelper/glhelper_vector.hpp>
+
+/* include glhelper_transform.hpp */
+#include <glhelper/glhelper_transform.hpp>
+
+/* include glhelper_region.hpp */
+#include <glhelper/glhelper_region.hpp>
+
+/* include glhelper_lod.hpp */
+#include <glhelper/glhelper_lod.hpp>
+
+
+
+/* NAMESPACE DECLARATIONS */
+
+namespace glh
+{
+    namespace meshlet
+    {
+        /* struct meshlet
+         *
+         * a cluster of triangles with bounds
+         */
+        struct meshlet;
+
+        /* struct meshlet_flags
+         *
+         * meshlet flags
+         */
+        struct meshlet_flags;
+
+        /* struct culling_statistics
+         *
+         * the number of meshlets tested and culled
+         */
+        struct culling_statistics;
+
+
+
+        /* build
+         *
+         * group triangles into meshlets, appending them to existing arrays
+         * the vertex and triangle offsets of the new meshlets are relative to the start of the arrays
+         *
+         * positions: the positions of the vertices
+         * triangles: the triangles to group
+         * meshlets: the array to append the meshlets to
+         * meshlet_vertices: the array to append the vertex indices of each meshlet to
+         * meshlet_triangles: the array to append the packed local triangles of each meshlet to
+         * flags: the flags to give each meshlet (defaults to none)
+         * mesh_index: the mesh index to give each meshlet (defaults to 0)
+         * max_vertices: the maximum number of vertices per meshlet (defaults to GLH_MESHLET_MAX_VERTICES)
+         * max_triangles: the maximum number of triangles per meshlet (defaults to GLH_MESHLET_MAX_TRIANGLES)
+         *
+         * return: the number of meshlets added
+         */
+        unsigned build ( const std::vector<math::fvec3>& positions, const std::vector<lod::triangle>& triangles, std::vector<meshlet>& meshlets, std::vector<unsigned>& meshlet_vertices, std::vector<unsigned>& meshlet_triangles,
+            const unsigned flags = 0, const unsigned mesh_index = 0, const unsigned max_vertices = GLH_MESHLET_MAX_VERTICES, const unsigned max_triangles = GLH_MESHLET_MAX_TRIANGLES );
+
+        /* meshlet_region
+         *
+         * get the bounding sphere of a meshlet as a region
+         */
+        region::spherical_region<> meshlet_region ( const meshlet& _meshlet );
+
+        /* is_backfacing
+         *
+         * returns true if every triangle of the meshlet faces away from a viewing position
+         *
+         * _meshlet: the meshlet to test
+         * viewpos: the viewing position, in the same space as the meshlet
+         */
+        bool is_backfacing ( const meshlet& _meshlet, const math::vec3& viewpos );
+    }
+
+    namespace exception
+    {
+        /* class meshlet_exception : exception
+         *
+         * exception relating to meshlets
+         */
+        class meshlet_exception;
+    }
+}
+
+
+
+/* MESHLET DEFINITION */
+
+/* struct meshlet
+ *
+ * a cluster of triangles with bounds
+ */
+struct glh::meshlet::meshlet
+{
+    /* the centre and radius of the bounding sphere */
+    math::fvec3 centre;
+    float radius;
+
+    /* the axis of the normal cone, and the sine of its half-angle
+     * a cutoff of 1 means that the cone is too wide to ever cull the meshlet
+     */
+    math::fvec3 cone_axis;
+    float cone_cutoff;
+
+    /* the start and size of the ranges of the meshlet vertex and triangle arrays */
+    unsigned vertex_offset;
+    unsigned vertex_count;
+    unsigned triangle_offset;
+    unsigned triangle_count;
+
+    /* flags of the meshlet (see meshlet_flags) */
+    unsigned flags;
+
+    /* the index of the mesh the meshlet belongs to */
+    unsigned mesh_index;
+
+    /* padding to match std430 layout */
+    unsigned padding [ 2 ];
+};
+
+
+
+/* MESHLET_FLAGS DEFINITION */
+
+/* struct meshlet_flags
+ *
+ * meshlet flags
+ */
+struct glh::meshlet::meshlet_flags
+{
+    /* no flags */
+    static const unsigned GLH_NONE = 0x00;
+
+    /* the meshlet is rendered in opaque mode */
+    static const unsigned GLH_OPAQUE = 0x01;
+
+    /* the meshlet is rendered in transparent mode */
+    static const unsigned GLH_TRANSPARENT = 0x02;
+};
+
+
+
+/* CULLING_STATISTICS DEFINITION */
+
+/* struct culling_statistics
+ *
+ * the number of meshlets tested and culled
+ */
+struct glh::meshlet::culling_statistics
+{
+    /* the number of meshlets tested */
+    unsigned num_tested = 0;
+
+    /* the number of meshlets culled by each test */
+    unsigned num_frustum_culled = 0;
+    unsigned num_backface_culled = 0;
+    unsigned num_occlusion_culled = 0;
+
+    /* num_visible
+     *
+     * get the number of meshlets which survived culling
+     */
+    unsigned num_visible () const { return num_tested - num_frustum_culled - num_backface_culled - num_occlusion_culled; }
+};
+
+
+
+/* MESHLET_EXCEPTION DEFINITION */
+
+/* class meshlet_exception : exception
+ *
+ * exception relating to meshlets
+ */
+class glh::exception::meshlet_exception : public exception
+{
+public:
+
+    /* full constructor
+     *
+     * __what: description of the exception
+     */
+    explicit meshlet_exception ( const std::string& __what )
+        : exception { __what }
+    {}
+
+    /* default zero-parameter constructor
+     *
+     * construct meshlet_exception with no descrption
+     */
+    meshlet_exception () = default;
+
+    /* default everything else and inherits what () function */
+
+};
+
+
+
+/* #ifndef GLHELPER_MESHLET_HPP_INCLUDED */
+#endif
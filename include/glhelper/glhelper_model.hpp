@@ -42,6 +42,11 @@
  * the model matrix uniform is purely a mat4
  * the material struct uniform is explained below, and the format of vertex attributes under that
  * 
+ * models are also draw sources, so the meshes of a model can be recorded into a render queue with record instead of being rendered immediately
+ * recording only reads the model and makes no OpenGL calls, so the same model can be recorded from several threads at once into different queues
+ * if recording with GLH_OCCLUSION_CULLING, the depth pyramid must first be read back on the thread with the context (see glh::culling::depth_pyramid::readback)
+ * the uniforms cached in the model must belong to the program the model is recorded with
+ * 
  * for information about implementing logic in shaders, see pseudocode at the bottom of: 
  * http://assimp.sourceforge.net/lib_html/materials.html
  * 
@@ -125,8 +130,14 @@
  * 2 : vec3    : tangent
  * 3 : vec4    : vertex color
  * 4 : vec2[x] : UV channels of texture coordinates
+ * 4 + x : mat4 : instance matrix (the identity, except when rendering with render_instanced)
  * 
  * the number of UV channels is defined by GLH_MODEL_MAX_TEXTURE_STACK_SIZE
+ * the instance matrix occupies four consecutive attribute locations, one per column, and advances once per instance
+ * when rendering instanced, the final model matrix of each vertex is the instance matrix multiplied by the model matrix uniform
+ * the instance data is a persistently mapped ring buffer, which render_instanced writes the instance matrices of each call straight into without waiting on the driver
+ * the identity instance matrix is kept in the first slot of the instance data, which is never written to again, and instanced draws start from the slot their matrices were written to
+ * next_frame must be called once per frame to move the ring buffer on, and render_instanced can draw up to GLH_MODEL_MAX_FRAME_INSTANCES instances in total per frame
  * 
  * 
  * 
@@ -148,13 +159,49 @@
 
 /* GLH_MODEL_MAX_TEXTURE_STACK_SIZE
  *
- * the maximum size of a texture stack
+ * the maximum size of a texture stack, which is injected into shaders as MAX_TEXTURE_STACK_SIZE
  * defaults to 2
  */
 #ifndef GLH_MODEL_MAX_TEXTURE_STACK_SIZE
     #define GLH_MODEL_MAX_TEXTURE_STACK_SIZE 2
 #endif
 
+/* GLH_MODEL_MAX_LODS
+ *
+ * the maximum number of levels of detail generated for each mesh, not including the full detail
+ * defaults to 3
+ */
+#ifndef GLH_MODEL_MAX_LODS
+    #define GLH_MODEL_MAX_LODS 3
+#endif
+
+/* GLH_MODEL_LOD_TRIANGLE_RATIO
+ *
+ * the target number of triangles of each level of detail, as a fraction of the level before
+ * defaults to 0.5
+ */
+#ifndef GLH_MODEL_LOD_TRIANGLE_RATIO
+    #define GLH_MODEL_LOD_TRIANGLE_RATIO 0.5
+#endif
+
+/* GLH_MODEL_LOD_MAX_RELATIVE_ERROR
+ *
+ * the greatest error a level of detail may introduce, as a fraction of the size of the bounding box of the mesh
+ * defaults to 0.02
+ */
+#ifndef GLH_MODEL_LOD_MAX_RELATIVE_ERROR
+    #define GLH_MODEL_LOD_MAX_RELATIVE_ERROR 0.02
+#endif
+
+/* GLH_MODEL_MAX_FRAME_INSTANCES
+ *
+ * the greatest number of instances which render_instanced can draw in one frame, summed over every call between calls to next_frame
+ * defaults to 1024
+ */
+#ifndef GLH_MODEL_MAX_FRAME_INSTANCES
+    #define GLH_MODEL_MAX_FRAME_INSTANCES 1024
+#endif
+
 
 
 /* INCLUDES */
@@ -162,6 +209,7 @@
 /* include core headers */
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <cmath>
 #include <iostream>
 #include <memory>
@@ -189,6 +237,9 @@
 /* include glhelper_render.hpp */
 #include <glhelper/glhelper_render.hpp>
 
+/* include glhelper_render_queue.hpp */
+#include <glhelper/glhelper_render_queue.hpp>
+
 /* include glhelper_vector.hpp */
 #include <glhelper/glhelper_vector.hpp>
 
@@ -207,6 +258,24 @@
 /* include glhelper_vertices.hpp */
 #include <glhelper/glhelper_vertices.hpp>
 
+/* include glhelper_culling.hpp */
+#include <glhelper/glhelper_culling.hpp>
+
+/* include glhelper_camera.hpp */
+#include <glhelper/glhelper_camera.hpp>
+
+/* include glhelper_lod.hpp */
+#include <glhelper/glhelper_lod.hpp>
+
+/* include glhelper_thread.hpp */
+#include <glhelper/glhelper_thread.hpp>
+
+/* include glhelper_meshlet.hpp */
+#include <glhelper/glhelper_meshlet.hpp>
+
+/* include glhelper_alpha_test.hpp */
+#include <glhelper/glhelper_alpha_test.hpp>
+
 
 
 /* NAMESPACE DECLARATIONS */
@@ -247,6 +316,12 @@ namespace glh
          */
         struct face;
 
+        /* struct mesh_lod
+         *
+         * a level of detail of a mesh
+         */
+        struct mesh_lod;
+
         /* struct mesh
          *
          * a mesh of a model
@@ -448,6 +523,31 @@ struct glh::model::face
 
 
 
+/* MESH_LOD DEFINITION */
+
+/* struct mesh_lod
+ *
+ * a level of detail of a mesh
+ * the faces index the same vertices as the full detail mesh
+ */
+struct glh::model::mesh_lod
+{
+    /* the number of faces in the level of detail */
+    unsigned num_faces;
+
+    /* the index that the index data for the faces start in the ebo and the global ebo */
+    unsigned start_of_faces;
+    unsigned global_start_of_faces;
+
+    /* the faces of the level of detail */
+    std::vector<face> faces;
+
+    /* the reduction and quality of the simplification which produced the level of detail */
+    lod::simplification_report report;
+};
+
+
+
 /* MESH DEFINITION */
 
 /* struct mesh
@@ -490,6 +590,19 @@ struct glh::model::mesh
     std::vector<face> faces;
     std::vector<face> opaque_faces;
     std::vector<face> transparent_faces;
+
+    /* the levels of detail of the mesh, from the most to least detailed, not including the full detail */
+    std::vector<mesh_lod> lods;
+
+    /* the meshlets of the mesh, and their vertex and triangle data
+     * the offsets of the meshlets and the vertex indices are local to the mesh
+     */
+    std::vector<meshlet::meshlet> meshlets;
+    std::vector<unsigned> meshlet_vertices;
+    std::vector<unsigned> meshlet_triangles;
+
+    /* the index of the first meshlet of the mesh in the global meshlet data */
+    unsigned global_start_of_meshlets;
     
 
 
@@ -630,6 +743,8 @@ struct glh::model::import_flags
      * the first will be be the index data for all the faces,
      * the second will will contain opaque faces and the third transparent
      * this changes how the opaque and transparent rendering modes function
+     * the faces of every mesh are classified by a compute program, with a dispatch per material and a single fence for the whole model
+     * the alpha test program is taken from the program registry, so is shared by every model imported with this flag
      */
     static const unsigned GLH_SPLIT_MESHES_BY_ALPHA_VALUES = 0x0400;
 
@@ -647,6 +762,33 @@ struct glh::model::import_flags
      * rather than storing vertex arrays on a per-mesh basis, generate global vertex arrays for the entire mesh
      */
     static const unsigned GLH_CONFIGURE_GLOBAL_VERTEX_ARRAYS = 0x2000;
+
+    /* generate levels of detail for each mesh using quadric-error simplification
+     * the simplification of the meshes is spread across a thread pool
+     * up to GLH_MODEL_MAX_LODS levels are generated per mesh, each with GLH_MODEL_LOD_TRIANGLE_RATIO of the triangles of the level before
+     * a level is only kept if it is a worthwhile reduction while staying within GLH_MODEL_LOD_MAX_RELATIVE_ERROR
+     */
+    static const unsigned GLH_GENERATE_LODS = 0x4000;
+
+    /* build meshlets for each mesh, which are buffered into ssbos for the whole model
+     * the meshlets index the global vertex data, so this flag requires GLH_CONFIGURE_GLOBAL_VERTEX_ARRAYS
+     * if meshes are split by alpha values, the opaque and transparent faces form separate meshlets
+     */
+    static const unsigned GLH_BUILD_MESHLETS = 0x8000;
+
+    /* alpha test by rasterisation
+     * when splitting meshes by alpha values, rasterise each mesh in turn with a geometry shader rather than using the compute program,
+     * waiting for the queue to finish after each mesh
+     * this is the original method of alpha testing, and is kept to compare import times against
+     */
+    static const unsigned GLH_ALPHA_TEST_BY_RASTERISATION = 0x10000;
+
+    /* alpha test on cpu
+     * when splitting meshes by alpha values, classify faces on the cpu across a thread pool rather than using the compute program
+     * each face is sampled at the same points as the compute program, from the decoded images of the diffuse stack, so no gl calls are made while alpha testing
+     * takes precedence over GLH_ALPHA_TEST_BY_RASTERISATION
+     */
+    static const unsigned GLH_ALPHA_TEST_ON_CPU = 0x20000;
     
 
 
@@ -702,6 +844,32 @@ struct glh::model::render_flags
      */
     static const unsigned GLH_LEAVE_GLOBAL_VERTEX_ARRAYS_BOUND = 0x10;
 
+    /* occlusion culling
+     * meshes whose regions are occluded in the depth pyramid set by set_occlusion_pyramid will not be rendered
+     * mesh regions must have been configured on import (so GLH_CONFIGURE_ONLY_ROOT_NODE_REGION cannot be used with accurate regions)
+     */
+    static const unsigned GLH_OCCLUSION_CULLING = 0x20;
+
+    /* frustum culling
+     * meshes whose regions lie outside of the frustum set by set_culling_frustum will not be rendered
+     * mesh regions must have been configured on import, as for occlusion culling
+     * when rendering instanced, both culling flags instead apply to whole instances, and do not require mesh regions
+     */
+    static const unsigned GLH_FRUSTUM_CULLING = 0x40;
+
+    /* level of detail selection
+     * each mesh is rendered at the level of detail chosen by the projected size of its region, as seen by the camera set by set_lod_camera
+     * mesh regions must have been configured on import, as must levels of detail (GLH_GENERATE_LODS)
+     * if meshes were split by alpha values, levels of detail are only used for meshes which are entirely opaque or entirely transparent
+     * this flag is ignored by render_instanced
+     */
+    static const unsigned GLH_LOD_SELECTION = 0x80;
+
+    /* uniform name lookup
+     * the members of texture stack levels are looked up by name rather than by hashed id, which is only useful to benchmark the two against each other
+     */
+    static const unsigned GLH_UNIFORM_NAME_LOOKUP = 0x100;
+
 };
 
 
@@ -712,7 +880,7 @@ struct glh::model::render_flags
  *
  * a class for a model
  */
-class glh::model::model
+class glh::model::model : public core::draw_source
 {
 public:
 
@@ -744,6 +912,14 @@ public:
 
 
 
+    /* get_shader_defines
+     *
+     * get the #define directives for the maximum texture stack size, to add to shaders which include shaders/materials.glsl
+     */
+    static std::string get_shader_defines () { return "#define MAX_TEXTURE_STACK_SIZE " + std::to_string ( GLH_MODEL_MAX_TEXTURE_STACK_SIZE ) + "\n"; }
+
+
+
     /* render
      *
      * render the model
@@ -757,6 +933,62 @@ public:
     void render ( const math::mat4& transform = math::identity<4> (), const unsigned flags = render_flags::GLH_NONE ) const;
     void render ( const unsigned flags = render_flags::GLH_NONE );
 
+    /* render_instanced
+     *
+     * render many copies of the model, drawing each mesh only once
+     * the transforms are written into the current frame region of the instance data as per-instance vertex attributes, and the program must make use of them (see shaders/vertex.model_instanced.glsl)
+     * the model matrix uniform is still set to the transformation of each node, so should be set to the identity if GLH_NO_MODEL_MATRIX is used
+     * throws if more than GLH_MODEL_MAX_FRAME_INSTANCES instances are drawn since the last call to next_frame
+     * 
+     * material_uni: material uniform to cache and set the material properties to
+     * model_matrix_uni: a 4x4 matrix uniform to cache and apply set the node transformations to
+     * transforms: the model transformation of each instance
+     * flags: rendering flags (none by default)
+     * 
+     * return: the number of instances drawn after culling
+     */
+    unsigned render_instanced ( core::struct_uniform& material_uni, core::uniform& model_matrix_uni, const std::vector<math::mat4>& transforms, const unsigned flags = render_flags::GLH_NONE );
+    unsigned render_instanced ( const std::vector<math::mat4>& transforms, const unsigned flags = render_flags::GLH_NONE ) const;
+
+    /* next_frame
+     *
+     * move the instance data on to its next frame region, waiting for the GPU to finish reading from that region if necessary
+     * this should be called once per frame, after the last call to render_instanced of the frame
+     */
+    void next_frame () { instance_data.next_frame (); }
+
+    /* get_instance_data
+     *
+     * get the ring buffer of instance matrices, e.g. for the number of frames where next_frame had to wait for the GPU
+     */
+    const core::ring_buffer& get_instance_data () const { return instance_data; }
+
+    /* record
+     *
+     * record a packet for each mesh which would be rendered into a render queue, rather than rendering immediately
+     * the depth of each packet is the distance of the mesh region from the view position of the queue, if the mesh regions are configured
+     * two sided meshes are recorded with face culling disabled in the render state
+     * GLH_LEAVE_GLOBAL_VERTEX_ARRAYS_BOUND has no effect, as the queue binds vaos itself
+     * throws if occlusion culling against a depth pyramid which has not been read back since it was built
+     * 
+     * queue: the render queue to record into
+     * state: the render state to record the meshes with
+     * prog: the program to record the meshes with, which the cached uniforms must belong to
+     * transform: the overall model transformation to apply (identity by default)
+     * flags: rendering flags (none by default)
+     */
+    void record ( core::render_queue& queue, const core::render_state& state, const core::program& prog, const math::mat4& transform = math::identity<4> (), const unsigned flags = render_flags::GLH_NONE ) const;
+
+    /* prepare_packet
+     *
+     * set the model matrix and material uniforms of a packet recorded by record
+     * the material is not applied again if the previous packet was recorded by this model with the same program and material
+     * 
+     * packet: the packet about to be drawn
+     * previous: the packet drawn before it, or NULL if it is the first
+     */
+    void prepare_packet ( const core::draw_packet& packet, const core::draw_packet * previous ) const override;
+
 
 
     /* cache_uniforms
@@ -778,6 +1010,127 @@ public:
 
 
 
+    /* set_occlusion_pyramid
+     *
+     * set the depth pyramid to use when rendering with GLH_OCCLUSION_CULLING
+     * the pyramid must outlive its use by the model
+     * rendering reads the pyramid back if it has been built since it was last read, but recording and culling meshlets require it to already be read back
+     * 
+     * pyramid: the depth pyramid to occlusion cull against
+     */
+    void set_occlusion_pyramid ( const culling::depth_pyramid& pyramid ) { occlusion_pyramid = &pyramid; }
+
+    /* set_culling_frustum
+     *
+     * set the frustum to use when rendering with GLH_FRUSTUM_CULLING
+     * the frustum must outlive its use by the model
+     * 
+     * _frustum: the frustum to cull against
+     */
+    void set_culling_frustum ( const culling::frustum& _frustum ) { culling_frustum = &_frustum; }
+
+    /* set_lod_camera
+     *
+     * set the camera to use when rendering with GLH_LOD_SELECTION
+     * the camera must outlive its use by the model
+     * 
+     * cam: the camera to select levels of detail from
+     * threshold: the smallest projected size of a mesh region which is rendered at full detail, as a fraction of half the height of the screen (defaults to 0.25)
+     */
+    void set_lod_camera ( const camera::camera_perspective_movement& cam, const double threshold = 0.25 ) { lod_camera = &cam; lod_threshold = threshold; }
+
+    /* get_num_lods
+     *
+     * get the greatest number of levels of detail of any mesh, not including the full detail
+     */
+    unsigned get_num_lods () const;
+
+    /* lod_report
+     *
+     * get the combined reduction and quality of a level of detail over all meshes
+     * meshes with fewer levels of detail contribute their least detailed level
+     * 
+     * level: the level of detail to report on (0 for the full detail)
+     */
+    lod::simplification_report lod_report ( const unsigned level ) const;
+
+
+
+    /* cull_meshlets
+     *
+     * cull the meshlets of the model on the CPU, returning the indices of those which are visible in the global meshlet data
+     * meshlets are always tested against their normal cones, and the GLH_FRUSTUM_CULLING and GLH_OCCLUSION_CULLING render flags enable the other tests
+     * GLH_OPAQUE_MODE and GLH_TRANSPARENT_MODE only keep the meshlets which would be rendered in that mode
+     * throws if occlusion culling against a depth pyramid which has not been read back since it was built
+     * 
+     * viewpos: the position of the viewer
+     * transform: the overall model transformation to apply (identity by default)
+     * flags: rendering flags (none by default)
+     * 
+     * return: the global indices of the visible meshlets
+     */
+    std::vector<unsigned> cull_meshlets ( const math::vec3& viewpos, const math::mat4& transform = math::identity<4> (), const unsigned flags = render_flags::GLH_NONE ) const;
+
+    /* get_num_meshlets
+     *
+     * get the total number of meshlets of the model
+     */
+    unsigned get_num_meshlets () const { return num_meshlets; }
+
+    /* get_meshlet_statistics
+     * reset_meshlet_statistics
+     *
+     * get or reset the number of meshlets tested and culled by cull_meshlets
+     */
+    const meshlet::culling_statistics& get_meshlet_statistics () const { return meshlet_statistics; }
+    void reset_meshlet_statistics () const { meshlet_statistics = meshlet::culling_statistics {}; }
+
+    /* get_meshlet_data
+     * get_meshlet_vertex_data
+     * get_meshlet_triangle_data
+     *
+     * get the ssbos of the meshlets, their vertex indices into the global vertex data and their packed triangles
+     * these can be bound to shader storage binding points (see shaders/meshlets.glsl)
+     */
+    const core::ssbo& get_meshlet_data () const { return meshlet_data; }
+    const core::ssbo& get_meshlet_vertex_data () const { return meshlet_vertex_data; }
+    const core::ssbo& get_meshlet_triangle_data () const { return meshlet_triangle_data; }
+
+    /* has_mesh_regions
+     *
+     * returns true if the regions of meshes were configured on import
+     */
+    bool has_mesh_regions () const;
+
+    /* get_import_time
+     *
+     * get the time in milliseconds taken to import the model
+     */
+    double get_import_time () const { return import_time; }
+
+    /* get_alpha_test_time
+     *
+     * get the time in milliseconds taken to split the meshes by alpha values, which is part of the import time
+     */
+    double get_alpha_test_time () const { return alpha_test_time; }
+
+    /* get_num_alpha_tested_faces
+     *
+     * get the number of faces which had to be alpha tested (i.e. excluding faces of meshes which are definitely opaque or transparent)
+     */
+    unsigned get_num_alpha_tested_faces () const { return num_alpha_tested_faces; }
+
+    /* verify_alpha_test
+     *
+     * alpha test every face again on the cpu, and compare the results to the opaque and transparent faces of each mesh
+     * this checks that the alpha testing used on import (e.g. the compute program) agrees with GLH_ALPHA_TEST_ON_CPU
+     *
+     * return: the number of faces which were classified differently
+     */
+    unsigned verify_alpha_test () const;
+
+
+
     /* model_region
      *
      * get the region of the model based on a model matrix
@@ -801,9 +1154,25 @@ private:
     /* the post processing steps used to import the model */
     unsigned pps;
 
+    /* the time in milliseconds taken to import the model */
+    double import_time;
+
+    /* the time in milliseconds taken to split the meshes by alpha values, and the number of faces alpha tested */
+    double alpha_test_time;
+    unsigned num_alpha_tested_faces;
+
     /* the rendering flags currently being used */
     mutable unsigned model_render_flags;
 
+    /* the number of instances currently being rendered, and the slot of the instance data which they start from */
+    mutable unsigned model_render_instances;
+    mutable unsigned model_render_base_instance;
+
+    /* whether face culling was enabled when rendering began
+     * face culling is then only toggled between meshes with one and two sided materials, and restored once rendering is complete
+     */
+    mutable bool model_face_culling;
+
     /* the pre-transform matrix and its normal matrix */
     const math::mat4 pretransform_matrix;
     const math::mat3 pretransform_normal_matrix;
@@ -829,13 +1198,26 @@ private:
     core::ebo global_index_data;
     core::vao global_vertex_arrays;
 
+    /* global meshlet buffers, and the total number of meshlets */
+    core::ssbo meshlet_data;
+    core::ssbo meshlet_vertex_data;
+    core::ssbo meshlet_triangle_data;
+    unsigned num_meshlets;
+
+    /* the number of meshlets tested and culled by cull_meshlets */
+    mutable meshlet::culling_statistics meshlet_statistics;
+
+    /* ring buffer of instance matrices, and the matrices of the instances which survived culling
+     * slot 0 of the buffer always holds the identity matrix, and the instances of render_instanced are written into the current frame region after it
+     */
+    mutable core::ring_buffer instance_data;
+    mutable std::vector<math::fmat4> instance_matrices;
 
 
-    /* shaders and programs for alpha testing */
-    core::vshader alpha_test_vshader;
-    core::gshader alpha_test_gshader;
-    core::fshader alpha_test_fshader;
-    core::program alpha_test_program;
+
+    /* the shared programs for alpha testing by compute and by rasterisation, where only the one which is used is not NULL */
+    std::shared_ptr<core::compute_program> alpha_test_compute_program;
+    std::shared_ptr<core::program> alpha_test_program;
 
 
 
@@ -889,6 +1271,18 @@ private:
 
 
 
+    /* the depth pyramid to use for occlusion culling */
+    const culling::depth_pyramid * occlusion_pyramid;
+
+    /* the frustum to use for frustum culling */
+    const culling::frustum * culling_frustum;
+
+    /* the camera and threshold to use for level of detail selection */
+    const camera::camera_perspective_movement * lod_camera;
+    double lod_threshold;
+
+
+
     /* cast_vector
      *
      * cast assimp vectors to glh vectors
@@ -1007,20 +1401,100 @@ private:
      */
     face& add_face ( face& _face, const mesh& _mesh, const aiFace& aiface );
 
+    /* split_meshes
+     *
+     * split every mesh into opaque and transparent faces
+     * meshes which need alpha testing are tested with a dispatch of the compute program for each material, and the results are read after a single fence
+     * if GLH_ALPHA_TEST_BY_RASTERISATION is set, each mesh is split with split_mesh instead
+     */
+    void split_meshes ();
+
     /* split_mesh
      *
-     * split a mesh into opaque and transparent faces
+     * split a mesh into opaque and transparent faces by rasterising it
      * 
      * _mesh: the mesh to split
      */
     void split_mesh ( mesh& _mesh );
 
+    /* add_alpha_tested_face
+     *
+     * add a face to the opaque and transparent faces of its mesh, according to the results of alpha testing it
+     *
+     * _mesh: the mesh of the face
+     * i: the index of the face in the mesh
+     * alpha_test_fb: the 4 bits of the results of alpha testing the face
+     */
+    void add_alpha_tested_face ( mesh& _mesh, const unsigned i, const unsigned alpha_test_fb );
+
+    /* is_opaque/transparent_alpha_test
+     *
+     * find whether the results of alpha testing a face put it in the opaque or transparent faces, taking into account the import flags
+     *
+     * alpha_test_fb: the 4 bits of the results of alpha testing the face
+     */
+    bool is_opaque_alpha_test ( const unsigned alpha_test_fb ) const;
+    bool is_transparent_alpha_test ( const unsigned alpha_test_fb ) const;
+
+    /* get_alpha_test_faces
+     *
+     * get the face data and diffuse stacks of some meshes for alpha testing
+     *
+     * tested_meshes: the meshes to alpha test
+     * face_data: filled with the face data of every face, with the faces of each mesh following the last
+     * first_faces: filled with the index of the first face of each mesh, followed by the total number of faces
+     * stacks: filled with the diffuse stack of each mesh
+     */
+    void get_alpha_test_faces ( const std::vector<const mesh *>& tested_meshes, std::vector<float>& face_data, std::vector<unsigned>& first_faces, std::vector<alpha_test::stack>& stacks ) const;
+
+    /* generate_lods
+     *
+     * generate the levels of detail of a mesh
+     * this makes no OpenGL calls, so is safe to call from any thread
+     * 
+     * _mesh: the mesh to generate levels of detail for
+     */
+    void generate_lods ( mesh& _mesh ) const;
+
+    /* build_meshlets
+     *
+     * build the meshlets of a mesh
+     * this makes no OpenGL calls, so is safe to call from any thread
+     * 
+     * _mesh: the mesh to build meshlets for
+     */
+    void build_meshlets ( mesh& _mesh ) const;
+
+    /* has_separate_alpha_faces
+     *
+     * returns true if a mesh has opaque and transparent faces which differ from its faces
+     * 
+     * _mesh: the mesh to check
+     */
+    bool has_separate_alpha_faces ( const mesh& _mesh ) const;
+
+    /* buffer_index_data
+     *
+     * buffer the final index data of a mesh into immutable storage
+     * this contains the faces, followed by the opaque and transparent faces (if distinct from the faces), followed by each level of detail
+     * 
+     * _mesh: the mesh to buffer the index data of
+     */
+    void buffer_index_data ( mesh& _mesh );
+
     /* configure_global_vertex_arrays
      *
      * configures the global vertex arrays
      */
     void configure_global_vertex_arrays ();
 
+    /* configure_meshlet_buffers
+     *
+     * combine the meshlets of every mesh into the global meshlet buffers
+     * the global vertex arrays must already be configured
+     */
+    void configure_meshlet_buffers ();
+
     /* add_node
      *
      * recursively add nodes to the node tree
@@ -1082,6 +1556,23 @@ private:
 
 
 
+    /* render_root
+     *
+     * render the root node, binding the global vertex arrays if configured
+     * the render flags and instance count must already be set
+     * 
+     * transform: the overall model transformation
+     */
+    void render_root ( const math::mat4& transform ) const;
+
+    /* configure_instance_attribs
+     *
+     * configure the instance matrix attributes of a vao to source from the instance data
+     * 
+     * _vertex_arrays: the vao to configure
+     */
+    void configure_instance_attribs ( core::vao& _vertex_arrays );
+
     /* render_node
      *
      * render a node and all of its children
@@ -1096,29 +1587,73 @@ private:
      * render a mesh
      * 
      * _mesh: the mesh to render
+     * level: the level of detail to render (0 for the full detail, which is the default)
+     */
+    void render_mesh ( const mesh& _mesh, const unsigned level = 0 ) const;
+
+    /* mesh_draw_range
+     *
+     * find the range of indices of a mesh to draw with a set of rendering flags
+     * 
+     * _mesh: the mesh to draw
+     * flags: the rendering flags to draw with
+     * level: the level of detail to draw
+     * count: set to the number of indices to draw
+     * start_index: set to the first index to draw, in the global element buffer if global vertex arrays are configured
+     * 
+     * return: false if there is nothing to draw
+     */
+    bool mesh_draw_range ( const mesh& _mesh, const unsigned flags, const unsigned level, GLsizei& count, GLsizeiptr& start_index ) const;
+
+    /* record_node
+     *
+     * record a node and all of its children into a render queue
+     * 
+     * queue: the render queue to record into
+     * state: the render state to record one sided meshes with
+     * two_sided_state: the render state to record two sided meshes with
+     * prog: the program to record the meshes with
+     * _node: the node to record
+     * transform: the current model transformation from all the previous nodes
+     * flags: rendering flags
+     */
+    void record_node ( core::render_queue& queue, const core::render_state& state, const core::render_state& two_sided_state, const core::program& prog, const node& _node, const math::fmat4& transform, const unsigned flags ) const;
+
+    /* cull_node_meshlets
+     *
+     * cull the meshlets of a node and all of its children
+     * 
+     * _node: the node to cull the meshlets of
+     * transform: the current model transformation from all the previous nodes
+     * viewpos: the position of the viewer
+     * flags: rendering flags
+     * visible: the array to append the global indices of visible meshlets to
      */
-    void render_mesh ( const mesh& _mesh ) const;
+    void cull_node_meshlets ( const node& _node, const math::fmat4& transform, const math::vec3& viewpos, const unsigned flags, std::vector<unsigned>& visible ) const;
 
     /* apply_material
      *
      * apply material uniforms during mesh rendering
      * 
      * _material: the material to apply
+     * flags: the render flags, of which only GLH_UNIFORM_NAME_LOOKUP is used (none by default)
      */
-    void apply_material ( const material& _material ) const;
+    void apply_material ( const material& _material, const unsigned flags = render_flags::GLH_NONE ) const;
 
     /* apply_texture_stack
      *
      * apply a texture stack during mesh rendering
      * 
      * _texture_stack: the texture stack to apply
+     * textures_unit: the texture unit the textures of the stack are bound to
      * stack_size/base_color/levels/textures_uni: cached stack uniforms
+     * flags: the render flags, of which only GLH_UNIFORM_NAME_LOOKUP is used
      */
     void apply_texture_stack 
     ( 
-        const texture_stack& _texture_stack, 
+        const texture_stack& _texture_stack, const unsigned textures_unit,
         core::uniform& stack_size_uni, core::uniform& stack_base_color_uni,
-        core::struct_array_uniform& stack_levels_uni, core::uniform& stack_textures_uni 
+        core::struct_array_uniform& stack_levels_uni, core::uniform& stack_textures_uni, const unsigned flags
     ) const;
 
 };
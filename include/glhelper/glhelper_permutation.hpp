@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * include/glhelper/glhelper_permutation.hpp
+ *
+ * constructs for building specialised variants of a program from a set of compile-time features
+ * notable constructs include:
+ *
+ *
+ *
+ * STRUCT GLH::CORE::PERMUTATION_FEATURE
+ *
+ * a single compile-time feature of a program, which becomes a #define in each of its shaders
+ * a flag feature is either defined without a value or not defined at all (e.g. NO_SHADOWS)
+ * any other feature is always defined as its value, which must be no greater than its maximum (e.g. NUM_DIRLIGHTS)
+ *
+ *
+ *
+ * CLASS GLH::CORE::PROGRAM_PERMUTATIONS
+ *
+ * a lazily-built set of variants of one program, each specialised for a combination of feature values
+ * the values of the features are packed into a 64-bit key with make_key, where each feature takes just enough bits to hold its maximum
+ * get then returns the variant for a key, building it through glh::core::program_registry the first time it is asked for,
+ * so that variants are shared with any other identical program, and previously linked variants come from the binary cache
+ * a build callback can be set to prepare each new variant (e.g. to bind its uniform blocks) before it is returned
+ * since shaders which are specialised for the values they are used with can have their loops unrolled and unused branches removed,
+ * variants are generally faster than a single program which branches on uniforms
+ * the number of variants built and the time taken to build them and look them up are recorded, so that the cost of building variants can be compared to the time they save
+ *
+ *
+ *
+ * CLASS GLH::EXCEPTION::PERMUTATION_EXCEPTION
+ *
+ * thrown when an error occurs in one of the permutation methods (e.g. a feature value greater than its maximum)
+ *
+ */
+
+
+
+/* HEADER GUARD */
+#ifndef GLHELPER_PERMUTATION_HPP_INCLUDED
+#define GLHELPER_PERMUTATION_HPP_INCLUDED
+
+
+
+/* INCLUDES */
+
+/* include core headers */
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* include glhelper_core.hpp */
+#include <glhelper/glhelper_core.hpp>
+
+/* include glhelper_exception.hpp */
+#include <glhelper/glhelper_exception.hpp>
+
+/* include glhelper_shader.hpp */
+#include <glhelper/glhelper_shader.hpp>
+
+
+
+/* NAMESPACE DECLARATIONS */
+
+namespace glh
+{
+    namespace core
+    {
+        /* struct permutation_feature
+         *
+         * a compile-time feature of a program
+         */
+        struct permutation_feature;
+
+        /* class program_permutations
+         *
+         * lazily-built variants of a program
+         */
+        class program_permutations;
+    }
+
+    namespace exception
+    {
+        /* class permutation_exception : exception
+         *
+         * exception relating to program permutations
+         */
+        class permutation_exception;
+    }
+}
+
+
+
+/* PERMUTATION_FEATURE DEFINITION */
+
+/* struct permutation_feature
+ *
+ * a compile-time feature of a program
+ */
+struct glh::core::permutation_feature
+{
+    /* the name of the macro to define */
+    std::string name;
+
+    /* the maximum value of the feature, which is 1 for flags */
+    unsigned max_value = 1;
+
+    /* true if the feature is a flag, which is defined without a value when its value is 1, and not defined otherwise */
+    bool flag = false;
+};
+
+
+
+/* PROGRAM_PERMUTATIONS DEFINITION */
+
+/* class program_permutations
+ *
+ * lazily-built variants of a program
+ */
+class glh::core::program_permutations
+{
+public:
+
+    /* full constructor
+     *
+     * describe the program and its features, without building any variants
+     *
+     * _vshader_paths/_gshader_paths/_fshader_paths: the source files of each shader, where no geometry shader paths means no geometry shader
+     * _features: the features of the program, in the order their values are given to make_key
+     * _defines: source to insert into every variant before the feature defines (e.g. the maxima of the library) (defaults to none)
+     */
+    program_permutations ( const std::vector<std::string>& _vshader_paths, const std::vector<std::string>& _gshader_paths, const std::vector<std::string>& _fshader_paths,
+        const std::vector<permutation_feature>& _features, const std::string& _defines = "" );
+
+    /* deleted copy constructor */
+    program_permutations ( const program_permutations& other ) = delete;
+
+    /* default move constructor */
+    program_permutations ( program_permutations&& other ) = default;
+
+    /* deleted copy assignment operator */
+    program_permutations& operator= ( const program_permutations& other ) = delete;
+
+    /* default destructor */
+    ~program_permutations () = default;
+
+
+
+    /* make_key
+     *
+     * pack the values of the features into a key
+     *
+     * values: the value of each feature, in the order the features were given to the constructor
+     *
+     * return: the key of the variant
+     */
+    std::uint64_t make_key ( const std::vector<unsigned>& values ) const;
+    std::uint64_t make_key ( std::initializer_list<unsigned> values ) const { return make_key ( std::vector<unsigned> { values } ); }
+
+    /* get_defines
+     *
+     * get the source inserted into the shaders of a variant, including the shared defines
+     *
+     * key: the key of the variant
+     */
+    std::string get_defines ( const std::uint64_t key ) const;
+
+    /* get
+     *
+     * get the variant for a key, building it if it has not been built before
+     *
+     * key: the key of the variant
+     *
+     * return: the variant, which stays valid for the lifetime of this object
+     */
+    program& get ( const std::uint64_t key );
+
+    /* set_build_callback
+     *
+     * set a function to call with each newly built variant before it is returned from get
+     *
+     * _build_callback: the function to call, or an empty function to call nothing
+     */
+    void set_build_callback ( const std::function<void ( program& )>& _build_callback ) { build_callback = _build_callback; }
+
+
+
+    /* get_num_features/variants
+     *
+     * get the number of features of the program, and the number of variants which have been built
+     */
+    unsigned get_num_features () const { return features.size (); }
+    unsigned get_num_variants () const { return variants.size (); }
+
+    /* get_num_builds/lookups
+     *
+     * get the number of calls to get which built a variant, and the total number of calls to get
+     */
+    unsigned get_num_builds () const { return num_builds; }
+    unsigned get_num_lookups () const { return num_lookups; }
+
+    /* get_build_time/lookup_time
+     *
+     * get the total time in milliseconds spent building variants, and spent in calls to get which found an existing variant
+     */
+    double get_build_time () const { return build_time; }
+    double get_lookup_time () const { return lookup_time; }
+
+    /* reset_statistics
+     *
+     * reset the build and lookup counts and times
+     */
+    void reset_statistics ();
+
+
+
+private:
+
+    /* the source files of each shader */
+    std::vector<std::string> vshader_paths;
+    std::vector<std::string> gshader_paths;
+    std::vector<std::string> fshader_paths;
+
+    /* the features of the program, and the shift of each within a key */
+    std::vector<permutation_feature> features;
+    std::vector<unsigned> shifts;
+
+    /* the source inserted into every variant */
+    std::string defines;
+
+    /* the variants which have been built, by key */
+    std::unordered_map<std::uint64_t, std::shared_ptr<program>> variants;
+
+    /* the function to call with each new variant */
+    std::function<void ( program& )> build_callback;
+
+    /* statistics */
+    unsigned num_builds;
+    unsigned num_lookups;
+    double build_time;
+    double lookup_time;
+
+
+
+    /* feature_value
+     *
+     * extract the value of a feature from a key
+     *
+     * key: the key to extract from
+     * index: the index of the feature
+     */
+    unsigned feature_value ( const std::uint64_t key, const unsigned index ) const;
+
+};
+
+
+
+/* PERMUTATION_EXCEPTION DEFINITION */
+
+/* class permutation_exception : exception
+ *
+ * exception relating to program permutations
+ */
+class glh::exception::permutation_exception : public exception
+{
+public:
+
+    /* full constructor
+     *
+     * __what: description of the exception
+     */
+    explicit permutation_exception ( const std::string& __what )
+        : exception { __what }
+    {}
+
+    /* default zero-parameter constructor
+     *
+     * construct permutation_exception with no descrption
+     */
+    permutation_exception () = default;
+
+    /* default everything else and inherits what () function */
+
+};
+
+
+
+/* #ifndef GLHELPER_PERMUTATION_HPP_INCLUDED */
+#endif
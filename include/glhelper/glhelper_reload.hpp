@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * include/glhelper/glhelper_reload.hpp
+ *
+ * constructs for reloading shaders while the application is running
+ * notable constructs include:
+ *
+ *
+ *
+ * CLASS GLH::CORE::SHADER_RELOADER
+ *
+ * watches the files included into the shaders of a set of programs with inotify, and recompiles and relinks the programs when any of them change
+ * the directories containing the files are watched, rather than the files themselves, so that editors which save by replacing a file are still noticed
+ * update should be called once per frame on the thread with the context, and never blocks on the driver if GL_KHR_parallel_shader_compile is supported:
+ * changed shaders are submitted with shader::recompile_async, then once they have compiled their programs are submitted with program::relink_async,
+ * after first compiling any unchanged shader of a program loaded from the binary cache, which never compiled its shaders,
+ * and once they have linked each new program object is swapped in by program::finish_relink, so the driver compiles and links in the background while frames continue
+ * without the extension, each step is finished on the update after it is submitted, which blocks for that step only
+ * if a shader fails to compile or a program fails to link, the error is logged and the old program keeps running, so a mistake never stops the application
+ * uniform values, uniform block bindings and every uniform already extracted from a program are carried over to its new program object,
+ * so uniform caches (e.g. those of models and light systems) stay valid
+ * the number of programs reloaded and failed, and the time from noticing a change to the new program being swapped in, are recorded
+ * only Linux is supported, as inotify is used
+ *
+ *
+ *
+ * CLASS GLH::EXCEPTION::RELOAD_EXCEPTION
+ *
+ * thrown when an error occurs in one of the reload methods (e.g. inotify cannot be initialised)
+ *
+ */
+
+
+
+/* HEADER GUARD */
+#ifndef GLHELPER_RELOAD_HPP_INCLUDED
+#define GLHELPER_RELOAD_HPP_INCLUDED
+
+
+
+/* INCLUDES */
+
+/* include core headers */
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+/* include inotify */
+#include <sys/inotify.h>
+#include <unistd.h>
+
+/* include glhelper_core.hpp */
+#include <glhelper/glhelper_core.hpp>
+
+/* include glhelper_exception.hpp */
+#include <glhelper/glhelper_exception.hpp>
+
+/* include glhelper_shader.hpp */
+#include <glhelper/glhelper_shader.hpp>
+
+
+
+/* NAMESPACE DECLARATIONS */
+
+namespace glh
+{
+    namespace core
+    {
+        /* class shader_reloader
+         *
+         * recompiles and relinks programs when their shader files change
+         */
+        class shader_reloader;
+    }
+
+    namespace exception
+    {
+        /* class reload_exception : exception
+         *
+         * exception relating to reloading shaders
+         */
+        class reload_exception;
+    }
+}
+
+
+
+/* SHADER_RELOADER DEFINITION */
+
+/* class shader_reloader
+ *
+ * recompiles and relinks programs when their shader files change
+ */
+class glh::core::shader_reloader
+{
+public:
+
+    /* zero-parameter constructor
+     *
+     * initialise inotify, watching no programs
+     */
+    shader_reloader ();
+
+    /* deleted copy constructor */
+    shader_reloader ( const shader_reloader& other ) = delete;
+
+    /* deleted copy assignment operator */
+    shader_reloader& operator= ( const shader_reloader& other ) = delete;
+
+    /* destructor */
+    ~shader_reloader ();
+
+
+
+    /* add
+     *
+     * watch the files of the shaders of a program, reloading the program when any of them change
+     * the program must outlive the reloader, or be removed first
+     *
+     * prog: the program to add
+     */
+    void add ( program& prog );
+
+    /* remove
+     *
+     * stop reloading a program, abandoning any reload in progress
+     *
+     * prog: the program to remove
+     */
+    void remove ( program& prog );
+
+    /* update
+     *
+     * read any changes to watched files, submit reloads for the programs affected, and progress any reloads in progress
+     *
+     * return: the number of programs swapped for their reloaded versions by this call
+     */
+    unsigned update ();
+
+
+
+    /* get_num_programs
+     *
+     * get the number of programs being watched
+     */
+    unsigned get_num_programs () const { return programs.size (); }
+
+    /* get_num_reloads/failed_reloads
+     *
+     * get the number of programs which have been reloaded, and the number of reloads which failed, leaving the old program running
+     */
+    unsigned get_num_reloads () const { return num_reloads; }
+    unsigned get_num_failed_reloads () const { return num_failed_reloads; }
+
+    /* get_last_reload_time
+     *
+     * get the time in milliseconds from noticing a change to swapping in the last program reloaded
+     */
+    double get_last_reload_time () const { return last_reload_time; }
+
+
+
+private:
+
+    /* the inotify file descriptor */
+    int inotify_fd;
+
+    /* the watched directories by watch descriptor */
+    std::map<int, std::string> watched_directories;
+
+    /* the programs being watched */
+    std::vector<program *> programs;
+
+    /* struct pending_reload
+     *
+     * a program being reloaded, when the change was noticed, and whether any of its shaders has failed to compile
+     */
+    struct pending_reload
+    {
+        program * prog;
+        std::chrono::steady_clock::time_point start;
+        bool failed;
+    };
+
+    /* the reloads in progress */
+    std::vector<pending_reload> pending_reloads;
+
+    /* statistics */
+    unsigned num_reloads;
+    unsigned num_failed_reloads;
+    double last_reload_time;
+
+
+
+    /* watch_program
+     *
+     * watch the directory of every file included into the shaders of a program
+     *
+     * prog: the program to watch
+     */
+    void watch_program ( const program& prog );
+
+    /* read_changed_files
+     *
+     * read every pending inotify event, without blocking
+     *
+     * return: the normalised paths of the files which changed
+     */
+    std::set<std::string> read_changed_files ();
+
+    /* submit_reloads
+     *
+     * submit the recompilation of every shader which includes a changed file, and start reloading the programs using them
+     *
+     * changed_files: the normalised paths of the files which changed
+     */
+    void submit_reloads ( const std::set<std::string>& changed_files );
+
+    /* progress_reload
+     *
+     * move a reload on to its next step if the driver has finished the current one
+     *
+     * reload: the reload to progress
+     *
+     * return: true if the reload has finished, whether or not it succeeded
+     */
+    bool progress_reload ( pending_reload& reload );
+
+};
+
+
+
+/* RELOAD_EXCEPTION DEFINITION */
+
+/* class reload_exception : exception
+ *
+ * exception relating to reloading shaders
+ */
+class glh::exception::reload_exception : public exception
+{
+public:
+
+    /* full constructor
+     *
+     * __what: description of the exception
+     */
+    explicit reload_exception ( const std::string& __what )
+        : exception { __what }
+    {}
+
+    /* default zero-parameter constructor
+     *
+     * construct reload_exception with no descrption
+     */
+    reload_exception () = default;
+
+    /* default everything else and inherits what () function */
+
+};
+
+
+
+/* #ifndef GLHELPER_RELOAD_HPP_INCLUDED */
+#endif
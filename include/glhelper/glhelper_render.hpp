@@ -11,10 +11,33 @@
  * 
  * 
  * 
+ * STRUCT GLH::CORE::GL_DISPATCH
+ * 
+ * a table of pointers to the OpenGL functions used by the renderer to change state, bind objects and draw
+ * by default the table calls straight through to OpenGL, but it can be replaced (e.g. with functions which record their calls)
+ * this allows the state cache to be exercised without an OpenGL context
+ * 
+ * 
+ * 
+ * CLASS GLH::CORE::RENDER_STATE
+ * 
+ * an immutable bundle of the depth, stencil, blend, face culling, multisample and viewport settings for a rendering pass
+ * a render state is built up from the default state of OpenGL by with_* methods, each of which return a modified copy
+ * the viewport is optional, and is left as it is if not specified
+ * the settings are applied all at once with renderer::apply, which only makes calls for the settings which differ from the current state
+ * as every setting (other than an unspecified viewport) is applied, a pass using a render state cannot inherit stray state from the pass before
+ * 
+ * 
+ * 
  * CLASS GLH::CORE::RENDERER
  * 
  * class containing static methods to control rendering and rendering options
- * various settings are tracked to reduce duplicate calls to set the same setting
+ * the renderer shadows the blend, depth, stencil, raster, viewport and scissor state, as well as the program, vao, buffer, texture and sampler bindings
+ * any call which would set state to the value it already has is skipped
+ * the number of calls issued and skipped are counted, and should be reset once per frame with reset_state_statistics
+ * the objects of glhelper bind through the renderer, so the bindings stay in sync with the state cache
+ * compute work groups are dispatched through the renderer as well, which flushes staged uniform block data first, just as drawing does
+ * if OpenGL state is changed outside of the renderer, reset_state should be used to return the cache to its defaults
  * 
  */
 
@@ -29,6 +52,8 @@
 /* INCLUDES */
 
 /* include core headers */
+#include <algorithm>
+#include <array>
 #include <iostream>
 #include <vector>
 
@@ -52,6 +77,18 @@ namespace glh
 {
     namespace core
     {
+        /* struct gl_dispatch
+         *
+         * table of OpenGL functions used by the renderer
+         */
+        struct gl_dispatch;
+
+        /* class render_state
+         *
+         * immutable bundle of rendering settings
+         */
+        class render_state;
+
         /* class renderer
          *
          * contains static methods to control rendering
@@ -62,6 +99,247 @@ namespace glh
 
 
 
+/* GL_DISPATCH DEFINITION */
+
+/* struct gl_dispatch
+ * 
+ * table of OpenGL functions used by the renderer
+ */
+struct glh::core::gl_dispatch
+{
+    /* capabilities */
+    void ( * enable ) ( GLenum cap );
+    void ( * disable ) ( GLenum cap );
+    void ( * enablei ) ( GLenum cap, GLuint index );
+    void ( * disablei ) ( GLenum cap, GLuint index );
+
+    /* clearing */
+    void ( * clear_color ) ( GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha );
+    void ( * clear ) ( GLbitfield mask );
+
+    /* depth state */
+    void ( * depth_func ) ( GLenum func );
+    void ( * depth_mask ) ( GLboolean flag );
+
+    /* stencil state */
+    void ( * stencil_func ) ( GLenum func, GLint ref, GLuint mask );
+    void ( * stencil_op ) ( GLenum sfail, GLenum dpfail, GLenum dppass );
+    void ( * stencil_mask ) ( GLuint mask );
+
+    /* blend state */
+    void ( * blend_func_separate ) ( GLenum srgbfact, GLenum drgbfact, GLenum salphafact, GLenum dalphafact );
+    void ( * blend_func_separatei ) ( GLuint buf, GLenum srgbfact, GLenum drgbfact, GLenum salphafact, GLenum dalphafact );
+    void ( * blend_equation_separate ) ( GLenum rgbequ, GLenum alphaequ );
+    void ( * blend_equation_separatei ) ( GLuint buf, GLenum rgbequ, GLenum alphaequ );
+
+    /* raster state */
+    void ( * cull_face ) ( GLenum face );
+    void ( * front_face ) ( GLenum winding );
+    void ( * polygon_mode ) ( GLenum face, GLenum mode );
+    void ( * color_mask ) ( GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha );
+    void ( * viewport ) ( GLint x, GLint y, GLsizei width, GLsizei height );
+    void ( * scissor ) ( GLint x, GLint y, GLsizei width, GLsizei height );
+
+    /* object bindings */
+    void ( * use_program ) ( GLuint program );
+    void ( * bind_vertex_array ) ( GLuint array );
+    void ( * bind_buffer ) ( GLenum target, GLuint buffer );
+    void ( * bind_buffer_base ) ( GLenum target, GLuint index, GLuint buffer );
+    void ( * bind_buffer_range ) ( GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size );
+    void ( * bind_texture ) ( GLenum target, GLuint texture );
+    void ( * bind_texture_unit ) ( GLuint unit, GLuint texture );
+    void ( * bind_textures ) ( GLuint first, GLsizei count, const GLuint * textures );
+    void ( * bind_sampler ) ( GLuint unit, GLuint sampler );
+
+    /* drawing */
+    void ( * draw_arrays ) ( GLenum mode, GLint first, GLsizei count );
+    void ( * draw_arrays_instanced_base_instance ) ( GLenum mode, GLint first, GLsizei count, GLsizei instances, GLuint base_instance );
+    void ( * draw_elements ) ( GLenum mode, GLsizei count, GLenum type, const void * indices );
+    void ( * draw_elements_instanced_base_instance ) ( GLenum mode, GLsizei count, GLenum type, const void * indices, GLsizei instances, GLuint base_instance );
+
+    /* compute */
+    void ( * dispatch_compute ) ( GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z );
+    void ( * dispatch_compute_indirect ) ( GLintptr indirect );
+};
+
+
+
+/* RENDER_STATE DEFINITION */
+
+/* class render_state
+ * 
+ * immutable bundle of rendering settings
+ */
+class glh::core::render_state
+{
+public:
+
+    /* struct blend_target
+     *
+     * the blend factors and equations of a render target
+     */
+    struct blend_target
+    {
+        GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
+        GLenum equ_rgb, equ_alpha;
+
+        bool operator== ( const blend_target& other ) const
+        { return src_rgb == other.src_rgb && dst_rgb == other.dst_rgb && src_alpha == other.src_alpha && dst_alpha == other.dst_alpha && equ_rgb == other.equ_rgb && equ_alpha == other.equ_alpha; }
+        bool operator!= ( const blend_target& other ) const { return !( * this == other ); }
+    };
+
+
+
+    /* default constructor
+     *
+     * the default state of OpenGL, with the viewport left unspecified
+     */
+    render_state ();
+
+    /* default copy constructor */
+    render_state ( const render_state& other ) = default;
+
+    /* default copy assignment operator */
+    render_state& operator= ( const render_state& other ) = default;
+
+    /* default destructor */
+    ~render_state () = default;
+
+
+
+    /* with_depth_test/mask/func
+     *
+     * return a copy of the state with depth testing enabled or disabled, a different depth mask, or a different depth function
+     */
+    render_state with_depth_test ( const bool enabled ) const;
+    render_state with_depth_mask ( const GLboolean mask ) const;
+    render_state with_depth_func ( const GLenum func ) const;
+
+    /* with_stencil_test/mask/func/op
+     *
+     * return a copy of the state with stencil testing enabled or disabled, a different stencil mask, function or operations
+     */
+    render_state with_stencil_test ( const bool enabled ) const;
+    render_state with_stencil_mask ( const GLuint mask ) const;
+    render_state with_stencil_func ( const GLenum func, const GLint ref, const GLuint mask ) const;
+    render_state with_stencil_op ( const GLenum sfail, const GLenum dpfail, const GLenum dppass ) const;
+
+    /* with_blend
+     *
+     * return a copy of the state with blending enabled or disabled
+     */
+    render_state with_blend ( const bool enabled ) const;
+
+    /* with_blend_func/func_separate/equation
+     *
+     * return a copy of the state with different blend factors or equations, either for all render targets or a specific render target
+     */
+    render_state with_blend_func ( const GLenum sfactor, const GLenum dfactor ) const
+    { return with_blend_func_separate ( sfactor, dfactor, sfactor, dfactor ); }
+    render_state with_blend_func ( const unsigned render_target, const GLenum sfactor, const GLenum dfactor ) const
+    { return with_blend_func_separate ( render_target, sfactor, dfactor, sfactor, dfactor ); }
+    render_state with_blend_func_separate ( const GLenum srgbfact, const GLenum drgbfact, const GLenum salphafact, const GLenum dalphafact ) const;
+    render_state with_blend_func_separate ( const unsigned render_target, const GLenum srgbfact, const GLenum drgbfact, const GLenum salphafact, const GLenum dalphafact ) const;
+    render_state with_blend_equation ( const GLenum equ ) const;
+    render_state with_blend_equation ( const unsigned render_target, const GLenum equ ) const;
+
+    /* with_face_culling/cull_face/front_face
+     *
+     * return a copy of the state with face culling enabled or disabled, or a different culled face or front face winding order
+     */
+    render_state with_face_culling ( const bool enabled ) const;
+    render_state with_cull_face ( const GLenum face ) const;
+    render_state with_front_face ( const GLenum winding ) const;
+
+    /* with_multisample
+     *
+     * return a copy of the state with multisampling enabled or disabled
+     */
+    render_state with_multisample ( const bool enabled ) const;
+
+    /* with/without_viewport
+     *
+     * return a copy of the state with a specified viewport, or with the viewport left unspecified
+     */
+    render_state with_viewport ( const GLint x, const GLint y, const GLsizei width, const GLsizei height ) const;
+    render_state without_viewport () const;
+
+
+
+    /* getters for the settings */
+    bool depth_test_enabled () const { return depth_test; }
+    GLboolean get_depth_mask () const { return depth_mask; }
+    GLenum get_depth_func () const { return depth_func; }
+    bool stencil_test_enabled () const { return stencil_test; }
+    GLuint get_stencil_mask () const { return stencil_mask; }
+    GLenum get_stencil_func () const { return stencil_function; }
+    GLint get_stencil_ref () const { return stencil_ref; }
+    GLuint get_stencil_func_mask () const { return stencil_func_mask; }
+    GLenum get_stencil_sfail () const { return stencil_sfail; }
+    GLenum get_stencil_dpfail () const { return stencil_dpfail; }
+    GLenum get_stencil_dppass () const { return stencil_dppass; }
+    bool blend_enabled () const { return blend; }
+    const blend_target& get_blend_target ( const unsigned render_target ) const { return blend_targets.at ( render_target ); }
+    bool face_culling_enabled () const { return face_culling; }
+    GLenum get_cull_face () const { return cull_face; }
+    GLenum get_front_face () const { return front_face; }
+    bool multisample_enabled () const { return multisample; }
+    bool has_viewport () const { return viewport_specified; }
+    const std::array<GLint, 4>& get_viewport () const { return viewport_box; }
+
+    /* uniform_blend_targets
+     *
+     * returns true if every render target has the same blend factors and equations
+     */
+    bool uniform_blend_targets () const;
+
+    /* operator==/!=
+     *
+     * compare render states setting by setting
+     */
+    bool operator== ( const render_state& other ) const;
+    bool operator!= ( const render_state& other ) const { return !( * this == other ); }
+
+
+
+private:
+
+    /* depth settings */
+    bool depth_test;
+    GLboolean depth_mask;
+    GLenum depth_func;
+
+    /* stencil settings */
+    bool stencil_test;
+    GLuint stencil_mask;
+    GLenum stencil_function;
+    GLint stencil_ref;
+    GLuint stencil_func_mask;
+    GLenum stencil_sfail, stencil_dpfail, stencil_dppass;
+
+    /* blend settings, with the factors and equations of each render target */
+    bool blend;
+    std::array<blend_target, 8> blend_targets;
+
+    /* face culling settings */
+    bool face_culling;
+    GLenum cull_face;
+    GLenum front_face;
+
+    /* multisample setting */
+    bool multisample;
+
+    /* the viewport, and whether it is specified */
+    bool viewport_specified;
+    std::array<GLint, 4> viewport_box;
+
+    /* the renderer can create render states from its current state */
+    friend class renderer;
+
+};
+
+
+
 /* RENDERER DEFINITION */
 
 /* class renderer
@@ -86,6 +364,64 @@ public:
 
 
 
+    /* get/set/reset_dispatch
+     * 
+     * get, replace or restore the table of functions used to call OpenGL
+     * setting or resetting the table also resets the state cache, as the new table will start from the default state
+     * 
+     * _dispatch: the new table of functions
+     */
+    static const gl_dispatch& get_dispatch () { return dispatch; }
+    static void set_dispatch ( const gl_dispatch& _dispatch );
+    static void reset_dispatch ();
+
+    /* reset_state
+     * 
+     * return the state cache to the default state of a new OpenGL context
+     * no OpenGL calls are made
+     */
+    static void reset_state ();
+
+    /* get_num_issued_calls
+     * 
+     * get the number of state changing calls which were made to OpenGL since the statistics were reset
+     */
+    static unsigned get_num_issued_calls () { return num_issued_calls; }
+
+    /* get_num_skipped_calls
+     * 
+     * get the number of state changing calls which were skipped since the statistics were reset, as the state was already set
+     */
+    static unsigned get_num_skipped_calls () { return num_skipped_calls; }
+
+    /* reset_state_statistics
+     * 
+     * reset the number of issued and skipped calls
+     * this should be done once per frame
+     */
+    static void reset_state_statistics ();
+
+
+
+    /* apply
+     * 
+     * apply a render state, making calls only for the settings which differ from the current state
+     * if the blend settings of the render state are the same for every render target, they are applied to all render targets at once
+     * 
+     * state: the render state to apply
+     */
+    static void apply ( const render_state& state );
+
+    /* get_render_state
+     * 
+     * get the current depth, stencil, blend, face culling, multisample and viewport settings as a render state
+     * this can be used to restore the settings after applying a different render state
+     * the viewport is only specified if it is known
+     */
+    static render_state get_render_state ();
+
+
+
     /* draw_arrays
      *
      * draw vertices straight from a vbo (via a vao)
@@ -95,8 +431,9 @@ public:
      * start_index: the start index of the buffered data
      * count: number of vertices to draw
      * instances: number of instances to draw (defaults to 1)
+     * base_instance: the instance which per-instance attributes start from (defaults to 0)
      */
-    static void draw_arrays ( const GLenum mode, const GLint start_index, const GLsizei count, const unsigned instances = 1 );
+    static void draw_arrays ( const GLenum mode, const GLint start_index, const GLsizei count, const unsigned instances = 1, const unsigned base_instance = 0 );
 
 
 
@@ -109,8 +446,29 @@ public:
      * type: the type of the data in the ebo
      * start_index: the start index of the elements
      * instances: number of instances to draw (defaults to 1)
+     * base_instance: the instance which per-instance attributes start from (defaults to 0)
+     */
+    static void draw_elements ( const GLenum mode, const GLsizei count, const GLenum type, const GLsizeiptr start_index, const unsigned instances = 1, const unsigned base_instance = 0 );
+
+
+
+    /* dispatch_compute
+     * 
+     * dispatch work groups of the compute program in use
+     * 
+     * num_groups_x/y/z: the number of work groups in each dimension
+     */
+    static void dispatch_compute ( const GLuint num_groups_x, const GLuint num_groups_y, const GLuint num_groups_z );
+
+    /* dispatch_compute_indirect
+     * 
+     * dispatch work groups of the compute program in use, reading the number of work groups from a buffer
+     * the buffer is bound to the dispatch indirect target
+     * 
+     * id: the id of the buffer containing the number of work groups in each dimension, as three unsigned integers
+     * offset: the offset of the integers in the buffer in bytes
      */
-    static void draw_elements ( const GLenum mode, const GLsizei count, const GLenum type, const GLsizeiptr start_index, const unsigned instances = 1 );
+    static void dispatch_compute_indirect ( const GLuint id, const GLintptr offset );
 
 
 
@@ -130,7 +488,7 @@ public:
      * buffer_bits: bitfield for the buffers to clear (or all by default)
      */
     static void clear ( const GLbitfield buffer_bits = GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT )
-    { glClear ( buffer_bits ); }
+    { dispatch.clear ( buffer_bits ); }
 
 
 
@@ -156,13 +514,14 @@ public:
     static GLboolean get_depth_mask () { return depth_mask; }
     static void set_depth_mask ( const GLboolean mask );
 
-    /* set_depth_func
+    /* get/set_depth_func
      *
-     * set the function to use for depth testing
+     * get/set the function to use for depth testing
      * 
      * func: the function to use (GL_LESS is the default)
      */
-    static void set_depth_func ( const GLenum func ) { glDepthFunc ( func ); }
+    static GLenum get_depth_func () { return depth_func; }
+    static void set_depth_func ( const GLenum func );
 
     
 
@@ -192,12 +551,11 @@ public:
      *
      * set the function to use for stencil testing
      * 
-     * func: the function to use (GL_LESS is the default)
+     * func: the function to use (GL_ALWAYS is the default)
      * ref: the value to compare the stencil buffer value against
      * mask: another bit mask applied to both the stencil buffer and ref value
      */
-    static void stencil_func ( const GLenum func, const GLint ref, const GLuint mask )
-    { glStencilFunc ( func, ref, mask ); }
+    static void stencil_func ( const GLenum func, const GLint ref, const GLuint mask );
 
     /* stencil_op
      *
@@ -207,8 +565,7 @@ public:
      * dpfail: what to do when the stencil test passes, but depth test fails
      * dppass: what to do when the stencil and depth tests pass
      */
-    static void stencil_op ( const GLenum sfail, const GLenum dpfail, const GLenum dppass )
-    { glStencilOp ( sfail, dpfail, dppass ); }
+    static void stencil_op ( const GLenum sfail, const GLenum dpfail, const GLenum dppass );
 
 
 
@@ -216,14 +573,18 @@ public:
      *
      * enable/disable blending either as a whole or for a specific render target
      */
-    static void enable_blend ()
-    { glEnable ( GL_BLEND ); }
-    static void enable_blend ( const unsigned render_target )
-    { glEnablei ( GL_BLEND, render_target ); }
-    static void disable_blend ()
-    { glDisable ( GL_BLEND ); }
-    static void disable_blend ( const unsigned render_target )
-    { glDisablei ( GL_BLEND, render_target ); }
+    static void enable_blend ();
+    static void enable_blend ( const unsigned render_target );
+    static void disable_blend ();
+    static void disable_blend ( const unsigned render_target );
+
+    /* blend_enabled
+     * 
+     * return true if blending is enabled for a render target
+     * 
+     * render_target: the render target to query (defaults to 0)
+     */
+    static bool blend_enabled ( const unsigned render_target = 0 ) { return blend_states.at ( render_target ).enabled; }
 
     /* blend_func
      *
@@ -233,9 +594,9 @@ public:
      * dfactor: where to recieve the destination factor from
      */
     static void blend_func ( const GLenum sfactor, const GLenum dfactor )
-    { glBlendFunc ( sfactor, dfactor ); }
+    { blend_func_separate ( sfactor, dfactor, sfactor, dfactor ); }
     static void blend_func ( const unsigned render_target, const GLenum sfactor, const GLenum dfactor )
-    { glBlendFunci ( render_target, sfactor, dfactor ); }
+    { blend_func_separate ( render_target, sfactor, dfactor, sfactor, dfactor ); }
 
     /* blend_func_separate
      *
@@ -247,10 +608,8 @@ public:
      * salphafact: where to recieve the source factor for the alpha component
      * dalphafact: where to recieve the destination factor for the alpha component
      */
-    static void blend_func_separate ( const GLenum srgbfact, const GLenum drgbfact, const GLenum salphafact, const GLenum dalphafact )
-    { glBlendFuncSeparate ( srgbfact, drgbfact, salphafact, dalphafact ); }
-    static void blend_func_separate ( const unsigned render_target, const GLenum srgbfact, const GLenum drgbfact, const GLenum salphafact, const GLenum dalphafact )
-    { glBlendFuncSeparatei ( render_target, srgbfact, drgbfact, salphafact, dalphafact ); }
+    static void blend_func_separate ( const GLenum srgbfact, const GLenum drgbfact, const GLenum salphafact, const GLenum dalphafact );
+    static void blend_func_separate ( const unsigned render_target, const GLenum srgbfact, const GLenum drgbfact, const GLenum salphafact, const GLenum dalphafact );
 
     /* blend_equation
      *
@@ -258,9 +617,20 @@ public:
      * 
      * equ: the equation to use
      */
-    static void blend_equation ( const GLenum equ ) { glBlendEquation ( equ ); }
+    static void blend_equation ( const GLenum equ )
+    { blend_equation_separate ( equ, equ ); }
     static void blend_equation ( const unsigned render_target, const GLenum equ ) 
-    { glBlendEquationi ( render_target, equ ); }
+    { blend_equation_separate ( render_target, equ, equ ); }
+
+    /* blend_equation_separate
+     * 
+     * set the equations to use for blending the rgb and alpha components
+     * 
+     * rgbequ: the equation for the rgb components
+     * alphaequ: the equation for the alpha component
+     */
+    static void blend_equation_separate ( const GLenum rgbequ, const GLenum alphaequ );
+    static void blend_equation_separate ( const unsigned render_target, const GLenum rgbequ, const GLenum alphaequ );
 
 
 
@@ -293,14 +663,52 @@ public:
     static GLenum get_front_face () { return front_face; }
     static void set_front_face ( const GLenum winding );
 
+    /* get/set_polygon_mode
+     * 
+     * get/set how polygons are rasterized for both faces
+     * 
+     * mode: GL_FILL (the default), GL_LINE or GL_POINT
+     */
+    static GLenum get_polygon_mode () { return polygon_mode; }
+    static void set_polygon_mode ( const GLenum mode );
+
+    /* get/set_color_mask
+     * 
+     * get/set which color components are written to the framebuffer
+     */
+    static const std::array<GLboolean, 4>& get_color_mask () { return color_mask; }
+    static void set_color_mask ( const GLboolean red, const GLboolean green, const GLboolean blue, const GLboolean alpha );
 
 
-    /* viewport
+
+    /* get_viewport/viewport
      *
-     * set the viewport size
+     * get/set the viewport size
+     * the viewport is unknown until first set, in which case the width and height are -1
      */
-    static void viewport ( GLint x, GLint y, GLsizei width, GLsizei height )
-    { glViewport ( x, y, width, height ); }
+    static const std::array<GLint, 4>& get_viewport () { return viewport_box; }
+    static void viewport ( GLint x, GLint y, GLsizei width, GLsizei height );
+
+    /* enable/disable_scissor_test
+     * 
+     * enable/disable scissor testing
+     */
+    static void enable_scissor_test ();
+    static void disable_scissor_test ();
+
+    /* scissor_test_enabled
+     * 
+     * return true if scissor testing is enabled
+     */
+    static bool scissor_test_enabled () { return scissor_test_state; }
+
+    /* get_scissor/scissor
+     * 
+     * get/set the scissor box
+     * the scissor box is unknown until first set, in which case the width and height are -1
+     */
+    static const std::array<GLint, 4>& get_scissor () { return scissor_box; }
+    static void scissor ( GLint x, GLint y, GLsizei width, GLsizei height );
 
 
 
@@ -334,10 +742,170 @@ public:
 
 
 
+    /* use_program
+     * 
+     * use a program by its id
+     * 
+     * id: the id of the program (0 for none)
+     */
+    static void use_program ( const GLuint id );
+
+    /* bind_vertex_array
+     * 
+     * bind a vertex array by its id
+     * as the element array buffer binding is part of the vertex array, it becomes unknown when the vertex array changes
+     * 
+     * id: the id of the vertex array (0 for none)
+     */
+    static void bind_vertex_array ( const GLuint id );
+
+    /* bind_buffer
+     * 
+     * bind a buffer to a target by its id
+     * targets which are not shadowed are always bound
+     * 
+     * target: the target to bind to
+     * id: the id of the buffer (0 for none)
+     */
+    static void bind_buffer ( const GLenum target, const GLuint id );
+
+    /* bind_buffer_base/range
+     * 
+     * bind a buffer, or a range of a buffer, to an index of an indexed target
+     * this also binds the buffer to the general binding point of the target
+     * 
+     * target: the indexed target to bind to
+     * index: the index to bind to
+     * id: the id of the buffer (0 for none)
+     * offset/size: the range of the buffer to bind
+     */
+    static void bind_buffer_base ( const GLenum target, const GLuint index, const GLuint id );
+    static void bind_buffer_range ( const GLenum target, const GLuint index, const GLuint id, const GLintptr offset, const GLsizeiptr size );
+
+    /* bind_texture
+     * 
+     * bind a texture to a target of texture unit 0, which is always the active unit
+     * used to bind textures which may not have been bound before, and so have no target yet
+     * unbinding only clears a single target, so the unit is then treated as unknown
+     * 
+     * target: the target to bind to
+     * id: the id of the texture (0 for none)
+     */
+    static void bind_texture ( const GLenum target, const GLuint id );
+
+    /* bind_texture_unit
+     * 
+     * bind a texture to a texture unit by its id
+     * 
+     * unit: the texture unit to bind to
+     * id: the id of the texture (0 for none)
+     */
+    static void bind_texture_unit ( const GLuint unit, const GLuint id );
+
+    /* bind_textures
+     * 
+     * bind textures to a range of consecutive units
+     * a single call is made if any of the units need changing
+     * 
+     * first: the first texture unit
+     * count: the number of units
+     * ids: the ids of the textures, or NULL to unbind all of the units
+     */
+    static void bind_textures ( const GLuint first, const GLsizei count, const GLuint * ids );
+
+    /* bind_sampler
+     * 
+     * bind a sampler to a texture unit by its id
+     * 
+     * unit: the texture unit to bind to
+     * id: the id of the sampler (0 for none)
+     */
+    static void bind_sampler ( const GLuint unit, const GLuint id );
+
+    /* forget_buffer/vertex_array/texture/sampler
+     * 
+     * to be called just before an object is deleted
+     * OpenGL resets any bindings of an object to 0 when it is deleted, so the same is done to the state cache
+     * no OpenGL calls are made
+     * 
+     * id: the id of the object being deleted
+     */
+    static void forget_buffer ( const GLuint id );
+    static void forget_vertex_array ( const GLuint id );
+    static void forget_texture ( const GLuint id );
+    static void forget_sampler ( const GLuint id );
+
+
+
 
 
 private:
 
+    /* struct blend_state
+     * 
+     * the blending state of a single render target
+     */
+    struct blend_state
+    {
+        bool enabled;
+        GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
+        GLenum equ_rgb, equ_alpha;
+    };
+
+    /* struct indexed_buffer_binding
+     * 
+     * a buffer bound to an index of an indexed target
+     * a size of -1 means that the whole buffer is bound
+     */
+    struct indexed_buffer_binding
+    {
+        GLuint id;
+        GLintptr offset;
+        GLsizeiptr size;
+    };
+
+    /* unknown_binding
+     * 
+     * the id recorded for a binding which is not known
+     */
+    static const GLuint unknown_binding = ~0u;
+
+    /* buffer_target_index/indexed_buffer_target_index
+     * 
+     * get the position of a buffer target in the array of buffer bindings, or -1 if the target is not shadowed
+     */
+    static int buffer_target_index ( const GLenum target );
+    static int indexed_buffer_target_index ( const GLenum target );
+
+    /* needs_call
+     * 
+     * count a request to change state, returning true if it must be passed on to OpenGL
+     * 
+     * differs: whether the requested state differs from the current state
+     */
+    static bool needs_call ( const bool differs );
+
+
+
+    /* gl_functions
+     * 
+     * the default table of functions, which call straight through to OpenGL
+     */
+    static const gl_dispatch gl_functions;
+
+    /* dispatch
+     * 
+     * the table of functions currently in use
+     */
+    static gl_dispatch dispatch;
+
+    /* num_issued_calls, num_skipped_calls
+     * 
+     * the number of state changing calls issued and skipped since the statistics were reset
+     */
+    static unsigned num_issued_calls;
+    static unsigned num_skipped_calls;
+
     /* clear_color
      *
      * the current clear color for the screen
@@ -359,6 +927,13 @@ private:
      */
     static GLboolean depth_mask;
 
+    /* depth_func
+     * 
+     * the function currently being used for depth testing
+     * defaults to GL_LESS
+     */
+    static GLenum depth_func;
+
     /* stencil_test_state
      *
      * whether stencil testing is enabled
@@ -373,6 +948,31 @@ private:
      */
     static GLuint stencil_mask;
 
+    /* stencil_function, stencil_ref, stencil_func_mask
+     * 
+     * the current stencil function, reference value and mask
+     * default to GL_ALWAYS, 0 and all bits set
+     */
+    static GLenum stencil_function;
+    static GLint stencil_ref;
+    static GLuint stencil_func_mask;
+
+    /* stencil_sfail, stencil_dpfail, stencil_dppass
+     * 
+     * the current stencil operations
+     * all default to GL_KEEP
+     */
+    static GLenum stencil_sfail;
+    static GLenum stencil_dpfail;
+    static GLenum stencil_dppass;
+
+    /* blend_states
+     * 
+     * the blending state of each render target
+     * blending defaults to disabled with factors of GL_ONE and GL_ZERO, and an equation of GL_FUNC_ADD
+     */
+    static std::array<blend_state, 8> blend_states;
+
     /* face_culling_state
      *
      * whether face culling is enabled
@@ -394,10 +994,45 @@ private:
      */
     static GLenum front_face;
 
+    /* polygon_mode
+     * 
+     * how polygons are rasterized
+     * defaults to GL_FILL
+     */
+    static GLenum polygon_mode;
+
+    /* color_mask
+     * 
+     * which color components are written
+     * defaults to all of them
+     */
+    static std::array<GLboolean, 4> color_mask;
+
+    /* viewport_box
+     * 
+     * the current viewport
+     * unknown by default
+     */
+    static std::array<GLint, 4> viewport_box;
+
+    /* scissor_test_state
+     * 
+     * whether scissor testing is enabled
+     * defaults to false
+     */
+    static bool scissor_test_state;
+
+    /* scissor_box
+     * 
+     * the current scissor box
+     * unknown by default
+     */
+    static std::array<GLint, 4> scissor_box;
+
     /* multisample_state
      *
      * whether multisampling is enabled
-     * defaults to false
+     * defaults to true, as in OpenGL
      */
     static bool multisample_state;
 
@@ -408,10 +1043,52 @@ private:
      */
     static bool framebuffer_srgb_state;
 
+    /* current_program
+     * 
+     * the id of the program in use
+     * defaults to 0
+     */
+    static GLuint current_program;
+
+    /* current_vertex_array
+     * 
+     * the id of the bound vertex array
+     * defaults to 0
+     */
+    static GLuint current_vertex_array;
+
+    /* buffer_bindings
+     * 
+     * the id of the buffer bound to each shadowed target
+     * all default to 0
+     */
+    static std::array<GLuint, 14> buffer_bindings;
+
+    /* indexed_buffer_bindings
+     * 
+     * the buffers bound to each index of each shadowed indexed target
+     * indices which have not been bound are 0
+     */
+    static std::array<std::vector<indexed_buffer_binding>, 4> indexed_buffer_bindings;
+
+    /* texture_units
+     * 
+     * the id of the texture bound to each texture unit
+     * all default to 0
+     */
+    static std::array<GLuint, 80> texture_units;
+
+    /* sampler_units
+     * 
+     * the id of the sampler bound to each texture unit
+     * all default to 0
+     */
+    static std::array<GLuint, 80> sampler_units;
+
 
 };
 
 
 
 /* #ifndef GLHELPER_RENDER_HPP_INCLUDED */
-#endif
\ No newline at end of file
+#endif
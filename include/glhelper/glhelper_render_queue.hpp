@@ -0,0 +1,402 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * include/glhelper/glhelper_render_queue.hpp
+ *
+ * constructs for recording draws and submitting them in an order which minimises state changes
+ * notable constructs include:
+ *
+ *
+ *
+ * STRUCT GLH::CORE::DRAW_PACKET
+ *
+ * everything needed to make a single draw: the program, vao, index range and instance count,
+ * as well as a material and depth to sort by, and a draw source to set the uniforms of the draw just before it is made
+ * the render state of a packet is not stored in the packet itself, but interned by the queue it is recorded into
+ *
+ *
+ *
+ * CLASS GLH::CORE::DRAW_SOURCE
+ *
+ * abstract base class for objects which record packets into a render queue (e.g. glh::model::model)
+ * prepare_packet is called once the program and vao of a packet have been bound, but before it is drawn,
+ * and is given the previous packet drawn, so that uniforms which have not changed (such as the material) need not be set again
+ *
+ *
+ *
+ * CLASS GLH::CORE::RENDER_QUEUE
+ *
+ * a list of draw packets for a single rendering pass
+ * each packet is given a 64-bit sort key, and the packets are ordered with an LSD radix sort over the bytes of the keys which differ
+ * by default packets are sorted by render state, then program, then material, then front to back, which minimises the state changes of opaque passes
+ * back-to-front queues are instead sorted back to front, then by render state, program and material, as is required by transparent passes
+ * submit then draws the packets in order, only applying render states, using programs and binding vaos when they change
+ * recording makes no OpenGL calls, so a pass can be recorded from several worker threads at once, each into its own queue
+ * (culling while recording is also thread-safe, but a depth pyramid must be read back on the thread with the context before recording starts)
+ * the queues are then merged into one on the thread with the context before the pass is submitted
+ *
+ *
+ *
+ * CLASS GLH::EXCEPTION::RENDER_QUEUE_EXCEPTION
+ *
+ * thrown when an error occurs in one of the render queue methods (e.g. recording more render states than the sort key can hold)
+ *
+ */
+
+
+
+/* HEADER GUARD */
+#ifndef GLHELPER_RENDER_QUEUE_HPP_INCLUDED
+#define GLHELPER_RENDER_QUEUE_HPP_INCLUDED
+
+
+
+/* INCLUDES */
+
+/* include core headers */
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+/* include glhelper_core.hpp */
+#include <glhelper/glhelper_core.hpp>
+
+/* include glhelper_exception.hpp */
+#include <glhelper/glhelper_exception.hpp>
+
+/* include glhelper_matrix.hpp */
+#include <glhelper/glhelper_matrix.hpp>
+
+/* include glhelper_vector.hpp */
+#include <glhelper/glhelper_vector.hpp>
+
+/* include glhelper_transform.hpp */
+#include <glhelper/glhelper_transform.hpp>
+
+/* include glhelper_buffer.hpp */
+#include <glhelper/glhelper_buffer.hpp>
+
+/* include glhelper_shader.hpp */
+#include <glhelper/glhelper_shader.hpp>
+
+/* include glhelper_render.hpp */
+#include <glhelper/glhelper_render.hpp>
+
+
+
+/* NAMESPACE DECLARATIONS */
+
+namespace glh
+{
+    namespace core
+    {
+        /* struct draw_packet
+         *
+         * a single recorded draw
+         */
+        struct draw_packet;
+
+        /* class draw_source
+         *
+         * abstract base class for objects which record draw packets
+         */
+        class draw_source;
+
+        /* class render_queue
+         *
+         * sorts and submits the draw packets of a rendering pass
+         */
+        class render_queue;
+    }
+
+    namespace exception
+    {
+        /* class render_queue_exception : exception
+         *
+         * exception relating to render queues
+         */
+        class render_queue_exception;
+    }
+}
+
+
+
+/* DRAW_PACKET DEFINITION */
+
+/* struct draw_packet
+ *
+ * a single recorded draw
+ */
+struct glh::core::draw_packet
+{
+    /* the program and vao to draw with */
+    const program * prog = NULL;
+    const vao * vertex_arrays = NULL;
+
+    /* the material of the draw, which is only used to group packets, so may be any pointer (or NULL) */
+    const void * material = NULL;
+
+    /* the distance of the draw from the viewer */
+    float depth = 0.0f;
+
+    /* the primitive mode, number of vertices or indices and the type of the indices
+     * a type of GL_NONE means that the packet is drawn with draw_arrays rather than draw_elements
+     */
+    GLenum mode = GL_TRIANGLES;
+    GLsizei count = 0;
+    GLenum type = GL_NONE;
+
+    /* the start vertex or index and the number of instances */
+    GLsizeiptr start_index = 0;
+    unsigned instances = 1;
+
+    /* the source which recorded the packet, and data, a transformation and flags for the source to prepare the packet with */
+    const draw_source * source = NULL;
+    const void * source_data = NULL;
+    math::fmat4 transform = math::identity<4, float> ();
+    unsigned source_flags = 0;
+
+    /* the index of the render state of the packet in the queue it was recorded into (set by the queue) */
+    unsigned state_index = 0;
+};
+
+
+
+/* DRAW_SOURCE DEFINITION */
+
+/* class draw_source
+ *
+ * abstract base class for objects which record draw packets
+ */
+class glh::core::draw_source
+{
+public:
+
+    /* default constructor */
+    draw_source () = default;
+
+    /* default copy constructor */
+    draw_source ( const draw_source& other ) = default;
+
+    /* default copy assignment operator */
+    draw_source& operator= ( const draw_source& other ) = default;
+
+    /* virtual default destructor */
+    virtual ~draw_source () = default;
+
+
+
+    /* pure virtual prepare_packet
+     *
+     * set any uniforms a packet needs before it is drawn
+     * the render state, program and vao of the packet are already applied when this is called
+     *
+     * packet: the packet about to be drawn
+     * previous: the packet drawn before it in the same submission, or NULL if it is the first
+     */
+    virtual void prepare_packet ( const draw_packet& packet, const draw_packet * previous ) const = 0;
+};
+
+
+
+/* RENDER_QUEUE DEFINITION */
+
+/* class render_queue
+ *
+ * sorts and submits the draw packets of a rendering pass
+ */
+class glh::core::render_queue
+{
+public:
+
+    /* constructor
+     *
+     * create an empty queue
+     *
+     * _back_to_front: true if the packets should be sorted back to front before render state, program and material, as for transparent passes (defaults to false)
+     */
+    explicit render_queue ( const bool _back_to_front = false );
+
+    /* default copy constructor */
+    render_queue ( const render_queue& other ) = default;
+
+    /* default move constructor */
+    render_queue ( render_queue&& other ) = default;
+
+    /* default copy assignment operator */
+    render_queue& operator= ( const render_queue& other ) = default;
+
+    /* default move assignment operator */
+    render_queue& operator= ( render_queue&& other ) = default;
+
+    /* default destructor */
+    ~render_queue () = default;
+
+
+
+    /* record
+     *
+     * record a packet into the queue
+     * no OpenGL calls are made, so different queues can be recorded into from different threads at once
+     *
+     * state: the render state to draw the packet with
+     * packet: the packet to record (the program and vao must not be NULL, and the state index is ignored)
+     */
+    void record ( const render_state& state, const draw_packet& packet );
+
+    /* merge
+     *
+     * move the packets of another queue to the end of this one, leaving the other queue empty
+     *
+     * other: the queue to merge into this one
+     */
+    void merge ( render_queue& other );
+
+    /* clear
+     *
+     * remove all packets and render states from the queue, ready for the next frame
+     * the statistics are not reset
+     */
+    void clear ();
+
+
+
+    /* sort
+     *
+     * sort the packets by their keys
+     * this is called by submit if the queue is not already sorted
+     */
+    void sort ();
+
+    /* submit
+     *
+     * draw the packets in sorted order, only changing render states, programs and vaos when they differ from the packet before
+     * the vao of the last packet is unbound afterwards
+     */
+    void submit ();
+
+
+
+    /* set/get_view_position
+     *
+     * set or get the position of the viewer, which draw sources use to find the depth of their packets
+     */
+    void set_view_position ( const math::vec3& _view_position ) { view_position = _view_position; }
+    const math::vec3& get_view_position () const { return view_position; }
+
+    /* is_back_to_front
+     *
+     * returns true if the queue sorts its packets back to front
+     */
+    bool is_back_to_front () const { return back_to_front; }
+
+    /* get_num_packets/render_states
+     *
+     * get the number of packets and distinct render states currently recorded
+     */
+    unsigned get_num_packets () const { return packets.size (); }
+    unsigned get_num_render_states () const { return states.size (); }
+
+    /* get_num_submitted_packets/state_changes/program_changes/vao_changes
+     *
+     * get the number of packets drawn by submit, and the number of times the render state, program and vao were changed between them
+     */
+    unsigned get_num_submitted_packets () const { return num_submitted_packets; }
+    unsigned get_num_state_changes () const { return num_state_changes; }
+    unsigned get_num_program_changes () const { return num_program_changes; }
+    unsigned get_num_vao_changes () const { return num_vao_changes; }
+
+    /* reset_submit_statistics
+     *
+     * reset the number of submitted packets and changes to zero
+     */
+    void reset_submit_statistics ();
+
+
+
+private:
+
+    /* whether the packets are sorted back to front */
+    bool back_to_front;
+
+    /* the position of the viewer */
+    math::vec3 view_position;
+
+    /* the recorded packets, and the distinct render states they refer to */
+    std::vector<draw_packet> packets;
+    std::vector<render_state> states;
+
+    /* the sort keys of the packets, the sorted order of the packets, and whether that order is up to date */
+    std::vector<std::uint64_t> keys;
+    std::vector<unsigned> order;
+    bool sorted;
+
+    /* submission statistics */
+    unsigned num_submitted_packets;
+    unsigned num_state_changes;
+    unsigned num_program_changes;
+    unsigned num_vao_changes;
+
+
+
+    /* intern_state
+     *
+     * get the index of a render state in the queue, adding it if it is not already present
+     *
+     * state: the render state to find
+     *
+     * return: the index of the state
+     */
+    unsigned intern_state ( const render_state& state );
+
+    /* depth_bits
+     *
+     * get the 24 most significant bits of a non-negative depth, which sort in the same order as the depths themselves
+     *
+     * depth: the depth to convert (negative depths are treated as zero)
+     */
+    static std::uint64_t depth_bits ( const float depth );
+
+};
+
+
+
+/* RENDER_QUEUE_EXCEPTION DEFINITION */
+
+/* class render_queue_exception : exception
+ *
+ * exception relating to render queues
+ */
+class glh::exception::render_queue_exception : public exception
+{
+public:
+
+    /* full constructor
+     *
+     * __what: description of the exception
+     */
+    explicit render_queue_exception ( const std::string& __what )
+        : exception { __what }
+    {}
+
+    /* default zero-parameter constructor
+     *
+     * construct render_queue_exception with no descrption
+     */
+    render_queue_exception () = default;
+
+    /* default everything else and inherits what () function */
+
+};
+
+
+
+/* #ifndef GLHELPER_RENDER_QUEUE_HPP_INCLUDED */
+#endif
@@ -16,10 +16,21 @@
  * base class for any type of shader
  * the type of shader and source code paths are passed in the constructor, but the shader is not compiled yet
  * shaders can be attached to a program without being compiled, however they must be compiled for the program to be linked
+ * compile_async submits the shader to the driver without waiting for the result, which is then checked by compile or by linking a program using the shader
  * 
+ * included files are preprocessed: #include "path" directives are replaced by the file at path, relative to the including file
+ * every file is included at most once into each shader, so files need no include guards, and may include what they depend on
+ * #define directives can be injected from C++ with define or add_defines, which go straight after the version directive, so apply to every file
+ * shader files can then wrap constants in #ifndef, so that they can be overridden to keep them in sync with C++ or to build specialised variants
+ * the contents of files are cached in memory across all shaders, and only read again if their last write time changes
  * 
+ * recompile_async rebuilds the source from the same files, defines and source, and submits it to a new shader object, leaving the current one untouched
+ * finish_recompile then swaps the new object in if it compiled, or deletes it and keeps the current object and source if it failed
+ * programs already linked with the old object are unaffected, and must be relinked to use the new one
  * 
- * CLASS GLH::CORE::V/G/FSHADER
+ * 
+ * 
+ * CLASS GLH::CORE::V/G/F/CSHADER
  * 
  * derivations of the shader base class to set defaults for the shader type
  * no more complicated than that
@@ -33,12 +44,23 @@
  * 
  * 
  * 
+ * STRUCT GLH::CORE::UNIFORM_ID
+ * 
+ * the name of a uniform hashed at compile time, created with the _uid literal (e.g. "material.shininess"_uid, after using namespace glh::core::literals)
+ * programs and struct uniforms can look up uniforms by id, which never allocates or compares strings once the uniform has been found
+ * the hash is 64-bit FNV-1a, which can be continued from a prefix, so struct uniforms look up their members by continuing from the hash of their own name
+ * 
+ * 
+ * 
  * CLASS GLH::CORE::UNIFORM
  * 
  * class for an endpoint uniform
  * a value is given to the uniform via the set_... methods
  * if the uniform is in the default block, glUniform... functions will be used to set the value(s)
  * if the unfirom is not in the default block, the ubo responsible for its data storage is located, and modified accordingly
+ * the program shadows the last value written to each location of its default block, so setting a uniform to the value it already has makes no call
+ * writes to blocks are similarly compared against the staging image of the ubo, so unchanged values are never uploaded
+ * the number of calls made and skipped are counted across all uniforms, to measure the effect on static scenes
  * 
  * 
  * 
@@ -65,6 +87,49 @@
  * uniforms in the program are extracted using the member functions get_..._uniform
  * the program class remembers loactions of uniforms, although it would still be better to not keep running get_..._uniform
  * hence many constructs throught GLHelper use uniform caching to avoid this
+ * on linking, every active uniform is resolved into a flat open-addressing table keyed by the hash of its name, which get_uniform with a uniform_id then probes
+ * uniforms missing from the table (e.g. elements of arrays which are not listed as active) are looked up by name once, then added to the table
+ * 
+ * if a binary cache directory is set, compile_and_link first looks for a binary of the program in it, which is keyed by a hash of the sources of the shaders and the driver
+ * if there is no binary, or the driver rejects it, the program is compiled and linked as usual and its binary is written to the cache for next time
+ * since any defines are part of the sources, programs which differ only by their defines are cached separately
+ * 
+ * compile_and_link_async submits the compilation of the shaders and the link of the program without querying the status of either
+ * is_ready then polls the program, finishing the link once the driver reports it complete, or wait_until_ready blocks until then
+ * with GL_KHR_parallel_shader_compile, the driver compiles in background threads, so is_ready never blocks
+ * without it, is_ready finishes the link straight away, which blocks, however the driver still sees every compilation before being asked for any result
+ * 
+ * relink_async links the current shader objects into a new program object, while the current program object stays in use
+ * finish_relink then swaps the new object in if it linked, or deletes it and keeps the current one running if it failed
+ * on a swap, the values of the default block uniforms and the uniform block bindings are copied into the new object,
+ * and every uniform already extracted from the program is refreshed in place, so references to them (and any caches built from them) stay valid
+ * 
+ * 
+ * 
+ * CLASS GLH::CORE::COMPUTE_PROGRAM
+ * 
+ * a program made from a single compute shader, which is compiled, linked, cached and reloaded in exactly the same way as any other program
+ * dispatch uses the program and runs a number of work groups through renderer::dispatch_compute, and dispatch_indirect reads the number from a buffer
+ * dispatch_invocations instead takes the number of invocations needed in each dimension, and rounds up to whole work groups of the size declared in the shader
+ * the results of a dispatch are not visible to other commands until the appropriate memory barrier is issued with glh::core::sync
+ * 
+ * 
+ * 
+ * CLASS GLH::CORE::PROGRAM_SET
+ * 
+ * a set of programs to be compiled and linked together
+ * compile_all submits every program before waiting on any of them, so that the compilation of all of the shaders overlaps
+ * compile_all can also compile each program in turn instead, to compare the startup time of both paths
+ * 
+ * 
+ * 
+ * CLASS GLH::CORE::PROGRAM_REGISTRY
+ * 
+ * a process-wide registry of programs, keyed by the source files of their shaders and any defines
+ * get returns a shared pointer to a program, which is only read from disk, compiled and linked if no identical program is still alive
+ * get_compute does the same for compute programs
+ * the registry owns the shaders of each program, and only keeps weak pointers, so a program is destroyed once the last shared pointer to it is
+ * this means that constructs which each need the same internal program (e.g. the alpha test program of every model) share a single program
  * 
  * 
  * 
@@ -92,10 +157,19 @@
 /* INCLUDES */
 
 /* include core headers */
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
 #include <fstream>
+#include <functional>
 #include <initializer_list>
+#include <iomanip>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <sstream>
 #include <string>
 #include <type_traits>
 #include <vector>
@@ -142,13 +216,41 @@ namespace glh
          */
         class shader;
 
-        /* class v/g/fshader : shader
+        /* class v/g/f/cshader : shader
          *
          * derived classes for specific shader types
          */
         class vshader;
         class gshader;
         class fshader;
+        class cshader;
+
+
+
+        /* struct uniform_id
+         *
+         * a uniform name hashed at compile time
+         */
+        struct uniform_id;
+
+        /* hash_uniform_name
+         *
+         * hash a uniform name with 64-bit FNV-1a
+         * 
+         * name: the characters to hash
+         * length: the number of characters
+         * seed: the hash to continue from (defaults to the FNV-1a offset basis, for the start of a name)
+         */
+        constexpr std::uint64_t hash_uniform_name ( const char * name, const std::size_t length, const std::uint64_t seed = 14695981039346656037ull );
+
+        namespace literals
+        {
+            /* operator""_uid
+             *
+             * create a uniform id from a string literal
+             */
+            constexpr uniform_id operator""_uid ( const char * name, const std::size_t length );
+        }
 
 
 
@@ -193,6 +295,24 @@ namespace glh
          */
         class program;
 
+        /* class compute_program : program
+         *
+         * program made from a compute shader
+         */
+        class compute_program;
+
+        /* class program_set
+         *
+         * a set of programs compiled and linked together
+         */
+        class program_set;
+
+        /* class program_registry
+         *
+         * process-wide registry of shared programs
+         */
+        class program_registry;
+
     }
 
     namespace math
@@ -284,6 +404,7 @@ namespace glh
 /* comparison operators for uniform types
  *
  * returns true if the objects refer to the same uniform
+ * the hashes of the names are compared, rather than the names themselves
  */
 bool operator== ( const glh::core::uniform& lhs, const glh::core::uniform& rhs );
 bool operator!= ( const glh::core::uniform& lhs, const glh::core::uniform& rhs );
@@ -341,14 +462,103 @@ public:
      */
     void include_source ( const std::string& source_to_include );
 
+    /* define
+     *
+     * add a #define directive after the version directive, so that it applies to all of the source
+     *
+     * name: the name of the macro
+     * value: the value of the macro (defaults to none)
+     */
+    void define ( const std::string& name, const std::string& value = "" );
+
+    /* add_defines
+     *
+     * add source (e.g. several #define directives) after the version directive and any previous defines
+     */
+    void add_defines ( const std::string& defines );
+
+    /* get_included_files
+     *
+     * get the paths of every file included into the shader, including those found in #include directives
+     */
+    const std::vector<std::string>& get_included_files () const { return included_files; }
+
+
+
+    /* get_num_source_cache_hits/misses
+     *
+     * get the number of file reads which were served by the source cache, and the number which had to read the file from disk
+     */
+    static unsigned get_num_source_cache_hits () { return num_source_cache_hits; }
+    static unsigned get_num_source_cache_misses () { return num_source_cache_misses; }
+
+    /* reset_source_cache_statistics
+     *
+     * reset the source cache hit and miss counts
+     */
+    static void reset_source_cache_statistics () { num_source_cache_hits = 0; num_source_cache_misses = 0; }
+
+    /* clear_source_cache
+     *
+     * forget the contents of every cached file
+     */
+    static void clear_source_cache () { source_cache.clear (); }
+
 
 
     /* compile
      * 
-     * compiles the shader
+     * compiles the shader, or if a compilation has been submitted by compile_async, waits for it to finish
+     * throws if compilation fails
      */
     void compile ();
 
+    /* compile_async
+     *
+     * submit the shader for compilation without waiting for the result
+     * the result is checked by compile, or when a program using the shader is linked
+     */
+    void compile_async ();
+
+    /* is_compile_complete
+     *
+     * returns true if the result of a submitted compilation can be checked without blocking
+     * always true if no compilation is pending, or if parallel shader compile is not supported
+     */
+    bool is_compile_complete () const;
+
+
+
+    /* recompile_async
+     *
+     * rebuild the source from the same files, defines and source, reading any files which have changed, and submit it to a new shader object
+     * the current shader object and source are left in place until finish_recompile
+     * throws if a file cannot be read, or if a recompilation is already pending
+     */
+    void recompile_async ();
+
+    /* is_recompile_complete
+     *
+     * returns true if the result of a submitted recompilation can be checked without blocking
+     * always true if no recompilation is pending, or if parallel shader compile is not supported
+     */
+    bool is_recompile_complete () const;
+
+    /* finish_recompile
+     *
+     * check the result of a submitted recompilation, blocking if it is not complete
+     * on success the new shader object and source replace the current ones, otherwise the error is logged and the new object deleted
+     *
+     * return: true if the shader was recompiled successfully
+     */
+    bool finish_recompile ();
+
+    /* is_recompile_pending
+     *
+     * returns true if a recompilation has been submitted by recompile_async, but its result not yet checked
+     */
+    bool is_recompile_pending () const { return recompile_id != 0; }
+
 
 
     /* get_source
@@ -363,6 +573,12 @@ public:
      */
     bool is_compiled () const { return compiled; }
 
+    /* is_compile_pending
+     *
+     * returns true if a compilation has been submitted by compile_async, but its result not yet checked
+     */
+    bool is_compile_pending () const { return compile_pending; }
+
 
 
 private:
@@ -370,9 +586,99 @@ private:
     /* shader source */
     std::string source;
 
+    /* the position in the source after the version directive and any defines */
+    std::size_t defines_end;
+
+    /* the normalised paths of the files included into the shader */
+    std::vector<std::string> included_files;
+
     /* true if has been compiled */
     bool compiled;
 
+    /* true if a compilation has been submitted but not checked */
+    bool compile_pending;
+
+    /* struct source_part
+     *
+     * a file included into the shader, or source included directly if the path is empty
+     */
+    struct source_part
+    {
+        std::string path;
+        std::string source;
+    };
+
+    /* the parts of the source after the defines, in the order they were added, from which the source can be rebuilt */
+    std::vector<source_part> source_parts;
+
+    /* the shader object, source and included files of a submitted recompilation (the id is 0 if none is pending) */
+    GLuint recompile_id;
+    std::string recompile_source;
+    std::vector<std::string> recompile_included_files;
+
+    /* struct cached_source_file
+     *
+     * the contents of a file and its last write time when they were read
+     */
+    struct cached_source_file
+    {
+        std::filesystem::file_time_type write_time;
+        std::string contents;
+    };
+
+    /* source_cache
+     *
+     * the contents of files read by any shader, by normalised path
+     */
+    static std::map<std::string, cached_source_file> source_cache;
+
+    /* num_source_cache_hits
+     * num_source_cache_misses
+     *
+     * source cache statistics across all shaders
+     */
+    static unsigned num_source_cache_hits;
+    static unsigned num_source_cache_misses;
+
+
+
+    /* include_file
+     *
+     * preprocess a file and append it to a source, unless it has already been included
+     *
+     * path: the path of the file
+     * target_source: the source to append to
+     * target_included_files: the normalised paths of the files already included into the source
+     */
+    static void include_file ( const std::string& path, std::string& target_source, std::vector<std::string>& target_included_files );
+
+    /* log_compile_failure
+     *
+     * print the info log of a shader object which failed to compile to stderr, and write the source which failed to the log file
+     *
+     * shader_id: the shader object
+     * failed_source: the source it was compiled from
+     */
+    static void log_compile_failure ( const GLuint shader_id, const std::string& failed_source );
+
+    /* read_source_file
+     *
+     * get the contents of a file through the source cache, throwing if it cannot be read
+     *
+     * path: the normalised path of the file
+     */
+    static const std::string& read_source_file ( const std::string& path );
+
+    /* parse_include_directive
+     *
+     * get the path of an #include directive
+     *
+     * line: a line of source
+     *
+     * return: the path in quotes or angle brackets, or an empty string if the line is not an #include directive
+     */
+    static std::string parse_include_directive ( const std::string& line );
+
 };
 
 
@@ -485,6 +791,42 @@ public:
 
 
 
+/* CSHADER DEFINITION */
+
+/* class cshader
+ *
+ * derived class for a compute shader
+ */
+class glh::core::cshader : public shader
+{
+public:
+
+    /* no source constructor */
+    cshader ()
+        : shader { GL_COMPUTE_SHADER }
+    {}
+
+    /* multi-source constructor */
+    explicit cshader ( std::initializer_list<std::string> paths )
+        : shader { GL_COMPUTE_SHADER, paths }
+    {}
+
+    /* deleted copy constructor */
+    cshader ( const cshader& other ) = delete;
+
+    /* default move constructor */
+    cshader ( cshader&& other ) = default;
+
+    /* deleted copy asignment operator */
+    cshader& operator= ( const cshader& other ) = delete;
+
+    /* default destructor */
+    ~cshader () = default;
+
+};
+
+
+
 /* UNIFORM_ALIGNED_VECTOR DEFINITION */
 
 /* class uniform_aligned_vector
@@ -662,6 +1004,44 @@ template<class T, class T0, class ...Ts> struct glh::meta::is_pack_same
 
 
 
+/* UNIFORM_ID DEFINITION */
+
+/* struct uniform_id
+ *
+ * a uniform name hashed at compile time
+ */
+struct glh::core::uniform_id
+{
+    /* the hash of the name */
+    std::uint64_t hash;
+
+    /* the name and its length, used if the uniform has to be looked up by name */
+    const char * name;
+    std::size_t length;
+};
+
+/* hash_uniform_name
+ *
+ * hash a uniform name with 64-bit FNV-1a
+ */
+constexpr std::uint64_t glh::core::hash_uniform_name ( const char * name, const std::size_t length, const std::uint64_t seed )
+{
+    std::uint64_t hash = seed;
+    for ( std::size_t i = 0; i < length; ++i ) { hash ^= static_cast<unsigned char> ( name [ i ] ); hash *= 1099511628211ull; }
+    return hash;
+}
+
+/* operator""_uid
+ *
+ * create a uniform id from a string literal
+ */
+constexpr glh::core::uniform_id glh::core::literals::operator""_uid ( const char * name, const std::size_t length )
+{
+    return uniform_id { hash_uniform_name ( name, length ), name, length };
+}
+
+
+
 /* UNIFORM_STORAGE DEFINITION */
 
 /* class uniform_storage : uniform_storage
@@ -710,6 +1090,12 @@ public:
     T& get ( const std::string& postfix ) { return __get ( postfix ); }
     const T& get ( const std::string& postfix ) const { return __get ( postfix ); }
 
+    /* refresh
+     *
+     * refresh every uniform in the storage after the program has been relinked
+     */
+    void refresh ();
+
 
 
     /* get_prefix
@@ -827,6 +1213,13 @@ public:
      */
     bool is_set_valid () const;
 
+    /* refresh
+     *
+     * get the location, index, offset and block index of the uniform again after the program has been relinked
+     * if the uniform is no longer active, it keeps its type but is given no location or block, so setting it does nothing
+     */
+    void refresh ();
+
 
 
     /* get_name
@@ -835,6 +1228,12 @@ public:
      */
     const std::string& get_name () const { return name; }
 
+    /* get_name_hash
+     *
+     * return the hash of the name of the uniform
+     */
+    std::uint64_t get_name_hash () const { return name_hash; }
+
     /* get_program
      *
      * return the program associated with the uniform
@@ -862,27 +1261,52 @@ public:
 
 
 
+    /* get_num_uniform_calls
+     * get_num_skipped_uniform_calls
+     *
+     * get the number of glUniform... calls made across all uniforms in the default block, and the number skipped as the value was unchanged
+     */
+    static unsigned get_num_uniform_calls () { return num_uniform_calls; }
+    static unsigned get_num_skipped_uniform_calls () { return num_skipped_uniform_calls; }
+
+    /* reset_uniform_call_statistics
+     *
+     * reset the uniform call counts
+     */
+    static void reset_uniform_call_statistics () { num_uniform_calls = 0; num_skipped_uniform_calls = 0; }
+
+
+
 protected:
 
-    /* store the name of the uniform */
+    /* store the name of the uniform, and its hash */
     const std::string name;
+    const std::uint64_t name_hash;
 
     /* the program the uniform is associated with */
     program& prog;
 
     /* the location and index of the uniform */
-    const GLint location;
-    const GLuint index;
+    GLint location;
+    GLuint index;
 
     /* size and offset of the uniform */
-    const GLint size;
-    const GLint offset;
+    GLint size;
+    GLint offset;
 
     /* the index of the uniform block associated with this uniform */
-    const GLint block_index;
+    GLint block_index;
 
     /* the type of the uniform in the shader */
-    const GLint uniform_type;
+    GLint uniform_type;
+
+    /* num_uniform_calls
+     * num_skipped_uniform_calls
+     *
+     * uniform call statistics across all uniforms
+     */
+    static unsigned num_uniform_calls;
+    static unsigned num_skipped_uniform_calls;
 
 
 };
@@ -910,6 +1334,7 @@ public:
      */
     array_uniform ( const std::string& _name, program& _prog )
         : name { _name }
+        , name_hash { hash_uniform_name ( _name.data (), _name.size () ) }
         , prog { _prog }
     {}
 
@@ -946,6 +1371,12 @@ public:
     T& operator[] ( const unsigned index ) { return __at ( index ); }
     const T& operator[] ( const unsigned index ) const { return __at ( index ); }
 
+    /* refresh
+     *
+     * refresh every uniform extracted from the array after the program has been relinked
+     */
+    void refresh () { for ( T& uni: uniforms ) uni.refresh (); }
+
 
 
     /* get_name
@@ -954,6 +1385,12 @@ public:
      */
     const std::string& get_name () const { return name; }
 
+    /* get_name_hash
+     *
+     * return the hash of the name of the uniform
+     */
+    std::uint64_t get_name_hash () const { return name_hash; }
+
     /* get_program
      *
      * return the program associated with the uniform
@@ -965,8 +1402,9 @@ public:
 
 protected:
 
-    /* store the name of the uniform */
+    /* store the name of the uniform, and its hash */
     const std::string name;
+    const std::uint64_t name_hash;
 
     /* the program the uniform is associated with */
     program& prog;
@@ -1003,6 +1441,8 @@ public:
      */
     struct_uniform ( const std::string& _name, program& _prog )
         : name { _name }
+        , name_hash { hash_uniform_name ( _name.data (), _name.size () ) }
+        , member_hash_seed { hash_uniform_name ( ".", 1, name_hash ) }
         , prog { _prog }
         , uniforms { _name + ".", _prog }, struct_uniforms { _name + ".", _prog }
         , uniform_array_uniforms { _name + ".", _prog }, struct_array_uniforms { _name + ".", _prog }
@@ -1031,6 +1471,15 @@ public:
     const uniform& get_uniform ( const std::string& member ) const { return uniforms.get ( member ); }
     struct_uniform& get_struct_uniform ( const std::string& member ) { return struct_uniforms.get ( member ); }
     const struct_uniform& get_struct_uniform ( const std::string& member ) const { return struct_uniforms.get ( member ); }
+
+    /* get_uniform by id
+     *
+     * get a member of the struct through the uniform table of the program
+     * the hash of the full name is continued from the hash of the name of the struct, and the name of the struct is passed on rather than a prefix,
+     * so no strings are built unless the uniform is not yet in the table
+     */
+    uniform& get_uniform ( const uniform_id& member );
+    const uniform& get_uniform ( const uniform_id& member ) const;
     
     /* pure get_..._array_uniform
      *
@@ -1045,6 +1494,12 @@ public:
     struct_2d_array_uniform& get_struct_2d_array_uniform ( const std::string& member ) { return struct_2d_array_uniforms.get ( member ); }
     const struct_2d_array_uniform& get_struct_2d_array_uniform ( const std::string& member ) const { return struct_2d_array_uniforms.get ( member ); }
 
+    /* refresh
+     *
+     * refresh every member extracted from the struct after the program has been relinked
+     */
+    void refresh ();
+
 
 
     /* get_name
@@ -1053,6 +1508,12 @@ public:
      */
     const std::string& get_name () const { return name; }
 
+    /* get_name_hash
+     *
+     * return the hash of the name of the uniform
+     */
+    std::uint64_t get_name_hash () const { return name_hash; }
+
     /* get_program
      *
      * return the program associated with the uniform
@@ -1064,8 +1525,10 @@ public:
 
 protected:
 
-    /* store the name of the uniform */
+    /* store the name of the uniform, its hash, and the hash of the name followed by a '.', which the hashes of members continue from */
     const std::string name;
+    const std::uint64_t name_hash;
+    const std::uint64_t member_hash_seed;
 
     /* the program the uniform is associated with */
     program& prog;
@@ -1144,16 +1607,122 @@ public:
     /* link
      *
      * link the shader program
-     * will throw if any of the shaders are not already compiled
+     * will throw if any of the shaders are neither compiled nor pending compilation
      */
     void link ();
 
+    /* link_async
+     *
+     * submit the link of the shader program without waiting for the result
+     * will throw if any of the shaders are neither compiled nor pending compilation
+     */
+    void link_async ();
+
     /* compile_and_link
      *
      * compile the shaders then link them
+     * if a binary cache directory is set, the program is loaded from the cache instead if possible, and otherwise added to it
      */
     void compile_and_link ();
 
+    /* compile_and_link_async
+     *
+     * submit the compilation of the shaders and the link of the program without waiting for either
+     * shaders already pending compilation (e.g. shared with another program) are not submitted again
+     * if a binary cache directory is set, the program is loaded from the cache instead if possible, and otherwise added to it once linked
+     */
+    void compile_and_link_async ();
+
+    /* is_ready
+     *
+     * returns true if the program is linked and ready to use
+     * if a link is pending and the driver reports it complete, the link is finished, throwing if it or any of the shaders failed
+     * if parallel shader compile is not supported, a pending link is finished straight away, which blocks
+     */
+    bool is_ready ();
+
+    /* wait_until_ready
+     *
+     * finish any pending link, blocking until the driver is done
+     * throws if the link or any of the shaders failed
+     */
+    void wait_until_ready ();
+
+    /* is_link_pending
+     *
+     * returns true if a link has been submitted but not finished
+     */
+    bool is_link_pending () const { return link_pending; }
+
+
+
+    /* relink_async
+     *
+     * submit a link of the current shader objects (e.g. after they have been recompiled) into a new program object
+     * the current program object stays in use until finish_relink
+     * throws if a relink is already pending, or if any shader is not compiled (e.g. the program was loaded from the binary cache, so never compiled its shaders)
+     */
+    void relink_async ();
+
+    /* is_relink_complete
+     *
+     * returns true if the result of a submitted relink can be checked without blocking
+     * always true if no relink is pending, or if parallel shader compile is not supported
+     */
+    bool is_relink_complete () const;
+
+    /* finish_relink
+     *
+     * check the result of a submitted relink, blocking if it is not complete
+     * on success the new program object replaces the current one, taking its uniform values and block bindings, and every uniform is refreshed
+     * on failure the error is logged, the new object deleted and the current one kept
+     *
+     * return: true if the program was relinked successfully
+     */
+    bool finish_relink ();
+
+    /* is_relink_pending
+     *
+     * returns true if a relink has been submitted but not finished
+     */
+    bool is_relink_pending () const { return relink_id != 0; }
+
+    /* get_shaders
+     *
+     * get the shaders of the program: the vertex shader, the geometry shader if there is one, then the fragment shader
+     * or just the compute shader of a compute program
+     */
+    std::vector<shader *> get_shaders () const;
+
+
+
+    /* is_loaded_from_binary_cache
+     *
+     * returns true if the program was last loaded from the binary cache, rather than compiled and linked
+     */
+    bool is_loaded_from_binary_cache () const { return loaded_from_binary_cache; }
+
+    /* set/get_binary_cache_directory
+     *
+     * set or get the directory of the program binary cache, which is created if it does not exist
+     * an empty path disables the cache, which is the default
+     */
+    static void set_binary_cache_directory ( const std::string& directory );
+    static const std::string& get_binary_cache_directory () { return binary_cache_directory; }
+
+    /* get_num_binary_cache_hits/misses
+     *
+     * get the number of programs loaded from the binary cache, and the number which had to be compiled and linked while the cache was enabled
+     */
+    static unsigned get_num_binary_cache_hits () { return num_binary_cache_hits; }
+    static unsigned get_num_binary_cache_misses () { return num_binary_cache_misses; }
+
+    /* reset_binary_cache_statistics
+     *
+     * reset the binary cache hit and miss counts
+     */
+    static void reset_binary_cache_statistics () { num_binary_cache_hits = 0; num_binary_cache_misses = 0; }
+
 
 
     /* get_(struct_)uniform
@@ -1182,6 +1751,48 @@ public:
     struct_2d_array_uniform& get_struct_2d_array_uniform ( const std::string& name ) { return struct_2d_array_uniforms.get ( name ); }
     const struct_2d_array_uniform& get_struct_2d_array_uniform ( const std::string& name ) const { return struct_2d_array_uniforms.get ( name ); }
 
+    /* get_uniform by id
+     *
+     * return a uniform through the uniform table, which never allocates or compares strings once the uniform is in the table
+     * 
+     * id: the id of the uniform, created with the _uid literal
+     */
+    uniform& get_uniform ( const uniform_id& id ) { return get_hashed_uniform ( id.hash, std::string {}, id ); }
+    const uniform& get_uniform ( const uniform_id& id ) const { return get_hashed_uniform ( id.hash, std::string {}, id ); }
+
+    /* get_hashed_uniform
+     *
+     * return a uniform from the uniform table by the hash of its full name
+     * if the uniform is not in the table, it is looked up by its full name and added
+     * 
+     * hash: the hash of the full name of the uniform
+     * parent_name: the name of the struct containing the uniform, or an empty string if it is not a member of a struct
+     * member: the name of the uniform within its parent
+     * the full name is only built if the uniform is not in the table
+     */
+    uniform& get_hashed_uniform ( const std::uint64_t hash, const std::string& parent_name, const uniform_id& member ) const;
+
+    /* get_uniform_table_size
+     * get_num_uniform_table_misses
+     *
+     * get the number of uniforms in the uniform table, and the number of lookups by id which had to fall back to looking the uniform up by name
+     */
+    unsigned get_uniform_table_size () const { return uniform_table_count; }
+    unsigned get_num_uniform_table_misses () const { return num_uniform_table_misses; }
+
+    /* update_uniform_shadow
+     *
+     * compare a value about to be written to a location in the default block with the last value written to it, and record it if it differs
+     * this is used by uniforms to skip setting values which have not changed, and the shadow is cleared each time the program is linked
+     * 
+     * location: the location of the uniform (negative locations are never shadowed)
+     * data: pointer to the value
+     * size: the size of the value in bytes
+     * 
+     * return: true if the value differs from the last value written, so must be set
+     */
+    bool update_uniform_shadow ( const GLint location, const void * data, const unsigned size ) const;
+
 
 
 
@@ -1255,6 +1866,18 @@ public:
 
 
 
+protected:
+
+    /* compute shader constructor
+     *
+     * link a compute shader into a program
+     * only used by compute_program, so that every compute program has that type
+     * NOTE: the shader program remains valid even when linked shaders are destroyed
+     */
+    explicit program ( cshader& cs );
+
+
+
 private:
 
     /* the currently bound program */
@@ -1264,9 +1887,38 @@ private:
     object_pointer<vshader> vertex_shader;
     object_pointer<gshader> geometry_shader;
     object_pointer<fshader> fragment_shader;
+    object_pointer<cshader> compute_shader;
 
-    /* true if has a geometry shader */
+    /* true if has a geometry shader, and true if the program is a compute program */
     const bool has_geometry_shader;
+    const bool has_compute_shader;
+
+    /* true if the program was loaded from the binary cache */
+    bool loaded_from_binary_cache;
+
+    /* true if the program has been linked, and if a link has been submitted but not finished */
+    bool linked;
+    bool link_pending;
+
+    /* true if the binary should be added to the cache once the pending link finishes */
+    bool binary_cache_save_pending;
+
+    /* the program object of a submitted relink, or 0 if none is pending */
+    GLuint relink_id;
+
+    /* binary_cache_directory
+     *
+     * the directory of the program binary cache, or empty if the cache is disabled
+     */
+    static std::string binary_cache_directory;
+
+    /* num_binary_cache_hits
+     * num_binary_cache_misses
+     *
+     * binary cache statistics across all programs
+     */
+    static unsigned num_binary_cache_hits;
+    static unsigned num_binary_cache_misses;
 
     /* uniform_locations
      * uniform_indices
@@ -1286,6 +1938,35 @@ private:
      */
     mutable std::vector<GLint> uniform_block_bindings;
 
+    /* struct uniform_table_slot
+     *
+     * a slot of the uniform table, which is empty if the uniform is NULL
+     */
+    struct uniform_table_slot
+    {
+        std::uint64_t hash;
+        uniform * uni;
+    };
+
+    /* uniform_table
+     * uniform_table_count
+     *
+     * open-addressing table of uniforms by the hash of their name, with a power of two size and linear probing
+     * the table is kept at most half full
+     */
+    mutable std::vector<uniform_table_slot> uniform_table;
+    mutable unsigned uniform_table_count;
+
+    /* the number of lookups by id which missed the table */
+    mutable unsigned num_uniform_table_misses;
+
+    /* uniform_shadows
+     *
+     * the bytes of the last value written to each location of the default block, indexed by location
+     * an empty shadow means that the value is unknown
+     */
+    mutable std::vector<std::vector<unsigned char>> uniform_shadows;
+
     /* pure_(..._)uniforms
      *
      * storage of uniforms in the program
@@ -1297,6 +1978,351 @@ private:
     uniform_storage<uniform_2d_array_uniform> uniform_2d_array_uniforms;
     uniform_storage<struct_2d_array_uniform> struct_2d_array_uniforms;
 
+
+
+    /* resolve_uniform_table
+     *
+     * fill the uniform table with every active uniform of the program, once linked
+     */
+    void resolve_uniform_table ();
+
+    /* finish_link
+     *
+     * check the result of a submitted link, first checking any shaders still pending compilation
+     * on success, the uniform table is resolved and the binary added to the cache if requested
+     */
+    void finish_link ();
+
+    /* insert_uniform_table
+     *
+     * add a uniform to the uniform table, growing the table if it would become more than half full
+     * throws if a different uniform with the same hash is already in the table
+     * 
+     * hash: the hash of the name of the uniform
+     * uni: the uniform to add
+     */
+    void insert_uniform_table ( const std::uint64_t hash, uniform& uni ) const;
+
+    /* get_binary_cache_path
+     *
+     * get the path of the cached binary of the program, named by a hash of the sources of its shaders and the vendor, renderer and version of the driver
+     */
+    std::string get_binary_cache_path () const;
+
+    /* load_binary_cache
+     *
+     * try to load the program from its cached binary
+     * 
+     * return: true if the binary was found and accepted by the driver
+     */
+    bool load_binary_cache ();
+
+    /* save_binary_cache
+     *
+     * write the binary of the linked program to the cache
+     * failing to write the binary is not an error, as the program will just be compiled again next time
+     */
+    void save_binary_cache () const;
+
+    /* copy_uniform_values
+     *
+     * copy the value of every default block uniform of one program object to the uniform of the same name and type in another
+     * uniforms which are not active in both objects are skipped
+     *
+     * from_id/to_id: the program objects to copy from and to
+     */
+    static void copy_uniform_values ( const GLuint from_id, const GLuint to_id );
+
+};
+
+
+
+/* COMPUTE_PROGRAM DEFINITION */
+
+/* class compute_program : program
+ *
+ * program made from a compute shader
+ */
+class glh::core::compute_program : public program
+{
+public:
+
+    /* compute shader constructor
+     *
+     * link a compute shader into a program
+     * NOTE: the shader program remains valid even when linked shaders are destroyed
+     */
+    explicit compute_program ( cshader& cs )
+        : program { cs }
+    {}
+
+    /* deleted zero-parameter constructor */
+    compute_program () = delete;
+
+    /* deleted copy constructor */
+    compute_program ( const compute_program& other ) = delete;
+
+    /* default move constructor */
+    compute_program ( compute_program&& other ) = default;
+
+    /* deleted copy assignment operator */
+    compute_program& operator= ( const compute_program& other ) = delete;
+
+    /* default destructor */
+    ~compute_program () = default;
+
+
+
+    /* get_work_group_size
+     *
+     * get the size of the work groups declared in the compute shader
+     * the program must be linked
+     */
+    math::ivec3 get_work_group_size () const;
+
+    /* dispatch
+     *
+     * use the program and dispatch a number of work groups
+     * 
+     * num_groups_x/y/z: the number of work groups in each dimension (y and z default to 1)
+     */
+    void dispatch ( const GLuint num_groups_x, const GLuint num_groups_y = 1, const GLuint num_groups_z = 1 ) const;
+
+    /* dispatch_invocations
+     *
+     * use the program and dispatch enough work groups to cover a number of invocations
+     * the number of work groups in each dimension is rounded up, so the shader must ignore invocations past the end
+     * 
+     * num_invocations_x/y/z: the number of invocations needed in each dimension (y and z default to 1)
+     */
+    void dispatch_invocations ( const GLuint num_invocations_x, const GLuint num_invocations_y = 1, const GLuint num_invocations_z = 1 ) const;
+
+    /* dispatch_indirect
+     *
+     * use the program and dispatch the number of work groups stored in a buffer
+     * 
+     * indirect_buffer: the buffer containing the three unsigned integers of the number of work groups
+     * offset: the offset of the integers in the buffer in bytes (defaults to 0)
+     */
+    void dispatch_indirect ( const buffer& indirect_buffer, const GLintptr offset = 0 ) const;
+
+};
+
+
+
+/* PROGRAM_SET DEFINITION */
+
+/* class program_set
+ *
+ * a set of programs compiled and linked together
+ */
+class glh::core::program_set
+{
+public:
+
+    /* zero-parameter constructor
+     *
+     * create an empty set
+     */
+    program_set ()
+        : compile_time { 0.0 }
+    {}
+
+    /* initializer list constructor
+     *
+     * _programs: the programs in the set
+     */
+    program_set ( std::initializer_list<std::reference_wrapper<program>> _programs );
+
+    /* default copy constructor */
+    program_set ( const program_set& other ) = default;
+
+    /* default copy assignment operator */
+    program_set& operator= ( const program_set& other ) = default;
+
+    /* default destructor */
+    ~program_set () = default;
+
+
+
+    /* add
+     *
+     * add a program to the set
+     */
+    void add ( program& prog ) { programs.push_back ( &prog ); }
+
+    /* get_num_programs
+     *
+     * get the number of programs in the set
+     */
+    unsigned get_num_programs () const { return programs.size (); }
+
+
+
+    /* submit_all
+     *
+     * submit the compilation and link of every program in the set without waiting on any of them
+     */
+    void submit_all ();
+
+    /* is_ready
+     *
+     * returns true if every program in the set is ready to use, finishing the links of those which are complete
+     */
+    bool is_ready ();
+
+    /* wait_until_ready
+     *
+     * finish the pending links of every program in the set, blocking until the driver is done
+     */
+    void wait_until_ready ();
+
+    /* compile_all
+     *
+     * compile and link every program in the set, and record the time taken
+     *
+     * parallel: if true, every program is submitted before any is waited on, otherwise each is compiled and linked in turn (defaults to true)
+     */
+    void compile_all ( const bool parallel = true );
+
+    /* get_compile_time
+     *
+     * get the time in milliseconds taken by the last call to compile_all
+     */
+    double get_compile_time () const { return compile_time; }
+
+
+
+private:
+
+    /* the programs of the set */
+    std::vector<program *> programs;
+
+    /* the time in milliseconds taken by the last call to compile_all */
+    double compile_time;
+
+};
+
+
+
+/* PROGRAM_REGISTRY DEFINITION */
+
+/* class program_registry
+ *
+ * process-wide registry of shared programs
+ */
+class glh::core::program_registry
+{
+public:
+
+    /* deleted constructor */
+    program_registry () = delete;
+
+    /* deleted copy constructor */
+    program_registry ( const program_registry& other ) = delete;
+
+    /* deleted assignment operator */
+    program_registry& operator= ( const program_registry& other ) = delete;
+
+    /* default destructor */
+    ~program_registry () = default;
+
+
+
+    /* get
+     *
+     * get a shared program built from source files and defines
+     * the program is only created, compiled and linked if no identical program is still alive
+     *
+     * vshader_paths/gshader_paths/fshader_paths: the source files of each shader, where no geometry shader paths means no geometry shader
+     * defines: source to insert after the version directive of each shader, before the files (e.g. #define lines) (defaults to none)
+     *
+     * return: a shared pointer to the program
+     */
+    static std::shared_ptr<program> get ( const std::vector<std::string>& vshader_paths, const std::vector<std::string>& gshader_paths, const std::vector<std::string>& fshader_paths, const std::string& defines = "" );
+
+    /* get_compute
+     *
+     * get a shared compute program built from source files and defines
+     * the program is only created, compiled and linked if no identical program is still alive
+     *
+     * cshader_paths: the source files of the compute shader
+     * defines: source to insert after the version directive of the shader, before the files (e.g. #define lines) (defaults to none)
+     *
+     * return: a shared pointer to the compute program
+     */
+    static std::shared_ptr<compute_program> get_compute ( const std::vector<std::string>& cshader_paths, const std::string& defines = "" );
+
+    /* get_num_programs
+     *
+     * get the number of programs in the registry which are still alive
+     */
+    static unsigned get_num_programs ();
+
+    /* get_num_hits/misses
+     *
+     * get the number of calls to get which shared an existing program, and the number which had to create one
+     */
+    static unsigned get_num_hits () { return num_hits; }
+    static unsigned get_num_misses () { return num_misses; }
+
+    /* reset_statistics
+     *
+     * reset the hit and miss counts
+     */
+    static void reset_statistics () { num_hits = 0; num_misses = 0; }
+
+
+
+private:
+
+    /* struct registry_entry
+     *
+     * a program and the shaders it was created from
+     */
+    struct registry_entry
+    {
+        vshader vertex_shader;
+        gshader geometry_shader;
+        fshader fragment_shader;
+        cshader compute_shader;
+        std::unique_ptr<program> prog;
+    };
+
+    /* find_entry
+     *
+     * find the entry of a key if it is still alive, counting a hit if so
+     *
+     * key: the key of the entry
+     *
+     * return: the entry, or NULL if there is no live entry with the key
+     */
+    static std::shared_ptr<registry_entry> find_entry ( const std::string& key );
+
+    /* add_entry
+     *
+     * add an entry whose program has been created, compiling and linking it first, and removing any entries which have expired
+     * the entry is only added if the program compiles and links
+     *
+     * key: the key of the entry
+     * entry: the entry to add
+     */
+    static void add_entry ( const std::string& key, const std::shared_ptr<registry_entry>& entry );
+
+    /* entries
+     *
+     * the entries of the registry by key, which expire once the last shared pointer to their program is destroyed
+     */
+    static std::map<std::string, std::weak_ptr<registry_entry>> entries;
+
+    /* num_hits
+     * num_misses
+     *
+     * registry statistics
+     */
+    static unsigned num_hits;
+    static unsigned num_misses;
+
 };
 
 
@@ -1369,7 +2395,7 @@ public:
  */
 template<class T> inline bool operator== ( const glh::core::array_uniform<T>& lhs, const glh::core::array_uniform<T>& rhs )
 {
-    return ( lhs.get_program () == rhs.get_program () && lhs.get_name () == rhs.get_name () );
+    return ( lhs.get_program () == rhs.get_program () && lhs.get_name_hash () == rhs.get_name_hash () );
 }
 template<class T> inline bool operator!= ( const glh::core::array_uniform<T>& lhs, const glh::core::array_uniform<T>& rhs )
 {
@@ -1462,6 +2488,18 @@ template<class T> inline T& glh::core::uniform_storage<T>::__get ( const std::st
 
 
 
+/* refresh
+ *
+ * refresh every uniform in the storage after the program has been relinked
+ */
+template<class T> inline void glh::core::uniform_storage<T>::refresh ()
+{
+    /* refresh each uniform in place, so that references to them stay valid */
+    for ( auto& uni: uniforms ) uni.second.refresh ();
+}
+
+
+
 /* ARRAY_UNIFORM IMPLEMENTATION */
 
 /* __at
@@ -7,6 +7,16 @@
  * include/glhelper/glhelper_sync.hpp
  * 
  * constructs to assist synchronisation between the CPU and the GPU
+ * notable constructs include:
+ * 
+ * 
+ * 
+ * CLASS GLH::CORE::SYNC
+ * 
+ * contains static methods for controlling the gpu queue
+ * memory_barrier orders incoherent memory accesses (e.g. writes to ssbos or images by a compute shader) before the commands which follow it
+ * the barrier bits say how the written memory will be read next, so a compute shader writing vertices which are then drawn needs a vertex attribute array barrier
+ * the named barriers cover the common cases, and memory_barrier_by_region limits a barrier to the fragments of the same region of the framebuffer
  *
  */
 
@@ -166,6 +176,37 @@ public:
      */
     static void flush_queue ();
 
+
+
+    /* memory_barrier
+     *
+     * make incoherent writes by previous commands visible to the reads of following commands
+     *
+     * barriers: the ways in which the written memory will be read (defaults to all)
+     */
+    static void memory_barrier ( const GLbitfield barriers = GL_ALL_BARRIER_BITS );
+
+    /* memory_barrier_by_region
+     *
+     * as memory_barrier, but only between fragment shaders writing and reading the same region of the framebuffer
+     *
+     * barriers: the ways in which the written memory will be read (defaults to all)
+     */
+    static void memory_barrier_by_region ( const GLbitfield barriers = GL_ALL_BARRIER_BITS );
+
+    /* shader_storage/shader_image/vertex_attrib/element_array/command/buffer_update/texture_fetch_barrier
+     *
+     * memory barriers for writes which are next read by: shaders through ssbos, shaders through image load/store,
+     * vertex attributes, element arrays, indirect draw or dispatch commands, buffer reads or writes from the cpu, or texture sampling
+     */
+    static void shader_storage_barrier () { memory_barrier ( GL_SHADER_STORAGE_BARRIER_BIT ); }
+    static void shader_image_barrier () { memory_barrier ( GL_SHADER_IMAGE_ACCESS_BARRIER_BIT ); }
+    static void vertex_attrib_barrier () { memory_barrier ( GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT ); }
+    static void element_array_barrier () { memory_barrier ( GL_ELEMENT_ARRAY_BARRIER_BIT ); }
+    static void command_barrier () { memory_barrier ( GL_COMMAND_BARRIER_BIT ); }
+    static void buffer_update_barrier () { memory_barrier ( GL_BUFFER_UPDATE_BARRIER_BIT ); }
+    static void texture_fetch_barrier () { memory_barrier ( GL_TEXTURE_FETCH_BARRIER_BIT ); }
+
 };
 
 
@@ -25,9 +25,22 @@
  * 
  * base class for all textures
  * implements common fucntionality such as wrapping and filtering settings
+ * textures can be bound to any free texture unit with bind_loop, which manages units 1 to 79 as a least-recently-used cache:
+ * a texture which is still bound to the unit it was last given keeps that unit without any OpenGL call,
+ * otherwise the least recently used unit is evicted, and batches of textures are bound together with glBindTextures
+ * bind_loop also removes any sampler from the unit, so that the texture is sampled with its own parameters, unless a sampler is given to bind instead
  * 
  * 
  * 
+ * CLASS GLH::CORE::SAMPLER
+ * 
+ * a sampler object, which overrides the filtering, wrapping, comparison and level of detail parameters of whichever texture shares its unit
+ * the parameters of a sampler are fixed on construction, so that samplers can be shared through a cache with get_cached, which creates one sampler per distinct set of parameters
+ * changing how a texture is sampled is then only a sampler binding, rather than changes to the parameters of the texture,
+ * and the same texture can be sampled in two ways at once by binding it to two units with different samplers
+ * the cache must be cleared with clear_cache before the OpenGL context is destroyed
+ * 
+ * 
  * CLASS GLH::CORE::TEXTURE2D
  * 
  * derivation of texture_base to represent a 2d texture
@@ -78,6 +91,8 @@
 /* INCLUDES */
 
 /* include core headers */
+#include <algorithm>
+#include <array>
 #include <cstdlib>
 #include <cstring>
 #include <functional>
@@ -85,6 +100,7 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
 /* include glhelper_core.hpp */
 #include <glhelper/glhelper_core.hpp>
@@ -131,6 +147,12 @@ namespace glh
          */
         class texture_multisample_base;
 
+        /* class sampler : object
+         *
+         * a sampler object with fixed parameters
+         */
+        class sampler;
+
         /* class texture1d : texture_base
          *
          * represents a 1D texture
@@ -407,24 +429,64 @@ public:
 
     /* bind_loop
      *
-     * this will keep looping around texture units, disincluding 0, and making subsequent binds to the next unit
-     * this avoids binding a texture to a unit already in use
+     * bind the texture to a texture unit, disincluding 0, which will not be reused by bind_loop until 78 other units have been used since
+     * if the texture is still bound to the unit it was last given, that unit is returned without rebinding
+     * otherwise the least recently used unit is evicted
      * 
-     * returns the unit just bound to
+     * returns the unit bound to
      */
     unsigned bind_loop () const;
 
+    /* bind_loop with a sampler
+     *
+     * bind_loop the texture, then bind a sampler to the same unit
+     * the sampler remains bound to the unit until the unit is next given to a texture by bind_loop
+     * 
+     * samp: the sampler to sample the texture with
+     * 
+     * returns the unit bound to
+     */
+    unsigned bind_loop ( const sampler& samp ) const;
+
+    /* bind_loop with multiple textures
+     *
+     * bind_loop several textures at once, binding those which are not already bound with as few calls to glBindTextures as possible
+     * 
+     * textures: the textures to bind
+     * 
+     * returns the units bound to, in the same order as the textures
+     */
+    static std::vector<unsigned> bind_loop ( const std::vector<const texture_base *>& textures );
+
     /* bind_loop_next
      *
-     * return the next index of the bind loop without binding
+     * return the unit which would be evicted by the next bind_loop of a texture which is not already bound
      */
-    unsigned bind_loop_next () const { return bind_loop_index; }
+    static unsigned bind_loop_next ();
 
     /* bind_loop_previous
      *
-     * return the previous binding of the loop
+     * return the unit returned by the previous bind_loop
+     */
+    static unsigned bind_loop_previous () { return bind_loop_index; }
+
+
+
+    /* get_num_loop_requests
+     * get_num_loop_binds_avoided
+     * get_num_loop_bind_calls
+     *
+     * get the number of textures passed to bind_loop, how many of those were already bound, and how many OpenGL calls were made to bind the rest
      */
-    unsigned bind_loop_previous () const;
+    static unsigned get_num_loop_requests () { return num_loop_requests; }
+    static unsigned get_num_loop_binds_avoided () { return num_loop_binds_avoided; }
+    static unsigned get_num_loop_bind_calls () { return num_loop_bind_calls; }
+
+    /* reset_loop_statistics
+     *
+     * reset the bind_loop counters
+     */
+    static void reset_loop_statistics () { num_loop_requests = 0; num_loop_binds_avoided = 0; num_loop_bind_calls = 0; }
 
 
 
@@ -475,6 +537,13 @@ public:
      */
     virtual void set_compare_func ( const GLenum opt );
 
+    /* set_base/max_level
+     *
+     * set the lowest and highest mipmap levels which can be accessed
+     */
+    void set_base_level ( const unsigned level );
+    void set_max_level ( const unsigned level );
+
 
 
     /* generate_mipmap
@@ -492,10 +561,41 @@ protected:
 
     /* bind_loop_index
      *
-     * the next unit to bind the texture to in the bind loop
+     * the unit returned by the previous bind_loop
      */
     static unsigned bind_loop_index;
 
+    /* unit_last_use
+     * unit_clock
+     *
+     * the time at which each texture unit was last used, counted in binds
+     */
+    static std::array<unsigned, 80> unit_last_use;
+    static unsigned unit_clock;
+
+    /* bind_loop counters */
+    static unsigned num_loop_requests;
+    static unsigned num_loop_binds_avoided;
+    static unsigned num_loop_bind_calls;
+
+
+
+private:
+
+    /* loop_unit
+     *
+     * the unit last given to the texture by bind_loop (0 for none)
+     */
+    mutable unsigned loop_unit;
+
+    /* acquire_loop_unit
+     *
+     * get the unit for bind_loop to use, marking it as the most recently used
+     * 
+     * resident: set to true if the texture is already bound to the unit
+     */
+    unsigned acquire_loop_unit ( bool& resident ) const;
+
 };
 
 
@@ -574,6 +674,162 @@ public:
 
 
 
+/* SAMPLER DEFINITION */
+
+/* class sampler : object
+ *
+ * a sampler object with fixed parameters
+ */
+class glh::core::sampler : public object
+{
+public:
+
+    /* struct parameters
+     *
+     * the parameters of a sampler, defaulting to those of OpenGL
+     * the with_* methods return a modified copy, so that parameters can be built up in a single expression
+     */
+    struct parameters
+    {
+        GLenum mag_filter = GL_LINEAR;
+        GLenum min_filter = GL_NEAREST_MIPMAP_LINEAR;
+        GLenum s_wrap = GL_REPEAT;
+        GLenum t_wrap = GL_REPEAT;
+        GLenum r_wrap = GL_REPEAT;
+        math::fvec4 border_color { 0.0 };
+        GLenum compare_mode = GL_NONE;
+        GLenum compare_func = GL_LEQUAL;
+        GLfloat min_lod = -1000.0f;
+        GLfloat max_lod = 1000.0f;
+        GLfloat lod_bias = 0.0f;
+
+        parameters with_filter ( const GLenum mag, const GLenum min ) const { parameters p = * this; p.mag_filter = mag; p.min_filter = min; return p; }
+        parameters with_wrap ( const GLenum opt ) const { return with_wrap ( opt, opt, opt ); }
+        parameters with_wrap ( const GLenum s, const GLenum t, const GLenum r ) const { parameters p = * this; p.s_wrap = s; p.t_wrap = t; p.r_wrap = r; return p; }
+        parameters with_border_color ( const math::fvec4& color ) const { parameters p = * this; p.border_color = color; return p; }
+        parameters with_compare ( const GLenum mode, const GLenum func ) const { parameters p = * this; p.compare_mode = mode; p.compare_func = func; return p; }
+        parameters with_lod ( const GLfloat min, const GLfloat max, const GLfloat bias ) const { parameters p = * this; p.min_lod = min; p.max_lod = max; p.lod_bias = bias; return p; }
+
+        bool operator== ( const parameters& other ) const;
+        bool operator!= ( const parameters& other ) const { return !( * this == other ); }
+    };
+
+    /* struct parameters_hash
+     *
+     * hashes a set of parameters for the sampler cache
+     */
+    struct parameters_hash
+    {
+        std::size_t operator() ( const parameters& params ) const;
+    };
+
+
+
+    /* full constructor
+     *
+     * create a sampler with a set of parameters
+     * 
+     * _params: the parameters of the sampler
+     */
+    explicit sampler ( const parameters& _params );
+
+    /* zero-parameter constructor
+     *
+     * create a sampler with the default parameters of OpenGL
+     */
+    sampler ();
+
+    /* deleted copy constructor */
+    sampler ( const sampler& other ) = delete;
+
+    /* default move constructor */
+    sampler ( sampler&& other ) = default;
+
+    /* deleted copy assignment operator */
+    sampler& operator= ( const sampler& other ) = delete;
+
+    /* destructor */
+    ~sampler ();
+
+
+
+    /* using bind methods from base class */
+    using object::bind;
+    using object::unbind;
+    using object::is_bound;
+
+    /* bind/unbind to texture units */
+    bool bind ( const unsigned index ) const;
+    bool unbind ( const unsigned index ) const;
+    bool is_bound ( const unsigned index ) const;
+
+    /* unbind_unit
+     *
+     * remove any sampler from a texture unit
+     * 
+     * returns true if a sampler was removed
+     */
+    static bool unbind_unit ( const unsigned index );
+
+    /* get the currently bound sampler */
+    static const object_pointer<sampler>& get_bound_sampler ( const unsigned index );
+
+
+
+    /* get_parameters
+     *
+     * get the parameters of the sampler
+     */
+    const parameters& get_parameters () const { return params; }
+
+
+
+    /* get_cached
+     *
+     * get the cached sampler with a set of parameters, creating it if it does not yet exist
+     * the sampler remains valid until clear_cache is called
+     * 
+     * _params: the parameters of the sampler
+     */
+    static const sampler& get_cached ( const parameters& _params );
+
+    /* clear_cache
+     *
+     * destroy all cached samplers
+     * this must be called before the OpenGL context is destroyed
+     */
+    static void clear_cache ();
+
+    /* get_num_cached_samplers
+     * get_num_cache_requests
+     *
+     * get the number of samplers in the cache, and the number of calls to get_cached
+     */
+    static unsigned get_num_cached_samplers () { return ( cache ? cache->size () : 0 ); }
+    static unsigned get_num_cache_requests () { return num_cache_requests; }
+
+
+
+private:
+
+    /* the parameters of the sampler */
+    const parameters params;
+
+    /* currently bound samplers */
+    static std::array<object_pointer<sampler>, 80> bound_sampler_indices;
+
+    /* the cache of samplers, allocated on first use and destroyed by clear_cache
+     * this is not destroyed automatically, as the samplers must be deleted while the context still exists
+     */
+    static std::unordered_map<parameters, std::unique_ptr<sampler>, parameters_hash> * cache;
+
+    /* the number of calls to get_cached */
+    static unsigned num_cache_requests;
+
+};
+
+
+
 /* TEXTURE1D DEFINITION */
 
 /* class texture1d : texture_base
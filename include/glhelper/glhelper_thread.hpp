@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * include/glhelper/glhelper_thread.hpp
+ *
+ * constructs for running CPU work across multiple threads
+ * notable constructs include:
+ *
+ *
+ *
+ * CLASS GLH::THREAD::THREAD_POOL
+ *
+ * a fixed-size pool of worker threads which is kept alive for the lifetime of the pool
+ * work is submitted through parallel_for, which calls a function once for every index in a range
+ * the calling thread also takes part in the work, and parallel_for does not return until every index has been processed
+ * if any call throws, the first exception thrown is rethrown from parallel_for once all other work has finished
+ * no OpenGL calls should be made from within the submitted function, as the worker threads have no context
+ * get_shared returns a pool which is created on first use and shared by the library, so that threads are not started for every task
+ * parallel_for must not be called on a pool from within work submitted to that same pool, as submissions are run one at a time
+ *
+ */
+
+
+
+/* HEADER GUARD */
+#ifndef GLHELPER_THREAD_HPP_INCLUDED
+#define GLHELPER_THREAD_HPP_INCLUDED
+
+
+
+/* INCLUDES */
+
+/* include core headers */
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* include glhelper_core.hpp */
+#include <glhelper/glhelper_core.hpp>
+
+
+
+/* NAMESPACE DECLARATIONS */
+
+namespace glh
+{
+    namespace thread
+    {
+        /* class thread_pool
+         *
+         * a fixed-size pool of worker threads
+         */
+        class thread_pool;
+    }
+}
+
+
+
+/* THREAD_POOL DEFINITION */
+
+/* class thread_pool
+ *
+ * a fixed-size pool of worker threads
+ */
+class glh::thread::thread_pool
+{
+public:
+
+    /* full constructor
+     *
+     * create the pool and start the worker threads
+     *
+     * _num_threads: the total number of threads to work with, including the calling thread (defaults to the hardware concurrency)
+     */
+    explicit thread_pool ( const unsigned _num_threads = std::thread::hardware_concurrency () );
+
+    /* deleted copy constructor */
+    thread_pool ( const thread_pool& other ) = delete;
+
+    /* deleted copy assignment operator */
+    thread_pool& operator= ( const thread_pool& other ) = delete;
+
+    /* destructor
+     *
+     * stop and join the worker threads
+     */
+    ~thread_pool ();
+
+
+
+    /* get_shared
+     *
+     * get the pool shared by the library, which is created on first use and lives until the program exits
+     */
+    static thread_pool& get_shared ();
+
+
+
+    /* parallel_for
+     *
+     * call a function once for every index in [0, count), spread across the threads of the pool
+     * the order in which indices are processed is unspecified
+     *
+     * count: the number of indices
+     * func: the function to call with each index
+     */
+    void parallel_for ( const unsigned count, const std::function<void ( unsigned )>& func );
+
+
+
+    /* get_num_threads
+     *
+     * get the total number of threads work is spread across, including the calling thread
+     */
+    unsigned get_num_threads () const { return workers.size () + 1; }
+
+
+
+private:
+
+    /* the worker threads */
+    std::vector<std::thread> workers;
+
+    /* mutex and condition variables for waking the workers and waiting for them to finish */
+    std::mutex pool_mutex;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+
+    /* mutex ensuring that only one parallel_for is running at a time */
+    std::mutex submit_mutex;
+
+    /* the current work */
+    const std::function<void ( unsigned )> * work_func;
+    unsigned work_count;
+    std::atomic<unsigned> next_index;
+
+    /* the generation of work, which is incremented for every parallel_for */
+    unsigned generation;
+
+    /* the number of workers yet to finish the current generation */
+    unsigned active_workers;
+
+    /* true when the workers should exit */
+    bool stopping;
+
+    /* the first exception thrown by the current work */
+    std::exception_ptr work_exception;
+
+
+
+    /* worker_loop
+     *
+     * the function run by each worker thread
+     */
+    void worker_loop ();
+
+    /* run_work
+     *
+     * process indices of the current work until none are left
+     */
+    void run_work ();
+
+};
+
+
+
+/* #ifndef GLHELPER_THREAD_HPP_INCLUDED */
+#endif
@@ -0,0 +1,1453 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * regression.cpp
+ *
+ * render a scene headlessly and compare it against the golden images in assets/golden
+ * the scene is built from boxes, so it needs no model assets, and is rendered with the same passes as test.cpp
+ * (shadow maps, a gbuffer, the lighting pass, a forward transparent pass, bloom and fxaa), each into an fbo
+ * before rendering, the state cache of the renderer is checked through a mock dispatch table, a compute dispatch is checked against the cpu,
+ * streaming through a ring buffer is checked,
+ * reloading a program loaded from the binary cache is checked,
+ * levels of detail and meshlets built from a sphere are checked, occlusion tests against a depth pyramid are checked, alpha testing faces across assets/alpha_test.png is checked to agree between the gpu and the cpu,
+ * back to front render queues are checked to submit in depth order, and render queues recorded from several threads and merged are checked to submit as one queue does
+ * the program exits with a non-zero status if any check or comparison fails, or if anything throws
+ *
+ * usage: regression [--record]
+ *
+ * --record: record the rendered images as the golden images of any which are missing, rather than failing
+ *
+ */
+
+
+
+/* INCLUDES */
+
+/* include core headers */
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+
+/* include only the glhelper headers which are needed, as glhelper.hpp includes the glfw and assimp headers, which headless programs do not need */
+
+/* include glhelper_core.hpp */
+#include <glhelper/glhelper_core.hpp>
+
+/* include glhelper_exception.hpp */
+#include <glhelper/glhelper_exception.hpp>
+
+/* include glhelper_buffer.hpp */
+#include <glhelper/glhelper_buffer.hpp>
+
+/* include glhelper_shader.hpp */
+#include <glhelper/glhelper_shader.hpp>
+
+/* include glhelper_permutation.hpp */
+#include <glhelper/glhelper_permutation.hpp>
+
+/* include glhelper_reload.hpp */
+#include <glhelper/glhelper_reload.hpp>
+
+/* include glhelper_matrix.hpp */
+#include <glhelper/glhelper_matrix.hpp>
+
+/* include glhelper_vector.hpp */
+#include <glhelper/glhelper_vector.hpp>
+
+/* include glhelper_transform.hpp */
+#include <glhelper/glhelper_transform.hpp>
+
+/* include glhelper_texture.hpp */
+#include <glhelper/glhelper_texture.hpp>
+
+/* include glhelper_camera.hpp */
+#include <glhelper/glhelper_camera.hpp>
+
+/* include glhelper_render.hpp */
+#include <glhelper/glhelper_render.hpp>
+
+/* include glhelper_render_queue.hpp */
+#include <glhelper/glhelper_render_queue.hpp>
+
+/* include glhelper_lighting.hpp */
+#include <glhelper/glhelper_lighting.hpp>
+
+/* include glhelper_framebuffer.hpp */
+#include <glhelper/glhelper_framebuffer.hpp>
+
+/* include glhelper_vertices.hpp */
+#include <glhelper/glhelper_vertices.hpp>
+
+/* include glhelper_region.hpp */
+#include <glhelper/glhelper_region.hpp>
+
+/* include glhelper_function.hpp */
+#include <glhelper/glhelper_function.hpp>
+
+/* include glhelper_culling.hpp */
+#include <glhelper/glhelper_culling.hpp>
+
+/* include glhelper_thread.hpp */
+#include <glhelper/glhelper_thread.hpp>
+
+/* include glhelper_lod.hpp */
+#include <glhelper/glhelper_lod.hpp>
+
+/* include glhelper_meshlet.hpp */
+#include <glhelper/glhelper_meshlet.hpp>
+
+/* include glhelper_alpha_test.hpp */
+#include <glhelper/glhelper_alpha_test.hpp>
+
+/* include glhelper_sync.hpp */
+#include <glhelper/glhelper_sync.hpp>
+
+/* include glhelper_headless.hpp */
+#include <glhelper/glhelper_headless.hpp>
+
+
+
+/* RESOLUTION
+ *
+ * the resolution to render at, which is kept small so that software rendering is quick
+ */
+#define RESOLUTION 320, 180
+
+/* SHADOW_MAP_WIDTH
+ *
+ * the width of the shadow maps
+ */
+#define SHADOW_MAP_WIDTH 1024
+
+/* GOLDEN_DIRECTORY
+ * OUTPUT_DIRECTORY
+ *
+ * the directories containing the golden images, and to write the rendered images to
+ */
+#define GOLDEN_DIRECTORY "assets/golden"
+#define OUTPUT_DIRECTORY "regression_output"
+
+/* TEXTURE_STACK_SIZE
+ *
+ * the maximum size of the texture stacks of the scene, which is injected into shaders as MAX_TEXTURE_STACK_SIZE
+ * this matches the default of GLH_MODEL_MAX_TEXTURE_STACK_SIZE, but glhelper_model.hpp is not included, as it includes the assimp headers
+ */
+#define TEXTURE_STACK_SIZE 2
+
+/* MAX_LODS
+ * LOD_TRIANGLE_RATIO
+ * LOD_MAX_RELATIVE_ERROR
+ *
+ * the settings to generate levels of detail with, which match the defaults of the GLH_MODEL_ macros of the same names
+ */
+#define MAX_LODS 3
+#define LOD_TRIANGLE_RATIO 0.5
+#define LOD_MAX_RELATIVE_ERROR 0.02
+
+
+
+/* get_texture_stack_defines
+ *
+ * get the #define directive for the texture stack size, to add to shaders which include shaders/materials.glsl
+ */
+std::string get_texture_stack_defines () { return "#define MAX_TEXTURE_STACK_SIZE " + std::to_string ( TEXTURE_STACK_SIZE ) + "\n"; }
+
+
+
+/* struct box
+ *
+ * an axis aligned box of the scene, and its material
+ */
+struct box
+{
+    /* the corners of the box */
+    std::array<GLfloat, 3> min, max;
+
+    /* the diffuse and emission colors, and opacity */
+    glh::math::fvec4 diffuse;
+    glh::math::fvec3 emission;
+    GLfloat opacity;
+};
+
+/* append_box
+ *
+ * append the vertices of a box to interleaved position, normal and tangent data, as 12 counter-clockwise triangles
+ *
+ * vertices: the vertex data to append to
+ * _box: the box to append
+ */
+void append_box ( std::vector<GLfloat>& vertices, const box& _box )
+{
+    /* the normal and tangent of each face, where the bitangent is the cross product of the normal and the tangent */
+    const GLfloat faces [ 6 ][ 2 ][ 3 ]
+    {
+        { { +1, 0, 0 }, { 0, 0, -1 } }, { { -1, 0, 0 }, { 0, 0, +1 } },
+        { { 0, +1, 0 }, { +1, 0, 0 } }, { { 0, -1, 0 }, { +1, 0, 0 } },
+        { { 0, 0, +1 }, { +1, 0, 0 } }, { { 0, 0, -1 }, { -1, 0, 0 } }
+    };
+
+    /* the corners of each face as multiples of the tangent and bitangent, making two counter-clockwise triangles */
+    const GLfloat corners [ 6 ][ 2 ] { { -1, -1 }, { +1, -1 }, { +1, +1 }, { -1, -1 }, { +1, +1 }, { -1, +1 } };
+
+    /* loop through the faces and their corners */
+    for ( const auto& face: faces )
+    {
+        const GLfloat * normal = face [ 0 ], * tangent = face [ 1 ];
+        const GLfloat bitangent [ 3 ] { normal [ 1 ] * tangent [ 2 ] - normal [ 2 ] * tangent [ 1 ], normal [ 2 ] * tangent [ 0 ] - normal [ 0 ] * tangent [ 2 ], normal [ 0 ] * tangent [ 1 ] - normal [ 1 ] * tangent [ 0 ] };
+        for ( const auto& corner: corners )
+        {
+            /* add the position, which is the centre moved by the half extents along the normal, tangent and bitangent */
+            for ( unsigned c = 0; c < 3; ++c )
+            {
+                const GLfloat centre = ( _box.min [ c ] + _box.max [ c ] ) * 0.5f, half_extent = ( _box.max [ c ] - _box.min [ c ] ) * 0.5f;
+                vertices.push_back ( centre + ( normal [ c ] + tangent [ c ] * corner [ 0 ] + bitangent [ c ] * corner [ 1 ] ) * half_extent );
+            }
+
+            /* add the normal and tangent */
+            vertices.insert ( vertices.end (), normal, normal + 3 );
+            vertices.insert ( vertices.end (), tangent, tangent + 3 );
+        }
+    }
+}
+
+/* apply_material
+ *
+ * set the material uniform of a program for a box, with empty texture stacks
+ *
+ * material_uni: the material uniform to set
+ * _box: the box to set the material of
+ */
+void apply_material ( glh::core::struct_uniform& material_uni, const box& _box )
+{
+    /* set each stack to its base color only */
+    for ( const char * stack: { "ambient_stack", "diffuse_stack", "specular_stack", "emission_stack", "normal_stack" } )
+    {
+        material_uni.get_struct_uniform ( stack ).get_uniform ( "stack_size" ).set_int ( 0 );
+        material_uni.get_struct_uniform ( stack ).get_uniform ( "base_color" ).set_vector
+            ( std::strcmp ( stack, "diffuse_stack" ) == 0 || std::strcmp ( stack, "ambient_stack" ) == 0 ? _box.diffuse :
+              std::strcmp ( stack, "emission_stack" ) == 0 ? glh::math::fvec4 { _box.emission.at ( 0 ), _box.emission.at ( 1 ), _box.emission.at ( 2 ), 1.0f } :
+              std::strcmp ( stack, "specular_stack" ) == 0 ? glh::math::fvec4 { 0.5f } : glh::math::fvec4 { 0.0f } );
+    }
+
+    /* set the remaining properties */
+    material_uni.get_uniform ( "blending_mode" ).set_int ( 0 );
+    material_uni.get_uniform ( "shininess" ).set_float ( 32.0f );
+    material_uni.get_uniform ( "shininess_strength" ).set_float ( 1.0f );
+    material_uni.get_uniform ( "opacity" ).set_float ( _box.opacity );
+    material_uni.get_uniform ( "definitely_opaque" ).set_int ( _box.opacity >= 1.0f );
+}
+
+/* make_sphere
+ *
+ * make a closed unit sphere from rings of vertices between two poles, where every edge is shared by two counter-clockwise triangles
+ *
+ * rings: the number of bands of triangles from pole to pole
+ * segments: the number of vertices around each ring
+ * positions: filled with the positions of the vertices
+ * triangles: filled with the triangles
+ */
+void make_sphere ( const unsigned rings, const unsigned segments, std::vector<glh::math::fvec3>& positions, std::vector<glh::lod::triangle>& triangles )
+{
+    /* add the north pole, the vertices of each ring, and the south pole */
+    positions.clear ();
+    positions.push_back ( glh::math::fvec3 { 0.0f, 1.0f, 0.0f } );
+    for ( unsigned i = 1; i < rings; ++i ) for ( unsigned j = 0; j < segments; ++j )
+    {
+        const double theta = glh::math::pi () * i / rings, phi = glh::math::pi ( 2.0 ) * j / segments;
+        positions.push_back ( glh::math::fvec3 { std::sin ( theta ) * std::cos ( phi ), std::cos ( theta ), -std::sin ( theta ) * std::sin ( phi ) } );
+    }
+    positions.push_back ( glh::math::fvec3 { 0.0f, -1.0f, 0.0f } );
+
+    /* ring_vertex
+     *
+     * get the index of a vertex on a ring, wrapping around the segments
+     */
+    const auto ring_vertex = [ & ] ( const unsigned ring, const unsigned segment ) { return 1 + ( ring - 1 ) * segments + segment % segments; };
+
+    /* add the fans around each pole, and two triangles between each pair of neighbouring rings */
+    triangles.clear ();
+    const unsigned south_pole = positions.size () - 1;
+    for ( unsigned j = 0; j < segments; ++j )
+    {
+        triangles.push_back ( glh::lod::triangle { 0, ring_vertex ( 1, j ), ring_vertex ( 1, j + 1 ) } );
+        for ( unsigned i = 1; i + 1 < rings; ++i )
+        {
+            triangles.push_back ( glh::lod::triangle { ring_vertex ( i, j ), ring_vertex ( i + 1, j ), ring_vertex ( i + 1, j + 1 ) } );
+            triangles.push_back ( glh::lod::triangle { ring_vertex ( i, j ), ring_vertex ( i + 1, j + 1 ), ring_vertex ( i, j + 1 ) } );
+        }
+        triangles.push_back ( glh::lod::triangle { ring_vertex ( rings - 1, j ), south_pole, ring_vertex ( rings - 1, j + 1 ) } );
+    }
+}
+
+
+
+/* num_mock_calls
+ * count_mock_call
+ *
+ * the number of calls made through the mock dispatch table, and the function which every entry of the table points to
+ */
+unsigned num_mock_calls = 0;
+template<class... Ts> void count_mock_call ( Ts... ) { ++num_mock_calls; }
+
+/* make_mock_dispatch
+ *
+ * make a dispatch table which counts calls rather than calling OpenGL
+ */
+glh::core::gl_dispatch make_mock_dispatch ()
+{
+    glh::core::gl_dispatch mock;
+    mock.enable = count_mock_call; mock.disable = count_mock_call; mock.enablei = count_mock_call; mock.disablei = count_mock_call;
+    mock.clear_color = count_mock_call; mock.clear = count_mock_call;
+    mock.depth_func = count_mock_call; mock.depth_mask = count_mock_call;
+    mock.stencil_func = count_mock_call; mock.stencil_op = count_mock_call; mock.stencil_mask = count_mock_call;
+    mock.blend_func_separate = count_mock_call; mock.blend_func_separatei = count_mock_call; mock.blend_equation_separate = count_mock_call; mock.blend_equation_separatei = count_mock_call;
+    mock.cull_face = count_mock_call; mock.front_face = count_mock_call; mock.polygon_mode = count_mock_call; mock.color_mask = count_mock_call; mock.viewport = count_mock_call; mock.scissor = count_mock_call;
+    mock.use_program = count_mock_call; mock.bind_vertex_array = count_mock_call; mock.bind_buffer = count_mock_call; mock.bind_buffer_base = count_mock_call; mock.bind_buffer_range = count_mock_call;
+    mock.bind_texture = count_mock_call; mock.bind_texture_unit = count_mock_call; mock.bind_textures = count_mock_call; mock.bind_sampler = count_mock_call;
+    mock.draw_arrays = count_mock_call; mock.draw_arrays_instanced_base_instance = count_mock_call; mock.draw_elements = count_mock_call; mock.draw_elements_instanced_base_instance = count_mock_call;
+    mock.dispatch_compute = count_mock_call; mock.dispatch_compute_indirect = count_mock_call;
+    return mock;
+}
+
+/* check_state_cache
+ *
+ * check through the mock dispatch table that the renderer makes calls for changes, and skips calls which would not change anything
+ *
+ * return: the number of checks which failed
+ */
+unsigned check_state_cache ()
+{
+    /* install the mock table, which also resets the state cache */
+    glh::core::renderer::set_dispatch ( make_mock_dispatch () );
+    unsigned num_failed = 0;
+
+    /* check_calls
+     *
+     * run an operation, and check that it made the expected number of calls
+     */
+    const auto check_calls = [ & ] ( const char * name, const unsigned expected_calls, const auto& operation )
+    {
+        num_mock_calls = 0;
+        operation ();
+        if ( num_mock_calls != expected_calls )
+        {
+            std::cerr << "state cache check failed: " << name << " made " << num_mock_calls << " calls, expected " << expected_calls << std::endl;
+            ++num_failed;
+        }
+    };
+
+    /* applying a render state makes calls for its settings, but applying it again or changing one setting makes only the calls needed */
+    const glh::core::render_state state = glh::core::render_state {}.with_depth_test ( true ).with_face_culling ( true ).with_blend ( true ).with_blend_func ( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA ).with_viewport ( 0, 0, 64, 64 );
+    check_calls ( "applying a render state", 5, [ & ] { glh::core::renderer::apply ( state ); } );
+    check_calls ( "applying the same render state", 0, [ & ] { glh::core::renderer::apply ( state ); } );
+    check_calls ( "changing the depth mask", 1, [ & ] { glh::core::renderer::apply ( state.with_depth_mask ( GL_FALSE ) ); } );
+
+    /* disabling multisample and restoring the previous state makes one call each, as when alpha testing by rasterisation */
+    check_calls ( "disabling multisample", 1, [ & ] { glh::core::renderer::apply ( state.with_depth_mask ( GL_FALSE ).with_multisample ( false ) ); } );
+    check_calls ( "disabling multisample again", 0, [] { glh::core::renderer::disable_multisample (); } );
+    check_calls ( "enabling multisample", 1, [ & ] { glh::core::renderer::apply ( state.with_depth_mask ( GL_FALSE ) ); } );
+
+    /* binding an object makes one call, and binding it again makes none */
+    check_calls ( "using a program twice", 1, [] { glh::core::renderer::use_program ( 5 ); glh::core::renderer::use_program ( 5 ); } );
+    check_calls ( "binding a vao twice", 1, [] { glh::core::renderer::bind_vertex_array ( 7 ); glh::core::renderer::bind_vertex_array ( 7 ); } );
+    check_calls ( "binding a buffer twice", 1, [] { glh::core::renderer::bind_buffer ( GL_ARRAY_BUFFER, 4 ); glh::core::renderer::bind_buffer ( GL_ARRAY_BUFFER, 4 ); } );
+    check_calls ( "binding an indexed buffer twice", 1, [] { glh::core::renderer::bind_buffer_base ( GL_UNIFORM_BUFFER, 2, 6 ); glh::core::renderer::bind_buffer_base ( GL_UNIFORM_BUFFER, 2, 6 ); } );
+    check_calls ( "binding a texture twice", 1, [] { glh::core::renderer::bind_texture_unit ( 3, 9 ); glh::core::renderer::bind_texture_unit ( 3, 9 ); } );
+    check_calls ( "binding a sampler twice", 1, [] { glh::core::renderer::bind_sampler ( 3, 2 ); glh::core::renderer::bind_sampler ( 3, 2 ); } );
+    check_calls ( "binding a different program", 1, [] { glh::core::renderer::use_program ( 6 ); } );
+
+    /* restore the OpenGL table, which resets the state cache again, as nothing was really bound */
+    glh::core::renderer::reset_dispatch ();
+    return num_failed;
+}
+
+/* check_texture_binding
+ *
+ * check that the default binds used to set up a texture keep the state cache of texture unit 0 coherent,
+ * so binding a texture back to unit 0 after setting up another is not skipped
+ *
+ * return: the number of checks which failed
+ */
+unsigned check_texture_binding ()
+{
+    /* bind the first texture to unit 0, then set up the second, which binds it to unit 0 by default */
+    glh::core::texture2d first_texture { 4, 4, GL_RGBA8 };
+    glh::core::texture2d second_texture;
+    first_texture.texture_base::bind ( 0 );
+    second_texture.tex_image ( 4, 4, GL_RGBA8 );
+
+    /* binding the first texture again should be a real call, so it is bound once more */
+    unsigned num_failed = 0;
+    GLint bound_texture = 0;
+    first_texture.texture_base::bind ( 0 );
+    glGetIntegerv ( GL_TEXTURE_BINDING_2D, &bound_texture );
+    if ( bound_texture != static_cast<GLint> ( first_texture.internal_id () ) ) { std::cerr << "texture binding check failed: unit 0 kept the texture which was set up" << std::endl; ++num_failed; }
+    return num_failed;
+}
+
+/* check_compute
+ *
+ * check that compute programs work by dispatching a program which writes the square of each index into an ssbo, then reading the values back
+ *
+ * return: the number of values which were wrong
+ */
+unsigned check_compute ()
+{
+    /* compile the sequence program */
+    glh::core::cshader sequence_cshader { "shaders/compute.sequence.glsl" };
+    glh::core::compute_program sequence_program { sequence_cshader };
+    sequence_program.compile_and_link ();
+
+    /* dispatch an invocation for each value, which is not a multiple of the work group size, so the bounds check in the shader is exercised */
+    const unsigned sequence_count = 1000;
+    glh::core::ssbo sequence_ssbo;
+    sequence_ssbo.buffer_storage ( sequence_count * sizeof ( unsigned ), NULL, GL_DYNAMIC_STORAGE_BIT | GL_MAP_READ_BIT | GL_MAP_WRITE_BIT );
+    sequence_ssbo.bind ( 0 );
+    sequence_program.get_uniform ( "count" ).set_uint ( sequence_count );
+    sequence_program.dispatch_invocations ( sequence_count );
+    glh::core::sync::buffer_update_barrier ();
+
+    /* read the values back and count those which are wrong */
+    unsigned num_failed = 0;
+    for ( unsigned i = 0; i < sequence_count; ++i ) num_failed += ( sequence_ssbo.at<unsigned> ( i ) != i * i );
+    sequence_ssbo.unmap_buffer ();
+    sequence_ssbo.unbind ( 0 );
+    if ( num_failed > 0 ) std::cerr << "compute check failed: " << num_failed << " of " << sequence_count << " values were wrong" << std::endl;
+    return num_failed;
+}
+
+
+
+/* check_ring_buffer
+ *
+ * check the alignment of allocations and writes to a ring buffer, binding a range of it, throwing once a frame region is full,
+ * and moving through the frame regions with next_frame, which should only count a stall when the GPU is still reading from the next region
+ *
+ * return: the number of checks which failed
+ */
+unsigned check_ring_buffer ()
+{
+    /* get the offset alignment of indexed bindings, which regions and default allocations are aligned to */
+    int uniform_alignment = 1, shader_storage_alignment = 1;
+    glGetIntegerv ( GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment );
+    glGetIntegerv ( GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &shader_storage_alignment );
+    const unsigned bind_alignment = std::max ( { uniform_alignment, shader_storage_alignment, 1 } );
+
+    /* create a ring buffer of two regions, whose size is not a multiple of the alignment */
+    unsigned num_failed = 0;
+    glh::core::ring_buffer ring { 1000, 2 };
+    if ( ring.get_region_size () < 1000 || ring.get_region_size () % bind_alignment != 0 || ring.get_size () != ring.get_region_size () * 2 )
+    {
+        std::cerr << "ring buffer check failed: the region size of " << ring.get_region_size () << " bytes is not rounded up to the alignment of " << bind_alignment << " bytes" << std::endl;
+        ++num_failed;
+    }
+
+    /* allocate, then write with the default alignment, then write with a smaller alignment straight after */
+    const std::array<GLfloat, 3> data { 1.0f, 2.0f, 3.0f };
+    const unsigned first = ring.allocate ( 10 );
+    const unsigned second = ring.write ( data.begin (), data.end () );
+    const unsigned third = ring.write ( data.data (), sizeof ( data ), sizeof ( GLfloat ) );
+    if ( first != 0 || second != ( ( 10 + bind_alignment - 1 ) / bind_alignment ) * bind_alignment || third != second + sizeof ( data ) || ring.get_region_used () != third + sizeof ( data ) ||
+         std::memcmp ( ring.get_pointer ( second ), data.data (), sizeof ( data ) ) != 0 || std::memcmp ( ring.get_pointer ( third ), data.data (), sizeof ( data ) ) != 0 )
+    {
+        std::cerr << "ring buffer check failed: allocations were made at offsets " << first << ", " << second << " and " << third << " with an alignment of " << bind_alignment << " bytes" << std::endl;
+        ++num_failed;
+    }
+
+    /* bind the second write to a uniform buffer index, and check the binding, then check that binding outside of the buffer throws */
+    ring.bind_range ( GL_UNIFORM_BUFFER, 7, second, sizeof ( data ) );
+    GLint bound_buffer = 0; GLint64 bound_start = 0, bound_size = 0;
+    glGetIntegeri_v ( GL_UNIFORM_BUFFER_BINDING, 7, &bound_buffer );
+    glGetInteger64i_v ( GL_UNIFORM_BUFFER_START, 7, &bound_start );
+    glGetInteger64i_v ( GL_UNIFORM_BUFFER_SIZE, 7, &bound_size );
+    if ( bound_buffer != static_cast<GLint> ( ring.internal_id () ) || bound_start != second || bound_size != sizeof ( data ) )
+    {
+        std::cerr << "ring buffer check failed: the bound range is buffer " << bound_buffer << " from " << bound_start << " of size " << bound_size << std::endl;
+        ++num_failed;
+    }
+    try
+    {
+        ring.bind_range ( GL_UNIFORM_BUFFER, 7, ring.get_size () - 4, sizeof ( data ) );
+        std::cerr << "ring buffer check failed: binding a range past the end of the buffer did not throw" << std::endl;
+        ++num_failed;
+    } catch ( const glh::exception::buffer_exception& ) {}
+    glh::core::renderer::bind_buffer_range ( GL_UNIFORM_BUFFER, 7, 0, 0, 0 );
+
+    /* allocating more than is left of the region throws */
+    try
+    {
+        ring.allocate ( ring.get_region_size () - ring.get_region_used () + 1, 1 );
+        std::cerr << "ring buffer check failed: allocating past the end of the frame region did not throw" << std::endl;
+        ++num_failed;
+    } catch ( const glh::exception::buffer_exception& ) {}
+
+    /* move through the regions, finishing the GPU before each move, so there must be no stalls */
+    for ( unsigned i = 0; i < 3; ++i ) { glFinish (); ring.next_frame (); }
+    if ( ring.get_num_frames () != 3 || ring.get_current_region () != 1 || ring.get_region_used () != 0 || ring.allocate ( 4, 4 ) != ring.get_region_size () || ring.get_num_stalls () != 0 )
+    {
+        std::cerr << "ring buffer check failed: after 3 frames with the GPU finished, the ring buffer is in region " << ring.get_current_region () << " with "
+                  << ring.get_num_stalls () << " stalls" << std::endl;
+        ++num_failed;
+    }
+
+    /* give the GPU a long compute dispatch, then move through both regions without finishing
+     * the fence of the first move is placed after the dispatch, so the second move stalls if the dispatch has not finished, in which case time must have been spent waiting
+     */
+    glh::core::cshader sequence_cshader { "shaders/compute.sequence.glsl" };
+    glh::core::compute_program sequence_program { sequence_cshader };
+    sequence_program.compile_and_link ();
+    const unsigned sequence_count = 1 << 22;
+    glh::core::ssbo sequence_ssbo;
+    sequence_ssbo.buffer_storage ( sequence_count * sizeof ( unsigned ), NULL, 0 );
+    sequence_ssbo.bind ( 0 );
+    sequence_program.get_uniform ( "count" ).set_uint ( sequence_count );
+    sequence_program.dispatch_invocations ( sequence_count );
+    sequence_ssbo.unbind ( 0 );
+    ring.next_frame (); ring.next_frame ();
+    if ( ring.get_num_stalls () > 1 || ( ring.get_num_stalls () > 0 ) != ( ring.get_stall_time () > 0.0 ) )
+    {
+        std::cerr << "ring buffer check failed: " << ring.get_num_stalls () << " stalls took " << ring.get_stall_time () << "s over 2 frames" << std::endl;
+        ++num_failed;
+    }
+
+    /* print the results */
+    if ( num_failed == 0 ) std::cout << "ring buffer check passed (" << ring.get_num_regions () << " regions of " << ring.get_region_size () << " bytes, " << ring.get_num_stalls () << " stalls over "
+                                     << ring.get_num_frames () << " frames)" << std::endl;
+    return num_failed;
+}
+
+
+
+/* check_reload
+ *
+ * check that a program loaded from the binary cache, which never compiled its shaders, is reloaded when one of its shader files changes
+ * the changed fragment shader declares a new uniform, which can only be found once the reloaded program has been swapped in
+ *
+ * return: the number of checks which failed
+ */
+unsigned check_reload ()
+{
+    /* write the shader files into their own directory, and cache binaries alongside them */
+    const std::string directory = OUTPUT_DIRECTORY "/reload";
+    std::filesystem::create_directories ( directory );
+    std::ofstream { directory + "/vertex.glsl" } << "void main () { gl_Position = vec4 ( 0.0, 0.0, 0.0, 1.0 ); }\n";
+    std::ofstream { directory + "/fragment.glsl" } << "out vec4 color;\nvoid main () { color = vec4 ( 1.0 ); }\n";
+    std::filesystem::remove_all ( directory + "/cache" );
+    glh::core::program::set_binary_cache_directory ( directory + "/cache" );
+
+    /* link the program once to fill the cache, then again from new shader objects, which should load it from the cache */
+    glh::core::vshader first_vshader { directory + "/vertex.glsl" }, vshader { directory + "/vertex.glsl" };
+    glh::core::fshader first_fshader { directory + "/fragment.glsl" }, fshader { directory + "/fragment.glsl" };
+    glh::core::program first_prog { first_vshader, first_fshader };
+    first_prog.compile_and_link ();
+    glh::core::program prog { vshader, fshader };
+    prog.compile_and_link ();
+    glh::core::program::set_binary_cache_directory ( "" );
+
+    /* skip the check if the driver cannot load binaries, as the program was then compiled as usual */
+    if ( !prog.is_loaded_from_binary_cache () )
+    {
+        std::cout << "reload check skipped (the driver did not load the program binary)" << std::endl;
+        return 0;
+    }
+
+    /* watch the program, change only the fragment shader, then update until the reload finishes or a few seconds pass */
+    glh::core::shader_reloader reloader;
+    reloader.add ( prog );
+    std::ofstream { directory + "/fragment.glsl" } << "out vec4 color;\nuniform vec4 tint;\nvoid main () { color = tint; }\n";
+    const auto start = std::chrono::steady_clock::now ();
+    while ( reloader.get_num_reloads () + reloader.get_num_failed_reloads () == 0 && std::chrono::steady_clock::now () - start < std::chrono::seconds { 5 } )
+    {
+        reloader.update ();
+        std::this_thread::sleep_for ( std::chrono::milliseconds { 10 } );
+    }
+
+    /* the program must have reloaded, and have the new uniform */
+    unsigned num_failed = 0;
+    if ( reloader.get_num_reloads () != 1 || reloader.get_num_failed_reloads () != 0 )
+    {
+        std::cerr << "reload check failed: " << reloader.get_num_reloads () << " reloads and " << reloader.get_num_failed_reloads () << " failed reloads after changing a shader of a cached program" << std::endl;
+        ++num_failed;
+    }
+    else try { prog.get_uniform ( "tint" ); } catch ( const glh::exception::exception& )
+    {
+        std::cerr << "reload check failed: the reloaded program does not have the uniform added to its shader" << std::endl;
+        ++num_failed;
+    }
+    reloader.remove ( prog );
+
+    /* print the reload time */
+    if ( num_failed == 0 ) std::cout << "reload check passed (reloaded a cached program in " << reloader.get_last_reload_time () << "ms)" << std::endl;
+    return num_failed;
+}
+
+
+
+/* check_lods
+ *
+ * check the levels of detail generated from a sphere, and the levels selected for projected sizes around the threshold
+ *
+ * return: the number of checks which failed
+ */
+unsigned check_lods ()
+{
+    unsigned num_failed = 0;
+
+    /* check
+     *
+     * count and report a failed check
+     */
+    const auto check = [ & ] ( const bool passed, const std::string& message )
+    {
+        if ( !passed ) { std::cerr << "lod check failed: " << message << std::endl; ++num_failed; }
+    };
+
+    /* generate levels from a sphere, with the same settings as models use by default */
+    std::vector<glh::math::fvec3> positions;
+    std::vector<glh::lod::triangle> triangles;
+    make_sphere ( 24, 48, positions, triangles );
+    const double max_error = 2.0 * std::sqrt ( 3.0 ) * LOD_MAX_RELATIVE_ERROR;
+    std::vector<glh::lod::simplification_report> reports;
+    const std::vector<std::vector<glh::lod::triangle>> levels = glh::lod::generate_lods ( positions, triangles, MAX_LODS, LOD_TRIANGLE_RATIO, max_error, &reports );
+    check ( !levels.empty () && reports.size () == levels.size (), "no levels were generated" );
+
+    /* each level must remove at least a quarter of the faces of the level before, and introduce no less error, while staying within the limit */
+    for ( unsigned i = 0; i < levels.size (); ++i )
+    {
+        const unsigned previous_faces = ( i == 0 ? triangles.size () : levels.at ( i - 1 ).size () );
+        const double previous_error = ( i == 0 ? 0.0 : reports.at ( i - 1 ).max_error );
+        check ( levels.at ( i ).size () <= previous_faces * 0.75, "level " + std::to_string ( i + 1 ) + " has " + std::to_string ( levels.at ( i ).size () ) + " faces, from " + std::to_string ( previous_faces ) );
+        check ( reports.at ( i ).result_triangles == levels.at ( i ).size (), "the report of level " + std::to_string ( i + 1 ) + " does not match its faces" );
+        check ( reports.at ( i ).max_error >= previous_error, "the error of level " + std::to_string ( i + 1 ) + " is less than the level before" );
+        check ( reports.at ( i ).max_error <= max_error, "the error of level " + std::to_string ( i + 1 ) + " exceeds the limit" );
+    }
+
+    /* sizes at least the threshold use the full detail, and each halving of the size below it uses the next level, until the coarsest */
+    const double threshold = 0.25;
+    const unsigned num_lods = 3;
+    check ( glh::lod::select_lod ( threshold, threshold, num_lods ) == 0 && glh::lod::select_lod ( threshold * 4.0, threshold, num_lods ) == 0, "a size at least the threshold did not select the full detail" );
+    for ( unsigned k = 1; k <= num_lods + 2; ++k )
+    {
+        const double size = threshold * 0.75 / std::pow ( 2.0, k - 1 );
+        check ( glh::lod::select_lod ( size, threshold, num_lods ) == std::min ( k, num_lods ), "a size of " + std::to_string ( size ) + " selected level " + std::to_string ( glh::lod::select_lod ( size, threshold, num_lods ) ) );
+    }
+    check ( glh::lod::select_lod ( 0.0, threshold, num_lods ) == num_lods && glh::lod::select_lod ( 0.01, threshold, 0 ) == 0, "a zero size or a mesh without levels selected the wrong level" );
+
+    /* a region seen from twice the distance projects to half the size, and a viewer inside the region sees an infinite size */
+    const glh::region::spherical_region<> region { glh::math::vec3 { 0.0, 0.0, 0.0 }, 1.0 };
+    const double near_size = glh::lod::projected_size ( region, glh::math::vec3 { 0.0, 0.0, 10.0 }, glh::math::rad ( 90.0 ) );
+    const double far_size = glh::lod::projected_size ( region, glh::math::vec3 { 0.0, 0.0, 20.0 }, glh::math::rad ( 90.0 ) );
+    check ( std::abs ( near_size - 0.1 ) < 1e-9 && std::abs ( far_size - near_size / 2.0 ) < 1e-9, "projected sizes were not inversely proportional to distance" );
+    check ( std::isinf ( glh::lod::projected_size ( region, glh::math::vec3 { 0.0, 0.0, 0.5 }, glh::math::rad ( 90.0 ) ) ), "a viewer inside a region did not see an infinite size" );
+
+    /* print the levels */
+    if ( num_failed == 0 )
+    {
+        std::cout << "lod check passed (" << triangles.size ();
+        for ( unsigned i = 0; i < levels.size (); ++i ) std::cout << " -> " << levels.at ( i ).size () << " faces, error " << reports.at ( i ).max_error;
+        std::cout << ")" << std::endl;
+    }
+    return num_failed;
+}
+
+
+
+/* check_meshlets
+ *
+ * check the meshlets built from a sphere, and that cone culling only culls meshlets which are entirely backfacing
+ *
+ * return: the number of checks which failed
+ */
+unsigned check_meshlets ()
+{
+    unsigned num_failed = 0;
+
+    /* check
+     *
+     * count and report a failed check
+     */
+    const auto check = [ & ] ( const bool passed, const std::string& message )
+    {
+        if ( !passed ) { std::cerr << "meshlet check failed: " << message << std::endl; ++num_failed; }
+    };
+
+    /* build meshlets from a sphere, with a flag and mesh index to be copied to each */
+    std::vector<glh::math::fvec3> positions;
+    std::vector<glh::lod::triangle> triangles;
+    make_sphere ( 24, 48, positions, triangles );
+    std::vector<glh::meshlet::meshlet> meshlets;
+    std::vector<unsigned> meshlet_vertices, meshlet_triangles;
+    const unsigned num_meshlets = glh::meshlet::build ( positions, triangles, meshlets, meshlet_vertices, meshlet_triangles, glh::meshlet::meshlet_flags::GLH_OPAQUE, 3 );
+    check ( num_meshlets > 1 && num_meshlets == meshlets.size (), "the sphere was not split into meshlets" );
+
+    /* unpack the triangles of each meshlet, checking its limits and that its bounding sphere contains its vertices */
+    std::vector<glh::lod::triangle> unpacked;
+    for ( const glh::meshlet::meshlet& _meshlet: meshlets )
+    {
+        check ( _meshlet.vertex_count <= GLH_MESHLET_MAX_VERTICES && _meshlet.triangle_count <= GLH_MESHLET_MAX_TRIANGLES, "a meshlet exceeds the vertex or triangle limit" );
+        check ( _meshlet.flags == glh::meshlet::meshlet_flags::GLH_OPAQUE && _meshlet.mesh_index == 3, "a meshlet does not have the flags and mesh index given" );
+        for ( unsigned i = 0; i < _meshlet.vertex_count; ++i )
+            check ( glh::math::modulus ( positions.at ( meshlet_vertices.at ( _meshlet.vertex_offset + i ) ) - _meshlet.centre ) <= _meshlet.radius * 1.0001f, "a meshlet's bounding sphere does not contain its vertices" );
+        for ( unsigned i = 0; i < _meshlet.triangle_count; ++i )
+        {
+            const unsigned packed = meshlet_triangles.at ( _meshlet.triangle_offset + i );
+            glh::lod::triangle tri;
+            for ( unsigned j = 0; j < 3; ++j ) tri.at ( j ) = meshlet_vertices.at ( _meshlet.vertex_offset + ( ( packed >> ( j * 8 ) ) & 0xff ) );
+            unpacked.push_back ( tri );
+        }
+    }
+
+    /* every triangle of the sphere must be in exactly one meshlet, with its winding kept */
+    const auto rotate_to_smallest = [] ( glh::lod::triangle tri ) { std::rotate ( tri.begin (), std::min_element ( tri.begin (), tri.end () ), tri.end () ); return tri; };
+    std::vector<glh::lod::triangle> expected;
+    for ( const glh::lod::triangle& tri: triangles ) expected.push_back ( rotate_to_smallest ( tri ) );
+    for ( glh::lod::triangle& tri: unpacked ) tri = rotate_to_smallest ( tri );
+    std::sort ( expected.begin (), expected.end () ); std::sort ( unpacked.begin (), unpacked.end () );
+    check ( expected == unpacked, "the triangles of the meshlets are not the triangles of the sphere" );
+
+    /* view the sphere from positions around it, near and far
+     * a meshlet may only be culled if every one of its triangles faces away from the viewer, and some meshlets must be culled from every position
+     */
+    unsigned num_culled = 0, num_tested = 0;
+    for ( const double distance: { 2.0, 20.0 } ) for ( const glh::math::vec3& direction:
+        { glh::math::vec3 { 1.0, 0.0, 0.0 }, glh::math::vec3 { 0.0, -1.0, 0.0 }, glh::math::vec3 { 0.0, 0.0, 1.0 }, glh::math::normalize ( glh::math::vec3 { -1.0, 1.0, 1.0 } ) } )
+    {
+        const glh::math::vec3 viewpos = direction * distance;
+        unsigned num_culled_here = 0;
+        for ( const glh::meshlet::meshlet& _meshlet: meshlets )
+        {
+            ++num_tested;
+            if ( !glh::meshlet::is_backfacing ( _meshlet, viewpos ) ) continue;
+            ++num_culled_here;
+            for ( unsigned i = 0; i < _meshlet.triangle_count; ++i )
+            {
+                const unsigned packed = meshlet_triangles.at ( _meshlet.triangle_offset + i );
+                const glh::math::vec3 p0 { positions.at ( meshlet_vertices.at ( _meshlet.vertex_offset + ( packed & 0xff ) ) ) };
+                const glh::math::vec3 p1 { positions.at ( meshlet_vertices.at ( _meshlet.vertex_offset + ( ( packed >> 8 ) & 0xff ) ) ) };
+                const glh::math::vec3 p2 { positions.at ( meshlet_vertices.at ( _meshlet.vertex_offset + ( ( packed >> 16 ) & 0xff ) ) ) };
+                check ( glh::math::dot ( glh::math::cross ( p1 - p0, p2 - p0 ), p0 - viewpos ) >= 0.0, "a meshlet with a front facing triangle was culled" );
+            }
+        }
+        check ( num_culled_here > 0, "no meshlets were culled from a distance of " + std::to_string ( distance ) );
+        num_culled += num_culled_here;
+    }
+
+    /* meshlets too large for 8-bit local indices must be rejected */
+    bool threw = false;
+    try { glh::meshlet::build ( positions, triangles, meshlets, meshlet_vertices, meshlet_triangles, 0, 0, 257 ); } catch ( const glh::exception::meshlet_exception& ) { threw = true; }
+    check ( threw, "meshlets with 257 vertices were not rejected" );
+
+    /* print the meshlets */
+    if ( num_failed == 0 ) std::cout << "meshlet check passed (" << triangles.size () << " faces in " << num_meshlets << " meshlets, " << num_culled << " of " << num_tested << " cone tests culled)" << std::endl;
+    return num_failed;
+}
+
+
+
+/* check_alpha_test
+ *
+ * check that alpha testing faces with the compute program gives the same results as the cpu, for faces across assets/alpha_test.png
+ * the image has opaque, transparent, translucent and checkered quarters, and is sampled by faces smaller than a texel and larger than the image,
+ * with each wrapping mode, two stack levels on different uv channels and varying vertex color alpha
+ *
+ * return: the number of faces whose results differed
+ */
+unsigned check_alpha_test ()
+{
+    /* load the image into both layers of a texture array */
+    const glh::core::image alpha_image { "assets/alpha_test.png" };
+    const glh::core::texture2d_array textures { alpha_image, alpha_image };
+
+    /* generate faces from a fixed seed, so that the check is repeatable
+     * each face has a random center and one of three sizes, and each vertex has a vertex color alpha of 0, 0.5 or 1
+     */
+    const unsigned num_uv_channels = TEXTURE_STACK_SIZE;
+    const unsigned num_faces = 1500;
+    std::uint32_t seed = 12345;
+    const auto random = [ & ] () { seed = seed * 1664525u + 1013904223u; return ( seed >> 8 ) / 16777216.0f; };
+    std::vector<float> face_data;
+    for ( unsigned i = 0; i < num_faces; ++i )
+    {
+        const float size = std::array<float, 3> { 0.02f, 0.3f, 1.5f }.at ( i % 3 );
+        std::array<float, num_uv_channels * 2> centers;
+        for ( float& center: centers ) center = random () * 2.0f - 0.5f;
+        for ( unsigned v = 0; v < 3; ++v )
+        {
+            for ( const float center: centers ) face_data.push_back ( center + size * ( random () - 0.5f ) );
+            face_data.push_back ( 0.5f * static_cast<unsigned> ( random () * 3.0f ) );
+        }
+    }
+
+    /* split the faces into a range for each wrapping mode, and give each a stack which multiplies the first uv channel and adds half of the second */
+    const std::array<GLenum, 3> wrappings { GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP_TO_BORDER };
+    std::vector<glh::alpha_test::stack> stacks;
+    std::vector<unsigned> first_faces;
+    for ( unsigned i = 0; i < wrappings.size (); ++i )
+    {
+        stacks.push_back ( glh::alpha_test::stack { 1.0f, alpha_image.get_width (), alpha_image.get_height (), wrappings.at ( i ), wrappings.at ( i ),
+            { glh::alpha_test::stack_level { &alpha_image, 0, 0, 1.0f }, glh::alpha_test::stack_level { &alpha_image, 1, 1, 0.5f } } } );
+        first_faces.push_back ( num_faces * i / wrappings.size () );
+    }
+    first_faces.push_back ( num_faces );
+
+    /* test on the cpu */
+    std::vector<const glh::alpha_test::stack *> stack_pointers;
+    for ( const glh::alpha_test::stack& _stack: stacks ) stack_pointers.push_back ( &_stack );
+    const std::vector<unsigned> cpu_results = glh::alpha_test::test_faces ( face_data, num_uv_channels, first_faces, stack_pointers );
+
+    /* test with the compute program, setting the diffuse stack before each dispatch */
+    auto alpha_test_program = glh::core::program_registry::get_compute ( { "shaders/materials.glsl", "shaders/compute.alpha_test.glsl" }, get_texture_stack_defines () );
+    glh::core::struct_uniform& diffuse_stack_uni = alpha_test_program->get_struct_uniform ( "material" ).get_struct_uniform ( "diffuse_stack" );
+    glh::alpha_test::compute_tester tester { * alpha_test_program, face_data, num_uv_channels };
+    for ( unsigned i = 0; i < stacks.size (); ++i )
+    {
+        diffuse_stack_uni.get_uniform ( "base_color" ).set_vector ( glh::math::fvec4 { 1.0f, 1.0f, 1.0f, stacks.at ( i ).base_alpha } );
+        diffuse_stack_uni.get_uniform ( "stack_size" ).set_int ( stacks.at ( i ).levels.size () );
+        for ( unsigned j = 0; j < stacks.at ( i ).levels.size (); ++j )
+        {
+            diffuse_stack_uni.get_struct_array_uniform ( "levels" ).at ( j ).get_uniform ( "blend_operation" ).set_int ( stacks.at ( i ).levels.at ( j ).blend_operation );
+            diffuse_stack_uni.get_struct_array_uniform ( "levels" ).at ( j ).get_uniform ( "blend_strength" ).set_float ( stacks.at ( i ).levels.at ( j ).blend_strength );
+            diffuse_stack_uni.get_struct_array_uniform ( "levels" ).at ( j ).get_uniform ( "uvwsrc" ).set_int ( stacks.at ( i ).levels.at ( j ).uvwsrc );
+        }
+        tester.dispatch ( textures, stacks.at ( i ), first_faces.at ( i ), first_faces.at ( i + 1 ) - first_faces.at ( i ) );
+    }
+    const std::vector<unsigned> gpu_results = tester.get_results ();
+
+    /* compare the results, and count the faces which are opaque, transparent and both by their diffuse alpha */
+    unsigned num_failed = 0;
+    std::array<unsigned, 4> num_diffuse_results { 0, 0, 0, 0 };
+    for ( unsigned i = 0; i < num_faces; ++i )
+    {
+        if ( cpu_results.at ( i ) != gpu_results.at ( i ) )
+        {
+            if ( num_failed++ < 10 ) std::cerr << "alpha test check failed: face " << i << " gave " << gpu_results.at ( i ) << " on the gpu but " << cpu_results.at ( i ) << " on the cpu" << std::endl;
+        } else ++num_diffuse_results.at ( ( cpu_results.at ( i ) >> 2 ) & 0x3 );
+    }
+
+    /* every kind of face must have occurred, or the check is not testing much */
+    if ( num_failed == 0 && std::count ( num_diffuse_results.begin (), num_diffuse_results.end (), 0 ) > 1 )
+    {
+        std::cerr << "alpha test check failed: the faces do not cover enough kinds of diffuse alpha" << std::endl;
+        ++num_failed;
+    }
+
+    /* print the results */
+    if ( num_failed == 0 ) std::cout << "alpha test check passed (" << num_faces << " faces: " << num_diffuse_results.at ( 1 ) << " opaque, " << num_diffuse_results.at ( 0 ) + num_diffuse_results.at ( 2 )
+                                     << " transparent or translucent, " << num_diffuse_results.at ( 3 ) << " mixed)" << std::endl;
+    return num_failed;
+}
+
+
+
+/* check_depth_pyramid
+ *
+ * check occlusion tests against a depth pyramid built from a depth texture of odd dimensions, whose readback level is a few levels down
+ * the depth texture is near everywhere, except for a far column and a far row close to the right and top edges,
+ * which the final texels of each level cover along with the odd columns and rows of the level before
+ * the view-projection matrix is the identity, so regions are placed directly in normalised device coordinates
+ *
+ * return: the number of checks which failed
+ */
+unsigned check_depth_pyramid ()
+{
+    /* the dimensions of the depth texture, and the far column and row */
+    const unsigned width = 541, height = 267, far_column = 528, far_row = 256;
+
+    /* create the depth texture */
+    std::vector<GLfloat> depths ( width * height, 0.1f );
+    for ( unsigned y = 0; y < height; ++y ) depths.at ( y * width + far_column ) = 1.0f;
+    for ( unsigned x = 0; x < width; ++x ) depths.at ( far_row * width + x ) = 1.0f;
+    glh::core::texture2d depth_texture { width, height, GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT, depths.data () };
+    depth_texture.set_min_filter ( GL_NEAREST ); depth_texture.set_mag_filter ( GL_NEAREST );
+
+    /* pixel_region
+     *
+     * get a region covering no more than a pixel of the depth texture, with its nearest depth in window coordinates just before depth
+     */
+    const auto pixel_region = [ & ] ( const unsigned x, const unsigned y, const double depth )
+    {
+        const double radius = 0.5 / width;
+        return glh::region::spherical_region<> { glh::math::vec3 { ( x + 0.5 ) * 2.0 / width - 1.0, ( y + 0.5 ) * 2.0 / height - 1.0, depth * 2.0 - 1.0 + radius }, radius };
+    };
+
+    /* nothing is occluded before the pyramid is built */
+    unsigned num_failed = 0;
+    glh::culling::depth_pyramid pyramid { width, height };
+    if ( pyramid.is_occluded ( pixel_region ( 10, 10, 0.5 ) ) )
+    {
+        std::cerr << "depth pyramid check failed: a region was occluded before the pyramid was built" << std::endl;
+        ++num_failed;
+    }
+
+    /* build the pyramid, and make sure that testing before reading back throws */
+    pyramid.build ( depth_texture, glh::math::identity<4> () );
+    try
+    {
+        pyramid.is_occluded ( pixel_region ( 10, 10, 0.5 ) );
+        std::cerr << "depth pyramid check failed: testing a region before reading back the pyramid did not throw" << std::endl;
+        ++num_failed;
+    } catch ( const glh::exception::culling_exception& ) {}
+    pyramid.readback ();
+
+    /* regions behind the near depth are occluded, and regions in front of it are not */
+    if ( !pyramid.is_occluded ( pixel_region ( 10, 10, 0.5 ) ) || !pyramid.is_occluded ( pixel_region ( far_column - 8, 10, 0.5 ) ) || pyramid.is_occluded ( pixel_region ( 10, 10, 0.05 ) ) )
+    {
+        std::cerr << "depth pyramid check failed: regions were not occluded by the near depth as expected" << std::endl;
+        ++num_failed;
+    }
+
+    /* regions behind the near depth, but over the far column or row, are not occluded */
+    if ( pyramid.is_occluded ( pixel_region ( far_column, 10, 0.5 ) ) || pyramid.is_occluded ( pixel_region ( 10, far_row, 0.5 ) ) )
+    {
+        std::cerr << "depth pyramid check failed: a region over the far column or row near the edge was occluded" << std::endl;
+        ++num_failed;
+    }
+
+    /* print the results */
+    if ( num_failed == 0 ) std::cout << "depth pyramid check passed (" << width << "x" << height << " depth texture read back at level " << pyramid.get_readback_level () << ", "
+                                     << pyramid.get_num_occluded () << " of " << pyramid.get_num_tests () << " regions occluded)" << std::endl;
+    return num_failed;
+}
+
+
+
+/* class depth_recorder : draw_source
+ *
+ * records the depth of each packet in the order they are submitted
+ */
+class depth_recorder : public glh::core::draw_source
+{
+public:
+
+    /* the depths of the packets submitted */
+    mutable std::vector<float> depths;
+
+    /* prepare_packet
+     *
+     * record the depth of the packet
+     */
+    void prepare_packet ( const glh::core::draw_packet& packet, const glh::core::draw_packet * ) const override { depths.push_back ( packet.depth ); }
+};
+
+
+
+/* check_parallel_recording
+ *
+ * check that recording a pass from several threads into separate queues, frustum culling as they go, then merging the queues,
+ * submits the same packets in the same order as recording the whole pass into one queue on one thread
+ *
+ * prog: the program to record the packets with
+ * vertex_arrays: the vao to record the packets with
+ *
+ * return: the number of checks which failed
+ */
+unsigned check_parallel_recording ( const glh::core::program& prog, const glh::core::vao& vertex_arrays )
+{
+    /* the packets are split into a number of chunks, each of which is recorded into its own queue */
+    const unsigned num_chunks = 8, chunk_size = 64;
+
+    /* cull against a camera at the origin looking down -z, which sees roughly the packets with small x */
+    const glh::math::mat4 view_proj = glh::math::perspective_fov ( glh::math::rad ( 60.0 ), 1.0, 0.5, 1000.0 );
+    const std::array<glh::core::render_state, 3> states
+    {
+        glh::core::render_state {}.with_depth_test ( true ).with_face_culling ( true ),
+        glh::core::render_state {}.with_depth_test ( true ).with_face_culling ( false ),
+        glh::core::render_state {}.with_depth_test ( true ).with_blend ( true )
+    };
+    const std::array<int, 5> materials {};
+
+    /* record_chunk
+     *
+     * record the packets of a chunk into a queue which survive frustum culling
+     * every packet has a unique depth, so the order they are submitted in can be compared through the depths
+     */
+    depth_recorder recorder;
+    const auto record_chunk = [ & ] ( glh::core::render_queue& queue, const glh::culling::frustum& _frustum, const unsigned chunk )
+    {
+        for ( unsigned i = chunk * chunk_size; i < ( chunk + 1 ) * chunk_size; ++i )
+        {
+            const double depth = 1.0 + i * 0.25;
+            const glh::region::spherical_region<> _region { glh::math::vec3 { ( i % 7 ) * 0.5 * depth - depth, 0.0, -depth }, 0.5 };
+            if ( _frustum.is_culled ( _region ) ) continue;
+            glh::core::draw_packet packet;
+            packet.prog = &prog; packet.vertex_arrays = &vertex_arrays; packet.source = &recorder;
+            packet.material = &materials.at ( ( i * 3 ) % materials.size () );
+            packet.depth = depth;
+            queue.record ( states.at ( ( i / 3 ) % states.size () ), packet );
+        }
+    };
+
+    /* record every chunk into one queue on this thread */
+    const glh::culling::frustum reference_frustum { view_proj };
+    glh::core::render_queue reference_queue;
+    for ( unsigned chunk = 0; chunk < num_chunks; ++chunk ) record_chunk ( reference_queue, reference_frustum, chunk );
+
+    /* record each chunk into its own queue on the shared thread pool, testing against one frustum from every thread, then merge the queues in chunk order */
+    const glh::culling::frustum parallel_frustum { view_proj };
+    std::vector<glh::core::render_queue> chunk_queues ( num_chunks );
+    glh::thread::thread_pool::get_shared ().parallel_for ( num_chunks, [ & ] ( const unsigned chunk ) { record_chunk ( chunk_queues.at ( chunk ), parallel_frustum, chunk ); } );
+    glh::core::render_queue merged_queue;
+    for ( glh::core::render_queue& queue: chunk_queues ) merged_queue.merge ( queue );
+
+    /* submit both queues, recording the order of the packets */
+    reference_queue.submit ();
+    const std::vector<float> reference_depths = std::move ( recorder.depths );
+    recorder.depths.clear ();
+    merged_queue.submit ();
+
+    /* the frustum statistics must agree, and some, but not all, packets must have been culled */
+    unsigned num_failed = 0;
+    if ( parallel_frustum.get_num_tests () != num_chunks * chunk_size || parallel_frustum.get_num_culled () != reference_frustum.get_num_culled () ||
+         reference_frustum.get_num_culled () == 0 || reference_frustum.get_num_culled () == num_chunks * chunk_size )
+    {
+        std::cerr << "parallel recording check failed: " << parallel_frustum.get_num_culled () << " of " << parallel_frustum.get_num_tests () << " regions culled from several threads, but "
+                  << reference_frustum.get_num_culled () << " of " << reference_frustum.get_num_tests () << " from one" << std::endl;
+        ++num_failed;
+    }
+
+    /* the merged queue must hold every packet and state, and submit the packets in the same order */
+    if ( merged_queue.get_num_packets () != reference_queue.get_num_packets () || merged_queue.get_num_render_states () != reference_queue.get_num_render_states () || recorder.depths != reference_depths )
+    {
+        std::cerr << "parallel recording check failed: the merged queues submitted " << recorder.depths.size () << " packets in a different order to the " << reference_depths.size () << " packets of one queue" << std::endl;
+        ++num_failed;
+    }
+
+    /* print the results */
+    if ( num_failed == 0 ) std::cout << "parallel recording check passed (" << merged_queue.get_num_packets () << " packets recorded into " << num_chunks << " queues by a thread pool of size "
+                                     << glh::thread::thread_pool::get_shared ().get_num_threads () << " and merged)" << std::endl;
+    return num_failed;
+}
+
+
+
+/* main */
+int main ( int argc, char ** argv )
+{
+    /* record missing golden images if --record is given */
+    const bool record = ( argc > 1 && std::strcmp ( argv [ 1 ], "--record" ) == 0 );
+
+    try
+    {
+        /* CREATE CONTEXT */
+
+        /* create a headless context, which is current from construction */
+        glh::headless::context context;
+        std::cout << "rendering with " << context.get_renderer () << ( context.is_surfaceless_platform () ? " (surfaceless)" : "" ) << std::endl;
+
+
+
+        /* CHECK STATE CACHE */
+
+        /* check that redundant state changes and binds are skipped, before anything is really bound */
+        if ( check_state_cache () > 0 ) return 1;
+        std::cout << "state cache check passed" << std::endl;
+
+
+
+        /* CHECK TEXTURE BINDING */
+
+        /* check that setting up a texture does not leave the state cache of texture unit 0 stale */
+        if ( check_texture_binding () > 0 ) return 1;
+        std::cout << "texture binding check passed" << std::endl;
+
+
+
+        /* CHECK COMPUTE */
+
+        /* check that a compute dispatch writes what the cpu expects */
+        if ( check_compute () > 0 ) return 1;
+        std::cout << "compute check passed" << std::endl;
+
+
+
+        /* CHECK RING BUFFER */
+
+        /* check allocating, writing, binding and moving through the frame regions of a ring buffer */
+        if ( check_ring_buffer () > 0 ) return 1;
+
+
+
+        /* CHECK RELOAD */
+
+        /* check that a program loaded from the binary cache can be reloaded */
+        if ( check_reload () > 0 ) return 1;
+
+
+
+        /* CHECK LEVELS OF DETAIL */
+
+        /* check level generation and selection, which is all on the cpu */
+        if ( check_lods () > 0 ) return 1;
+
+
+
+        /* CHECK MESHLETS */
+
+        /* check meshlet building and cone culling, which is all on the cpu */
+        if ( check_meshlets () > 0 ) return 1;
+
+
+
+        /* CHECK ALPHA TEST */
+
+        /* check that the compute program alpha tests faces as the cpu does */
+        if ( check_alpha_test () > 0 ) return 1;
+
+
+
+        /* CHECK DEPTH PYRAMID */
+
+        /* check occlusion tests against a depth pyramid */
+        if ( check_depth_pyramid () > 0 ) return 1;
+
+
+
+        /* SET UP PROGRAMS */
+
+        /* create model shader programs */
+        glh::core::vshader model_vshader { "shaders/materials.glsl", "shaders/camera.glsl", "shaders/vertex.model.glsl" };
+        glh::core::fshader forward_model_fshader { "shaders/materials.glsl", "shaders/camera.glsl", "shaders/lighting.glsl", "shaders/fragment.forward_model.glsl"  };
+        glh::core::program forward_model_program { model_vshader, forward_model_fshader };
+        glh::core::fshader deferred_model_fshader { "shaders/materials.glsl", "shaders/fragment.deferred_model.glsl" };
+        glh::core::program deferred_model_program { model_vshader, deferred_model_fshader };
+
+        /* create shadow shader program */
+        glh::core::vshader shadow_vshader { "shaders/materials.glsl", "shaders/vertex.shadow.glsl" };
+        glh::core::gshader shadow_gshader { "shaders/materials.glsl", "shaders/camera.glsl", "shaders/lighting.glsl", "shaders/geometry.shadow.glsl" };
+        glh::core::fshader shadow_fshader { "shaders/materials.glsl", "shaders/fragment.shadow.glsl" };
+        glh::core::program shadow_program { shadow_vshader, shadow_gshader, shadow_fshader };
+
+        /* create bloom and fxaa shader programs */
+        glh::core::vshader simple_vshader { "shaders/vertex.simple.glsl" };
+        glh::core::fshader bloom_fshader { "shaders/function.glsl", "shaders/fragment.bloom.glsl" };
+        glh::core::program bloom_program { simple_vshader, bloom_fshader };
+        glh::core::fshader fxaa_fshader { "shaders/fragment.fxaa.glsl" };
+        glh::core::program fxaa_program { simple_vshader, fxaa_fshader };
+
+        /* define the texture stack size and light maxima, then compile and link the programs */
+        const std::string shader_defines = get_texture_stack_defines () + glh::lighting::light_system::get_shader_defines ();
+        for ( glh::core::shader * s: std::initializer_list<glh::core::shader *> { &model_vshader, &forward_model_fshader, &deferred_model_fshader, &shadow_vshader, &shadow_gshader, &shadow_fshader } )
+            s->add_defines ( shader_defines );
+        glh::core::program_set programs { forward_model_program, deferred_model_program, shadow_program, bloom_program, fxaa_program };
+        programs.compile_all ( true );
+
+        /* bind the camera and light system blocks of each program to shared ubos */
+        glh::core::ubo camera_ubo, light_system_ubo;
+        camera_ubo.bind ( 0 ); light_system_ubo.bind ( 1 );
+        forward_model_program.set_uniform_block_binding ( "camera_block", 0 );
+        forward_model_program.set_uniform_block_binding ( "light_system_block", 1 );
+        deferred_model_program.set_uniform_block_binding ( "camera_block", 0 );
+        shadow_program.set_uniform_block_binding ( "light_system_block", 1 );
+
+        /* create the lighting program permutations */
+        glh::core::program_permutations lighting_permutations
+        {
+            { "shaders/vertex.simple.glsl" }, {}, { "shaders/materials.glsl", "shaders/camera.glsl", "shaders/lighting.glsl", "shaders/fragment.lighting.glsl" },
+            glh::lighting::light_system::get_permutation_features (), shader_defines
+        };
+        lighting_permutations.set_build_callback ( [] ( glh::core::program& prog )
+        {
+            prog.set_uniform_block_binding ( "camera_block", 0 );
+            prog.set_uniform_block_binding ( "light_system_block", 1 );
+        } );
+
+        /* extract uniforms */
+        auto& forward_model_shadow_maps_uni = forward_model_program.get_uniform ( "light_system_shadow_maps" );
+        auto& forward_model_material_uni = forward_model_program.get_struct_uniform ( "material" );
+        auto& deferred_model_material_uni = deferred_model_program.get_struct_uniform ( "material" );
+        auto& deferred_model_transparent_mode_uni = deferred_model_program.get_uniform ( "transparent_mode" );
+        auto& shadow_material_uni = shadow_program.get_struct_uniform ( "material" );
+        auto& bloom_texture_uni = bloom_program.get_uniform ( "bloom_texture" );
+        auto& bloom_mode_uni = bloom_program.get_uniform ( "bloom_mode" );
+        auto& bloom_function_uni = bloom_program.get_struct_uniform ( "bloom_function" );
+        auto& bloom_radius_uni = bloom_program.get_uniform ( "bloom_radius" );
+        auto& fxaa_texture_uni = fxaa_program.get_uniform ( "fxaa_texture" );
+
+
+
+        /* SET UP SCENE */
+
+        /* the boxes of the scene: a floor, two opaque boxes, an emissive box and a transparent pane */
+        const std::vector<box> boxes
+        {
+            { { -10.0f, -1.0f, -10.0f }, { 10.0f, 0.0f, 10.0f }, glh::math::fvec4 { 0.6f, 0.6f, 0.6f, 1.0f }, glh::math::fvec3 { 0.0f }, 1.0f },
+            { { -4.0f, 0.0f, -2.0f }, { -2.0f, 2.0f, 0.0f }, glh::math::fvec4 { 0.8f, 0.2f, 0.2f, 1.0f }, glh::math::fvec3 { 0.0f }, 1.0f },
+            { { 1.0f, 0.0f, -4.0f }, { 3.0f, 5.0f, -2.0f }, glh::math::fvec4 { 0.2f, 0.3f, 0.8f, 1.0f }, glh::math::fvec3 { 0.0f }, 1.0f },
+            { { 3.0f, 0.0f, 1.0f }, { 4.0f, 1.0f, 2.0f }, glh::math::fvec4 { 1.0f, 0.9f, 0.3f, 1.0f }, glh::math::fvec3 { 1.0f, 0.8f, 0.2f }, 1.0f },
+            { { -1.0f, 0.0f, 2.0f }, { 1.0f, 3.0f, 2.2f }, glh::math::fvec4 { 0.2f, 0.9f, 0.3f, 1.0f }, glh::math::fvec3 { 0.0f }, 0.5f }
+        };
+
+        /* put the vertices of every box in one vbo, with a vao reading position, normal and tangent */
+        std::vector<GLfloat> vertices;
+        for ( const box& _box: boxes ) append_box ( vertices, _box );
+        glh::core::vbo scene_vbo;
+        scene_vbo.buffer_storage ( vertices.begin (), vertices.end () );
+        glh::core::vao scene_vao;
+        scene_vao.set_vertex_attrib ( 0, scene_vbo, 3, GL_FLOAT, GL_FALSE, 9 * sizeof ( GLfloat ), 0 );
+        scene_vao.set_vertex_attrib ( 1, scene_vbo, 3, GL_FLOAT, GL_FALSE, 9 * sizeof ( GLfloat ), 3 * sizeof ( GLfloat ) );
+        scene_vao.set_vertex_attrib ( 2, scene_vbo, 3, GL_FLOAT, GL_FALSE, 9 * sizeof ( GLfloat ), 6 * sizeof ( GLfloat ) );
+
+        /* draw_boxes
+         *
+         * draw the boxes which are opaque or transparent, setting the material uniform for each
+         */
+        const auto draw_boxes = [ & ] ( glh::core::struct_uniform& material_uni, const bool transparent )
+        {
+            scene_vao.bind ();
+            for ( unsigned i = 0; i < boxes.size (); ++i ) if ( ( boxes.at ( i ).opacity < 1.0f ) == transparent )
+            {
+                apply_material ( material_uni, boxes.at ( i ) );
+                glh::core::renderer::draw_arrays ( GL_TRIANGLES, i * 36, 36 );
+            }
+            scene_vao.unbind ();
+        };
+
+        /* CHECK RENDER QUEUE ORDER */
+
+        /* record empty draws into a back to front queue, alternating between the one and two sided states a model records transparent meshes with
+         * they must be submitted in depth order regardless of their state, otherwise transparent meshes do not blend correctly
+         */
+        {
+            const glh::core::render_state one_sided_state = glh::core::render_state {}.with_depth_test ( true ).with_face_culling ( true ).with_blend ( true );
+            const glh::core::render_state two_sided_state = one_sided_state.with_face_culling ( false );
+            depth_recorder recorder;
+            glh::core::render_queue transparent_queue { true };
+            for ( const float depth: { 3.0f, 12.0f, 0.5f, 7.0f, 25.0f, 1.0f, 9.0f, 4.0f } )
+            {
+                glh::core::draw_packet packet;
+                packet.prog = &forward_model_program; packet.vertex_arrays = &scene_vao; packet.source = &recorder;
+                packet.depth = depth;
+                transparent_queue.record ( transparent_queue.get_num_packets () % 2 ? two_sided_state : one_sided_state, packet );
+            }
+            transparent_queue.submit ();
+            if ( !std::is_sorted ( recorder.depths.rbegin (), recorder.depths.rend () ) || recorder.depths.size () != 8 )
+            {
+                std::cerr << "render queue check failed: transparent packets with different states were not submitted back to front" << std::endl;
+                return 1;
+            }
+            std::cout << "render queue check passed (" << recorder.depths.size () << " packets in " << transparent_queue.get_num_render_states () << " states submitted back to front)" << std::endl;
+        }
+
+        /* check that recording into several queues from worker threads and merging them submits as recording into one queue does */
+        if ( check_parallel_recording ( forward_model_program, scene_vao ) > 0 ) return 1;
+
+
+
+        /* SET UP CAMERA AND LIGHTS */
+
+        /* create the camera, looking down at the scene */
+        glh::camera::camera_perspective_movement camera
+        {
+            glh::math::vec3 { 0.0, 8.0, 12.0 }, glh::math::vec3 { 0.0, -0.5, -1.0 }, glh::math::vec3 { 0.0, 1.0, 0.0 },
+            glh::math::rad ( 75.0 ), 16.0 / 9.0, 0.5, 100.0
+        };
+
+        /* create a light system with a shadow mapped light of each type, all covering the scene */
+        const glh::region::spherical_region<> scene_region { glh::math::vec3 { 0.0, 0.0, 0.0 }, 15.0 };
+        glh::lighting::light_system light_system { SHADOW_MAP_WIDTH };
+        light_system.add_dirlight
+        (
+            glh::math::vec3 { 1.0, -1.0, -0.5 },
+            glh::math::vec3 { 0.15 }, glh::math::vec3 { 0.5 }, glh::math::vec3 { 0.3 },
+            scene_region, true, true, 0.005, 8, 2. / light_system.get_shadow_map_width ()
+        );
+        light_system.add_pointlight
+        (
+            glh::math::vec3 ( -5, 6, 4 ), 1.0, 0.05, 0.01,
+            glh::math::vec3 { 0.0 }, glh::math::vec3 { 0.6 }, glh::math::vec3 { 0.6 },
+            scene_region, true, true, 0.003, 8, 2. / light_system.get_shadow_map_width ()
+        );
+        light_system.add_spotlight
+        (
+            glh::math::vec3 ( 6, 10, 6 ), -glh::math::vec3 ( 6, 10, 6 ),
+            glh::math::rad ( 20 ), glh::math::rad ( 30 ), 1.0, 0.01, 0.001,
+            glh::math::vec3 { 0.0 }, glh::math::vec3 { 0.8 }, glh::math::vec3 { 0.8 },
+            scene_region, true, true, 0.003, 8, 2. / light_system.get_shadow_map_width ()
+        );
+
+        /* upload the camera and lights */
+        camera.apply ( camera_ubo );
+        light_system.apply ( light_system_ubo );
+
+
+
+        /* SET UP FRAMEBUFFERS */
+
+        /* create bloom textures and framebuffers */
+        glh::core::texture2d bloom_texture_alpha { RESOLUTION, GL_RGBA8 };
+        glh::core::texture2d bloom_texture_beta { RESOLUTION, GL_RGBA8 };
+        for ( glh::core::texture2d * t: { &bloom_texture_alpha, &bloom_texture_beta } ) { t->set_min_filter ( GL_NEAREST ); t->set_mag_filter ( GL_NEAREST ); t->set_wrap ( GL_CLAMP_TO_EDGE ); }
+        glh::core::fbo bloom_fbo_alpha, bloom_fbo_beta;
+        bloom_fbo_alpha.attach_texture ( bloom_texture_alpha, GL_COLOR_ATTACHMENT0 );
+        bloom_fbo_beta.attach_texture ( bloom_texture_beta, GL_COLOR_ATTACHMENT0 );
+
+        /* create the depth texture and gbuffer textures */
+        glh::core::texture2d depth_texture, gbuffer_positionshininess, gbuffer_normalsstrength, gbuffer_albedospec;
+        depth_texture.tex_storage ( RESOLUTION, GL_DEPTH_COMPONENT32F, 1 );
+        gbuffer_positionshininess.tex_storage ( RESOLUTION, GL_RGBA32F, 1 );
+        gbuffer_normalsstrength.tex_storage ( RESOLUTION, GL_RGBA32F, 1 );
+        gbuffer_albedospec.tex_storage ( RESOLUTION, GL_RGBA8, 1 );
+        for ( glh::core::texture2d * t: { &depth_texture, &gbuffer_positionshininess, &gbuffer_normalsstrength, &gbuffer_albedospec } ) { t->set_min_filter ( GL_NEAREST ); t->set_mag_filter ( GL_NEAREST ); t->set_wrap ( GL_CLAMP_TO_EDGE ); }
+
+        /* create the gbuffer framebuffer */
+        glh::core::fbo gbuffer_fbo;
+        gbuffer_fbo.attach_texture ( gbuffer_positionshininess, GL_COLOR_ATTACHMENT0 );
+        gbuffer_fbo.attach_texture ( gbuffer_normalsstrength, GL_COLOR_ATTACHMENT1 );
+        gbuffer_fbo.attach_texture ( gbuffer_albedospec, GL_COLOR_ATTACHMENT2 );
+        gbuffer_fbo.attach_texture ( bloom_texture_beta, GL_COLOR_ATTACHMENT3 );
+        gbuffer_fbo.attach_texture ( depth_texture, GL_DEPTH_ATTACHMENT );
+        gbuffer_fbo.draw_buffers ( GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 );
+
+        /* create the final color framebuffer, and the transparent framebuffer which shares its color and the depth of the gbuffer */
+        glh::core::texture2d final_color_texture { RESOLUTION, GL_RGBA8 };
+        final_color_texture.set_min_filter ( GL_NEAREST ); final_color_texture.set_mag_filter ( GL_NEAREST ); final_color_texture.set_wrap ( GL_CLAMP_TO_EDGE );
+        glh::core::fbo final_color_fbo;
+        final_color_fbo.attach_texture ( final_color_texture, GL_COLOR_ATTACHMENT0 );
+        glh::core::fbo transparent_fbo;
+        transparent_fbo.attach_texture ( final_color_texture, GL_COLOR_ATTACHMENT0 );
+        transparent_fbo.attach_texture ( bloom_texture_beta, GL_COLOR_ATTACHMENT1 );
+        transparent_fbo.attach_texture ( depth_texture, GL_DEPTH_ATTACHMENT );
+        transparent_fbo.draw_buffers ( GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 );
+
+        /* create the fxaa framebuffer, in place of the default framebuffer of a window */
+        glh::core::texture2d fxaa_texture { RESOLUTION, GL_RGBA8 };
+        glh::core::fbo fxaa_fbo;
+        fxaa_fbo.attach_texture ( fxaa_texture, GL_COLOR_ATTACHMENT0 );
+        const glh::core::sampler& linear_clamp_sampler = glh::core::sampler::get_cached ( glh::core::sampler::parameters {}.with_filter ( GL_LINEAR, GL_LINEAR ).with_wrap ( GL_CLAMP_TO_EDGE ) );
+
+        /* create the quad vao */
+        glh::core::vbo quad_vbo;
+        quad_vbo.buffer_storage ( glh::vertices::square_vertex_data.begin (), glh::vertices::square_vertex_data.end () );
+        glh::core::vao quad_vao;
+        quad_vao.set_vertex_attrib ( 0, quad_vbo, 3, GL_FLOAT, GL_FALSE, 3 * sizeof ( GLfloat ), 0 );
+
+        /* create the bloom function */
+        const double bloom_func_rms = 1.0;
+        glh::function::gaussian_function<double, double> bloom_func { 1.00 / ( std::sqrt ( glh::math::pi ( 2.0 ) ) * bloom_func_rms ), 0.0, bloom_func_rms };
+        glh::function::glsl_function<1> glsl_bloom_func { bloom_func, 1024, -5.0, 5.0 };
+        glsl_bloom_func.cache_uniforms ( bloom_function_uni );
+
+        /* create the render state of each pass */
+        glh::core::renderer::set_clear_color ( glh::math::vec4 { 0.0, 0.0, 0.0, 1.0 } );
+        glh::core::renderer::enable_framebuffer_srgb ();
+        const glh::core::render_state shadow_state = glh::core::render_state {}.with_depth_test ( true ).with_face_culling ( true ).with_viewport ( 0, 0, SHADOW_MAP_WIDTH, SHADOW_MAP_WIDTH );
+        const glh::core::render_state gbuffer_state = glh::core::render_state {}.with_depth_test ( true ).with_face_culling ( true ).with_viewport ( 0, 0, RESOLUTION );
+        const glh::core::render_state transparent_state = gbuffer_state.with_depth_mask ( GL_FALSE ).with_blend ( true )
+            .with_blend_func ( 0, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA ).with_blend_func ( 1, GL_ONE, GL_ONE );
+        const glh::core::render_state fullscreen_state = glh::core::render_state {}.with_viewport ( 0, 0, RESOLUTION );
+        const glh::core::render_state additive_state = fullscreen_state.with_blend ( true ).with_blend_func ( GL_ONE, GL_ONE );
+
+
+
+        /* RENDER */
+
+        /* render the shadow maps */
+        light_system.bind_shadow_maps_fbo ();
+        shadow_program.use ();
+        glh::core::renderer::apply ( shadow_state );
+        glh::core::renderer::clear ( GL_DEPTH_BUFFER_BIT );
+        draw_boxes ( shadow_material_uni, false );
+
+        /* render the opaque boxes into the gbuffer */
+        gbuffer_fbo.bind ();
+        deferred_model_program.use ();
+        deferred_model_transparent_mode_uni.set_int ( 2 );
+        glh::core::renderer::apply ( gbuffer_state );
+        glh::core::renderer::clear ( GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT );
+        draw_boxes ( deferred_model_material_uni, false );
+
+        /* light the gbuffer into the final color framebuffer */
+        final_color_fbo.bind ();
+        glh::core::program& lighting_program = lighting_permutations.get ( lighting_permutations.make_key ( light_system.get_permutation_values () ) );
+        lighting_program.use ();
+        lighting_program.get_uniform ( "gbuffer_positionshininess" ).set_int ( gbuffer_positionshininess.bind_loop () );
+        lighting_program.get_uniform ( "gbuffer_normalsstrength" ).set_int ( gbuffer_normalsstrength.bind_loop () );
+        lighting_program.get_uniform ( "gbuffer_albedospec" ).set_int ( gbuffer_albedospec.bind_loop () );
+        light_system.apply_shadow_maps ( lighting_program.get_uniform ( "light_system_shadow_maps" ) );
+        glh::core::renderer::apply ( fullscreen_state );
+        quad_vao.bind ();
+        glh::core::renderer::draw_arrays ( GL_TRIANGLE_STRIP, 0, 4 );
+        quad_vao.unbind ();
+
+        /* forward render the transparent boxes on top */
+        transparent_fbo.bind ();
+        forward_model_program.use ();
+        light_system.apply_shadow_maps ( forward_model_shadow_maps_uni );
+        glh::core::renderer::apply ( transparent_state );
+        draw_boxes ( forward_model_material_uni, true );
+
+        /* blur the emission and add it to the final color */
+        bloom_program.use ();
+        glsl_bloom_func.apply ();
+        bloom_radius_uni.set_int ( 3 );
+        quad_vao.bind ();
+        bloom_fbo_alpha.bind ();
+        glh::core::renderer::apply ( fullscreen_state );
+        bloom_texture_uni.set_int ( bloom_texture_beta.bind_loop () );
+        bloom_mode_uni.set_int ( 0 );
+        glh::core::renderer::draw_arrays ( GL_TRIANGLE_STRIP, 0, 4 );
+        final_color_fbo.bind ();
+        glh::core::renderer::apply ( additive_state );
+        bloom_texture_uni.set_int ( bloom_texture_alpha.bind_loop () );
+        bloom_mode_uni.set_int ( 1 );
+        glh::core::renderer::draw_arrays ( GL_TRIANGLE_STRIP, 0, 4 );
+
+        /* apply fxaa into the fxaa framebuffer */
+        fxaa_fbo.bind ();
+        fxaa_program.use ();
+        fxaa_texture_uni.set_int ( final_color_texture.bind_loop ( linear_clamp_sampler ) );
+        fxaa_program.get_uniform ( "contrast_constant_threshold" ).set_float ( 0.01 );
+        fxaa_program.get_uniform ( "contrast_relative_threshold" ).set_float ( 0.02 );
+        glh::core::renderer::apply ( fullscreen_state );
+        glh::core::renderer::draw_arrays ( GL_TRIANGLE_STRIP, 0, 4 );
+        quad_vao.unbind ();
+        fxaa_fbo.unbind ();
+
+
+
+        /* COMPARE AGAINST GOLDEN IMAGES */
+
+        /* compare the output of each pass, failing on missing golden images unless recording */
+        glh::headless::image_regression regression { GOLDEN_DIRECTORY, OUTPUT_DIRECTORY, 2, 0.001, !record };
+        for ( const auto& image: std::initializer_list<std::pair<const char *, const glh::core::texture2d *>>
+            { { "regression_albedo", &gbuffer_albedospec }, { "regression_bloom", &bloom_texture_alpha }, { "regression_final_color", &final_color_texture }, { "regression_fxaa", &fxaa_texture } } )
+        {
+            const bool passed = regression.compare ( image.first, * image.second );
+            std::cout << image.first << ": " << ( passed ? "passed" : "FAILED" ) << " (" << regression.get_last_differing_fraction () * 100.0 << "% of pixels differ)" << std::endl;
+        }
+        std::cout << "regression: " << regression.get_num_passed () << " passed, " << regression.get_num_failed () << " failed, " << regression.get_num_recorded () << " recorded" << std::endl;
+
+        /* destroy the cached samplers while the context still exists */
+        glh::core::sampler::clear_cache ();
+
+        /* fail if any comparison failed */
+        if ( regression.get_num_failed () > 0 )
+        {
+            std::cerr << "regression failed: see the images in " OUTPUT_DIRECTORY << std::endl;
+            return 1;
+        }
+    }
+
+    /* fail on any exception */
+    catch ( const std::exception& e )
+    {
+        std::cerr << "regression failed: " << e.what () << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -17,4 +17,14 @@ struct camera_struct
     mat4 view_proj;
     
     vec3 viewpos;
-};
\ No newline at end of file
+};
+
+
+
+/* UNIFORM BLOCKS */
+
+/* the camera, shared by all programs through the camera_block binding */
+layout ( std140 ) uniform camera_block
+{
+    camera_struct camera;
+};
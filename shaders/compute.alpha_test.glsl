@@ -0,0 +1,172 @@
+/*
+ * compute.alpha_test.glsl
+ *
+ * compute shader to query about primative alpha values, with a work group for each face
+ *
+ * each face is sampled at its centroid, its vertices and the center of every texel of the diffuse texture stack it covers
+ * the texels are found in the uv space of the level of the diffuse stack with the largest texcoords area,
+ * and if a face covers more texels than the stack has in either direction, it is sampled at most once per texel of the stack in that direction
+ */
+
+
+
+/* WORK GROUP */
+
+/* 8x8 invocations per face */
+layout ( local_size_x = 8, local_size_y = 8 ) in;
+
+
+
+/* DEFINITIONS */
+
+/* the number of floats per vertex and per face of the input face data: the texcoords of each uv channel, then the vertex color alpha */
+#define VERTEX_STRIDE ( MAX_TEXTURE_STACK_SIZE * 2 + 1 )
+#define FACE_STRIDE ( VERTEX_STRIDE * 3 )
+
+
+
+/* SSBOS */
+
+/* input ssbo containing the texcoords and vertex color alpha of each vertex of each face */
+layout ( std430, binding = 0 ) readonly buffer face_ssbo
+{
+    float face_data [];
+};
+
+/* output ssbo containing 4 bits for each face, 8 faces to an unsigned integer */
+layout ( std430, binding = 1 ) buffer output_ssbo
+{
+    uint output_data [];
+};
+
+
+
+/* UNIFORMS */
+
+/* material uniforms */
+uniform material_struct material;
+
+/* the index of the first face to test in the face data, and the number of faces to test */
+uniform uint first_face;
+uniform uint num_faces;
+
+
+
+/* SHARED */
+
+/* the output mask of the face, combined across the work group */
+shared uint face_mask;
+
+
+
+/* FUNCTIONS */
+
+/* sample_face
+ *
+ * sample the face at barycentric coordinates and return its output mask
+ */
+uint sample_face ( const uint face_offset, const vec3 barycentric, const uint bit_offset )
+{
+    /* interpolate the vertex color alpha and the texcoords of each uv channel */
+    float vcolor_alpha = 0.0;
+    vec2 texcoords [ MAX_TEXTURE_STACK_SIZE ];
+    for ( int i = 0; i < MAX_TEXTURE_STACK_SIZE; ++i ) texcoords [ i ] = vec2 ( 0.0 );
+    for ( int v = 0; v < 3; ++v )
+    {
+        const uint vertex_offset = face_offset + v * VERTEX_STRIDE;
+        for ( int i = 0; i < MAX_TEXTURE_STACK_SIZE; ++i ) texcoords [ i ] += vec2 ( face_data [ vertex_offset + i * 2 ], face_data [ vertex_offset + i * 2 + 1 ] ) * barycentric [ v ];
+        vcolor_alpha += face_data [ vertex_offset + MAX_TEXTURE_STACK_SIZE * 2 ] * barycentric [ v ];
+    }
+
+    /* sample the alpha of the diffuse stack */
+    const float diffuse_alpha = evaluate_stack_w ( material.diffuse_stack, texcoords );
+
+    /* create the output mask */
+    uint output_mask = 0;
+    output_mask |= uint ( vcolor_alpha >= 0.98 ) << ( bit_offset );
+    output_mask |= uint ( vcolor_alpha >= 0.02 && vcolor_alpha <= 0.98 ) << ( bit_offset + 1 );
+    output_mask |= uint ( diffuse_alpha >= 0.98 ) << ( bit_offset + 2 );
+    output_mask |= uint ( diffuse_alpha >= 0.02 && diffuse_alpha <= 0.98 ) << ( bit_offset + 3 );
+    return output_mask;
+}
+
+
+
+/* MAIN */
+
+/* main */
+void main ()
+{
+    /* get the face of the work group, and whether it is past the end, which is the same for the whole work group
+     * the work group cannot just return if past the end, as barriers may not follow a return
+     */
+    const uint local_face = gl_WorkGroupID.y * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+    const bool valid_face = local_face < num_faces;
+    const uint face = first_face + min ( local_face, num_faces - 1 );
+    const uint face_offset = face * FACE_STRIDE;
+
+    /* get the bit offset of the face */
+    const uint bit_offset = ( face % 8 ) * 4;
+
+    /* the first invocation samples the centroid and each vertex, so that every face is sampled even if it covers no texel centers */
+    if ( valid_face && gl_LocalInvocationIndex == 0 )
+    {
+        face_mask = sample_face ( face_offset, vec3 ( 1.0 / 3.0 ), bit_offset );
+        face_mask |= sample_face ( face_offset, vec3 ( 1.0, 0.0, 0.0 ), bit_offset );
+        face_mask |= sample_face ( face_offset, vec3 ( 0.0, 1.0, 0.0 ), bit_offset );
+        face_mask |= sample_face ( face_offset, vec3 ( 0.0, 0.0, 1.0 ), bit_offset );
+    }
+    barrier ();
+
+    /* find the uv channel of the level of the diffuse stack with the largest texcoords area */
+    int uv_channel = -1;
+    float max_texcoords_area = 0.0;
+    for ( int i = 0; valid_face && i < material.diffuse_stack.stack_size; ++i )
+    {
+        const int uvwsrc = material.diffuse_stack.levels [ i ].uvwsrc;
+        const vec2 uv0 = vec2 ( face_data [ face_offset + uvwsrc * 2 ], face_data [ face_offset + uvwsrc * 2 + 1 ] );
+        const vec2 uv1 = vec2 ( face_data [ face_offset + VERTEX_STRIDE + uvwsrc * 2 ], face_data [ face_offset + VERTEX_STRIDE + uvwsrc * 2 + 1 ] );
+        const vec2 uv2 = vec2 ( face_data [ face_offset + VERTEX_STRIDE * 2 + uvwsrc * 2 ], face_data [ face_offset + VERTEX_STRIDE * 2 + uvwsrc * 2 + 1 ] );
+        const float texcoords_area = abs ( ( uv1.x - uv0.x ) * ( uv2.y - uv0.y ) - ( uv2.x - uv0.x ) * ( uv1.y - uv0.y ) );
+        if ( texcoords_area > max_texcoords_area ) { max_texcoords_area = texcoords_area; uv_channel = uvwsrc; }
+    }
+
+    /* if there is a uv channel with any area, sample the center of each texel covered */
+    uint local_mask = 0;
+    if ( uv_channel >= 0 )
+    {
+        /* get the uvs of the face in texel space */
+        const vec2 stack_size = vec2 ( textureSize ( material.diffuse_stack.textures, 0 ).xy );
+        const vec2 uv0 = vec2 ( face_data [ face_offset + uv_channel * 2 ], face_data [ face_offset + uv_channel * 2 + 1 ] ) * stack_size;
+        const vec2 uv1 = vec2 ( face_data [ face_offset + VERTEX_STRIDE + uv_channel * 2 ], face_data [ face_offset + VERTEX_STRIDE + uv_channel * 2 + 1 ] ) * stack_size;
+        const vec2 uv2 = vec2 ( face_data [ face_offset + VERTEX_STRIDE * 2 + uv_channel * 2 ], face_data [ face_offset + VERTEX_STRIDE * 2 + uv_channel * 2 + 1 ] ) * stack_size;
+
+        /* find the texels covered by the bounding box of the face, and the step between samples, which is greater than one texel if the box is larger than the stack */
+        const vec2 min_texel = floor ( min ( uv0, min ( uv1, uv2 ) ) );
+        const vec2 max_texel = ceil ( max ( uv0, max ( uv1, uv2 ) ) );
+        const vec2 step = max ( ( max_texel - min_texel ) / stack_size, vec2 ( 1.0 ) );
+        const uvec2 num_samples = uvec2 ( ceil ( ( max_texel - min_texel ) / step ) );
+
+        /* loop over the samples of this invocation, keeping the samples inside the face */
+        const float area = ( uv1.x - uv0.x ) * ( uv2.y - uv0.y ) - ( uv2.x - uv0.x ) * ( uv1.y - uv0.y );
+        for ( uint y = gl_LocalInvocationID.y; y < num_samples.y; y += gl_WorkGroupSize.y ) for ( uint x = gl_LocalInvocationID.x; x < num_samples.x; x += gl_WorkGroupSize.x )
+        {
+            /* find the barycentric coordinates of the sample */
+            const vec2 p = min_texel + ( vec2 ( x, y ) + 0.5 ) * step;
+            const vec3 barycentric = vec3
+            (
+                ( uv1.x - p.x ) * ( uv2.y - p.y ) - ( uv2.x - p.x ) * ( uv1.y - p.y ),
+                ( uv2.x - p.x ) * ( uv0.y - p.y ) - ( uv0.x - p.x ) * ( uv2.y - p.y ),
+                ( uv0.x - p.x ) * ( uv1.y - p.y ) - ( uv1.x - p.x ) * ( uv0.y - p.y )
+            ) / area;
+
+            /* sample if inside the face */
+            if ( all ( greaterThanEqual ( barycentric, vec3 ( 0.0 ) ) ) ) local_mask |= sample_face ( face_offset, barycentric, bit_offset );
+        }
+    }
+
+    /* combine the masks of the work group, then set the output integer */
+    atomicOr ( face_mask, local_mask );
+    barrier ();
+    if ( valid_face && gl_LocalInvocationIndex == 0 ) atomicOr ( output_data [ face / 8 ], face_mask );
+}
@@ -0,0 +1,44 @@
+/*
+ * compute.sequence.glsl
+ * 
+ * compute shader to write the square of each index into an ssbo, used to check that compute programs work
+ */
+
+
+
+/* WORK GROUP */
+
+/* one-dimensional work groups of 64 invocations */
+layout ( local_size_x = 64 ) in;
+
+
+
+/* SSBO */
+
+/* output ssbo containing the squares */
+layout ( std430, binding = 0 ) buffer output_ssbo
+{
+    uint output_data [];
+};
+
+
+
+/* UNIFORMS */
+
+/* the number of values to write */
+uniform uint count;
+
+
+
+/* MAIN */
+
+/* main */
+void main ()
+{
+    /* ignore invocations past the end, as the number of work groups is rounded up */
+    const uint index = gl_GlobalInvocationID.x;
+    if ( index >= count ) return;
+
+    /* write the square of the index */
+    output_data [ index ] = index * index;
+}
@@ -0,0 +1,63 @@
+/*
+ * fragment.depth_pyramid.glsl
+ *
+ * fragment shader to downsample a level of a depth pyramid
+ * each output texel is the maximum (furthest) depth of the source texels it covers
+ */
+
+
+
+/* INPUTS AND OUTPUTS */
+
+/* input texcoords */
+in VS_OUT
+{
+    vec2 texcoords;
+} vs_out;
+
+/* output depth */
+out float max_depth;
+
+
+
+/* UNIFORMS */
+
+/* the texture to downsample
+ * this is either the depth texture or the previous level of the pyramid, with its base level set to that level
+ */
+uniform sampler2D source_texture;
+
+
+
+/* MAIN */
+
+/* main */
+void main ()
+{
+    /* get the size of the source and the texel to start sampling from */
+    const ivec2 source_size = textureSize ( source_texture, 0 );
+    const ivec2 source_texel = ivec2 ( gl_FragCoord.xy ) * 2;
+
+    /* find the maximum of the 2x2 block of texels */
+    max_depth = max
+    (
+        max ( texelFetch ( source_texture, min ( source_texel + ivec2 ( 0, 0 ), source_size - 1 ), 0 ).r, texelFetch ( source_texture, min ( source_texel + ivec2 ( 1, 0 ), source_size - 1 ), 0 ).r ),
+        max ( texelFetch ( source_texture, min ( source_texel + ivec2 ( 0, 1 ), source_size - 1 ), 0 ).r, texelFetch ( source_texture, min ( source_texel + ivec2 ( 1, 1 ), source_size - 1 ), 0 ).r )
+    );
+
+    /* if the source has an odd width or height, the final column or row of the output must also cover the extra texels of the source */
+    const bool extra_column = ( source_size.x % 2 == 1 ) && ( source_texel.x + 3 == source_size.x );
+    const bool extra_row = ( source_size.y % 2 == 1 ) && ( source_texel.y + 3 == source_size.y );
+    if ( extra_column )
+    {
+        max_depth = max ( max_depth, texelFetch ( source_texture, min ( source_texel + ivec2 ( 2, 0 ), source_size - 1 ), 0 ).r );
+        max_depth = max ( max_depth, texelFetch ( source_texture, min ( source_texel + ivec2 ( 2, 1 ), source_size - 1 ), 0 ).r );
+    }
+    if ( extra_row )
+    {
+        max_depth = max ( max_depth, texelFetch ( source_texture, min ( source_texel + ivec2 ( 0, 2 ), source_size - 1 ), 0 ).r );
+        max_depth = max ( max_depth, texelFetch ( source_texture, min ( source_texel + ivec2 ( 1, 2 ), source_size - 1 ), 0 ).r );
+    }
+    if ( extra_column && extra_row )
+        max_depth = max ( max_depth, texelFetch ( source_texture, min ( source_texel + ivec2 ( 2, 2 ), source_size - 1 ), 0 ).r );
+}
@@ -27,12 +27,10 @@ layout ( location = 1 ) out vec3 emission_fragcolor;
 
 /* UNIFORMS */
 
-/* material and lighting uniforms */
+/* material uniforms (the lights are in light_system_block, see lighting.glsl) */
 uniform material_struct material;
-uniform light_system_struct light_system;
 
-/* camera matrices */
-uniform camera_struct camera;
+/* camera matrices are in camera_block (see camera.glsl) */
 
 /* transparency modes are: 
  *
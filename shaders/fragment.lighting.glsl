@@ -30,12 +30,10 @@ uniform sampler2D gbuffer_normalsstrength;
 /* fragment albedo and specular colors */
 uniform sampler2D gbuffer_albedospec;
 
-/* material and lighting uniforms */
+/* material uniforms (the lights are in light_system_block, see lighting.glsl) */
 uniform material_struct material;
-uniform light_system_struct light_system;
 
-/* camera matrices */
-uniform camera_struct camera;
+/* camera matrices are in camera_block (see camera.glsl) */
 
 
 
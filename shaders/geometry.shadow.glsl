@@ -31,8 +31,7 @@ out GS_OUT
 
 /* UNIFORMS */
 
-/* light system */
-uniform light_system_struct light_system;
+/* the light system is in light_system_block (see lighting.glsl) */
 
 
 
@@ -40,7 +39,7 @@ uniform light_system_struct light_system;
 void main ()
 {
     /* loop through dirlights */
-    for ( int i = 0; i < light_system.dirlights_size; ++i )
+    for ( int i = 0; i < DIRLIGHTS_SIZE; ++i )
     {
         /* continue if light is disabled */
         if ( !light_system.dirlights [ i ].enabled || !light_system.dirlights [ i ].shadow_mapping_enabled ) continue;
@@ -52,7 +51,7 @@ void main ()
     }
 
     /* loop through pointlights */
-    for ( int i = 0; i < light_system.pointlights_size; ++i )
+    for ( int i = 0; i < POINTLIGHTS_SIZE; ++i )
     {
         /* continue if light is disabled */
         if ( !light_system.pointlights [ i ].enabled || !light_system.pointlights [ i ].shadow_mapping_enabled ) continue;
@@ -60,7 +59,7 @@ void main ()
         /* set to render to the front texture
          * the front texture is defined by all points where z >= 0
          */
-        gl_Layer = light_system.dirlights_size + i * 2;
+        gl_Layer = DIRLIGHTS_SIZE + i * 2;
 
         /* three vectors in preparation for caching position vectors */
         vec3 cached_positions [ 3 ];
@@ -98,7 +97,7 @@ void main ()
         EndPrimitive ();
         
         /* set to render to the back texture */
-        gl_Layer = light_system.dirlights_size + i * 2 + 1;
+        gl_Layer = DIRLIGHTS_SIZE + i * 2 + 1;
         
         /* do similar to the above, except using the cached depths where appropriate
          * the x and y components of the cached position is now divided by 1.0 MINUS the cached z component, since z should be <= 0.0
@@ -120,13 +119,13 @@ void main ()
     }
     
     /* loop through dirlights */
-    for ( int i = 0; i < light_system.spotlights_size; ++i )
+    for ( int i = 0; i < SPOTLIGHTS_SIZE; ++i )
     {
         /* continue if light is disabled */
         if ( !light_system.spotlights [ i ].enabled || !light_system.spotlights [ i ].shadow_mapping_enabled ) continue;
 
         /* set the layer */
-        gl_Layer = light_system.dirlights_size + light_system.pointlights_size * 2 + i;
+        gl_Layer = DIRLIGHTS_SIZE + POINTLIGHTS_SIZE * 2 + i;
 
         /* set the positions and depths of all of the vertices, then emit the primative
          * the depth linear by using the distance to the light, and mapped to 0-1 by multiplying by shadow_depth_range_mult
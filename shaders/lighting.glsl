@@ -9,9 +9,45 @@
 
 /* DEFINITIONS */
 
-#define MAX_NUM_DIRLIGHTS 1
-#define MAX_NUM_POINTLIGHTS 1
-#define MAX_NUM_SPOTLIGHTS 1
+/* maximum number of each type of light, which may be defined by glh::lighting::light_system::get_shader_defines */
+#ifndef MAX_NUM_DIRLIGHTS
+    #define MAX_NUM_DIRLIGHTS 1
+#endif
+#ifndef MAX_NUM_POINTLIGHTS
+    #define MAX_NUM_POINTLIGHTS 1
+#endif
+#ifndef MAX_NUM_SPOTLIGHTS
+    #define MAX_NUM_SPOTLIGHTS 1
+#endif
+
+/* the number of each type of light to loop over
+ * NUM_DIRLIGHTS/POINTLIGHTS/SPOTLIGHTS may be defined to build a variant for a particular light system, so that the loops can be unrolled
+ * otherwise the sizes in the light system are used
+ */
+#ifdef NUM_DIRLIGHTS
+    #define DIRLIGHTS_SIZE NUM_DIRLIGHTS
+#else
+    #define DIRLIGHTS_SIZE light_system.dirlights_size
+#endif
+#ifdef NUM_POINTLIGHTS
+    #define POINTLIGHTS_SIZE NUM_POINTLIGHTS
+#else
+    #define POINTLIGHTS_SIZE light_system.pointlights_size
+#endif
+#ifdef NUM_SPOTLIGHTS
+    #define SPOTLIGHTS_SIZE NUM_SPOTLIGHTS
+#else
+    #define SPOTLIGHTS_SIZE light_system.spotlights_size
+#endif
+
+/* whether shadow mapping is enabled for a light
+ * NO_SHADOWS may be defined to build a variant for a light system without shadow mapping, which removes all shadow map sampling
+ */
+#ifdef NO_SHADOWS
+    #define SHADOW_MAPPING_ENABLED( light ) false
+#else
+    #define SHADOW_MAPPING_ENABLED( light ) ( light.shadow_mapping_enabled )
+#endif
 
 
 
@@ -99,12 +135,27 @@ struct light_system_struct
 
     int spotlights_size;
     spotlight_struct spotlights [ MAX_NUM_SPOTLIGHTS ];
+};
+
+
+
+/* UNIFORM BLOCKS */
 
-    sampler2DArrayShadow shadow_maps;
+/* the light system, shared by all programs through the light_system_block binding */
+layout ( std140 ) uniform light_system_block
+{
+    light_system_struct light_system;
 };
 
 
 
+/* UNIFORMS */
+
+/* the shadow maps of the light system, which cannot be stored in the block */
+uniform sampler2DArrayShadow light_system_shadow_maps;
+
+
+
 /* FUNCTIONS */
 
 /* compute_attenuation
@@ -204,14 +255,14 @@ vec3 compute_lighting ( const vec3 ambient_light, const vec3 diffuse_light, cons
     const vec3 viewdir = normalize ( viewpos - fragpos );
 
     /* iterate through directional lighting */
-    for ( int i = 0; i < light_system.dirlights_size; ++i )
+    for ( int i = 0; i < DIRLIGHTS_SIZE; ++i )
     {
         /* continue if disabled */
         if ( !light_system.dirlights [ i ].enabled ) continue;
 
         /* calculate shadow_constant */
         float shadow_constant = 1.0;
-        if ( light_system.dirlights [ i ].shadow_mapping_enabled ) 
+        if ( SHADOW_MAPPING_ENABLED ( light_system.dirlights [ i ] ) ) 
         { 
             /* transform the fragment position using the light's shadow matrices 
              * then transform into the range [0-1]
@@ -226,7 +277,7 @@ vec3 compute_lighting ( const vec3 ambient_light, const vec3 diffuse_light, cons
             if ( light_system.dirlights [ i ].pcf_samples == 0 ) 
             { 
                 /* sample the shadow map to get the shadow constant */ 
-                shadow_constant = texture ( light_system.shadow_maps, vec4 ( fragpos_light_proj.xy, i, fragpos_light_proj.z ) ); 
+                shadow_constant = texture ( light_system_shadow_maps, vec4 ( fragpos_light_proj.xy, i, fragpos_light_proj.z ) ); 
             } else 
             { 
                 /* set the initial sample offset */ 
@@ -237,9 +288,9 @@ vec3 compute_lighting ( const vec3 ambient_light, const vec3 diffuse_light, cons
                 for ( int j = 0; j < light_system.dirlights [ i ].pcf_samples; ++j ) 
                 { 
                     /* sample shadow map and rotate offset */ 
-                    shadow_constant += texture ( light_system.shadow_maps, vec4 ( fragpos_light_proj.xy + pcf_sample_offset, i, fragpos_light_proj.z ) ); 
+                    shadow_constant += texture ( light_system_shadow_maps, vec4 ( fragpos_light_proj.xy + pcf_sample_offset, i, fragpos_light_proj.z ) ); 
                     pcf_sample_offset = light_system.dirlights [ i ].pcf_rotation * pcf_sample_offset; 
-                    shadow_constant += texture ( light_system.shadow_maps, vec4 ( fragpos_light_proj.xy + pcf_sample_offset * 0.5, i, fragpos_light_proj.z ) ); 
+                    shadow_constant += texture ( light_system_shadow_maps, vec4 ( fragpos_light_proj.xy + pcf_sample_offset * 0.5, i, fragpos_light_proj.z ) ); 
                     pcf_sample_offset = light_system.dirlights [ i ].pcf_rotation * pcf_sample_offset; 
                 } 
                 
@@ -260,7 +311,7 @@ vec3 compute_lighting ( const vec3 ambient_light, const vec3 diffuse_light, cons
     } 
     
     /* iterate through point lighting */ 
-    for ( int i = 0; i < light_system.pointlights_size; ++i ) 
+    for ( int i = 0; i < POINTLIGHTS_SIZE; ++i ) 
     { 
         /* continue if disabled */ 
         if ( !light_system.pointlights [ i ].enabled ) continue; 
@@ -276,14 +327,14 @@ vec3 compute_lighting ( const vec3 ambient_light, const vec3 diffuse_light, cons
          
         /* calculate shadow_constant */ 
         float shadow_constant = 1.0; 
-        if ( light_system.pointlights [ i ].shadow_mapping_enabled ) 
+        if ( SHADOW_MAPPING_ENABLED ( light_system.pointlights [ i ] ) ) 
         { 
             /* transform the fragment position for dual-parabolic sampling 
              * lightdir.xy is negated, since lightdir is from the fragment to the light - opposite to the incident ray
              * the absolute of lightdir.z is used, since this will be correct or whichever side of the dual-paraboloid map is chosen to be used
              * the expression 'int ( -lightdir.z <= 0.0 )' equates to 1 or 0, depending on whether the front or back paraboloid should be sampled from
              */ 
-            vec4 fragpos_light_proj = vec4 ( ( -lightdir.xy / ( 1.0 + abs ( lightdir.z ) ) ) * 0.5 + 0.5, light_system.dirlights_size + i * 2 + int ( -lightdir.z <= 0.0 ), 
+            vec4 fragpos_light_proj = vec4 ( ( -lightdir.xy / ( 1.0 + abs ( lightdir.z ) ) ) * 0.5 + 0.5, DIRLIGHTS_SIZE + i * 2 + int ( -lightdir.z <= 0.0 ), 
                 lightdist * light_system.pointlights [ i ].shadow_depth_range_mult - 
                 max ( light_system.pointlights [ i ].shadow_bias * ( 1.0 - compute_diffuse_constant ( lightdir, normal ) ), 0.001 ) ); 
             
@@ -291,7 +342,7 @@ vec3 compute_lighting ( const vec3 ambient_light, const vec3 diffuse_light, cons
             if ( light_system.pointlights [ i ].pcf_samples == 0 ) 
             { 
                 /* sample the shadow map to get the shadow constant */ 
-                shadow_constant = texture ( light_system.shadow_maps, fragpos_light_proj ); 
+                shadow_constant = texture ( light_system_shadow_maps, fragpos_light_proj ); 
             } else 
             { 
                 /* set the initial sample offset */ 
@@ -302,12 +353,12 @@ vec3 compute_lighting ( const vec3 ambient_light, const vec3 diffuse_light, cons
                 for ( int j = 0; j < light_system.pointlights [ i ].pcf_samples; j += 2 ) 
                 { 
                     /* sample the shadow map using the radius and rotate */ 
-                    shadow_constant += texture ( light_system.shadow_maps, 
+                    shadow_constant += texture ( light_system_shadow_maps, 
                         vec4 ( fragpos_light_proj.xy + pcf_sample_offset * 1.0, fragpos_light_proj.zw ) ); 
                     pcf_sample_offset = light_system.pointlights [ i ].pcf_rotation * pcf_sample_offset; 
                     
                     /* sample the shadow map with half the radius and rotate */ 
-                    shadow_constant += texture ( light_system.shadow_maps, 
+                    shadow_constant += texture ( light_system_shadow_maps, 
                         vec4 ( fragpos_light_proj.xy + pcf_sample_offset * 0.5, fragpos_light_proj.zw ) ); 
                     pcf_sample_offset = light_system.pointlights [ i ].pcf_rotation * pcf_sample_offset; 
                 } 
@@ -328,7 +379,7 @@ vec3 compute_lighting ( const vec3 ambient_light, const vec3 diffuse_light, cons
     } 
     
     /* iterate through spot lighting */ 
-    for ( int i = 0; i < light_system.spotlights_size; ++i ) 
+    for ( int i = 0; i < SPOTLIGHTS_SIZE; ++i ) 
     { 
         /* continue if disabled */ 
         if ( !light_system.spotlights [ i ].enabled ) continue; 
@@ -347,7 +398,7 @@ vec3 compute_lighting ( const vec3 ambient_light, const vec3 diffuse_light, cons
         
         /* calculate shadow_constant */ 
         float shadow_constant = 1.0; 
-        if ( light_system.spotlights [ i ].shadow_mapping_enabled ) 
+        if ( SHADOW_MAPPING_ENABLED ( light_system.spotlights [ i ] ) ) 
         { 
             /* transform the fragment position using the light's shadow matrices */ 
             vec4 fragpos_light_proj = light_system.spotlights [ i ].shadow_trans * vec4 ( fragpos, 1.0 ); 
@@ -358,7 +409,7 @@ vec3 compute_lighting ( const vec3 ambient_light, const vec3 diffuse_light, cons
              * also take into account the angle of the surface to the light's position
              */ 
             fragpos_light_proj = vec4 ( ( fragpos_light_proj.xy / fragpos_light_proj.w ) * 0.5 + 0.5, 
-                light_system.dirlights_size + light_system.pointlights_size * 2 + i, 
+                DIRLIGHTS_SIZE + POINTLIGHTS_SIZE * 2 + i, 
                 lightdist * light_system.spotlights [ i ].shadow_depth_range_mult 
                 - max ( light_system.spotlights [ i ].shadow_bias * ( 1.0 - compute_diffuse_constant ( lightdir, normal ) ), 0.001 ) ); 
             
@@ -366,7 +417,7 @@ vec3 compute_lighting ( const vec3 ambient_light, const vec3 diffuse_light, cons
             if ( light_system.spotlights [ i ].pcf_samples == 0 ) 
             { 
                 /* sample the shadow map to get the shadow constant */ 
-                shadow_constant = texture ( light_system.shadow_maps, fragpos_light_proj ); 
+                shadow_constant = texture ( light_system_shadow_maps, fragpos_light_proj ); 
             } else 
             { 
                 /* set the initial sample offset */ 
@@ -377,12 +428,12 @@ vec3 compute_lighting ( const vec3 ambient_light, const vec3 diffuse_light, cons
                 for ( int j = 0; j < light_system.spotlights [ i ].pcf_samples; j += 2 ) 
                 { 
                     /* sample shadow map with the full radius and rotate */ 
-                    shadow_constant += texture ( light_system.shadow_maps, 
+                    shadow_constant += texture ( light_system_shadow_maps, 
                         vec4 ( fragpos_light_proj.xy + pcf_sample_offset, fragpos_light_proj.zw ) ); 
                     pcf_sample_offset = light_system.spotlights [ i ].pcf_rotation * pcf_sample_offset; 
                     
                     /* sample the shadow map with half the radius and rotate */ 
-                    shadow_constant += texture ( light_system.shadow_maps, 
+                    shadow_constant += texture ( light_system_shadow_maps, 
                         vec4 ( fragpos_light_proj.xy + pcf_sample_offset * 0.5, fragpos_light_proj.zw ) ); 
                     pcf_sample_offset = light_system.spotlights [ i ].pcf_rotation * pcf_sample_offset; 
                 } 
@@ -8,8 +8,10 @@
 
 /* DEFINITIONS */
 
-/* maximum number of textures in texture stack */
-#define MAX_TEXTURE_STACK_SIZE 2
+/* maximum number of textures in texture stack, which may be defined by glh::model::model::get_shader_defines */
+#ifndef MAX_TEXTURE_STACK_SIZE
+    #define MAX_TEXTURE_STACK_SIZE 2
+#endif
 
 
 
@@ -0,0 +1,31 @@
+/*
+ * meshlets.glsl
+ *
+ * defines structures for meshlets
+ *
+ */
+
+
+
+/* STRUCTURES */
+
+/* structure for a meshlet
+ * matches glh::meshlet::meshlet under std430 packing
+ * the triangles of a meshlet are three 8-bit indices into its range of vertices, packed into a uint
+ */
+struct meshlet_struct
+{
+    vec3 centre;
+    float radius;
+
+    vec3 cone_axis;
+    float cone_cutoff;
+
+    uint vertex_offset;
+    uint vertex_count;
+    uint triangle_offset;
+    uint triangle_count;
+
+    uint flags;
+    uint mesh_index;
+};
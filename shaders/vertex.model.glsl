@@ -28,8 +28,7 @@ out VS_OUT
 
 /* UNIFORMS */
 
-/* camera matrices */
-uniform camera_struct camera;
+/* camera matrices are in camera_block (see camera.glsl) */
 
 
 
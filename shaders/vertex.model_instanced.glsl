@@ -0,0 +1,64 @@
+/*
+ * vertex.model_instanced.glsl
+ * 
+ * model vertex shader for instanced rendering
+ */
+
+
+
+/* INPUTS AND OUTPUTS */
+
+/* input vertex position, normal, vertex color, texture coords and instance matrix */
+layout ( location = 0 ) in vec3 in_pos;
+layout ( location = 1 ) in vec3 in_normal;
+layout ( location = 2 ) in vec3 in_tangent;
+layout ( location = 3 ) in vec4 in_vcolor;
+layout ( location = 4 ) in vec2 in_texcoords [ MAX_TEXTURE_STACK_SIZE ];
+layout ( location = 4 + MAX_TEXTURE_STACK_SIZE ) in mat4 in_instance_matrix;
+
+/* output fragpos, tbn_matrix, vcolor and texcoords */
+out VS_OUT
+{
+    vec3 fragpos;
+    mat3 tbn_matrix;
+    vec4 vcolor;
+    vec2 texcoords [ MAX_TEXTURE_STACK_SIZE ];
+} vs_out;
+
+
+
+/* UNIFORMS */
+
+/* camera matrices are in camera_block (see camera.glsl) */
+
+/* the model matrix of the current node */
+uniform mat4 model_matrix;
+
+
+
+/* MAIN */
+
+/* main */
+void main ()
+{
+    /* get the final model matrix and its normal matrix */
+    const mat4 final_model_matrix = in_instance_matrix * model_matrix;
+    const mat3 normal_matrix = transpose ( inverse ( mat3 ( final_model_matrix ) ) );
+
+    /* set fragpos */
+    vs_out.fragpos = vec3 ( final_model_matrix * vec4 ( in_pos, 1.0 ) );
+
+    /* transform position based on camera */
+    gl_Position = camera.view_proj * vec4 ( vs_out.fragpos, 1.0 );
+
+    /* set tbn matrix */
+    const vec3 normal = normalize ( normal_matrix * in_normal );
+    const vec3 tangent = normalize ( mat3 ( final_model_matrix ) * in_tangent );
+    vs_out.tbn_matrix = mat3 ( tangent, cross ( normal, tangent ), normal );
+
+    /* set vcolor */
+    vs_out.vcolor = in_vcolor;
+    
+    /* set texcoords to in_texcoords */
+    vs_out.texcoords = in_texcoords;
+}
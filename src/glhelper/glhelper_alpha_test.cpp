@@ -0,0 +1,314 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * src/glhelper/glhelper_alpha_test.cpp
+ *
+ * implementation of include/glhelper/glhelper_alpha_test.hpp
+ *
+ */
+
+
+
+/* INCLUDES */
+
+/* include glhelper_alpha_test.hpp */
+#include <glhelper/glhelper_alpha_test.hpp>
+
+
+
+/* ALPHA TEST FUNCTIONS IMPLEMENTATION */
+
+/* sample_stack_alpha
+ *
+ * sample the alpha of a level of a stack from its image, without interpolation
+ * the texel is wrapped in the same way as the sampler used by the compute program
+ *
+ * _stack: the stack to sample
+ * level: the level of the stack to sample
+ * texcoords: the texture coords to sample at
+ */
+float glh::alpha_test::sample_stack_alpha ( const stack& _stack, const unsigned level, const math::fvec2& texcoords )
+{
+    /* get the image of the level, and the texel containing the texcoords before wrapping */
+    const core::image& _image = * _stack.levels.at ( level ).level_image;
+    const int size [ 2 ] { static_cast<int> ( _stack.width ), static_cast<int> ( _stack.height ) };
+    const GLenum wrapping [ 2 ] { _stack.wrapping_u, _stack.wrapping_v };
+    int texel [ 2 ];
+    for ( unsigned c = 0; c < 2; ++c )
+    {
+        /* wrap the texel as described by the gl specification for nearest filtering */
+        texel [ c ] = static_cast<int> ( std::floor ( texcoords.at ( c ) * static_cast<float> ( size [ c ] ) ) );
+        if ( wrapping [ c ] == GL_CLAMP_TO_BORDER ) { if ( texel [ c ] < 0 || texel [ c ] >= size [ c ] ) return 0.0f; } else
+        if ( wrapping [ c ] == GL_CLAMP_TO_EDGE ) texel [ c ] = std::min ( std::max ( texel [ c ], 0 ), size [ c ] - 1 ); else
+        if ( wrapping [ c ] == GL_MIRRORED_REPEAT )
+        {
+            const int mirrored = ( ( texel [ c ] % ( 2 * size [ c ] ) ) + 2 * size [ c ] ) % ( 2 * size [ c ] ) - size [ c ];
+            texel [ c ] = ( size [ c ] - 1 ) - ( mirrored >= 0 ? mirrored : -( 1 + mirrored ) );
+        }
+        else texel [ c ] = ( ( texel [ c ] % size [ c ] ) + size [ c ] ) % size [ c ];
+    }
+
+    /* images are uploaded with the format given by image::to_format, so only four channel images have an alpha channel, and gl reads the alpha of the rest as 1.0 */
+    if ( _image.get_channels () != 4 ) return 1.0f;
+
+    /* return the alpha of the texel, converted from unsigned normalised in the same way as gl */
+    const unsigned char * data = static_cast<const unsigned char *> ( _image.get_ptr () );
+    return static_cast<float> ( data [ ( static_cast<std::size_t> ( texel [ 1 ] ) * size [ 0 ] + texel [ 0 ] ) * 4 + 3 ] ) / 255.0f;
+}
+
+/* sample_face
+ *
+ * sample a face at barycentric coordinates, as sample_face does in the compute program
+ *
+ * _stack: the diffuse stack of the face
+ * face: a pointer to the face data of the face
+ * num_uv_channels: the number of uv channels of each vertex
+ * barycentric: the barycentric coordinates to sample at
+ *
+ * return: the 4 bits of the results of the sample
+ */
+unsigned glh::alpha_test::sample_face ( const stack& _stack, const float * face, const unsigned num_uv_channels, const math::fvec3& barycentric )
+{
+    /* interpolate the vertex color alpha and the texcoords of each uv channel */
+    const unsigned vertex_stride = num_uv_channels * 2 + 1;
+    float vcolor_alpha = 0.0f;
+    std::vector<math::fvec2> texcoords ( num_uv_channels, math::fvec2 { 0.0f } );
+    for ( unsigned v = 0; v < 3; ++v )
+    {
+        const float * vertex = face + v * vertex_stride;
+        for ( unsigned i = 0; i < num_uv_channels; ++i ) for ( unsigned c = 0; c < 2; ++c ) texcoords.at ( i ).at ( c ) += vertex [ i * 2 + c ] * barycentric.at ( v );
+        vcolor_alpha += vertex [ num_uv_channels * 2 ] * barycentric.at ( v );
+    }
+
+    /* evaluate the alpha of the diffuse stack, in the same way as evaluate_stack_w */
+    float diffuse_alpha = _stack.base_alpha;
+    for ( unsigned i = 0; i < _stack.levels.size (); ++i )
+    {
+        const float texel_alpha = sample_stack_alpha ( _stack, i, texcoords.at ( _stack.levels.at ( i ).uvwsrc ) );
+        const float blend_strength = _stack.levels.at ( i ).blend_strength;
+        switch ( _stack.levels.at ( i ).blend_operation )
+        {
+            case 1: diffuse_alpha += texel_alpha * blend_strength; break;
+            case 2: diffuse_alpha -= texel_alpha * blend_strength; break;
+            case 3: diffuse_alpha /= texel_alpha * blend_strength; break;
+            case 4: diffuse_alpha = ( diffuse_alpha + texel_alpha ) - ( diffuse_alpha * texel_alpha ); break;
+            case 5: diffuse_alpha += texel_alpha * blend_strength - 0.5f; break;
+            default: diffuse_alpha *= texel_alpha * blend_strength; break;
+        }
+    }
+
+    /* create the output mask */
+    unsigned output_mask = 0;
+    output_mask |= static_cast<unsigned> ( vcolor_alpha >= 0.98f );
+    output_mask |= static_cast<unsigned> ( vcolor_alpha >= 0.02f && vcolor_alpha <= 0.98f ) << 1;
+    output_mask |= static_cast<unsigned> ( diffuse_alpha >= 0.98f ) << 2;
+    output_mask |= static_cast<unsigned> ( diffuse_alpha >= 0.02f && diffuse_alpha <= 0.98f ) << 3;
+    return output_mask;
+}
+
+/* test_face
+ *
+ * alpha test a face on the cpu
+ *
+ * _stack: the diffuse stack of the face
+ * face: a pointer to the face data of the face
+ * num_uv_channels: the number of uv channels of each vertex
+ *
+ * return: the 4 bits of the results of alpha testing the face
+ */
+unsigned glh::alpha_test::test_face ( const stack& _stack, const float * face, const unsigned num_uv_channels )
+{
+    /* get the texcoords of a vertex of the face */
+    const unsigned vertex_stride = num_uv_channels * 2 + 1;
+    const auto texcoords_of = [ & ] ( const unsigned v, const unsigned uv_channel ) { return math::fvec2 { face [ v * vertex_stride + uv_channel * 2 ], face [ v * vertex_stride + uv_channel * 2 + 1 ] }; };
+
+    /* sample the centroid and each vertex, so that every face is sampled even if it covers no texel centers */
+    unsigned face_mask = sample_face ( _stack, face, num_uv_channels, math::fvec3 { 1.0f / 3.0f } );
+    face_mask |= sample_face ( _stack, face, num_uv_channels, math::fvec3 { 1.0f, 0.0f, 0.0f } );
+    face_mask |= sample_face ( _stack, face, num_uv_channels, math::fvec3 { 0.0f, 1.0f, 0.0f } );
+    face_mask |= sample_face ( _stack, face, num_uv_channels, math::fvec3 { 0.0f, 0.0f, 1.0f } );
+
+    /* find the uv channel of the level of the stack with the largest texcoords area */
+    int uv_channel = -1;
+    float max_texcoords_area = 0.0f;
+    for ( const stack_level& level: _stack.levels )
+    {
+        const math::fvec2 uv0 = texcoords_of ( 0, level.uvwsrc ), uv1 = texcoords_of ( 1, level.uvwsrc ), uv2 = texcoords_of ( 2, level.uvwsrc );
+        const float texcoords_area = std::abs ( ( uv1.at ( 0 ) - uv0.at ( 0 ) ) * ( uv2.at ( 1 ) - uv0.at ( 1 ) ) - ( uv2.at ( 0 ) - uv0.at ( 0 ) ) * ( uv1.at ( 1 ) - uv0.at ( 1 ) ) );
+        if ( texcoords_area > max_texcoords_area ) { max_texcoords_area = texcoords_area; uv_channel = level.uvwsrc; }
+    }
+
+    /* if there is no uv channel with any area, return the mask of the centroid and vertices */
+    if ( uv_channel < 0 ) return face_mask;
+
+    /* get the uvs of the face in texel space */
+    const float stack_size [ 2 ] { static_cast<float> ( _stack.width ), static_cast<float> ( _stack.height ) };
+    float uv [ 3 ][ 2 ];
+    for ( unsigned v = 0; v < 3; ++v ) for ( unsigned c = 0; c < 2; ++c ) uv [ v ][ c ] = texcoords_of ( v, uv_channel ).at ( c ) * stack_size [ c ];
+
+    /* find the texels covered by the bounding box of the face, and the step between samples, which is greater than one texel if the box is larger than the stack */
+    float min_texel [ 2 ], step [ 2 ];
+    unsigned num_samples [ 2 ];
+    for ( unsigned c = 0; c < 2; ++c )
+    {
+        min_texel [ c ] = std::floor ( std::min ( uv [ 0 ][ c ], std::min ( uv [ 1 ][ c ], uv [ 2 ][ c ] ) ) );
+        const float max_texel = std::ceil ( std::max ( uv [ 0 ][ c ], std::max ( uv [ 1 ][ c ], uv [ 2 ][ c ] ) ) );
+        step [ c ] = std::max ( ( max_texel - min_texel [ c ] ) / stack_size [ c ], 1.0f );
+        num_samples [ c ] = static_cast<unsigned> ( std::ceil ( ( max_texel - min_texel [ c ] ) / step [ c ] ) );
+    }
+
+    /* loop over the samples, keeping the samples inside the face */
+    const float area = ( uv [ 1 ][ 0 ] - uv [ 0 ][ 0 ] ) * ( uv [ 2 ][ 1 ] - uv [ 0 ][ 1 ] ) - ( uv [ 2 ][ 0 ] - uv [ 0 ][ 0 ] ) * ( uv [ 1 ][ 1 ] - uv [ 0 ][ 1 ] );
+    for ( unsigned y = 0; y < num_samples [ 1 ]; ++y ) for ( unsigned x = 0; x < num_samples [ 0 ]; ++x )
+    {
+        /* find the barycentric coordinates of the sample */
+        const float px = min_texel [ 0 ] + ( static_cast<float> ( x ) + 0.5f ) * step [ 0 ];
+        const float py = min_texel [ 1 ] + ( static_cast<float> ( y ) + 0.5f ) * step [ 1 ];
+        const math::fvec3 barycentric
+        {
+            ( ( uv [ 1 ][ 0 ] - px ) * ( uv [ 2 ][ 1 ] - py ) - ( uv [ 2 ][ 0 ] - px ) * ( uv [ 1 ][ 1 ] - py ) ) / area,
+            ( ( uv [ 2 ][ 0 ] - px ) * ( uv [ 0 ][ 1 ] - py ) - ( uv [ 0 ][ 0 ] - px ) * ( uv [ 2 ][ 1 ] - py ) ) / area,
+            ( ( uv [ 0 ][ 0 ] - px ) * ( uv [ 1 ][ 1 ] - py ) - ( uv [ 1 ][ 0 ] - px ) * ( uv [ 0 ][ 1 ] - py ) ) / area
+        };
+
+        /* sample if inside the face */
+        if ( barycentric.at ( 0 ) >= 0.0f && barycentric.at ( 1 ) >= 0.0f && barycentric.at ( 2 ) >= 0.0f ) face_mask |= sample_face ( _stack, face, num_uv_channels, barycentric );
+    }
+
+    /* return the mask of the face */
+    return face_mask;
+}
+
+/* test_faces
+ *
+ * alpha test ranges of faces on the cpu across the shared thread pool
+ *
+ * face_data: the face data of every face
+ * num_uv_channels: the number of uv channels of each vertex
+ * first_faces: the index of the first face of each range, followed by the total number of faces
+ * stacks: the diffuse stack of each range
+ *
+ * return: the 4 bits of the results of alpha testing each face
+ */
+std::vector<unsigned> glh::alpha_test::test_faces ( const std::vector<float>& face_data, const unsigned num_uv_channels, const std::vector<unsigned>& first_faces, const std::vector<const stack *>& stacks )
+{
+    /* throw if the ranges do not describe the face data */
+    const unsigned face_stride = get_face_stride ( num_uv_channels );
+    if ( first_faces.size () != stacks.size () + 1 || first_faces.front () != 0 || static_cast<std::size_t> ( first_faces.back () ) * face_stride != face_data.size () )
+        throw exception::alpha_test_exception { "attempted to alpha test ranges of faces which do not cover the face data" };
+
+    /* test the faces in chunks, so that threads are not handed work one face at a time
+     * each result is written by exactly one thread, so no synchronisation is needed
+     */
+    const unsigned chunk_size = 256;
+    std::vector<unsigned> results ( first_faces.back (), 0 );
+    thread::thread_pool::get_shared ().parallel_for ( ( first_faces.back () + chunk_size - 1 ) / chunk_size, [ & ] ( const unsigned chunk )
+    {
+        /* find the range of the first face of the chunk, then test each face, moving on to the next range where necessary */
+        const unsigned end = std::min ( ( chunk + 1 ) * chunk_size, first_faces.back () );
+        unsigned r = std::upper_bound ( first_faces.begin (), first_faces.end (), chunk * chunk_size ) - first_faces.begin () - 1;
+        for ( unsigned k = chunk * chunk_size; k < end; ++k )
+        {
+            while ( k >= first_faces.at ( r + 1 ) ) ++r;
+            results.at ( k ) = test_face ( * stacks.at ( r ), face_data.data () + static_cast<std::size_t> ( k ) * face_stride, num_uv_channels );
+        }
+    } );
+
+    /* return the results */
+    return results;
+}
+
+
+
+/* COMPUTE_TESTER IMPLEMENTATION */
+
+/* full constructor
+ *
+ * upload the face data, and create the output buffer cleared to zero
+ *
+ * _alpha_test_program: the compute program built from shaders/compute.alpha_test.glsl
+ * face_data: the face data of every face to test
+ * num_uv_channels: the number of uv channels of each vertex, which must be the MAX_TEXTURE_STACK_SIZE of the program
+ */
+glh::alpha_test::compute_tester::compute_tester ( core::compute_program& _alpha_test_program, const std::vector<float>& face_data, const unsigned num_uv_channels )
+    : alpha_test_program { _alpha_test_program }
+    , num_faces { static_cast<unsigned> ( face_data.size () / get_face_stride ( num_uv_channels ) ) }
+    , face_ssbo { face_data.begin (), face_data.end () }
+    , first_face_uni { _alpha_test_program.get_uniform ( "first_face" ) }
+    , num_faces_uni { _alpha_test_program.get_uniform ( "num_faces" ) }
+    , textures_uni { _alpha_test_program.get_struct_uniform ( "material" ).get_struct_uniform ( "diffuse_stack" ).get_uniform ( "textures" ) }
+{
+    /* throw if the face data is not a whole number of faces */
+    if ( face_data.size () % get_face_stride ( num_uv_channels ) != 0 ) throw exception::alpha_test_exception { "attempted to alpha test face data which is not a whole number of faces" };
+
+    /* create the output with 4 bits for each face, cleared to zero */
+    output_ssbo.buffer_storage ( ( ( num_faces + 7 ) / 8 ) * sizeof ( unsigned ), NULL, GL_DYNAMIC_STORAGE_BIT | GL_MAP_READ_BIT | GL_MAP_WRITE_BIT );
+    const unsigned zero = 0;
+    output_ssbo.clear_data ( GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero );
+}
+
+
+
+/* dispatch
+ *
+ * dispatch the program for a range of faces which share a diffuse stack, without waiting for it to complete
+ * the textures are sampled without interpolation through a cached sampler with the wrapping of the stack
+ *
+ * textures: the texture array of the diffuse stack
+ * _stack: the diffuse stack, whose base color and levels must already be set in the material uniform of the program
+ * first_face: the index of the first face of the range
+ * num_faces: the number of faces in the range
+ */
+void glh::alpha_test::compute_tester::dispatch ( const core::texture2d_array& textures, const stack& _stack, const unsigned first_face, const unsigned num_faces )
+{
+    /* throw if the range is outside of the face data */
+    if ( first_face + num_faces > this->num_faces ) throw exception::alpha_test_exception { "attempted to alpha test faces outside of the face data" };
+    if ( num_faces == 0 ) return;
+
+    /* bind the face data and output */
+    face_ssbo.bind ( 0 );
+    output_ssbo.bind ( 1 );
+
+    /* bind the textures with a sampler which does not interpolate, and point the program at the unit they were bound to
+     * compute shaders always sample the base level, so the minification filter does not use mipmaps, which the textures may not have
+     */
+    const unsigned textures_unit = textures.bind_loop ( core::sampler::get_cached ( core::sampler::parameters {}
+        .with_filter ( GL_NEAREST, GL_NEAREST ).with_wrap ( _stack.wrapping_u, _stack.wrapping_v, GL_REPEAT ) ) );
+    textures_uni.set_int ( textures_unit );
+
+    /* dispatch a work group for each face
+     * every implementation allows at least 65535 work groups in each dimension, so any more faces than that are spread over a second dimension
+     */
+    first_face_uni.set_uint ( first_face );
+    num_faces_uni.set_uint ( num_faces );
+    const unsigned num_groups_x = std::min ( num_faces, 65535u );
+    alpha_test_program.dispatch ( num_groups_x, ( num_faces + num_groups_x - 1 ) / num_groups_x );
+
+    /* remove the sampler, so the textures are interpolated again */
+    core::sampler::unbind_unit ( textures_unit );
+}
+
+/* get_results
+ *
+ * wait for every dispatch, then read the results
+ *
+ * return: the 4 bits of the results of alpha testing each face
+ */
+std::vector<unsigned> glh::alpha_test::compute_tester::get_results ()
+{
+    /* make the results visible to the mapping of the output, then wait for every dispatch with a single fence */
+    core::sync::buffer_update_barrier ();
+    core::fence_sync alpha_test_fence;
+    alpha_test_fence.client_wait_sync ();
+
+    /* extract the 4 bits of each face */
+    std::vector<unsigned> results ( num_faces );
+    for ( unsigned k = 0; k < num_faces; ++k ) results.at ( k ) = ( output_ssbo.at<unsigned> ( k / 8 ) >> ( ( k % 8 ) * 4 ) ) & 0xf;
+    output_ssbo.unmap_buffer ();
+
+    /* return the results */
+    return results;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * src/glhelper/glhelper_block_layout.cpp
+ *
+ * implementation of include/glhelper/glhelper_block_layout.hpp
+ *
+ */
+
+
+
+/* INCLUDES */
+
+/* include glhelper_block_layout.hpp */
+#include <glhelper/glhelper_block_layout.hpp>
+
+
+
+/* BLOCK FUNCTIONS IMPLEMENTATION */
+
+/* write_block_data
+ *
+ * upload laid out data to a buffer
+ * if the buffer is a ubo, the data is staged, so only the bytes which differ from the contents of the ubo are uploaded before the next draw
+ * if the buffer is empty and the offset is 0, the buffer is allocated to the size of the data
+ *
+ * buff: the buffer to upload to
+ * data: the laid out data
+ * offset: the offset into the buffer to upload to
+ */
+void glh::core::write_block_data ( buffer& buff, const std::vector<unsigned char>& data, const unsigned offset )
+{
+    /* allocate empty buffers */
+    if ( buff.get_size () == 0 && offset == 0 ) { buff.buffer_data ( data.size (), data.data (), GL_DYNAMIC_DRAW ); return; }
+
+    /* throw if the data does not fit */
+    if ( offset + data.size () > buff.get_size () ) throw exception::block_layout_exception { "attempted to upload block data outside of the range of a buffer" };
+
+    /* stage the data for ubos, otherwise upload it */
+    if ( ubo * staged_ubo = dynamic_cast<ubo *> ( &buff ) ) staged_ubo->stage_sub_data ( offset, data.size (), data.data () );
+    else buff.buffer_sub_data ( offset, data.size (), data.data () );
+}
+
+/* validate_block_member
+ *
+ * check the offset and strides of a single member of a block against a program
+ * members which are not active in the program are skipped
+ *
+ * prog: the program to validate against
+ * interface: the program interface of the member
+ * name: the full name of the member
+ * offset: the expected offset of the member in its block
+ * array_stride: the expected array stride, or -1 to not check it (defaults to -1)
+ * matrix_stride: the expected matrix stride, or -1 to not check it (defaults to -1)
+ */
+void glh::core::validate_block_member ( const program& prog, const GLenum interface, const std::string& name, const unsigned offset, const int array_stride, const int matrix_stride )
+{
+    /* get the index of the resource, returning if it is not active */
+    const GLuint index = glGetProgramResourceIndex ( prog.internal_id (), interface, name.c_str () );
+    if ( index == GL_INVALID_INDEX ) return;
+
+    /* get the offset and strides */
+    const GLenum properties [ 3 ] { GL_OFFSET, GL_ARRAY_STRIDE, GL_MATRIX_STRIDE };
+    GLint values [ 3 ];
+    glGetProgramResourceiv ( prog.internal_id (), interface, index, 3, properties, 3, NULL, values );
+
+    /* throw if the member is not in a block, or if anything differs */
+    if ( values [ 0 ] < 0 ) throw exception::block_layout_exception { "block member with name " + name + " is not in a block" };
+    if ( static_cast<unsigned> ( values [ 0 ] ) != offset )
+        throw exception::block_layout_exception { "block member with name " + name + " has offset " + std::to_string ( values [ 0 ] ) + " but was laid out at offset " + std::to_string ( offset ) };
+    if ( array_stride >= 0 && values [ 1 ] != array_stride )
+        throw exception::block_layout_exception { "block member with name " + name + " has array stride " + std::to_string ( values [ 1 ] ) + " but was laid out with stride " + std::to_string ( array_stride ) };
+    if ( matrix_stride >= 0 && values [ 2 ] != matrix_stride )
+        throw exception::block_layout_exception { "block member with name " + name + " has matrix stride " + std::to_string ( values [ 2 ] ) + " but was laid out with stride " + std::to_string ( matrix_stride ) };
+}
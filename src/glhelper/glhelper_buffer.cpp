@@ -17,6 +17,9 @@
 /* include glhelper_buffer.hpp */
 #include <glhelper/glhelper_buffer.hpp>
 
+/* include glhelper_render.hpp */
+#include <glhelper/glhelper_render.hpp>
+
 
 
 /* buffer IMPLEMENTATION */
@@ -38,7 +41,7 @@ glh::core::buffer::buffer ()
 glh::core::buffer::~buffer ()
 {
     /* destroy object */
-    if ( id != 0 ) glDeleteBuffers ( 1, &id );
+    if ( id != 0 ) { renderer::forget_buffer ( id ); glDeleteBuffers ( 1, &id ); }
 }
 
 
@@ -53,7 +56,7 @@ bool glh::core::buffer::bind_copy_read () const
 {
     /* if bound, return false, otherwise bind and return true */
     if ( bound_copy_read_buffer == this ) return false;
-    glBindBuffer ( GL_COPY_READ_BUFFER, id );
+    renderer::bind_buffer ( GL_COPY_READ_BUFFER, id );
     bound_copy_read_buffer = const_cast<buffer *> ( this );
     return true;
 }
@@ -61,7 +64,7 @@ bool glh::core::buffer::bind_copy_write () const
 {
     /* if bound, return false, otherwise bind and return true */
     if ( bound_copy_write_buffer == this ) return false;
-    glBindBuffer ( GL_COPY_WRITE_BUFFER, id );
+    renderer::bind_buffer ( GL_COPY_WRITE_BUFFER, id );
     bound_copy_write_buffer = const_cast<buffer *> ( this );
     return true;
 }
@@ -76,7 +79,7 @@ bool glh::core::buffer::unbind_copy_read () const
 {
     /* if not bound, return false, otherwise unbind and return true */
     if ( bound_copy_read_buffer != this ) return false;
-    glBindBuffer ( GL_COPY_READ_BUFFER, 0 );
+    renderer::bind_buffer ( GL_COPY_READ_BUFFER, 0 );
     bound_copy_read_buffer = NULL;
     return true;
 }
@@ -84,7 +87,7 @@ bool glh::core::buffer::unbind_copy_write () const
 {
     /* if not bound, return false, otherwise unbind and return true */
     if ( bound_copy_write_buffer != this ) return false;
-    glBindBuffer ( GL_COPY_WRITE_BUFFER, 0 );
+    renderer::bind_buffer ( GL_COPY_WRITE_BUFFER, 0 );
     bound_copy_write_buffer = NULL;
     return true;
 }
@@ -260,7 +263,7 @@ bool glh::core::vbo::bind () const
 {
     /* if already bound, return false, else bind and return true */
     if ( bound_vbo == this ) return false;
-    glBindBuffer ( GL_ARRAY_BUFFER, id );
+    renderer::bind_buffer ( GL_ARRAY_BUFFER, id );
     bound_vbo = const_cast<vbo *> ( this );
     return true;
 }
@@ -268,7 +271,7 @@ bool glh::core::vbo::unbind () const
 {
     /* if not bound, return false, else unbind and return true */
     if ( bound_vbo != this ) return false;
-    glBindBuffer ( GL_ARRAY_BUFFER, 0 );
+    renderer::bind_buffer ( GL_ARRAY_BUFFER, 0 );
     bound_vbo = NULL;
     return true;
 }
@@ -287,7 +290,7 @@ bool glh::core::ebo::bind () const
 {
     /* if already bound, return false, else bind and return true */
     if ( bound_ebo == this ) return false;
-    glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, id );
+    renderer::bind_buffer ( GL_ELEMENT_ARRAY_BUFFER, id );
     bound_ebo = const_cast<ebo *> ( this );
     return true;
 }
@@ -295,7 +298,7 @@ bool glh::core::ebo::unbind () const
 {
     /* if not bound, return false, else unbind and return true */
     if ( bound_ebo != this ) return false;
-    glBindBuffer ( GL_ELEMENT_ARRAY_BUFFER, 0 );
+    renderer::bind_buffer ( GL_ELEMENT_ARRAY_BUFFER, 0 );
     bound_ebo = NULL;
     return true;
 }
@@ -346,7 +349,7 @@ bool glh::core::ubo::bind () const
 {
     /* if already bound, return false, else bind and return true */
     if ( bound_ubo == this ) return false;
-    glBindBuffer ( GL_UNIFORM_BUFFER, id );
+    renderer::bind_buffer ( GL_UNIFORM_BUFFER, id );
     bound_ubo = const_cast<ubo *> ( this );
     return true;
 }
@@ -354,7 +357,7 @@ bool glh::core::ubo::unbind () const
 {
     /* if not bound, return false, else unbind and return true */
     if ( bound_ubo != this ) return false;
-    glBindBuffer ( GL_UNIFORM_BUFFER, 0 );
+    renderer::bind_buffer ( GL_UNIFORM_BUFFER, 0 );
     bound_ubo = NULL;
     return true;
 }
@@ -365,7 +368,7 @@ bool glh::core::ubo::bind ( const unsigned index ) const
     /* if already bound, return false, else bind and return true */
     if ( bound_ubo_indices.size () > index && bound_ubo_indices.at ( index ) == this ) return true;
     if ( bound_ubo_indices.size () <= index ) bound_ubo_indices.resize ( index + 1 );
-    glBindBufferBase ( GL_UNIFORM_BUFFER, index, id );
+    renderer::bind_buffer_base ( GL_UNIFORM_BUFFER, index, id );
     bound_ubo_indices.at ( index ) = const_cast<ubo *> ( this );
     return true;
 }
@@ -373,7 +376,7 @@ bool glh::core::ubo::unbind ( const unsigned index ) const
 {
     /* if not bound, return false, else unbind and return true */
     if ( bound_ubo_indices.size () <= index || bound_ubo_indices.at ( index ) != this ) return true;
-    glBindBufferBase ( GL_UNIFORM_BUFFER, index, id );
+    renderer::bind_buffer_base ( GL_UNIFORM_BUFFER, index, 0 );
     bound_ubo_indices.at ( index ) = NULL;
     return true;
 }
@@ -396,6 +399,102 @@ bool glh::core::ubo::unbind_all () const
 
 
 
+/* stage_sub_data
+ *
+ * write data into the CPU-side image of the ubo, to be uploaded on the next flush
+ * 
+ * offset: offset in bytes of where to start writing
+ * size: size of the data in bytes
+ * data: pointer to data
+ */
+void glh::core::ubo::stage_sub_data ( const unsigned offset, const unsigned size, const void * data )
+{
+    /* throw if the write is out of range */
+    if ( offset + size > get_size () ) throw exception::buffer_exception { "attempted to stage data outside of the range of a ubo" };
+    if ( size == 0 ) return;
+
+    /* if the image does not match the size of the ubo (as it has not been read back yet, or the ubo was resized), read it back */
+    if ( staging.size () != get_size () )
+    {
+        staging.resize ( get_size () );
+        staged_ranges.clear ();
+        unmap_buffer ();
+        glGetNamedBufferSubData ( id, 0, staging.size (), staging.data () );
+    }
+
+    /* trim the bytes at either end which already match the image, returning if the whole write matches */
+    ++num_staged_writes;
+    const unsigned char * bytes = static_cast<const unsigned char *> ( data );
+    unsigned begin = offset, end = offset + size;
+    while ( begin < end && staging.at ( begin ) == bytes [ begin - offset ] ) ++begin;
+    while ( end > begin && staging.at ( end - 1 ) == bytes [ end - 1 - offset ] ) --end;
+    if ( begin == end ) { ++num_unchanged_staged_writes; return; }
+
+    /* copy the changed data into the image */
+    std::copy ( bytes + ( begin - offset ), bytes + ( end - offset ), staging.begin () + begin );
+
+    /* if the ubo had no staged data, add it to the ubos to flush */
+    if ( staged_ranges.empty () ) staged_ubos.push_back ( this );
+
+    /* find the first range which ends at or after the gap before the new range, then merge every range which starts within the gap after it */
+    auto first = std::lower_bound ( staged_ranges.begin (), staged_ranges.end (), begin, [] ( const std::pair<unsigned, unsigned>& range, const unsigned value ) 
+        { return range.second + GLH_UBO_STAGING_MERGE_GAP < value; } );
+    auto last = first;
+    while ( last != staged_ranges.end () && last->first <= end + GLH_UBO_STAGING_MERGE_GAP ) 
+        { begin = std::min ( begin, last->first ); end = std::max ( end, last->second ); ++last; }
+
+    /* replace the merged ranges with the new range */
+    if ( first == last ) staged_ranges.insert ( first, { begin, end } );
+    else { * first = { begin, end }; staged_ranges.erase ( first + 1, last ); }
+}
+
+/* flush_staging
+ *
+ * upload the ranges of the ubo written to since the last flush
+ * 
+ * return: true if any data was uploaded
+ */
+bool glh::core::ubo::flush_staging ()
+{
+    /* return if there is nothing to flush */
+    if ( staged_ranges.empty () ) return false;
+
+    /* upload each range */
+    for ( const auto& range: staged_ranges ) buffer_sub_data ( range.first, range.second - range.first, staging.data () + range.first );
+    num_staged_uploads += staged_ranges.size ();
+    staged_ranges.clear ();
+
+    /* return true */
+    return true;
+}
+
+/* invalidate_staging
+ *
+ * flush any staged data, then discard the CPU-side image, so that it is read back from the ubo when next written to
+ * this should be called after writing to the ubo by means other than uniforms
+ */
+void glh::core::ubo::invalidate_staging ()
+{
+    /* flush, then free the image */
+    flush_staging ();
+    staging.clear ();
+    staging.shrink_to_fit ();
+}
+
+/* flush_all_staging
+ *
+ * flush every ubo with staged data
+ * this is called by the renderer before each draw
+ */
+void glh::core::ubo::flush_all_staging ()
+{
+    /* flush each ubo which still exists, then forget them all */
+    for ( object_pointer<ubo>& staged_ubo: staged_ubos ) if ( staged_ubo ) staged_ubo->flush_staging ();
+    staged_ubos.clear ();
+}
+
+
+
 /* bound_ubo
  * bound_ubo_indices
  *
@@ -404,6 +503,22 @@ bool glh::core::ubo::unbind_all () const
 glh::core::object_pointer<glh::core::ubo> glh::core::ubo::bound_ubo {};
 std::vector<glh::core::object_pointer<glh::core::ubo>> glh::core::ubo::bound_ubo_indices {};
 
+/* staged_ubos
+ *
+ * the ubos with staged data waiting to be flushed
+ */
+std::vector<glh::core::object_pointer<glh::core::ubo>> glh::core::ubo::staged_ubos {};
+
+/* num_staged_writes
+ * num_unchanged_staged_writes
+ * num_staged_uploads
+ *
+ * staging statistics across all ubos
+ */
+unsigned glh::core::ubo::num_staged_writes { 0 };
+unsigned glh::core::ubo::num_unchanged_staged_writes { 0 };
+unsigned glh::core::ubo::num_staged_uploads { 0 };
+
 
 
 /* SSBO IMPLEMENTATION */
@@ -413,7 +528,7 @@ bool glh::core::ssbo::bind () const
 {
     /* if already bound, return false, else bind and return true */
     if ( bound_ssbo == this ) return false;
-    glBindBuffer ( GL_SHADER_STORAGE_BUFFER, id );
+    renderer::bind_buffer ( GL_SHADER_STORAGE_BUFFER, id );
     bound_ssbo = const_cast<ssbo *> ( this );
     return true;
 }
@@ -421,7 +536,7 @@ bool glh::core::ssbo::unbind () const
 {
     /* if not bound, return false, else unbind and return true */
     if ( bound_ssbo != this ) return false;
-    glBindBuffer ( GL_SHADER_STORAGE_BUFFER, 0 );
+    renderer::bind_buffer ( GL_SHADER_STORAGE_BUFFER, 0 );
     bound_ssbo = NULL;
     return true;
 }
@@ -432,7 +547,7 @@ bool glh::core::ssbo::bind ( const unsigned index ) const
     /* if already bound, return false, else bind and return true */
     if ( bound_ssbo_indices.size () > index && bound_ssbo_indices.at ( index ) == this ) return true;
     if ( bound_ssbo_indices.size () <= index ) bound_ssbo_indices.resize ( index + 1 );
-    glBindBufferBase ( GL_SHADER_STORAGE_BUFFER, index, id );
+    renderer::bind_buffer_base ( GL_SHADER_STORAGE_BUFFER, index, id );
     bound_ssbo_indices.at ( index ) = const_cast<ssbo *> ( this );
     return true;
 }
@@ -440,7 +555,7 @@ bool glh::core::ssbo::unbind ( const unsigned index ) const
 {
     /* if not bound, return false, else unbind and return true */
     if ( bound_ssbo_indices.size () <= index || bound_ssbo_indices.at ( index ) != this ) return true;
-    glBindBufferBase ( GL_SHADER_STORAGE_BUFFER, index, id );
+    renderer::bind_buffer_base ( GL_SHADER_STORAGE_BUFFER, index, 0 );
     bound_ssbo_indices.at ( index ) = NULL;
     return true;
 }
@@ -473,6 +588,142 @@ std::vector<glh::core::object_pointer<glh::core::ssbo>> glh::core::ssbo::bound_s
 
 
 
+/* RING_BUFFER IMPLEMENTATION */
+
+/* full constructor
+ *
+ * create the buffer and persistently map it
+ * 
+ * _region_size: the size of each frame region in bytes (rounded up to the offset alignment of indexed targets)
+ * _num_regions: the number of frame regions, and so the number of frames the CPU may get ahead of the GPU (defaults to 3)
+ */
+glh::core::ring_buffer::ring_buffer ( const unsigned _region_size, const unsigned _num_regions )
+    : num_regions { _num_regions }
+    , current_region { 0 }
+    , region_offset { 0 }
+    , region_fences ( _num_regions )
+    , num_frames { 0 }
+    , num_stalls { 0 }
+    , stall_time { 0.0 }
+{
+    /* throw if there are no regions */
+    if ( num_regions == 0 || _region_size == 0 ) throw exception::buffer_exception { "attempted to create ring buffer with no frame regions" };
+
+    /* get the offset alignment of uniform and shader storage buffer bindings, and round the region size up to it
+     * this makes the start of every region suitable for any indexed binding
+     */
+    int uniform_alignment = 1, shader_storage_alignment = 1;
+    glGetIntegerv ( GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniform_alignment );
+    glGetIntegerv ( GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &shader_storage_alignment );
+    bind_alignment = std::max ( { uniform_alignment, shader_storage_alignment, 1 } );
+    region_size = ( ( _region_size + bind_alignment - 1 ) / bind_alignment ) * bind_alignment;
+
+    /* bind to create the buffer object, then create the immutable storage and map it persistently */
+    bind_copy_write (); unbind_copy_write ();
+    buffer_storage ( region_size * num_regions, NULL, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT );
+    map_base = reinterpret_cast<char *> ( glMapNamedBufferRange ( id, 0, region_size * num_regions, GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT ) );
+
+    /* throw if the mapping failed */
+    if ( !map_base ) throw exception::buffer_exception { "failed to persistently map ring buffer" };
+}
+
+
+
+/* allocate
+ *
+ * allocate space in the current frame region
+ * 
+ * size: the number of bytes to allocate
+ * alignment: the alignment of the allocation in bytes (defaults to 0, meaning the offset alignment of indexed targets)
+ * 
+ * return: the offset of the allocation from the start of the buffer
+ */
+unsigned glh::core::ring_buffer::allocate ( const unsigned size, const unsigned alignment )
+{
+    /* align the offset, then throw if the allocation does not fit in the region */
+    const unsigned _alignment = ( alignment == 0 ? bind_alignment : alignment );
+    const unsigned offset = ( ( region_offset + _alignment - 1 ) / _alignment ) * _alignment;
+    if ( offset + size > region_size ) throw exception::buffer_exception { "ring buffer frame region is full" };
+
+    /* move the offset along and return the allocation */
+    region_offset = offset + size;
+    return current_region * region_size + offset;
+}
+
+/* write with pointer
+ *
+ * allocate space in the current frame region and copy data into it
+ * 
+ * data: pointer to the data
+ * size: the size of the data in bytes
+ * alignment: the alignment of the allocation in bytes (defaults to the offset alignment of indexed targets)
+ * 
+ * return: the offset of the data from the start of the buffer
+ */
+unsigned glh::core::ring_buffer::write ( const void * data, const unsigned size, const unsigned alignment )
+{
+    /* allocate the space, then copy the data */
+    const unsigned offset = allocate ( size, alignment );
+    std::copy_n ( reinterpret_cast<const char *> ( data ), size, map_base + offset );
+    return offset;
+}
+
+/* bind_range
+ *
+ * bind a range of the buffer to an indexed target
+ * 
+ * target: the indexed target (e.g. GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER)
+ * index: the index of the binding point
+ * offset: the offset of the range from the start of the buffer, as returned by allocate or write
+ * size: the size of the range in bytes
+ */
+void glh::core::ring_buffer::bind_range ( const GLenum target, const unsigned index, const unsigned offset, const unsigned size ) const
+{
+    /* throw if the range is not within the buffer */
+    if ( offset + size > get_size () ) throw exception::buffer_exception { "attempted to bind range outside of ring buffer" };
+
+    /* a ubo or ssbo recorded as bound to the index is no longer bound, so forget about it */
+    if ( target == GL_UNIFORM_BUFFER && ubo::bound_ubo_indices.size () > index ) ubo::bound_ubo_indices.at ( index ) = NULL;
+    if ( target == GL_SHADER_STORAGE_BUFFER && ssbo::bound_ssbo_indices.size () > index ) ssbo::bound_ssbo_indices.at ( index ) = NULL;
+
+    /* bind the range */
+    renderer::bind_buffer_range ( target, index, id, offset, size );
+}
+
+/* next_frame
+ *
+ * fence the current frame region, and move to the next one, waiting for the GPU to finish with it if necessary
+ * this should be called once per frame, after the last command which reads from the current region
+ */
+void glh::core::ring_buffer::next_frame ()
+{
+    /* fence the current region and move to the next */
+    region_fences.at ( current_region ).reset ( new fence_sync {} );
+    current_region = ( current_region + 1 ) % num_regions;
+    region_offset = 0;
+    ++num_frames;
+
+    /* if the next region has a fence, check whether it has been signaled without waiting */
+    std::unique_ptr<fence_sync>& fence = region_fences.at ( current_region );
+    if ( !fence ) return;
+    GLenum status = fence->client_wait_sync ( GL_SYNC_FLUSH_COMMANDS_BIT, 0 );
+
+    /* if it has not, the GPU is still reading the region, so record a stall and wait */
+    if ( status == GL_TIMEOUT_EXPIRED )
+    {
+        ++num_stalls;
+        const auto stall_start = std::chrono::steady_clock::now ();
+        while ( status == GL_TIMEOUT_EXPIRED ) status = fence->client_wait_sync ( GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000 );
+        stall_time += std::chrono::duration<double> { std::chrono::steady_clock::now () - stall_start }.count ();
+    }
+
+    /* throw if the wait failed, otherwise the fence is no longer needed */
+    if ( status == GL_WAIT_FAILED ) throw exception::buffer_exception { "failed to wait for ring buffer frame region" };
+    fence.reset ();
+}
+
+
+
 /* VAO IMPLEMENTATION */
 
 /* constructor
@@ -493,7 +744,7 @@ bool glh::core::vao::bind () const
 {
     /* if already bound, return false, else bind and return true */
     if ( bound_vao == this ) return false;
-    glBindVertexArray ( id );
+    renderer::bind_vertex_array ( id );
     bound_vao = const_cast<vao *> ( this );
     return true;
 }
@@ -501,7 +752,7 @@ bool glh::core::vao::unbind () const
 {
     /* if not bound, return false, else unbind and return true */
     if ( bound_vao != this ) return false;
-    glBindVertexArray ( 0 );
+    renderer::bind_vertex_array ( 0 );
     bound_vao = NULL;
     return true;
 }
@@ -514,7 +765,8 @@ bool glh::core::vao::unbind () const
  * also implicitly enables the vertex attribute
  * 
  * attrib: the attribute to configure (>=0)
- * buff: the vertex buffer object to bind to the attribute
+ * buff: the vertex buffer object or ring buffer to bind to the attribute
+ *       data written to a ring buffer is reached by the base vertex or base instance of a draw, as the offset is fixed
  * size: components per vertex (1, 2, 3 or 4)
  * type: the type of each component of each vertex
  * norm: boolean as to whether to normalize the vertex data
@@ -532,6 +784,17 @@ void glh::core::vao::set_vertex_attrib ( const unsigned attrib, const vbo& buff,
     /* enable attribute */
     glEnableVertexArrayAttrib ( id, attrib );
 }
+void glh::core::vao::set_vertex_attrib ( const unsigned attrib, const ring_buffer& buff, const int size, const GLenum type, const bool norm, const unsigned stride, const unsigned offset )
+{
+    /* set the format */
+    glVertexArrayAttribFormat ( id, attrib, size, type, norm, 0 );
+
+    /* set the buffer */
+    glVertexArrayVertexBuffer ( id, attrib, buff.internal_id (), offset, stride );
+
+    /* enable attribute */
+    glEnableVertexArrayAttrib ( id, attrib );
+}
 
 /* enable_vertex_attrib
  *
@@ -557,6 +820,19 @@ void glh::core::vao::disable_vertex_attrib ( const unsigned attrib )
     glDisableVertexArrayAttrib ( id, attrib );
 }
 
+/* set_vertex_attrib_divisor
+ *
+ * set the rate at which a vertex attribute advances during instanced rendering
+ * 
+ * attrib: the attribute to configure (>=0)
+ * divisor: the number of instances to draw before advancing (0 advances per vertex rather than per instance)
+ */
+void glh::core::vao::set_vertex_attrib_divisor ( const unsigned attrib, const unsigned divisor )
+{
+    /* set the divisor of the binding point, which is the same as the attribute */
+    glVertexArrayBindingDivisor ( id, attrib, divisor );
+}
+
 /* bind_ebo
  *
  * binds an element buffer object to the vao
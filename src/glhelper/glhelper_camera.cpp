@@ -51,11 +51,29 @@ void glh::camera::camera_base::apply () const
     /* update parameters */
     update_parameters ();
 
-    /* set the parameters */
-    cached_uniforms->view_uni.set_matrix ( view );
-    cached_uniforms->proj_uni.set_matrix ( proj );
-    cached_uniforms->view_proj_uni.set_matrix ( view_proj );
-    cached_uniforms->viewpos_uni.set_vector ( viewpos );
+    /* set the parameters which have changed since they were last applied to the cached uniforms */
+    const bool view_applied = ( cached_uniforms->applied_view_version == view_version );
+    const bool proj_applied = ( cached_uniforms->applied_proj_version == proj_version );
+    if ( !view_applied ) { cached_uniforms->view_uni.set_matrix ( view ); cached_uniforms->viewpos_uni.set_vector ( viewpos ); }
+    if ( !proj_applied ) cached_uniforms->proj_uni.set_matrix ( proj );
+    if ( !view_applied || !proj_applied ) cached_uniforms->view_proj_uni.set_matrix ( view_proj );
+
+    /* record the versions applied */
+    cached_uniforms->applied_view_version = view_version;
+    cached_uniforms->applied_proj_version = proj_version;
+}
+
+/* apply to a ubo
+ *
+ * upload the camera to a ubo in one write, laid out as a std140 camera_struct
+ * the ubo should be bound to the binding of a camera_block uniform block
+ * 
+ * camera_ubo: the ubo to upload to
+ */
+void glh::camera::camera_base::apply ( core::ubo& camera_ubo ) const
+{
+    /* upload the parameters */
+    core::upload_block<core::std140_layout> ( camera_ubo, get_block () );
 }
 
 /* cache_uniforms
@@ -73,11 +91,23 @@ void glh::camera::camera_base::cache_uniforms ( core::struct_uniform& camera_uni
             camera_uni.get_uniform ( "view" ),
             camera_uni.get_uniform ( "proj" ),
             camera_uni.get_uniform ( "view_proj" ),
-            camera_uni.get_uniform ( "viewpos" )
+            camera_uni.get_uniform ( "viewpos" ),
+            view_version - 1, proj_version - 1
         } );
     }
 }
 
+/* get_block
+ *
+ * get the parameters of the camera, ready to be laid out in a block
+ */
+glh::camera::camera_block glh::camera::camera_base::get_block () const
+{
+    /* update the parameters, then return them as floats */
+    update_parameters ();
+    return camera_block { math::fmat4 { view }, math::fmat4 { proj }, math::fmat4 { view_proj }, math::fvec3 { viewpos } };
+}
+
 /* get_view
  *
  * get the view matrix
@@ -125,12 +155,14 @@ void glh::camera::camera_base::update_parameters () const
     {
         view = create_view ();
         viewpos = math::vec3 { math::inverse ( view ) * math::vec4 { 0.0, 0.0, 0.0, 1.0 } };
+        ++view_version;
     }
 
     /* if any change to proj matrix, update related parameters */
     if ( proj_change )
     {
         proj = create_proj ();
+        ++proj_version;
     }
 
     /* if any change to either, update view_proj parameters */
@@ -28,33 +28,54 @@
 glh::core::object::object ( const unsigned _id )
     : id { _id }
     , unique_id { next_unique_id++ }
+    , slot { acquire_slot () }
 {
-    /* add object pointer to map */
-    object_pointers.insert ( std::make_pair ( unique_id, this ) );
+    /* fill the slot */
+    object_slots [ slot ] = object_slot { unique_id, this };
 }
 
 /* move constructor */
 glh::core::object::object ( object&& other )
     : id { other.id }
     , unique_id { other.unique_id }
+    , slot { other.slot }
 {
-    /* if id is not 0, update object pointers */
-    if ( id != 0 )
-    {
-       object_pointers.at ( unique_id ) = this;
-       other.id = 0;
-    }
+    /* if the other object still occupies the slot, take it over */
+    if ( object_slots [ slot ].ptr == &other ) object_slots [ slot ].ptr = this;
+    other.id = 0;
 }
 
 /* virtual destructor */
 glh::core::object::~object ()
 {
-    /* remove object pointer from map, if id does not already equal 0 */
-    if ( id != 0 )
+    /* if the object occupies its slot, free the slot */
+    if ( object_slots [ slot ].ptr == this )
+    {
+        object_slots [ slot ] = object_slot { 0, NULL };
+        free_object_slots.push_back ( slot );
+    }
+    id = 0;
+}
+
+
+
+/* acquire_slot
+ *
+ * get the index of a free slot in the object table, reusing a freed slot if possible
+ */
+unsigned glh::core::object::acquire_slot ()
+{
+    /* reuse a free slot if there is one */
+    if ( !free_object_slots.empty () )
     {
-        object_pointers.erase ( unique_id );
-        id = 0;
+        const unsigned _slot = free_object_slots.back ();
+        free_object_slots.pop_back ();
+        return _slot;
     }
+
+    /* otherwise add a slot */
+    object_slots.push_back ( object_slot { 0, NULL } );
+    return object_slots.size () - 1;
 }
 
 
@@ -64,8 +85,10 @@ glh::core::object::~object ()
 /* next_unique_id is one at start */
 GLuint glh::core::object::next_unique_id { 1 };
 
-/* object_pointers
+/* object_slots
+ * free_object_slots
  *
- * map between unique ids and pointers to their objects
+ * the object table, and the indices of the slots of the table which are free to be reused
  */
-std::map<unsigned, glh::core::object *> glh::core::object::object_pointers {};
\ No newline at end of file
+std::vector<glh::core::object::object_slot> glh::core::object::object_slots {};
+std::vector<unsigned> glh::core::object::free_object_slots {};
\ No newline at end of file
@@ -0,0 +1,321 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * src/glhelper/glhelper_culling.cpp
+ *
+ * implementation of include/glhelper/glhelper_culling.hpp
+ *
+ */
+
+
+
+/* INCLUDES */
+
+/* include glhelper_culling.hpp */
+#include <glhelper/glhelper_culling.hpp>
+
+
+
+/* FRUSTUM IMPLEMENTATION */
+
+/* set_view_proj
+ *
+ * re-extract the planes of the frustum from a new view-projection matrix
+ * the statistics are not reset
+ *
+ * view_proj: the view-projection matrix to extract the planes from
+ */
+void glh::culling::frustum::set_view_proj ( const math::mat4& view_proj )
+{
+    /* each plane is the sum or difference of the last row of the matrix and one of the other rows */
+    for ( unsigned i = 0; i < 6; ++i )
+    {
+        /* get the plane */
+        const double sign = ( i % 2 == 0 ? 1.0 : -1.0 );
+        for ( unsigned j = 0; j < 4; ++j ) planes.at ( i ).at ( j ) = view_proj.at ( 3, j ) + sign * view_proj.at ( i / 2, j );
+
+        /* normalise the plane, so that distances from it are true distances */
+        const double length = std::sqrt ( planes.at ( i ).at ( 0 ) * planes.at ( i ).at ( 0 ) + planes.at ( i ).at ( 1 ) * planes.at ( i ).at ( 1 ) + planes.at ( i ).at ( 2 ) * planes.at ( i ).at ( 2 ) );
+        if ( length > 0.0 ) for ( unsigned j = 0; j < 4; ++j ) planes.at ( i ).at ( j ) /= length;
+    }
+}
+
+
+
+/* is_culled
+ *
+ * test whether a region lies entirely outside of the frustum
+ *
+ * _region: the region to test (in world space)
+ *
+ * return: true if the region is outside of the frustum
+ */
+bool glh::culling::frustum::is_culled ( const region::spherical_region<>& _region ) const
+{
+    /* increment the number of tests */
+    ++num_tests;
+
+    /* the region is culled if it lies entirely behind any of the planes */
+    for ( const math::vec4& plane: planes )
+    {
+        const double distance = plane.at ( 0 ) * _region.centre.at ( 0 ) + plane.at ( 1 ) * _region.centre.at ( 1 ) + plane.at ( 2 ) * _region.centre.at ( 2 ) + plane.at ( 3 );
+        if ( distance < -_region.radius ) { ++num_culled; return true; }
+    }
+
+    /* otherwise the region is at least partially visible */
+    return false;
+}
+
+/* is_visible
+ *
+ * the opposite of is_culled, for any number of regions
+ *
+ * _region(s): the region(s) to test (in world space)
+ *
+ * return: true (or a vector of booleans) if the region(s) are at least partially inside the frustum
+ */
+std::vector<bool> glh::culling::frustum::is_visible ( const std::vector<region::spherical_region<>>& regions ) const
+{
+    /* test each region in turn */
+    std::vector<bool> visibility;
+    visibility.reserve ( regions.size () );
+    for ( const region::spherical_region<>& _region: regions ) visibility.push_back ( !is_culled ( _region ) );
+
+    /* return the visibility */
+    return visibility;
+}
+
+
+
+/* DEPTH_PYRAMID IMPLEMENTATION */
+
+/* full constructor
+ *
+ * create the pyramid for a depth texture of given dimensions
+ * the base level of the pyramid is half the size of the depth texture
+ *
+ * _depth_width/_depth_height: the width and height of the depth texture the pyramid will be built from
+ */
+glh::culling::depth_pyramid::depth_pyramid ( const unsigned _depth_width, const unsigned _depth_height )
+    : depth_width { _depth_width }
+    , depth_height { _depth_height }
+    , num_levels { static_cast<unsigned> ( std::log2 ( std::max ( std::max ( _depth_width / 2, _depth_height / 2 ), 1u ) ) ) + 1 }
+    , downsample_vshader { "shaders/vertex.simple.glsl" }
+    , downsample_fshader { "shaders/fragment.depth_pyramid.glsl" }
+    , downsample_program { downsample_vshader, downsample_fshader }
+    , built { false }
+    , readback_pending { false }
+    , num_tests { 0 }
+    , num_occluded { 0 }
+{
+    /* throw if the depth texture is too small to be downsampled */
+    if ( depth_width < 2 || depth_height < 2 ) throw exception::culling_exception { "cannot create a depth pyramid for a depth texture smaller than 2x2" };
+
+    /* find the readback level, which is the first level to fit within GLH_DEPTH_PYRAMID_READBACK_SIZE */
+    readback_level = 0;
+    while ( readback_level + 1 < num_levels && ( level_width ( readback_level ) > GLH_DEPTH_PYRAMID_READBACK_SIZE || level_height ( readback_level ) > GLH_DEPTH_PYRAMID_READBACK_SIZE ) ) ++readback_level;
+    readback_width = level_width ( readback_level );
+    readback_height = level_height ( readback_level );
+    readback_depths.resize ( readback_width * readback_height );
+
+    /* set up the pyramid texture
+     * no filtering is used, as all reads are done through texelFetch
+     */
+    pyramid_texture.tex_storage ( level_width ( 0 ), level_height ( 0 ), GL_R32F, num_levels );
+    pyramid_texture.set_min_filter ( GL_NEAREST_MIPMAP_NEAREST ); pyramid_texture.set_mag_filter ( GL_NEAREST );
+    pyramid_texture.set_wrap ( GL_CLAMP_TO_EDGE );
+
+    /* create an fbo for each level of the pyramid */
+    pyramid_fbos.reserve ( num_levels );
+    for ( unsigned i = 0; i < num_levels; ++i )
+    {
+        pyramid_fbos.emplace_back ();
+        pyramid_fbos.back ().attach_texture ( pyramid_texture, GL_COLOR_ATTACHMENT0, i );
+    }
+
+    /* set up the quad */
+    quad_vbo.buffer_storage ( vertices::square_vertex_data.begin (), vertices::square_vertex_data.end () );
+    quad_vao.set_vertex_attrib ( 0, quad_vbo, 3, GL_FLOAT, GL_FALSE, 3 * sizeof ( GLfloat ), 0 );
+
+    /* compile and link the downsample program */
+    downsample_program.compile_and_link ();
+}
+
+
+
+/* build
+ *
+ * build the pyramid from a depth texture
+ * this will change the bound framebuffer, program, vao and viewport
+ * the render state is restored afterwards
+ * readback must be called before the pyramid is next tested against
+ *
+ * depth_texture: the depth texture to build from (must be the same size as specified in the constructor)
+ * view_proj: the view-projection matrix used to render the depth texture
+ */
+void glh::culling::depth_pyramid::build ( const core::texture2d& depth_texture, const math::mat4& view_proj )
+{
+    /* throw if the depth texture is not the expected size */
+    if ( depth_texture.get_width () != depth_width || depth_texture.get_height () != depth_height )
+        throw exception::culling_exception { "attempted to build depth pyramid from a depth texture of the wrong dimensions" };
+
+    /* record the current render state, then apply the default state, which has depth testing, face culling and blending disabled */
+    const core::render_state previous_state = core::renderer::get_render_state ();
+    core::renderer::apply ( core::render_state {} );
+
+    /* use the downsample program and bind the quad */
+    downsample_program.use ();
+    core::uniform& source_texture_uni = downsample_program.get_uniform ( "source_texture" );
+    quad_vao.bind ();
+
+    /* render each level */
+    for ( unsigned i = 0; i < num_levels; ++i )
+    {
+        /* the base level is downsampled from the depth texture, and all others from the previous level
+         * when reading from the pyramid, restrict the accessible levels to the previous level only,
+         * so that the level being rendered to is not also a level which can be read from
+         */
+        if ( i == 0 ) source_texture_uni.set_int ( depth_texture.bind_loop () ); else
+        {
+            pyramid_texture.set_base_level ( i - 1 );
+            pyramid_texture.set_max_level ( i - 1 );
+            source_texture_uni.set_int ( pyramid_texture.bind_loop () );
+        }
+
+        /* bind the fbo for the level, set the viewport and render */
+        pyramid_fbos.at ( i ).bind ();
+        core::renderer::viewport ( 0, 0, level_width ( i ), level_height ( i ) );
+        core::renderer::draw_arrays ( GL_TRIANGLE_STRIP, 0, 4 );
+    }
+
+    /* make all levels accessible again */
+    pyramid_texture.set_base_level ( 0 );
+    pyramid_texture.set_max_level ( num_levels - 1 );
+
+    /* unbind the quad and the final fbo */
+    quad_vao.unbind ();
+    pyramid_fbos.back ().unbind ();
+
+    /* restore the previous render state */
+    core::renderer::apply ( previous_state );
+
+    /* record the matrix and mark the readback as pending */
+    build_view_proj = view_proj;
+    built = true;
+    readback_pending = true;
+}
+
+
+
+/* readback
+ *
+ * read back the readback level of the last build to the CPU, if not already read
+ * this must be called on the thread with the context, and before any region is tested after a build
+ */
+void glh::culling::depth_pyramid::readback () const
+{
+    /* return if nothing is pending */
+    if ( !readback_pending ) return;
+
+    /* get the texture data */
+    pyramid_texture.get_tex_image ( readback_level, GL_RED, GL_FLOAT, readback_depths.size () * sizeof ( GLfloat ), readback_depths.data () );
+    readback_pending = false;
+}
+
+
+
+/* is_occluded
+ *
+ * test whether a region is definitely hidden behind the depth of the last build
+ * regions which intersect the near plane or lie outside of the view at the time of the build are never considered occluded
+ * if the pyramid has not yet been built, no region is occluded
+ * throws if the pyramid has been built but not read back
+ *
+ * _region: the region to test (in world space)
+ *
+ * return: true if the region is occluded
+ */
+bool glh::culling::depth_pyramid::is_occluded ( const region::spherical_region<>& _region ) const
+{
+    /* increment the number of tests */
+    ++num_tests;
+
+    /* if not built, the region cannot be occluded */
+    if ( !built ) return false;
+
+    /* throw if the depths have not been read back since the last build */
+    if ( readback_pending ) throw exception::culling_exception { "attempted to test occlusion against depth pyramid which has not been read back since it was built" };
+
+    /* project the corners of the cube encompassing the region, and find the extents of the corners in normalised device coordinates */
+    math::vec3 min_ndc { 1.0 }, max_ndc { -1.0 };
+    for ( unsigned i = 0; i < 8; ++i )
+    {
+        /* get the corner and transform it to clip space */
+        const math::vec4 clip = build_view_proj * math::vec4
+        {
+            _region.centre.at ( 0 ) + ( i & 0x1 ? _region.radius : -_region.radius ),
+            _region.centre.at ( 1 ) + ( i & 0x2 ? _region.radius : -_region.radius ),
+            _region.centre.at ( 2 ) + ( i & 0x4 ? _region.radius : -_region.radius ),
+            1.0
+        };
+
+        /* if the corner is in front of the near plane, the region cannot be occluded */
+        if ( clip.at ( 3 ) <= 0.0 || clip.at ( 2 ) < -clip.at ( 3 ) ) return false;
+
+        /* update the extents */
+        for ( unsigned j = 0; j < 3; ++j )
+        {
+            min_ndc.at ( j ) = std::min ( min_ndc.at ( j ), clip.at ( j ) / clip.at ( 3 ) );
+            max_ndc.at ( j ) = std::max ( max_ndc.at ( j ), clip.at ( j ) / clip.at ( 3 ) );
+        }
+    }
+
+    /* if the region was outside of the view, there is no depth to test against */
+    if ( max_ndc.at ( 0 ) < -1.0 || min_ndc.at ( 0 ) > 1.0 || max_ndc.at ( 1 ) < -1.0 || min_ndc.at ( 1 ) > 1.0 ) return false;
+
+    /* get the nearest depth of the region in window coordinates */
+    const double region_depth = min_ndc.at ( 2 ) * 0.5 + 0.5;
+
+    /* get the rectangle of texels covered by the region in the readback level
+     * each level halves the previous with floor, and the final texel of a level covers any odd row or column of the level before,
+     * so the texel covering a pixel of the depth texture is the pixel shifted right once for every level, clamped to the final texel
+     * the pixel is clamped before converting it from a double, as regions close to the camera can project far outside of the range of an integer
+     */
+    const auto readback_texel = [ this ] ( const double ndc, const unsigned depth_size, const unsigned readback_size )
+    {
+        const unsigned pixel = static_cast<unsigned> ( std::clamp ( std::floor ( ( ndc * 0.5 + 0.5 ) * depth_size ), 0.0, depth_size - 1.0 ) );
+        return std::min ( pixel >> ( readback_level + 1 ), readback_size - 1 );
+    };
+    const unsigned x0 = readback_texel ( min_ndc.at ( 0 ), depth_width, readback_width ), x1 = readback_texel ( max_ndc.at ( 0 ), depth_width, readback_width );
+    const unsigned y0 = readback_texel ( min_ndc.at ( 1 ), depth_height, readback_height ), y1 = readback_texel ( max_ndc.at ( 1 ), depth_height, readback_height );
+
+    /* the region is visible if any texel is at least as far away as the nearest point of the region */
+    for ( unsigned y = y0; y <= y1; ++y ) for ( unsigned x = x0; x <= x1; ++x )
+        if ( readback_depths.at ( y * readback_width + x ) >= region_depth ) return false;
+
+    /* otherwise the region is occluded */
+    ++num_occluded;
+    return true;
+}
+
+/* is_visible
+ *
+ * the opposite of is_occluded, for any number of regions
+ *
+ * _region(s): the region(s) to test (in world space)
+ *
+ * return: true (or a vector of booleans) if the region(s) are not occluded
+ */
+std::vector<bool> glh::culling::depth_pyramid::is_visible ( const std::vector<region::spherical_region<>>& regions ) const
+{
+    /* test each region in turn */
+    std::vector<bool> visibility;
+    visibility.reserve ( regions.size () );
+    for ( const region::spherical_region<>& _region: regions ) visibility.push_back ( !is_occluded ( _region ) );
+
+    /* return the visibility */
+    return visibility;
+}
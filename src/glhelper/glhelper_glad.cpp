@@ -21,34 +21,80 @@
 
 /* GLAD_LOADER IMPLEMENTATION */
 
-/* load_to_window
+/* load
  *
- * win: window to load OpenGL to
+ * loads glad to the current context, which was not made current by GLFW
+ *
+ * context: a handle to the current context, which is used to avoid reloading the same context
+ * get_proc_address: the function to get the address of each OpenGL function with
  */
-void glh::core::glad_loader::load ()
+void glh::core::glad_loader::load ( const void * context, GLADloadproc get_proc_address )
 {
-    /* get the window from the current context */
-    GLFWwindow * win = glfwGetCurrentContext ();
-
-    /* produce error if no context set */
-    if ( !win ) throw exception::glad_exception { "attempted to load GLAD with no context set" };
+    /* produce error if no context given */
+    if ( !context ) throw exception::glad_exception { "attempted to load GLAD with no context set" };
 
-    /* if window is already loaded, return without reloading glad */
-    if ( win == active_window ) return;
+    /* if context is already loaded, return without reloading glad */
+    if ( context == active_context ) return;
 
     /* activate glad to current context */
-    if ( !gladLoadGLLoader ( ( GLADloadproc ) glfwGetProcAddress ) )
+    if ( !gladLoadGLLoader ( get_proc_address ) )
     {
         /* failed to initialise OpenGL, so produce an exception */
         throw exception::glad_exception { "GLH ERROR: failed to load glad" };
     }
 
-    /* set new active window */
-    active_window = win;
+    /* set new active context */
+    active_context = context;
+
+    /* load glMaxShaderCompilerThreads by hand if parallel shader compile is supported */
+    max_shader_compiler_threads_proc = NULL;
+    if ( has_extension ( "GL_KHR_parallel_shader_compile" ) )
+        max_shader_compiler_threads_proc = reinterpret_cast<void ( APIENTRYP ) ( GLuint )> ( get_proc_address ( "glMaxShaderCompilerThreadsKHR" ) );
+    else if ( has_extension ( "GL_ARB_parallel_shader_compile" ) )
+        max_shader_compiler_threads_proc = reinterpret_cast<void ( APIENTRYP ) ( GLuint )> ( get_proc_address ( "glMaxShaderCompilerThreadsARB" ) );
 }
 
-/* GLFWwindow * active_window
+
+
+/* has_extension
+ *
+ * checks whether the current context supports an extension
+ *
+ * name: the name of the extension (e.g. GL_KHR_parallel_shader_compile)
+ *
+ * return: boolean representing if the extension is supported
+ */
+bool glh::core::glad_loader::has_extension ( const std::string& name )
+{
+    /* compare the name against each extension of the context */
+    GLint num_extensions = 0;
+    glGetIntegerv ( GL_NUM_EXTENSIONS, &num_extensions );
+    for ( GLint i = 0; i < num_extensions; ++i )
+        if ( name == reinterpret_cast<const char *> ( glGetStringi ( GL_EXTENSIONS, i ) ) ) return true;
+    return false;
+}
+
+/* set_max_shader_compiler_threads
+ *
+ * hint to the driver how many threads to compile shaders and link programs with
+ * does nothing if parallel shader compile is not supported
+ *
+ * count: the number of threads, where 0 disables parallel compilation and 0xffffffff (the initial value) leaves it to the driver
+ */
+void glh::core::glad_loader::set_max_shader_compiler_threads ( const unsigned count )
+{
+    /* set the hint if supported */
+    if ( max_shader_compiler_threads_proc ) max_shader_compiler_threads_proc ( count );
+}
+
+/* const void * active_context
+ *
+ * a handle to the currently active context (e.g. a GLFWwindow pointer)
+ */
+const void * glh::core::glad_loader::active_context = NULL;
+
+/* max_shader_compiler_threads_proc
  *
- * a pointer to the currently active window
+ * glMaxShaderCompilerThreadsKHR/ARB, loaded by hand as it is not part of glad, or NULL if not supported
  */
-const GLFWwindow * glh::core::glad_loader::active_window = NULL;
\ No newline at end of file
+void ( APIENTRYP glh::core::glad_loader::max_shader_compiler_threads_proc ) ( GLuint count ) = NULL;
\ No newline at end of file
@@ -471,4 +471,25 @@ void glh::glfw::window::unregister_object ()
         /* terminate glfw */
         glfwTerminate ();
     }
-}
\ No newline at end of file
+}
+
+
+
+/* GLAD_LOADER IMPLEMENTATION */
+
+/* load
+ *
+ * loads glad to the current context
+ * defined alongside the glfw window, so that headless programs can link without glfw
+ */
+void glh::core::glad_loader::load ()
+{
+    /* get the window from the current context */
+    GLFWwindow * win = glfwGetCurrentContext ();
+
+    /* produce error if no context set */
+    if ( !win ) throw exception::glad_exception { "attempted to load GLAD with no context set" };
+
+    /* load glad with glfw */
+    load ( win, reinterpret_cast<GLADloadproc> ( glfwGetProcAddress ) );
+}
@@ -0,0 +1,323 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * src/glhelper/glhelper_headless.cpp
+ *
+ * implementation of include/glhelper/glhelper_headless.hpp
+ *
+ */
+
+
+
+/* INCLUDES */
+
+/* include glhelper_headless.hpp */
+#include <glhelper/glhelper_headless.hpp>
+
+
+
+/* CONTEXT IMPLEMENTATION */
+
+/* full constructor
+ *
+ * create a core profile context, make it current, load glad to it and reset the state cache of the renderer
+ *
+ * major_version/minor_version: the version of OpenGL to request (defaults to 4.6)
+ */
+glh::headless::context::context ( const unsigned major_version, const unsigned minor_version )
+    : display { EGL_NO_DISPLAY }
+    , egl_context { EGL_NO_CONTEXT }
+    , surfaceless_platform { false }
+{
+    /* get the surfaceless Mesa platform display if supported, otherwise the default display */
+    const char * client_extensions = eglQueryString ( EGL_NO_DISPLAY, EGL_EXTENSIONS );
+    const auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC> ( eglGetProcAddress ( "eglGetPlatformDisplayEXT" ) );
+    if ( client_extensions && std::strstr ( client_extensions, "EGL_MESA_platform_surfaceless" ) && get_platform_display )
+    {
+        display = get_platform_display ( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL );
+        surfaceless_platform = ( display != EGL_NO_DISPLAY );
+    }
+    if ( display == EGL_NO_DISPLAY ) display = eglGetDisplay ( EGL_DEFAULT_DISPLAY );
+    if ( display == EGL_NO_DISPLAY ) throw exception::headless_exception { "failed to get an EGL display" };
+
+    /* initialise the display, which does nothing if it is already initialised, and add a reference to it */
+    if ( !eglInitialize ( display, NULL, NULL ) ) throw exception::headless_exception { "failed to initialise EGL display (error " + std::to_string ( eglGetError () ) + ")" };
+    ++display_references [ display ];
+
+    /* create the context, releasing the display on failure */
+    try
+    {
+        /* throw if surfaceless contexts are not supported */
+        const char * display_extensions = eglQueryString ( display, EGL_EXTENSIONS );
+        if ( !display_extensions || !std::strstr ( display_extensions, "EGL_KHR_surfaceless_context" ) )
+            throw exception::headless_exception { "EGL display does not support EGL_KHR_surfaceless_context" };
+
+        /* use desktop OpenGL */
+        if ( !eglBindAPI ( EGL_OPENGL_API ) ) throw exception::headless_exception { "failed to bind the OpenGL API to EGL" };
+
+        /* choose any config which supports OpenGL, as no surface will be created */
+        const EGLint config_attribs [] { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_SURFACE_TYPE, 0, EGL_NONE };
+        EGLConfig config;
+        EGLint num_configs = 0;
+        if ( !eglChooseConfig ( display, config_attribs, &config, 1, &num_configs ) || num_configs == 0 )
+            throw exception::headless_exception { "failed to find an EGL config supporting OpenGL" };
+
+        /* create a core profile context of the version requested */
+        const EGLint context_attribs []
+        {
+            EGL_CONTEXT_MAJOR_VERSION_KHR, static_cast<EGLint> ( major_version ),
+            EGL_CONTEXT_MINOR_VERSION_KHR, static_cast<EGLint> ( minor_version ),
+            EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+            EGL_NONE
+        };
+        egl_context = eglCreateContext ( display, config, EGL_NO_CONTEXT, context_attribs );
+        if ( egl_context == EGL_NO_CONTEXT ) throw exception::headless_exception
+            { "failed to create OpenGL " + std::to_string ( major_version ) + "." + std::to_string ( minor_version ) + " context (error " + std::to_string ( eglGetError () ) + ")" };
+
+        /* make the context current */
+        make_current ();
+    }
+    catch ( ... )
+    {
+        if ( egl_context != EGL_NO_CONTEXT ) eglDestroyContext ( display, egl_context );
+        release_display ( display );
+        throw;
+    }
+
+    /* the new context is in the default state, so reset the state cache, which may hold the state of another context */
+    core::renderer::reset_state ();
+}
+
+/* destructor
+ *
+ * release and destroy the context, terminating the display if no other context uses it
+ */
+glh::headless::context::~context ()
+{
+    /* release the context if current, and make glad forget it */
+    if ( is_current () ) eglMakeCurrent ( display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+    core::glad_loader::unload ( egl_context );
+
+    /* destroy the context and release the display */
+    eglDestroyContext ( display, egl_context );
+    release_display ( display );
+}
+
+
+
+/* make_current
+ *
+ * makes the context current, loading glad to it if it is not already loaded
+ */
+void glh::headless::context::make_current () const
+{
+    /* if context not already current */
+    if ( !is_current () )
+    {
+        /* make the context current with no surface */
+        if ( !eglMakeCurrent ( display, EGL_NO_SURFACE, EGL_NO_SURFACE, egl_context ) )
+            throw exception::headless_exception { "failed to make EGL context current (error " + std::to_string ( eglGetError () ) + ")" };
+
+        /* tell the glad loader to load to the context */
+        core::glad_loader::load ( egl_context, reinterpret_cast<GLADloadproc> ( eglGetProcAddress ) );
+    }
+}
+
+/* get_renderer
+ *
+ * get the name of the renderer of the context (e.g. llvmpipe)
+ */
+std::string glh::headless::context::get_renderer () const
+{
+    /* make current and return the renderer string */
+    make_current ();
+    return reinterpret_cast<const char *> ( glGetString ( GL_RENDERER ) );
+}
+
+
+
+/* release_display
+ *
+ * remove a reference to a display, terminating it if it has no references left
+ *
+ * _display: the display to release
+ */
+void glh::headless::context::release_display ( const EGLDisplay _display )
+{
+    /* decrement the references, and terminate the display once there are none */
+    if ( --display_references.at ( _display ) == 0 )
+    {
+        display_references.erase ( _display );
+        eglTerminate ( _display );
+    }
+}
+
+
+
+/* IMAGE_REGRESSION IMPLEMENTATION */
+
+/* full constructor
+ *
+ * _golden_directory: the directory containing the golden images, where missing golden images are recorded
+ * _output_directory: the directory to write the rendered images and difference images to
+ * _channel_tolerance: the largest difference in any channel for pixels to be considered the same (defaults to 2)
+ * _max_differing_fraction: the largest fraction of pixels which can differ for a comparison to pass (defaults to 0.001)
+ * _fail_on_missing: true if a missing golden image should fail the comparison, rather than be recorded (defaults to false)
+ */
+glh::headless::image_regression::image_regression ( const std::string& _golden_directory, const std::string& _output_directory, const unsigned _channel_tolerance, const double _max_differing_fraction, const bool _fail_on_missing )
+    : golden_directory { _golden_directory }
+    , output_directory { _output_directory }
+    , channel_tolerance { _channel_tolerance }
+    , max_differing_fraction { _max_differing_fraction }
+    , fail_on_missing { _fail_on_missing }
+    , num_passed { 0 }
+    , num_failed { 0 }
+    , num_recorded { 0 }
+    , last_differing_fraction { 0.0 }
+{}
+
+
+
+/* compare
+ *
+ * read back the base level of a texture and compare it against its golden image
+ *
+ * name: the name of the image, which is the name of its png files without the extension
+ * texture: the texture to compare
+ *
+ * return: true if the comparison passed, or the golden image was recorded
+ */
+bool glh::headless::image_regression::compare ( const std::string& name, const core::texture2d& texture )
+{
+    /* read back the texture as 8-bit RGBA, whose rows are always 4-byte aligned */
+    std::vector<unsigned char> pixels ( texture.get_width () * texture.get_height () * 4 );
+    texture.get_tex_image ( 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.size (), pixels.data () );
+
+    /* compare the pixels */
+    return compare_pixels ( name, texture.get_width (), texture.get_height (), pixels );
+}
+
+/* compare_default_framebuffer
+ *
+ * copy the color buffer of the default framebuffer into a texture and compare it against its golden image
+ * this needs a window, as a headless context has no default framebuffer
+ *
+ * name: the name of the image, which is the name of its png files without the extension
+ * width/height: the dimensions of the default framebuffer
+ *
+ * return: true if the comparison passed, or the golden image was recorded
+ */
+bool glh::headless::image_regression::compare_default_framebuffer ( const std::string& name, const unsigned width, const unsigned height )
+{
+    /* blit the default framebuffer into a texture */
+    core::texture2d copy_texture { width, height, GL_RGBA8 };
+    core::fbo copy_fbo;
+    copy_fbo.attach_texture ( copy_texture, GL_COLOR_ATTACHMENT0 );
+    copy_fbo.blit_copy_from_default ( 0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST );
+
+    /* compare the texture */
+    return compare ( name, copy_texture );
+}
+
+
+
+/* compare_pixels
+ *
+ * write rendered pixels and compare them against their golden image
+ *
+ * name: the name of the image
+ * width/height: the dimensions of the image
+ * pixels: the 8-bit RGBA pixels read back from OpenGL, with the bottom row first, which are flipped in place
+ *
+ * return: true if the comparison passed, or the golden image was recorded
+ */
+bool glh::headless::image_regression::compare_pixels ( const std::string& name, const unsigned width, const unsigned height, std::vector<unsigned char>& pixels )
+{
+    /* flip the rows, so the top row is first as in image files */
+    for ( unsigned y = 0; y < height / 2; ++y )
+        std::swap_ranges ( pixels.begin () + y * width * 4, pixels.begin () + ( y + 1 ) * width * 4, pixels.begin () + ( height - 1 - y ) * width * 4 );
+
+    /* write the rendered image */
+    write_png ( output_directory / ( name + ".png" ), width, height, pixels );
+
+    /* if there is no golden image, fail if missing golden images should fail, otherwise record the rendered image as the golden image */
+    const std::filesystem::path golden_path = golden_directory / ( name + ".png" );
+    if ( !std::filesystem::exists ( golden_path ) )
+    {
+        if ( fail_on_missing )
+        {
+            last_differing_fraction = 1.0;
+            ++num_failed;
+            return false;
+        }
+        write_png ( golden_path, width, height, pixels );
+        last_differing_fraction = 0.0;
+        ++num_recorded;
+        return true;
+    }
+
+    /* load the golden image, failing if its dimensions differ */
+    const core::image golden { golden_path.string (), 4 };
+    if ( golden.get_width () != width || golden.get_height () != height )
+    {
+        last_differing_fraction = 1.0;
+        ++num_failed;
+        return false;
+    }
+
+    /* count the pixels which differ by more than the tolerance in any channel, marking them in red in a difference image
+     * the pixels which match are shown in dimmed grey, so the differences can be placed in the image
+     */
+    const unsigned char * golden_pixels = static_cast<const unsigned char *> ( golden.get_ptr () );
+    std::vector<unsigned char> difference ( pixels.size () );
+    unsigned num_differing = 0;
+    for ( unsigned i = 0; i < width * height; ++i )
+    {
+        bool differs = false;
+        for ( unsigned c = 0; c < 4; ++c ) differs |= static_cast<unsigned> ( std::abs ( pixels.at ( i * 4 + c ) - golden_pixels [ i * 4 + c ] ) ) > channel_tolerance;
+        const unsigned char grey = ( golden_pixels [ i * 4 ] + golden_pixels [ i * 4 + 1 ] + golden_pixels [ i * 4 + 2 ] ) / 12;
+        difference.at ( i * 4 ) = ( differs ? 255 : grey );
+        difference.at ( i * 4 + 1 ) = ( differs ? 0 : grey );
+        difference.at ( i * 4 + 2 ) = ( differs ? 0 : grey );
+        difference.at ( i * 4 + 3 ) = 255;
+        if ( differs ) ++num_differing;
+    }
+
+    /* record the result, writing the difference image on failure */
+    last_differing_fraction = static_cast<double> ( num_differing ) / ( width * height );
+    if ( last_differing_fraction > max_differing_fraction )
+    {
+        write_png ( output_directory / ( name + ".diff.png" ), width, height, difference );
+        ++num_failed;
+        return false;
+    }
+    ++num_passed;
+    return true;
+}
+
+/* write_png
+ *
+ * write 8-bit RGBA pixels to a png, with the top row first, creating its directory if necessary
+ *
+ * path: the path to write to
+ * width/height: the dimensions of the image
+ * pixels: the pixels to write
+ */
+void glh::headless::image_regression::write_png ( const std::filesystem::path& path, const unsigned width, const unsigned height, const std::vector<unsigned char>& pixels )
+{
+    /* create the directory and write the image, throwing on failure */
+    if ( path.has_parent_path () ) std::filesystem::create_directories ( path.parent_path () );
+    if ( !stbi_write_png ( path.string ().c_str (), width, height, 4, pixels.data (), width * 4 ) )
+        throw exception::headless_exception { "failed to write image to file at path " + path.string () };
+}
+
+
+
+/* display_references
+ *
+ * the number of contexts using each initialised display
+ */
+std::map<EGLDisplay, unsigned> glh::headless::context::display_references {};
@@ -41,15 +41,11 @@ void glh::lighting::dirlight::apply () const
     /* throw if no uniform is cached */
     if ( !cached_uniforms ) throw exception::uniform_exception { "attempted to apply dirlight to uniform with out a complete uniform cache" };
 
+    /* if the light has not changed since it was last applied to the cached uniforms, there is nothing to set */
+    if ( cached_uniforms->applied_version == version ) return;
+
     /* update the shadow camera if necessary */
-    if ( shadow_mapping_enabled && shadow_camera_change )
-    {
-        shadow_camera.set_position ( shadow_region.centre );
-        shadow_camera.set_direction ( direction, math::any_perpandicular ( direction ) );
-        shadow_camera.set_lbn ( math::vec3 { -shadow_region.radius } );
-        shadow_camera.set_rtf ( math::vec3 { shadow_region.radius } );
-        shadow_camera_change = false;
-    }
+    update_shadow_camera ();
 
     /* now set all of the uniform values */
     cached_uniforms->direction_uni.set_vector ( direction );
@@ -63,6 +59,9 @@ void glh::lighting::dirlight::apply () const
     cached_uniforms->pcf_samples_uni.set_int ( pcf_samples );
     cached_uniforms->pcf_radius_uni.set_float ( pcf_radius );
     cached_uniforms->pcf_rotation_uni.set_matrix ( pcf_rotation );
+
+    /* record the version applied */
+    cached_uniforms->applied_version = version;
 }
 
 /* cache_uniforms
@@ -89,11 +88,47 @@ void glh::lighting::dirlight::cache_uniforms ( core::struct_uniform& light_uni )
             light_uni.get_uniform ( "shadow_bias" ),
             light_uni.get_uniform ( "pcf_samples" ),
             light_uni.get_uniform ( "pcf_radius" ),
-            light_uni.get_uniform ( "pcf_rotation" )
+            light_uni.get_uniform ( "pcf_rotation" ),
+            version - 1
         } );
     }
 }
 
+/* get_block
+ *
+ * get the attributes of the light, ready to be laid out in a block
+ */
+glh::lighting::dirlight_block glh::lighting::dirlight::get_block () const
+{
+    /* update the shadow camera if necessary */
+    update_shadow_camera ();
+
+    /* return the attributes as floats */
+    return dirlight_block
+    {
+        math::fvec3 { direction }, math::fvec3 { ambient_color }, math::fvec3 { diffuse_color }, math::fvec3 { specular_color },
+        enabled, shadow_mapping_enabled, math::fmat4 { shadow_camera.get_view_proj () },
+        static_cast<float> ( shadow_bias ), 0.0f, static_cast<int> ( pcf_samples ), static_cast<float> ( pcf_radius ), math::fmat2 { pcf_rotation }
+    };
+}
+
+/* update_shadow_camera
+ *
+ * update the shadow camera, if shadow mapping is enabled and it has changed
+ */
+void glh::lighting::dirlight::update_shadow_camera () const
+{
+    /* move the shadow camera to cover the shadow region */
+    if ( shadow_mapping_enabled && shadow_camera_change )
+    {
+        shadow_camera.set_position ( shadow_region.centre );
+        shadow_camera.set_direction ( direction, math::any_perpandicular ( direction ) );
+        shadow_camera.set_lbn ( math::vec3 { -shadow_region.radius } );
+        shadow_camera.set_rtf ( math::vec3 { shadow_region.radius } );
+        shadow_camera_change = false;
+    }
+}
+
 
 
 /* POINTLIGHT IMPLEMENTATION */
@@ -118,6 +153,9 @@ void glh::lighting::pointlight::apply () const
     /* throw if no uniform is cached */
     if ( !cached_uniforms ) throw exception::uniform_exception { "attempted to apply pointlight to uniform with out a complete uniform cache" };
 
+    /* if the light has not changed since it was last applied to the cached uniforms, there is nothing to set */
+    if ( cached_uniforms->applied_version == version ) return;
+
     /* now set all of the uniform values */
     cached_uniforms->position_uni.set_vector ( position );
     cached_uniforms->att_const_uni.set_float ( att_const );
@@ -132,7 +170,10 @@ void glh::lighting::pointlight::apply () const
     cached_uniforms->shadow_depth_range_mult_uni.set_float ( 1.0 / ( math::modulus ( shadow_region.centre - position ) + shadow_region.radius ) );
     cached_uniforms->pcf_samples_uni.set_int ( pcf_samples );
     cached_uniforms->pcf_radius_uni.set_float ( pcf_radius );
-    cached_uniforms->pcf_rotation_uni.set_matrix ( pcf_rotation );    
+    cached_uniforms->pcf_rotation_uni.set_matrix ( pcf_rotation );
+
+    /* record the version applied */
+    cached_uniforms->applied_version = version;
 }
 
 /* cache_uniforms
@@ -162,11 +203,28 @@ void glh::lighting::pointlight::cache_uniforms ( core::struct_uniform& light_uni
             light_uni.get_uniform ( "shadow_depth_range_mult" ),
             light_uni.get_uniform ( "pcf_samples" ),
             light_uni.get_uniform ( "pcf_radius" ),
-            light_uni.get_uniform ( "pcf_rotation" )            
+            light_uni.get_uniform ( "pcf_rotation" ),
+            version - 1
         } );
     }
 }
 
+/* get_block
+ *
+ * get the attributes of the light, ready to be laid out in a block
+ */
+glh::lighting::pointlight_block glh::lighting::pointlight::get_block () const
+{
+    /* return the attributes as floats */
+    return pointlight_block
+    {
+        math::fvec3 { position }, static_cast<float> ( att_const ), static_cast<float> ( att_linear ), static_cast<float> ( att_quad ),
+        math::fvec3 { ambient_color }, math::fvec3 { diffuse_color }, math::fvec3 { specular_color }, enabled, shadow_mapping_enabled,
+        static_cast<float> ( shadow_bias ), static_cast<float> ( 1.0 / ( math::modulus ( shadow_region.centre - position ) + shadow_region.radius ) ),
+        static_cast<int> ( pcf_samples ), static_cast<float> ( pcf_radius ), math::fmat2 { pcf_rotation }
+    };
+}
+
 
 
 /* SPOTLIGHT IMPLEMENTATION */
@@ -191,15 +249,11 @@ void glh::lighting::spotlight::apply () const
     /* throw if no uniform is cached */
     if ( !cached_uniforms ) throw exception::uniform_exception { "attempted to apply spotlightlight to uniform with out a complete uniform cache" };
 
+    /* if the light has not changed since it was last applied to the cached uniforms, there is nothing to set */
+    if ( cached_uniforms->applied_version == version ) return;
+
     /* update the shadow camera if necessary */
-    if ( shadow_camera_change )
-    {
-        shadow_camera.set_position ( position );
-        shadow_camera.set_direction ( direction, math::any_perpandicular ( direction ) );
-        shadow_camera.set_far ( math::modulus ( shadow_region.centre - position ) + shadow_region.radius );
-        shadow_camera.set_fov ( outer_cone * 2.0 );
-        shadow_camera_change = false;
-    }
+    update_shadow_camera ();
 
     /* now set all of the uniform values */
     cached_uniforms->position_uni.set_vector ( position );
@@ -220,6 +274,9 @@ void glh::lighting::spotlight::apply () const
     cached_uniforms->pcf_samples_uni.set_int ( pcf_samples );
     cached_uniforms->pcf_radius_uni.set_float ( pcf_radius );
     cached_uniforms->pcf_rotation_uni.set_matrix ( pcf_rotation );
+
+    /* record the version applied */
+    cached_uniforms->applied_version = version;
 }
 
 /* cache_uniforms
@@ -253,11 +310,49 @@ void glh::lighting::spotlight::cache_uniforms ( core::struct_uniform& light_uni
             light_uni.get_uniform ( "shadow_depth_range_mult" ),
             light_uni.get_uniform ( "pcf_samples" ),
             light_uni.get_uniform ( "pcf_radius" ),
-            light_uni.get_uniform ( "pcf_rotation" )
+            light_uni.get_uniform ( "pcf_rotation" ),
+            version - 1
         } );
     }
 }
 
+/* get_block
+ *
+ * get the attributes of the light, ready to be laid out in a block
+ */
+glh::lighting::spotlight_block glh::lighting::spotlight::get_block () const
+{
+    /* update the shadow camera if necessary */
+    update_shadow_camera ();
+
+    /* return the attributes as floats */
+    return spotlight_block
+    {
+        math::fvec3 { position }, math::fvec3 { direction }, static_cast<float> ( inner_cone ), static_cast<float> ( outer_cone ),
+        static_cast<float> ( att_const ), static_cast<float> ( att_linear ), static_cast<float> ( att_quad ),
+        math::fvec3 { ambient_color }, math::fvec3 { diffuse_color }, math::fvec3 { specular_color }, enabled, shadow_mapping_enabled,
+        math::fmat4 { shadow_camera.get_view_proj () }, static_cast<float> ( shadow_bias ), static_cast<float> ( 1.0 / ( shadow_camera.get_far () * std::sqrt ( 2.0 ) ) ),
+        static_cast<int> ( pcf_samples ), static_cast<float> ( pcf_radius ), math::fmat2 { pcf_rotation }
+    };
+}
+
+/* update_shadow_camera
+ *
+ * update the shadow camera, if it has changed
+ */
+void glh::lighting::spotlight::update_shadow_camera () const
+{
+    /* move the shadow camera to the light, reaching the far side of the shadow region */
+    if ( shadow_camera_change )
+    {
+        shadow_camera.set_position ( position );
+        shadow_camera.set_direction ( direction, math::any_perpandicular ( direction ) );
+        shadow_camera.set_far ( math::modulus ( shadow_region.centre - position ) + shadow_region.radius );
+        shadow_camera.set_fov ( outer_cone * 2.0 );
+        shadow_camera_change = false;
+    }
+}
+
 
 
 /* LIGHT_SYSTEM IMPLEMENTATION */
@@ -289,6 +384,44 @@ glh::lighting::light_system::light_system ( const unsigned _shadow_map_width )
     shadow_maps_fbo.read_buffer ( GL_NONE ); shadow_maps_fbo.draw_buffer ( GL_NONE );
 }
 
+/* get_shader_defines
+ *
+ * get the #define directives for the maximum number of each type of light, to add to shaders which include shaders/lighting.glsl
+ */
+std::string glh::lighting::light_system::get_shader_defines ()
+{
+    /* define each maximum */
+    return "#define MAX_NUM_DIRLIGHTS " + std::to_string ( GLH_LIGHTING_MAX_DIRLIGHTS ) + "\n"
+           "#define MAX_NUM_POINTLIGHTS " + std::to_string ( GLH_LIGHTING_MAX_POINTLIGHTS ) + "\n"
+           "#define MAX_NUM_SPOTLIGHTS " + std::to_string ( GLH_LIGHTING_MAX_SPOTLIGHTS ) + "\n";
+}
+
+/* get_permutation_features
+ *
+ * get the program permutation features of a light system: NUM_DIRLIGHTS/POINTLIGHTS/SPOTLIGHTS and the NO_SHADOWS flag
+ */
+std::vector<glh::core::permutation_feature> glh::lighting::light_system::get_permutation_features ()
+{
+    /* the number of each light is at most its maximum */
+    return std::vector<core::permutation_feature>
+    {
+        core::permutation_feature { "NUM_DIRLIGHTS", GLH_LIGHTING_MAX_DIRLIGHTS, false },
+        core::permutation_feature { "NUM_POINTLIGHTS", GLH_LIGHTING_MAX_POINTLIGHTS, false },
+        core::permutation_feature { "NUM_SPOTLIGHTS", GLH_LIGHTING_MAX_SPOTLIGHTS, false },
+        core::permutation_feature { "NO_SHADOWS", 1, true }
+    };
+}
+
+/* get_permutation_values
+ *
+ * get the values of the features from get_permutation_features for this light system
+ */
+std::vector<unsigned> glh::lighting::light_system::get_permutation_values () const
+{
+    /* the number of each light, and whether no light requires shadow mapping */
+    return std::vector<unsigned> { dirlight_count (), pointlight_count (), spotlight_count (), static_cast<unsigned> ( !requires_shadow_mapping () ) };
+}
+
 /* apply
  *
  * apply the lighting to uniforms
@@ -320,6 +453,31 @@ void glh::lighting::light_system::apply () const
     cached_uniforms->shadow_maps_uni.set_int ( shadow_maps.bind_loop () );
 }
 
+/* apply to a ubo
+ *
+ * upload all of the lights to a ubo in one write, laid out as a std140 light_system_struct
+ * the ubo should be bound to the binding of a light_system_block uniform block, so one upload serves every program
+ * 
+ * light_system_ubo: the ubo to upload to
+ */
+void glh::lighting::light_system::apply ( core::ubo& light_system_ubo ) const
+{
+    /* upload the lights */
+    core::upload_block<core::std140_layout> ( light_system_ubo, get_block () );
+}
+
+/* apply_shadow_maps
+ *
+ * bind the shadow maps and set a sampler uniform to them
+ * 
+ * shadow_maps_uni: the sampler uniform for the shadow maps
+ */
+void glh::lighting::light_system::apply_shadow_maps ( core::uniform& shadow_maps_uni ) const
+{
+    /* bind shadow maps */
+    shadow_maps_uni.set_int ( shadow_maps.bind_loop () );
+}
+
 /* cache_uniforms
  *
  * cache uniforms for later use
@@ -340,7 +498,7 @@ void glh::lighting::light_system::cache_uniforms ( core::struct_uniform& light_s
             light_system_uni.get_struct_array_uniform ( "pointlights" ),
             light_system_uni.get_uniform ( "spotlights_size" ),
             light_system_uni.get_struct_array_uniform ( "spotlights" ),
-            light_system_uni.get_uniform ( "shadow_maps" )
+            light_system_uni.get_program ().get_uniform ( light_system_uni.get_name () + "_shadow_maps" )
         } );
     }
 
@@ -350,6 +508,28 @@ void glh::lighting::light_system::cache_uniforms ( core::struct_uniform& light_s
     for ( unsigned i = 0; i < spotlights.size (); ++i ) spotlights.at ( i ).cache_uniforms ( cached_uniforms->spotlights_uni.at ( i ) );
 }
 
+/* get_block
+ *
+ * get the attributes of every light, ready to be laid out in a block
+ * throws if there are more lights of a type than the block can hold
+ */
+glh::lighting::light_system_block glh::lighting::light_system::get_block () const
+{
+    /* throw if there are too many lights */
+    if ( dirlights.size () > GLH_LIGHTING_MAX_DIRLIGHTS || pointlights.size () > GLH_LIGHTING_MAX_POINTLIGHTS || spotlights.size () > GLH_LIGHTING_MAX_SPOTLIGHTS )
+        throw exception::block_layout_exception { "attempted to get block of light_system with more lights than the block can hold" };
+
+    /* get the blocks of each light, leaving unused elements zeroed */
+    light_system_block block = light_system_block ();
+    block.dirlights_size = dirlights.size ();
+    for ( unsigned i = 0; i < dirlights.size (); ++i ) block.dirlights.at ( i ) = dirlights.at ( i ).get_block ();
+    block.pointlights_size = pointlights.size ();
+    for ( unsigned i = 0; i < pointlights.size (); ++i ) block.pointlights.at ( i ) = pointlights.at ( i ).get_block ();
+    block.spotlights_size = spotlights.size ();
+    for ( unsigned i = 0; i < spotlights.size (); ++i ) block.spotlights.at ( i ) = spotlights.at ( i ).get_block ();
+    return block;
+}
+
 /* recache_uniforms
  *
  * recache the light collections based on the currently cached uniforms
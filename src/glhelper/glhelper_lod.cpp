@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * src/glhelper/glhelper_lod.cpp
+ *
+ * implementation of include/glhelper/glhelper_lod.hpp
+ *
+ */
+
+
+
+/* INCLUDES */
+
+/* include glhelper_lod.hpp */
+#include <glhelper/glhelper_lod.hpp>
+
+
+
+/* LOD FUNCTIONS IMPLEMENTATION */
+
+/* simplify
+ *
+ * simplify a triangle mesh by collapsing edges until a target number of triangles or an error limit is reached
+ *
+ * positions: the positions of the vertices
+ * triangles: the triangles to simplify
+ * target_triangles: the number of triangles to stop at
+ * max_error: the greatest error a collapse may introduce (in the units of the positions)
+ * report: if not NULL, filled in with the reduction and quality of the simplification
+ *
+ * return: the simplified triangles, which index the same positions
+ */
+std::vector<glh::lod::triangle> glh::lod::simplify ( const std::vector<math::fvec3>& positions, const std::vector<triangle>& triangles, const unsigned target_triangles, const double max_error, simplification_report * report )
+{
+    /* copy the triangles, which will be modified as edges are collapsed
+     * degenerate triangles are removed immediately
+     */
+    std::vector<triangle> working_triangles = triangles;
+    std::vector<bool> triangle_alive ( working_triangles.size (), true );
+    unsigned num_alive = working_triangles.size ();
+    for ( unsigned i = 0; i < working_triangles.size (); ++i )
+    {
+        const triangle& tri = working_triangles.at ( i );
+        if ( tri.at ( 0 ) == tri.at ( 1 ) || tri.at ( 1 ) == tri.at ( 2 ) || tri.at ( 2 ) == tri.at ( 0 ) ) { triangle_alive.at ( i ) = false; --num_alive; }
+    }
+
+    /* find the triangles around each vertex and the quadric of each vertex
+     * the quadric of a vertex is the sum of the quadrics of the planes of its triangles
+     * the original planes each vertex represents are also kept, so that the true error of a collapse can be measured
+     */
+    std::vector<std::vector<unsigned>> vertex_triangles ( positions.size () );
+    std::vector<std::vector<unsigned>> vertex_planes ( positions.size () );
+    std::vector<math::dvec4> planes ( working_triangles.size (), math::dvec4 { 0.0 } );
+    std::vector<quadric> quadrics ( positions.size () );
+    for ( unsigned i = 0; i < working_triangles.size (); ++i ) if ( triangle_alive.at ( i ) )
+    {
+        const triangle& tri = working_triangles.at ( i );
+        const math::dvec3 p0 { positions.at ( tri.at ( 0 ) ) };
+        const math::dvec3 normal = math::cross ( math::dvec3 { positions.at ( tri.at ( 1 ) ) } - p0, math::dvec3 { positions.at ( tri.at ( 2 ) ) } - p0 );
+        const double length = math::modulus ( normal );
+        if ( length > 0.0 ) planes.at ( i ) = math::dvec4 { normal.at ( 0 ) / length, normal.at ( 1 ) / length, normal.at ( 2 ) / length, -math::dot ( normal, p0 ) / length };
+        const quadric plane = ( length > 0.0 ? quadric { planes.at ( i ).at ( 0 ), planes.at ( i ).at ( 1 ), planes.at ( i ).at ( 2 ), planes.at ( i ).at ( 3 ) } : quadric {} );
+        for ( const unsigned index: tri ) { vertex_triangles.at ( index ).push_back ( i ); vertex_planes.at ( index ).push_back ( i ); quadrics.at ( index ) += plane; }
+    }
+
+    /* lock vertices on borders, which are edges used by any number of triangles other than two */
+    std::unordered_map<unsigned long long, unsigned> edge_counts;
+    for ( unsigned i = 0; i < working_triangles.size (); ++i ) if ( triangle_alive.at ( i ) ) for ( unsigned j = 0; j < 3; ++j )
+    {
+        const unsigned a = working_triangles.at ( i ).at ( j ), b = working_triangles.at ( i ).at ( ( j + 1 ) % 3 );
+        ++edge_counts [ ( static_cast<unsigned long long> ( std::min ( a, b ) ) << 32 ) | std::max ( a, b ) ];
+    }
+    std::vector<bool> locked ( positions.size (), false );
+    for ( const auto& edge_count: edge_counts ) if ( edge_count.second != 2 )
+    {
+        locked.at ( edge_count.first >> 32 ) = true;
+        locked.at ( edge_count.first & 0xffffffff ) = true;
+    }
+
+    /* struct for a potential collapse of one vertex onto another
+     * the versions of the vertices at the time the collapse was found are recorded, so that outdated collapses can be skipped
+     */
+    struct collapse
+    {
+        double cost;
+        unsigned from, to;
+        unsigned from_version, to_version;
+        bool operator> ( const collapse& other ) const { return cost > other.cost; }
+    };
+
+    /* queue of collapses, cheapest first */
+    std::priority_queue<collapse, std::vector<collapse>, std::greater<collapse>> collapses;
+    std::vector<unsigned> versions ( positions.size (), 0 );
+    std::vector<bool> removed ( positions.size (), false );
+
+    /* function to add a collapse to the queue */
+    auto push_collapse = [ & ] ( const unsigned from, const unsigned to )
+    {
+        if ( from == to || locked.at ( from ) ) return;
+        quadric combined = quadrics.at ( from ); combined += quadrics.at ( to );
+        collapses.push ( collapse { std::max ( combined.evaluate ( positions.at ( to ) ), 0.0 ), from, to, versions.at ( from ), versions.at ( to ) } );
+    };
+
+    /* function to get the unnormalised normal of a triangle, with one vertex optionally replaced */
+    auto triangle_normal = [ & ] ( const triangle& tri, const unsigned from, const unsigned to )
+    {
+        const math::dvec3 p0 { positions.at ( tri.at ( 0 ) == from ? to : tri.at ( 0 ) ) };
+        const math::dvec3 p1 { positions.at ( tri.at ( 1 ) == from ? to : tri.at ( 1 ) ) };
+        const math::dvec3 p2 { positions.at ( tri.at ( 2 ) == from ? to : tri.at ( 2 ) ) };
+        return math::cross ( p1 - p0, p2 - p0 );
+    };
+
+    /* add the collapses of every edge in both directions */
+    for ( unsigned i = 0; i < working_triangles.size (); ++i ) if ( triangle_alive.at ( i ) ) for ( unsigned j = 0; j < 3; ++j )
+    {
+        push_collapse ( working_triangles.at ( i ).at ( j ), working_triangles.at ( i ).at ( ( j + 1 ) % 3 ) );
+        push_collapse ( working_triangles.at ( i ).at ( ( j + 1 ) % 3 ), working_triangles.at ( i ).at ( j ) );
+    }
+
+    /* perform the cheapest collapses until the target or the error limit is reached
+     * the cost of a collapse is a sum of squared distances to planes, so is never less than the square of the true error
+     * stopping on the cost therefore keeps the true error within the limit
+     */
+    const double max_cost = max_error * max_error;
+    double greatest_error = 0.0;
+    unsigned num_collapses = 0;
+    while ( num_alive > target_triangles && !collapses.empty () )
+    {
+        /* get the cheapest collapse, skipping it if outdated */
+        const collapse next = collapses.top (); collapses.pop ();
+        if ( removed.at ( next.from ) || removed.at ( next.to ) || versions.at ( next.from ) != next.from_version || versions.at ( next.to ) != next.to_version ) continue;
+
+        /* if the cheapest collapse is too expensive, stop */
+        if ( next.cost > max_cost ) break;
+
+        /* reject the collapse if it would flip or degenerate any of the triangles which will remain */
+        bool flips = false;
+        for ( const unsigned i: vertex_triangles.at ( next.from ) ) if ( triangle_alive.at ( i ) )
+        {
+            const triangle& tri = working_triangles.at ( i );
+            if ( tri.at ( 0 ) == next.to || tri.at ( 1 ) == next.to || tri.at ( 2 ) == next.to ) continue;
+            if ( math::dot ( triangle_normal ( tri, next.from, next.from ), triangle_normal ( tri, next.from, next.to ) ) <= 0.0 ) { flips = true; break; }
+        }
+        if ( flips ) continue;
+
+        /* perform the collapse, removing triangles which contained the edge and moving the others onto the remaining vertex */
+        for ( const unsigned i: vertex_triangles.at ( next.from ) ) if ( triangle_alive.at ( i ) )
+        {
+            triangle& tri = working_triangles.at ( i );
+            if ( tri.at ( 0 ) == next.to || tri.at ( 1 ) == next.to || tri.at ( 2 ) == next.to ) { triangle_alive.at ( i ) = false; --num_alive; } else
+            {
+                for ( unsigned& index: tri ) if ( index == next.from ) index = next.to;
+                vertex_triangles.at ( next.to ).push_back ( i );
+            }
+        }
+        quadrics.at ( next.to ) += quadrics.at ( next.from );
+        removed.at ( next.from ) = true;
+        ++versions.at ( next.to );
+        vertex_triangles.at ( next.from ).clear ();
+
+        /* the remaining vertex now represents the original planes of both vertices */
+        std::vector<unsigned>& to_planes = vertex_planes.at ( next.to );
+        to_planes.insert ( to_planes.end (), vertex_planes.at ( next.from ).begin (), vertex_planes.at ( next.from ).end () );
+        std::sort ( to_planes.begin (), to_planes.end () );
+        to_planes.erase ( std::unique ( to_planes.begin (), to_planes.end () ), to_planes.end () );
+        vertex_planes.at ( next.from ).clear ();
+
+        /* record the collapse, and its error, which is the greatest distance from the remaining vertex to any of those planes */
+        ++num_collapses;
+        const math::dvec3 to_position { positions.at ( next.to ) };
+        for ( const unsigned i: to_planes )
+        {
+            const math::dvec4& plane = planes.at ( i );
+            greatest_error = std::max ( greatest_error, std::abs ( plane.at ( 0 ) * to_position.at ( 0 ) + plane.at ( 1 ) * to_position.at ( 1 ) + plane.at ( 2 ) * to_position.at ( 2 ) + plane.at ( 3 ) ) );
+        }
+
+        /* remove dead triangles from around the remaining vertex, and find new collapses for its edges */
+        std::vector<unsigned>& to_triangles = vertex_triangles.at ( next.to );
+        to_triangles.erase ( std::remove_if ( to_triangles.begin (), to_triangles.end (), [ & ] ( const unsigned i ) { return !triangle_alive.at ( i ); } ), to_triangles.end () );
+        for ( const unsigned i: to_triangles ) for ( const unsigned index: working_triangles.at ( i ) )
+        {
+            push_collapse ( index, next.to );
+            push_collapse ( next.to, index );
+        }
+    }
+
+    /* collect the remaining triangles */
+    std::vector<triangle> result;
+    result.reserve ( num_alive );
+    for ( unsigned i = 0; i < working_triangles.size (); ++i ) if ( triangle_alive.at ( i ) ) result.push_back ( working_triangles.at ( i ) );
+
+    /* fill in the report */
+    if ( report )
+    {
+        report->source_triangles = triangles.size ();
+        report->result_triangles = result.size ();
+        report->num_collapses = num_collapses;
+        report->max_error = greatest_error;
+    }
+
+    /* return the triangles */
+    return result;
+}
+
+
+
+/* generate_lods
+ *
+ * generate successive levels of detail of a triangle mesh
+ * each level is simplified from the full detail, so that errors do not accumulate, and targets triangle_ratio of the triangles of the level before
+ * generation stops once a level fails to remove at least a quarter of the triangles of the level before, as further levels would not be worthwhile
+ *
+ * positions: the positions of the vertices
+ * triangles: the triangles of the full detail
+ * max_levels: the greatest number of levels to generate
+ * triangle_ratio: the fraction of the triangles of the previous level each level targets
+ * max_error: the greatest error a collapse may introduce (in the units of the positions)
+ * reports: if not NULL, filled in with the report of each level generated
+ *
+ * return: the triangles of each level generated, from the finest to the coarsest
+ */
+std::vector<std::vector<glh::lod::triangle>> glh::lod::generate_lods ( const std::vector<math::fvec3>& positions, const std::vector<triangle>& triangles, const unsigned max_levels, const double triangle_ratio, const double max_error, std::vector<simplification_report> * reports )
+{
+    /* generate each level, stopping early if it is not worthwhile */
+    std::vector<std::vector<triangle>> levels;
+    if ( reports ) reports->clear ();
+    unsigned previous_triangles = triangles.size ();
+    for ( unsigned i = 0; i < max_levels; ++i )
+    {
+        simplification_report report;
+        std::vector<triangle> level_triangles = simplify ( positions, triangles, previous_triangles * triangle_ratio, max_error, &report );
+        if ( level_triangles.empty () || level_triangles.size () > previous_triangles * 0.75 ) break;
+
+        /* add the level */
+        previous_triangles = level_triangles.size ();
+        levels.push_back ( std::move ( level_triangles ) );
+        if ( reports ) reports->push_back ( report );
+    }
+
+    /* return the levels */
+    return levels;
+}
+
+/* projected_size
+ *
+ * get the radius of a region as a fraction of half the height of the screen
+ * if the viewer is inside of the region, infinity is returned
+ *
+ * _region: the region to project
+ * viewpos: the position of the viewer
+ * fov: the vertical field of view of the viewer
+ */
+double glh::lod::projected_size ( const region::spherical_region<>& _region, const math::vec3& viewpos, const double fov )
+{
+    /* get the distance to the region */
+    const double distance = math::modulus ( _region.centre - viewpos );
+
+    /* if inside the region, return infinity */
+    if ( distance <= _region.radius ) return std::numeric_limits<double>::infinity ();
+
+    /* return the projected size */
+    return _region.radius / ( distance * std::tan ( fov / 2.0 ) );
+}
+
+/* select_lod
+ *
+ * select a level of detail from a projected size
+ * 0 is the full detail, and each level up to num_lods is used for half the size of the level before
+ *
+ * size: the projected size of the region being rendered
+ * threshold: the smallest projected size which is rendered at full detail
+ * num_lods: the number of levels of detail available, not including the full detail
+ */
+unsigned glh::lod::select_lod ( const double size, const double threshold, const unsigned num_lods )
+{
+    /* full detail if at least the threshold */
+    if ( size >= threshold || num_lods == 0 ) return 0;
+
+    /* zero sized regions use the coarsest level */
+    if ( size <= 0.0 ) return num_lods;
+
+    /* otherwise find the level from how many times the size halves to reach the threshold */
+    return std::min<unsigned> ( std::floor ( std::log2 ( threshold / size ) ) + 1, num_lods );
+}
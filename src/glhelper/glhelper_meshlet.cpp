@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * src/glhelper/glhelper_meshlet.cpp
+ *
+ * implementation of include/glhelper/glhelper_meshlet.hpp
+ *
+ */
+
+
+
+/* INCLUDES */
+
+/* include glhelper_meshlet.hpp */
+#include <glhelper/glhelper_meshlet.hpp>
+
+
+
+/* MESHLET FUNCTIONS IMPLEMENTATION */
+
+/* build
+ *
+ * group triangles into meshlets, appending them to existing arrays
+ * the vertex and triangle offsets of the new meshlets are relative to the start of the arrays
+ *
+ * positions: the positions of the vertices
+ * triangles: the triangles to group
+ * meshlets: the array to append the meshlets to
+ * meshlet_vertices: the array to append the vertex indices of each meshlet to
+ * meshlet_triangles: the array to append the packed local triangles of each meshlet to
+ * flags: the flags to give each meshlet (defaults to none)
+ * mesh_index: the mesh index to give each meshlet (defaults to 0)
+ * max_vertices: the maximum number of vertices per meshlet (defaults to GLH_MESHLET_MAX_VERTICES)
+ * max_triangles: the maximum number of triangles per meshlet (defaults to GLH_MESHLET_MAX_TRIANGLES)
+ *
+ * return: the number of meshlets added
+ */
+unsigned glh::meshlet::build ( const std::vector<math::fvec3>& positions, const std::vector<lod::triangle>& triangles, std::vector<meshlet>& meshlets, std::vector<unsigned>& meshlet_vertices, std::vector<unsigned>& meshlet_triangles,
+    const unsigned flags, const unsigned mesh_index, const unsigned max_vertices, const unsigned max_triangles )
+{
+    /* throw if the limits are invalid */
+    if ( max_vertices < 3 || max_vertices > 256 || max_triangles == 0 ) throw exception::meshlet_exception { "meshlets must have between 3 and 256 vertices, and at least 1 triangle" };
+
+    /* find the triangles around each vertex */
+    std::vector<std::vector<unsigned>> vertex_triangles ( positions.size () );
+    for ( unsigned i = 0; i < triangles.size (); ++i ) for ( const unsigned index: triangles.at ( i ) ) vertex_triangles.at ( index ).push_back ( i );
+
+    /* the triangles already in a meshlet, and the index of each vertex within the current meshlet (or -1 if not in the current meshlet) */
+    std::vector<bool> assigned ( triangles.size (), false );
+    std::vector<int> local_indices ( positions.size (), -1 );
+
+    /* the triangles adjacent to the current meshlet */
+    std::vector<unsigned> candidates;
+
+    /* the first triangle which might not be assigned yet */
+    unsigned next_unassigned = 0;
+
+    /* the number of meshlets at the start */
+    const unsigned first_meshlet = meshlets.size ();
+
+    /* function to start a new meshlet */
+    auto start_meshlet = [ & ] ()
+    {
+        meshlets.emplace_back ();
+        meshlet& current = meshlets.back ();
+        current.vertex_offset = meshlet_vertices.size ();
+        current.vertex_count = 0;
+        current.triangle_offset = meshlet_triangles.size ();
+        current.triangle_count = 0;
+        current.flags = flags;
+        current.mesh_index = mesh_index;
+        current.padding [ 0 ] = current.padding [ 1 ] = 0;
+    };
+
+    /* function to finish the current meshlet, computing its bounds */
+    auto finish_meshlet = [ & ] ()
+    {
+        meshlet& current = meshlets.back ();
+
+        /* the centre of the bounding sphere is the mean of the vertices, and the radius is the furthest vertex from the centre */
+        math::dvec3 centre { 0.0 };
+        for ( unsigned i = 0; i < current.vertex_count; ++i ) centre += math::dvec3 { positions.at ( meshlet_vertices.at ( current.vertex_offset + i ) ) };
+        centre /= static_cast<double> ( std::max ( current.vertex_count, 1u ) );
+        double radius = 0.0;
+        for ( unsigned i = 0; i < current.vertex_count; ++i ) radius = std::max ( radius, math::modulus ( math::dvec3 { positions.at ( meshlet_vertices.at ( current.vertex_offset + i ) ) } - centre ) );
+        current.centre = math::fvec3 { centre };
+        current.radius = radius;
+
+        /* the axis of the normal cone is the mean of the normals of the triangles */
+        std::vector<math::dvec3> normals;
+        normals.reserve ( current.triangle_count );
+        math::dvec3 axis { 0.0 };
+        for ( unsigned i = 0; i < current.triangle_count; ++i )
+        {
+            const unsigned packed = meshlet_triangles.at ( current.triangle_offset + i );
+            const math::dvec3 p0 { positions.at ( meshlet_vertices.at ( current.vertex_offset + ( packed & 0xff ) ) ) };
+            const math::dvec3 p1 { positions.at ( meshlet_vertices.at ( current.vertex_offset + ( ( packed >> 8 ) & 0xff ) ) ) };
+            const math::dvec3 p2 { positions.at ( meshlet_vertices.at ( current.vertex_offset + ( ( packed >> 16 ) & 0xff ) ) ) };
+            const math::dvec3 normal = math::cross ( p1 - p0, p2 - p0 );
+            const double length = math::modulus ( normal );
+            if ( length > 0.0 ) { normals.push_back ( normal / length ); axis += normals.back (); }
+        }
+
+        /* the cutoff is the sine of the angle between the axis and the furthest normal
+         * if the normals span too wide an angle (or there are none), the cone is disabled with a cutoff of 1
+         */
+        const double axis_length = math::modulus ( axis );
+        double min_dot = 1.0;
+        if ( axis_length > 0.0 ) { axis /= axis_length; for ( const math::dvec3& normal: normals ) min_dot = std::min ( min_dot, math::dot ( normal, axis ) ); }
+        else min_dot = 0.0;
+        current.cone_axis = math::fvec3 { axis };
+        current.cone_cutoff = ( min_dot <= 0.1 ? 1.0 : std::sqrt ( 1.0 - min_dot * min_dot ) );
+
+        /* reset the local indices of the vertices and the candidates */
+        for ( unsigned i = 0; i < current.vertex_count; ++i ) local_indices.at ( meshlet_vertices.at ( current.vertex_offset + i ) ) = -1;
+        candidates.clear ();
+    };
+
+    /* function to count the number of vertices of a triangle not yet in the current meshlet */
+    auto count_new_vertices = [ & ] ( const unsigned i )
+    {
+        return ( local_indices.at ( triangles.at ( i ).at ( 0 ) ) < 0 ) + ( local_indices.at ( triangles.at ( i ).at ( 1 ) ) < 0 ) + ( local_indices.at ( triangles.at ( i ).at ( 2 ) ) < 0 );
+    };
+
+    /* function to check if a triangle adding a number of vertices would fit in the current meshlet */
+    auto fits = [ & ] ( const unsigned new_vertices )
+    {
+        return meshlets.back ().triangle_count < max_triangles && meshlets.back ().vertex_count + new_vertices <= max_vertices;
+    };
+
+    /* add triangles until all are assigned */
+    if ( !triangles.empty () ) start_meshlet ();
+    while ( true )
+    {
+        /* find the adjacent triangle which adds the fewest new vertices */
+        int best = -1;
+        unsigned best_new_vertices = 4;
+        bool adjacent_remaining = false;
+        for ( const unsigned i: candidates ) if ( !assigned.at ( i ) )
+        {
+            adjacent_remaining = true;
+            const unsigned new_vertices = count_new_vertices ( i );
+            if ( new_vertices < best_new_vertices && fits ( new_vertices ) ) { best = i; best_new_vertices = new_vertices; }
+        }
+
+        /* if no adjacent triangle fits... */
+        if ( best < 0 )
+        {
+            /* if adjacent triangles remain, the meshlet is full, so start a new one */
+            if ( adjacent_remaining ) { finish_meshlet (); start_meshlet (); continue; }
+
+            /* otherwise take the next unassigned triangle, stopping if there are none left */
+            while ( next_unassigned < triangles.size () && assigned.at ( next_unassigned ) ) ++next_unassigned;
+            if ( next_unassigned == triangles.size () ) break;
+            if ( !fits ( count_new_vertices ( next_unassigned ) ) ) { finish_meshlet (); start_meshlet (); continue; }
+            best = next_unassigned;
+        }
+
+        /* add the triangle to the meshlet */
+        meshlet& current = meshlets.back ();
+        unsigned packed = 0;
+        for ( unsigned j = 0; j < 3; ++j )
+        {
+            const unsigned index = triangles.at ( best ).at ( j );
+            if ( local_indices.at ( index ) < 0 ) { local_indices.at ( index ) = current.vertex_count++; meshlet_vertices.push_back ( index ); }
+            packed |= local_indices.at ( index ) << ( j * 8 );
+        }
+        meshlet_triangles.push_back ( packed );
+        ++current.triangle_count;
+        assigned.at ( best ) = true;
+
+        /* add the triangles adjacent to the new triangle as candidates */
+        for ( const unsigned index: triangles.at ( best ) ) for ( const unsigned i: vertex_triangles.at ( index ) ) if ( !assigned.at ( i ) ) candidates.push_back ( i );
+    }
+
+    /* finish the final meshlet */
+    if ( !triangles.empty () ) finish_meshlet ();
+
+    /* return the number of meshlets added */
+    return meshlets.size () - first_meshlet;
+}
+
+
+
+/* meshlet_region
+ *
+ * get the bounding sphere of a meshlet as a region
+ */
+glh::region::spherical_region<> glh::meshlet::meshlet_region ( const meshlet& _meshlet )
+{
+    /* return the region */
+    return region::spherical_region<> { math::vec3 { _meshlet.centre }, _meshlet.radius };
+}
+
+/* is_backfacing
+ *
+ * returns true if every triangle of the meshlet faces away from a viewing position
+ *
+ * _meshlet: the meshlet to test
+ * viewpos: the viewing position, in the same space as the meshlet
+ */
+bool glh::meshlet::is_backfacing ( const meshlet& _meshlet, const math::vec3& viewpos )
+{
+    /* the meshlet is backfacing if the direction to it from the viewer lies within the normal cone, expanded by the bounding sphere */
+    const math::vec3 view_direction = math::vec3 { _meshlet.centre } - viewpos;
+    return math::dot ( view_direction, math::vec3 { _meshlet.cone_axis } ) >= _meshlet.cone_cutoff * math::modulus ( view_direction ) + _meshlet.radius;
+}
@@ -35,10 +35,24 @@ glh::model::model::model ( const std::string& _directory, const std::string& _en
     , entry { _entry }
     , model_import_flags { _model_import_flags }
     , pps { aiProcessPreset_TargetRealtime_MaxQuality }
+    , import_time { 0.0 }
+    , alpha_test_time { 0.0 }
+    , num_alpha_tested_faces { 0 }
+    , model_render_instances { 1 }
+    , model_render_base_instance { 0 }
+    , model_face_culling { false }
     , pretransform_matrix { _pretransform_matrix }
     , pretransform_normal_matrix { math::normal ( _pretransform_matrix ) }
-    , alpha_test_program { alpha_test_vshader, alpha_test_gshader, alpha_test_fshader }
+    , num_meshlets { 0 }
+    , instance_data { ( GLH_MODEL_MAX_FRAME_INSTANCES + 1 ) * sizeof ( math::fmat4 ) }
+    , occlusion_pyramid { NULL }
+    , culling_frustum { NULL }
+    , lod_camera { NULL }
+    , lod_threshold { 0.25 }
 {
+    /* start timing the import */
+    const auto timestamp_start = std::chrono::steady_clock::now ();
+
     /* add debone and optimise graph */
     pps |= aiProcess_Debone | aiProcess_OptimizeGraph;
 
@@ -53,15 +67,29 @@ glh::model::model::model ( const std::string& _directory, const std::string& _en
     if ( model_import_flags & import_flags::GLH_IGNORE_VCOLOR_WHEN_ALPHA_TESTING && model_import_flags & import_flags::GLH_IGNORE_TEXTURE_COLOR_WHEN_ALPHA_TESTING )
         throw exception::model_exception { "cannot import model with both GLH_IGNORE_VCOLOR_WHEN_ALPHA_TESTING and GLH_IGNORE_TEXTURE_COLOR_WHEN_ALPHA_TESTING options set" };
 
-    /* if alpha testing is requested, initialise the program and shaders */
-    if ( model_import_flags & import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES )
+    /* throw if GLH_BUILD_MESHLETS is set without GLH_CONFIGURE_GLOBAL_VERTEX_ARRAYS */
+    if ( model_import_flags & import_flags::GLH_BUILD_MESHLETS && ~model_import_flags & import_flags::GLH_CONFIGURE_GLOBAL_VERTEX_ARRAYS )
+        throw exception::model_exception { "cannot import model with GLH_BUILD_MESHLETS set without GLH_CONFIGURE_GLOBAL_VERTEX_ARRAYS" };
+
+    /* if alpha testing is requested, get the shared alpha test program, which is only compiled by the first model to need it */
+    if ( model_import_flags & import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES && ~model_import_flags & import_flags::GLH_ALPHA_TEST_ON_CPU )
     {
-        alpha_test_vshader.include_files ( { "shaders/materials.glsl", "shaders/vertex.alpha_test.glsl" } );
-        alpha_test_gshader.include_files ( { "shaders/materials.glsl", "shaders/geometry.alpha_test.glsl" } );
-        alpha_test_fshader.include_files ( { "shaders/materials.glsl", "shaders/fragment.alpha_test.glsl" } );
-        alpha_test_program.compile_and_link ();
+        if ( model_import_flags & import_flags::GLH_ALPHA_TEST_BY_RASTERISATION ) alpha_test_program = core::program_registry::get
+        (
+            { "shaders/materials.glsl", "shaders/vertex.alpha_test.glsl" },
+            { "shaders/materials.glsl", "shaders/geometry.alpha_test.glsl" },
+            { "shaders/materials.glsl", "shaders/fragment.alpha_test.glsl" },
+            get_shader_defines ()
+        );
+        else alpha_test_compute_program = core::program_registry::get_compute ( { "shaders/materials.glsl", "shaders/compute.alpha_test.glsl" }, get_shader_defines () );
     }
 
+    /* write a single identity matrix to the start of the first frame region of the instance data
+     * this is slot 0, which render_instanced skips over whenever the first region is reused, so rendering without instancing is unaffected
+     */
+    const math::fmat4 identity_instance { math::identity<4> () };
+    instance_data.write ( identity_instance.internal_ptr (), sizeof ( math::fmat4 ), sizeof ( math::fmat4 ) );
+
     /* create the importer */
     Assimp::Importer importer;
 
@@ -73,6 +101,9 @@ glh::model::model::model ( const std::string& _directory, const std::string& _en
 
     /* process the scene */
     process_scene ( * aiscene );
+
+    /* record the import time */
+    import_time = std::chrono::duration<double, std::milli> { std::chrono::steady_clock::now () - timestamp_start }.count ();
 }
 
 
@@ -100,24 +131,28 @@ void glh::model::model::render ( const math::mat4& transform, const unsigned fla
     if ( !cached_material_uniforms && ~flags & render_flags::GLH_NO_MATERIAL || !cached_model_matrix_uniform && ~flags & render_flags::GLH_NO_MODEL_MATRIX )
         throw exception::uniform_exception { "attempted to render model without a complete uniform cache" };
 
-    /* cache the render flags */
-    model_render_flags = flags;
+    /* throw if occlusion culling is requested without a depth pyramid or mesh regions */
+    if ( flags & render_flags::GLH_OCCLUSION_CULLING && ( !occlusion_pyramid || !has_mesh_regions () ) )
+        throw exception::model_exception { "attempted to occlusion cull model without a depth pyramid or configured mesh regions" };
 
-    /* if imported with global vertex arrays configured... */
-    if ( model_import_flags & import_flags::GLH_CONFIGURE_GLOBAL_VERTEX_ARRAYS )
-    {
-        /* bind global vertex arrays */
-        global_vertex_arrays.bind ();
+    /* throw if frustum culling is requested without a frustum or mesh regions */
+    if ( flags & render_flags::GLH_FRUSTUM_CULLING && ( !culling_frustum || !has_mesh_regions () ) )
+        throw exception::model_exception { "attempted to frustum cull model without a frustum or configured mesh regions" };
 
-        /* render the root node */
-        render_node ( root_node, transform );
+    /* throw if level of detail selection is requested without a camera or mesh regions */
+    if ( flags & render_flags::GLH_LOD_SELECTION && ( !lod_camera || !has_mesh_regions () ) )
+        throw exception::model_exception { "attempted to select levels of detail of model without a camera or configured mesh regions" };
 
-        /* only unbind if GLH_LEAVE_GLOBAL_VERTEX_ARRAYS_BOUND is unset */
-        if ( ~model_render_flags & render_flags::GLH_LEAVE_GLOBAL_VERTEX_ARRAYS_BOUND ) global_vertex_arrays.unbind ();
-    } 
-    /* else just render root node normally */
-    else render_node ( root_node, transform );
+    /* read back the depth pyramid if occlusion culling, as rendering is always on the thread with the context */
+    if ( flags & render_flags::GLH_OCCLUSION_CULLING ) occlusion_pyramid->readback ();
+
+    /* cache the render flags and render a single instance, which uses the identity instance matrix */
+    model_render_flags = flags;
+    model_render_instances = 1;
+    model_render_base_instance = 0;
 
+    /* render the root node */
+    render_root ( transform );
 }
 void glh::model::model::render ( const unsigned flags )
 {
@@ -127,6 +162,145 @@ void glh::model::model::render ( const unsigned flags )
 
 
 
+/* render_instanced
+ *
+ * render many copies of the model, drawing each mesh only once
+ * the transforms are written into the current frame region of the instance data as per-instance vertex attributes, and the program must make use of them (see shaders/vertex.model_instanced.glsl)
+ * the model matrix uniform is still set to the transformation of each node, so should be set to the identity if GLH_NO_MODEL_MATRIX is used
+ * throws if more than GLH_MODEL_MAX_FRAME_INSTANCES instances are drawn since the last call to next_frame
+ * 
+ * material_uni: material uniform to cache and set the material properties to
+ * model_matrix_uni: a 4x4 matrix uniform to cache and apply set the node transformations to
+ * transforms: the model transformation of each instance
+ * flags: rendering flags (none by default)
+ * 
+ * return: the number of instances drawn after culling
+ */
+unsigned glh::model::model::render_instanced ( core::struct_uniform& material_uni, core::uniform& model_matrix_uni, const std::vector<math::mat4>& transforms, const unsigned flags )
+{
+    /* reload the cache of uniforms  */
+    cache_uniforms ( material_uni, model_matrix_uni );
+
+    /* render */
+    return render_instanced ( transforms, flags );
+}
+unsigned glh::model::model::render_instanced ( const std::vector<math::mat4>& transforms, const unsigned flags ) const
+{
+    /* throw if uniforms are not already cached */
+    if ( !cached_material_uniforms && ~flags & render_flags::GLH_NO_MATERIAL || !cached_model_matrix_uniform && ~flags & render_flags::GLH_NO_MODEL_MATRIX )
+        throw exception::uniform_exception { "attempted to render model without a complete uniform cache" };
+
+    /* throw if culling is requested without a depth pyramid or frustum */
+    if ( flags & render_flags::GLH_OCCLUSION_CULLING && !occlusion_pyramid )
+        throw exception::model_exception { "attempted to occlusion cull model instances without a depth pyramid" };
+    if ( flags & render_flags::GLH_FRUSTUM_CULLING && !culling_frustum )
+        throw exception::model_exception { "attempted to frustum cull model instances without a frustum" };
+
+    /* read back the depth pyramid if occlusion culling, as rendering is always on the thread with the context */
+    if ( flags & render_flags::GLH_OCCLUSION_CULLING ) occlusion_pyramid->readback ();
+
+    /* collect the matrices of the instances which survive culling
+     * the frustum is tested first, as it is the cheaper of the two tests
+     */
+    instance_matrices.clear ();
+    instance_matrices.reserve ( transforms.size () );
+    for ( const math::mat4& transform: transforms )
+    {
+        if ( flags & ( render_flags::GLH_FRUSTUM_CULLING | render_flags::GLH_OCCLUSION_CULLING ) )
+        {
+            const region::spherical_region<> instance_region = model_region ( transform );
+            if ( flags & render_flags::GLH_FRUSTUM_CULLING && culling_frustum->is_culled ( instance_region ) ) continue;
+            if ( flags & render_flags::GLH_OCCLUSION_CULLING && occlusion_pyramid->is_occluded ( instance_region ) ) continue;
+        }
+        instance_matrices.push_back ( transform );
+    }
+
+    /* if every instance was culled, there is nothing to draw */
+    if ( instance_matrices.empty () ) return 0;
+
+    /* if the first frame region is being reused, skip over the identity instance in slot 0 */
+    if ( instance_data.get_current_region () == 0 && instance_data.get_region_used () == 0 ) instance_data.allocate ( sizeof ( math::fmat4 ), sizeof ( math::fmat4 ) );
+
+    /* throw if the instance matrices do not fit in what is left of the frame region */
+    const unsigned instance_data_size = instance_matrices.size () * sizeof ( math::fmat4 );
+    if ( instance_data.get_region_used () + instance_data_size > instance_data.get_region_size () )
+        throw exception::model_exception { "attempted to render more than GLH_MODEL_MAX_FRAME_INSTANCES instances of model in one frame" };
+
+    /* write the instance matrices straight into the frame region, aligned to whole slots so that they can be reached by the base instance */
+    const unsigned instance_data_offset = instance_data.write ( instance_matrices.begin (), instance_matrices.end (), sizeof ( math::fmat4 ) );
+
+    /* cache the render flags, removing the culling flags as they have already been applied to the instances, and set the number of instances
+     * level of detail selection is also removed, as all instances share the same draw
+     * the instances start from the slot of the instance data they were written to
+     */
+    model_render_flags = flags & ~( render_flags::GLH_FRUSTUM_CULLING | render_flags::GLH_OCCLUSION_CULLING | render_flags::GLH_LOD_SELECTION );
+    model_render_instances = instance_matrices.size ();
+    model_render_base_instance = instance_data_offset / sizeof ( math::fmat4 );
+
+    /* render the root node with an identity transformation, as the instance matrices hold the model transformations */
+    render_root ( math::identity<4> () );
+
+    /* return the number of instances drawn */
+    return model_render_instances;
+}
+
+/* record
+ *
+ * record a packet for each mesh which would be rendered into a render queue, rather than rendering immediately
+ * the depth of each packet is the distance of the mesh region from the view position of the queue, if the mesh regions are configured
+ * two sided meshes are recorded with face culling disabled in the render state
+ * GLH_LEAVE_GLOBAL_VERTEX_ARRAYS_BOUND has no effect, as the queue binds vaos itself
+ * throws if occlusion culling against a depth pyramid which has not been read back since it was built
+ * 
+ * queue: the render queue to record into
+ * state: the render state to record the meshes with
+ * prog: the program to record the meshes with, which the cached uniforms must belong to
+ * transform: the overall model transformation to apply (identity by default)
+ * flags: rendering flags (none by default)
+ */
+void glh::model::model::record ( core::render_queue& queue, const core::render_state& state, const core::program& prog, const math::mat4& transform, const unsigned flags ) const
+{
+    /* throw if uniforms are not already cached */
+    if ( !cached_material_uniforms && ~flags & render_flags::GLH_NO_MATERIAL || !cached_model_matrix_uniform && ~flags & render_flags::GLH_NO_MODEL_MATRIX )
+        throw exception::uniform_exception { "attempted to record model without a complete uniform cache" };
+
+    /* throw if culling or level of detail selection is requested without what they need */
+    if ( flags & render_flags::GLH_OCCLUSION_CULLING && ( !occlusion_pyramid || !has_mesh_regions () ) )
+        throw exception::model_exception { "attempted to occlusion cull model without a depth pyramid or configured mesh regions" };
+    if ( flags & render_flags::GLH_FRUSTUM_CULLING && ( !culling_frustum || !has_mesh_regions () ) )
+        throw exception::model_exception { "attempted to frustum cull model without a frustum or configured mesh regions" };
+    if ( flags & render_flags::GLH_LOD_SELECTION && ( !lod_camera || !has_mesh_regions () ) )
+        throw exception::model_exception { "attempted to select levels of detail of model without a camera or configured mesh regions" };
+
+    /* throw if occlusion culling against a depth pyramid which has not been read back, as recording may not be on the thread with the context */
+    if ( flags & render_flags::GLH_OCCLUSION_CULLING && occlusion_pyramid->is_readback_pending () )
+        throw exception::model_exception { "attempted to occlusion cull model against a depth pyramid which has not been read back" };
+
+    /* record the root node, with a second state for two sided meshes */
+    record_node ( queue, state, state.with_face_culling ( false ), prog, root_node, transform, flags );
+}
+
+/* prepare_packet
+ *
+ * set the model matrix and material uniforms of a packet recorded by record
+ * the material is not applied again if the previous packet was recorded by this model with the same program and material
+ * 
+ * packet: the packet about to be drawn
+ * previous: the packet drawn before it, or NULL if it is the first
+ */
+void glh::model::model::prepare_packet ( const core::draw_packet& packet, const core::draw_packet * previous ) const
+{
+    /* set the model matrix, if no model matrix flag not set */
+    if ( ~packet.source_flags & render_flags::GLH_NO_MODEL_MATRIX ) 
+        cached_model_matrix_uniform->model_matrix_uni.set_matrix ( packet.transform );
+
+    /* apply the material, if not disabled in flags and not already applied by the previous packet */
+    if ( ~packet.source_flags & render_flags::GLH_NO_MATERIAL && !( previous && previous->source == this && ~previous->source_flags & render_flags::GLH_NO_MATERIAL && 
+        previous->prog == packet.prog && previous->material == packet.material ) ) apply_material ( * static_cast<const material *> ( packet.material ), packet.source_flags );
+}
+
+
+
 /* cache_uniforms
  *
  * cache all uniforms
@@ -208,6 +382,96 @@ void glh::model::model::cache_model_uniform ( core::uniform& model_matrix_uni )
 
 
 
+/* has_mesh_regions
+ *
+ * returns true if the regions of meshes were configured on import
+ */
+bool glh::model::model::has_mesh_regions () const
+{
+    /* mesh regions are configured if any region flag is set, unless accurate regions are used only for the root node */
+    return ( model_import_flags & ( import_flags::GLH_CONFIGURE_REGIONS_FAST | import_flags::GLH_CONFIGURE_REGIONS_ACCEPTABLE | import_flags::GLH_CONFIGURE_REGIONS_ACCURATE ) ) &&
+        !( model_import_flags & import_flags::GLH_CONFIGURE_REGIONS_ACCURATE && model_import_flags & import_flags::GLH_CONFIGURE_ONLY_ROOT_NODE_REGION );
+}
+
+
+
+
+/* get_num_lods
+ *
+ * get the greatest number of levels of detail of any mesh, not including the full detail
+ */
+unsigned glh::model::model::get_num_lods () const
+{
+    /* find the greatest number of levels */
+    unsigned num_lods = 0;
+    for ( const mesh& _mesh: meshes ) num_lods = std::max<unsigned> ( num_lods, _mesh.lods.size () );
+    return num_lods;
+}
+
+/* lod_report
+ *
+ * get the combined reduction and quality of a level of detail over all meshes
+ * meshes with fewer levels of detail contribute their least detailed level
+ * 
+ * level: the level of detail to report on (0 for the full detail)
+ */
+glh::lod::simplification_report glh::model::model::lod_report ( const unsigned level ) const
+{
+    /* combine the reports of each mesh */
+    lod::simplification_report report;
+    for ( const mesh& _mesh: meshes )
+    {
+        report.source_triangles += _mesh.num_faces;
+        if ( level == 0 || _mesh.lods.empty () ) report.result_triangles += _mesh.num_faces; else
+        {
+            const mesh_lod& _mesh_lod = _mesh.lods.at ( std::min<unsigned> ( level, _mesh.lods.size () ) - 1 );
+            report.result_triangles += _mesh_lod.report.result_triangles;
+            report.num_collapses += _mesh_lod.report.num_collapses;
+            report.max_error = std::max ( report.max_error, _mesh_lod.report.max_error );
+        }
+    }
+
+    /* return the report */
+    return report;
+}
+
+
+
+/* cull_meshlets
+ *
+ * cull the meshlets of the model on the CPU, returning the indices of those which are visible in the global meshlet data
+ * meshlets are always tested against their normal cones, and the GLH_FRUSTUM_CULLING and GLH_OCCLUSION_CULLING render flags enable the other tests
+ * GLH_OPAQUE_MODE and GLH_TRANSPARENT_MODE only keep the meshlets which would be rendered in that mode
+ * throws if occlusion culling against a depth pyramid which has not been read back since it was built
+ * 
+ * viewpos: the position of the viewer
+ * transform: the overall model transformation to apply (identity by default)
+ * flags: rendering flags (none by default)
+ * 
+ * return: the global indices of the visible meshlets
+ */
+std::vector<unsigned> glh::model::model::cull_meshlets ( const math::vec3& viewpos, const math::mat4& transform, const unsigned flags ) const
+{
+    /* throw if meshlets were not built, or if culling without the frustum or depth pyramid being set */
+    if ( ~model_import_flags & import_flags::GLH_BUILD_MESHLETS )
+        throw exception::model_exception { "attempted to cull meshlets of model imported without GLH_BUILD_MESHLETS" };
+    if ( flags & render_flags::GLH_FRUSTUM_CULLING && !culling_frustum )
+        throw exception::model_exception { "attempted to frustum cull meshlets without a frustum set" };
+    if ( flags & render_flags::GLH_OCCLUSION_CULLING && !occlusion_pyramid )
+        throw exception::model_exception { "attempted to occlusion cull meshlets without a depth pyramid set" };
+    if ( flags & render_flags::GLH_OCCLUSION_CULLING && occlusion_pyramid->is_readback_pending () )
+        throw exception::model_exception { "attempted to occlusion cull meshlets against a depth pyramid which has not been read back" };
+
+    /* cull the meshlets of the root node */
+    std::vector<unsigned> visible;
+    visible.reserve ( num_meshlets );
+    cull_node_meshlets ( root_node, transform, viewpos, flags, visible );
+
+    /* return the visible meshlets */
+    return visible;
+}
+
+
 
 /* process_scene
  *
@@ -224,18 +488,29 @@ void glh::model::model::process_scene ( const aiScene& aiscene )
 
     /* now loop through the meshes */
     meshes.resize ( aiscene.mNumMeshes );
-    for ( unsigned i = 0; i < aiscene.mNumMeshes; ++i )
-    {   
-        /* add the mesh */
-        add_mesh ( meshes.at ( i ), * aiscene.mMeshes [ i ] );
+    for ( unsigned i = 0; i < aiscene.mNumMeshes; ++i ) add_mesh ( meshes.at ( i ), * aiscene.mMeshes [ i ] );
 
-        /* if required to split the meshes, also split it */
-        if ( model_import_flags & import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES ) split_mesh ( meshes.at ( i ) );
-    }
+    /* if required to split the meshes, split them all together */
+    if ( model_import_flags & import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES ) split_meshes ();
+
+    /* generate levels of detail and build meshlets, if required, spreading the meshes across the shared thread pool */
+    if ( model_import_flags & ( import_flags::GLH_GENERATE_LODS | import_flags::GLH_BUILD_MESHLETS ) )
+        thread::thread_pool::get_shared ().parallel_for ( meshes.size (), [ this ] ( const unsigned i )
+        {
+            if ( model_import_flags & import_flags::GLH_GENERATE_LODS ) generate_lods ( meshes.at ( i ) );
+            if ( model_import_flags & import_flags::GLH_BUILD_MESHLETS ) build_meshlets ( meshes.at ( i ) );
+        } );
+
+    /* buffer the final index data, if it was not already buffered when the mesh was added */
+    if ( model_import_flags & ( import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES | import_flags::GLH_GENERATE_LODS ) )
+        for ( mesh& _mesh: meshes ) buffer_index_data ( _mesh );
 
     /* configure global vertex arrays if necessary */
     if ( model_import_flags & import_flags::GLH_CONFIGURE_GLOBAL_VERTEX_ARRAYS ) configure_global_vertex_arrays ();
 
+    /* configure meshlet buffers if necessary */
+    if ( model_import_flags & import_flags::GLH_BUILD_MESHLETS ) configure_meshlet_buffers ();
+
     /* now recursively process all of the nodes */
     root_node.parent = NULL;
     add_node ( root_node, * aiscene.mRootNode );
@@ -570,6 +845,7 @@ glh::model::mesh& glh::model::model::add_mesh ( mesh& _mesh, const aiMesh& aimes
     _mesh.global_start_of_faces             = 0;
     _mesh.global_start_of_opaque_faces      = 0;
     _mesh.global_start_of_transparent_faces = 0;
+    _mesh.global_start_of_meshlets          = 0;
 
     /* set definitely opaque */
     _mesh.definitely_opaque = is_definitely_opaque ( _mesh );
@@ -587,9 +863,9 @@ glh::model::mesh& glh::model::model::add_mesh ( mesh& _mesh, const aiMesh& aimes
     _mesh.vertex_data.buffer_storage ( _mesh.vertices.begin (), _mesh.vertices.end () );
 
     /* buffer index data 
-     * don't use immutable storage if the meshes will be split
+     * don't use immutable storage if the meshes will be split or have levels of detail added
      */
-    if ( model_import_flags & import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES )
+    if ( model_import_flags & ( import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES | import_flags::GLH_GENERATE_LODS ) )
         _mesh.index_data.buffer_data ( _mesh.faces.begin (), _mesh.faces.end () );
     else _mesh.index_data.buffer_storage ( _mesh.faces.begin (), _mesh.faces.end () );
 
@@ -600,6 +876,7 @@ glh::model::mesh& glh::model::model::add_mesh ( mesh& _mesh, const aiMesh& aimes
     _mesh.vertex_arrays.set_vertex_attrib ( 3, _mesh.vertex_data, 4, GL_FLOAT, GL_FALSE, sizeof ( vertex ), 9 * sizeof ( GLfloat ) );
     for ( unsigned i = 0; i < _mesh.num_uv_channels; ++i )
         _mesh.vertex_arrays.set_vertex_attrib ( 4 + i, _mesh.vertex_data, 2, GL_FLOAT, GL_FALSE, sizeof ( vertex ), ( 13 + i * 2 ) * sizeof ( GLfloat ) );
+    configure_instance_attribs ( _mesh.vertex_arrays );
     _mesh.vertex_arrays.bind_ebo ( _mesh.index_data );
 
 
@@ -636,25 +913,94 @@ glh::model::face& glh::model::model::add_face ( face& _face, const mesh& _mesh,
 
 
 
+/* split_meshes
+ *
+ * split every mesh into opaque and transparent faces
+ * meshes which need alpha testing are tested with a dispatch of the compute program for each material, and the results are read after a single fence
+ * if GLH_ALPHA_TEST_ON_CPU is set, the faces are tested on the cpu instead, and if GLH_ALPHA_TEST_BY_RASTERISATION is set, each mesh is split with split_mesh instead
+ */
+void glh::model::model::split_meshes ()
+{
+    /* start timing the alpha testing */
+    const auto timestamp_start = std::chrono::steady_clock::now ();
+
+    /* find the meshes which need alpha testing */
+    std::vector<mesh *> tested_meshes;
+    for ( mesh& _mesh: meshes )
+    {
+        /* if mesh is definitely opaque, set the number of opaque faces to be the same as the number of faces
+         * since the index is already zero, this will cause the same vertices to be used by general faces as well as opaque faces
+         */
+        if ( _mesh.definitely_opaque ) _mesh.num_opaque_faces = _mesh.num_faces; else
+
+        /* else if the material has an opacity of less than 1.0, set the number of transparent faces to be the same as the number of faces
+         * since the index is already zero, this will cause the same vertices to be used by general faces as well as transparent faces
+         */
+        if ( _mesh.properties->opacity < 1.0 ) _mesh.num_transparent_faces = _mesh.num_faces;
+
+        /* else the mesh must be alpha tested */
+        else { tested_meshes.push_back ( &_mesh ); num_alpha_tested_faces += _mesh.num_faces; }
+    }
+
+    /* if alpha testing by rasterisation, split each mesh in turn */
+    if ( model_import_flags & import_flags::GLH_ALPHA_TEST_BY_RASTERISATION && ~model_import_flags & import_flags::GLH_ALPHA_TEST_ON_CPU ) for ( mesh * _mesh: tested_meshes ) split_mesh ( * _mesh );
+
+    /* otherwise alpha test every face on the cpu or with the compute program */
+    else if ( !tested_meshes.empty () )
+    {
+        /* sort the meshes by material, so that the faces of meshes with the same material are tested by one dispatch */
+        std::stable_sort ( tested_meshes.begin (), tested_meshes.end (), [] ( const mesh * lhs, const mesh * rhs ) { return lhs->properties_index < rhs->properties_index; } );
+
+        /* get the face data and diffuse stack of each mesh */
+        std::vector<float> face_data;
+        std::vector<unsigned> first_faces;
+        std::vector<alpha_test::stack> stacks;
+        get_alpha_test_faces ( std::vector<const mesh *> { tested_meshes.begin (), tested_meshes.end () }, face_data, first_faces, stacks );
+
+        /* if alpha testing on the cpu, test every face across the shared thread pool */
+        std::vector<unsigned> alpha_test_results;
+        if ( model_import_flags & import_flags::GLH_ALPHA_TEST_ON_CPU )
+        {
+            std::vector<const alpha_test::stack *> stack_pointers;
+            for ( const alpha_test::stack& _stack: stacks ) stack_pointers.push_back ( &_stack );
+            alpha_test_results = alpha_test::test_faces ( face_data, GLH_MODEL_MAX_TEXTURE_STACK_SIZE, first_faces, stack_pointers );
+        } else
+        {
+            /* upload the faces, and cache the material uniform of the compute program */
+            alpha_test::compute_tester tester { * alpha_test_compute_program, face_data, GLH_MODEL_MAX_TEXTURE_STACK_SIZE };
+            cache_material_uniforms ( alpha_test_compute_program->get_struct_uniform ( "material" ) );
+
+            /* dispatch for each run of meshes with the same material, without waiting for any of them */
+            for ( unsigned i = 0, j = 0; i < tested_meshes.size (); i = j )
+            {
+                while ( j < tested_meshes.size () && tested_meshes.at ( j )->properties_index == tested_meshes.at ( i )->properties_index ) ++j;
+                const material& _material = * tested_meshes.at ( i )->properties;
+                apply_material ( _material );
+                tester.dispatch ( _material.diffuse_stack.textures, stacks.at ( i ), first_faces.at ( i ), first_faces.at ( j ) - first_faces.at ( i ) );
+            }
+
+            /* wait for every dispatch and read the results */
+            alpha_test_results = tester.get_results ();
+        }
+
+        /* add each face to the opaque and transparent faces of its mesh */
+        for ( unsigned i = 0; i < tested_meshes.size (); ++i ) for ( unsigned j = 0; j < tested_meshes.at ( i )->num_faces; ++j )
+            add_alpha_tested_face ( * tested_meshes.at ( i ), j, alpha_test_results.at ( first_faces.at ( i ) + j ) );
+    }
+
+    /* record the alpha test time */
+    alpha_test_time = std::chrono::duration<double, std::milli> { std::chrono::steady_clock::now () - timestamp_start }.count ();
+}
+
 /* split_mesh
  *
- * split a mesh into opaque and transparent faces
+ * split a mesh into opaque and transparent faces by rasterising it
  * 
  * _mesh: the mesh to split
  */
 void glh::model::model::split_mesh ( mesh& _mesh )
 {
-    /* if mesh is definitely opaque, set the number of opaque faces to be the same as the number of faces
-     * since the index is already zero, this will cause the same vertices to be used by general faces as well as opaque faces
-     */
-    if ( _mesh.definitely_opaque ) _mesh.num_opaque_faces = _mesh.num_faces; else
-
-    /* else if the material has an opacity of less than 1.0, set the number of transparent faces to be the same as the number of faces
-     * since the index is already zero, this will cause the same vertices to be used by general faces as well as transparent faces
-     */
-    if ( _mesh.properties->opacity < 1.0 ) _mesh.num_transparent_faces = _mesh.num_faces; else
-  
-    /* else apply alpha testing on each face */
+    /* apply alpha testing on each face */
     {
         /* get ssbo size
          * there are two faces per byte, hence the division by two, and the size must be a multiple of 32
@@ -676,27 +1022,26 @@ void glh::model::model::split_mesh ( mesh& _mesh )
         alpha_test_fbo.set_default_dimensions ( _mesh.properties->diffuse_stack.stack_width, _mesh.properties->diffuse_stack.stack_height );
         alpha_test_fbo.bind ();
 
-        /* temporarily set diffuse texture stack to not use interpolation */
-        _mesh.properties->diffuse_stack.textures.set_mag_filter ( GL_NEAREST );
-        _mesh.properties->diffuse_stack.textures.set_min_filter ( GL_NEAREST_MIPMAP_NEAREST );
-
         /* use alpha test program */
-        alpha_test_program.use ();
+        alpha_test_program->use ();
 
-        /* cache the material uniform */
-        cache_material_uniforms ( alpha_test_program.get_struct_uniform ( "material" ) );
+        /* cache the material uniform and apply the material */
+        cache_material_uniforms ( alpha_test_program->get_struct_uniform ( "material" ) );
+        apply_material ( * _mesh.properties );
 
-        /* set viewport and disable some settings */
-        core::renderer::disable_multisample ();
-        core::renderer::viewport ( 0, 0, _mesh.properties->diffuse_stack.stack_width, _mesh.properties->diffuse_stack.stack_height );
-        core::renderer::disable_depth_test ();
-        core::renderer::disable_face_culling ();
+        /* sample the diffuse texture stack without interpolation through a cached sampler, rather than changing the parameters of the textures */
+        const unsigned diffuse_unit = _mesh.properties->diffuse_stack.textures.bind_loop ( core::sampler::get_cached ( core::sampler::parameters {}
+            .with_filter ( GL_NEAREST, GL_NEAREST_MIPMAP_NEAREST ).with_wrap ( cast_wrapping ( _mesh.properties->diffuse_stack.wrapping_u ), cast_wrapping ( _mesh.properties->diffuse_stack.wrapping_v ), GL_REPEAT ) ) );
+
+        /* record the current render state, then apply one with the viewport of the texture stack and depth testing, face culling, blending and multisampling disabled */
+        const core::render_state previous_state = core::renderer::get_render_state ();
+        core::renderer::apply ( core::render_state {}.with_multisample ( false ).with_viewport ( 0, 0, _mesh.properties->diffuse_stack.stack_width, _mesh.properties->diffuse_stack.stack_height ) );
         
         /* render the mesh
-         * set the render flags to none
+         * set the render flags to only skip the material, as it is already applied
          * if GLH_CONFIGURE_GLOBAL_VERTEX_ARRAYS is set in import flags, temorarily remove it
          */
-        model_render_flags = render_flags::GLH_NONE;
+        model_render_flags = render_flags::GLH_NO_MATERIAL;
         if ( model_import_flags & import_flags::GLH_CONFIGURE_GLOBAL_VERTEX_ARRAYS )
         {
             model_import_flags &= ~import_flags::GLH_CONFIGURE_GLOBAL_VERTEX_ARRAYS;
@@ -707,56 +1052,291 @@ void glh::model::model::split_mesh ( mesh& _mesh )
         /* wait for the draw command above to finish */
         glh::core::sync::finish_queue ();
 
-        /* set texture stacks to use interpolation again */
-        _mesh.properties->diffuse_stack.textures.set_mag_filter ( GL_LINEAR );
-        _mesh.properties->diffuse_stack.textures.set_min_filter ( GL_LINEAR_MIPMAP_LINEAR );
+        /* restore the previous render state */
+        core::renderer::apply ( previous_state );
+
+        /* remove the sampler, so the diffuse texture stack is interpolated again */
+        core::sampler::unbind_unit ( diffuse_unit );
         
-        /* now loop through the faces... */
-        for ( unsigned i = 0; i < _mesh.num_faces; ++i )
+        /* now add each face by the results of the alpha testing */
+        for ( unsigned i = 0; i < _mesh.num_faces; ++i ) add_alpha_tested_face ( _mesh, i, alpha_test_ssbo.at<unsigned> ( i / 8 ) >> ( ( i % 8 ) * 4 ) );
+    }
+}
+
+/* add_alpha_tested_face
+ *
+ * add a face to the opaque and transparent faces of its mesh, according to the results of alpha testing it
+ *
+ * _mesh: the mesh of the face
+ * i: the index of the face in the mesh
+ * alpha_test_fb: the 4 bits of the results of alpha testing the face
+ */
+void glh::model::model::add_alpha_tested_face ( mesh& _mesh, const unsigned i, const unsigned alpha_test_fb )
+{
+    /* add to opaque mesh set if necessary */
+    if ( is_opaque_alpha_test ( alpha_test_fb ) )
+    {
+        ++_mesh.num_opaque_faces;
+        _mesh.opaque_faces.push_back ( _mesh.faces.at ( i ) );
+    }
+
+    /* add to transparent mesh set if necessary */
+    if ( is_transparent_alpha_test ( alpha_test_fb ) )
+    {
+        ++_mesh.num_transparent_faces;
+        _mesh.transparent_faces.push_back ( _mesh.faces.at ( i ) );
+    }
+}
+
+/* is_opaque/transparent_alpha_test
+ *
+ * find whether the results of alpha testing a face put it in the opaque or transparent faces, taking into account the import flags
+ *
+ * alpha_test_fb: the 4 bits of the results of alpha testing the face
+ */
+bool glh::model::model::is_opaque_alpha_test ( const unsigned alpha_test_fb ) const
+{
+    return ( ~model_import_flags & import_flags::GLH_IGNORE_VCOLOR_WHEN_ALPHA_TESTING && alpha_test_fb & 0x1 ) ||
+           ( ~model_import_flags & import_flags::GLH_IGNORE_TEXTURE_COLOR_WHEN_ALPHA_TESTING && alpha_test_fb & 0x4 );
+}
+bool glh::model::model::is_transparent_alpha_test ( const unsigned alpha_test_fb ) const
+{
+    return ( ~model_import_flags & import_flags::GLH_IGNORE_VCOLOR_WHEN_ALPHA_TESTING && alpha_test_fb & 0x2 ) ||
+           ( ~model_import_flags & import_flags::GLH_IGNORE_TEXTURE_COLOR_WHEN_ALPHA_TESTING && alpha_test_fb & 0x8 );
+}
+
+/* get_alpha_test_faces
+ *
+ * get the face data and diffuse stacks of some meshes for alpha testing
+ *
+ * tested_meshes: the meshes to alpha test
+ * face_data: filled with the face data of every face, with the faces of each mesh following the last
+ * first_faces: filled with the index of the first face of each mesh, followed by the total number of faces
+ * stacks: filled with the diffuse stack of each mesh
+ */
+void glh::model::model::get_alpha_test_faces ( const std::vector<const mesh *>& tested_meshes, std::vector<float>& face_data, std::vector<unsigned>& first_faces, std::vector<alpha_test::stack>& stacks ) const
+{
+    /* write the texcoords of each uv channel and the vertex color alpha of each vertex of each face, recording the index of the first face of each mesh */
+    const unsigned face_stride = alpha_test::get_face_stride ( GLH_MODEL_MAX_TEXTURE_STACK_SIZE );
+    face_data.clear ();
+    first_faces.clear ();
+    stacks.clear ();
+    for ( const mesh * _mesh: tested_meshes )
+    {
+        first_faces.push_back ( face_data.size () / face_stride );
+        for ( const face& _face: _mesh->faces ) for ( const unsigned index: _face.indices )
         {
-            /* get the results of the alpha testing */
-            const unsigned alpha_test_fb = alpha_test_ssbo.at<unsigned> ( i / 8 ) >> ( ( i % 8 ) * 4 );
+            const vertex& _vertex = _mesh->vertices.at ( index );
+            for ( const math::fvec2& texcoords: _vertex.texcoords ) { face_data.push_back ( texcoords.at ( 0 ) ); face_data.push_back ( texcoords.at ( 1 ) ); }
+            face_data.push_back ( _vertex.vcolor.at ( 3 ) );
+        }
 
-            /* add to opaque mesh set if necessary */
-            if ( ( ~model_import_flags & import_flags::GLH_IGNORE_VCOLOR_WHEN_ALPHA_TESTING && alpha_test_fb & 0x1 ) ||
-                 ( ~model_import_flags & import_flags::GLH_IGNORE_TEXTURE_COLOR_WHEN_ALPHA_TESTING && alpha_test_fb & 0x4 ) )
-            {
-                ++_mesh.num_opaque_faces;
-                _mesh.opaque_faces.push_back ( _mesh.faces.at ( i ) );
-            }
+        /* describe the diffuse stack, with each level referring to the image it was uploaded from */
+        const texture_stack& diffuse_stack = _mesh->properties->diffuse_stack;
+        stacks.push_back ( alpha_test::stack
+        {
+            diffuse_stack.base_color.at ( 3 ), diffuse_stack.stack_width, diffuse_stack.stack_height,
+            static_cast<GLenum> ( cast_wrapping ( diffuse_stack.wrapping_u ) ), static_cast<GLenum> ( cast_wrapping ( diffuse_stack.wrapping_v ) ), {}
+        } );
+        for ( unsigned i = 0; i < diffuse_stack.stack_size; ++i ) stacks.back ().levels.push_back ( alpha_test::stack_level
+        {
+            &images.at ( diffuse_stack.levels.at ( i ).image_index ), diffuse_stack.levels.at ( i ).uvwsrc,
+            diffuse_stack.levels.at ( i ).blend_operation, diffuse_stack.levels.at ( i ).blend_strength
+        } );
+    }
+    first_faces.push_back ( face_data.size () / face_stride );
+}
 
-            /* add to transparent mesh set if necessary */
-            if ( ( ~model_import_flags & import_flags::GLH_IGNORE_VCOLOR_WHEN_ALPHA_TESTING && alpha_test_fb & 0x2 ) ||
-                 ( ~model_import_flags & import_flags::GLH_IGNORE_TEXTURE_COLOR_WHEN_ALPHA_TESTING && alpha_test_fb & 0x8 ) )
-             {
-                ++_mesh.num_transparent_faces;
-                _mesh.transparent_faces.push_back ( _mesh.faces.at ( i ) );
-            }
+
+
+/* verify_alpha_test
+ *
+ * alpha test every face again on the cpu, and compare the results to the opaque and transparent faces of each mesh
+ * this checks that the alpha testing used on import (e.g. the compute program) agrees with GLH_ALPHA_TEST_ON_CPU
+ *
+ * return: the number of faces which were classified differently
+ */
+unsigned glh::model::model::verify_alpha_test () const
+{
+    /* if meshes were not split, there is nothing to compare */
+    if ( ~model_import_flags & import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES ) return 0;
+
+    /* find the meshes which were alpha tested, and test them on the cpu */
+    std::vector<const mesh *> tested_meshes;
+    for ( const mesh& _mesh: meshes ) if ( !_mesh.definitely_opaque && _mesh.properties->opacity >= 1.0 ) tested_meshes.push_back ( &_mesh );
+    std::vector<float> face_data;
+    std::vector<unsigned> first_faces;
+    std::vector<alpha_test::stack> stacks;
+    get_alpha_test_faces ( tested_meshes, face_data, first_faces, stacks );
+    std::vector<const alpha_test::stack *> stack_pointers;
+    for ( const alpha_test::stack& _stack: stacks ) stack_pointers.push_back ( &_stack );
+    const std::vector<unsigned> alpha_test_results = alpha_test::test_faces ( face_data, GLH_MODEL_MAX_TEXTURE_STACK_SIZE, first_faces, stack_pointers );
+
+    /* walk the opaque and transparent faces of each mesh, which were added in the order of the faces, and count the faces whose classification differs */
+    unsigned num_differences = 0, k = 0;
+    for ( const mesh * _mesh: tested_meshes )
+    {
+        unsigned opaque_index = 0, transparent_index = 0;
+        for ( unsigned i = 0; i < _mesh->num_faces; ++i, ++k )
+        {
+            const bool opaque = ( opaque_index < _mesh->opaque_faces.size () && _mesh->opaque_faces.at ( opaque_index ).indices == _mesh->faces.at ( i ).indices );
+            const bool transparent = ( transparent_index < _mesh->transparent_faces.size () && _mesh->transparent_faces.at ( transparent_index ).indices == _mesh->faces.at ( i ).indices );
+            if ( opaque ) ++opaque_index;
+            if ( transparent ) ++transparent_index;
+            if ( opaque != is_opaque_alpha_test ( alpha_test_results.at ( k ) ) || transparent != is_transparent_alpha_test ( alpha_test_results.at ( k ) ) ) ++num_differences;
         }
+
+        /* any faces left over were not matched at all */
+        num_differences += ( _mesh->opaque_faces.size () - opaque_index ) + ( _mesh->transparent_faces.size () - transparent_index );
     }
 
-    /* change index buffer to use immutable storage
-     * if both the number of opaque and transparent faces are both either zero or the same as the max number of faces, then simply duplicate the index data from before
-     */
-    if ( ( _mesh.num_opaque_faces == 0 || _mesh.num_opaque_faces == _mesh.num_faces ) && ( _mesh.num_transparent_faces == 0 || _mesh.num_transparent_faces == _mesh.num_faces ) )
-        _mesh.index_data.buffer_storage ( _mesh.faces.begin (), _mesh.faces.end () );
-    else
-    
-    /* otherwise reformat the index data to contain the faces from alpha testing */
+    /* return the number of differences */
+    return num_differences;
+}
+
+
+
+/* generate_lods
+ *
+ * generate the levels of detail of a mesh
+ * this makes no OpenGL calls, so is safe to call from any thread
+ * 
+ * _mesh: the mesh to generate levels of detail for
+ */
+void glh::model::model::generate_lods ( mesh& _mesh ) const
+{
+    /* get the positions and triangles of the mesh */
+    std::vector<math::fvec3> positions;
+    positions.reserve ( _mesh.vertices.size () );
+    for ( const vertex& _vertex: _mesh.vertices ) positions.push_back ( _vertex.position );
+    std::vector<lod::triangle> triangles;
+    triangles.reserve ( _mesh.num_faces );
+    for ( const face& _face: _mesh.faces ) triangles.push_back ( _face.indices );
+
+    /* get the greatest error allowed from the size of the bounding box of the mesh */
+    const std::pair<math::fvec3, math::fvec3> max_min_components = mesh_max_min_components ( _mesh, math::identity<4, float> () );
+    const double max_error = math::modulus ( max_min_components.first - max_min_components.second ) * GLH_MODEL_LOD_MAX_RELATIVE_ERROR;
+
+    /* generate the levels, and add each to the mesh */
+    std::vector<lod::simplification_report> reports;
+    const std::vector<std::vector<lod::triangle>> levels = lod::generate_lods ( positions, triangles, GLH_MODEL_MAX_LODS, GLH_MODEL_LOD_TRIANGLE_RATIO, max_error, &reports );
+    for ( unsigned i = 0; i < levels.size (); ++i )
+    {
+        _mesh.lods.emplace_back ();
+        mesh_lod& _mesh_lod = _mesh.lods.back ();
+        _mesh_lod.num_faces = levels.at ( i ).size ();
+        _mesh_lod.start_of_faces = 0;
+        _mesh_lod.global_start_of_faces = 0;
+        _mesh_lod.faces.resize ( _mesh_lod.num_faces );
+        for ( unsigned j = 0; j < _mesh_lod.num_faces; ++j ) _mesh_lod.faces.at ( j ).indices = levels.at ( i ).at ( j );
+        _mesh_lod.report = reports.at ( i );
+    }
+}
+
+
+
+/* build_meshlets
+ *
+ * build the meshlets of a mesh
+ * this makes no OpenGL calls, so is safe to call from any thread
+ * 
+ * _mesh: the mesh to build meshlets for
+ */
+void glh::model::model::build_meshlets ( mesh& _mesh ) const
+{
+    /* get the positions of the mesh */
+    std::vector<math::fvec3> positions;
+    positions.reserve ( _mesh.vertices.size () );
+    for ( const vertex& _vertex: _mesh.vertices ) positions.push_back ( _vertex.position );
+
+    /* function to get the triangles of a set of faces */
+    auto get_triangles = [] ( const std::vector<face>& faces )
     {
-        /* set the size of the buffer */
-        _mesh.index_data.buffer_storage ( ( _mesh.num_faces + _mesh.num_opaque_faces + _mesh.num_transparent_faces ) * sizeof ( face ) );
+        std::vector<lod::triangle> triangles;
+        triangles.reserve ( faces.size () );
+        for ( const face& _face: faces ) triangles.push_back ( _face.indices );
+        return triangles;
+    };
+
+    /* get the index of the mesh */
+    const unsigned mesh_index = &_mesh - meshes.data ();
+
+    /* if the mesh was split into separate opaque and transparent faces, build meshlets from each of them */
+    if ( has_separate_alpha_faces ( _mesh ) )
+    {
+        meshlet::build ( positions, get_triangles ( _mesh.opaque_faces ), _mesh.meshlets, _mesh.meshlet_vertices, _mesh.meshlet_triangles, meshlet::meshlet_flags::GLH_OPAQUE, mesh_index );
+        meshlet::build ( positions, get_triangles ( _mesh.transparent_faces ), _mesh.meshlets, _mesh.meshlet_vertices, _mesh.meshlet_triangles, meshlet::meshlet_flags::GLH_TRANSPARENT, mesh_index );
+    } else
+    /* else build meshlets from all of the faces, flagged in the same way that render_mesh chooses whether to draw the mesh */
+    {
+        unsigned flags = meshlet::meshlet_flags::GLH_NONE;
+        if ( model_import_flags & import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES )
+        {
+            if ( _mesh.num_opaque_faces == _mesh.num_faces ) flags |= meshlet::meshlet_flags::GLH_OPAQUE;
+            if ( _mesh.num_transparent_faces == _mesh.num_faces ) flags |= meshlet::meshlet_flags::GLH_TRANSPARENT;
+        } else
+        {
+            if ( _mesh.properties->opacity >= 1.0 ) flags |= meshlet::meshlet_flags::GLH_OPAQUE;
+            if ( !_mesh.definitely_opaque ) flags |= meshlet::meshlet_flags::GLH_TRANSPARENT;
+        }
+        meshlet::build ( positions, get_triangles ( _mesh.faces ), _mesh.meshlets, _mesh.meshlet_vertices, _mesh.meshlet_triangles, flags, mesh_index );
+    }
+}
+
+/* has_separate_alpha_faces
+ *
+ * returns true if a mesh has opaque and transparent faces which differ from its faces
+ * 
+ * _mesh: the mesh to check
+ */
+bool glh::model::model::has_separate_alpha_faces ( const mesh& _mesh ) const
+{
+    /* the faces are separate unless the number of opaque and transparent faces are both either zero or the same as the total number of faces */
+    return !( ( _mesh.num_opaque_faces == 0 || _mesh.num_opaque_faces == _mesh.num_faces ) && ( _mesh.num_transparent_faces == 0 || _mesh.num_transparent_faces == _mesh.num_faces ) );
+}
+
+
+
+/* buffer_index_data
+ *
+ * buffer the final index data of a mesh into immutable storage
+ * this contains the faces, followed by the opaque and transparent faces (if distinct from the faces), followed by each level of detail
+ * 
+ * _mesh: the mesh to buffer the index data of
+ */
+void glh::model::model::buffer_index_data ( mesh& _mesh )
+{
+    /* if the opaque and transparent faces are not separate from the faces, then simply reuse the faces for them */
+    const bool separate_faces = has_separate_alpha_faces ( _mesh );
 
-        /* now buffer in the subdata, also setting the offsets for the types of face */
-        _mesh.index_data.buffer_sub_data ( _mesh.faces.begin (), _mesh.faces.end (), 0 );
+    /* set the size of the buffer */
+    unsigned num_indexed_faces = _mesh.num_faces + ( separate_faces ? _mesh.num_opaque_faces + _mesh.num_transparent_faces : 0 );
+    for ( const mesh_lod& _mesh_lod: _mesh.lods ) num_indexed_faces += _mesh_lod.num_faces;
+    _mesh.index_data.buffer_storage ( num_indexed_faces * sizeof ( face ) );
 
-        _mesh.start_of_opaque_faces        = _mesh.num_faces * sizeof ( face );
-        _mesh.global_start_of_opaque_faces = _mesh.num_faces * sizeof ( face );
-        _mesh.index_data.buffer_sub_data ( _mesh.opaque_faces.begin (), _mesh.opaque_faces.end (), _mesh.num_faces );
+    /* now buffer in the subdata, also setting the offsets for the types of face */
+    _mesh.index_data.buffer_sub_data ( _mesh.faces.begin (), _mesh.faces.end (), 0 );
+    unsigned next_face = _mesh.num_faces;
 
-        _mesh.start_of_transparent_faces        = _mesh.start_of_opaque_faces + _mesh.num_opaque_faces * sizeof ( face );     
-        _mesh.global_start_of_transparent_faces = _mesh.start_of_opaque_faces + _mesh.num_opaque_faces * sizeof ( face );
-        _mesh.index_data.buffer_sub_data ( _mesh.transparent_faces.begin (), _mesh.transparent_faces.end (), _mesh.num_faces + _mesh.num_opaque_faces );  
+    if ( separate_faces )
+    {
+        _mesh.start_of_opaque_faces        = next_face * sizeof ( face );
+        _mesh.global_start_of_opaque_faces = next_face * sizeof ( face );
+        _mesh.index_data.buffer_sub_data ( _mesh.opaque_faces.begin (), _mesh.opaque_faces.end (), next_face );
+        next_face += _mesh.num_opaque_faces;
+
+        _mesh.start_of_transparent_faces        = next_face * sizeof ( face );
+        _mesh.global_start_of_transparent_faces = next_face * sizeof ( face );
+        _mesh.index_data.buffer_sub_data ( _mesh.transparent_faces.begin (), _mesh.transparent_faces.end (), next_face );
+        next_face += _mesh.num_transparent_faces;
+    }
+
+    for ( mesh_lod& _mesh_lod: _mesh.lods )
+    {
+        _mesh_lod.start_of_faces        = next_face * sizeof ( face );
+        _mesh_lod.global_start_of_faces = next_face * sizeof ( face );
+        _mesh.index_data.buffer_sub_data ( _mesh_lod.faces.begin (), _mesh_lod.faces.end (), next_face );
+        next_face += _mesh_lod.num_faces;
     }
 }
 
@@ -778,6 +1358,7 @@ void glh::model::model::configure_global_vertex_arrays ()
         _mesh.global_start_of_faces             += global_index_data_size;
         _mesh.global_start_of_opaque_faces      += global_index_data_size;
         _mesh.global_start_of_transparent_faces += global_index_data_size;
+        for ( mesh_lod& _mesh_lod: _mesh.lods ) _mesh_lod.global_start_of_faces += global_index_data_size;
         global_vertex_data_size += _mesh.vertex_data.get_size ();
         global_index_data_size  += _mesh.index_data.get_size ();
     }
@@ -831,11 +1412,68 @@ void glh::model::model::configure_global_vertex_arrays ()
     global_vertex_arrays.set_vertex_attrib ( 3, global_vertex_data, 4, GL_FLOAT, GL_FALSE, sizeof ( vertex ), 9 * sizeof ( GLfloat ) );
     for ( unsigned i = 0; i < GLH_MODEL_MAX_TEXTURE_STACK_SIZE; ++i )
         global_vertex_arrays.set_vertex_attrib ( 4 + i, global_vertex_data, 2, GL_FLOAT, GL_FALSE, sizeof ( vertex ), ( 13 + i * 2 ) * sizeof ( GLfloat ) );
+    configure_instance_attribs ( global_vertex_arrays );
     global_vertex_arrays.bind_ebo ( global_index_data );
 }
 
 
 
+/* configure_meshlet_buffers
+ *
+ * combine the meshlets of every mesh into the global meshlet buffers
+ * the global vertex arrays must already be configured
+ */
+void glh::model::model::configure_meshlet_buffers ()
+{
+    /* combine the meshlets, offsetting the ranges of each mesh by the sizes of the meshes before it
+     * the vertex indices are also offset by the number of vertices before the mesh, so that they index the global vertex data
+     */
+    std::vector<meshlet::meshlet> global_meshlets;
+    std::vector<unsigned> global_meshlet_vertices;
+    std::vector<unsigned> global_meshlet_triangles;
+    unsigned global_vertex_offset = 0;
+    for ( mesh& _mesh: meshes )
+    {
+        _mesh.global_start_of_meshlets = global_meshlets.size ();
+        for ( meshlet::meshlet _meshlet: _mesh.meshlets )
+        {
+            _meshlet.vertex_offset += global_meshlet_vertices.size ();
+            _meshlet.triangle_offset += global_meshlet_triangles.size ();
+            global_meshlets.push_back ( _meshlet );
+        }
+        for ( const unsigned index: _mesh.meshlet_vertices ) global_meshlet_vertices.push_back ( index + global_vertex_offset );
+        global_meshlet_triangles.insert ( global_meshlet_triangles.end (), _mesh.meshlet_triangles.begin (), _mesh.meshlet_triangles.end () );
+        global_vertex_offset += _mesh.num_vertices;
+    }
+    num_meshlets = global_meshlets.size ();
+
+    /* buffer the meshlet data, if there are any meshlets */
+    if ( num_meshlets == 0 ) return;
+    meshlet_data.buffer_storage ( global_meshlets.begin (), global_meshlets.end () );
+    meshlet_vertex_data.buffer_storage ( global_meshlet_vertices.begin (), global_meshlet_vertices.end () );
+    meshlet_triangle_data.buffer_storage ( global_meshlet_triangles.begin (), global_meshlet_triangles.end () );
+}
+
+
+
+/* configure_instance_attribs
+ *
+ * configure the instance matrix attributes of a vao to source from the instance data
+ * 
+ * _vertex_arrays: the vao to configure
+ */
+void glh::model::model::configure_instance_attribs ( core::vao& _vertex_arrays )
+{
+    /* each column of the instance matrix is a separate attribute, which advances once per instance */
+    for ( unsigned i = 0; i < 4; ++i )
+    {
+        _vertex_arrays.set_vertex_attrib ( 4 + GLH_MODEL_MAX_TEXTURE_STACK_SIZE + i, instance_data, 4, GL_FLOAT, GL_FALSE, sizeof ( math::fmat4 ), i * 4 * sizeof ( GLfloat ) );
+        _vertex_arrays.set_vertex_attrib_divisor ( 4 + GLH_MODEL_MAX_TEXTURE_STACK_SIZE + i, 1 );
+    }
+}
+
+
+
 /* add_node
  *
  * recursively add nodes to the node tree
@@ -1083,6 +1721,40 @@ void glh::model::model::configure_node_region ( node& _node )
 
 
 
+/* render_root
+ *
+ * render the root node, binding the global vertex arrays if configured
+ * the render flags and instance count must already be set
+ * 
+ * transform: the overall model transformation
+ */
+void glh::model::model::render_root ( const math::mat4& transform ) const
+{
+    /* record whether face culling is enabled, so that render_mesh only disables it for two sided materials */
+    model_face_culling = core::renderer::face_culling_enabled ();
+
+    /* if imported with global vertex arrays configured... */
+    if ( model_import_flags & import_flags::GLH_CONFIGURE_GLOBAL_VERTEX_ARRAYS )
+    {
+        /* bind global vertex arrays */
+        global_vertex_arrays.bind ();
+
+        /* render the root node */
+        render_node ( root_node, transform );
+
+        /* only unbind if GLH_LEAVE_GLOBAL_VERTEX_ARRAYS_BOUND is unset */
+        if ( ~model_render_flags & render_flags::GLH_LEAVE_GLOBAL_VERTEX_ARRAYS_BOUND ) global_vertex_arrays.unbind ();
+    } 
+    /* else just render root node normally */
+    else render_node ( root_node, transform );
+
+    /* restore face culling, in case the last mesh rendered was two sided */
+    if ( model_face_culling ) core::renderer::enable_face_culling ();
+    model_face_culling = false;
+}
+
+
+
 /* render_node
  *
  * render a node and all of its children
@@ -1102,8 +1774,18 @@ void glh::model::model::render_node ( const node& _node, const math::fmat4& tran
     if ( ~model_render_flags & render_flags::GLH_NO_MODEL_MATRIX ) 
         cached_model_matrix_uniform->model_matrix_uni.set_matrix ( trans );
 
-    /* render meshes */
-    for ( const mesh * _mesh: _node.meshes ) render_mesh ( * _mesh );
+    /* render meshes, skipping those which are outside of the frustum or occluded if culling */
+    for ( const mesh * _mesh: _node.meshes ) 
+    {
+        if ( model_render_flags & ( render_flags::GLH_FRUSTUM_CULLING | render_flags::GLH_OCCLUSION_CULLING ) )
+        {
+            const region::spherical_region<> _mesh_region = trans * _mesh->mesh_region;
+            if ( model_render_flags & render_flags::GLH_FRUSTUM_CULLING && culling_frustum->is_culled ( _mesh_region ) ) continue;
+            if ( model_render_flags & render_flags::GLH_OCCLUSION_CULLING && occlusion_pyramid->is_occluded ( _mesh_region ) ) continue;
+        }
+        render_mesh ( * _mesh, ( model_render_flags & render_flags::GLH_LOD_SELECTION ?
+            lod::select_lod ( lod::projected_size ( trans * _mesh->mesh_region, lod_camera->get_position (), lod_camera->get_fov () ), lod_threshold, _mesh->lods.size () ) : 0 ) );
+    }
 }
 
 
@@ -1114,49 +1796,196 @@ void glh::model::model::render_node ( const node& _node, const math::fmat4& tran
  * 
  * _mesh: the mesh to render
  */
-void glh::model::model::render_mesh ( const mesh& _mesh ) const
+void glh::model::model::render_mesh ( const mesh& _mesh, const unsigned level ) const
+{
+    /* find the range of indices to draw, returning if there is nothing to draw */
+    GLsizei count;
+    GLsizeiptr start_index;
+    if ( !mesh_draw_range ( _mesh, model_render_flags, level, count, start_index ) ) return;
+
+    /* if face culling was on when rendering began, disable it only for two sided materials
+     * it is not restored after the mesh, so consecutive meshes with the same sidedness do not toggle it
+     */
+    if ( model_face_culling )
+    {
+        if ( _mesh.properties->two_sided ) core::renderer::disable_face_culling ();
+        else core::renderer::enable_face_culling ();
+    }
+
+    /* apply the material, if not disabled in flags */
+    if ( ~model_render_flags & render_flags::GLH_NO_MATERIAL ) apply_material ( * _mesh.properties, model_render_flags );
+
+    /* draw elements */
+    if ( model_import_flags & import_flags::GLH_CONFIGURE_GLOBAL_VERTEX_ARRAYS )
+        core::renderer::draw_elements ( GL_TRIANGLES, count, GL_UNSIGNED_INT, start_index, model_render_instances, model_render_base_instance );
+    else
+    {
+        _mesh.vertex_arrays.bind ();
+        core::renderer::draw_elements ( GL_TRIANGLES, count, GL_UNSIGNED_INT, start_index, model_render_instances, model_render_base_instance );
+        _mesh.vertex_arrays.unbind ();
+    }
+}
+
+/* mesh_draw_range
+ *
+ * find the range of indices of a mesh to draw with a set of rendering flags
+ * 
+ * _mesh: the mesh to draw
+ * flags: the rendering flags to draw with
+ * level: the level of detail to draw
+ * count: set to the number of indices to draw
+ * start_index: set to the first index to draw, in the global element buffer if global vertex arrays are configured
+ * 
+ * return: false if there is nothing to draw
+ */
+bool glh::model::model::mesh_draw_range ( const mesh& _mesh, const unsigned flags, const unsigned level, GLsizei& count, GLsizeiptr& start_index ) const
 {
     /* don't draw if contains no faces */
     if ( model_import_flags & import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES )
     {
-        if ( model_render_flags & render_flags::GLH_OPAQUE_MODE      ) { if ( _mesh.num_opaque_faces      == 0 ) return; } else
-        if ( model_render_flags & render_flags::GLH_TRANSPARENT_MODE ) { if ( _mesh.num_transparent_faces == 0 ) return; } else
-        if ( _mesh.num_faces == 0 ) return;
+        if ( flags & render_flags::GLH_OPAQUE_MODE      ) { if ( _mesh.num_opaque_faces      == 0 ) return false; } else
+        if ( flags & render_flags::GLH_TRANSPARENT_MODE ) { if ( _mesh.num_transparent_faces == 0 ) return false; } else
+        if ( _mesh.num_faces == 0 ) return false;
     } else 
     {
-        if ( model_render_flags & render_flags::GLH_OPAQUE_MODE      ) { if ( _mesh.properties->opacity < 1.0 ) return; } else
-        if ( model_render_flags & render_flags::GLH_TRANSPARENT_MODE ) { if ( _mesh.definitely_opaque         ) return; }
-        if ( _mesh.num_faces == 0 ) return;
+        if ( flags & render_flags::GLH_OPAQUE_MODE      ) { if ( _mesh.properties->opacity < 1.0 ) return false; } else
+        if ( flags & render_flags::GLH_TRANSPARENT_MODE ) { if ( _mesh.definitely_opaque         ) return false; }
+        if ( _mesh.num_faces == 0 ) return false;
     }
 
-    /* if face culling is on and material is two sided, disable face culling */
-    const bool culling_active = core::renderer::face_culling_enabled ();
-    if ( culling_active && _mesh.properties->two_sided ) core::renderer::disable_face_culling ();
+    /* levels of detail replace the full set of faces, so cannot be used if only a subset of the faces would be drawn */
+    const bool use_lod = level > 0 && !( model_import_flags & import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES && 
+        ( ( flags & render_flags::GLH_OPAQUE_MODE && _mesh.num_opaque_faces != _mesh.num_faces ) || ( flags & render_flags::GLH_TRANSPARENT_MODE && _mesh.num_transparent_faces != _mesh.num_faces ) ) );
 
-    /* apply the material, if not disabled in flags */
-    if ( ~model_render_flags & render_flags::GLH_NO_MATERIAL ) apply_material ( * _mesh.properties );
+    /* whether the indices are found in the global element buffer */
+    const bool global = model_import_flags & import_flags::GLH_CONFIGURE_GLOBAL_VERTEX_ARRAYS;
 
-    /* draw elements */
-    if ( model_import_flags & import_flags::GLH_CONFIGURE_GLOBAL_VERTEX_ARRAYS )
+    /* set the range */
+    if ( use_lod )
     {
-        if ( model_import_flags & import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES && model_render_flags & render_flags::GLH_OPAQUE_MODE ) 
-            core::renderer::draw_elements ( GL_TRIANGLES, _mesh.num_opaque_faces * 3, GL_UNSIGNED_INT, _mesh.global_start_of_opaque_faces ); else
-        if ( model_import_flags & import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES && model_render_flags & render_flags::GLH_TRANSPARENT_MODE ) 
-            core::renderer::draw_elements ( GL_TRIANGLES, _mesh.num_transparent_faces * 3, GL_UNSIGNED_INT, _mesh.global_start_of_transparent_faces );
-        else core::renderer::draw_elements ( GL_TRIANGLES, _mesh.num_faces * 3, GL_UNSIGNED_INT, _mesh.global_start_of_faces );
+        count = _mesh.lods.at ( level - 1 ).num_faces * 3;
+        start_index = ( global ? _mesh.lods.at ( level - 1 ).global_start_of_faces : _mesh.lods.at ( level - 1 ).start_of_faces );
     } else
+    if ( model_import_flags & import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES && flags & render_flags::GLH_OPAQUE_MODE ) 
     {
-        _mesh.vertex_arrays.bind ();
-        if ( model_import_flags & import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES && model_render_flags & render_flags::GLH_OPAQUE_MODE ) 
-            core::renderer::draw_elements ( GL_TRIANGLES, _mesh.num_opaque_faces * 3, GL_UNSIGNED_INT, _mesh.start_of_opaque_faces ); else
-        if ( model_import_flags & import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES && model_render_flags & render_flags::GLH_TRANSPARENT_MODE ) 
-            core::renderer::draw_elements ( GL_TRIANGLES, _mesh.num_transparent_faces * 3, GL_UNSIGNED_INT, _mesh.start_of_transparent_faces );
-        else core::renderer::draw_elements ( GL_TRIANGLES, _mesh.num_faces * 3, GL_UNSIGNED_INT, _mesh.start_of_faces );
-        _mesh.vertex_arrays.unbind ();
+        count = _mesh.num_opaque_faces * 3;
+        start_index = ( global ? _mesh.global_start_of_opaque_faces : _mesh.start_of_opaque_faces );
+    } else
+    if ( model_import_flags & import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES && flags & render_flags::GLH_TRANSPARENT_MODE ) 
+    {
+        count = _mesh.num_transparent_faces * 3;
+        start_index = ( global ? _mesh.global_start_of_transparent_faces : _mesh.start_of_transparent_faces );
+    } else
+    {
+        count = _mesh.num_faces * 3;
+        start_index = ( global ? _mesh.global_start_of_faces : _mesh.start_of_faces );
     }
 
-    /* re-enable face culling if was previously disabled */
-    if ( culling_active ) core::renderer::enable_face_culling ();
+    /* there is something to draw */
+    return true;
+}
+
+
+
+/* record_node
+ *
+ * record a node and all of its children into a render queue
+ * 
+ * queue: the render queue to record into
+ * state: the render state to record one sided meshes with
+ * two_sided_state: the render state to record two sided meshes with
+ * prog: the program to record the meshes with
+ * _node: the node to record
+ * transform: the current model transformation from all the previous nodes
+ * flags: rendering flags
+ */
+void glh::model::model::record_node ( core::render_queue& queue, const core::render_state& state, const core::render_state& two_sided_state, const core::program& prog, const node& _node, const math::fmat4& transform, const unsigned flags ) const
+{
+    /* create transformation matrix */
+    math::fmat4 trans = transform * _node.transform;
+
+    /* first record the child nodes */
+    for ( const node& child: _node.children ) record_node ( queue, state, two_sided_state, prog, child, trans, flags );
+
+    /* record meshes, skipping those which are outside of the frustum or occluded if culling */
+    for ( const mesh * _mesh: _node.meshes ) 
+    {
+        /* find the region of the mesh, if configured */
+        const region::spherical_region<> _mesh_region = trans * _mesh->mesh_region;
+        if ( flags & render_flags::GLH_FRUSTUM_CULLING && culling_frustum->is_culled ( _mesh_region ) ) continue;
+        if ( flags & render_flags::GLH_OCCLUSION_CULLING && occlusion_pyramid->is_occluded ( _mesh_region ) ) continue;
+
+        /* find the range of indices to draw, skipping the mesh if there is nothing to draw */
+        const unsigned level = ( flags & render_flags::GLH_LOD_SELECTION ?
+            lod::select_lod ( lod::projected_size ( _mesh_region, lod_camera->get_position (), lod_camera->get_fov () ), lod_threshold, _mesh->lods.size () ) : 0 );
+        core::draw_packet packet;
+        if ( !mesh_draw_range ( * _mesh, flags, level, packet.count, packet.start_index ) ) continue;
+
+        /* fill in the rest of the packet and record it */
+        packet.prog = &prog;
+        packet.vertex_arrays = ( model_import_flags & import_flags::GLH_CONFIGURE_GLOBAL_VERTEX_ARRAYS ? &global_vertex_arrays : &_mesh->vertex_arrays );
+        packet.material = _mesh->properties;
+        packet.depth = math::modulus ( _mesh_region.centre - queue.get_view_position () );
+        packet.mode = GL_TRIANGLES;
+        packet.type = GL_UNSIGNED_INT;
+        packet.source = this;
+        packet.source_data = _mesh;
+        packet.transform = trans;
+        packet.source_flags = flags;
+        queue.record ( ( _mesh->properties->two_sided ? two_sided_state : state ), packet );
+    }
+}
+
+
+
+/* cull_node_meshlets
+ *
+ * cull the meshlets of a node and all of its children
+ * 
+ * _node: the node to cull the meshlets of
+ * transform: the current model transformation from all the previous nodes
+ * viewpos: the position of the viewer
+ * flags: rendering flags
+ * visible: the array to append the global indices of visible meshlets to
+ */
+void glh::model::model::cull_node_meshlets ( const node& _node, const math::fmat4& transform, const math::vec3& viewpos, const unsigned flags, std::vector<unsigned>& visible ) const
+{
+    /* create transformation matrix */
+    math::fmat4 trans = transform * _node.transform;
+
+    /* first cull the child nodes */
+    for ( const node& child: _node.children ) cull_node_meshlets ( child, trans, viewpos, flags, visible );
+
+    /* if there are no meshes, there is nothing more to do */
+    if ( _node.meshes.empty () ) return;
+
+    /* the normal cones are in model space, so transform the viewer into model space for the backface test */
+    const math::vec3 model_viewpos { math::inverse ( math::mat4 { trans } ) * math::vec4 { viewpos, 1.0 } };
+
+    /* cull the meshlets of each mesh */
+    for ( const mesh * _mesh: _node.meshes ) for ( unsigned i = 0; i < _mesh->meshlets.size (); ++i )
+    {
+        const meshlet::meshlet& _meshlet = _mesh->meshlets.at ( i );
+
+        /* skip meshlets which would not be rendered in the current mode */
+        if ( flags & render_flags::GLH_OPAQUE_MODE && ~_meshlet.flags & meshlet::meshlet_flags::GLH_OPAQUE ) continue;
+        if ( flags & render_flags::GLH_TRANSPARENT_MODE && ~_meshlet.flags & meshlet::meshlet_flags::GLH_TRANSPARENT ) continue;
+
+        /* test the meshlet, backface culling first since it is the cheapest test
+         * two sided materials are never backface culled
+         */
+        ++meshlet_statistics.num_tested;
+        if ( !_mesh->properties->two_sided && meshlet::is_backfacing ( _meshlet, model_viewpos ) ) { ++meshlet_statistics.num_backface_culled; continue; }
+        if ( flags & ( render_flags::GLH_FRUSTUM_CULLING | render_flags::GLH_OCCLUSION_CULLING ) )
+        {
+            const region::spherical_region<> _meshlet_region = trans * meshlet::meshlet_region ( _meshlet );
+            if ( flags & render_flags::GLH_FRUSTUM_CULLING && culling_frustum->is_culled ( _meshlet_region ) ) { ++meshlet_statistics.num_frustum_culled; continue; }
+            if ( flags & render_flags::GLH_OCCLUSION_CULLING && occlusion_pyramid->is_occluded ( _meshlet_region ) ) { ++meshlet_statistics.num_occlusion_culled; continue; }
+        }
+
+        /* the meshlet is visible */
+        visible.push_back ( _mesh->global_start_of_meshlets + i );
+    }
 }
 
 
@@ -1166,39 +1995,47 @@ void glh::model::model::render_mesh ( const mesh& _mesh ) const
  * apply material uniforms during mesh rendering
  * 
  * _material: the material to apply
+ * flags: the render flags, of which only GLH_UNIFORM_NAME_LOOKUP is used (none by default)
  */
-void glh::model::model::apply_material ( const material& _material ) const
+void glh::model::model::apply_material ( const material& _material, const unsigned flags ) const
 {
+    /* bind the textures of all of the stacks at once */
+    const std::vector<unsigned> units = core::texture_base::bind_loop 
+    ( { 
+        &_material.ambient_stack.textures, &_material.diffuse_stack.textures, &_material.specular_stack.textures, 
+        &_material.emission_stack.textures, &_material.normal_stack.textures 
+    } );
+
     /* apply the texture stacks */
     apply_texture_stack 
     ( 
-        _material.ambient_stack, 
+        _material.ambient_stack, units.at ( 0 ),
         cached_material_uniforms->ambient_stack_size_uni, cached_material_uniforms->ambient_stack_base_color_uni,
-        cached_material_uniforms->ambient_stack_levels_uni, cached_material_uniforms->ambient_stack_textures_uni 
+        cached_material_uniforms->ambient_stack_levels_uni, cached_material_uniforms->ambient_stack_textures_uni, flags
     );
     apply_texture_stack 
     ( 
-        _material.diffuse_stack,
+        _material.diffuse_stack, units.at ( 1 ),
         cached_material_uniforms->diffuse_stack_size_uni, cached_material_uniforms->diffuse_stack_base_color_uni,
-        cached_material_uniforms->diffuse_stack_levels_uni,cached_material_uniforms->diffuse_stack_textures_uni 
+        cached_material_uniforms->diffuse_stack_levels_uni,cached_material_uniforms->diffuse_stack_textures_uni, flags
     );
     apply_texture_stack 
     ( 
-        _material.specular_stack, 
+        _material.specular_stack, units.at ( 2 ),
         cached_material_uniforms->specular_stack_size_uni, cached_material_uniforms->specular_stack_base_color_uni,
-        cached_material_uniforms->specular_stack_levels_uni, cached_material_uniforms->specular_stack_textures_uni 
+        cached_material_uniforms->specular_stack_levels_uni, cached_material_uniforms->specular_stack_textures_uni, flags
     );
     apply_texture_stack
     ( 
-        _material.emission_stack, 
+        _material.emission_stack, units.at ( 3 ),
         cached_material_uniforms->emission_stack_size_uni, cached_material_uniforms->emission_stack_base_color_uni,
-        cached_material_uniforms->emission_stack_levels_uni, cached_material_uniforms->emission_stack_textures_uni 
+        cached_material_uniforms->emission_stack_levels_uni, cached_material_uniforms->emission_stack_textures_uni, flags
     );
     apply_texture_stack 
     ( 
-        _material.normal_stack, 
+        _material.normal_stack, units.at ( 4 ),
         cached_material_uniforms->normal_stack_size_uni, cached_material_uniforms->normal_stack_base_color_uni,
-        cached_material_uniforms->normal_stack_levels_uni, cached_material_uniforms->normal_stack_textures_uni 
+        cached_material_uniforms->normal_stack_levels_uni, cached_material_uniforms->normal_stack_textures_uni, flags
     );
 
     /* set blending mode */
@@ -1223,12 +2060,13 @@ void glh::model::model::apply_material ( const material& _material ) const
  * 
  * _texture_stack: the texture stack to apply
  * stack_size/base_color/levels/textures_uni: cached stack uniforms
+ * flags: the render flags, of which only GLH_UNIFORM_NAME_LOOKUP is used
  */
 void glh::model::model::apply_texture_stack 
 ( 
-    const texture_stack& _texture_stack, 
+    const texture_stack& _texture_stack, const unsigned textures_unit,
     core::uniform& stack_size_uni, core::uniform& stack_base_color_uni,
-    core::struct_array_uniform& stack_levels_uni, core::uniform& stack_textures_uni 
+    core::struct_array_uniform& stack_levels_uni, core::uniform& stack_textures_uni, const unsigned flags
 ) const
 {
     /* set the base color */
@@ -1237,15 +2075,24 @@ void glh::model::model::apply_texture_stack
     /* set the stack size */
     stack_size_uni.set_int ( _texture_stack.stack_size );
 
-    /* bind the texture array */
-    stack_textures_uni.set_int ( _texture_stack.textures.bind_loop () );
+    /* set the unit of the texture array */
+    stack_textures_uni.set_int ( textures_unit );
 
-    /* set up each level of the texture stack */
-    for ( unsigned i = 0; i < _texture_stack.stack_size; ++i ) 
+    /* set up each level of the texture stack
+     * the members are looked up by hashed id, as this runs for every mesh drawn, unless looking up by name is requested for benchmarking
+     */
+    using namespace core::literals;
+    if ( flags & render_flags::GLH_UNIFORM_NAME_LOOKUP ) for ( unsigned i = 0; i < _texture_stack.stack_size; ++i )
     {
-        /* set uniforms for each stack level */
+        /* set uniforms for each stack level by name */
         stack_levels_uni.at ( i ).get_uniform ( "blend_operation" ).set_int ( _texture_stack.levels.at ( i ).blend_operation );
         stack_levels_uni.at ( i ).get_uniform ( "blend_strength" ).set_float ( _texture_stack.levels.at ( i ).blend_strength );
         stack_levels_uni.at ( i ).get_uniform ( "uvwsrc" ).set_int ( _texture_stack.levels.at ( i ).uvwsrc );
+    } else for ( unsigned i = 0; i < _texture_stack.stack_size; ++i )
+    {
+        /* set uniforms for each stack level by hashed id */
+        stack_levels_uni.at ( i ).get_uniform ( "blend_operation"_uid ).set_int ( _texture_stack.levels.at ( i ).blend_operation );
+        stack_levels_uni.at ( i ).get_uniform ( "blend_strength"_uid ).set_float ( _texture_stack.levels.at ( i ).blend_strength );
+        stack_levels_uni.at ( i ).get_uniform ( "uvwsrc"_uid ).set_int ( _texture_stack.levels.at ( i ).uvwsrc );
     }
 }
\ No newline at end of file
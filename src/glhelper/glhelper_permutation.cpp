@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * src/glhelper/glhelper_permutation.cpp
+ *
+ * implementation of include/glhelper/glhelper_permutation.hpp
+ *
+ */
+
+
+
+/* INCLUDES */
+
+/* include glhelper_permutation.hpp */
+#include <glhelper/glhelper_permutation.hpp>
+
+
+
+/* PROGRAM_PERMUTATIONS IMPLEMENTATION */
+
+/* full constructor
+ *
+ * describe the program and its features, without building any variants
+ *
+ * _vshader_paths/_gshader_paths/_fshader_paths: the source files of each shader, where no geometry shader paths means no geometry shader
+ * _features: the features of the program, in the order their values are given to make_key
+ * _defines: source to insert into every variant before the feature defines (e.g. the maxima of the library) (defaults to none)
+ */
+glh::core::program_permutations::program_permutations ( const std::vector<std::string>& _vshader_paths, const std::vector<std::string>& _gshader_paths, const std::vector<std::string>& _fshader_paths,
+    const std::vector<permutation_feature>& _features, const std::string& _defines )
+    : vshader_paths { _vshader_paths }
+    , gshader_paths { _gshader_paths }
+    , fshader_paths { _fshader_paths }
+    , features { _features }
+    , defines { _defines }
+    , num_builds { 0 }
+    , num_lookups { 0 }
+    , build_time { 0.0 }
+    , lookup_time { 0.0 }
+{
+    /* give each feature just enough bits to hold its maximum */
+    unsigned shift = 0;
+    for ( const permutation_feature& feature: features )
+    {
+        /* throw if a flag has a maximum other than 1 */
+        if ( feature.flag && feature.max_value != 1 ) throw exception::permutation_exception { "flag permutation feature with name " + feature.name + " has a maximum other than 1" };
+
+        /* find the bits needed */
+        unsigned bits = 0;
+        while ( bits < 32 && ( feature.max_value >> bits ) != 0 ) ++bits;
+
+        /* throw if the key is full */
+        if ( shift + bits > 64 ) throw exception::permutation_exception { "permutation features do not fit in a 64-bit key" };
+
+        /* record the shift */
+        shifts.push_back ( shift );
+        shift += bits;
+    }
+}
+
+
+
+/* make_key
+ *
+ * pack the values of the features into a key
+ *
+ * values: the value of each feature, in the order the features were given to the constructor
+ *
+ * return: the key of the variant
+ */
+std::uint64_t glh::core::program_permutations::make_key ( const std::vector<unsigned>& values ) const
+{
+    /* throw if the number of values is wrong */
+    if ( values.size () != features.size () ) throw exception::permutation_exception { "attempted to make permutation key with " + std::to_string ( values.size () ) + " values for " + std::to_string ( features.size () ) + " features" };
+
+    /* pack each value, throwing if it is too large */
+    std::uint64_t key = 0;
+    for ( unsigned i = 0; i < features.size (); ++i )
+    {
+        if ( values.at ( i ) > features.at ( i ).max_value )
+            throw exception::permutation_exception { "permutation feature with name " + features.at ( i ).name + " given value " + std::to_string ( values.at ( i ) ) + " greater than its maximum of " + std::to_string ( features.at ( i ).max_value ) };
+        key |= std::uint64_t { values.at ( i ) } << shifts.at ( i );
+    }
+
+    /* return the key */
+    return key;
+}
+
+/* get_defines
+ *
+ * get the source inserted into the shaders of a variant, including the shared defines
+ *
+ * key: the key of the variant
+ */
+std::string glh::core::program_permutations::get_defines ( const std::uint64_t key ) const
+{
+    /* start with the shared defines */
+    std::string variant_defines = defines;
+
+    /* add each feature, skipping flags which are not set */
+    for ( unsigned i = 0; i < features.size (); ++i )
+    {
+        const unsigned value = feature_value ( key, i );
+        if ( features.at ( i ).flag ) { if ( value ) variant_defines += "#define " + features.at ( i ).name + "\n"; }
+        else variant_defines += "#define " + features.at ( i ).name + " " + std::to_string ( value ) + "\n";
+    }
+
+    /* return the defines */
+    return variant_defines;
+}
+
+/* get
+ *
+ * get the variant for a key, building it if it has not been built before
+ *
+ * key: the key of the variant
+ *
+ * return: the variant, which stays valid for the lifetime of this object
+ */
+glh::core::program& glh::core::program_permutations::get ( const std::uint64_t key )
+{
+    /* record the lookup, and time it */
+    ++num_lookups;
+    const auto start = std::chrono::steady_clock::now ();
+
+    /* return the variant if it has already been built */
+    const auto it = variants.find ( key );
+    if ( it != variants.end () )
+    {
+        lookup_time += std::chrono::duration<double, std::milli> ( std::chrono::steady_clock::now () - start ).count ();
+        return *it->second;
+    }
+
+    /* otherwise build the variant through the registry and prepare it */
+    std::shared_ptr<program> variant = program_registry::get ( vshader_paths, gshader_paths, fshader_paths, get_defines ( key ) );
+    if ( build_callback ) build_callback ( *variant );
+    variants.emplace ( key, variant );
+
+    /* record the build */
+    ++num_builds;
+    build_time += std::chrono::duration<double, std::milli> ( std::chrono::steady_clock::now () - start ).count ();
+
+    /* return the variant */
+    return *variant;
+}
+
+
+
+/* reset_statistics
+ *
+ * reset the build and lookup counts and times
+ */
+void glh::core::program_permutations::reset_statistics ()
+{
+    /* reset the counts and times */
+    num_builds = 0;
+    num_lookups = 0;
+    build_time = 0.0;
+    lookup_time = 0.0;
+}
+
+
+
+/* feature_value
+ *
+ * extract the value of a feature from a key
+ *
+ * key: the key to extract from
+ * index: the index of the feature
+ */
+unsigned glh::core::program_permutations::feature_value ( const std::uint64_t key, const unsigned index ) const
+{
+    /* the bits of the feature end where the next feature starts, or at the end of the key */
+    const unsigned end = ( index + 1 < shifts.size () ? shifts.at ( index + 1 ) : 64 );
+    const std::uint64_t mask = ( end - shifts.at ( index ) >= 64 ? ~std::uint64_t { 0 } : ( std::uint64_t { 1 } << ( end - shifts.at ( index ) ) ) - 1 );
+    return ( key >> shifts.at ( index ) ) & mask;
+}
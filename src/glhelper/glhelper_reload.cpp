@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * src/glhelper/glhelper_reload.cpp
+ *
+ * implementation of include/glhelper/glhelper_reload.hpp
+ *
+ */
+
+
+
+/* INCLUDES */
+
+/* include glhelper_reload.hpp */
+#include <glhelper/glhelper_reload.hpp>
+
+
+
+/* SHADER_RELOADER IMPLEMENTATION */
+
+/* zero-parameter constructor
+ *
+ * initialise inotify, watching no programs
+ */
+glh::core::shader_reloader::shader_reloader ()
+    : inotify_fd { inotify_init1 ( IN_NONBLOCK | IN_CLOEXEC ) }
+    , num_reloads { 0 }
+    , num_failed_reloads { 0 }
+    , last_reload_time { 0.0 }
+{
+    /* throw if inotify could not be initialised */
+    if ( inotify_fd < 0 ) throw exception::reload_exception { "failed to initialise inotify" };
+}
+
+/* destructor */
+glh::core::shader_reloader::~shader_reloader ()
+{
+    /* close inotify, which removes every watch */
+    close ( inotify_fd );
+}
+
+
+
+/* add
+ *
+ * watch the files of the shaders of a program, reloading the program when any of them change
+ * the program must outlive the reloader, or be removed first
+ *
+ * prog: the program to add
+ */
+void glh::core::shader_reloader::add ( program& prog )
+{
+    /* add the program if not already added, and watch its files */
+    if ( std::find ( programs.begin (), programs.end (), &prog ) != programs.end () ) return;
+    programs.push_back ( &prog );
+    watch_program ( prog );
+}
+
+/* remove
+ *
+ * stop reloading a program, finishing any relink already submitted
+ *
+ * prog: the program to remove
+ */
+void glh::core::shader_reloader::remove ( program& prog )
+{
+    /* remove the program and any reload in progress */
+    programs.erase ( std::remove ( programs.begin (), programs.end (), &prog ), programs.end () );
+    pending_reloads.erase ( std::remove_if ( pending_reloads.begin (), pending_reloads.end (), [ & ] ( const pending_reload& reload ) { return reload.prog == &prog; } ), pending_reloads.end () );
+
+    /* finish any relink, as the program cannot be left with a pending relink */
+    if ( prog.is_relink_pending () ) prog.finish_relink ();
+}
+
+/* update
+ *
+ * read any changes to watched files, submit reloads for the programs affected, and progress any reloads in progress
+ *
+ * return: the number of programs swapped for their reloaded versions by this call
+ */
+unsigned glh::core::shader_reloader::update ()
+{
+    /* record the number of reloads, to find how many happen in this call */
+    const unsigned previous_num_reloads = num_reloads;
+
+    /* submit reloads for any changed files */
+    const std::set<std::string> changed_files = read_changed_files ();
+    if ( !changed_files.empty () ) submit_reloads ( changed_files );
+
+    /* progress every reload
+     * progressing one reload can mark another as failed, so every reload is progressed before any are removed
+     */
+    std::vector<bool> finished;
+    finished.reserve ( pending_reloads.size () );
+    for ( pending_reload& reload: pending_reloads ) finished.push_back ( progress_reload ( reload ) );
+
+    /* keep the reloads which have not finished */
+    std::vector<pending_reload> unfinished_reloads;
+    for ( unsigned i = 0; i < pending_reloads.size (); ++i ) if ( !finished.at ( i ) ) unfinished_reloads.push_back ( pending_reloads.at ( i ) );
+    pending_reloads.swap ( unfinished_reloads );
+
+    /* return the number of reloads which happened */
+    return num_reloads - previous_num_reloads;
+}
+
+
+
+/* watch_program
+ *
+ * watch the directory of every file included into the shaders of a program
+ *
+ * prog: the program to watch
+ */
+void glh::core::shader_reloader::watch_program ( const program& prog )
+{
+    /* watch the directory of each file, for files being written, or moved or created in place of the file */
+    for ( const shader * s: prog.get_shaders () ) for ( const std::string& path: s->get_included_files () )
+    {
+        const std::string directory = std::filesystem::path { path }.parent_path ().string ();
+        const int wd = inotify_add_watch ( inotify_fd, ( directory.empty () ? "." : directory.c_str () ), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE );
+        if ( wd < 0 ) throw exception::reload_exception { "failed to watch shader directory " + ( directory.empty () ? std::string { "." } : directory ) };
+        watched_directories [ wd ] = directory;
+    }
+}
+
+/* read_changed_files
+ *
+ * read every pending inotify event, without blocking
+ *
+ * return: the normalised paths of the files which changed
+ */
+std::set<std::string> glh::core::shader_reloader::read_changed_files ()
+{
+    /* read events until there are none left */
+    std::set<std::string> changed_files;
+    alignas ( inotify_event ) char buffer [ 4096 ];
+    while ( true )
+    {
+        /* read as many events as fit in the buffer, stopping if there are none and throwing on any other error */
+        const ssize_t length = read ( inotify_fd, buffer, sizeof ( buffer ) );
+        if ( length < 0 && errno == EINTR ) continue;
+        if ( length < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) ) break;
+        if ( length < 0 ) throw exception::reload_exception { "failed to read inotify events" };
+        if ( length == 0 ) break;
+
+        /* add the path of the file of each event, normalised in the same way as the included files of shaders */
+        for ( ssize_t offset = 0; offset < length; )
+        {
+            const inotify_event * event = reinterpret_cast<const inotify_event *> ( buffer + offset );
+            const auto it = watched_directories.find ( event->wd );
+            if ( event->len > 0 && it != watched_directories.end () ) changed_files.insert ( ( std::filesystem::path { it->second } / event->name ).lexically_normal ().string () );
+            offset += sizeof ( inotify_event ) + event->len;
+        }
+    }
+
+    /* return the changed files */
+    return changed_files;
+}
+
+/* submit_reloads
+ *
+ * submit the recompilation of every shader which includes a changed file, and start reloading the programs using them
+ *
+ * changed_files: the normalised paths of the files which changed
+ */
+void glh::core::shader_reloader::submit_reloads ( const std::set<std::string>& changed_files )
+{
+    /* find the shaders which include any of the changed files */
+    std::set<shader *> changed_shaders;
+    for ( const program * prog: programs ) for ( shader * s: prog->get_shaders () )
+        for ( const std::string& path: s->get_included_files () ) if ( changed_files.count ( path ) ) { changed_shaders.insert ( s ); break; }
+
+    /* submit each shader, first finishing any recompilation still in progress, which is out of date
+     * a shader which cannot be submitted (e.g. if a file is mid-save) is reported and skipped, so the program using it keeps its old version of the shader
+     */
+    std::set<shader *> failed_shaders;
+    for ( shader * s: changed_shaders )
+    {
+        try
+        {
+            if ( s->is_recompile_pending () ) s->finish_recompile ();
+            s->recompile_async ();
+        }
+        catch ( const exception::shader_exception& e )
+        {
+            std::cerr << "failed to reload shader: " << e.what () << std::endl;
+            failed_shaders.insert ( s );
+        }
+    }
+
+    /* start a reload of each program using a changed shader */
+    const auto now = std::chrono::steady_clock::now ();
+    for ( program * prog: programs )
+    {
+        /* skip the program if it uses none of the changed shaders */
+        const std::vector<shader *> shaders = prog->get_shaders ();
+        if ( std::none_of ( shaders.begin (), shaders.end (), [ & ] ( shader * s ) { return changed_shaders.count ( s ) > 0; } ) ) continue;
+        const bool failed = std::any_of ( shaders.begin (), shaders.end (), [ & ] ( shader * s ) { return failed_shaders.count ( s ) > 0; } );
+
+        /* if the program is already being reloaded, a submitted relink is out of date, so finish it, then restart the reload */
+        auto it = std::find_if ( pending_reloads.begin (), pending_reloads.end (), [ & ] ( const pending_reload& reload ) { return reload.prog == prog; } );
+        if ( it != pending_reloads.end () )
+        {
+            if ( prog->is_relink_pending () && prog->finish_relink () ) ++num_reloads;
+            * it = pending_reload { prog, now, failed };
+        }
+        else pending_reloads.push_back ( pending_reload { prog, now, failed } );
+    }
+}
+
+/* progress_reload
+ *
+ * move a reload on to its next step if the driver has finished the current one
+ *
+ * reload: the reload to progress
+ *
+ * return: true if the reload has finished, whether or not it succeeded
+ */
+bool glh::core::shader_reloader::progress_reload ( pending_reload& reload )
+{
+    /* if the relink has been submitted, finish it once it is complete */
+    program& prog = * reload.prog;
+    if ( prog.is_relink_pending () )
+    {
+        if ( !prog.is_relink_complete () ) return false;
+        if ( prog.finish_relink () )
+        {
+            /* record the reload, and watch any new files included */
+            ++num_reloads;
+            last_reload_time = std::chrono::duration<double, std::milli> ( std::chrono::steady_clock::now () - reload.start ).count ();
+            watch_program ( prog );
+        }
+        else ++num_failed_reloads;
+        return true;
+    }
+
+    /* otherwise wait until every shader of the program has finished recompiling */
+    const std::vector<shader *> shaders = prog.get_shaders ();
+    for ( const shader * s: shaders ) if ( s->is_recompile_pending () && !s->is_recompile_complete () ) return false;
+
+    /* finish the recompilation of each shader, marking every reload using a shader which failed as failed */
+    for ( shader * s: shaders ) if ( s->is_recompile_pending () && !s->finish_recompile () )
+        for ( pending_reload& other: pending_reloads )
+        {
+            const std::vector<shader *> other_shaders = other.prog->get_shaders ();
+            if ( std::find ( other_shaders.begin (), other_shaders.end (), s ) != other_shaders.end () ) other.failed = true;
+        }
+
+    /* if any shader failed, keep the old program */
+    if ( reload.failed ) { ++num_failed_reloads; return true; }
+
+    /* a program loaded from the binary cache never compiled its shaders, so submit any unchanged shader which is neither compiled nor pending, then wait for them */
+    for ( shader * s: shaders ) if ( !s->is_compiled () && !s->is_compile_pending () ) s->compile_async ();
+    for ( const shader * s: shaders ) if ( s->is_compile_pending () && !s->is_compile_complete () ) return false;
+
+    /* check the result of each of those compilations, keeping the old program if any failed */
+    try { for ( shader * s: shaders ) if ( s->is_compile_pending () ) s->compile (); }
+    catch ( const exception::shader_exception& e ) { std::cerr << "failed to reload program: " << e.what () << std::endl; ++num_failed_reloads; return true; }
+
+    /* otherwise submit the relink */
+    prog.relink_async ();
+    return false;
+}
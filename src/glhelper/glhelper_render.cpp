@@ -19,8 +19,372 @@
 
 
 
+/* RENDER_STATE IMPLEMENTATION */
+
+/* default constructor
+ *
+ * the default state of OpenGL, with the viewport left unspecified
+ */
+glh::core::render_state::render_state ()
+    : depth_test { false }
+    , depth_mask { GL_TRUE }
+    , depth_func { GL_LESS }
+    , stencil_test { false }
+    , stencil_mask { 0xff }
+    , stencil_function { GL_ALWAYS }
+    , stencil_ref { 0 }
+    , stencil_func_mask { ~0u }
+    , stencil_sfail { GL_KEEP }
+    , stencil_dpfail { GL_KEEP }
+    , stencil_dppass { GL_KEEP }
+    , blend { false }
+    , face_culling { false }
+    , cull_face { GL_BACK }
+    , front_face { GL_CCW }
+    , multisample { true }
+    , viewport_specified { false }
+    , viewport_box { 0, 0, -1, -1 }
+{
+    /* set the default blend factors and equations of each render target */
+    blend_targets.fill ( blend_target { GL_ONE, GL_ZERO, GL_ONE, GL_ZERO, GL_FUNC_ADD, GL_FUNC_ADD } );
+}
+
+
+
+/* with_depth_test/mask/func
+ *
+ * return a copy of the state with depth testing enabled or disabled, a different depth mask, or a different depth function
+ */
+glh::core::render_state glh::core::render_state::with_depth_test ( const bool enabled ) const
+{
+    /* copy and modify */
+    render_state state { * this };
+    state.depth_test = enabled;
+    return state;
+}
+glh::core::render_state glh::core::render_state::with_depth_mask ( const GLboolean mask ) const
+{
+    /* copy and modify */
+    render_state state { * this };
+    state.depth_mask = mask;
+    return state;
+}
+glh::core::render_state glh::core::render_state::with_depth_func ( const GLenum func ) const
+{
+    /* copy and modify */
+    render_state state { * this };
+    state.depth_func = func;
+    return state;
+}
+
+/* with_stencil_test/mask/func/op
+ *
+ * return a copy of the state with stencil testing enabled or disabled, a different stencil mask, function or operations
+ */
+glh::core::render_state glh::core::render_state::with_stencil_test ( const bool enabled ) const
+{
+    /* copy and modify */
+    render_state state { * this };
+    state.stencil_test = enabled;
+    return state;
+}
+glh::core::render_state glh::core::render_state::with_stencil_mask ( const GLuint mask ) const
+{
+    /* copy and modify */
+    render_state state { * this };
+    state.stencil_mask = mask;
+    return state;
+}
+glh::core::render_state glh::core::render_state::with_stencil_func ( const GLenum func, const GLint ref, const GLuint mask ) const
+{
+    /* copy and modify */
+    render_state state { * this };
+    state.stencil_function = func; state.stencil_ref = ref; state.stencil_func_mask = mask;
+    return state;
+}
+glh::core::render_state glh::core::render_state::with_stencil_op ( const GLenum sfail, const GLenum dpfail, const GLenum dppass ) const
+{
+    /* copy and modify */
+    render_state state { * this };
+    state.stencil_sfail = sfail; state.stencil_dpfail = dpfail; state.stencil_dppass = dppass;
+    return state;
+}
+
+/* with_blend
+ *
+ * return a copy of the state with blending enabled or disabled
+ */
+glh::core::render_state glh::core::render_state::with_blend ( const bool enabled ) const
+{
+    /* copy and modify */
+    render_state state { * this };
+    state.blend = enabled;
+    return state;
+}
+
+/* with_blend_func/func_separate/equation
+ *
+ * return a copy of the state with different blend factors or equations, either for all render targets or a specific render target
+ */
+glh::core::render_state glh::core::render_state::with_blend_func_separate ( const GLenum srgbfact, const GLenum drgbfact, const GLenum salphafact, const GLenum dalphafact ) const
+{
+    /* copy and modify every render target */
+    render_state state { * this };
+    for ( unsigned i = 0; i < state.blend_targets.size (); ++i ) state = state.with_blend_func_separate ( i, srgbfact, drgbfact, salphafact, dalphafact );
+    return state;
+}
+glh::core::render_state glh::core::render_state::with_blend_func_separate ( const unsigned render_target, const GLenum srgbfact, const GLenum drgbfact, const GLenum salphafact, const GLenum dalphafact ) const
+{
+    /* copy and modify */
+    render_state state { * this };
+    blend_target& target = state.blend_targets.at ( render_target );
+    target.src_rgb = srgbfact; target.dst_rgb = drgbfact; target.src_alpha = salphafact; target.dst_alpha = dalphafact;
+    return state;
+}
+glh::core::render_state glh::core::render_state::with_blend_equation ( const GLenum equ ) const
+{
+    /* copy and modify every render target */
+    render_state state { * this };
+    for ( unsigned i = 0; i < state.blend_targets.size (); ++i ) state = state.with_blend_equation ( i, equ );
+    return state;
+}
+glh::core::render_state glh::core::render_state::with_blend_equation ( const unsigned render_target, const GLenum equ ) const
+{
+    /* copy and modify */
+    render_state state { * this };
+    state.blend_targets.at ( render_target ).equ_rgb = equ;
+    state.blend_targets.at ( render_target ).equ_alpha = equ;
+    return state;
+}
+
+/* with_face_culling/cull_face/front_face
+ *
+ * return a copy of the state with face culling enabled or disabled, or a different culled face or front face winding order
+ */
+glh::core::render_state glh::core::render_state::with_face_culling ( const bool enabled ) const
+{
+    /* copy and modify */
+    render_state state { * this };
+    state.face_culling = enabled;
+    return state;
+}
+glh::core::render_state glh::core::render_state::with_cull_face ( const GLenum face ) const
+{
+    /* copy and modify */
+    render_state state { * this };
+    state.cull_face = face;
+    return state;
+}
+glh::core::render_state glh::core::render_state::with_front_face ( const GLenum winding ) const
+{
+    /* copy and modify */
+    render_state state { * this };
+    state.front_face = winding;
+    return state;
+}
+
+/* with_multisample
+ *
+ * return a copy of the state with multisampling enabled or disabled
+ */
+glh::core::render_state glh::core::render_state::with_multisample ( const bool enabled ) const
+{
+    /* copy and modify */
+    render_state state { * this };
+    state.multisample = enabled;
+    return state;
+}
+
+/* with/without_viewport
+ *
+ * return a copy of the state with a specified viewport, or with the viewport left unspecified
+ */
+glh::core::render_state glh::core::render_state::with_viewport ( const GLint x, const GLint y, const GLsizei width, const GLsizei height ) const
+{
+    /* copy and modify */
+    render_state state { * this };
+    state.viewport_specified = true;
+    state.viewport_box = { x, y, width, height };
+    return state;
+}
+glh::core::render_state glh::core::render_state::without_viewport () const
+{
+    /* copy and modify */
+    render_state state { * this };
+    state.viewport_specified = false;
+    state.viewport_box = { 0, 0, -1, -1 };
+    return state;
+}
+
+
+
+/* uniform_blend_targets
+ *
+ * returns true if every render target has the same blend factors and equations
+ */
+bool glh::core::render_state::uniform_blend_targets () const
+{
+    /* compare each target to the first */
+    return std::all_of ( blend_targets.begin (), blend_targets.end (), [ this ] ( const blend_target& target ) { return target == blend_targets.front (); } );
+}
+
+/* operator==/!=
+ *
+ * compare render states setting by setting
+ */
+bool glh::core::render_state::operator== ( const render_state& other ) const
+{
+    /* compare every setting */
+    return depth_test == other.depth_test && depth_mask == other.depth_mask && depth_func == other.depth_func &&
+        stencil_test == other.stencil_test && stencil_mask == other.stencil_mask && stencil_function == other.stencil_function && stencil_ref == other.stencil_ref && stencil_func_mask == other.stencil_func_mask &&
+        stencil_sfail == other.stencil_sfail && stencil_dpfail == other.stencil_dpfail && stencil_dppass == other.stencil_dppass &&
+        blend == other.blend && blend_targets == other.blend_targets &&
+        face_culling == other.face_culling && cull_face == other.cull_face && front_face == other.front_face &&
+        multisample == other.multisample &&
+        viewport_specified == other.viewport_specified && viewport_box == other.viewport_box;
+}
+
+
+
 /* RENDERER IMPLEMENTATION */
 
+/* apply
+ * 
+ * apply a render state, making calls only for the settings which differ from the current state
+ * if the blend settings of the render state are the same for every render target, they are applied to all render targets at once
+ * 
+ * state: the render state to apply
+ */
+void glh::core::renderer::apply ( const render_state& state )
+{
+    /* depth settings */
+    if ( state.depth_test ) enable_depth_test (); else disable_depth_test ();
+    set_depth_mask ( state.depth_mask );
+    set_depth_func ( state.depth_func );
+
+    /* stencil settings */
+    if ( state.stencil_test ) enable_stencil_test (); else disable_stencil_test ();
+    set_stencil_mask ( state.stencil_mask );
+    stencil_func ( state.stencil_function, state.stencil_ref, state.stencil_func_mask );
+    stencil_op ( state.stencil_sfail, state.stencil_dpfail, state.stencil_dppass );
+
+    /* blend settings, set for all render targets at once if possible */
+    if ( state.blend ) enable_blend (); else disable_blend ();
+    if ( state.uniform_blend_targets () )
+    {
+        const render_state::blend_target& target = state.blend_targets.front ();
+        blend_func_separate ( target.src_rgb, target.dst_rgb, target.src_alpha, target.dst_alpha );
+        blend_equation_separate ( target.equ_rgb, target.equ_alpha );
+    } else for ( unsigned i = 0; i < state.blend_targets.size (); ++i )
+    {
+        const render_state::blend_target& target = state.blend_targets.at ( i );
+        blend_func_separate ( i, target.src_rgb, target.dst_rgb, target.src_alpha, target.dst_alpha );
+        blend_equation_separate ( i, target.equ_rgb, target.equ_alpha );
+    }
+
+    /* face culling settings */
+    if ( state.face_culling ) enable_face_culling (); else disable_face_culling ();
+    set_cull_face ( state.cull_face );
+    set_front_face ( state.front_face );
+
+    /* multisample setting */
+    if ( state.multisample ) enable_multisample (); else disable_multisample ();
+
+    /* viewport, if specified */
+    if ( state.viewport_specified ) viewport ( state.viewport_box.at ( 0 ), state.viewport_box.at ( 1 ), state.viewport_box.at ( 2 ), state.viewport_box.at ( 3 ) );
+}
+
+/* get_render_state
+ * 
+ * get the current depth, stencil, blend, face culling, multisample and viewport settings as a render state
+ * this can be used to restore the settings after applying a different render state
+ * the viewport is only specified if it is known
+ */
+glh::core::render_state glh::core::renderer::get_render_state ()
+{
+    /* copy each setting into a render state */
+    render_state state;
+    state.depth_test = depth_test_state; state.depth_mask = depth_mask; state.depth_func = depth_func;
+    state.stencil_test = stencil_test_state; state.stencil_mask = stencil_mask;
+    state.stencil_function = stencil_function; state.stencil_ref = stencil_ref; state.stencil_func_mask = stencil_func_mask;
+    state.stencil_sfail = stencil_sfail; state.stencil_dpfail = stencil_dpfail; state.stencil_dppass = stencil_dppass;
+    state.blend = blend_states.front ().enabled;
+    for ( unsigned i = 0; i < blend_states.size (); ++i )
+        state.blend_targets.at ( i ) = render_state::blend_target { blend_states.at ( i ).src_rgb, blend_states.at ( i ).dst_rgb, blend_states.at ( i ).src_alpha, blend_states.at ( i ).dst_alpha, blend_states.at ( i ).equ_rgb, blend_states.at ( i ).equ_alpha };
+    state.face_culling = face_culling_state; state.cull_face = cull_face; state.front_face = front_face;
+    state.multisample = multisample_state;
+    if ( viewport_box.at ( 2 ) >= 0 ) state = state.with_viewport ( viewport_box.at ( 0 ), viewport_box.at ( 1 ), viewport_box.at ( 2 ), viewport_box.at ( 3 ) );
+    return state;
+}
+
+/* get/set/reset_dispatch
+ * 
+ * get, replace or restore the table of functions used to call OpenGL
+ * setting or resetting the table also resets the state cache, as the new table will start from the default state
+ * 
+ * _dispatch: the new table of functions
+ */
+void glh::core::renderer::set_dispatch ( const gl_dispatch& _dispatch )
+{
+    /* set the table and reset the state */
+    dispatch = _dispatch;
+    reset_state ();
+}
+void glh::core::renderer::reset_dispatch ()
+{
+    /* restore the default table */
+    set_dispatch ( gl_functions );
+}
+
+/* reset_state
+ * 
+ * return the state cache to the default state of a new OpenGL context
+ * no OpenGL calls are made
+ */
+void glh::core::renderer::reset_state ()
+{
+    /* reset each piece of state to its default */
+    clear_color = math::fvec4 { 0.0, 0.0, 0.0, 0.0 };
+    depth_test_state = false;
+    depth_mask = GL_TRUE;
+    depth_func = GL_LESS;
+    stencil_test_state = false;
+    stencil_mask = 0xff;
+    stencil_function = GL_ALWAYS; stencil_ref = 0; stencil_func_mask = ~0u;
+    stencil_sfail = stencil_dpfail = stencil_dppass = GL_KEEP;
+    blend_states.fill ( blend_state { false, GL_ONE, GL_ZERO, GL_ONE, GL_ZERO, GL_FUNC_ADD, GL_FUNC_ADD } );
+    face_culling_state = false;
+    cull_face = GL_BACK;
+    front_face = GL_CCW;
+    polygon_mode = GL_FILL;
+    color_mask.fill ( GL_TRUE );
+    viewport_box = { 0, 0, -1, -1 };
+    scissor_test_state = false;
+    scissor_box = { 0, 0, -1, -1 };
+    multisample_state = true;
+    framebuffer_srgb_state = false;
+    current_program = 0;
+    current_vertex_array = 0;
+    buffer_bindings.fill ( 0 );
+    for ( std::vector<indexed_buffer_binding>& bindings: indexed_buffer_bindings ) bindings.clear ();
+    texture_units.fill ( 0 );
+    sampler_units.fill ( 0 );
+}
+
+/* reset_state_statistics
+ * 
+ * reset the number of issued and skipped calls
+ * this should be done once per frame
+ */
+void glh::core::renderer::reset_state_statistics ()
+{
+    /* reset the counters */
+    num_issued_calls = 0;
+    num_skipped_calls = 0;
+}
+
+
+
 /* draw_arrays
  *
  * draw vertices straight from a vbo (via a vao)
@@ -30,12 +394,14 @@
  * start_index: the start index of the buffered data
  * count: number of vertices to draw
  * instances: number of instances to draw (defaults to 1)
+ * base_instance: the instance which per-instance attributes start from (defaults to 0)
  */
-void glh::core::renderer::draw_arrays ( const GLenum mode, const GLint start_index, const GLsizei count, const unsigned instances )
+void glh::core::renderer::draw_arrays ( const GLenum mode, const GLint start_index, const GLsizei count, const unsigned instances, const unsigned base_instance )
 {
-    /* draw arrays */
-    if ( instances == 1 ) glDrawArrays ( mode, start_index, count );
-    else glDrawArraysInstanced ( mode, start_index, count, instances );
+    /* flush staged uniform block data, then draw arrays */
+    ubo::flush_all_staging ();
+    if ( instances == 1 && base_instance == 0 ) dispatch.draw_arrays ( mode, start_index, count );
+    else dispatch.draw_arrays_instanced_base_instance ( mode, start_index, count, instances, base_instance );
 }
 
 /* draw_elements
@@ -47,12 +413,43 @@ void glh::core::renderer::draw_arrays ( const GLenum mode, const GLint start_ind
  * type: the type of the data in the ebo
  * start_index: the start index of the elements
  * instances: number of instances to draw (defaults to 1)
+ * base_instance: the instance which per-instance attributes start from (defaults to 0)
+ */
+void glh::core::renderer::draw_elements ( const GLenum mode, const GLsizei count, const GLenum type, const GLsizeiptr start_index, const unsigned instances, const unsigned base_instance )
+{
+    /* flush staged uniform block data, then draw elements */
+    ubo::flush_all_staging ();
+    if ( instances == 1 && base_instance == 0 ) dispatch.draw_elements ( mode, count, type, reinterpret_cast<GLvoid *> ( start_index ) );
+    else dispatch.draw_elements_instanced_base_instance ( mode, count, type, reinterpret_cast<GLvoid *> ( start_index ), instances, base_instance );
+}
+
+/* dispatch_compute
+ * 
+ * dispatch work groups of the compute program in use
+ * 
+ * num_groups_x/y/z: the number of work groups in each dimension
  */
-void glh::core::renderer::draw_elements ( const GLenum mode, const GLsizei count, const GLenum type, const GLsizeiptr start_index, const unsigned instances )
+void glh::core::renderer::dispatch_compute ( const GLuint num_groups_x, const GLuint num_groups_y, const GLuint num_groups_z )
 {
-    /* draw elements */
-    if ( instances == 1 ) glDrawElements ( mode, count, type, reinterpret_cast<GLvoid *> ( start_index ) );
-    else glDrawElementsInstanced ( mode, count, type, reinterpret_cast<GLvoid *> ( start_index ), instances );
+    /* flush staged uniform block data, then dispatch */
+    ubo::flush_all_staging ();
+    dispatch.dispatch_compute ( num_groups_x, num_groups_y, num_groups_z );
+}
+
+/* dispatch_compute_indirect
+ * 
+ * dispatch work groups of the compute program in use, reading the number of work groups from a buffer
+ * the buffer is bound to the dispatch indirect target
+ * 
+ * id: the id of the buffer containing the number of work groups in each dimension, as three unsigned integers
+ * offset: the offset of the integers in the buffer in bytes
+ */
+void glh::core::renderer::dispatch_compute_indirect ( const GLuint id, const GLintptr offset )
+{
+    /* flush staged uniform block data, bind the buffer, then dispatch */
+    ubo::flush_all_staging ();
+    bind_buffer ( GL_DISPATCH_INDIRECT_BUFFER, id );
+    dispatch.dispatch_compute_indirect ( offset );
 }
 
 /* get/set_clear_color
@@ -64,9 +461,9 @@ void glh::core::renderer::draw_elements ( const GLenum mode, const GLsizei count
 void glh::core::renderer::set_clear_color ( const math::fvec4& color )
 { 
     /* if is a new clear color run the function */
-    if ( color != clear_color )
+    if ( needs_call ( color != clear_color ) )
     {
-        glClearColor ( color.at ( 0 ), color.at ( 1 ), color.at ( 2 ), color.at ( 3 ) ); 
+        dispatch.clear_color ( color.at ( 0 ), color.at ( 1 ), color.at ( 2 ), color.at ( 3 ) ); 
         clear_color = color;
     }
 }
@@ -78,18 +475,18 @@ void glh::core::renderer::set_clear_color ( const math::fvec4& color )
 void glh::core::renderer::enable_depth_test () 
 {
     /* enable if not already enabled */
-    if ( !depth_test_state )
+    if ( needs_call ( !depth_test_state ) )
     {
-        glEnable ( GL_DEPTH_TEST ); 
+        dispatch.enable ( GL_DEPTH_TEST ); 
         depth_test_state = true; 
     } 
 }
 void glh::core::renderer::disable_depth_test ()
 {
     /* disable if not already disabled */
-    if ( depth_test_state )
+    if ( needs_call ( depth_test_state ) )
     {
-        glDisable ( GL_DEPTH_TEST ); 
+        dispatch.disable ( GL_DEPTH_TEST ); 
         depth_test_state = false; 
     } 
 }
@@ -103,13 +500,29 @@ void glh::core::renderer::disable_depth_test ()
 void glh::core::renderer::set_depth_mask ( const GLboolean mask )
 { 
     /* if is a different mask */
-    if ( mask != depth_mask )
+    if ( needs_call ( mask != depth_mask ) )
     {
-        glDepthMask ( mask ); 
+        dispatch.depth_mask ( mask ); 
         depth_mask = mask;
     }
 }
 
+/* get/set_depth_func
+ *
+ * get/set the function to use for depth testing
+ * 
+ * func: the function to use (GL_LESS is the default)
+ */
+void glh::core::renderer::set_depth_func ( const GLenum func )
+{
+    /* if is a different function */
+    if ( needs_call ( func != depth_func ) )
+    {
+        dispatch.depth_func ( func );
+        depth_func = func;
+    }
+}
+
 /* enable/disable_stencil_test
  *
  * enavle or disable stencil testing
@@ -117,18 +530,18 @@ void glh::core::renderer::set_depth_mask ( const GLboolean mask )
 void glh::core::renderer::enable_stencil_test ()
 {
     /* enable if not already enabled */
-    if ( !stencil_test_state )
+    if ( needs_call ( !stencil_test_state ) )
     {
-        glEnable ( GL_STENCIL_TEST ); 
+        dispatch.enable ( GL_STENCIL_TEST ); 
         stencil_test_state = true; 
     } 
 }
 void glh::core::renderer::disable_stencil_test ()
 {
     /* disable if not already disabled */
-    if ( stencil_test_state )
+    if ( needs_call ( stencil_test_state ) )
     {
-        glDisable ( GL_STENCIL_TEST ); 
+        dispatch.disable ( GL_STENCIL_TEST ); 
         stencil_test_state = false; 
     } 
 }
@@ -143,10 +556,145 @@ void glh::core::renderer::disable_stencil_test ()
 void glh::core::renderer::set_stencil_mask ( const GLuint mask )
 {
     /* if mask differs, set new mask */
-    if ( mask != stencil_mask )
+    if ( needs_call ( mask != stencil_mask ) )
+    {
+        dispatch.stencil_mask ( mask );
+        stencil_mask = mask;
+    }
+}
+
+/* stencil_func
+ *
+ * set the function to use for stencil testing
+ * 
+ * func: the function to use (GL_ALWAYS is the default)
+ * ref: the value to compare the stencil buffer value against
+ * mask: another bit mask applied to both the stencil buffer and ref value
+ */
+void glh::core::renderer::stencil_func ( const GLenum func, const GLint ref, const GLuint mask )
+{
+    /* if any parameter differs, set the new function */
+    if ( needs_call ( func != stencil_function || ref != stencil_ref || mask != stencil_func_mask ) )
+    {
+        dispatch.stencil_func ( func, ref, mask );
+        stencil_function = func; stencil_ref = ref; stencil_func_mask = mask;
+    }
+}
+
+/* stencil_op
+ *
+ * set the options under which the stencil buffer should be updated
+ *
+ * sfail: what to do when the stencil test fails
+ * dpfail: what to do when the stencil test passes, but depth test fails
+ * dppass: what to do when the stencil and depth tests pass
+ */
+void glh::core::renderer::stencil_op ( const GLenum sfail, const GLenum dpfail, const GLenum dppass )
+{
+    /* if any operation differs, set the new operations */
+    if ( needs_call ( sfail != stencil_sfail || dpfail != stencil_dpfail || dppass != stencil_dppass ) )
+    {
+        dispatch.stencil_op ( sfail, dpfail, dppass );
+        stencil_sfail = sfail; stencil_dpfail = dpfail; stencil_dppass = dppass;
+    }
+}
+
+/* enable/disable_blend
+ *
+ * enable/disable blending either as a whole or for a specific render target
+ */
+void glh::core::renderer::enable_blend ()
+{
+    /* enable if any render target is not already enabled */
+    if ( needs_call ( std::any_of ( blend_states.begin (), blend_states.end (), [] ( const blend_state& state ) { return !state.enabled; } ) ) )
+    {
+        dispatch.enable ( GL_BLEND );
+        for ( blend_state& state: blend_states ) state.enabled = true;
+    }
+}
+void glh::core::renderer::enable_blend ( const unsigned render_target )
+{
+    /* enable if not already enabled */
+    if ( needs_call ( !blend_states.at ( render_target ).enabled ) )
+    {
+        dispatch.enablei ( GL_BLEND, render_target );
+        blend_states.at ( render_target ).enabled = true;
+    }
+}
+void glh::core::renderer::disable_blend ()
+{
+    /* disable if any render target is not already disabled */
+    if ( needs_call ( std::any_of ( blend_states.begin (), blend_states.end (), [] ( const blend_state& state ) { return state.enabled; } ) ) )
+    {
+        dispatch.disable ( GL_BLEND );
+        for ( blend_state& state: blend_states ) state.enabled = false;
+    }
+}
+void glh::core::renderer::disable_blend ( const unsigned render_target )
+{
+    /* disable if not already disabled */
+    if ( needs_call ( blend_states.at ( render_target ).enabled ) )
+    {
+        dispatch.disablei ( GL_BLEND, render_target );
+        blend_states.at ( render_target ).enabled = false;
+    }
+}
+
+/* blend_func_separate
+ *
+ * set where to revieve the factors from for blending
+ * different values can be set for the rgb and alpha components
+ *
+ * srgbfact: where to recieve the source factor for rgb components
+ * drgbfact: where to recieve the destination factor for rgb components
+ * salphafact: where to recieve the source factor for the alpha component
+ * dalphafact: where to recieve the destination factor for the alpha component
+ */
+void glh::core::renderer::blend_func_separate ( const GLenum srgbfact, const GLenum drgbfact, const GLenum salphafact, const GLenum dalphafact )
+{
+    /* set the factors if they differ for any render target */
+    if ( needs_call ( std::any_of ( blend_states.begin (), blend_states.end (), [ & ] ( const blend_state& state )
+        { return state.src_rgb != srgbfact || state.dst_rgb != drgbfact || state.src_alpha != salphafact || state.dst_alpha != dalphafact; } ) ) )
+    {
+        dispatch.blend_func_separate ( srgbfact, drgbfact, salphafact, dalphafact );
+        for ( blend_state& state: blend_states ) { state.src_rgb = srgbfact; state.dst_rgb = drgbfact; state.src_alpha = salphafact; state.dst_alpha = dalphafact; }
+    }
+}
+void glh::core::renderer::blend_func_separate ( const unsigned render_target, const GLenum srgbfact, const GLenum drgbfact, const GLenum salphafact, const GLenum dalphafact )
+{
+    /* set the factors if they differ */
+    blend_state& state = blend_states.at ( render_target );
+    if ( needs_call ( state.src_rgb != srgbfact || state.dst_rgb != drgbfact || state.src_alpha != salphafact || state.dst_alpha != dalphafact ) )
     {
-        glStencilMask ( mask );
-        stencil_mask = stencil_mask;
+        dispatch.blend_func_separatei ( render_target, srgbfact, drgbfact, salphafact, dalphafact );
+        state.src_rgb = srgbfact; state.dst_rgb = drgbfact; state.src_alpha = salphafact; state.dst_alpha = dalphafact;
+    }
+}
+
+/* blend_equation_separate
+ *
+ * set the equations to use for blending the rgb and alpha components
+ * 
+ * rgbequ: the equation for the rgb components
+ * alphaequ: the equation for the alpha component
+ */
+void glh::core::renderer::blend_equation_separate ( const GLenum rgbequ, const GLenum alphaequ )
+{
+    /* set the equations if they differ for any render target */
+    if ( needs_call ( std::any_of ( blend_states.begin (), blend_states.end (), [ & ] ( const blend_state& state ) { return state.equ_rgb != rgbequ || state.equ_alpha != alphaequ; } ) ) )
+    {
+        dispatch.blend_equation_separate ( rgbequ, alphaequ );
+        for ( blend_state& state: blend_states ) { state.equ_rgb = rgbequ; state.equ_alpha = alphaequ; }
+    }
+}
+void glh::core::renderer::blend_equation_separate ( const unsigned render_target, const GLenum rgbequ, const GLenum alphaequ )
+{
+    /* set the equations if they differ */
+    blend_state& state = blend_states.at ( render_target );
+    if ( needs_call ( state.equ_rgb != rgbequ || state.equ_alpha != alphaequ ) )
+    {
+        dispatch.blend_equation_separatei ( render_target, rgbequ, alphaequ );
+        state.equ_rgb = rgbequ; state.equ_alpha = alphaequ;
     }
 }
 
@@ -157,18 +705,18 @@ void glh::core::renderer::set_stencil_mask ( const GLuint mask )
 void glh::core::renderer::enable_face_culling ()
 {
     /* enable if not already enabled */
-    if ( !face_culling_state )
+    if ( needs_call ( !face_culling_state ) )
     {
-        glEnable ( GL_CULL_FACE ); 
+        dispatch.enable ( GL_CULL_FACE ); 
         face_culling_state = true; 
     } 
 }
 void glh::core::renderer::disable_face_culling ()
 {
     /* disable if not already disable */
-    if ( face_culling_state )
+    if ( needs_call ( face_culling_state ) )
     {
-        glDisable ( GL_CULL_FACE ); 
+        dispatch.disable ( GL_CULL_FACE ); 
         face_culling_state = false; 
     }
 }
@@ -182,9 +730,9 @@ void glh::core::renderer::disable_face_culling ()
 void glh::core::renderer::set_cull_face ( const GLenum face )
 {
     /* if a different face, set the new face */
-    if ( face != cull_face )
+    if ( needs_call ( face != cull_face ) )
     {
-        glCullFace ( face );
+        dispatch.cull_face ( face );
         cull_face = face;
     }
 }
@@ -196,13 +744,99 @@ void glh::core::renderer::set_cull_face ( const GLenum face )
 void glh::core::renderer::set_front_face ( const GLenum winding )
 {
     /* if a different front face, set the new face */
-    if ( winding != front_face )
+    if ( needs_call ( winding != front_face ) )
     {
-        glFrontFace ( winding );
+        dispatch.front_face ( winding );
         front_face = winding;
     }
 }
 
+/* get/set_polygon_mode
+ *
+ * get/set how polygons are rasterized for both faces
+ * 
+ * mode: GL_FILL (the default), GL_LINE or GL_POINT
+ */
+void glh::core::renderer::set_polygon_mode ( const GLenum mode )
+{
+    /* if a different mode, set the new mode */
+    if ( needs_call ( mode != polygon_mode ) )
+    {
+        dispatch.polygon_mode ( GL_FRONT_AND_BACK, mode );
+        polygon_mode = mode;
+    }
+}
+
+/* get/set_color_mask
+ *
+ * get/set which color components are written to the framebuffer
+ */
+void glh::core::renderer::set_color_mask ( const GLboolean red, const GLboolean green, const GLboolean blue, const GLboolean alpha )
+{
+    /* if a different mask, set the new mask */
+    const std::array<GLboolean, 4> mask { red, green, blue, alpha };
+    if ( needs_call ( mask != color_mask ) )
+    {
+        dispatch.color_mask ( red, green, blue, alpha );
+        color_mask = mask;
+    }
+}
+
+/* get_viewport/viewport
+ *
+ * get/set the viewport size
+ * the viewport is unknown until first set, in which case the width and height are -1
+ */
+void glh::core::renderer::viewport ( GLint x, GLint y, GLsizei width, GLsizei height )
+{
+    /* if a different viewport, set the new viewport */
+    const std::array<GLint, 4> box { x, y, width, height };
+    if ( needs_call ( box != viewport_box ) )
+    {
+        dispatch.viewport ( x, y, width, height );
+        viewport_box = box;
+    }
+}
+
+/* enable/disable_scissor_test
+ *
+ * enable/disable scissor testing
+ */
+void glh::core::renderer::enable_scissor_test ()
+{
+    /* enable if not already enabled */
+    if ( needs_call ( !scissor_test_state ) )
+    {
+        dispatch.enable ( GL_SCISSOR_TEST );
+        scissor_test_state = true;
+    }
+}
+void glh::core::renderer::disable_scissor_test ()
+{
+    /* disable if not already disabled */
+    if ( needs_call ( scissor_test_state ) )
+    {
+        dispatch.disable ( GL_SCISSOR_TEST );
+        scissor_test_state = false;
+    }
+}
+
+/* get_scissor/scissor
+ *
+ * get/set the scissor box
+ * the scissor box is unknown until first set, in which case the width and height are -1
+ */
+void glh::core::renderer::scissor ( GLint x, GLint y, GLsizei width, GLsizei height )
+{
+    /* if a different box, set the new box */
+    const std::array<GLint, 4> box { x, y, width, height };
+    if ( needs_call ( box != scissor_box ) )
+    {
+        dispatch.scissor ( x, y, width, height );
+        scissor_box = box;
+    }
+}
+
 /* enable/disable_multisample
  *
  * enable/disable MSAA
@@ -210,18 +844,18 @@ void glh::core::renderer::set_front_face ( const GLenum winding )
 void glh::core::renderer::enable_multisample ()
 {
     /* if is disabled, enable */
-    if ( !multisample_state )
+    if ( needs_call ( !multisample_state ) )
     {
-        glEnable ( GL_MULTISAMPLE );
+        dispatch.enable ( GL_MULTISAMPLE );
         multisample_state = true;
     }
 }
 void glh::core::renderer::disable_multisample ()
 {
     /* if is enabled, disable */
-    if ( multisample_state )
+    if ( needs_call ( multisample_state ) )
     {
-        glDisable ( GL_MULTISAMPLE );
+        dispatch.disable ( GL_MULTISAMPLE );
         multisample_state = false;
     }
 }
@@ -235,28 +869,333 @@ void glh::core::renderer::disable_multisample ()
 void glh::core::renderer::enable_framebuffer_srgb ()
 {
     /* if is disabled, enable */
-    if ( !framebuffer_srgb_state )
+    if ( needs_call ( !framebuffer_srgb_state ) )
     {
-        glEnable ( GL_FRAMEBUFFER_SRGB );
+        dispatch.enable ( GL_FRAMEBUFFER_SRGB );
         framebuffer_srgb_state = true;
     }
 }
 void glh::core::renderer::disable_framebuffer_srgb ()
 {
     /* if is enabled, disable */
-    if ( framebuffer_srgb_state )
+    if ( needs_call ( framebuffer_srgb_state ) )
     {
-        glDisable ( GL_FRAMEBUFFER_SRGB );
+        dispatch.disable ( GL_FRAMEBUFFER_SRGB );
         framebuffer_srgb_state = false;
     }
 }
 
 
 
+/* use_program
+ *
+ * use a program by its id
+ * 
+ * id: the id of the program (0 for none)
+ */
+void glh::core::renderer::use_program ( const GLuint id )
+{
+    /* if a different program, use the new program */
+    if ( needs_call ( id != current_program ) )
+    {
+        dispatch.use_program ( id );
+        current_program = id;
+    }
+}
+
+/* bind_vertex_array
+ *
+ * bind a vertex array by its id
+ * as the element array buffer binding is part of the vertex array, it becomes unknown when the vertex array changes
+ * 
+ * id: the id of the vertex array (0 for none)
+ */
+void glh::core::renderer::bind_vertex_array ( const GLuint id )
+{
+    /* if a different vertex array, bind the new vertex array */
+    if ( needs_call ( id != current_vertex_array ) )
+    {
+        dispatch.bind_vertex_array ( id );
+        current_vertex_array = id;
+        buffer_bindings.at ( buffer_target_index ( GL_ELEMENT_ARRAY_BUFFER ) ) = unknown_binding;
+    }
+}
+
+/* bind_buffer
+ *
+ * bind a buffer to a target by its id
+ * targets which are not shadowed are always bound
+ * 
+ * target: the target to bind to
+ * id: the id of the buffer (0 for none)
+ */
+void glh::core::renderer::bind_buffer ( const GLenum target, const GLuint id )
+{
+    /* if the target is not shadowed, or the buffer is different, bind the new buffer */
+    const int target_index = buffer_target_index ( target );
+    if ( needs_call ( target_index < 0 || buffer_bindings.at ( target_index ) != id ) )
+    {
+        dispatch.bind_buffer ( target, id );
+        if ( target_index >= 0 ) buffer_bindings.at ( target_index ) = id;
+    }
+}
+
+/* bind_buffer_base/range
+ *
+ * bind a buffer, or a range of a buffer, to an index of an indexed target
+ * this also binds the buffer to the general binding point of the target
+ * 
+ * target: the indexed target to bind to
+ * index: the index to bind to
+ * id: the id of the buffer (0 for none)
+ * offset/size: the range of the buffer to bind
+ */
+void glh::core::renderer::bind_buffer_base ( const GLenum target, const GLuint index, const GLuint id )
+{
+    /* if the target is not shadowed, or the binding is different, bind the new buffer */
+    const int target_index = indexed_buffer_target_index ( target );
+    if ( target_index >= 0 && indexed_buffer_bindings.at ( target_index ).size () <= index ) indexed_buffer_bindings.at ( target_index ).resize ( index + 1, indexed_buffer_binding { 0, 0, -1 } );
+    if ( needs_call ( target_index < 0 || indexed_buffer_bindings.at ( target_index ).at ( index ).id != id || indexed_buffer_bindings.at ( target_index ).at ( index ).size != -1 ) )
+    {
+        dispatch.bind_buffer_base ( target, index, id );
+        if ( target_index >= 0 ) indexed_buffer_bindings.at ( target_index ).at ( index ) = indexed_buffer_binding { id, 0, -1 };
+        if ( buffer_target_index ( target ) >= 0 ) buffer_bindings.at ( buffer_target_index ( target ) ) = id;
+    }
+}
+void glh::core::renderer::bind_buffer_range ( const GLenum target, const GLuint index, const GLuint id, const GLintptr offset, const GLsizeiptr size )
+{
+    /* if the target is not shadowed, or the binding is different, bind the new range */
+    const int target_index = indexed_buffer_target_index ( target );
+    if ( target_index >= 0 && indexed_buffer_bindings.at ( target_index ).size () <= index ) indexed_buffer_bindings.at ( target_index ).resize ( index + 1, indexed_buffer_binding { 0, 0, -1 } );
+    if ( needs_call ( target_index < 0 || indexed_buffer_bindings.at ( target_index ).at ( index ).id != id ||
+        indexed_buffer_bindings.at ( target_index ).at ( index ).offset != offset || indexed_buffer_bindings.at ( target_index ).at ( index ).size != size ) )
+    {
+        dispatch.bind_buffer_range ( target, index, id, offset, size );
+        if ( target_index >= 0 ) indexed_buffer_bindings.at ( target_index ).at ( index ) = indexed_buffer_binding { id, offset, size };
+        if ( buffer_target_index ( target ) >= 0 ) buffer_bindings.at ( buffer_target_index ( target ) ) = id;
+    }
+}
+
+/* bind_texture
+ *
+ * bind a texture to a target of texture unit 0, which is always the active unit
+ * used to bind textures which may not have been bound before, and so have no target yet
+ * unbinding only clears a single target, so the unit is then treated as unknown
+ * 
+ * target: the target to bind to
+ * id: the id of the texture (0 for none)
+ */
+void glh::core::renderer::bind_texture ( const GLenum target, const GLuint id )
+{
+    /* if a different texture, bind the new texture */
+    if ( needs_call ( id == 0 || texture_units.at ( 0 ) != id ) )
+    {
+        dispatch.bind_texture ( target, id );
+        texture_units.at ( 0 ) = ( id ? id : unknown_binding );
+    }
+}
+
+/* bind_texture_unit
+ *
+ * bind a texture to a texture unit by its id
+ * 
+ * unit: the texture unit to bind to
+ * id: the id of the texture (0 for none)
+ */
+void glh::core::renderer::bind_texture_unit ( const GLuint unit, const GLuint id )
+{
+    /* if a different texture, bind the new texture */
+    if ( needs_call ( texture_units.at ( unit ) != id ) )
+    {
+        dispatch.bind_texture_unit ( unit, id );
+        texture_units.at ( unit ) = id;
+    }
+}
+
+/* bind_textures
+ *
+ * bind textures to a range of consecutive units
+ * a single call is made if any of the units need changing
+ * 
+ * first: the first texture unit
+ * count: the number of units
+ * ids: the ids of the textures, or NULL to unbind all of the units
+ */
+void glh::core::renderer::bind_textures ( const GLuint first, const GLsizei count, const GLuint * ids )
+{
+    /* find if any of the units differ */
+    bool differs = false;
+    for ( GLsizei i = 0; i < count && !differs; ++i ) differs = texture_units.at ( first + i ) != ( ids ? ids [ i ] : 0 );
+
+    /* if so, bind the new textures */
+    if ( needs_call ( differs ) )
+    {
+        dispatch.bind_textures ( first, count, ids );
+        for ( GLsizei i = 0; i < count; ++i ) texture_units.at ( first + i ) = ( ids ? ids [ i ] : 0 );
+    }
+}
+
+/* bind_sampler
+ *
+ * bind a sampler to a texture unit by its id
+ * 
+ * unit: the texture unit to bind to
+ * id: the id of the sampler (0 for none)
+ */
+void glh::core::renderer::bind_sampler ( const GLuint unit, const GLuint id )
+{
+    /* if a different sampler, bind the new sampler */
+    if ( needs_call ( sampler_units.at ( unit ) != id ) )
+    {
+        dispatch.bind_sampler ( unit, id );
+        sampler_units.at ( unit ) = id;
+    }
+}
+
+/* forget_buffer/vertex_array/texture/sampler
+ *
+ * to be called just before an object is deleted
+ * OpenGL resets any bindings of an object to 0 when it is deleted, so the same is done to the state cache
+ * no OpenGL calls are made
+ * 
+ * id: the id of the object being deleted
+ */
+void glh::core::renderer::forget_buffer ( const GLuint id )
+{
+    /* reset the general and indexed bindings of the buffer */
+    for ( GLuint& binding: buffer_bindings ) if ( binding == id ) binding = 0;
+    for ( std::vector<indexed_buffer_binding>& bindings: indexed_buffer_bindings ) for ( indexed_buffer_binding& binding: bindings ) if ( binding.id == id ) binding = indexed_buffer_binding { 0, 0, -1 };
+}
+void glh::core::renderer::forget_vertex_array ( const GLuint id )
+{
+    /* if bound, the default vertex array becomes bound, whose element array buffer is unknown */
+    if ( current_vertex_array == id )
+    {
+        current_vertex_array = 0;
+        buffer_bindings.at ( buffer_target_index ( GL_ELEMENT_ARRAY_BUFFER ) ) = unknown_binding;
+    }
+}
+void glh::core::renderer::forget_texture ( const GLuint id )
+{
+    /* reset the units the texture is bound to */
+    for ( GLuint& unit: texture_units ) if ( unit == id ) unit = 0;
+}
+void glh::core::renderer::forget_sampler ( const GLuint id )
+{
+    /* reset the units the sampler is bound to */
+    for ( GLuint& unit: sampler_units ) if ( unit == id ) unit = 0;
+}
+
+
+
+/* buffer_target_index/indexed_buffer_target_index
+ *
+ * get the position of a buffer target in the array of buffer bindings, or -1 if the target is not shadowed
+ */
+int glh::core::renderer::buffer_target_index ( const GLenum target )
+{
+    /* switch on the target */
+    switch ( target )
+    {
+        case GL_ARRAY_BUFFER: return 0;
+        case GL_ATOMIC_COUNTER_BUFFER: return 1;
+        case GL_COPY_READ_BUFFER: return 2;
+        case GL_COPY_WRITE_BUFFER: return 3;
+        case GL_DISPATCH_INDIRECT_BUFFER: return 4;
+        case GL_DRAW_INDIRECT_BUFFER: return 5;
+        case GL_ELEMENT_ARRAY_BUFFER: return 6;
+        case GL_PIXEL_PACK_BUFFER: return 7;
+        case GL_PIXEL_UNPACK_BUFFER: return 8;
+        case GL_QUERY_BUFFER: return 9;
+        case GL_SHADER_STORAGE_BUFFER: return 10;
+        case GL_TEXTURE_BUFFER: return 11;
+        case GL_TRANSFORM_FEEDBACK_BUFFER: return 12;
+        case GL_UNIFORM_BUFFER: return 13;
+        default: return -1;
+    }
+}
+int glh::core::renderer::indexed_buffer_target_index ( const GLenum target )
+{
+    /* switch on the target */
+    switch ( target )
+    {
+        case GL_ATOMIC_COUNTER_BUFFER: return 0;
+        case GL_SHADER_STORAGE_BUFFER: return 1;
+        case GL_TRANSFORM_FEEDBACK_BUFFER: return 2;
+        case GL_UNIFORM_BUFFER: return 3;
+        default: return -1;
+    }
+}
+
+/* needs_call
+ *
+ * count a request to change state, returning true if it must be passed on to OpenGL
+ * 
+ * differs: whether the requested state differs from the current state
+ */
+bool glh::core::renderer::needs_call ( const bool differs )
+{
+    /* count the call as issued or skipped */
+    if ( differs ) ++num_issued_calls; else ++num_skipped_calls;
+    return differs;
+}
+
+
+
 /* RENDERER STATIC MEMBERS DEFINITIONS */
 
+/* the default table of functions call straight through to OpenGL */
+const glh::core::gl_dispatch glh::core::renderer::gl_functions = [] ()
+{
+    gl_dispatch functions;
+    functions.enable = [] ( GLenum cap ) { glEnable ( cap ); };
+    functions.disable = [] ( GLenum cap ) { glDisable ( cap ); };
+    functions.enablei = [] ( GLenum cap, GLuint index ) { glEnablei ( cap, index ); };
+    functions.disablei = [] ( GLenum cap, GLuint index ) { glDisablei ( cap, index ); };
+    functions.clear_color = [] ( GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha ) { glClearColor ( red, green, blue, alpha ); };
+    functions.clear = [] ( GLbitfield mask ) { glClear ( mask ); };
+    functions.depth_func = [] ( GLenum func ) { glDepthFunc ( func ); };
+    functions.depth_mask = [] ( GLboolean flag ) { glDepthMask ( flag ); };
+    functions.stencil_func = [] ( GLenum func, GLint ref, GLuint mask ) { glStencilFunc ( func, ref, mask ); };
+    functions.stencil_op = [] ( GLenum sfail, GLenum dpfail, GLenum dppass ) { glStencilOp ( sfail, dpfail, dppass ); };
+    functions.stencil_mask = [] ( GLuint mask ) { glStencilMask ( mask ); };
+    functions.blend_func_separate = [] ( GLenum srgbfact, GLenum drgbfact, GLenum salphafact, GLenum dalphafact ) { glBlendFuncSeparate ( srgbfact, drgbfact, salphafact, dalphafact ); };
+    functions.blend_func_separatei = [] ( GLuint buf, GLenum srgbfact, GLenum drgbfact, GLenum salphafact, GLenum dalphafact ) { glBlendFuncSeparatei ( buf, srgbfact, drgbfact, salphafact, dalphafact ); };
+    functions.blend_equation_separate = [] ( GLenum rgbequ, GLenum alphaequ ) { glBlendEquationSeparate ( rgbequ, alphaequ ); };
+    functions.blend_equation_separatei = [] ( GLuint buf, GLenum rgbequ, GLenum alphaequ ) { glBlendEquationSeparatei ( buf, rgbequ, alphaequ ); };
+    functions.cull_face = [] ( GLenum face ) { glCullFace ( face ); };
+    functions.front_face = [] ( GLenum winding ) { glFrontFace ( winding ); };
+    functions.polygon_mode = [] ( GLenum face, GLenum mode ) { glPolygonMode ( face, mode ); };
+    functions.color_mask = [] ( GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha ) { glColorMask ( red, green, blue, alpha ); };
+    functions.viewport = [] ( GLint x, GLint y, GLsizei width, GLsizei height ) { glViewport ( x, y, width, height ); };
+    functions.scissor = [] ( GLint x, GLint y, GLsizei width, GLsizei height ) { glScissor ( x, y, width, height ); };
+    functions.use_program = [] ( GLuint program ) { glUseProgram ( program ); };
+    functions.bind_vertex_array = [] ( GLuint array ) { glBindVertexArray ( array ); };
+    functions.bind_buffer = [] ( GLenum target, GLuint buffer ) { glBindBuffer ( target, buffer ); };
+    functions.bind_buffer_base = [] ( GLenum target, GLuint index, GLuint buffer ) { glBindBufferBase ( target, index, buffer ); };
+    functions.bind_buffer_range = [] ( GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size ) { glBindBufferRange ( target, index, buffer, offset, size ); };
+    functions.bind_texture = [] ( GLenum target, GLuint texture ) { glBindTexture ( target, texture ); };
+    functions.bind_texture_unit = [] ( GLuint unit, GLuint texture ) { glBindTextureUnit ( unit, texture ); };
+    functions.bind_textures = [] ( GLuint first, GLsizei count, const GLuint * textures ) { glBindTextures ( first, count, textures ); };
+    functions.bind_sampler = [] ( GLuint unit, GLuint sampler ) { glBindSampler ( unit, sampler ); };
+    functions.draw_arrays = [] ( GLenum mode, GLint first, GLsizei count ) { glDrawArrays ( mode, first, count ); };
+    functions.draw_arrays_instanced_base_instance = [] ( GLenum mode, GLint first, GLsizei count, GLsizei instances, GLuint base_instance ) { glDrawArraysInstancedBaseInstance ( mode, first, count, instances, base_instance ); };
+    functions.draw_elements = [] ( GLenum mode, GLsizei count, GLenum type, const void * indices ) { glDrawElements ( mode, count, type, indices ); };
+    functions.draw_elements_instanced_base_instance = [] ( GLenum mode, GLsizei count, GLenum type, const void * indices, GLsizei instances, GLuint base_instance ) { glDrawElementsInstancedBaseInstance ( mode, count, type, indices, instances, base_instance ); };
+    functions.dispatch_compute = [] ( GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z ) { glDispatchCompute ( num_groups_x, num_groups_y, num_groups_z ); };
+    functions.dispatch_compute_indirect = [] ( GLintptr indirect ) { glDispatchComputeIndirect ( indirect ); };
+    return functions;
+} ();
+
+/* the default table is in use by default */
+glh::core::gl_dispatch glh::core::renderer::dispatch { gl_functions };
+
+/* no calls have been issued or skipped by default */
+unsigned glh::core::renderer::num_issued_calls { 0 };
+unsigned glh::core::renderer::num_skipped_calls { 0 };
+
 /* clear color is black by default */
-glh::math::fvec4 glh::core::renderer::clear_color { 0.0, 0.0, 0.0, 1.0 };
+glh::math::fvec4 glh::core::renderer::clear_color { 0.0, 0.0, 0.0, 0.0 };
 
 /* depth testing disabled by default */
 bool glh::core::renderer::depth_test_state { false };
@@ -264,12 +1203,33 @@ bool glh::core::renderer::depth_test_state { false };
 /* depth mask is GL_TRUE by default */
 GLboolean glh::core::renderer::depth_mask { GL_TRUE };
 
+/* depth function is GL_LESS by default */
+GLenum glh::core::renderer::depth_func { GL_LESS };
+
 /* stencil testing disabled by default */
 bool glh::core::renderer::stencil_test_state { false };
 
 /* stencil mask is 0xff by default */
 GLuint glh::core::renderer::stencil_mask { 0xff };
 
+/* stencil function is GL_ALWAYS, with a reference of 0 and all mask bits set, by default */
+GLenum glh::core::renderer::stencil_function { GL_ALWAYS };
+GLint glh::core::renderer::stencil_ref { 0 };
+GLuint glh::core::renderer::stencil_func_mask { ~0u };
+
+/* stencil operations are GL_KEEP by default */
+GLenum glh::core::renderer::stencil_sfail { GL_KEEP };
+GLenum glh::core::renderer::stencil_dpfail { GL_KEEP };
+GLenum glh::core::renderer::stencil_dppass { GL_KEEP };
+
+/* blending is disabled, with factors of GL_ONE and GL_ZERO and an equation of GL_FUNC_ADD, by default */
+std::array<glh::core::renderer::blend_state, 8> glh::core::renderer::blend_states = [] ()
+{
+    std::array<blend_state, 8> states;
+    states.fill ( blend_state { false, GL_ONE, GL_ZERO, GL_ONE, GL_ZERO, GL_FUNC_ADD, GL_FUNC_ADD } );
+    return states;
+} ();
+
 /* face culling is disabled by default */
 bool glh::core::renderer::face_culling_state { false };
 
@@ -279,8 +1239,31 @@ GLenum glh::core::renderer::cull_face { GL_BACK };
 /* front face is GL_CCW by default */
 GLenum glh::core::renderer::front_face ( GL_CCW );
 
-/* multisampling is disabled by default */
-bool glh::core::renderer::multisample_state { false };
+/* polygon mode is GL_FILL by default */
+GLenum glh::core::renderer::polygon_mode { GL_FILL };
+
+/* all color components are written by default */
+std::array<GLboolean, 4> glh::core::renderer::color_mask { GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE };
+
+/* the viewport is unknown by default */
+std::array<GLint, 4> glh::core::renderer::viewport_box { 0, 0, -1, -1 };
+
+/* scissor testing is disabled by default */
+bool glh::core::renderer::scissor_test_state { false };
+
+/* the scissor box is unknown by default */
+std::array<GLint, 4> glh::core::renderer::scissor_box { 0, 0, -1, -1 };
+
+/* multisampling is enabled by default */
+bool glh::core::renderer::multisample_state { true };
 
 /* framebuffer srgb is disabled by default */
-bool glh::core::renderer::framebuffer_srgb_state { false };
\ No newline at end of file
+bool glh::core::renderer::framebuffer_srgb_state { false };
+
+/* no program, vertex array, buffers, textures or samplers are bound by default */
+GLuint glh::core::renderer::current_program { 0 };
+GLuint glh::core::renderer::current_vertex_array { 0 };
+std::array<GLuint, 14> glh::core::renderer::buffer_bindings {};
+std::array<std::vector<glh::core::renderer::indexed_buffer_binding>, 4> glh::core::renderer::indexed_buffer_bindings {};
+std::array<GLuint, 80> glh::core::renderer::texture_units {};
+std::array<GLuint, 80> glh::core::renderer::sampler_units {};
@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * src/glhelper/glhelper_render_queue.cpp
+ *
+ * implementation of include/glhelper/glhelper_render_queue.hpp
+ *
+ */
+
+
+
+/* INCLUDES */
+
+/* include glhelper_render_queue.hpp */
+#include <glhelper/glhelper_render_queue.hpp>
+
+
+
+/* RENDER_QUEUE IMPLEMENTATION */
+
+/* constructor
+ *
+ * create an empty queue
+ *
+ * _back_to_front: true if the packets should be sorted back to front before render state, program and material, as for transparent passes (defaults to false)
+ */
+glh::core::render_queue::render_queue ( const bool _back_to_front )
+    : back_to_front { _back_to_front }
+    , view_position { 0.0 }
+    , sorted { true }
+    , num_submitted_packets { 0 }
+    , num_state_changes { 0 }
+    , num_program_changes { 0 }
+    , num_vao_changes { 0 }
+{}
+
+
+
+/* record
+ *
+ * record a packet into the queue
+ * no OpenGL calls are made, so different queues can be recorded into from different threads at once
+ *
+ * state: the render state to draw the packet with
+ * packet: the packet to record (the program and vao must not be NULL, and the state index is ignored)
+ */
+void glh::core::render_queue::record ( const render_state& state, const draw_packet& packet )
+{
+    /* throw if the program or vao are missing */
+    if ( !packet.prog || !packet.vertex_arrays ) throw exception::render_queue_exception { "attempted to record draw packet without a program or vao" };
+
+    /* add the packet with the index of its state */
+    packets.push_back ( packet );
+    packets.back ().state_index = intern_state ( state );
+    sorted = false;
+}
+
+/* merge
+ *
+ * move the packets of another queue to the end of this one, leaving the other queue empty
+ *
+ * other: the queue to merge into this one
+ */
+void glh::core::render_queue::merge ( render_queue& other )
+{
+    /* merging a queue into itself does nothing */
+    if ( &other == this ) return;
+
+    /* find the index of each of the other queue's states in this queue */
+    std::vector<unsigned> state_indices;
+    state_indices.reserve ( other.states.size () );
+    for ( const render_state& state: other.states ) state_indices.push_back ( intern_state ( state ) );
+
+    /* append the packets, remapping their states */
+    packets.reserve ( packets.size () + other.packets.size () );
+    for ( const draw_packet& packet: other.packets )
+    {
+        packets.push_back ( packet );
+        packets.back ().state_index = state_indices.at ( packet.state_index );
+    }
+    if ( !other.packets.empty () ) sorted = false;
+
+    /* empty the other queue */
+    other.clear ();
+}
+
+/* clear
+ *
+ * remove all packets and render states from the queue, ready for the next frame
+ * the statistics are not reset
+ */
+void glh::core::render_queue::clear ()
+{
+    /* clear the arrays, keeping their capacity for the next frame */
+    packets.clear ();
+    states.clear ();
+    keys.clear ();
+    order.clear ();
+    sorted = true;
+}
+
+
+
+/* sort
+ *
+ * sort the packets by their keys
+ * this is called by submit if the queue is not already sorted
+ */
+void glh::core::render_queue::sort ()
+{
+    /* give each program and material an id in the order they first appear */
+    std::unordered_map<const void *, std::uint64_t> program_ids, material_ids;
+    keys.resize ( packets.size () );
+    for ( unsigned i = 0; i < packets.size (); ++i )
+    {
+        const draw_packet& packet = packets.at ( i );
+        const std::uint64_t program_id = program_ids.emplace ( packet.prog, program_ids.size () ).first->second;
+        const std::uint64_t material_id = material_ids.emplace ( packet.material, material_ids.size () ).first->second;
+
+        /* build the key
+         * front to back: state (8 bits) | program (12 bits) | material (20 bits) | depth (24 bits)
+         * back to front: inverted depth (24 bits) | state (8 bits) | program (12 bits) | material (20 bits)
+         * the depth is above the state when back to front, as a transparent pass can use several states (e.g. for one and two sided meshes) which must still blend in depth order
+         */
+        if ( back_to_front ) keys.at ( i ) = ( ( 0xffffff - depth_bits ( packet.depth ) ) << 40 ) | ( std::uint64_t { packet.state_index } << 32 ) | ( program_id << 20 ) | material_id;
+        else keys.at ( i ) = ( std::uint64_t { packet.state_index } << 56 ) | ( program_id << 44 ) | ( material_id << 24 ) | depth_bits ( packet.depth );
+    }
+
+    /* throw if there are too many programs or materials for the key */
+    if ( program_ids.size () > 0x1000 || material_ids.size () > 0x100000 ) throw exception::render_queue_exception { "attempted to sort render queue with more programs or materials than the sort key can hold" };
+
+    /* start with the packets in the order they were recorded */
+    order.resize ( packets.size () );
+    for ( unsigned i = 0; i < order.size (); ++i ) order.at ( i ) = i;
+
+    /* LSD radix sort, one byte at a time from the least significant
+     * each pass is stable, so the order of the less significant bytes is kept within each bucket
+     */
+    std::vector<unsigned> scratch ( order.size () );
+    for ( unsigned shift = 0; shift < 64; shift += 8 )
+    {
+        /* count the keys in each bucket */
+        std::array<unsigned, 256> counts;
+        counts.fill ( 0 );
+        for ( const std::uint64_t key: keys ) ++counts.at ( ( key >> shift ) & 0xff );
+
+        /* if every key has the same byte, the pass would not change the order, so skip it */
+        if ( std::find ( counts.begin (), counts.end (), order.size () ) != counts.end () ) continue;
+
+        /* turn the counts into the start of each bucket, then scatter the packets into their buckets */
+        unsigned offset = 0;
+        for ( unsigned& count: counts ) { const unsigned size = count; count = offset; offset += size; }
+        for ( const unsigned index: order ) scratch.at ( counts.at ( ( keys.at ( index ) >> shift ) & 0xff )++ ) = index;
+        order.swap ( scratch );
+    }
+
+    /* the queue is now sorted */
+    sorted = true;
+}
+
+/* submit
+ *
+ * draw the packets in sorted order, only changing render states, programs and vaos when they differ from the packet before
+ * the vao of the last packet is unbound afterwards
+ */
+void glh::core::render_queue::submit ()
+{
+    /* sort if not already sorted */
+    if ( !sorted ) sort ();
+
+    /* draw each packet, tracking the previous packet to find what has changed */
+    const draw_packet * previous = NULL;
+    for ( const unsigned index: order )
+    {
+        const draw_packet& packet = packets.at ( index );
+
+        /* apply the render state, program and vao if they have changed */
+        if ( !previous || packet.state_index != previous->state_index ) { renderer::apply ( states.at ( packet.state_index ) ); ++num_state_changes; }
+        if ( !previous || packet.prog != previous->prog ) { packet.prog->use (); ++num_program_changes; }
+        if ( !previous || packet.vertex_arrays != previous->vertex_arrays ) { packet.vertex_arrays->bind (); ++num_vao_changes; }
+
+        /* let the source set its uniforms */
+        if ( packet.source ) packet.source->prepare_packet ( packet, previous );
+
+        /* draw */
+        if ( packet.type == GL_NONE ) renderer::draw_arrays ( packet.mode, packet.start_index, packet.count, packet.instances );
+        else renderer::draw_elements ( packet.mode, packet.count, packet.type, packet.start_index, packet.instances );
+        ++num_submitted_packets;
+
+        /* this packet is now the previous packet */
+        previous = &packet;
+    }
+
+    /* unbind the last vao */
+    if ( previous ) previous->vertex_arrays->unbind ();
+}
+
+
+
+/* reset_submit_statistics
+ *
+ * reset the number of submitted packets and changes to zero
+ */
+void glh::core::render_queue::reset_submit_statistics ()
+{
+    /* reset the counters */
+    num_submitted_packets = 0;
+    num_state_changes = 0;
+    num_program_changes = 0;
+    num_vao_changes = 0;
+}
+
+
+
+/* intern_state
+ *
+ * get the index of a render state in the queue, adding it if it is not already present
+ *
+ * state: the render state to find
+ *
+ * return: the index of the state
+ */
+unsigned glh::core::render_queue::intern_state ( const render_state& state )
+{
+    /* passes use few render states, so a linear search is fastest */
+    const auto it = std::find ( states.begin (), states.end (), state );
+    if ( it != states.end () ) return it - states.begin ();
+
+    /* throw if the state would not fit in the sort key */
+    if ( states.size () == 0x100 ) throw exception::render_queue_exception { "attempted to record more than 256 render states into a render queue" };
+
+    /* add the state */
+    states.push_back ( state );
+    return states.size () - 1;
+}
+
+/* depth_bits
+ *
+ * get the 24 most significant bits of a non-negative depth, which sort in the same order as the depths themselves
+ *
+ * depth: the depth to convert (negative depths are treated as zero)
+ */
+std::uint64_t glh::core::render_queue::depth_bits ( const float depth )
+{
+    /* the bits of a non-negative float increase with its value, and the sign bit is always zero, so take the 24 bits after it */
+    if ( !( depth > 0.0f ) ) return 0;
+    std::uint32_t bits;
+    std::memcpy ( &bits, &depth, sizeof ( bits ) );
+    return ( bits >> 7 ) & 0xffffff;
+}
@@ -17,6 +17,12 @@
 /* include glhelper_shader.hpp */
 #include <glhelper/glhelper_shader.hpp>
 
+/* include glhelper_render.hpp */
+#include <glhelper/glhelper_render.hpp>
+
+/* include glhelper_glad.hpp */
+#include <glhelper/glhelper_glad.hpp>
+
 
 
 /* UNIFORM COMPARISION OPERATORS IMPLEMENTATION */
@@ -28,7 +34,7 @@
  */
 bool operator== ( const glh::core::uniform& lhs, const glh::core::uniform& rhs )
 {
-    return ( lhs.get_program () == rhs.get_program () && lhs.get_name () == rhs.get_name () );
+    return ( lhs.get_program () == rhs.get_program () && lhs.get_name_hash () == rhs.get_name_hash () );
 }
 bool operator!= ( const glh::core::uniform& lhs, const glh::core::uniform& rhs )
 {
@@ -36,7 +42,7 @@ bool operator!= ( const glh::core::uniform& lhs, const glh::core::uniform& rhs )
 }
 bool operator== ( const glh::core::struct_uniform& lhs, const glh::core::struct_uniform& rhs )
 {
-    return ( lhs.get_program () == rhs.get_program () && lhs.get_name () == rhs.get_name () );
+    return ( lhs.get_program () == rhs.get_program () && lhs.get_name_hash () == rhs.get_name_hash () );
 }
 bool operator!= ( const glh::core::struct_uniform& lhs, const glh::core::struct_uniform& rhs )
 {
@@ -49,8 +55,11 @@ bool operator!= ( const glh::core::struct_uniform& lhs, const glh::core::struct_
 
 /* multi-source constructor */
 glh::core::shader::shader ( const GLenum type, std::initializer_list<std::string> paths )
-    : source { "#version 460" }
+    : source { "#version 460\n" }
+    , defines_end { source.size () }
     , compiled { false }
+    , compile_pending { false }
+    , recompile_id { 0 }
 {
     /* generate shader */
     id = glCreateShader ( type );
@@ -62,8 +71,9 @@ glh::core::shader::shader ( const GLenum type, std::initializer_list<std::string
 /* destructor */
 glh::core::shader::~shader ()
 {
-    /* destroy shader */
+    /* destroy shader, and any pending recompilation */
     glDeleteShader ( id );
+    if ( recompile_id ) glDeleteShader ( recompile_id );
 }
 
 
@@ -74,20 +84,11 @@ glh::core::shader::~shader ()
  */
 void glh::core::shader::include_files ( std::initializer_list<std::string> paths )
 {
-    /* loop through paths */
+    /* loop through paths, recording and including each file */
     for ( const auto& path: paths )
     {
-        /* try to open the shader */
-        std::ifstream shader_file { path, std::ios_base::in };
-
-        /* throw exception for failure */
-        if ( !shader_file ) throw exception::shader_exception { "could not open shader file" };
-
-        /* otherwise read shader as string */
-        source.append ( std::istreambuf_iterator<char> ( shader_file ), std::istreambuf_iterator<char> () );
-
-        /* close the file */
-        shader_file.close ();
+        source_parts.push_back ( source_part { path, std::string {} } );
+        include_file ( path, source, included_files );
     }
 }
 
@@ -97,47 +98,288 @@ void glh::core::shader::include_files ( std::initializer_list<std::string> paths
  */
 void glh::core::shader::include_source ( const std::string& source_to_include )
 {
-    /* append the source */
+    /* record and append the source */
+    source_parts.push_back ( source_part { std::string {}, source_to_include } );
     source.append ( source_to_include );
 }
 
+/* define
+ *
+ * add a #define directive after the version directive, so that it applies to all of the source
+ *
+ * name: the name of the macro
+ * value: the value of the macro (defaults to none)
+ */
+void glh::core::shader::define ( const std::string& name, const std::string& value )
+{
+    /* add the directive */
+    add_defines ( "#define " + name + ( value.empty () ? "" : " " + value ) + "\n" );
+}
+
+/* add_defines
+ *
+ * add source (e.g. several #define directives) after the version directive and any previous defines
+ */
+void glh::core::shader::add_defines ( const std::string& defines )
+{
+    /* insert the defines, making sure they end in a newline */
+    const std::string line_defines = ( defines.empty () || defines.back () == '\n' ? defines : defines + '\n' );
+    source.insert ( defines_end, line_defines );
+    defines_end += line_defines.size ();
+}
+
 
 
 /* compile
  * 
- * compiles the shader
+ * compiles the shader, or if a compilation has been submitted by compile_async, waits for it to finish
+ * throws if compilation fails
  */
 void glh::core::shader::compile ()
+{
+    /* submit the compilation, unless it has already been submitted */
+    if ( !compile_pending ) compile_async ();
+    compile_pending = false;
+
+    /* check compilation success, which waits for the compilation to finish */
+    GLint comp_success;
+    glGetShaderiv ( id, GL_COMPILE_STATUS, &comp_success );
+    if ( !comp_success ) 
+    {
+        /* compilation failed, so log and throw */
+        log_compile_failure ( id, source );
+        throw exception::shader_exception { "shader compilation failed" };
+    }
+
+    /* set is_compiled to true */
+    compiled = true;
+}
+
+/* compile_async
+ *
+ * submit the shader for compilation without waiting for the result
+ * the result is checked by compile, or when a program using the shader is linked
+ */
+void glh::core::shader::compile_async ()
 {
     /* attach the current source and compile */
     const char * source_ptr = source.c_str ();
     glShaderSource ( id, 1, &source_ptr, NULL );
     glCompileShader ( id );
 
-    /* check compilation success */
-    GLint comp_success;
-    glGetShaderiv ( id, GL_COMPILE_STATUS, &comp_success );
-    if ( !comp_success ) 
+    /* the shader is not compiled until the result is checked */
+    compiled = false;
+    compile_pending = true;
+}
+
+/* recompile_async
+ *
+ * rebuild the source from the same files, defines and source, reading any files which have changed, and submit it to a new shader object
+ * the current shader object and source are left in place until finish_recompile
+ * throws if a file cannot be read, or if a recompilation is already pending
+ */
+void glh::core::shader::recompile_async ()
+{
+    /* throw if a recompilation is already pending */
+    if ( recompile_id ) throw exception::shader_exception { "attempted to recompile shader while a recompilation is already pending" };
+
+    /* rebuild the source, starting from the version directive and defines, then adding each part in turn */
+    std::string new_source = source.substr ( 0, defines_end );
+    std::vector<std::string> new_included_files;
+    for ( const source_part& part: source_parts )
     {
-        /* compilation failed
-         * first get log info */
-        char comp_log [ GLH_SHADER_LOG_SIZE ];
-        glGetShaderInfoLog ( id, GLH_SHADER_LOG_SIZE, NULL, comp_log );
+        if ( part.path.empty () ) new_source.append ( part.source );
+        else include_file ( part.path, new_source, new_included_files );
+    }
 
-        /* print log info to stderr */
-        std::cerr << "\nSHADER TRACEBACK:\n\n" << comp_log;
+    /* create a shader object of the same type, then submit the new source to it */
+    GLint type;
+    glGetShaderiv ( id, GL_SHADER_TYPE, &type );
+    recompile_id = glCreateShader ( type );
+    recompile_source = std::move ( new_source );
+    recompile_included_files = std::move ( new_included_files );
+    const char * source_ptr = recompile_source.c_str ();
+    glShaderSource ( recompile_id, 1, &source_ptr, NULL );
+    glCompileShader ( recompile_id );
+}
 
-        /* write into file */
-        std::ofstream log_file { GLH_SHADER_LOG_FILE, std::ios::out };
-        log_file << source;
-        log_file.close ();
+/* is_recompile_complete
+ *
+ * returns true if the result of a submitted recompilation can be checked without blocking
+ * always true if no recompilation is pending, or if parallel shader compile is not supported
+ */
+bool glh::core::shader::is_recompile_complete () const
+{
+    /* return true if there is nothing to wait for, or no way to ask */
+    if ( !recompile_id || !glad_loader::has_parallel_shader_compile () ) return true;
 
-        /* throw */
-        throw exception::shader_exception { "shader compilation failed" };
+    /* query the completion status */
+    GLint complete;
+    glGetShaderiv ( recompile_id, GL_COMPLETION_STATUS_KHR, &complete );
+    return complete;
+}
+
+/* finish_recompile
+ *
+ * check the result of a submitted recompilation, blocking if it is not complete
+ * on success the new shader object and source replace the current ones, otherwise the error is logged and the new object deleted
+ *
+ * return: true if the shader was recompiled successfully
+ */
+bool glh::core::shader::finish_recompile ()
+{
+    /* throw if no recompilation is pending */
+    if ( !recompile_id ) throw exception::shader_exception { "attempted to finish recompiling shader with no recompilation pending" };
+
+    /* take the pending shader object */
+    const GLuint new_id = recompile_id;
+    recompile_id = 0;
+
+    /* check compilation success, keeping the current shader object and source on failure */
+    GLint comp_success;
+    glGetShaderiv ( new_id, GL_COMPILE_STATUS, &comp_success );
+    if ( !comp_success )
+    {
+        log_compile_failure ( new_id, recompile_source );
+        glDeleteShader ( new_id );
+        recompile_source.clear ();
+        recompile_included_files.clear ();
+        return false;
     }
 
-    /* set is_compiled to true */
+    /* swap in the new shader object and source
+     * programs linked with the old object remain valid after it is deleted
+     */
+    glDeleteShader ( id );
+    id = new_id;
+    source = std::move ( recompile_source );
+    included_files = std::move ( recompile_included_files );
+    recompile_source.clear ();
+    recompile_included_files.clear ();
     compiled = true;
+    compile_pending = false;
+    return true;
+}
+
+/* include_file
+ *
+ * preprocess a file and append it to a source, unless it has already been included
+ *
+ * path: the path of the file
+ * target_source: the source to append to
+ * target_included_files: the normalised paths of the files already included into the source
+ */
+void glh::core::shader::include_file ( const std::string& path, std::string& target_source, std::vector<std::string>& target_included_files )
+{
+    /* normalise the path, and return if the file has already been included */
+    const std::string normal_path = std::filesystem::path { path }.lexically_normal ().string ();
+    if ( std::find ( target_included_files.begin (), target_included_files.end (), normal_path ) != target_included_files.end () ) return;
+    target_included_files.push_back ( normal_path );
+
+    /* append the file line by line, replacing #include directives with the files they refer to */
+    std::istringstream file_stream { read_source_file ( normal_path ) };
+    std::string line;
+    while ( std::getline ( file_stream, line ) )
+    {
+        const std::string include_path = parse_include_directive ( line );
+        if ( include_path.empty () ) target_source.append ( line ).push_back ( '\n' );
+        else include_file ( ( std::filesystem::path { normal_path }.parent_path () / include_path ).string (), target_source, target_included_files );
+    }
+}
+
+/* log_compile_failure
+ *
+ * print the info log of a shader object which failed to compile to stderr, and write the source which failed to the log file
+ *
+ * shader_id: the shader object
+ * failed_source: the source it was compiled from
+ */
+void glh::core::shader::log_compile_failure ( const GLuint shader_id, const std::string& failed_source )
+{
+    /* get log info */
+    char comp_log [ GLH_SHADER_LOG_SIZE ];
+    glGetShaderInfoLog ( shader_id, GLH_SHADER_LOG_SIZE, NULL, comp_log );
+
+    /* print log info to stderr */
+    std::cerr << "\nSHADER TRACEBACK:\n\n" << comp_log;
+
+    /* write into file */
+    std::ofstream log_file { GLH_SHADER_LOG_FILE, std::ios::out };
+    log_file << failed_source;
+    log_file.close ();
+}
+
+/* read_source_file
+ *
+ * get the contents of a file through the source cache, throwing if it cannot be read
+ *
+ * path: the normalised path of the file
+ */
+const std::string& glh::core::shader::read_source_file ( const std::string& path )
+{
+    /* get the last write time of the file, throwing if it does not exist */
+    std::error_code error;
+    const std::filesystem::file_time_type write_time = std::filesystem::last_write_time ( path, error );
+    if ( error ) throw exception::shader_exception { "could not open shader file " + path };
+
+    /* return the cached contents if they are up to date */
+    auto it = source_cache.find ( path );
+    if ( it != source_cache.end () && it->second.write_time == write_time ) { ++num_source_cache_hits; return it->second.contents; }
+    ++num_source_cache_misses;
+
+    /* otherwise open the file, throwing on failure */
+    std::ifstream shader_file { path, std::ios_base::in };
+    if ( !shader_file ) throw exception::shader_exception { "could not open shader file " + path };
+
+    /* read the file into the cache */
+    cached_source_file& cached_file = source_cache [ path ];
+    cached_file.write_time = write_time;
+    cached_file.contents.assign ( std::istreambuf_iterator<char> ( shader_file ), std::istreambuf_iterator<char> () );
+    return cached_file.contents;
+}
+
+/* parse_include_directive
+ *
+ * get the path of an #include directive
+ *
+ * line: a line of source
+ *
+ * return: the path in quotes or angle brackets, or an empty string if the line is not an #include directive
+ */
+std::string glh::core::shader::parse_include_directive ( const std::string& line )
+{
+    /* find the hash, which may only be preceded by whitespace */
+    std::size_t pos = line.find_first_not_of ( " \t" );
+    if ( pos == std::string::npos || line.at ( pos ) != '#' ) return {};
+
+    /* find the directive name, which may be separated from the hash by whitespace */
+    pos = line.find_first_not_of ( " \t", pos + 1 );
+    if ( pos == std::string::npos || line.compare ( pos, 7, "include" ) != 0 ) return {};
+
+    /* find the opening quote or angle bracket, and the matching closing one */
+    pos = line.find_first_not_of ( " \t", pos + 7 );
+    if ( pos == std::string::npos || ( line.at ( pos ) != '"' && line.at ( pos ) != '<' ) ) return {};
+    const std::size_t end = line.find ( line.at ( pos ) == '"' ? '"' : '>', pos + 1 );
+    if ( end == std::string::npos ) throw exception::shader_exception { "malformed #include directive: " + line };
+
+    /* return the path */
+    return line.substr ( pos + 1, end - pos - 1 );
+}
+
+/* is_compile_complete
+ *
+ * returns true if the result of a submitted compilation can be checked without blocking
+ * always true if no compilation is pending, or if parallel shader compile is not supported
+ */
+bool glh::core::shader::is_compile_complete () const
+{
+    /* return true if there is nothing to wait for, or no way to ask */
+    if ( !compile_pending || !glad_loader::has_parallel_shader_compile () ) return true;
+
+    /* query the completion status */
+    GLint complete;
+    glGetShaderiv ( id, GL_COMPLETION_STATUS_KHR, &complete );
+    return complete;
 }
 
 
@@ -153,6 +395,7 @@ void glh::core::shader::compile ()
  */
 glh::core::uniform::uniform ( const std::string& _name, program& _prog )
     : name { _name }
+    , name_hash { hash_uniform_name ( _name.data (), _name.size () ) }
     , prog { _prog }
     , location { _prog.get_uniform_location ( _name ) }
     , index { _prog.get_uniform_index ( _name ) }
@@ -191,16 +434,19 @@ void glh::core::uniform::set_int ( const GLint v0 )
     /* apply the uniform */
     if ( block_index == -1 ) 
     {
+        /* skip the call if the value is unchanged since it was last set in this program */
+        if ( !prog.update_uniform_shadow ( location, &v0, sizeof ( v0 ) ) ) { ++num_skipped_uniform_calls; return; }
         prog.bind ();
         glUniform1i ( location, v0 );
+        ++num_uniform_calls;
     } else
     {   
-        /* get ubo for bind point and throw if anything goes wrong, then set the value */
+        /* get ubo for bind point and throw if anything goes wrong, then stage the value to be flushed before the next draw */
         const int bind_index = prog.get_uniform_block_binding ( block_index );
         if ( bind_index < 0 ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without it's block being bound to an index" };
         auto bound_ubo = ubo::get_bound_ubo_index ( bind_index );
         if ( !bound_ubo ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without a ubo being associated to its block's index" };
-        bound_ubo->buffer_sub_data ( offset, sizeof ( v0 ), &v0 );
+        bound_ubo->stage_sub_data ( offset, sizeof ( v0 ), &v0 );
     }
 }
 void glh::core::uniform::set_uint ( const GLuint v0 )
@@ -208,7 +454,7 @@ void glh::core::uniform::set_uint ( const GLuint v0 )
     /* check that the type is correct */
     if 
     ( 
-        uniform_type != GL_INT && uniform_type && uniform_type != GL_BOOL &&
+        uniform_type != GL_INT && uniform_type != GL_UNSIGNED_INT && uniform_type && uniform_type != GL_BOOL &&
         uniform_type != GL_SAMPLER_1D && uniform_type != GL_SAMPLER_2D && uniform_type != GL_SAMPLER_3D && uniform_type != GL_SAMPLER_CUBE &&
         uniform_type != GL_SAMPLER_1D_SHADOW && uniform_type != GL_SAMPLER_2D_SHADOW && uniform_type != GL_SAMPLER_CUBE_SHADOW &&
         uniform_type != GL_SAMPLER_1D_ARRAY && uniform_type != GL_SAMPLER_2D_ARRAY && uniform_type != GL_SAMPLER_CUBE_MAP_ARRAY && 
@@ -228,16 +474,19 @@ void glh::core::uniform::set_uint ( const GLuint v0 )
     /* apply the uniform */
     if ( block_index == -1 ) 
     {
+        /* skip the call if the value is unchanged since it was last set in this program */
+        if ( !prog.update_uniform_shadow ( location, &v0, sizeof ( v0 ) ) ) { ++num_skipped_uniform_calls; return; }
         prog.bind ();
         glUniform1ui ( location, v0 );
+        ++num_uniform_calls;
     } else
     {   
-        /* get ubo for bind point and throw if anything goes wrong, then set the value */
+        /* get ubo for bind point and throw if anything goes wrong, then stage the value to be flushed before the next draw */
         const int bind_index = prog.get_uniform_block_binding ( block_index );
         if ( bind_index < 0 ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without it's block being bound to an index" };
         auto bound_ubo = ubo::get_bound_ubo_index ( bind_index );
         if ( !bound_ubo ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without a ubo being associated to its block's index" };
-        bound_ubo->buffer_sub_data ( offset, sizeof ( v0 ), &v0 );
+        bound_ubo->stage_sub_data ( offset, sizeof ( v0 ), &v0 );
     }
 }
 void glh::core::uniform::set_float ( const GLfloat v0 )
@@ -249,16 +498,19 @@ void glh::core::uniform::set_float ( const GLfloat v0 )
     /* apply the uniform */
     if ( block_index == -1 ) 
     {
+        /* skip the call if the value is unchanged since it was last set in this program */
+        if ( !prog.update_uniform_shadow ( location, &v0, sizeof ( v0 ) ) ) { ++num_skipped_uniform_calls; return; }
         prog.bind ();
         glUniform1f ( location, v0 );
+        ++num_uniform_calls;
     } else
     {   
-        /* get ubo for bind point and throw if anything goes wrong, then set the value */
+        /* get ubo for bind point and throw if anything goes wrong, then stage the value to be flushed before the next draw */
         const int bind_index = prog.get_uniform_block_binding ( block_index );
         if ( bind_index < 0 ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without it's block being bound to an index" };
         auto bound_ubo = ubo::get_bound_ubo_index ( bind_index );
         if ( !bound_ubo ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without a ubo being associated to its block's index" };
-        bound_ubo->buffer_sub_data ( offset, sizeof ( v0 ), &v0 );
+        bound_ubo->stage_sub_data ( offset, sizeof ( v0 ), &v0 );
     }
 }
 void glh::core::uniform::set_vector ( const math::fvec2& v0 )
@@ -270,16 +522,19 @@ void glh::core::uniform::set_vector ( const math::fvec2& v0 )
     /* apply the uniform */
     if ( block_index == -1 ) 
     {
+        /* skip the call if the value is unchanged since it was last set in this program */
+        if ( !prog.update_uniform_shadow ( location, v0.internal_ptr (), sizeof ( v0 ) ) ) { ++num_skipped_uniform_calls; return; }
         prog.bind ();
         glUniform2f ( location, v0.at ( 0 ), v0.at ( 1 ) );
+        ++num_uniform_calls;
     } else
     {   
-        /* get ubo for bind point and throw if anything goes wrong, then set the value */
+        /* get ubo for bind point and throw if anything goes wrong, then stage the value to be flushed before the next draw */
         const int bind_index = prog.get_uniform_block_binding ( block_index );
         if ( bind_index < 0 ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without it's block being bound to an index" };
         auto bound_ubo = ubo::get_bound_ubo_index ( bind_index );
         if ( !bound_ubo ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without a ubo being associated to its block's index" };
-        bound_ubo->buffer_sub_data ( offset, sizeof ( v0 ), v0.internal_ptr () );
+        bound_ubo->stage_sub_data ( offset, sizeof ( v0 ), v0.internal_ptr () );
     }
     
 }
@@ -292,16 +547,19 @@ void glh::core::uniform::set_vector ( const math::fvec3& v0 )
     /* apply the uniform */
     if ( block_index == -1 ) 
     {
+        /* skip the call if the value is unchanged since it was last set in this program */
+        if ( !prog.update_uniform_shadow ( location, v0.internal_ptr (), sizeof ( v0 ) ) ) { ++num_skipped_uniform_calls; return; }
         prog.bind ();
         glUniform3f ( location, v0.at ( 0 ), v0.at ( 1 ), v0.at ( 2 ) );
+        ++num_uniform_calls;
     } else
     {   
-        /* get ubo for bind point and throw if anything goes wrong, then set the value */
+        /* get ubo for bind point and throw if anything goes wrong, then stage the value to be flushed before the next draw */
         const int bind_index = prog.get_uniform_block_binding ( block_index );
         if ( bind_index < 0 ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without it's block being bound to an index" };
         auto bound_ubo = ubo::get_bound_ubo_index ( bind_index );
         if ( !bound_ubo ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without a ubo being associated to its block's index" };
-        bound_ubo->buffer_sub_data ( offset, sizeof ( v0 ), v0.internal_ptr () );
+        bound_ubo->stage_sub_data ( offset, sizeof ( v0 ), v0.internal_ptr () );
     }
 }
 void glh::core::uniform::set_vector ( const math::fvec4& v0 )
@@ -313,16 +571,19 @@ void glh::core::uniform::set_vector ( const math::fvec4& v0 )
     /* apply the uniform */
     if ( block_index == -1 ) 
     {
+        /* skip the call if the value is unchanged since it was last set in this program */
+        if ( !prog.update_uniform_shadow ( location, v0.internal_ptr (), sizeof ( v0 ) ) ) { ++num_skipped_uniform_calls; return; }
         prog.bind ();
         glUniform4f ( location, v0.at ( 0 ), v0.at ( 1 ), v0.at ( 2 ), v0.at ( 3 ) );
+        ++num_uniform_calls;
     } else
     {   
-        /* get ubo for bind point and throw if anything goes wrong, then set the value */
+        /* get ubo for bind point and throw if anything goes wrong, then stage the value to be flushed before the next draw */
         const int bind_index = prog.get_uniform_block_binding ( block_index );
         if ( bind_index < 0 ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without it's block being bound to an index" };
         auto bound_ubo = ubo::get_bound_ubo_index ( bind_index );
         if ( !bound_ubo ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without a ubo being associated to its block's index" };
-        bound_ubo->buffer_sub_data ( offset, sizeof ( v0 ), v0.internal_ptr () );
+        bound_ubo->stage_sub_data ( offset, sizeof ( v0 ), v0.internal_ptr () );
     }
 }
 void glh::core::uniform::set_matrix ( const math::fmat2& v0 )
@@ -334,18 +595,21 @@ void glh::core::uniform::set_matrix ( const math::fmat2& v0 )
     /* apply the uniform */
     if ( block_index == -1 ) 
     {
+        /* skip the call if the value is unchanged since it was last set in this program */
+        if ( !prog.update_uniform_shadow ( location, v0.internal_ptr (), sizeof ( v0 ) ) ) { ++num_skipped_uniform_calls; return; }
         prog.bind ();
         glUniformMatrix2fv ( location, 1, GL_FALSE, v0.internal_ptr () );
+        ++num_uniform_calls;
     } else
     {   
         /* convert to uniform-aligned matrix */
         math::ua_fmat2 ua_v0 { v0 };
-        /* get ubo for bind point and throw if anything goes wrong, then set the value */
+        /* get ubo for bind point and throw if anything goes wrong, then stage the value to be flushed before the next draw */
         const int bind_index = prog.get_uniform_block_binding ( block_index );
         if ( bind_index < 0 ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without it's block being bound to an index" };
         auto bound_ubo = ubo::get_bound_ubo_index ( bind_index );
         if ( !bound_ubo ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without a ubo being associated to its block's index" };
-        bound_ubo->buffer_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
+        bound_ubo->stage_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
     }
 }
 void glh::core::uniform::set_matrix ( const math::fmat2x3& v0 )
@@ -357,18 +621,21 @@ void glh::core::uniform::set_matrix ( const math::fmat2x3& v0 )
     /* apply the uniform */
     if ( block_index == -1 ) 
     {
+        /* skip the call if the value is unchanged since it was last set in this program */
+        if ( !prog.update_uniform_shadow ( location, v0.internal_ptr (), sizeof ( v0 ) ) ) { ++num_skipped_uniform_calls; return; }
         prog.bind ();
         glUniformMatrix2x3fv ( location, 1, GL_FALSE, v0.internal_ptr () );
+        ++num_uniform_calls;
     } else
     {   
         /* convert to uniform-aligned matrix */
         math::ua_fmat2x3 ua_v0 { v0 };
-        /* get ubo for bind point and throw if anything goes wrong, then set the value */
+        /* get ubo for bind point and throw if anything goes wrong, then stage the value to be flushed before the next draw */
         const int bind_index = prog.get_uniform_block_binding ( block_index );
         if ( bind_index < 0 ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without it's block being bound to an index" };
         auto bound_ubo = ubo::get_bound_ubo_index ( bind_index );
         if ( !bound_ubo ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without a ubo being associated to its block's index" };
-        bound_ubo->buffer_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
+        bound_ubo->stage_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
     }
 }
 void glh::core::uniform::set_matrix ( const math::fmat2x4& v0 )
@@ -380,18 +647,21 @@ void glh::core::uniform::set_matrix ( const math::fmat2x4& v0 )
     /* apply the uniform */
     if ( block_index == -1 ) 
     {
+        /* skip the call if the value is unchanged since it was last set in this program */
+        if ( !prog.update_uniform_shadow ( location, v0.internal_ptr (), sizeof ( v0 ) ) ) { ++num_skipped_uniform_calls; return; }
         prog.bind ();
         glUniformMatrix2x4fv ( location, 1, GL_FALSE, v0.internal_ptr () );
+        ++num_uniform_calls;
     } else
     {   
         /* convert to uniform-aligned matrix */
         math::ua_fmat2x4 ua_v0 { v0 };
-        /* get ubo for bind point and throw if anything goes wrong, then set the value */
+        /* get ubo for bind point and throw if anything goes wrong, then stage the value to be flushed before the next draw */
         const int bind_index = prog.get_uniform_block_binding ( block_index );
         if ( bind_index < 0 ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without it's block being bound to an index" };
         auto bound_ubo = ubo::get_bound_ubo_index ( bind_index );
         if ( !bound_ubo ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without a ubo being associated to its block's index" };
-        bound_ubo->buffer_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
+        bound_ubo->stage_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
     }
 }
 void glh::core::uniform::set_matrix ( const math::fmat3x2& v0 )
@@ -403,18 +673,21 @@ void glh::core::uniform::set_matrix ( const math::fmat3x2& v0 )
     /* apply the uniform */
     if ( block_index == -1 ) 
     {
+        /* skip the call if the value is unchanged since it was last set in this program */
+        if ( !prog.update_uniform_shadow ( location, v0.internal_ptr (), sizeof ( v0 ) ) ) { ++num_skipped_uniform_calls; return; }
         prog.bind ();
         glUniformMatrix3x2fv ( location, 1, GL_FALSE, v0.internal_ptr () );
+        ++num_uniform_calls;
     } else
     {   
         /* convert to uniform-aligned matrix */
         math::ua_fmat3x2 ua_v0 { v0 };
-        /* get ubo for bind point and throw if anything goes wrong, then set the value */
+        /* get ubo for bind point and throw if anything goes wrong, then stage the value to be flushed before the next draw */
         const int bind_index = prog.get_uniform_block_binding ( block_index );
         if ( bind_index < 0 ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without it's block being bound to an index" };
         auto bound_ubo = ubo::get_bound_ubo_index ( bind_index );
         if ( !bound_ubo ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without a ubo being associated to its block's index" };
-        bound_ubo->buffer_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
+        bound_ubo->stage_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
     }
 }
 void glh::core::uniform::set_matrix ( const math::fmat3& v0 )
@@ -426,18 +699,21 @@ void glh::core::uniform::set_matrix ( const math::fmat3& v0 )
     /* apply the uniform */
     if ( block_index == -1 ) 
     {
+        /* skip the call if the value is unchanged since it was last set in this program */
+        if ( !prog.update_uniform_shadow ( location, v0.internal_ptr (), sizeof ( v0 ) ) ) { ++num_skipped_uniform_calls; return; }
         prog.bind ();
         glUniformMatrix3fv ( location, 1, GL_FALSE, v0.internal_ptr () );
+        ++num_uniform_calls;
     } else
     {   
         /* convert to uniform-aligned matrix */
         math::ua_fmat3 ua_v0 { v0 };
-        /* get ubo for bind point and throw if anything goes wrong, then set the value */
+        /* get ubo for bind point and throw if anything goes wrong, then stage the value to be flushed before the next draw */
         const int bind_index = prog.get_uniform_block_binding ( block_index );
         if ( bind_index < 0 ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without it's block being bound to an index" };
         auto bound_ubo = ubo::get_bound_ubo_index ( bind_index );
         if ( !bound_ubo ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without a ubo being associated to its block's index" };
-        bound_ubo->buffer_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
+        bound_ubo->stage_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
     }
 }
 void glh::core::uniform::set_matrix ( const math::fmat3x4& v0 )
@@ -449,18 +725,21 @@ void glh::core::uniform::set_matrix ( const math::fmat3x4& v0 )
     /* apply the uniform */
     if ( block_index == -1 ) 
     {
+        /* skip the call if the value is unchanged since it was last set in this program */
+        if ( !prog.update_uniform_shadow ( location, v0.internal_ptr (), sizeof ( v0 ) ) ) { ++num_skipped_uniform_calls; return; }
         prog.bind ();
         glUniformMatrix3x4fv ( location, 1, GL_FALSE, v0.internal_ptr () );
+        ++num_uniform_calls;
     } else
     {   
         /* convert to uniform-aligned matrix */
         math::ua_fmat3x4 ua_v0 { v0 };
-        /* get ubo for bind point and throw if anything goes wrong, then set the value */
+        /* get ubo for bind point and throw if anything goes wrong, then stage the value to be flushed before the next draw */
         const int bind_index = prog.get_uniform_block_binding ( block_index );
         if ( bind_index < 0 ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without it's block being bound to an index" };
         auto bound_ubo = ubo::get_bound_ubo_index ( bind_index );
         if ( !bound_ubo ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without a ubo being associated to its block's index" };
-        bound_ubo->buffer_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
+        bound_ubo->stage_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
     }
 }
 void glh::core::uniform::set_matrix ( const math::fmat4x2& v0 )
@@ -472,18 +751,21 @@ void glh::core::uniform::set_matrix ( const math::fmat4x2& v0 )
     /* apply the uniform */
     if ( block_index == -1 ) 
     {
+        /* skip the call if the value is unchanged since it was last set in this program */
+        if ( !prog.update_uniform_shadow ( location, v0.internal_ptr (), sizeof ( v0 ) ) ) { ++num_skipped_uniform_calls; return; }
         prog.bind ();
         glUniformMatrix4x2fv ( location, 1, GL_FALSE, v0.internal_ptr () );
+        ++num_uniform_calls;
     } else
     {   
         /* convert to uniform-aligned matrix */
         math::ua_fmat4x2 ua_v0 { v0 };
-        /* get ubo for bind point and throw if anything goes wrong, then set the value */
+        /* get ubo for bind point and throw if anything goes wrong, then stage the value to be flushed before the next draw */
         const int bind_index = prog.get_uniform_block_binding ( block_index );
         if ( bind_index < 0 ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without it's block being bound to an index" };
         auto bound_ubo = ubo::get_bound_ubo_index ( bind_index );
         if ( !bound_ubo ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without a ubo being associated to its block's index" };
-        bound_ubo->buffer_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
+        bound_ubo->stage_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
     }
 }
 void glh::core::uniform::set_matrix ( const math::fmat4x3& v0 )
@@ -495,18 +777,21 @@ void glh::core::uniform::set_matrix ( const math::fmat4x3& v0 )
     /* apply the uniform */
     if ( block_index == -1 ) 
     {
+        /* skip the call if the value is unchanged since it was last set in this program */
+        if ( !prog.update_uniform_shadow ( location, v0.internal_ptr (), sizeof ( v0 ) ) ) { ++num_skipped_uniform_calls; return; }
         prog.bind ();
         glUniformMatrix4x3fv ( location, 1, GL_FALSE, v0.internal_ptr () );
+        ++num_uniform_calls;
     } else
     {   
         /* convert to uniform-aligned matrix */
         math::ua_fmat4x3 ua_v0 { v0 };
-        /* get ubo for bind point and throw if anything goes wrong, then set the value */
+        /* get ubo for bind point and throw if anything goes wrong, then stage the value to be flushed before the next draw */
         const int bind_index = prog.get_uniform_block_binding ( block_index );
         if ( bind_index < 0 ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without it's block being bound to an index" };
         auto bound_ubo = ubo::get_bound_ubo_index ( bind_index );
         if ( !bound_ubo ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without a ubo being associated to its block's index" };
-        bound_ubo->buffer_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
+        bound_ubo->stage_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
     }
 }
 void glh::core::uniform::set_matrix ( const math::fmat4& v0 )
@@ -518,18 +803,21 @@ void glh::core::uniform::set_matrix ( const math::fmat4& v0 )
     /* apply the uniform */
     if ( block_index == -1 ) 
     {
+        /* skip the call if the value is unchanged since it was last set in this program */
+        if ( !prog.update_uniform_shadow ( location, v0.internal_ptr (), sizeof ( v0 ) ) ) { ++num_skipped_uniform_calls; return; }
         prog.bind ();
         glUniformMatrix4fv ( location, 1, GL_FALSE, v0.internal_ptr () );
+        ++num_uniform_calls;
     } else
     {   
         /* convert to uniform-aligned matrix */
         math::ua_fmat4 ua_v0 { v0 };
-        /* get ubo for bind point and throw if anything goes wrong, then set the value */
+        /* get ubo for bind point and throw if anything goes wrong, then stage the value to be flushed before the next draw */
         const int bind_index = prog.get_uniform_block_binding ( block_index );
         if ( bind_index < 0 ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without it's block being bound to an index" };
         auto bound_ubo = ubo::get_bound_ubo_index ( bind_index );
         if ( !bound_ubo ) throw exception::uniform_exception { "attempted to set value to uniform not in default block without a ubo being associated to its block's index" };
-        bound_ubo->buffer_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
+        bound_ubo->stage_sub_data ( offset, sizeof ( ua_v0 ), ua_v0.internal_ptr () );
     }
 }
 
@@ -552,6 +840,70 @@ bool glh::core::uniform::is_program_in_use () const
     return prog.is_bound ();
 }
 
+/* refresh
+ *
+ * get the location, index, offset and block index of the uniform again after the program has been relinked
+ * if the uniform is no longer active, it keeps its type but is given no location or block, so setting it does nothing
+ */
+void glh::core::uniform::refresh ()
+{
+    /* get the new location, which is negative if the uniform is no longer active or not in the default block */
+    location = prog.get_uniform_location ( name );
+
+    /* get the index, and the information which depends on it, if the uniform is still active */
+    try
+    {
+        index = prog.get_uniform_index ( name );
+        size = prog.get_active_uniform_iv ( index, GL_UNIFORM_SIZE );
+        offset = prog.get_active_uniform_iv ( index, GL_UNIFORM_OFFSET );
+        block_index = prog.get_active_uniform_iv ( index, GL_UNIFORM_BLOCK_INDEX );
+        uniform_type = prog.get_active_uniform_iv ( index, GL_UNIFORM_TYPE );
+    }
+
+    /* otherwise remove it from any block, so that nothing is staged for it */
+    catch ( const exception::uniform_exception& )
+    {
+        index = GL_INVALID_INDEX;
+        block_index = -1;
+    }
+}
+
+
+
+/* STRUCT_UNIFORM IMPLEMENTATION */
+
+/* get_uniform by id
+ *
+ * get a member of the struct through the uniform table of the program
+ * the hash of the full name is continued from the hash of the name of the struct, and the name of the struct is passed on rather than a prefix,
+ * so no strings are built unless the uniform is not yet in the table
+ */
+glh::core::uniform& glh::core::struct_uniform::get_uniform ( const uniform_id& member )
+{
+    /* continue the hash from the name of the struct, then look the uniform up in the program */
+    return prog.get_hashed_uniform ( hash_uniform_name ( member.name, member.length, member_hash_seed ), name, member );
+}
+const glh::core::uniform& glh::core::struct_uniform::get_uniform ( const uniform_id& member ) const
+{
+    /* continue the hash from the name of the struct, then look the uniform up in the program */
+    return prog.get_hashed_uniform ( hash_uniform_name ( member.name, member.length, member_hash_seed ), name, member );
+}
+
+/* refresh
+ *
+ * refresh every member extracted from the struct after the program has been relinked
+ */
+void glh::core::struct_uniform::refresh ()
+{
+    /* refresh each storage */
+    uniforms.refresh ();
+    struct_uniforms.refresh ();
+    uniform_array_uniforms.refresh ();
+    struct_array_uniforms.refresh ();
+    uniform_2d_array_uniforms.refresh ();
+    struct_2d_array_uniforms.refresh ();
+}
+
 
 
 /* PROGRAM IMPLEMENTATION */
@@ -563,7 +915,10 @@ bool glh::core::uniform::is_program_in_use () const
  */
 glh::core::program::program ( vshader& vs, gshader& gs, fshader& fs )
     : vertex_shader { vs }, geometry_shader { gs }, fragment_shader { fs }
-    , has_geometry_shader { true }
+    , has_geometry_shader { true }, has_compute_shader { false }
+    , loaded_from_binary_cache { false }
+    , linked { false }, link_pending { false }, binary_cache_save_pending { false }, relink_id { 0 }
+    , uniform_table_count { 0 }, num_uniform_table_misses { 0 }
     , uniforms { "", * this }, struct_uniforms { "", * this }
     , uniform_array_uniforms { "", * this }, struct_array_uniforms { "", * this }
     , uniform_2d_array_uniforms { "", * this }, struct_2d_array_uniforms { "", * this }
@@ -583,7 +938,10 @@ glh::core::program::program ( vshader& vs, gshader& gs, fshader& fs )
  */
 glh::core::program::program ( vshader& vs, fshader& fs )
     : vertex_shader { vs }, fragment_shader { fs }
-    , has_geometry_shader { false }
+    , has_geometry_shader { false }, has_compute_shader { false }
+    , loaded_from_binary_cache { false }
+    , linked { false }, link_pending { false }, binary_cache_save_pending { false }, relink_id { 0 }
+    , uniform_table_count { 0 }, num_uniform_table_misses { 0 }
     , uniforms { "", * this }, struct_uniforms { "", * this }
     , uniform_array_uniforms { "", * this }, struct_array_uniforms { "", * this }
     , uniform_2d_array_uniforms { "", * this }, struct_2d_array_uniforms { "", * this }
@@ -595,11 +953,35 @@ glh::core::program::program ( vshader& vs, fshader& fs )
     if ( !vs.is_object_valid () || !fs.is_object_valid () ) throw exception::shader_exception { "cannot create shader program from invalid shaders" };
 }
 
+/* compute shader constructor
+ *
+ * link a compute shader into a program
+ * only used by compute_program, so that every compute program has that type
+ * NOTE: the shader program remains valid even when linked shaders are destroyed
+ */
+glh::core::program::program ( cshader& cs )
+    : compute_shader { cs }
+    , has_geometry_shader { false }, has_compute_shader { true }
+    , loaded_from_binary_cache { false }
+    , linked { false }, link_pending { false }, binary_cache_save_pending { false }, relink_id { 0 }
+    , uniform_table_count { 0 }, num_uniform_table_misses { 0 }
+    , uniforms { "", * this }, struct_uniforms { "", * this }
+    , uniform_array_uniforms { "", * this }, struct_array_uniforms { "", * this }
+    , uniform_2d_array_uniforms { "", * this }, struct_2d_array_uniforms { "", * this }
+{
+    /* generate program */
+    id = glCreateProgram ();
+
+    /* check shader is valid */
+    if ( !cs.is_object_valid () ) throw exception::shader_exception { "cannot create shader program from invalid shaders" };
+}
+
 /* destructor */
 glh::core::program::~program ()
 {
-    /* destroy program */
+    /* destroy program, and any pending relink */
     glDeleteProgram ( id );
+    if ( relink_id ) glDeleteProgram ( relink_id );
 }
 
 
@@ -609,7 +991,7 @@ bool glh::core::program::bind () const
 {
     /* if bound, return false, else bind and return true */
     if ( bound_program == this ) return false;
-    glUseProgram ( id );
+    renderer::use_program ( id );
     bound_program = const_cast<program *> ( this );
     return true;
 }
@@ -619,22 +1001,56 @@ bool glh::core::program::bind () const
 /* link
  *
  * link the shader program
- * will throw if any of the shaders are not already compiled
+ * will throw if any of the shaders are neither compiled nor pending compilation
  */
 void glh::core::program::link ()
 {
-    /* check that the shaders are valid and compiled */
-    if ( !vertex_shader->is_compiled () || ( has_geometry_shader && !geometry_shader->is_compiled () ) || !fragment_shader->is_compiled () )
+    /* submit the link then wait for it */
+    link_async ();
+    finish_link ();
+}
+
+/* link_async
+ *
+ * submit the link of the shader program without waiting for the result
+ * will throw if any of the shaders are neither compiled nor pending compilation
+ */
+void glh::core::program::link_async ()
+{
+    /* check that the shaders are compiled or will be */
+    const std::vector<shader *> shaders = get_shaders ();
+    if ( std::any_of ( shaders.begin (), shaders.end (), [] ( const shader * s ) { return !s->is_compiled () && !s->is_compile_pending (); } ) )
         throw exception::shader_exception { "cannot link program with uncompiled shaders" };
 
     /* attach shaders */
-    glAttachShader ( id, vertex_shader->internal_id () );
-    if ( has_geometry_shader ) glAttachShader ( id, geometry_shader->internal_id () );
-    glAttachShader ( id, fragment_shader->internal_id () );
+    for ( const shader * s: shaders ) glAttachShader ( id, s->internal_id () );
+
+    /* if the binary cache is enabled, make sure the binary can be retrieved after linking */
+    if ( !binary_cache_directory.empty () ) glProgramParameteri ( id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
 
     /* link the program */
     glLinkProgram ( id );
 
+    /* the program is not linked until the result is checked */
+    linked = false;
+    link_pending = true;
+}
+
+/* finish_link
+ *
+ * check the result of a submitted link, first checking any shaders still pending compilation
+ * on success, the uniform table is resolved and the binary added to the cache if requested
+ */
+void glh::core::program::finish_link ()
+{
+    /* the link is no longer pending, whether or not it succeeds */
+    link_pending = false;
+    const bool save_binary = binary_cache_save_pending;
+    binary_cache_save_pending = false;
+
+    /* check the shaders first, so that compilation errors are reported as such rather than as link errors */
+    for ( shader * s: get_shaders () ) if ( s->is_compile_pending () ) s->compile ();
+
     /* check linking success */
     int link_success;
     glGetProgramiv ( id, GL_LINK_STATUS, &link_success );
@@ -651,6 +1067,21 @@ void glh::core::program::link ()
         /* throw exception */
         throw exception::shader_exception { "program linking failed" };
     }
+
+    /* the program was not loaded from the binary cache */
+    loaded_from_binary_cache = false;
+
+    /* linking resets the values of every uniform, so forget the shadowed values */
+    uniform_shadows.clear ();
+
+    /* resolve the active uniforms into the uniform table */
+    resolve_uniform_table ();
+
+    /* the program is now linked */
+    linked = true;
+
+    /* add the binary to the cache if requested */
+    if ( save_binary ) save_binary_cache ();
 }
 
 
@@ -661,13 +1092,267 @@ void glh::core::program::link ()
  */
 void glh::core::program::compile_and_link ()
 {
+    /* if the binary cache is enabled, try to load the program from it */
+    if ( !binary_cache_directory.empty () )
+    {
+        if ( load_binary_cache () ) { ++num_binary_cache_hits; return; }
+        ++num_binary_cache_misses;
+    }
+
     /* compile each shader */
-    vertex_shader->compile ();
-    if ( has_geometry_shader ) geometry_shader->compile ();
-    fragment_shader->compile ();
+    for ( shader * s: get_shaders () ) s->compile ();
 
     /* now link the program */
     link ();    
+
+    /* add the binary to the cache */
+    if ( !binary_cache_directory.empty () ) save_binary_cache ();
+}
+
+/* compile_and_link_async
+ *
+ * submit the compilation of the shaders and the link of the program without waiting for either
+ * shaders already pending compilation (e.g. shared with another program) are not submitted again
+ */
+void glh::core::program::compile_and_link_async ()
+{
+    /* if the binary cache is enabled, try to load the program from it */
+    if ( !binary_cache_directory.empty () )
+    {
+        if ( load_binary_cache () ) { ++num_binary_cache_hits; return; }
+        ++num_binary_cache_misses;
+    }
+
+    /* submit each shader which is not already pending */
+    for ( shader * s: get_shaders () ) if ( !s->is_compile_pending () ) s->compile_async ();
+
+    /* submit the link, adding the binary to the cache once it is finished */
+    link_async ();
+    binary_cache_save_pending = !binary_cache_directory.empty ();
+}
+
+/* is_ready
+ *
+ * returns true if the program is linked and ready to use
+ * if a link is pending and the driver reports it complete, the link is finished, throwing if it or any of the shaders failed
+ * if parallel shader compile is not supported, a pending link is finished straight away, which blocks
+ */
+bool glh::core::program::is_ready ()
+{
+    /* if no link is pending, the program is ready if it has been linked */
+    if ( !link_pending ) return linked;
+
+    /* if the driver can be asked, return false if the link is not yet complete */
+    if ( glad_loader::has_parallel_shader_compile () )
+    {
+        GLint complete;
+        glGetProgramiv ( id, GL_COMPLETION_STATUS_KHR, &complete );
+        if ( !complete ) return false;
+    }
+
+    /* finish the link */
+    finish_link ();
+    return true;
+}
+
+/* wait_until_ready
+ *
+ * finish any pending link, blocking until the driver is done
+ * throws if the link or any of the shaders failed
+ */
+void glh::core::program::wait_until_ready ()
+{
+    /* finish the link if pending */
+    if ( link_pending ) finish_link ();
+}
+
+
+
+/* relink_async
+ *
+ * submit a link of the current shader objects (e.g. after they have been recompiled) into a new program object
+ * the current program object stays in use until finish_relink
+ * throws if a relink is already pending
+ */
+void glh::core::program::relink_async ()
+{
+    /* throw if a relink is already pending */
+    if ( relink_id ) throw exception::shader_exception { "attempted to relink program while a relink is already pending" };
+
+    /* throw if any shader is not compiled, as a pending compilation is not checked by finish_relink */
+    const std::vector<shader *> shaders = get_shaders ();
+    if ( std::any_of ( shaders.begin (), shaders.end (), [] ( const shader * s ) { return !s->is_compiled (); } ) )
+        throw exception::shader_exception { "cannot relink program with uncompiled shaders" };
+
+    /* create a new program object and attach the current shader objects */
+    relink_id = glCreateProgram ();
+    for ( const shader * s: shaders ) glAttachShader ( relink_id, s->internal_id () );
+
+    /* if the binary cache is enabled, make sure the binary can be retrieved after linking */
+    if ( !binary_cache_directory.empty () ) glProgramParameteri ( relink_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+
+    /* link the new program object */
+    glLinkProgram ( relink_id );
+}
+
+/* is_relink_complete
+ *
+ * returns true if the result of a submitted relink can be checked without blocking
+ * always true if no relink is pending, or if parallel shader compile is not supported
+ */
+bool glh::core::program::is_relink_complete () const
+{
+    /* return true if there is nothing to wait for, or no way to ask */
+    if ( !relink_id || !glad_loader::has_parallel_shader_compile () ) return true;
+
+    /* query the completion status */
+    GLint complete;
+    glGetProgramiv ( relink_id, GL_COMPLETION_STATUS_KHR, &complete );
+    return complete;
+}
+
+/* finish_relink
+ *
+ * check the result of a submitted relink, blocking if it is not complete
+ * on success the new program object replaces the current one, taking its uniform values and block bindings, and every uniform is refreshed
+ * on failure the error is logged, the new object deleted and the current one kept
+ *
+ * return: true if the program was relinked successfully
+ */
+bool glh::core::program::finish_relink ()
+{
+    /* throw if no relink is pending */
+    if ( !relink_id ) throw exception::shader_exception { "attempted to finish relinking program with no relink pending" };
+
+    /* take the pending program object */
+    const GLuint new_id = relink_id;
+    relink_id = 0;
+
+    /* check linking success, keeping the current program object on failure */
+    int link_success;
+    glGetProgramiv ( new_id, GL_LINK_STATUS, &link_success );
+    if ( !link_success )
+    {
+        char link_log [ GLH_SHADER_LOG_SIZE ];
+        glGetProgramInfoLog ( new_id, GLH_SHADER_LOG_SIZE, NULL, link_log );
+        std::cerr << link_log;
+        glDeleteProgram ( new_id );
+        return false;
+    }
+
+    /* copy the values of the uniforms to the new program object */
+    copy_uniform_values ( id, new_id );
+
+    /* copy the binding of each uniform block by name, recording the bindings by the block indices of the new program object */
+    std::vector<GLint> new_block_bindings;
+    GLint num_blocks, max_block_name_length;
+    glGetProgramiv ( new_id, GL_ACTIVE_UNIFORM_BLOCKS, &num_blocks );
+    glGetProgramiv ( new_id, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &max_block_name_length );
+    std::vector<char> block_name_buffer ( std::max ( max_block_name_length, 1 ) );
+    for ( GLint i = 0; i < num_blocks; ++i )
+    {
+        glGetActiveUniformBlockName ( new_id, i, block_name_buffer.size (), NULL, block_name_buffer.data () );
+        const GLuint old_index = glGetUniformBlockIndex ( id, block_name_buffer.data () );
+        const int binding = ( old_index == GL_INVALID_INDEX ? -1 : get_uniform_block_binding ( old_index ) );
+        if ( binding < 0 ) continue;
+        glUniformBlockBinding ( new_id, i, binding );
+        if ( new_block_bindings.size () <= static_cast<unsigned> ( i ) ) new_block_bindings.resize ( i + 1, -1 );
+        new_block_bindings.at ( i ) = binding;
+    }
+
+    /* if the program is in use, use the new program object first, so that the current one is never in use when deleted */
+    if ( bound_program.get () == this ) renderer::use_program ( new_id );
+
+    /* swap in the new program object */
+    glDeleteProgram ( id );
+    id = new_id;
+
+    /* forget the locations, indices and shadowed values of the old program object */
+    uniform_locations.clear ();
+    uniform_indices.clear ();
+    uniform_block_indices.clear ();
+    uniform_block_bindings = std::move ( new_block_bindings );
+    uniform_shadows.clear ();
+
+    /* refresh every uniform in place, so that references to them stay valid, then resolve the uniform table again */
+    uniforms.refresh ();
+    struct_uniforms.refresh ();
+    uniform_array_uniforms.refresh ();
+    struct_array_uniforms.refresh ();
+    uniform_2d_array_uniforms.refresh ();
+    struct_2d_array_uniforms.refresh ();
+    resolve_uniform_table ();
+
+    /* the program is now linked */
+    loaded_from_binary_cache = false;
+    linked = true;
+
+    /* add the binary to the cache */
+    if ( !binary_cache_directory.empty () ) save_binary_cache ();
+    return true;
+}
+
+/* get_shaders
+ *
+ * get the shaders of the program: the vertex shader, the geometry shader if there is one, then the fragment shader
+ * or just the compute shader of a compute program
+ */
+std::vector<glh::core::shader *> glh::core::program::get_shaders () const
+{
+    /* a compute program only has its compute shader */
+    if ( has_compute_shader ) return std::vector<shader *> { compute_shader.get () };
+
+    /* otherwise add each shader */
+    std::vector<shader *> shaders { vertex_shader.get () };
+    if ( has_geometry_shader ) shaders.push_back ( geometry_shader.get () );
+    shaders.push_back ( fragment_shader.get () );
+    return shaders;
+}
+
+/* set_binary_cache_directory
+ *
+ * set the directory of the program binary cache, which is created if it does not exist
+ * an empty path disables the cache
+ */
+void glh::core::program::set_binary_cache_directory ( const std::string& directory )
+{
+    /* create the directory, throwing if it cannot be created */
+    std::error_code error;
+    if ( !directory.empty () ) std::filesystem::create_directories ( directory, error );
+    if ( error ) throw exception::shader_exception { "failed to create program binary cache directory " + directory };
+
+    /* set the directory */
+    binary_cache_directory = directory;
+}
+
+
+
+/* get_hashed_uniform
+ *
+ * return a uniform from the uniform table by the hash of its full name
+ * if the uniform is not in the table, it is looked up by its full name and added
+ * 
+ * hash: the hash of the full name of the uniform
+ * parent_name: the name of the struct containing the uniform, or an empty string if it is not a member of a struct
+ * member: the name of the uniform within its parent
+ * the full name is only built if the uniform is not in the table
+ */
+glh::core::uniform& glh::core::program::get_hashed_uniform ( const std::uint64_t hash, const std::string& parent_name, const uniform_id& member ) const
+{
+    /* probe the table, stopping at the first empty slot */
+    if ( !uniform_table.empty () )
+    {
+        const std::size_t mask = uniform_table.size () - 1;
+        for ( std::size_t i = hash & mask; uniform_table.at ( i ).uni; i = ( i + 1 ) & mask )
+            if ( uniform_table.at ( i ).hash == hash ) return * uniform_table.at ( i ).uni;
+    }
+
+    /* not in the table, so look the uniform up by name and add it */
+    ++num_uniform_table_misses;
+    const std::string member_name { member.name, member.length };
+    uniform& uni = const_cast<program *> ( this )->uniforms.get ( parent_name.empty () ? member_name : parent_name + "." + member_name );
+    insert_uniform_table ( hash, uni );
+    return uni;
 }
 
 
@@ -859,7 +1544,589 @@ int glh::core::program::get_uniform_block_binding ( const std::string& block_nam
     return get_uniform_block_binding ( get_uniform_block_index ( block_name ) );
 }
 
+/* update_uniform_shadow
+ *
+ * compare a value about to be written to a location in the default block with the last value written to it, and record it if it differs
+ * 
+ * location: the location of the uniform (negative locations are never shadowed)
+ * data: pointer to the value
+ * size: the size of the value in bytes
+ * 
+ * return: true if the value differs from the last value written, so must be set
+ */
+bool glh::core::program::update_uniform_shadow ( const GLint location, const void * data, const unsigned size ) const
+{
+    /* inactive uniforms have no location to shadow */
+    if ( location < 0 ) return true;
+
+    /* resize the shadows if necessary */
+    if ( uniform_shadows.size () <= static_cast<unsigned> ( location ) ) uniform_shadows.resize ( location + 1 );
+
+    /* if the value is unchanged, return false */
+    std::vector<unsigned char>& shadow = uniform_shadows.at ( location );
+    const unsigned char * bytes = static_cast<const unsigned char *> ( data );
+    if ( shadow.size () == size && std::equal ( shadow.begin (), shadow.end (), bytes ) ) return false;
+
+    /* otherwise record the new value and return true */
+    shadow.assign ( bytes, bytes + size );
+    return true;
+}
+
+
+
+/* get_binary_cache_path
+ *
+ * get the path of the cached binary of the program, named by a hash of the sources of its shaders and the vendor, renderer and version of the driver
+ */
+std::string glh::core::program::get_binary_cache_path () const
+{
+    /* hash the driver strings, then the sources of the shaders, each followed by a null character so that where one ends is part of the hash */
+    std::uint64_t hash = hash_uniform_name ( "", 0 );
+    for ( const GLenum name: { GL_VENDOR, GL_RENDERER, GL_VERSION } )
+    {
+        const std::string driver_string { reinterpret_cast<const char *> ( glGetString ( name ) ) };
+        hash = hash_uniform_name ( driver_string.c_str (), driver_string.size () + 1, hash );
+    }
+    for ( const shader * s: get_shaders () ) hash = hash_uniform_name ( s->get_source ().c_str (), s->get_source ().size () + 1, hash );
+
+    /* name the file by the hash in hex */
+    std::ostringstream path;
+    path << binary_cache_directory << '/' << std::hex << std::setw ( 16 ) << std::setfill ( '0' ) << hash << ".bin";
+    return path.str ();
+}
+
+/* load_binary_cache
+ *
+ * try to load the program from its cached binary
+ * 
+ * return: true if the binary was found and accepted by the driver
+ */
+bool glh::core::program::load_binary_cache ()
+{
+    /* return if the driver supports no binary formats */
+    GLint num_formats;
+    glGetIntegerv ( GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats );
+    if ( num_formats == 0 ) return false;
+
+    /* open the file, returning if it does not exist */
+    std::ifstream binary_file { get_binary_cache_path (), std::ios::in | std::ios::binary };
+    if ( !binary_file ) return false;
+
+    /* read the format and the binary */
+    GLenum format;
+    if ( !binary_file.read ( reinterpret_cast<char *> ( &format ), sizeof ( format ) ) ) return false;
+    const std::vector<char> binary { std::istreambuf_iterator<char> ( binary_file ), std::istreambuf_iterator<char> () };
+    if ( binary.empty () ) return false;
+
+    /* give the binary to the driver, returning if it is rejected (e.g. if the driver has been updated) */
+    glProgramBinary ( id, format, binary.data (), binary.size () );
+    GLint link_success;
+    glGetProgramiv ( id, GL_LINK_STATUS, &link_success );
+    if ( !link_success ) return false;
+
+    /* the program was loaded from the binary cache, and is linked */
+    loaded_from_binary_cache = true;
+    linked = true;
+
+    /* loading a binary resets the values of every uniform, as linking does, so forget the shadowed values and resolve the uniform table */
+    uniform_shadows.clear ();
+    resolve_uniform_table ();
+    return true;
+}
+
+/* save_binary_cache
+ *
+ * write the binary of the linked program to the cache
+ * failing to write the binary is not an error, as the program will just be compiled again next time
+ */
+void glh::core::program::save_binary_cache () const
+{
+    /* get the binary, returning if there is none */
+    GLint length;
+    glGetProgramiv ( id, GL_PROGRAM_BINARY_LENGTH, &length );
+    if ( length <= 0 ) return;
+    std::vector<char> binary ( length );
+    GLenum format;
+    glGetProgramBinary ( id, length, NULL, &format, binary.data () );
+
+    /* write the format and the binary */
+    std::ofstream binary_file { get_binary_cache_path (), std::ios::out | std::ios::binary | std::ios::trunc };
+    binary_file.write ( reinterpret_cast<const char *> ( &format ), sizeof ( format ) );
+    binary_file.write ( binary.data (), binary.size () );
+}
+
+/* copy_uniform_values
+ *
+ * copy the value of every default block uniform of one program object to the uniform of the same name and type in another
+ * uniforms which are not active in both objects are skipped
+ *
+ * from_id/to_id: the program objects to copy from and to
+ */
+void glh::core::program::copy_uniform_values ( const GLuint from_id, const GLuint to_id )
+{
+    /* get the number of active uniforms and the length of the longest name */
+    GLint num_uniforms, max_name_length;
+    glGetProgramiv ( to_id, GL_ACTIVE_UNIFORMS, &num_uniforms );
+    glGetProgramiv ( to_id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length );
+    std::vector<char> name_buffer ( std::max ( max_name_length, 1 ) );
+
+    /* copy each active uniform */
+    for ( GLint i = 0; i < num_uniforms; ++i )
+    {
+        /* get the name, array size and type of the uniform */
+        GLsizei name_length;
+        GLint size;
+        GLenum type;
+        glGetActiveUniform ( to_id, i, name_buffer.size (), &name_length, &size, &type, name_buffer.data () );
+        const std::string name { name_buffer.data (), static_cast<std::size_t> ( name_length ) };
+
+        /* skip the uniform unless it has the same type in the other program object */
+        const GLuint from_index = glGetProgramResourceIndex ( from_id, GL_UNIFORM, name.c_str () );
+        if ( from_index == GL_INVALID_INDEX ) continue;
+        const GLenum type_property = GL_TYPE;
+        GLint from_type;
+        glGetProgramResourceiv ( from_id, GL_UNIFORM, from_index, 1, &type_property, 1, NULL, &from_type );
+        if ( static_cast<GLenum> ( from_type ) != type ) continue;
+
+        /* copy each element of arrays, or just the uniform otherwise, skipping any without a location in both objects (e.g. block members) */
+        const bool is_array = ( name.size () >= 3 && name.compare ( name.size () - 3, 3, "[0]" ) == 0 );
+        for ( GLint j = 0; j < size; ++j )
+        {
+            const std::string element_name = ( is_array ? name.substr ( 0, name.size () - 3 ) + "[" + std::to_string ( j ) + "]" : name );
+            const GLint from_location = glGetUniformLocation ( from_id, element_name.c_str () );
+            const GLint to_location = glGetUniformLocation ( to_id, element_name.c_str () );
+            if ( from_location < 0 || to_location < 0 ) continue;
+
+            /* read the value with the function for its component type, then write it with the function for its exact type */
+            GLfloat f [ 16 ]; GLdouble d [ 4 ]; GLint v [ 4 ]; GLuint u [ 4 ];
+            switch ( type )
+            {
+                case GL_FLOAT: glGetUniformfv ( from_id, from_location, f ); glProgramUniform1fv ( to_id, to_location, 1, f ); break;
+                case GL_FLOAT_VEC2: glGetUniformfv ( from_id, from_location, f ); glProgramUniform2fv ( to_id, to_location, 1, f ); break;
+                case GL_FLOAT_VEC3: glGetUniformfv ( from_id, from_location, f ); glProgramUniform3fv ( to_id, to_location, 1, f ); break;
+                case GL_FLOAT_VEC4: glGetUniformfv ( from_id, from_location, f ); glProgramUniform4fv ( to_id, to_location, 1, f ); break;
+                case GL_FLOAT_MAT2: glGetUniformfv ( from_id, from_location, f ); glProgramUniformMatrix2fv ( to_id, to_location, 1, GL_FALSE, f ); break;
+                case GL_FLOAT_MAT3: glGetUniformfv ( from_id, from_location, f ); glProgramUniformMatrix3fv ( to_id, to_location, 1, GL_FALSE, f ); break;
+                case GL_FLOAT_MAT4: glGetUniformfv ( from_id, from_location, f ); glProgramUniformMatrix4fv ( to_id, to_location, 1, GL_FALSE, f ); break;
+                case GL_FLOAT_MAT2x3: glGetUniformfv ( from_id, from_location, f ); glProgramUniformMatrix2x3fv ( to_id, to_location, 1, GL_FALSE, f ); break;
+                case GL_FLOAT_MAT2x4: glGetUniformfv ( from_id, from_location, f ); glProgramUniformMatrix2x4fv ( to_id, to_location, 1, GL_FALSE, f ); break;
+                case GL_FLOAT_MAT3x2: glGetUniformfv ( from_id, from_location, f ); glProgramUniformMatrix3x2fv ( to_id, to_location, 1, GL_FALSE, f ); break;
+                case GL_FLOAT_MAT3x4: glGetUniformfv ( from_id, from_location, f ); glProgramUniformMatrix3x4fv ( to_id, to_location, 1, GL_FALSE, f ); break;
+                case GL_FLOAT_MAT4x2: glGetUniformfv ( from_id, from_location, f ); glProgramUniformMatrix4x2fv ( to_id, to_location, 1, GL_FALSE, f ); break;
+                case GL_FLOAT_MAT4x3: glGetUniformfv ( from_id, from_location, f ); glProgramUniformMatrix4x3fv ( to_id, to_location, 1, GL_FALSE, f ); break;
+                case GL_DOUBLE: glGetUniformdv ( from_id, from_location, d ); glProgramUniform1dv ( to_id, to_location, 1, d ); break;
+                case GL_DOUBLE_VEC2: glGetUniformdv ( from_id, from_location, d ); glProgramUniform2dv ( to_id, to_location, 1, d ); break;
+                case GL_DOUBLE_VEC3: glGetUniformdv ( from_id, from_location, d ); glProgramUniform3dv ( to_id, to_location, 1, d ); break;
+                case GL_DOUBLE_VEC4: glGetUniformdv ( from_id, from_location, d ); glProgramUniform4dv ( to_id, to_location, 1, d ); break;
+                case GL_UNSIGNED_INT: glGetUniformuiv ( from_id, from_location, u ); glProgramUniform1uiv ( to_id, to_location, 1, u ); break;
+                case GL_UNSIGNED_INT_VEC2: glGetUniformuiv ( from_id, from_location, u ); glProgramUniform2uiv ( to_id, to_location, 1, u ); break;
+                case GL_UNSIGNED_INT_VEC3: glGetUniformuiv ( from_id, from_location, u ); glProgramUniform3uiv ( to_id, to_location, 1, u ); break;
+                case GL_UNSIGNED_INT_VEC4: glGetUniformuiv ( from_id, from_location, u ); glProgramUniform4uiv ( to_id, to_location, 1, u ); break;
+                case GL_INT_VEC2: case GL_BOOL_VEC2: glGetUniformiv ( from_id, from_location, v ); glProgramUniform2iv ( to_id, to_location, 1, v ); break;
+                case GL_INT_VEC3: case GL_BOOL_VEC3: glGetUniformiv ( from_id, from_location, v ); glProgramUniform3iv ( to_id, to_location, 1, v ); break;
+                case GL_INT_VEC4: case GL_BOOL_VEC4: glGetUniformiv ( from_id, from_location, v ); glProgramUniform4iv ( to_id, to_location, 1, v ); break;
+
+                /* double matrices are not used by the library, so are not copied */
+                case GL_DOUBLE_MAT2: case GL_DOUBLE_MAT3: case GL_DOUBLE_MAT4: case GL_DOUBLE_MAT2x3: case GL_DOUBLE_MAT2x4:
+                case GL_DOUBLE_MAT3x2: case GL_DOUBLE_MAT3x4: case GL_DOUBLE_MAT4x2: case GL_DOUBLE_MAT4x3: break;
+
+                /* anything else is a single integer: int and bool, or an opaque type such as a sampler, whose value is its texture unit */
+                default: glGetUniformiv ( from_id, from_location, v ); glProgramUniform1iv ( to_id, to_location, 1, v ); break;
+            }
+        }
+    }
+}
+
+
+
+/* resolve_uniform_table
+ *
+ * fill the uniform table with every active uniform of the program, once linked
+ */
+void glh::core::program::resolve_uniform_table ()
+{
+    /* empty the table */
+    uniform_table.clear ();
+    uniform_table_count = 0;
+
+    /* get the number of active uniforms and the length of the longest name */
+    GLint num_uniforms, max_name_length;
+    glGetProgramiv ( id, GL_ACTIVE_UNIFORMS, &num_uniforms );
+    glGetProgramiv ( id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length );
+    std::vector<char> name_buffer ( std::max ( max_name_length, 1 ) );
+
+    /* add each active uniform */
+    for ( GLint i = 0; i < num_uniforms; ++i )
+    {
+        /* get the name and array size of the uniform */
+        GLsizei name_length;
+        glGetActiveUniformName ( id, i, name_buffer.size (), &name_length, name_buffer.data () );
+        const std::string name { name_buffer.data (), static_cast<std::size_t> ( name_length ) };
+        GLint size;
+        glGetActiveUniformsiv ( id, 1, reinterpret_cast<const GLuint *> ( &i ), GL_UNIFORM_SIZE, &size );
+
+        /* if the uniform is not an array, add it by its name */
+        if ( name.size () < 3 || name.compare ( name.size () - 3, 3, "[0]" ) != 0 ) insert_uniform_table ( hash_uniform_name ( name.data (), name.size () ), uniforms.get ( name ) );
+
+        /* otherwise add each element of the array */
+        else for ( GLint j = 0; j < size; ++j )
+        {
+            const std::string element_name = name.substr ( 0, name.size () - 3 ) + "[" + std::to_string ( j ) + "]";
+            insert_uniform_table ( hash_uniform_name ( element_name.data (), element_name.size () ), uniforms.get ( element_name ) );
+        }
+    }
+}
+
+/* insert_uniform_table
+ *
+ * add a uniform to the uniform table, growing the table if it would become more than half full
+ * throws if a different uniform with the same hash is already in the table
+ * 
+ * hash: the hash of the name of the uniform
+ * uni: the uniform to add
+ */
+void glh::core::program::insert_uniform_table ( const std::uint64_t hash, uniform& uni ) const
+{
+    /* if the table would become more than half full, double its size and reinsert the existing slots */
+    if ( ( uniform_table_count + 1 ) * 2 > uniform_table.size () )
+    {
+        std::vector<uniform_table_slot> old_table { std::max<std::size_t> ( uniform_table.size () * 2, 16 ), uniform_table_slot { 0, NULL } };
+        old_table.swap ( uniform_table );
+        const std::size_t mask = uniform_table.size () - 1;
+        for ( const uniform_table_slot& slot: old_table ) if ( slot.uni )
+        {
+            std::size_t i = slot.hash & mask;
+            while ( uniform_table.at ( i ).uni ) i = ( i + 1 ) & mask;
+            uniform_table.at ( i ) = slot;
+        }
+    }
+
+    /* probe for the uniform or an empty slot */
+    const std::size_t mask = uniform_table.size () - 1;
+    std::size_t i = hash & mask;
+    for ( ; uniform_table.at ( i ).uni; i = ( i + 1 ) & mask ) if ( uniform_table.at ( i ).hash == hash )
+    {
+        /* already present: throw if it is a different uniform with the same hash */
+        if ( uniform_table.at ( i ).uni != &uni ) throw exception::uniform_exception { "uniform with name " + uni.get_name () + " has the same hash as uniform with name " + uniform_table.at ( i ).uni->get_name () };
+        return;
+    }
+
+    /* add the uniform to the empty slot */
+    uniform_table.at ( i ) = uniform_table_slot { hash, &uni };
+    ++uniform_table_count;
+}
+
+
+
+/* COMPUTE_PROGRAM IMPLEMENTATION */
+
+/* get_work_group_size
+ *
+ * get the size of the work groups declared in the compute shader
+ * the program must be linked
+ */
+glh::math::ivec3 glh::core::compute_program::get_work_group_size () const
+{
+    /* query the work group size */
+    GLint work_group_size [ 3 ];
+    glGetProgramiv ( id, GL_COMPUTE_WORK_GROUP_SIZE, work_group_size );
+    return math::ivec3 { work_group_size [ 0 ], work_group_size [ 1 ], work_group_size [ 2 ] };
+}
+
+/* dispatch
+ *
+ * use the program and dispatch a number of work groups
+ * 
+ * num_groups_x/y/z: the number of work groups in each dimension (y and z default to 1)
+ */
+void glh::core::compute_program::dispatch ( const GLuint num_groups_x, const GLuint num_groups_y, const GLuint num_groups_z ) const
+{
+    /* use the program, then dispatch */
+    use ();
+    renderer::dispatch_compute ( num_groups_x, num_groups_y, num_groups_z );
+}
+
+/* dispatch_invocations
+ *
+ * use the program and dispatch enough work groups to cover a number of invocations
+ * the number of work groups in each dimension is rounded up, so the shader must ignore invocations past the end
+ * 
+ * num_invocations_x/y/z: the number of invocations needed in each dimension (y and z default to 1)
+ */
+void glh::core::compute_program::dispatch_invocations ( const GLuint num_invocations_x, const GLuint num_invocations_y, const GLuint num_invocations_z ) const
+{
+    /* round the number of invocations up to whole work groups */
+    const math::ivec3 work_group_size = get_work_group_size ();
+    const auto num_groups = [] ( const GLuint num_invocations, const GLuint size ) { return ( num_invocations + size - 1 ) / size; };
+    dispatch ( num_groups ( num_invocations_x, work_group_size.at ( 0 ) ), num_groups ( num_invocations_y, work_group_size.at ( 1 ) ), num_groups ( num_invocations_z, work_group_size.at ( 2 ) ) );
+}
+
+/* dispatch_indirect
+ *
+ * use the program and dispatch the number of work groups stored in a buffer
+ * 
+ * indirect_buffer: the buffer containing the three unsigned integers of the number of work groups
+ * offset: the offset of the integers in the buffer in bytes (defaults to 0)
+ */
+void glh::core::compute_program::dispatch_indirect ( const buffer& indirect_buffer, const GLintptr offset ) const
+{
+    /* use the program, then dispatch */
+    use ();
+    renderer::dispatch_compute_indirect ( indirect_buffer.internal_id (), offset );
+}
+
+
+
+/* PROGRAM_SET IMPLEMENTATION */
+
+/* initializer list constructor
+ *
+ * _programs: the programs in the set
+ */
+glh::core::program_set::program_set ( std::initializer_list<std::reference_wrapper<program>> _programs )
+    : compile_time { 0.0 }
+{
+    /* add each program */
+    for ( program& prog: _programs ) add ( prog );
+}
+
+
+
+/* submit_all
+ *
+ * submit the compilation and link of every program in the set without waiting on any of them
+ */
+void glh::core::program_set::submit_all ()
+{
+    /* submit each program */
+    for ( program * prog: programs ) prog->compile_and_link_async ();
+}
+
+/* is_ready
+ *
+ * returns true if every program in the set is ready to use, finishing the links of those which are complete
+ */
+bool glh::core::program_set::is_ready ()
+{
+    /* poll every program, so that each completed link is finished */
+    bool ready = true;
+    for ( program * prog: programs ) if ( !prog->is_ready () ) ready = false;
+    return ready;
+}
+
+/* wait_until_ready
+ *
+ * finish the pending links of every program in the set, blocking until the driver is done
+ */
+void glh::core::program_set::wait_until_ready ()
+{
+    /* wait for each program */
+    for ( program * prog: programs ) prog->wait_until_ready ();
+}
+
+/* compile_all
+ *
+ * compile and link every program in the set, and record the time taken
+ *
+ * parallel: if true, every program is submitted before any is waited on, otherwise each is compiled and linked in turn (defaults to true)
+ */
+void glh::core::program_set::compile_all ( const bool parallel )
+{
+    /* start timing */
+    const auto timestamp_start = std::chrono::steady_clock::now ();
 
+    /* either submit everything then wait, or compile and link each program in turn */
+    if ( parallel ) { submit_all (); wait_until_ready (); }
+    else for ( program * prog: programs ) prog->compile_and_link ();
+
+    /* record the time taken */
+    compile_time = std::chrono::duration<double, std::milli> { std::chrono::steady_clock::now () - timestamp_start }.count ();
+}
+
+
+
+/* PROGRAM_REGISTRY IMPLEMENTATION */
+
+/* get
+ *
+ * get a shared program built from source files and defines
+ * the program is only created, compiled and linked if no identical program is still alive
+ *
+ * vshader_paths/gshader_paths/fshader_paths: the source files of each shader, where no geometry shader paths means no geometry shader
+ * defines: source to insert after the version directive of each shader, before the files (e.g. #define lines) (defaults to none)
+ *
+ * return: a shared pointer to the program
+ */
+std::shared_ptr<glh::core::program> glh::core::program_registry::get ( const std::vector<std::string>& vshader_paths, const std::vector<std::string>& gshader_paths, const std::vector<std::string>& fshader_paths, const std::string& defines )
+{
+    /* build the key from the paths of each shader and the defines */
+    std::string key;
+    for ( const std::string& path: vshader_paths ) key.append ( "v:" + path + '\n' );
+    for ( const std::string& path: gshader_paths ) key.append ( "g:" + path + '\n' );
+    for ( const std::string& path: fshader_paths ) key.append ( "f:" + path + '\n' );
+    key.append ( "d:" + defines );
+
+    /* if the program is still alive, share it */
+    std::shared_ptr<registry_entry> entry = find_entry ( key );
+    if ( entry ) return std::shared_ptr<program> { entry, entry->prog.get () };
+
+    /* otherwise create the shaders, inserting the defines before the files */
+    entry.reset ( new registry_entry {} );
+    const auto include = [ & ] ( shader& s, const std::vector<std::string>& paths )
+    {
+        s.add_defines ( defines );
+        for ( const std::string& path: paths ) s.include_files ( { path } );
+    };
+    include ( entry->vertex_shader, vshader_paths );
+    include ( entry->geometry_shader, gshader_paths );
+    include ( entry->fragment_shader, fshader_paths );
+
+    /* create the program, and add it to the registry once compiled and linked */
+    if ( gshader_paths.empty () ) entry->prog.reset ( new program { entry->vertex_shader, entry->fragment_shader } );
+    else entry->prog.reset ( new program { entry->vertex_shader, entry->geometry_shader, entry->fragment_shader } );
+    add_entry ( key, entry );
+
+    /* return the program */
+    return std::shared_ptr<program> { entry, entry->prog.get () };
+}
+
+/* get_compute
+ *
+ * get a shared compute program built from source files and defines
+ * the program is only created, compiled and linked if no identical program is still alive
+ *
+ * cshader_paths: the source files of the compute shader
+ * defines: source to insert after the version directive of the shader, before the files (e.g. #define lines) (defaults to none)
+ *
+ * return: a shared pointer to the compute program
+ */
+std::shared_ptr<glh::core::compute_program> glh::core::program_registry::get_compute ( const std::vector<std::string>& cshader_paths, const std::string& defines )
+{
+    /* build the key from the paths of the shader and the defines */
+    std::string key;
+    for ( const std::string& path: cshader_paths ) key.append ( "c:" + path + '\n' );
+    key.append ( "d:" + defines );
+
+    /* if the program is still alive, share it */
+    std::shared_ptr<registry_entry> entry = find_entry ( key );
+    if ( entry ) return std::shared_ptr<compute_program> { entry, static_cast<compute_program *> ( entry->prog.get () ) };
+
+    /* otherwise create the shader, inserting the defines before the files */
+    entry.reset ( new registry_entry {} );
+    entry->compute_shader.add_defines ( defines );
+    for ( const std::string& path: cshader_paths ) entry->compute_shader.include_files ( { path } );
+
+    /* create the program, and add it to the registry once compiled and linked */
+    entry->prog.reset ( new compute_program { entry->compute_shader } );
+    add_entry ( key, entry );
+
+    /* return the program */
+    return std::shared_ptr<compute_program> { entry, static_cast<compute_program *> ( entry->prog.get () ) };
+}
+
+/* get_num_programs
+ *
+ * get the number of programs in the registry which are still alive
+ */
+unsigned glh::core::program_registry::get_num_programs ()
+{
+    /* count the entries which have not expired */
+    return std::count_if ( entries.begin (), entries.end (), [] ( const auto& entry ) { return !entry.second.expired (); } );
+}
+
+
+
+/* find_entry
+ *
+ * find the entry of a key if it is still alive, counting a hit if so
+ *
+ * key: the key of the entry
+ *
+ * return: the entry, or NULL if there is no live entry with the key
+ */
+std::shared_ptr<glh::core::program_registry::registry_entry> glh::core::program_registry::find_entry ( const std::string& key )
+{
+    /* lock the entry if there is one, counting a hit if it is alive */
+    const auto it = entries.find ( key );
+    std::shared_ptr<registry_entry> entry = ( it != entries.end () ? it->second.lock () : NULL );
+    if ( entry ) ++num_hits;
+    return entry;
+}
+
+/* add_entry
+ *
+ * add an entry whose program has been created, compiling and linking it first, and removing any entries which have expired
+ * the entry is only added if the program compiles and links
+ *
+ * key: the key of the entry
+ * entry: the entry to add
+ */
+void glh::core::program_registry::add_entry ( const std::string& key, const std::shared_ptr<registry_entry>& entry )
+{
+    /* compile and link the program, which throws on failure */
+    entry->prog->compile_and_link ();
+    ++num_misses;
+
+    /* add the entry, removing any which have expired */
+    for ( auto expired_it = entries.begin (); expired_it != entries.end (); )
+    {
+        if ( expired_it->second.expired () ) expired_it = entries.erase ( expired_it );
+        else ++expired_it;
+    }
+    entries [ key ] = entry;
+}
+
+
+
+/* source_cache
+ *
+ * the contents of files read by any shader, by normalised path
+ */
+std::map<std::string, glh::core::shader::cached_source_file> glh::core::shader::source_cache {};
+
+/* num_source_cache_hits
+ * num_source_cache_misses
+ *
+ * source cache statistics across all shaders
+ */
+unsigned glh::core::shader::num_source_cache_hits { 0 };
+unsigned glh::core::shader::num_source_cache_misses { 0 };
 
 /* the currently bound program */
-glh::core::object_pointer<glh::core::program> glh::core::program::bound_program {};
\ No newline at end of file
+glh::core::object_pointer<glh::core::program> glh::core::program::bound_program {};
+
+/* num_uniform_calls
+ * num_skipped_uniform_calls
+ *
+ * uniform call statistics across all uniforms
+ */
+unsigned glh::core::uniform::num_uniform_calls { 0 };
+unsigned glh::core::uniform::num_skipped_uniform_calls { 0 };
+
+/* binary_cache_directory
+ *
+ * the directory of the program binary cache, or empty if the cache is disabled
+ */
+std::string glh::core::program::binary_cache_directory {};
+
+/* num_binary_cache_hits
+ * num_binary_cache_misses
+ *
+ * binary cache statistics across all programs
+ */
+unsigned glh::core::program::num_binary_cache_hits { 0 };
+unsigned glh::core::program::num_binary_cache_misses { 0 };
+
+/* entries
+ *
+ * the entries of the registry by key, which expire once the last shared pointer to their program is destroyed
+ */
+std::map<std::string, std::weak_ptr<glh::core::program_registry::registry_entry>> glh::core::program_registry::entries {};
+
+/* num_hits
+ * num_misses
+ *
+ * registry statistics
+ */
+unsigned glh::core::program_registry::num_hits { 0 };
+unsigned glh::core::program_registry::num_misses { 0 };
\ No newline at end of file
@@ -80,4 +80,30 @@ void glh::core::sync::flush_queue ()
 {
     /* call glFlush */
     glFlush ();
+}
+
+
+
+/* memory_barrier
+ *
+ * make incoherent writes by previous commands visible to the reads of following commands
+ *
+ * barriers: the ways in which the written memory will be read (defaults to all)
+ */
+void glh::core::sync::memory_barrier ( const GLbitfield barriers )
+{
+    /* call glMemoryBarrier */
+    glMemoryBarrier ( barriers );
+}
+
+/* memory_barrier_by_region
+ *
+ * as memory_barrier, but only between fragment shaders writing and reading the same region of the framebuffer
+ *
+ * barriers: the ways in which the written memory will be read (defaults to all)
+ */
+void glh::core::sync::memory_barrier_by_region ( const GLbitfield barriers )
+{
+    /* call glMemoryBarrierByRegion */
+    glMemoryBarrierByRegion ( barriers );
 }
\ No newline at end of file
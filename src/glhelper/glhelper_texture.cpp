@@ -17,6 +17,9 @@
 /* include glhelper_texture.hpp */
 #include <glhelper/glhelper_texture.hpp>
 
+/* include glhelper_render.hpp */
+#include <glhelper/glhelper_render.hpp>
+
 /* indlude stb_image.h with implementation */
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
@@ -195,6 +198,7 @@ GLenum glh::core::image::to_format ( const bool use_srgb ) const
  * set everything to defaults
  */
 glh::core::texture_base::texture_base ()
+    : loop_unit { 0 }
 {
     /* generate the texture */
     glGenTextures ( 1, &id );
@@ -204,7 +208,7 @@ glh::core::texture_base::texture_base ()
 glh::core::texture_base::~texture_base ()
 {
     /* destroy texture */
-    if ( id ) glDeleteTextures ( 1, &id );
+    if ( id ) { renderer::forget_texture ( id ); glDeleteTextures ( 1, &id ); }
 }
 
 
@@ -217,8 +221,9 @@ bool glh::core::texture_base::bind ( const unsigned index ) const
 
     /* if already bound, return false, else bind and return true */
     if ( bound_texture_indices.at ( index ) == this ) return false;
-    glBindTextureUnit ( index, id );
+    renderer::bind_texture_unit ( index, id );
     bound_texture_indices.at ( index ) = const_cast<texture_base *> ( this );
+    unit_last_use.at ( index ) = ++unit_clock;
     return true;
 }
 bool glh::core::texture_base::unbind ( const unsigned index ) const
@@ -228,7 +233,7 @@ bool glh::core::texture_base::unbind ( const unsigned index ) const
 
     /* if not bound, return false, else unbind and return true */
     if ( bound_texture_indices.at ( index ) != this ) return false;
-    glBindTextureUnit ( index, 0 );
+    renderer::bind_texture_unit ( index, 0 );
     bound_texture_indices.at ( index ) = NULL;
     return true;
 }
@@ -257,33 +262,132 @@ const glh::core::object_pointer<glh::core::texture_base>& glh::core::texture_bas
 
 /* bind_loop
  *
- * this will keep looping around texture units, disincluding 0, and making subsequent binds to the next unit
- * this avoids binding a texture to a unit already in use
+ * bind the texture to a texture unit, disincluding 0, which will not be reused by bind_loop until 78 other units have been used since
+ * if the texture is still bound to the unit it was last given, that unit is returned without rebinding
+ * otherwise the least recently used unit is evicted
  * 
- * returns the unit just bound to
+ * returns the unit bound to
  */
 unsigned glh::core::texture_base::bind_loop () const
 { 
-    /* bind and get the unit bound to */
-    bind ( bind_loop_index ); 
-    const unsigned temp_unit = bind_loop_index++;
+    /* get the unit, and bind to it if not already bound */
+    bool resident;
+    const unsigned unit = acquire_loop_unit ( resident );
+    if ( !resident ) { bind ( unit ); ++num_loop_bind_calls; }
+
+    /* remove any sampler from the unit, so the texture is sampled with its own parameters */
+    sampler::unbind_unit ( unit );
+
+    /* return the unit */
+    return unit;
+}
+
+/* bind_loop with a sampler
+ *
+ * bind_loop the texture, then bind a sampler to the same unit
+ * the sampler remains bound to the unit until the unit is next given to a texture by bind_loop
+ * 
+ * samp: the sampler to sample the texture with
+ * 
+ * returns the unit bound to
+ */
+unsigned glh::core::texture_base::bind_loop ( const sampler& samp ) const
+{
+    /* get the unit, and bind to it if not already bound */
+    bool resident;
+    const unsigned unit = acquire_loop_unit ( resident );
+    if ( !resident ) { bind ( unit ); ++num_loop_bind_calls; }
 
-    /* loop if necesary */
-    if ( bind_loop_index == 80 ) bind_loop_index = 1;
+    /* bind the sampler to the unit */
+    samp.bind ( unit );
 
-    /* return unit just bound to */
-    return temp_unit;
+    /* return the unit */
+    return unit;
 }
 
-/* bind_loop_previous
+/* bind_loop with multiple textures
+ *
+ * bind_loop several textures at once, binding those which are not already bound with as few calls to glBindTextures as possible
+ * 
+ * textures: the textures to bind
+ * 
+ * returns the units bound to, in the same order as the textures
+ */
+std::vector<unsigned> glh::core::texture_base::bind_loop ( const std::vector<const texture_base *>& textures )
+{
+    /* get the unit of each texture, recording those which need binding
+     * the bound textures are updated immediately, so that a texture appearing twice is only bound once
+     */
+    std::vector<unsigned> units ( textures.size () );
+    std::array<GLuint, 80> unit_ids;
+    std::array<bool, 80> unit_changed;
+    unit_changed.fill ( false );
+    for ( unsigned i = 0; i < textures.size (); ++i )
+    {
+        bool resident;
+        units.at ( i ) = textures.at ( i )->acquire_loop_unit ( resident );
+        if ( !resident )
+        {
+            unit_ids.at ( units.at ( i ) ) = textures.at ( i )->internal_id ();
+            unit_changed.at ( units.at ( i ) ) = true;
+            bound_texture_indices.at ( units.at ( i ) ) = const_cast<texture_base *> ( textures.at ( i ) );
+        }
+    }
+
+    /* bind each run of consecutive changed units with a single call */
+    for ( unsigned first = 1; first < 80; ++first ) if ( unit_changed.at ( first ) )
+    {
+        unsigned last = first;
+        while ( last + 1 < 80 && unit_changed.at ( last + 1 ) ) ++last;
+        renderer::bind_textures ( first, last - first + 1, unit_ids.data () + first );
+        ++num_loop_bind_calls;
+        first = last;
+    }
+
+    /* remove any samplers from the units */
+    for ( const unsigned unit: units ) sampler::unbind_unit ( unit );
+
+    /* return the units */
+    return units;
+}
+
+/* bind_loop_next
+ *
+ * return the unit which would be evicted by the next bind_loop of a texture which is not already bound
+ */
+unsigned glh::core::texture_base::bind_loop_next ()
+{
+    /* prefer units with no valid texture bound, otherwise take the least recently used unit */
+    unsigned next_unit = 1;
+    for ( unsigned i = 1; i < 80; ++i )
+    {
+        if ( !bound_texture_indices.at ( i ) ) return i;
+        if ( unit_last_use.at ( i ) < unit_last_use.at ( next_unit ) ) next_unit = i;
+    }
+    return next_unit;
+}
+
+
+
+/* acquire_loop_unit
  *
- * return the previous binding of the loop
+ * get the unit for bind_loop to use, marking it as the most recently used
+ * 
+ * resident: set to true if the texture is already bound to the unit
  */
-unsigned glh::core::texture_base::bind_loop_previous () const
+unsigned glh::core::texture_base::acquire_loop_unit ( bool& resident ) const
 {
-    /* if is 1, return 31, else return next index - 1 */
-    if ( bind_loop_index == 1 ) return 79;
-    else return bind_loop_index - 1;
+    /* record the request */
+    ++num_loop_requests;
+
+    /* reuse the unit last given to the texture if it is still bound there, otherwise evict a unit */
+    resident = ( loop_unit != 0 && bound_texture_indices.at ( loop_unit ) == this );
+    if ( resident ) ++num_loop_binds_avoided; else loop_unit = bind_loop_next ();
+
+    /* mark the unit as the most recently used and return it */
+    unit_last_use.at ( loop_unit ) = ++unit_clock;
+    bind_loop_index = loop_unit;
+    return loop_unit;
 }
 
 
@@ -377,6 +481,21 @@ void glh::core::texture_base::set_compare_func ( const GLenum opt )
     glTextureParameteri ( id, GL_TEXTURE_COMPARE_FUNC, opt );
 }
 
+/* set_base/max_level
+ *
+ * set the lowest and highest mipmap levels which can be accessed
+ */
+void glh::core::texture_base::set_base_level ( const unsigned level )
+{
+    /* set parameter */
+    glTextureParameteri ( id, GL_TEXTURE_BASE_LEVEL, level );
+}
+void glh::core::texture_base::set_max_level ( const unsigned level )
+{
+    /* set parameter */
+    glTextureParameteri ( id, GL_TEXTURE_MAX_LEVEL, level );
+}
+
 /* generate_mipmap
  *
  * generate texture mipmap
@@ -392,8 +511,209 @@ void glh::core::texture_base::generate_mipmap ()
 /* currently bound textures */
 std::array<glh::core::object_pointer<glh::core::texture_base>, 80> glh::core::texture_base::bound_texture_indices {};
 
-/* bind_loop_next defaults to 1 */
-unsigned glh::core::texture_base::bind_loop_index { 1 };
+/* no unit has been returned by bind_loop yet */
+unsigned glh::core::texture_base::bind_loop_index { 0 };
+
+/* unit_last_use
+ * unit_clock
+ *
+ * the time at which each texture unit was last used, counted in binds
+ */
+std::array<unsigned, 80> glh::core::texture_base::unit_last_use {};
+unsigned glh::core::texture_base::unit_clock { 0 };
+
+/* bind_loop counters */
+unsigned glh::core::texture_base::num_loop_requests { 0 };
+unsigned glh::core::texture_base::num_loop_binds_avoided { 0 };
+unsigned glh::core::texture_base::num_loop_bind_calls { 0 };
+
+
+
+/* SAMPLER IMPLEMENTATION */
+
+/* parameters::operator==
+ *
+ * compare sets of parameters
+ */
+bool glh::core::sampler::parameters::operator== ( const parameters& other ) const
+{
+    /* compare every parameter */
+    return mag_filter == other.mag_filter && min_filter == other.min_filter && s_wrap == other.s_wrap && t_wrap == other.t_wrap && r_wrap == other.r_wrap &&
+        border_color == other.border_color && compare_mode == other.compare_mode && compare_func == other.compare_func &&
+        min_lod == other.min_lod && max_lod == other.max_lod && lod_bias == other.lod_bias;
+}
+
+/* parameters_hash::operator()
+ *
+ * hash a set of parameters
+ */
+std::size_t glh::core::sampler::parameters_hash::operator() ( const parameters& params ) const
+{
+    /* combine the hashes of each parameter */
+    std::size_t seed = 0;
+    auto combine = [ & ] ( const std::size_t hash ) { seed ^= hash + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 ); };
+    combine ( std::hash<GLenum> {} ( params.mag_filter ) );
+    combine ( std::hash<GLenum> {} ( params.min_filter ) );
+    combine ( std::hash<GLenum> {} ( params.s_wrap ) );
+    combine ( std::hash<GLenum> {} ( params.t_wrap ) );
+    combine ( std::hash<GLenum> {} ( params.r_wrap ) );
+    for ( unsigned i = 0; i < 4; ++i ) combine ( std::hash<GLfloat> {} ( params.border_color.at ( i ) ) );
+    combine ( std::hash<GLenum> {} ( params.compare_mode ) );
+    combine ( std::hash<GLenum> {} ( params.compare_func ) );
+    combine ( std::hash<GLfloat> {} ( params.min_lod ) );
+    combine ( std::hash<GLfloat> {} ( params.max_lod ) );
+    combine ( std::hash<GLfloat> {} ( params.lod_bias ) );
+    return seed;
+}
+
+
+
+/* full constructor
+ *
+ * create a sampler with a set of parameters
+ * 
+ * _params: the parameters of the sampler
+ */
+glh::core::sampler::sampler ( const parameters& _params )
+    : params { _params }
+{
+    /* create the sampler */
+    glCreateSamplers ( 1, &id );
+
+    /* set the parameters */
+    glSamplerParameteri ( id, GL_TEXTURE_MAG_FILTER, params.mag_filter );
+    glSamplerParameteri ( id, GL_TEXTURE_MIN_FILTER, params.min_filter );
+    glSamplerParameteri ( id, GL_TEXTURE_WRAP_S, params.s_wrap );
+    glSamplerParameteri ( id, GL_TEXTURE_WRAP_T, params.t_wrap );
+    glSamplerParameteri ( id, GL_TEXTURE_WRAP_R, params.r_wrap );
+    glSamplerParameterfv ( id, GL_TEXTURE_BORDER_COLOR, params.border_color.internal_ptr () );
+    glSamplerParameteri ( id, GL_TEXTURE_COMPARE_MODE, params.compare_mode );
+    glSamplerParameteri ( id, GL_TEXTURE_COMPARE_FUNC, params.compare_func );
+    glSamplerParameterf ( id, GL_TEXTURE_MIN_LOD, params.min_lod );
+    glSamplerParameterf ( id, GL_TEXTURE_MAX_LOD, params.max_lod );
+    glSamplerParameterf ( id, GL_TEXTURE_LOD_BIAS, params.lod_bias );
+}
+
+/* zero-parameter constructor
+ *
+ * create a sampler with the default parameters of OpenGL
+ */
+glh::core::sampler::sampler ()
+    : sampler { parameters {} }
+{}
+
+/* destructor */
+glh::core::sampler::~sampler ()
+{
+    /* destroy sampler */
+    if ( id ) { renderer::forget_sampler ( id ); glDeleteSamplers ( 1, &id ); }
+}
+
+
+
+/* bind/unbind to texture units */
+bool glh::core::sampler::bind ( const unsigned index ) const
+{
+    /* if index is out of range, throw */
+    if ( index >= 80 ) throw exception::texture_exception { "texture unit is out of range" };
+
+    /* if already bound, return false, else bind and return true */
+    if ( bound_sampler_indices.at ( index ) == this ) return false;
+    renderer::bind_sampler ( index, id );
+    bound_sampler_indices.at ( index ) = const_cast<sampler *> ( this );
+    return true;
+}
+bool glh::core::sampler::unbind ( const unsigned index ) const
+{
+    /* if index is out of range, throw */
+    if ( index >= 80 ) throw exception::texture_exception { "texture unit is out of range" };
+
+    /* if not bound, return false, else unbind and return true */
+    if ( bound_sampler_indices.at ( index ) != this ) return false;
+    return unbind_unit ( index );
+}
+bool glh::core::sampler::is_bound ( const unsigned index ) const
+{
+    /* if index is out of range, throw */
+    if ( index >= 80 ) throw exception::texture_exception { "texture unit is out of range" };
+
+    /* return true if is bound */
+    return bound_sampler_indices.at ( index ) == this;
+}
+
+/* unbind_unit
+ *
+ * remove any sampler from a texture unit
+ * 
+ * returns true if a sampler was removed
+ */
+bool glh::core::sampler::unbind_unit ( const unsigned index )
+{
+    /* if index is out of range, throw */
+    if ( index >= 80 ) throw exception::texture_exception { "texture unit is out of range" };
+
+    /* if no sampler is bound, return false, else unbind and return true */
+    if ( !bound_sampler_indices.at ( index ) ) return false;
+    renderer::bind_sampler ( index, 0 );
+    bound_sampler_indices.at ( index ) = NULL;
+    return true;
+}
+
+/* get the currently bound sampler */
+const glh::core::object_pointer<glh::core::sampler>& glh::core::sampler::get_bound_sampler ( const unsigned index )
+{
+    /* if index is out of range, throw */
+    if ( index >= 80 ) throw exception::texture_exception { "texture unit is out of range" };
+
+    /* return bound sampler pointer */
+    return bound_sampler_indices.at ( index );
+}
+
+
+
+/* get_cached
+ *
+ * get the cached sampler with a set of parameters, creating it if it does not yet exist
+ * the sampler remains valid until clear_cache is called
+ * 
+ * _params: the parameters of the sampler
+ */
+const glh::core::sampler& glh::core::sampler::get_cached ( const parameters& _params )
+{
+    /* record the request, and create the cache if it does not exist */
+    ++num_cache_requests;
+    if ( !cache ) cache = new std::unordered_map<parameters, std::unique_ptr<sampler>, parameters_hash> {};
+
+    /* find the sampler, creating it if not found */
+    std::unique_ptr<sampler>& cached = ( * cache ) [ _params ];
+    if ( !cached ) cached.reset ( new sampler { _params } );
+    return * cached;
+}
+
+/* clear_cache
+ *
+ * destroy all cached samplers
+ * this must be called before the OpenGL context is destroyed
+ */
+void glh::core::sampler::clear_cache ()
+{
+    /* delete the cache, which destroys the samplers */
+    delete cache;
+    cache = NULL;
+}
+
+
+
+/* SAMPLER STATIC MEMBERS DEFINITIONS */
+
+/* currently bound samplers */
+std::array<glh::core::object_pointer<glh::core::sampler>, 80> glh::core::sampler::bound_sampler_indices {};
+
+/* the cache is allocated on first use */
+std::unordered_map<glh::core::sampler::parameters, std::unique_ptr<glh::core::sampler>, glh::core::sampler::parameters_hash> * glh::core::sampler::cache { NULL };
+
+/* no calls to get_cached yet */
+unsigned glh::core::sampler::num_cache_requests { 0 };
 
 
 
@@ -404,7 +724,7 @@ bool glh::core::texture1d::bind () const
 {
     /* if already bound, return false, else bind and return true */
     if ( bound_texture_indices.at ( 0 ) == this ) return false;
-    glBindTexture ( GL_TEXTURE_1D, id );
+    renderer::bind_texture ( GL_TEXTURE_1D, id );
     bound_texture_indices.at ( 0 ) = const_cast<texture1d *> ( this );
     return true;
 }
@@ -412,7 +732,7 @@ bool glh::core::texture1d::unbind () const
 {
     /* if not bound, return false, else unbind and return true */
     if ( bound_texture_indices.at ( 0 ) != this ) return false;
-    glBindTexture ( GL_TEXTURE_1D, 0 );
+    renderer::bind_texture ( GL_TEXTURE_1D, 0 );
     bound_texture_indices.at ( 0 ) = NULL;
     return true;
 }
@@ -498,7 +818,7 @@ bool glh::core::buffer_texture::bind () const
 {
     /* if already bound, return false, else bind and return true */
     if ( bound_texture_indices.at ( 0 ) == this ) return false;
-    glBindTexture ( GL_TEXTURE_BUFFER, id );
+    renderer::bind_texture ( GL_TEXTURE_BUFFER, id );
     bound_texture_indices.at ( 0 ) = const_cast<buffer_texture *> ( this );
     return true;
 }
@@ -506,7 +826,7 @@ bool glh::core::buffer_texture::unbind () const
 {
     /* if not bound, return false, else unbind and return true */
     if ( bound_texture_indices.at ( 0 ) != this ) return false;
-    glBindTexture ( GL_TEXTURE_BUFFER, 0 );
+    renderer::bind_texture ( GL_TEXTURE_BUFFER, 0 );
     bound_texture_indices.at ( 0 ) = NULL;
     return true;
 }
@@ -539,7 +859,7 @@ bool glh::core::texture2d::bind () const
 {
     /* if already bound, return false, else bind and return true */
     if ( bound_texture_indices.at ( 0 ) == this ) return false;
-    glBindTexture ( GL_TEXTURE_2D, id );
+    renderer::bind_texture ( GL_TEXTURE_2D, id );
     bound_texture_indices.at ( 0 ) = const_cast<texture2d *> ( this );
     return true;
 }
@@ -547,7 +867,7 @@ bool glh::core::texture2d::unbind () const
 {
     /* if not bound, return false, else unbind and return true */
     if ( bound_texture_indices.at ( 0 ) != this ) return false;
-    glBindTexture ( GL_TEXTURE_2D, 0 );
+    renderer::bind_texture ( GL_TEXTURE_2D, 0 );
     bound_texture_indices.at ( 0 ) = NULL;
     return true;
 }
@@ -676,7 +996,7 @@ bool glh::core::texture2d_array::bind () const
 {
     /* if already bound, return false, else bind and return true */
     if ( bound_texture_indices.at ( 0 ) == this ) return false;
-    glBindTexture ( GL_TEXTURE_2D_ARRAY, id );
+    renderer::bind_texture ( GL_TEXTURE_2D_ARRAY, id );
     bound_texture_indices.at ( 0 ) = const_cast<texture2d_array *> ( this );
     return true;
 }
@@ -684,7 +1004,7 @@ bool glh::core::texture2d_array::unbind () const
 {
     /* if not bound, return false, else unbind and return true */
     if ( bound_texture_indices.at ( 0 ) != this ) return false;
-    glBindTexture ( GL_TEXTURE_2D_ARRAY, 0 );
+    renderer::bind_texture ( GL_TEXTURE_2D_ARRAY, 0 );
     bound_texture_indices.at ( 0 ) = NULL;
     return true;
 }
@@ -879,7 +1199,7 @@ bool glh::core::texture2d_multisample::bind () const
 {
     /* if already bound, return false, else bind and return true */
     if ( bound_texture_indices.at ( 0 ) == this ) return false;
-    glBindTexture ( GL_TEXTURE_2D_MULTISAMPLE, id );
+    renderer::bind_texture ( GL_TEXTURE_2D_MULTISAMPLE, id );
     bound_texture_indices.at ( 0 ) = const_cast<texture2d_multisample *> ( this );
     return true;
 }
@@ -887,7 +1207,7 @@ bool glh::core::texture2d_multisample::unbind () const
 {
     /* if not bound, return false, else unbind and return true */
     if ( bound_texture_indices.at ( 0 ) != this ) return false;
-    glBindTexture ( GL_TEXTURE_2D_MULTISAMPLE, 0 );
+    renderer::bind_texture ( GL_TEXTURE_2D_MULTISAMPLE, 0 );
     bound_texture_indices.at ( 0 ) = NULL;
     return true;
 }
@@ -955,7 +1275,7 @@ bool glh::core::cubemap::bind () const
 {
     /* if already bound, return false, else bind and return true */
     if ( bound_texture_indices.at ( 0 ) == this ) return false;
-    glBindTexture ( GL_TEXTURE_CUBE_MAP, id );
+    renderer::bind_texture ( GL_TEXTURE_CUBE_MAP, id );
     bound_texture_indices.at ( 0 ) = const_cast<cubemap *> ( this );
     return true;
 }
@@ -963,7 +1283,7 @@ bool glh::core::cubemap::unbind () const
 {
     /* if not bound, return false, else unbind and return true */
     if ( bound_texture_indices.at ( 0 ) != this ) return false;
-    glBindTexture ( GL_TEXTURE_CUBE_MAP, 0 );
+    renderer::bind_texture ( GL_TEXTURE_CUBE_MAP, 0 );
     bound_texture_indices.at ( 0 ) = NULL;
     return true;
 }
@@ -1170,7 +1490,7 @@ bool glh::core::cubemap_array::bind () const
 {
     /* if already bound, return false, else bind and return true */
     if ( bound_texture_indices.at ( 0 ) == this ) return false;
-    glBindTexture ( GL_TEXTURE_CUBE_MAP_ARRAY, id );
+    renderer::bind_texture ( GL_TEXTURE_CUBE_MAP_ARRAY, id );
     bound_texture_indices.at ( 0 ) = const_cast<cubemap_array *> ( this );
     return true;
 }
@@ -1178,7 +1498,7 @@ bool glh::core::cubemap_array::unbind () const
 {
     /* if not bound, return false, else unbind and return true */
     if ( bound_texture_indices.at ( 0 ) != this ) return false;
-    glBindTexture ( GL_TEXTURE_CUBE_MAP_ARRAY, 0 );
+    renderer::bind_texture ( GL_TEXTURE_CUBE_MAP_ARRAY, 0 );
     bound_texture_indices.at ( 0 ) = NULL;
     return true;
 }
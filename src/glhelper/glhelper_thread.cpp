@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2020 Louis Hobson <louis-hobson@hotmail.co.uk>. All Rights Reserved.
+ *
+ * Distributed under MIT licence as a part of the GLHelper C++ library.
+ * For details, see: https://github.com/louishobson/GLHelper/blob/master/LICENSE
+ *
+ * src/glhelper/glhelper_thread.cpp
+ *
+ * implementation of include/glhelper/glhelper_thread.hpp
+ *
+ */
+
+
+
+/* INCLUDES */
+
+/* include glhelper_thread.hpp */
+#include <glhelper/glhelper_thread.hpp>
+
+
+
+/* THREAD_POOL IMPLEMENTATION */
+
+/* full constructor
+ *
+ * create the pool and start the worker threads
+ *
+ * _num_threads: the total number of threads to work with, including the calling thread (defaults to the hardware concurrency)
+ */
+glh::thread::thread_pool::thread_pool ( const unsigned _num_threads )
+    : work_func { NULL }
+    , work_count { 0 }
+    , next_index { 0 }
+    , generation { 0 }
+    , active_workers { 0 }
+    , stopping { false }
+{
+    /* start the workers, leaving one thread for the caller */
+    for ( unsigned i = 1; i < _num_threads; ++i ) workers.emplace_back ( &thread_pool::worker_loop, this );
+}
+
+/* destructor
+ *
+ * stop and join the worker threads
+ */
+glh::thread::thread_pool::~thread_pool ()
+{
+    /* tell the workers to stop */
+    {
+        std::lock_guard<std::mutex> lock { pool_mutex };
+        stopping = true;
+    }
+    work_cv.notify_all ();
+
+    /* join the workers */
+    for ( std::thread& worker: workers ) worker.join ();
+}
+
+
+
+/* get_shared
+ *
+ * get the pool shared by the library, which is created on first use and lives until the program exits
+ */
+glh::thread::thread_pool& glh::thread::thread_pool::get_shared ()
+{
+    /* create the pool on first use */
+    static thread_pool shared_pool;
+    return shared_pool;
+}
+
+
+
+/* parallel_for
+ *
+ * call a function once for every index in [0, count), spread across the threads of the pool
+ * the order in which indices are processed is unspecified
+ *
+ * count: the number of indices
+ * func: the function to call with each index
+ */
+void glh::thread::thread_pool::parallel_for ( const unsigned count, const std::function<void ( unsigned )>& func )
+{
+    /* only allow one submission at a time */
+    std::lock_guard<std::mutex> submit_lock { submit_mutex };
+
+    /* set up the work and wake the workers */
+    {
+        std::lock_guard<std::mutex> lock { pool_mutex };
+        work_func = &func;
+        work_count = count;
+        next_index = 0;
+        work_exception = NULL;
+        active_workers = workers.size ();
+        ++generation;
+    }
+    work_cv.notify_all ();
+
+    /* take part in the work */
+    run_work ();
+
+    /* wait for the workers to finish */
+    std::unique_lock<std::mutex> lock { pool_mutex };
+    done_cv.wait ( lock, [ this ] () { return active_workers == 0; } );
+    work_func = NULL;
+
+    /* rethrow the first exception, if any */
+    if ( work_exception ) std::rethrow_exception ( work_exception );
+}
+
+
+
+/* worker_loop
+ *
+ * the function run by each worker thread
+ */
+void glh::thread::thread_pool::worker_loop ()
+{
+    /* the last generation of work this worker completed */
+    unsigned completed_generation = 0;
+
+    /* loop until stopped */
+    while ( true )
+    {
+        /* wait for new work or to be stopped */
+        {
+            std::unique_lock<std::mutex> lock { pool_mutex };
+            work_cv.wait ( lock, [ this, completed_generation ] () { return stopping || generation != completed_generation; } );
+            if ( stopping ) return;
+            completed_generation = generation;
+        }
+
+        /* process the work */
+        run_work ();
+
+        /* mark this worker as finished, waking the caller if it was the last */
+        std::lock_guard<std::mutex> lock { pool_mutex };
+        if ( --active_workers == 0 ) done_cv.notify_all ();
+    }
+}
+
+/* run_work
+ *
+ * process indices of the current work until none are left
+ */
+void glh::thread::thread_pool::run_work ()
+{
+    /* take indices until they run out */
+    for ( unsigned i = next_index++; i < work_count; i = next_index++ )
+    {
+        /* call the function, recording the first exception thrown */
+        try { ( * work_func ) ( i ); } catch ( ... )
+        {
+            std::lock_guard<std::mutex> lock { pool_mutex };
+            if ( !work_exception ) work_exception = std::current_exception ();
+        }
+    }
+}
@@ -24,6 +24,9 @@
 /* include glhelper.hpp */
 #include <glhelper/glhelper.hpp>
 
+/* include glhelper_headless.hpp, which is not included by glhelper.hpp as it depends on EGL */
+#include <glhelper/glhelper_headless.hpp>
+
 void GLAPIENTRY
 MessageCallback( GLenum source,
                  GLenum type,
@@ -52,6 +55,42 @@ MessageCallback( GLenum source,
  */
 #define RESOLUTION 2560, 1440
 
+/* PARALLEL_SHADER_COMPILE
+ *
+ * true to submit every program before waiting on any, false to compile and link each in turn
+ */
+#define PARALLEL_SHADER_COMPILE true
+
+/* IMPORT_BENCHMARK_MODELS
+ *
+ * if non-zero, the number of extra copies of the island model to import (e.g. 1, 10 or 100), reporting the time taken
+ */
+#define IMPORT_BENCHMARK_MODELS 0
+
+/* REGRESSION_FRAME
+ *
+ * if non-zero, the frame at which to compare the final color texture and the window against the golden images in assets/golden, recording any which are missing
+ */
+#define REGRESSION_FRAME 0
+
+/* REGISTRY_BENCHMARK
+ *
+ * if non-zero, the number of iterations of object create/destroy churn and object pointer queries to time, reporting the time per iteration
+ */
+#define REGISTRY_BENCHMARK 0
+
+/* INSTANCED_ISLANDS
+ *
+ * if non-zero, the number of rows and columns of a grid of island copies drawn around the island in one instanced draw, culled against the view frustum
+ */
+#define INSTANCED_ISLANDS 0
+
+/* UNIFORM_LOOKUP_BENCHMARK
+ *
+ * if non-zero, the number of times to render the island into the gbuffer looking up texture stack uniforms by name, and again by hashed id, reporting the time per render
+ */
+#define UNIFORM_LOOKUP_BENCHMARK 0
+
 
 
 int main ()
@@ -74,64 +113,149 @@ int main ()
     
     /* SET UP PROGRAMS */
 
+    /* cache program binaries */
+    glh::core::program::set_binary_cache_directory ( "shaders/cache" );
+
     /* create forward model shader program */
     glh::core::vshader model_vshader { "shaders/materials.glsl", "shaders/camera.glsl", "shaders/vertex.model.glsl" };
     glh::core::fshader forward_model_fshader { "shaders/materials.glsl", "shaders/camera.glsl", "shaders/lighting.glsl", "shaders/fragment.forward_model.glsl"  };
     glh::core::program forward_model_program { model_vshader, forward_model_fshader };
-    forward_model_program.compile_and_link ();
 
     /* create deferred model shader program */
     glh::core::fshader deferred_model_fshader { "shaders/materials.glsl", "shaders/fragment.deferred_model.glsl" };
     glh::core::program deferred_model_program { model_vshader, deferred_model_fshader };
-    deferred_model_program.compile_and_link ();
+
+    /* create instanced deferred model shader program */
+    glh::core::vshader model_instanced_vshader { "shaders/materials.glsl", "shaders/camera.glsl", "shaders/vertex.model_instanced.glsl" };
+    glh::core::program deferred_model_instanced_program { model_instanced_vshader, deferred_model_fshader };
 
     /* create shadow shader program */
     glh::core::vshader shadow_vshader { "shaders/materials.glsl", "shaders/vertex.shadow.glsl" };
     glh::core::gshader shadow_gshader { "shaders/materials.glsl", "shaders/camera.glsl", "shaders/lighting.glsl", "shaders/geometry.shadow.glsl" };
     glh::core::fshader shadow_fshader { "shaders/materials.glsl", "shaders/fragment.shadow.glsl" };
     glh::core::program shadow_program { shadow_vshader, shadow_gshader, shadow_fshader };
-    shadow_program.compile_and_link ();
 
     /* create simple vshader */
     glh::core::vshader simple_vshader { "shaders/vertex.simple.glsl" };
 
-    /* create lighting shader program */
-    glh::core::fshader lighting_fshader { "shaders/materials.glsl", "shaders/camera.glsl", "shaders/lighting.glsl", "shaders/fragment.lighting.glsl"  };
-    glh::core::program lighting_program { simple_vshader, lighting_fshader };
-    lighting_program.compile_and_link ();
-
     /* create bloom shader program */
     glh::core::fshader bloom_fshader { "shaders/function.glsl", "shaders/fragment.bloom.glsl" };
     glh::core::program bloom_program { simple_vshader, bloom_fshader };
-    bloom_program.compile_and_link ();
 
     /* create fxaa shader program */
     glh::core::fshader fxaa_fshader { "shaders/fragment.fxaa.glsl" };
     glh::core::program fxaa_program { simple_vshader, fxaa_fshader };
-    fxaa_program.compile_and_link ();
+
+    /* define the texture stack size and light maxima in the shaders which include materials.glsl or lighting.glsl, so that they match the library */
+    const std::string shader_defines = glh::model::model::get_shader_defines () + glh::lighting::light_system::get_shader_defines ();
+    for ( glh::core::shader * s: std::initializer_list<glh::core::shader *> { &model_vshader, &model_instanced_vshader, &forward_model_fshader, &deferred_model_fshader, &shadow_vshader, &shadow_gshader, &shadow_fshader } )
+        s->add_defines ( shader_defines );
+
+    /* compile and link the programs together, timing how long they take to be ready with a cold or warm cache and with or without parallel compilation */
+    glh::core::program_set programs { forward_model_program, deferred_model_program, deferred_model_instanced_program, shadow_program, bloom_program, fxaa_program };
+    programs.compile_all ( PARALLEL_SHADER_COMPILE );
+
+    /* output the startup time of the programs, and how many came from the cache */
+    std::cout << "programs ready in " << programs.get_compile_time () << "ms ("
+              << glh::core::program::get_num_binary_cache_hits () << " from cache, " << glh::core::program::get_num_binary_cache_misses () << " compiled, "
+              << ( PARALLEL_SHADER_COMPILE ? ( glh::core::glad_loader::has_parallel_shader_compile () ? "parallel" : "submitted together" ) : "sequential" ) << ", "
+              << glh::core::shader::get_num_source_cache_misses () << " files read, " << glh::core::shader::get_num_source_cache_hits () << " from memory)" << std::endl;
+
+    /* bind the camera and light system blocks of each program to shared ubos */
+    glh::core::ubo camera_ubo, light_system_ubo;
+    camera_ubo.bind ( 0 ); light_system_ubo.bind ( 1 );
+    forward_model_program.set_uniform_block_binding ( "camera_block", 0 );
+    forward_model_program.set_uniform_block_binding ( "light_system_block", 1 );
+    deferred_model_program.set_uniform_block_binding ( "camera_block", 0 );
+    deferred_model_instanced_program.set_uniform_block_binding ( "camera_block", 0 );
+    shadow_program.set_uniform_block_binding ( "light_system_block", 1 );
+
+    /* check the blocks are laid out as the C++ structs expect */
+    for ( const glh::core::program * prog: { &forward_model_program, &deferred_model_program, &deferred_model_instanced_program } )
+        glh::core::validate_block<glh::core::std140_layout, glh::camera::camera_block> ( *prog, "camera" );
+    for ( const glh::core::program * prog: { &forward_model_program, &shadow_program } )
+        glh::core::validate_block<glh::core::std140_layout, glh::lighting::light_system_block> ( *prog, "light_system" );
+
+    /* check that compute programs work by writing the square of each index into an ssbo, then reading them back */
+    glh::core::cshader sequence_cshader { "shaders/compute.sequence.glsl" };
+    glh::core::compute_program sequence_program { sequence_cshader };
+    sequence_program.compile_and_link ();
+    {
+        const unsigned sequence_count = 1000;
+        glh::core::ssbo sequence_ssbo;
+        sequence_ssbo.buffer_storage ( sequence_count * sizeof ( unsigned ), NULL, GL_DYNAMIC_STORAGE_BIT | GL_MAP_READ_BIT | GL_MAP_WRITE_BIT );
+        sequence_ssbo.bind ( 0 );
+        sequence_program.get_uniform ( "count" ).set_uint ( sequence_count );
+        sequence_program.dispatch_invocations ( sequence_count );
+        glh::core::sync::buffer_update_barrier ();
+        unsigned sequence_errors = 0;
+        for ( unsigned i = 0; i < sequence_count; ++i ) sequence_errors += ( sequence_ssbo.at<unsigned> ( i ) != i * i );
+        sequence_ssbo.unmap_buffer ();
+        sequence_ssbo.unbind ( 0 );
+        std::cout << "compute check " << ( sequence_errors ? "failed" : "passed" ) << " (" << sequence_count << " values, work group size " << sequence_program.get_work_group_size ().at ( 0 ) << ", "
+                  << sequence_errors << " wrong)" << std::endl;
+    }
+
+    /* time the object registry by replacing objects in a set of live objects, and querying object pointers to them and whether a vbo is bound, each iteration */
+    if ( REGISTRY_BENCHMARK > 0 )
+    {
+        const unsigned num_live_objects = 1000;
+        std::vector<std::unique_ptr<glh::core::object>> live_objects ( num_live_objects );
+        for ( auto& live_object: live_objects ) live_object = std::make_unique<glh::core::object> ();
+        glh::core::vbo query_vbo;
+        query_vbo.bind ();
+        unsigned num_valid_queries = 0;
+        const auto registry_start = std::chrono::system_clock::now ();
+        for ( unsigned i = 0; i < REGISTRY_BENCHMARK; ++i )
+        {
+            live_objects.at ( i % num_live_objects ) = std::make_unique<glh::core::object> ();
+            const glh::core::object_pointer<glh::core::object> query_pointer { live_objects.at ( ( i * 7 ) % num_live_objects ).get () };
+            num_valid_queries += ( query_pointer.get () != NULL ) + query_vbo.is_bound ();
+        }
+        const double registry_time = std::chrono::duration<double, std::milli> { std::chrono::system_clock::now () - registry_start }.count ();
+        query_vbo.unbind ();
+        std::cout << "registry benchmark: " << REGISTRY_BENCHMARK << " create/query/destroy iterations in " << registry_time << "ms (" << registry_time * 1e6 / static_cast<double> ( REGISTRY_BENCHMARK ) << "ns each, "
+                  << num_valid_queries << " valid queries, " << glh::core::object::get_num_object_slots () << " object slots)" << std::endl;
+    }
+
+    /* reload the programs whenever their shader files change */
+    glh::core::shader_reloader shader_reloader;
+    for ( glh::core::program * prog: { &forward_model_program, &deferred_model_program, &deferred_model_instanced_program, &shadow_program, &bloom_program, &fxaa_program } ) shader_reloader.add ( *prog );
+
+    /* create the lighting program permutations, with a variant for each number of lights and whether shadow mapping is used
+     * each variant is built the first time the light system needs it, and has its blocks bound and validated before use, then is reloaded with the other programs
+     */
+    glh::core::program_permutations lighting_permutations
+    {
+        { "shaders/vertex.simple.glsl" }, {}, { "shaders/materials.glsl", "shaders/camera.glsl", "shaders/lighting.glsl", "shaders/fragment.lighting.glsl" },
+        glh::lighting::light_system::get_permutation_features (), shader_defines
+    };
+    lighting_permutations.set_build_callback ( [ & ] ( glh::core::program& prog )
+    {
+        prog.set_uniform_block_binding ( "camera_block", 0 );
+        prog.set_uniform_block_binding ( "light_system_block", 1 );
+        glh::core::validate_block<glh::core::std140_layout, glh::camera::camera_block> ( prog, "camera" );
+        glh::core::validate_block<glh::core::std140_layout, glh::lighting::light_system_block> ( prog, "light_system" );
+        shader_reloader.add ( prog );
+    } );
 
     /* extract uniforms out of forward model program */
-    auto& forward_model_camera_uni = forward_model_program.get_struct_uniform ( "camera" );
-    auto& forward_model_light_system_uni = forward_model_program.get_struct_uniform ( "light_system" );
+    auto& forward_model_shadow_maps_uni = forward_model_program.get_uniform ( "light_system_shadow_maps" );
     auto& forward_model_material_uni = forward_model_program.get_struct_uniform ( "material" );
     //auto& forward_model_transparent_mode_uni = forward_model_program.get_uniform ( "transparent_mode" );
 
     /* extract uniforms out of deferred model program */
-    auto& deferred_model_camera_uni = deferred_model_program.get_struct_uniform ( "camera" );
     auto& deferred_model_material_uni = deferred_model_program.get_struct_uniform ( "material" );
     auto& deferred_model_transparent_mode_uni = deferred_model_program.get_uniform ( "transparent_mode" );
 
+    /* extract uniforms out of instanced deferred model program */
+    auto& deferred_model_instanced_material_uni = deferred_model_instanced_program.get_struct_uniform ( "material" );
+    auto& deferred_model_instanced_model_matrix_uni = deferred_model_instanced_program.get_uniform ( "model_matrix" );
+    auto& deferred_model_instanced_transparent_mode_uni = deferred_model_instanced_program.get_uniform ( "transparent_mode" );
+
     /* extract uniforms out of shadow program */
-    auto& shadow_light_system_uni = shadow_program.get_struct_uniform ( "light_system" );
     auto& shadow_material_uni = shadow_program.get_struct_uniform ( "material" );
 
-    /* extract uniforms out of ligthing program */
-    auto& lighting_camera_uni = lighting_program.get_struct_uniform ( "camera" );
-    auto& lighting_light_system_uni = lighting_program.get_struct_uniform ( "light_system" );
-    auto& lighting_gbuffer_positionshininess_uni = lighting_program.get_uniform ( "gbuffer_positionshininess" );
-    auto& lighting_gbuffer_normalsstrength_uni = lighting_program.get_uniform ( "gbuffer_normalsstrength" );
-    auto& lighting_gbuffer_albedospec_uni = lighting_program.get_uniform ( "gbuffer_albedospec" );
-
     /* extract uniforms out of bloom program */
     auto& bloom_texture_uni = bloom_program.get_uniform ( "bloom_texture" );
     auto& bloom_mode_uni = bloom_program.get_uniform ( "bloom_mode" );
@@ -185,17 +309,50 @@ int main ()
         glh::math::identity<4, double> (),
         0.1
     );
-    glh::model::model island { "assets/island", "scene.gltf", 
+    const unsigned island_import_flags =
         glh::model::import_flags::GLH_CONFIGURE_REGIONS_ACCURATE |
-        glh::model::import_flags::GLH_CONFIGURE_ONLY_ROOT_NODE_REGION |
         glh::model::import_flags::GLH_FLIP_V_TEXTURES |
         glh::model::import_flags::GLH_PRETRANSFORM_VERTICES |
         glh::model::import_flags::GLH_SPLIT_MESHES_BY_ALPHA_VALUES |
         glh::model::import_flags::GLH_IGNORE_VCOLOR_WHEN_ALPHA_TESTING |
         glh::model::import_flags::GLH_CONFIGURE_GLOBAL_VERTEX_ARRAYS |
-        0,
-        island_matrix
-    };
+        0;
+    glh::model::model island { "assets/island", "scene.gltf", island_import_flags, island_matrix };
+    std::cout << "alpha tested " << island.get_num_alpha_tested_faces () << " island faces in " << island.get_alpha_test_time () << "ms" << std::endl;
+
+    /* check that the island was alpha tested in the same way as on the cpu, warning if not
+     * equivalence is enforced by the regression program, so a difference here should not stop the demo
+     */
+    if ( const unsigned alpha_test_differences = island.verify_alpha_test () )
+        std::cerr << "warning: " << alpha_test_differences << " island faces were alpha tested differently to the cpu" << std::endl;
+
+    /* import copies of the island model, keeping them alive so that they all share the alpha test program, and report the import time */
+    if ( IMPORT_BENCHMARK_MODELS > 0 )
+    {
+        glh::core::program_registry::reset_statistics ();
+        std::vector<glh::model::model> benchmark_models;
+        benchmark_models.reserve ( IMPORT_BENCHMARK_MODELS );
+        double benchmark_import_time = 0.0;
+        for ( unsigned i = 0; i < IMPORT_BENCHMARK_MODELS; ++i )
+        {
+            benchmark_models.emplace_back ( "assets/island", "scene.gltf", island_import_flags, island_matrix );
+            benchmark_import_time += benchmark_models.back ().get_import_time ();
+        }
+        std::cout << "imported " << IMPORT_BENCHMARK_MODELS << " models in " << benchmark_import_time << "ms (" << benchmark_import_time / benchmark_models.size () << "ms each, "
+                  << glh::core::program_registry::get_num_misses () << " programs compiled, " << glh::core::program_registry::get_num_hits () << " shared)" << std::endl;
+
+        /* compare alpha testing by compute to alpha testing by rasterisation, on one more copy for each */
+        glh::model::model compute_model { "assets/island", "scene.gltf", island_import_flags, island_matrix };
+        glh::model::model rasterised_model { "assets/island", "scene.gltf", island_import_flags | glh::model::import_flags::GLH_ALPHA_TEST_BY_RASTERISATION, island_matrix };
+        std::cout << "alpha tested " << compute_model.get_num_alpha_tested_faces () << " faces by compute in " << compute_model.get_alpha_test_time () << "ms (import " << compute_model.get_import_time () << "ms), "
+                  << "by rasterisation in " << rasterised_model.get_alpha_test_time () << "ms (import " << rasterised_model.get_import_time () << "ms)" << std::endl;
+
+        /* alpha test on the cpu, report its throughput, and report how differently each path classifies faces to the cpu */
+        glh::model::model cpu_model { "assets/island", "scene.gltf", island_import_flags | glh::model::import_flags::GLH_ALPHA_TEST_ON_CPU, island_matrix };
+        std::cout << "alpha tested " << cpu_model.get_num_alpha_tested_faces () << " faces on the cpu in " << cpu_model.get_alpha_test_time () << "ms ("
+                  << cpu_model.get_num_alpha_tested_faces () / cpu_model.get_alpha_test_time () << " faces/ms), differences from cpu: compute " << compute_model.verify_alpha_test ()
+                  << ", rasterisation " << rasterised_model.verify_alpha_test () << ", cpu " << cpu_model.verify_alpha_test () << std::endl;
+    }
 
     /* import box model */
     //const glh::math::mat4 box_matrix =
@@ -340,8 +497,27 @@ int main ()
 
 
 
-    /* create the depth rbo (the fbos below depend on this) */
-    glh::core::rbo depth_rbo { RESOLUTION, GL_DEPTH_COMPONENT };
+    /* create the depth texture (the fbos below depend on this) */
+    glh::core::texture2d depth_texture;
+    depth_texture.tex_storage ( RESOLUTION, GL_DEPTH_COMPONENT32F, 1 );
+    depth_texture.set_min_filter ( GL_NEAREST ); depth_texture.set_mag_filter ( GL_NEAREST );
+
+    /* create the depth pyramid for occlusion culling */
+    glh::culling::depth_pyramid depth_pyramid { RESOLUTION };
+    MODEL_SWITCH.set_occlusion_pyramid ( depth_pyramid );
+
+    /* create the frustum for culling instances, which is updated to the camera every frame */
+    glh::culling::frustum instance_frustum;
+    MODEL_SWITCH.set_culling_frustum ( instance_frustum );
+
+    /* create the transforms of the grid of instanced islands, spaced so that neighbouring copies do not overlap, and leaving out the centre where the island itself is */
+    std::vector<glh::math::mat4> island_instances;
+    for ( int i = 0; i < INSTANCED_ISLANDS; ++i ) for ( int j = 0; j < INSTANCED_ISLANDS; ++j )
+    {
+        const double spacing = 2.0 * MODEL_SWITCH.model_region ().radius;
+        const glh::math::vec3 offset { ( i - INSTANCED_ISLANDS / 2 ) * spacing, 0.0, ( j - INSTANCED_ISLANDS / 2 ) * spacing };
+        if ( glh::math::modulus ( offset ) > 0.0 ) island_instances.push_back ( glh::math::translate3d ( glh::math::identity<4, double> (), offset ) );
+    }
 
 
 
@@ -371,7 +547,7 @@ int main ()
     gbuffer_fbo.attach_texture ( gbuffer_normalsstrength, GL_COLOR_ATTACHMENT1 );
     gbuffer_fbo.attach_texture ( gbuffer_albedospec, GL_COLOR_ATTACHMENT2 );
     gbuffer_fbo.attach_texture ( bloom_texture_beta, GL_COLOR_ATTACHMENT3 );
-    gbuffer_fbo.attach_rbo ( depth_rbo, GL_DEPTH_ATTACHMENT );
+    gbuffer_fbo.attach_texture ( depth_texture, GL_DEPTH_ATTACHMENT );
     gbuffer_fbo.draw_buffers ( GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3 );
 
 
@@ -381,6 +557,9 @@ int main ()
     final_color_texture.set_min_filter ( GL_NEAREST ); final_color_texture.set_mag_filter ( GL_NEAREST );
     final_color_texture.set_wrap ( GL_CLAMP_TO_EDGE );
 
+    /* get a sampler to sample the final color texture with linear interpolation for fxaa */
+    const glh::core::sampler& linear_clamp_sampler = glh::core::sampler::get_cached ( glh::core::sampler::parameters {}.with_filter ( GL_LINEAR, GL_LINEAR ).with_wrap ( GL_CLAMP_TO_EDGE ) );
+
     /* create the final color framebuffer */
     glh::core::fbo final_color_fbo;
     final_color_fbo.attach_texture ( final_color_texture, GL_COLOR_ATTACHMENT0 );
@@ -391,7 +570,7 @@ int main ()
     glh::core::fbo transparent_fbo;
     transparent_fbo.attach_texture ( final_color_texture, GL_COLOR_ATTACHMENT0 );
     transparent_fbo.attach_texture ( bloom_texture_beta, GL_COLOR_ATTACHMENT1 );
-    transparent_fbo.attach_rbo ( depth_rbo, GL_DEPTH_ATTACHMENT );
+    transparent_fbo.attach_texture ( depth_texture, GL_DEPTH_ATTACHMENT );
     transparent_fbo.draw_buffers ( GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 );
 
 
@@ -431,6 +610,43 @@ int main ()
     glh::core::renderer::set_clear_color ( glh::math::vec4 { 0.0, 0.0, 0.0, 1.0 } );
     glh::core::renderer::enable_framebuffer_srgb ();
 
+    /* create the render state of each pass */
+    const glh::core::render_state shadow_state = glh::core::render_state {}.with_depth_test ( true ).with_face_culling ( true )
+        .with_viewport ( 0, 0, light_system.get_shadow_map_width (), light_system.get_shadow_map_width () );
+    const glh::core::render_state gbuffer_state = glh::core::render_state {}.with_depth_test ( true ).with_face_culling ( true ).with_viewport ( 0, 0, RESOLUTION );
+    const glh::core::render_state transparent_state = gbuffer_state.with_depth_mask ( GL_FALSE ).with_blend ( true )
+        .with_blend_func ( 0, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA ).with_blend_func ( 1, GL_ONE, GL_ONE );
+    const glh::core::render_state fullscreen_state = glh::core::render_state {}.with_viewport ( 0, 0, RESOLUTION );
+    const glh::core::render_state additive_state = fullscreen_state.with_blend ( true ).with_blend_func ( GL_ONE, GL_ONE );
+
+    /* create a back to front render queue for the transparent pass */
+    glh::core::render_queue transparent_queue { true };
+
+    /* time rendering the island into the gbuffer, looking up the members of texture stack levels by name and then by hashed id, and report the uniform table misses of the program */
+    if ( UNIFORM_LOOKUP_BENCHMARK > 0 )
+    {
+        gbuffer_fbo.bind ();
+        deferred_model_program.use ();
+        deferred_model_transparent_mode_uni.set_int ( 2 );
+        glh::core::renderer::apply ( gbuffer_state );
+        MODEL_SWITCH.cache_material_uniforms ( deferred_model_material_uni );
+        const auto time_renders = [ & ] ( const unsigned flags )
+        {
+            glFinish ();
+            const auto renders_start = std::chrono::system_clock::now ();
+            for ( unsigned i = 0; i < UNIFORM_LOOKUP_BENCHMARK; ++i ) MODEL_SWITCH.render ( glh::model::render_flags::GLH_OPAQUE_MODE | glh::model::render_flags::GLH_NO_MODEL_MATRIX | flags );
+            glFinish ();
+            return std::chrono::duration<double, std::milli> { std::chrono::system_clock::now () - renders_start }.count ();
+        };
+        const unsigned misses_before = deferred_model_program.get_num_uniform_table_misses ();
+        const double name_lookup_time = time_renders ( glh::model::render_flags::GLH_UNIFORM_NAME_LOOKUP );
+        const double id_lookup_time = time_renders ( glh::model::render_flags::GLH_NONE );
+        gbuffer_fbo.unbind ();
+        std::cout << "uniform lookup benchmark: " << UNIFORM_LOOKUP_BENCHMARK << " renders looking up by name in " << name_lookup_time << "ms (" << name_lookup_time / UNIFORM_LOOKUP_BENCHMARK << "ms each), "
+                  << "by hashed id in " << id_lookup_time << "ms (" << id_lookup_time / UNIFORM_LOOKUP_BENCHMARK << "ms each), " << deferred_model_program.get_uniform_table_size () << " uniforms in the table, "
+                  << deferred_model_program.get_num_uniform_table_misses () - misses_before << " table misses" << std::endl;
+    }
+
 
 
     /* RENDERING LOOP */
@@ -440,6 +656,11 @@ int main ()
         /* GET START TIME */
         const auto timestamp_start = std::chrono::system_clock::now ();
 
+        /* RELOAD SHADERS */
+
+        /* reload any programs whose shader files have changed, reporting how long the last reload took from saving the file */
+        if ( shader_reloader.update () > 0 ) std::cout << "\nreloaded shaders in " << shader_reloader.get_last_reload_time () << "ms (" << shader_reloader.get_num_reloads () << " reloaded, " << shader_reloader.get_num_failed_reloads () << " failed)" << std::endl;
+
         /* GET PROPERTIES */
 
         /* get window properties */
@@ -483,6 +704,10 @@ int main ()
         /* rotate light */
         light_system.pointlight_at ( 0 ).set_position ( glh::math::rotate3d ( light_system.pointlight_at ( 0 ).get_position (), light_rotation_sensitivity * timeinfo.delta, glh::math::vec3 { 0.0, 1.0, 0.0 } ) );        
 
+        /* upload the camera and lights, which every program then reads from the shared ubos */
+        camera.apply ( camera_ubo );
+        light_system.apply ( light_system_ubo );
+
         /* set timestamp */
         const auto timestamp_movement = std::chrono::system_clock::now ();
 
@@ -499,16 +724,8 @@ int main ()
             /* use the shadow program */
             shadow_program.use ();
 
-            /* apply light system and cache model matrix uniform */
-            light_system.apply ( shadow_light_system_uni );
-
             /* prepare for rendering  */
-            glh::core::renderer::disable_blend ();
-            glh::core::renderer::enable_depth_test ();
-            glh::core::renderer::set_depth_mask ( GL_TRUE );
-            glh::core::renderer::enable_face_culling ();
-            glh::core::renderer::set_cull_face ( GL_BACK );
-            glh::core::renderer::viewport ( 0, 0, light_system.get_shadow_map_width (), light_system.get_shadow_map_width () );
+            glh::core::renderer::apply ( shadow_state );
             glh::core::renderer::clear ( GL_DEPTH_BUFFER_BIT );
 
             /* render */
@@ -529,23 +746,31 @@ int main ()
         /* use the deferred model program */
         deferred_model_program.use ();
 
-        /* apply camera and set to opaque mode */
-        camera.apply ( deferred_model_camera_uni );
+        /* set to opaque mode */
         deferred_model_transparent_mode_uni.set_int ( 2 );
 
         /* set up renderer */
-        glh::core::renderer::disable_blend ();
-        glh::core::renderer::enable_depth_test ();
-        glh::core::renderer::set_depth_mask ( GL_TRUE );
-        glh::core::renderer::enable_face_culling ();
-        glh::core::renderer::set_cull_face ( GL_BACK );
-        glh::core::renderer::viewport ( 0, 0, RESOLUTION );  
+        glh::core::renderer::apply ( gbuffer_state );
         glh::core::renderer::clear ( GL_DEPTH_BUFFER_BIT );
         glh::core::renderer::clear ( GL_COLOR_BUFFER_BIT );
         
-        /* render */
+        /* render, culling against the depth pyramid of the previous frame */
         MODEL_SWITCH.cache_material_uniforms ( deferred_model_material_uni );
-        MODEL_SWITCH.render ( glh::model::render_flags::GLH_OPAQUE_MODE | glh::model::render_flags::GLH_NO_MODEL_MATRIX );
+        MODEL_SWITCH.render ( glh::model::render_flags::GLH_OPAQUE_MODE | glh::model::render_flags::GLH_NO_MODEL_MATRIX | glh::model::render_flags::GLH_OCCLUSION_CULLING );
+
+        /* render the instanced islands in one draw per mesh, culling whole instances against the frustum of the camera */
+        unsigned num_drawn_instances = 0;
+        if ( !island_instances.empty () )
+        {
+            deferred_model_instanced_program.use ();
+            deferred_model_instanced_transparent_mode_uni.set_int ( 2 );
+            instance_frustum.set_view_proj ( camera.get_view_proj () );
+            num_drawn_instances = MODEL_SWITCH.render_instanced ( deferred_model_instanced_material_uni, deferred_model_instanced_model_matrix_uni, island_instances,
+                glh::model::render_flags::GLH_OPAQUE_MODE | glh::model::render_flags::GLH_FRUSTUM_CULLING );
+        }
+
+        /* build the depth pyramid for the next frame */
+        depth_pyramid.build ( depth_texture, camera.get_view_proj () );
 
         /* set timestamp */
         const auto timestamp_gbuffer_render = std::chrono::system_clock::now ();
@@ -557,24 +782,18 @@ int main ()
         /* bind the final color framebuffer */
         final_color_fbo.bind ();
 
-        /* use the lighting program */
+        /* get the variant of the lighting program for the current light system, and use it */
+        glh::core::program& lighting_program = lighting_permutations.get ( lighting_permutations.make_key ( light_system.get_permutation_values () ) );
         lighting_program.use ();
 
-        /* apply many uniforms */
-        lighting_gbuffer_positionshininess_uni.set_int ( gbuffer_positionshininess.bind_loop () );
-        lighting_gbuffer_normalsstrength_uni.set_int ( gbuffer_normalsstrength.bind_loop () );
-        lighting_gbuffer_albedospec_uni.set_int ( gbuffer_albedospec.bind_loop () );
-        camera.apply ( lighting_camera_uni );
-        light_system.apply ( lighting_light_system_uni );
-
-        /* set final color texture to use nearest filtering */
-        final_color_texture.set_min_filter ( GL_NEAREST ); final_color_texture.set_mag_filter ( GL_NEAREST );
+        /* apply many uniforms, where variants without shadow mapping have no shadow map sampler */
+        lighting_program.get_uniform ( "gbuffer_positionshininess" ).set_int ( gbuffer_positionshininess.bind_loop () );
+        lighting_program.get_uniform ( "gbuffer_normalsstrength" ).set_int ( gbuffer_normalsstrength.bind_loop () );
+        lighting_program.get_uniform ( "gbuffer_albedospec" ).set_int ( gbuffer_albedospec.bind_loop () );
+        if ( light_system.requires_shadow_mapping () ) light_system.apply_shadow_maps ( lighting_program.get_uniform ( "light_system_shadow_maps" ) );
 
         /* set up renderer */
-        glh::core::renderer::disable_blend ();
-        glh::core::renderer::disable_depth_test ();
-        glh::core::renderer::disable_face_culling ();
-        glh::core::renderer::viewport ( 0, 0, RESOLUTION );
+        glh::core::renderer::apply ( fullscreen_state );
 
         /* render */
         quad_vao.bind ();
@@ -595,24 +814,15 @@ int main ()
         forward_model_program.bind ();
 
         /* apply many uniforms */
-        camera.apply ( forward_model_camera_uni );
-        light_system.apply ( forward_model_light_system_uni );
+        light_system.apply_shadow_maps ( forward_model_shadow_maps_uni );
         //forward_model_transparent_mode_uni.set_int ( 1 );
 
-        /* set up renderer */
-        glh::core::renderer::enable_blend ();
-        glh::core::renderer::blend_equation ( GL_FUNC_ADD );
-        glh::core::renderer::blend_func ( 0, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-        glh::core::renderer::blend_func ( 1, GL_ONE, GL_ONE );
-        glh::core::renderer::enable_depth_test ();
-        glh::core::renderer::set_depth_mask ( GL_FALSE );
-        glh::core::renderer::enable_face_culling ();
-        glh::core::renderer::set_cull_face ( GL_BACK );
-        glh::core::renderer::viewport ( 0, 0, RESOLUTION );
-
-        /* render */
+        /* record the transparent meshes into the queue, then submit them back to front */
+        transparent_queue.set_view_position ( camera.get_position () );
         MODEL_SWITCH.cache_material_uniforms ( forward_model_material_uni );
-        MODEL_SWITCH.render ( glh::model::render_flags::GLH_TRANSPARENT_MODE | glh::model::render_flags::GLH_NO_MODEL_MATRIX );
+        MODEL_SWITCH.record ( transparent_queue, transparent_state, forward_model_program, glh::math::identity<4> (), glh::model::render_flags::GLH_TRANSPARENT_MODE | glh::model::render_flags::GLH_NO_MODEL_MATRIX );
+        transparent_queue.submit ();
+        transparent_queue.clear ();
 
         /* set timestamp */
         const auto timestamp_transparent_render = std::chrono::system_clock::now ();
@@ -629,10 +839,7 @@ int main ()
         bloom_radius_uni.set_int ( bloom_radius );        
 
         /* prepare for rendering */
-        glh::core::renderer::disable_blend ();
-        glh::core::renderer::disable_depth_test ();
-        glh::core::renderer::disable_face_culling ();
-        glh::core::renderer::viewport ( 0, 0, RESOLUTION );
+        glh::core::renderer::apply ( fullscreen_state );
 
         /* bloom loop */
         quad_vao.bind ();
@@ -659,9 +866,7 @@ int main ()
                 final_color_fbo.bind ();
 
                 /* set up renderer */
-                glh::core::renderer::enable_blend ();
-                glh::core::renderer::blend_func ( GL_ONE, GL_ONE );
-                glh::core::renderer::blend_equation ( GL_FUNC_ADD );
+                glh::core::renderer::apply ( additive_state );
 
                 /* render into the default framebuffer */
                 bloom_texture_uni.set_int ( bloom_texture_alpha.bind_loop () );
@@ -684,17 +889,14 @@ int main ()
         fxaa_program.use ();
 
         /* set uniforms */
-        fxaa_texture_uni.set_int ( final_color_texture.bind_loop () );
+        fxaa_texture_uni.set_int ( final_color_texture.bind_loop ( linear_clamp_sampler ) );
         //fxaa_contrast_constant_threshold_uni.set_float ( 0.0312 );
         fxaa_contrast_constant_threshold_uni.set_float ( 0.01 );
         //fxaa_contrast_relative_threshold_uni.set_float ( 0.063 );
         fxaa_contrast_relative_threshold_uni.set_float ( 0.02 );
 
-        /* set final color texture to use linear interpolation */
-        final_color_texture.set_min_filter ( GL_LINEAR ); final_color_texture.set_mag_filter ( GL_LINEAR );
-
         /* set up renderer */
-        glh::core::renderer::disable_blend ();
+        glh::core::renderer::apply ( fullscreen_state );
 
         /* render */
         glh::core::renderer::draw_arrays ( GL_TRIANGLE_STRIP, 0, 4 );
@@ -738,8 +940,33 @@ int main ()
                   << "% fxaa               : " << fraction_fxaa * 100.0 << std::endl \
                   << "\x1b[A\x1b[A\x1b[A\x1b[A\x1b[A\x1b[A\x1b[A\x1b[A";
         
-        /* print framerate every 10th frame */
-        if ( frame % 10 == 0 ) std::cout << "FPS: " << std::to_string ( 1.0 / timeinfo.delta ) << '\r' << std::flush;
+        /* print framerate and the uniform calls and ubo uploads of the frame every 10th frame */
+        if ( frame % 10 == 0 ) std::cout << "FPS: " << std::to_string ( 1.0 / timeinfo.delta )
+                                         << ", uniform calls: " << glh::core::uniform::get_num_uniform_calls () << " (" << glh::core::uniform::get_num_skipped_uniform_calls () << " skipped)"
+                                         << ", ubo uploads: " << glh::core::ubo::get_num_staged_uploads () << " (" << glh::core::ubo::get_num_unchanged_staged_writes () << " unchanged writes)"
+                                         << ", lighting variants: " << lighting_permutations.get_num_variants () << " (" << lighting_permutations.get_build_time () << "ms building, "
+                                         << lighting_permutations.get_lookup_time () / std::max ( lighting_permutations.get_num_lookups (), 1u ) << "ms per lookup)"
+                                         << ( island_instances.empty () ? "" : ", instanced islands: " + std::to_string ( num_drawn_instances ) + " of " + std::to_string ( island_instances.size () ) + " drawn ("
+                                             + std::to_string ( MODEL_SWITCH.get_instance_data ().get_num_stalls () ) + " instance data stalls)" )
+                                         << '\r' << std::flush;
+
+        /* reset the statistics for the next frame */
+        glh::core::uniform::reset_uniform_call_statistics ();
+        glh::core::ubo::reset_staging_statistics ();
+
+
+
+        /* COMPARE AGAINST GOLDEN IMAGES */
+
+        /* compare the final color before and after fxaa against the golden images, and report the results */
+        if ( REGRESSION_FRAME > 0 && frame == REGRESSION_FRAME )
+        {
+            glh::headless::image_regression regression { "assets/golden", "regression_output" };
+            regression.compare ( "final_color", final_color_texture );
+            regression.compare_default_framebuffer ( "fxaa", window.get_dimensions ().width, window.get_dimensions ().height );
+            std::cout << std::endl << "regression: " << regression.get_num_passed () << " passed, " << regression.get_num_failed () << " failed, "
+                      << regression.get_num_recorded () << " recorded" << std::endl;
+        }
 
 
 
@@ -748,10 +975,16 @@ int main ()
         /* swap buffers */
         window.swap_buffers ();
 
+        /* move the instance data of the model on to its next frame region */
+        MODEL_SWITCH.next_frame ();
+
         /* poll events */
         window.poll_events ();
 
     }
 
+    /* destroy the cached samplers while the context still exists */
+    glh::core::sampler::clear_cache ();
+
     return 0;
 }
\ No newline at end of file